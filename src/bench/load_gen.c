@@ -0,0 +1,1795 @@
+/*
+===========================================================================
+
+Wolfenstein: Enemy Territory GPL Source Code
+Copyright (C) 1999-2010 id Software LLC, a ZeniMax Media company.
+
+This file is part of the Wolfenstein: Enemy Territory GPL Source Code (Wolf ET Source Code).
+
+Wolf ET Source Code is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Wolf ET Source Code is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Wolf ET Source Code.  If not, see <http://www.gnu.org/licenses/>.
+
+In addition, the Wolf: ET Source Code is also subject to certain additional terms. You should have received a copy of these additional terms immediately following the terms and conditions of the GNU General Public License which accompanied the Wolf ET Source Code.  If not, please request a copy in writing from id Software at the address below.
+
+If you have questions concerning this license or the applicable additional terms, you may contact in writing id Software LLC, c/o ZeniMax Media Inc., Suite 120, Rockville, Maryland 20850 USA.
+
+===========================================================================
+*/
+
+// load_gen.c -- synthetic client load generator for dedicated servers
+//
+// Connects a number of simulated clients to an ete-ded over UDP through
+// the regular netchan and msg code, completes the challenge, gamestate and
+// pure handshake like a real client, then sends usercmd streams and
+// acknowledges every snapshot. Only the playerState of each snapshot is
+// decoded, that is all the client needs to measure when the server has run
+// its commands. Everything runs in one thread against local sockets.
+//
+// loadgen [options] <server[:port]>
+//   -clients <n>      simulated clients (default 8)
+//   -duration <sec>   seconds of measured load once all clients are in
+//                     game (default 30)
+//   -fps <n>          packets sent per second by each client (default 60)
+//   -cmds <file>      replay a recorded usercmd stream (pmovebench format)
+//                     instead of generating random movement
+//   -seed <n>         seed for generated movement (default 1)
+//   -rate <n>         rate sent in userinfo (default 25000)
+//   -snaps <n>        snaps sent in userinfo (default 20)
+//   -source <ip>      local address of the first client (default 127.0.0.1)
+//   -perip <n>        clients sharing one source address before moving on
+//                     to the next one (default 1), the server only accepts
+//                     sv_maxclientsPerIP clients from one address
+//   -stagger <msec>   delay between starting client connections (default 50)
+//   -timeout <sec>    give up on clients not in game after this (default 20)
+//   -basepath <dir>   where to find the server pk3s when it is pure, may be
+//                     repeated
+//   -cmd <text>       reliable command each client sends once in game, e.g.
+//                     "team r", may be repeated
+//   -metrics <port>   read the server frame time histogram from its
+//                     sv_metricsPort before and after the run
+
+#include "../qcommon/q_shared.h"
+#include "../qcommon/qcommon.h"
+#include "pmove_bench.h"
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+typedef int socklen_t;
+#else
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+typedef int SOCKET;
+#define INVALID_SOCKET		-1
+#define closesocket			close
+#endif
+
+#include <setjmp.h>
+
+#define MAX_LG_CLIENTS		MAX_CLIENTS
+#define MAX_LG_COMMANDS		8
+#define MAX_LG_BASEPATHS	4
+
+// reliable commands we may have in flight, far less than the server allows
+#define LG_RELIABLE_COMMANDS	16
+// only the start of a server command is kept, it keys the usercmd encoding
+#define LG_SERVERCOMMAND_CHARS	64
+
+#define LG_RESEND_MSEC		1000
+#define LG_PACKET_TIMEOUT	10000
+
+typedef enum {
+	LG_WAITING,			// not started yet
+	LG_CHALLENGING,		// sent getchallenge
+	LG_CONNECTING,		// sent connect
+	LG_CONNECTED,		// netchan up, waiting for the gamestate
+	LG_PRIMED,			// got the gamestate, waiting for a snapshot
+	LG_ACTIVE,			// in game
+	LG_DROPPED
+} lgState_t;
+
+static const char *lgStateNames[] = {
+	"waiting", "challenging", "connecting", "connected", "primed", "active", "dropped"
+};
+
+typedef struct {
+	float	*values;
+	int		count;
+	int		size;
+} lgSamples_t;
+
+typedef struct {
+	int64_t		realtime;
+	int			serverTime;
+} lgOutPacket_t;
+
+typedef struct {
+	qboolean		valid;
+	int				messageNum;
+	playerState_t	ps;
+} lgSnapshot_t;
+
+typedef struct {
+	int				num;
+	SOCKET			sock;
+	netadr_t		source;
+	lgState_t		state;
+	char			dropReason[MAX_STRING_CHARS];
+
+	int				clientChallenge;
+	int				challenge;
+	int				protocol;
+	int				qport;
+	int64_t			startTime;
+	int64_t			lastResend;
+	int64_t			nextPacket;
+	int64_t			lastPacketTime;
+
+	netchan_t		netchan;
+	int				serverId;
+	int				checksumFeed;
+	int				clientNum;
+	int				serverMessageSequence;
+	int				serverCommandSequence;
+	char			serverCommands[MAX_RELIABLE_COMMANDS][LG_SERVERCOMMAND_CHARS];
+	int				reliableSequence;
+	int				reliableAcknowledge;
+	char			reliableCommands[LG_RELIABLE_COMMANDS][MAX_STRING_CHARS];
+
+	lgSnapshot_t	snapshots[PACKET_BACKUP];
+	int				snapMessageNum;
+	int				snapServerTime;
+	int64_t			snapRealtime;
+	lgOutPacket_t	outPackets[PACKET_BACKUP];
+
+	usercmd_t		cmds[2];
+	int				cmdNumber;
+	int				streamPos;
+	unsigned int	seed;
+	int				segment;
+	int				yawSpeed;
+
+	// measured from the start of the run
+	int				snapshotCount;
+	lgSamples_t		latency;		// usercmd sent until a snapshot shows it was run, msec
+	lgSamples_t		jitter;			// snapshot arrival against server time, msec
+	netchanStats_t	startStats;
+} lgClient_t;
+
+typedef struct {
+	int			numBuckets;
+	double		bounds[16];
+	int64_t		counts[16];			// cumulative, the last one is +Inf
+	double		sum;
+	int64_t		count;
+	int			load;
+} lgServerFrames_t;
+
+static lgClient_t	*lgClients;
+static int			lgNumClients = 8;
+static lgClient_t	*lgCurrent;
+static netadr_t		lgServer;
+
+static usercmd_t	*lgStream;
+static int			lgStreamCmds;
+
+static int			lgFps = 60;
+static int			lgRate = 25000;
+static int			lgSnaps = 20;
+static const char	*lgBasepaths[MAX_LG_BASEPATHS];
+static int			lgNumBasepaths;
+static const char	*lgCommands[MAX_LG_COMMANDS];
+static int			lgNumCommands;
+
+// pure checksums only depend on the checksum feed, so share them
+static int			lgPureFeed;
+static char			lgPureChecksums[MAX_STRING_CHARS];
+static qboolean		lgPureValid;
+
+static jmp_buf		lgAbort;
+static qboolean		lgAbortSet;
+
+extern cvar_t *qport;
+
+
+/*
+==============================================================
+
+ENGINE SERVICES
+
+Minimal replacements for what msg.c and net_chan.c pull in
+from common.c, cvar.c and net_ip.c.
+
+==============================================================
+*/
+
+void QDECL Com_Printf( const char *fmt, ... ) {
+	va_list argptr;
+
+	va_start( argptr, fmt );
+	vprintf( fmt, argptr );
+	va_end( argptr );
+}
+
+void QDECL Com_DPrintf( const char *fmt, ... ) {
+}
+
+/*
+================
+Com_Error
+
+Errors while a client packet is parsed only drop that client
+================
+*/
+void NORETURN QDECL Com_Error( errorParm_t code, const char *fmt, ... ) {
+	va_list argptr;
+	char	text[MAX_STRING_CHARS];
+
+	va_start( argptr, fmt );
+	Q_vsnprintf( text, sizeof( text ), fmt, argptr );
+	va_end( argptr );
+
+	if ( code != ERR_FATAL && lgAbortSet && lgCurrent ) {
+		Q_strncpyz( lgCurrent->dropReason, text, sizeof( lgCurrent->dropReason ) );
+		longjmp( lgAbort, 1 );
+	}
+
+	fprintf( stderr, "ERROR: %s\n", text );
+	exit( 1 );
+}
+
+cvar_t *Cvar_Get( const char *var_name, const char *value, int flags ) {
+	cvar_t *var;
+
+	var = calloc( 1, sizeof( *var ) );
+	var->name = strdup( var_name );
+	var->string = strdup( value );
+	var->flags = flags;
+	var->value = atof( value );
+	var->integer = atoi( value );
+
+	return var;
+}
+
+void Cvar_SetDescription( cvar_t *var, const char *var_description ) {
+}
+
+void *S_Malloc( int size ) {
+	void *buf = malloc( size );
+
+	if ( !buf ) {
+		Com_Error( ERR_FATAL, "Out of memory for %i bytes", size );
+	}
+
+	return buf;
+}
+
+void Z_Free( void *ptr ) {
+	free( ptr );
+}
+
+/*
+================
+LG_Microseconds
+================
+*/
+static int64_t LG_Microseconds( void ) {
+#ifdef _WIN32
+	static LARGE_INTEGER freq;
+	LARGE_INTEGER count;
+
+	if ( !freq.QuadPart ) {
+		QueryPerformanceFrequency( &freq );
+	}
+	QueryPerformanceCounter( &count );
+
+	return (int64_t)( (double)count.QuadPart * 1e6 / (double)freq.QuadPart );
+#else
+	struct timespec ts;
+
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+
+	return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#endif
+}
+
+int Sys_Milliseconds( void ) {
+	return (int)( LG_Microseconds() / 1000 );
+}
+
+qboolean Sys_IsLANAddress( const netadr_t *adr ) {
+	return qtrue;
+}
+
+/*
+================
+LG_AdrToSockaddr
+================
+*/
+static void LG_AdrToSockaddr( const netadr_t *a, struct sockaddr_in *s ) {
+	memset( s, 0, sizeof( *s ) );
+	s->sin_family = AF_INET;
+	s->sin_port = a->port;
+	memcpy( &s->sin_addr, a->ipv._4, 4 );
+}
+
+const char *NET_AdrToString( const netadr_t *a ) {
+	static char s[32];
+
+	Com_sprintf( s, sizeof( s ), "%i.%i.%i.%i:%i", a->ipv._4[0], a->ipv._4[1],
+		a->ipv._4[2], a->ipv._4[3], BigShort( a->port ) );
+
+	return s;
+}
+
+qboolean Sys_StringToAdr( const char *s, netadr_t *a, netadrtype_t family ) {
+	struct addrinfo hints, *res;
+
+	memset( &hints, 0, sizeof( hints ) );
+	hints.ai_family = AF_INET;
+	hints.ai_socktype = SOCK_DGRAM;
+
+	if ( getaddrinfo( s, NULL, &hints, &res ) != 0 || !res ) {
+		return qfalse;
+	}
+
+	memset( a, 0, sizeof( *a ) );
+	a->type = NA_IP;
+	memcpy( a->ipv._4, &( (struct sockaddr_in *)res->ai_addr )->sin_addr, 4 );
+	freeaddrinfo( res );
+
+	return qtrue;
+}
+
+/*
+================
+Sys_SendPacket
+
+The netchan has no notion of our per client sockets, every send
+happens while the client it belongs to is being serviced
+================
+*/
+void Sys_SendPacket( int length, const void *data, const netadr_t *to ) {
+	struct sockaddr_in addr;
+
+	if ( !lgCurrent || lgCurrent->sock == INVALID_SOCKET ) {
+		return;
+	}
+
+	LG_AdrToSockaddr( to, &addr );
+	sendto( lgCurrent->sock, data, length, 0, (struct sockaddr *)&addr, sizeof( addr ) );
+}
+
+
+/*
+================
+NET_EmuSend
+
+Sends are tied to lgCurrent, so nothing can be held back for later
+================
+*/
+qboolean NET_EmuSend( netsrc_t sock, int length, const void *data, const netadr_t *to ) {
+	return qfalse;
+}
+
+
+/*
+================
+Com_JournalReplaying
+================
+*/
+qboolean Com_JournalReplaying( void ) {
+	return qfalse;
+}
+
+
+/*
+================
+Com_EventTime
+================
+*/
+int Com_EventTime( void ) {
+	return Sys_Milliseconds();
+}
+
+
+/*
+==============================================================
+
+SAMPLES
+
+==============================================================
+*/
+
+static void LG_AddSample( lgSamples_t *s, float value ) {
+	if ( s->count == s->size ) {
+		s->size = s->size ? s->size * 2 : 1024;
+		s->values = realloc( s->values, s->size * sizeof( s->values[0] ) );
+		if ( !s->values ) {
+			Com_Error( ERR_FATAL, "Out of memory for %i samples", s->size );
+		}
+	}
+	s->values[s->count++] = value;
+}
+
+static int LG_CompareFloats( const void *a, const void *b ) {
+	const float fa = *(const float *)a, fb = *(const float *)b;
+
+	return ( fa > fb ) - ( fa < fb );
+}
+
+/*
+================
+LG_SortSamples
+
+Sorts in place and returns the mean, percentiles are read from the sorted values
+================
+*/
+static float LG_SortSamples( lgSamples_t *s ) {
+	double sum = 0;
+	int i;
+
+	if ( !s->count ) {
+		return 0;
+	}
+
+	qsort( s->values, s->count, sizeof( s->values[0] ), LG_CompareFloats );
+	for ( i = 0; i < s->count; i++ ) {
+		sum += s->values[i];
+	}
+
+	return sum / s->count;
+}
+
+static float LG_Percentile( const lgSamples_t *s, float p ) {
+	int i;
+
+	if ( !s->count ) {
+		return 0;
+	}
+
+	i = (int)( p * ( s->count - 1 ) + 0.5f );
+
+	return s->values[i];
+}
+
+static void LG_AppendSamples( lgSamples_t *dst, const lgSamples_t *src ) {
+	int i;
+
+	for ( i = 0; i < src->count; i++ ) {
+		LG_AddSample( dst, src->values[i] );
+	}
+}
+
+
+/*
+==============================================================
+
+PURE CHECKSUMS
+
+==============================================================
+*/
+
+typedef struct {
+	int			checksum;
+	int			pureChecksum;
+	qboolean	hasCgame;
+	qboolean	hasUI;
+} lgPak_t;
+
+/*
+================
+LG_ScanPak
+
+Reads the zip central directory, the checksums are computed from the
+crcs it lists the same way FS_LoadZipFile does
+================
+*/
+static qboolean LG_ScanPak( const char *filename, int checksumFeed, lgPak_t *pak ) {
+	FILE	*f;
+	byte	*buf = NULL, *eocd, *p, *end;
+	int		*headerLongs = NULL;
+	int		numHeaderLongs;
+	long	fileSize, tailSize;
+	int		numEntries, dirSize, dirOffset;
+	int		method, crc, size, nameLen;
+	char	name[MAX_QPATH];
+	int		i;
+
+	memset( pak, 0, sizeof( *pak ) );
+
+	f = fopen( filename, "rb" );
+	if ( !f ) {
+		return qfalse;
+	}
+
+	// the end of central directory record is followed by at most 64k of comment
+	fseek( f, 0, SEEK_END );
+	fileSize = ftell( f );
+	tailSize = MIN( fileSize, 65535 + 22 );
+	buf = malloc( tailSize );
+	fseek( f, fileSize - tailSize, SEEK_SET );
+	if ( !buf || fread( buf, 1, tailSize, f ) != tailSize ) {
+		goto fail;
+	}
+
+	for ( eocd = buf + tailSize - 22; eocd >= buf; eocd-- ) {
+		if ( eocd[0] == 'P' && eocd[1] == 'K' && eocd[2] == 5 && eocd[3] == 6 ) {
+			break;
+		}
+	}
+	if ( eocd < buf ) {
+		goto fail;
+	}
+
+	numEntries = eocd[10] | ( eocd[11] << 8 );
+	dirSize = eocd[12] | ( eocd[13] << 8 ) | ( eocd[14] << 16 ) | ( eocd[15] << 24 );
+	dirOffset = eocd[16] | ( eocd[17] << 8 ) | ( eocd[18] << 16 ) | ( eocd[19] << 24 );
+	free( buf );
+
+	buf = malloc( dirSize );
+	headerLongs = malloc( ( numEntries + 1 ) * sizeof( headerLongs[0] ) );
+	fseek( f, dirOffset, SEEK_SET );
+	if ( !buf || !headerLongs || fread( buf, 1, dirSize, f ) != dirSize ) {
+		goto fail;
+	}
+
+	numHeaderLongs = 0;
+	headerLongs[numHeaderLongs++] = LittleLong( checksumFeed );
+
+	p = buf;
+	end = buf + dirSize;
+	for ( i = 0; i < numEntries; i++ ) {
+		if ( p + 46 > end || p[0] != 'P' || p[1] != 'K' || p[2] != 1 || p[3] != 2 ) {
+			goto fail;
+		}
+		method = p[10] | ( p[11] << 8 );
+		crc = p[16] | ( p[17] << 8 ) | ( p[18] << 16 ) | ( p[19] << 24 );
+		size = p[24] | ( p[25] << 8 ) | ( p[26] << 16 ) | ( p[27] << 24 );
+		nameLen = p[28] | ( p[29] << 8 );
+
+		if ( method == 0 || method == 8 ) {
+			if ( size > 0 ) {
+				headerLongs[numHeaderLongs++] = LittleLong( crc );
+			}
+			if ( nameLen < sizeof( name ) && p + 46 + nameLen <= end ) {
+				memcpy( name, p + 46, nameLen );
+				name[nameLen] = '\0';
+				if ( !Q_stricmp( name, SYS_DLLNAME_CGAME ) ) {
+					pak->hasCgame = qtrue;
+				} else if ( !Q_stricmp( name, SYS_DLLNAME_UI ) ) {
+					pak->hasUI = qtrue;
+				}
+			}
+		}
+
+		p += 46 + nameLen + ( p[30] | ( p[31] << 8 ) ) + ( p[32] | ( p[33] << 8 ) );
+	}
+
+	pak->checksum = LittleLong( Com_BlockChecksum( headerLongs + 1, sizeof( headerLongs[0] ) * ( numHeaderLongs - 1 ) ) );
+	pak->pureChecksum = LittleLong( Com_BlockChecksum( headerLongs, sizeof( headerLongs[0] ) * numHeaderLongs ) );
+
+	free( headerLongs );
+	free( buf );
+	fclose( f );
+	return qtrue;
+
+fail:
+	free( headerLongs );
+	free( buf );
+	fclose( f );
+	return qfalse;
+}
+
+/*
+================
+LG_FindPak
+================
+*/
+static qboolean LG_FindPak( const char *name, int checksum, int checksumFeed, lgPak_t *pak ) {
+	int i;
+
+	for ( i = 0; i < lgNumBasepaths; i++ ) {
+		if ( LG_ScanPak( va( "%s/%s.pk3", lgBasepaths[i], name ), checksumFeed, pak ) ) {
+			if ( pak->checksum != checksum ) {
+				Com_Printf( "WARNING: %s/%s.pk3 differs from the server's copy\n", lgBasepaths[i], name );
+			}
+			return qtrue;
+		}
+	}
+
+	return qfalse;
+}
+
+/*
+================
+LG_PureChecksums
+
+Builds the "cgame ui @ ref1 ref2 ... encoded" list FS_ReferencedPakPureChecksums
+would send for the paks the server references
+================
+*/
+static const char *LG_PureChecksums( const char *systemInfo, int checksumFeed ) {
+	char		names[BIG_INFO_VALUE], sums[BIG_INFO_VALUE];
+	const char	*pn, *ps, *token;
+	char		name[MAX_QPATH];
+	int			cgame = 0, ui = 0, checksum, encoded, numPaks;
+	lgPak_t		pak;
+	char		*s;
+
+	if ( lgPureValid && lgPureFeed == checksumFeed ) {
+		return lgPureChecksums;
+	}
+
+	// cgame and ui may come from any pak the server has loaded
+	Q_strncpyz( names, Info_ValueForKey( systemInfo, "sv_pakNames" ), sizeof( names ) );
+	Q_strncpyz( sums, Info_ValueForKey( systemInfo, "sv_paks" ), sizeof( sums ) );
+	pn = names;
+	ps = sums;
+	while ( ( !cgame || !ui ) && *( token = COM_Parse( &pn ) ) ) {
+		Q_strncpyz( name, token, sizeof( name ) );
+		checksum = atoi( COM_Parse( &ps ) );
+		if ( LG_FindPak( name, checksum, checksumFeed, &pak ) ) {
+			if ( pak.hasCgame && !cgame ) {
+				cgame = pak.pureChecksum;
+			}
+			if ( pak.hasUI && !ui ) {
+				ui = pak.pureChecksum;
+			}
+		}
+	}
+
+	if ( !cgame || !ui ) {
+		Com_Error( ERR_FATAL, "Server is pure but no %s and %s were found in its pk3s, check -basepath",
+			SYS_DLLNAME_CGAME, SYS_DLLNAME_UI );
+	}
+
+	s = lgPureChecksums;
+	s += sprintf( s, "%i %i @ ", cgame, ui );
+
+	encoded = checksumFeed;
+	numPaks = 0;
+
+	Q_strncpyz( names, Info_ValueForKey( systemInfo, "sv_referencedPakNames" ), sizeof( names ) );
+	Q_strncpyz( sums, Info_ValueForKey( systemInfo, "sv_referencedPaks" ), sizeof( sums ) );
+	pn = names;
+	ps = sums;
+	while ( *( token = COM_Parse( &pn ) ) ) {
+		Q_strncpyz( name, token, sizeof( name ) );
+		checksum = atoi( COM_Parse( &ps ) );
+		if ( !LG_FindPak( name, checksum, checksumFeed, &pak ) ) {
+			Com_Error( ERR_FATAL, "Couldn't find referenced pak %s, check -basepath", name );
+		}
+		if ( s - lgPureChecksums > sizeof( lgPureChecksums ) - 32 ) {
+			Com_Error( ERR_FATAL, "Too many referenced paks" );
+		}
+		s += sprintf( s, "%i ", pak.pureChecksum );
+		encoded ^= pak.pureChecksum;
+		numPaks++;
+	}
+
+	sprintf( s, "%i", encoded ^ numPaks );
+
+	lgPureFeed = checksumFeed;
+	lgPureValid = qtrue;
+
+	return lgPureChecksums;
+}
+
+
+/*
+==============================================================
+
+USERCMD STREAMS
+
+==============================================================
+*/
+
+/*
+================
+LG_LoadStream
+================
+*/
+static void LG_LoadStream( const char *filename ) {
+	FILE		*f;
+	byte		header[12], rec[PMB_STREAM_CMDSIZE];
+	usercmd_t	*cmd;
+	int			i;
+
+	f = fopen( filename, "rb" );
+	if ( !f ) {
+		Com_Error( ERR_FATAL, "Couldn't load %s", filename );
+	}
+
+	if ( fread( header, sizeof( header ), 1, f ) != 1 || LittleLong( ( (int *)header )[0] ) != PMB_STREAM_IDENT ) {
+		Com_Error( ERR_FATAL, "%s is not a usercmd stream", filename );
+	}
+	if ( LittleLong( ( (int *)header )[1] ) != PMB_STREAM_VERSION ) {
+		Com_Error( ERR_FATAL, "%s has wrong version number (%i should be %i)", filename,
+			LittleLong( ( (int *)header )[1] ), PMB_STREAM_VERSION );
+	}
+
+	lgStreamCmds = LittleLong( ( (int *)header )[2] );
+	if ( lgStreamCmds <= 0 ) {
+		Com_Error( ERR_FATAL, "%s is empty", filename );
+	}
+
+	lgStream = calloc( lgStreamCmds, sizeof( usercmd_t ) );
+	for ( i = 0, cmd = lgStream; i < lgStreamCmds; i++, cmd++ ) {
+		if ( fread( rec, sizeof( rec ), 1, f ) != 1 ) {
+			Com_Error( ERR_FATAL, "%s is truncated", filename );
+		}
+		cmd->angles[0] = LittleLong( ( (int *)rec )[1] );
+		cmd->angles[1] = LittleLong( ( (int *)rec )[2] );
+		cmd->angles[2] = LittleLong( ( (int *)rec )[3] );
+		cmd->buttons = rec[16];
+		cmd->wbuttons = rec[17];
+		cmd->weapon = rec[18];
+		cmd->flags = rec[19];
+		cmd->forwardmove = (signed char)rec[20];
+		cmd->rightmove = (signed char)rec[21];
+		cmd->upmove = (signed char)rec[22];
+		cmd->doubleTap = rec[23];
+	}
+
+	fclose( f );
+}
+
+static unsigned int LG_Random( unsigned int *seed ) {
+	*seed = *seed * 1103515245 + 12345;
+	return ( *seed >> 16 ) & 0x7fff;
+}
+
+/*
+================
+LG_NextCommand
+
+Replays the stream from a different offset for every client, or
+keeps up runs of random movement, turning and firing
+================
+*/
+static void LG_NextCommand( lgClient_t *cl, usercmd_t *cmd ) {
+	static const signed char moves[3] = { -127, 0, 127 };
+	const int msec = 1000 / lgFps;
+
+	if ( lgStream ) {
+		*cmd = lgStream[( cl->streamPos++ ) % lgStreamCmds];
+		return;
+	}
+
+	*cmd = cl->cmds[cl->cmdNumber & 1];
+
+	if ( --cl->segment <= 0 ) {
+		cl->segment = ( 250 + LG_Random( &cl->seed ) % 750 ) / msec + 1;
+
+		cmd->forwardmove = moves[LG_Random( &cl->seed ) % 3];
+		cmd->rightmove = moves[LG_Random( &cl->seed ) % 3];
+		cmd->buttons = 0;
+		cmd->wbuttons = 0;
+		if ( LG_Random( &cl->seed ) % 4 == 0 ) {
+			cmd->buttons |= BUTTON_ATTACK;
+		} else if ( LG_Random( &cl->seed ) & 1 ) {
+			cmd->buttons |= BUTTON_SPRINT;
+		}
+
+		cl->yawSpeed = (int)( LG_Random( &cl->seed ) % 181 ) - 90;
+		cmd->angles[PITCH] = ANGLE2SHORT( (int)( LG_Random( &cl->seed ) % 61 ) - 30 );
+	}
+
+	// jumps are edge triggered, so pulse them
+	cmd->upmove = ( LG_Random( &cl->seed ) % 64 ) == 0 ? 127 : 0;
+	cmd->angles[YAW] += ANGLE2SHORT( cl->yawSpeed * msec / 1000.0f );
+}
+
+
+/*
+==============================================================
+
+CLIENTS
+
+==============================================================
+*/
+
+/*
+================
+LG_Drop
+================
+*/
+static void LG_Drop( lgClient_t *cl, const char *reason ) {
+	if ( cl->state == LG_DROPPED ) {
+		return;
+	}
+
+	Com_Printf( "client %i: %s\n", cl->num, reason );
+	Q_strncpyz( cl->dropReason, reason, sizeof( cl->dropReason ) );
+	cl->state = LG_DROPPED;
+}
+
+/*
+================
+LG_AddReliableCommand
+================
+*/
+static void LG_AddReliableCommand( lgClient_t *cl, const char *cmd ) {
+	if ( cl->reliableSequence - cl->reliableAcknowledge >= LG_RELIABLE_COMMANDS ) {
+		LG_Drop( cl, "reliable command overflow" );
+		return;
+	}
+
+	cl->reliableSequence++;
+	Q_strncpyz( cl->reliableCommands[cl->reliableSequence & ( LG_RELIABLE_COMMANDS - 1 )], cmd,
+		sizeof( cl->reliableCommands[0] ) );
+}
+
+/*
+================
+LG_SendConnect
+================
+*/
+static void LG_SendConnect( lgClient_t *cl ) {
+	char	info[MAX_INFO_STRING];
+	char	data[MAX_INFO_STRING + 16];
+	int		len;
+
+	info[0] = '\0';
+	Info_SetValueForKey( info, "name", va( "loadgen%02i", cl->num ) );
+	Info_SetValueForKey( info, "rate", va( "%i", lgRate ) );
+	Info_SetValueForKey( info, "snaps", va( "%i", lgSnaps ) );
+	Info_SetValueForKey( info, "cl_maxpackets", va( "%i", lgFps ) );
+	Info_SetValueForKey( info, "cl_guid", va( "%032X", 0x10000 + cl->num ) );
+	Info_SetValueForKey( info, "protocol", va( "%i", cl->protocol ) );
+	Info_SetValueForKey( info, "qport", va( "%i", cl->qport ) );
+	Info_SetValueForKey( info, "challenge", va( "%i", cl->challenge ) );
+	Info_SetValueForKey( info, "client", Q3_VERSION );
+
+	len = Com_sprintf( data, sizeof( data ), "connect \"%s\"", info );
+	NET_OutOfBandCompress( NS_CLIENT, &lgServer, (byte *)data, len );
+}
+
+/*
+================
+LG_WritePacket
+
+Same layout as CL_WritePacket, every packet carries the new command
+and repeats the previous one
+================
+*/
+static void LG_WritePacket( lgClient_t *cl, int64_t now ) {
+	msg_t		buf;
+	byte		data[MAX_MSGLEN_BUF];
+	usercmd_t	*cmd, *oldcmd;
+	usercmd_t	nullcmd;
+	int			i, n, count, key, serverTime;
+
+	MSG_Init( &buf, data, MAX_MSGLEN );
+	MSG_Bitstream( &buf );
+
+	MSG_WriteLong( &buf, cl->serverId );
+	MSG_WriteLong( &buf, cl->serverMessageSequence );
+	MSG_WriteLong( &buf, cl->serverCommandSequence );
+
+	n = cl->reliableSequence - cl->reliableAcknowledge;
+	for ( i = 0; i < n; i++ ) {
+		const int index = cl->reliableAcknowledge + 1 + i;
+		MSG_WriteByte( &buf, clc_clientCommand );
+		MSG_WriteLong( &buf, index );
+		MSG_WriteString( &buf, cl->reliableCommands[index & ( LG_RELIABLE_COMMANDS - 1 )] );
+	}
+
+	serverTime = 0;
+	if ( cl->state >= LG_PRIMED ) {
+		// extrapolate the server time from the last snapshot
+		if ( cl->snapRealtime ) {
+			serverTime = cl->snapServerTime + (int)( ( now - cl->snapRealtime ) / 1000 );
+		}
+		if ( cl->cmdNumber && serverTime - cl->cmds[cl->cmdNumber & 1].serverTime <= 0 ) {
+			serverTime = cl->cmds[cl->cmdNumber & 1].serverTime + 1;
+		}
+
+		cmd = &cl->cmds[( cl->cmdNumber + 1 ) & 1];
+		LG_NextCommand( cl, cmd );
+		cmd->serverTime = serverTime;
+		cl->cmdNumber++;
+
+		count = MIN( cl->cmdNumber, 2 );
+
+		if ( cl->snapshots[cl->serverMessageSequence & PACKET_MASK].valid
+			&& cl->snapMessageNum == cl->serverMessageSequence ) {
+			MSG_WriteByte( &buf, clc_move );
+		} else {
+			MSG_WriteByte( &buf, clc_moveNoDelta );
+		}
+		MSG_WriteByte( &buf, count );
+
+		key = cl->checksumFeed;
+		key ^= cl->serverMessageSequence;
+		key ^= MSG_HashKey( cl->serverCommands[cl->serverCommandSequence & ( MAX_RELIABLE_COMMANDS - 1 )], 32 );
+
+		memset( &nullcmd, 0, sizeof( nullcmd ) );
+		oldcmd = &nullcmd;
+		for ( i = 0; i < count; i++ ) {
+			cmd = &cl->cmds[( cl->cmdNumber - count + i + 1 ) & 1];
+			MSG_WriteDeltaUsercmdKey( &buf, key, oldcmd, cmd );
+			oldcmd = cmd;
+		}
+	}
+
+	cl->outPackets[cl->netchan.outgoingSequence & PACKET_MASK].realtime = now;
+	cl->outPackets[cl->netchan.outgoingSequence & PACKET_MASK].serverTime = serverTime;
+
+	MSG_WriteByte( &buf, clc_EOF );
+	if ( buf.overflowed ) {
+		LG_Drop( cl, "message overflowed" );
+		return;
+	}
+
+	Netchan_Transmit( &cl->netchan, buf.cursize, buf.data );
+	while ( cl->netchan.unsentFragments ) {
+		Netchan_TransmitNextFragment( &cl->netchan );
+	}
+}
+
+/*
+================
+LG_ParseCommandString
+================
+*/
+static void LG_ParseCommandString( lgClient_t *cl, msg_t *msg ) {
+	const char	*s;
+	int			seq;
+
+	seq = MSG_ReadLong( msg );
+	s = MSG_ReadString( msg );
+
+	if ( cl->serverCommandSequence - seq >= 0 ) {
+		return;
+	}
+	cl->serverCommandSequence = seq;
+	Q_strncpyz( cl->serverCommands[seq & ( MAX_RELIABLE_COMMANDS - 1 )], s, sizeof( cl->serverCommands[0] ) );
+
+	if ( !Q_strncmp( s, "disconnect", 10 ) ) {
+		LG_Drop( cl, *( s + 10 ) ? va( "server disconnected:%s", s + 10 ) : "server disconnected" );
+	}
+}
+
+/*
+================
+LG_ParseGamestate
+================
+*/
+static void LG_ParseGamestate( lgClient_t *cl, msg_t *msg ) {
+	char			systemInfo[BIG_INFO_STRING];
+	entityState_t	nullstate, es;
+	int				cmd, i, newnum;
+
+	systemInfo[0] = '\0';
+	memset( &nullstate, 0, sizeof( nullstate ) );
+
+	cl->serverCommandSequence = MSG_ReadLong( msg );
+
+	while ( 1 ) {
+		cmd = MSG_ReadByte( msg );
+
+		if ( cmd == svc_EOF ) {
+			break;
+		}
+
+		if ( cmd == svc_configstring ) {
+			i = MSG_ReadShort( msg );
+			if ( i < 0 || i >= MAX_CONFIGSTRINGS ) {
+				Com_Error( ERR_DROP, "%s: configstring > MAX_CONFIGSTRINGS", __func__ );
+			}
+			if ( i == CS_SYSTEMINFO ) {
+				Q_strncpyz( systemInfo, MSG_ReadBigString( msg ), sizeof( systemInfo ) );
+			} else {
+				MSG_ReadBigString( msg );
+			}
+		} else if ( cmd == svc_baseline ) {
+			newnum = MSG_ReadEntitynum( msg );
+			if ( newnum < 0 || newnum >= MAX_GENTITIES ) {
+				Com_Error( ERR_DROP, "%s: baseline number out of range: %i", __func__, newnum );
+			}
+			MSG_ReadDeltaEntity( msg, &nullstate, &es, newnum );
+		} else {
+			Com_Error( ERR_DROP, "%s: bad command byte", __func__ );
+		}
+	}
+
+	cl->clientNum = MSG_ReadLong( msg );
+	cl->checksumFeed = MSG_ReadLong( msg );
+	cl->serverId = atoi( Info_ValueForKey( systemInfo, "sv_serverid" ) );
+
+	for ( i = 0; i < PACKET_BACKUP; i++ ) {
+		cl->snapshots[i].valid = qfalse;
+	}
+	cl->snapRealtime = 0;
+	cl->state = LG_PRIMED;
+
+	if ( atoi( Info_ValueForKey( systemInfo, "sv_pure" ) ) ) {
+		LG_AddReliableCommand( cl, va( "cp %d %s", cl->serverId, LG_PureChecksums( systemInfo, cl->checksumFeed ) ) );
+	}
+}
+
+/*
+================
+LG_SnapshotReceived
+================
+*/
+static void LG_SnapshotReceived( lgClient_t *cl, int serverTime, const playerState_t *ps, int64_t now ) {
+	int i, packetNum;
+
+	if ( cl->state == LG_PRIMED ) {
+		cl->state = LG_ACTIVE;
+		for ( i = 0; i < lgNumCommands; i++ ) {
+			LG_AddReliableCommand( cl, lgCommands[i] );
+		}
+	} else if ( cl->snapRealtime && serverTime - cl->snapServerTime > 0 ) {
+		// a steady server delivers snapshots exactly as far apart as their server times
+		LG_AddSample( &cl->jitter, ( now - cl->snapRealtime ) / 1000.0f - ( serverTime - cl->snapServerTime ) );
+	}
+
+	// the newest command the server has run tells how old this snapshot is for us
+	for ( i = 0; i < PACKET_BACKUP; i++ ) {
+		packetNum = ( cl->netchan.outgoingSequence - 1 - i ) & PACKET_MASK;
+		if ( !cl->outPackets[packetNum].realtime || !cl->outPackets[packetNum].serverTime ) {
+			break;
+		}
+		if ( ps->commandTime - cl->outPackets[packetNum].serverTime >= 0 ) {
+			LG_AddSample( &cl->latency, ( now - cl->outPackets[packetNum].realtime ) / 1000.0f );
+			break;
+		}
+	}
+
+	cl->snapshotCount++;
+	cl->snapServerTime = serverTime;
+	cl->snapRealtime = now;
+}
+
+/*
+================
+LG_ParseSnapshot
+
+Only the playerState is decoded, the entities that follow are skipped
+================
+*/
+static void LG_ParseSnapshot( lgClient_t *cl, msg_t *msg, int64_t now ) {
+	const lgSnapshot_t	*old;
+	lgSnapshot_t		*snap;
+	byte				areamask[MAX_MAP_AREA_BYTES];
+	int					serverTime, deltaNum, areabytes;
+	qboolean			valid;
+
+	serverTime = MSG_ReadLong( msg );
+	deltaNum = MSG_ReadByte( msg );
+	deltaNum = deltaNum ? cl->serverMessageSequence - deltaNum : -1;
+	MSG_ReadByte( msg );	// snapFlags
+
+	areabytes = MSG_ReadByte( msg );
+	if ( areabytes > sizeof( areamask ) ) {
+		Com_Error( ERR_DROP, "%s: invalid size %d for areamask", __func__, areabytes );
+	}
+	MSG_ReadData( msg, areamask, areabytes );
+
+	if ( deltaNum <= 0 ) {
+		old = NULL;
+		valid = qtrue;
+	} else {
+		old = &cl->snapshots[deltaNum & PACKET_MASK];
+		valid = old->valid && old->messageNum == deltaNum;
+	}
+
+	snap = &cl->snapshots[cl->serverMessageSequence & PACKET_MASK];
+	MSG_ReadDeltaPlayerstate( msg, old ? &old->ps : NULL, &snap->ps );
+	snap->messageNum = cl->serverMessageSequence;
+	snap->valid = valid;
+
+	if ( !valid ) {
+		return;
+	}
+
+	cl->snapMessageNum = cl->serverMessageSequence;
+	LG_SnapshotReceived( cl, serverTime, &snap->ps, now );
+}
+
+/*
+================
+LG_ParseServerMessage
+================
+*/
+static void LG_ParseServerMessage( lgClient_t *cl, msg_t *msg, int64_t now ) {
+	int cmd;
+
+	MSG_Bitstream( msg );
+
+	cl->reliableAcknowledge = MSG_ReadLong( msg );
+	if ( cl->reliableSequence - cl->reliableAcknowledge > LG_RELIABLE_COMMANDS
+		|| cl->reliableSequence - cl->reliableAcknowledge < 0 ) {
+		cl->reliableAcknowledge = cl->reliableSequence;
+	}
+
+	while ( cl->state != LG_DROPPED ) {
+		if ( msg->readcount > msg->cursize ) {
+			Com_Error( ERR_DROP, "%s: read past end of server message", __func__ );
+		}
+
+		cmd = MSG_ReadByte( msg );
+		switch ( cmd ) {
+		case svc_EOF:
+			return;
+		case svc_nop:
+			break;
+		case svc_serverCommand:
+			LG_ParseCommandString( cl, msg );
+			break;
+		case svc_gamestate:
+			LG_ParseGamestate( cl, msg );
+			break;
+		case svc_snapshot:
+			LG_ParseSnapshot( cl, msg, now );
+			return;
+		default:
+			// downloads and voip are of no interest
+			return;
+		}
+	}
+}
+
+/*
+================
+LG_ConnectionlessPacket
+================
+*/
+static void LG_ConnectionlessPacket( lgClient_t *cl, msg_t *msg, int64_t now ) {
+	const char	*s;
+	int			challenge, visible, clientChallenge, protocol, n;
+
+	MSG_BeginReadingOOB( msg );
+	MSG_ReadLong( msg );
+	s = MSG_ReadStringLine( msg );
+
+	if ( !Q_strncmp( s, "challengeResponse ", 18 ) ) {
+		if ( cl->state != LG_CHALLENGING ) {
+			return;
+		}
+		n = sscanf( s + 18, "%d %d %d %d", &challenge, &visible, &clientChallenge, &protocol );
+		if ( n < 4 || clientChallenge != cl->clientChallenge ) {
+			return;
+		}
+		if ( protocol <= OLD_PROTOCOL_VERSION ) {
+			LG_Drop( cl, va( "server protocol %i is not supported, only %i", protocol, NEW_PROTOCOL_VERSION ) );
+			return;
+		}
+		cl->challenge = challenge;
+		cl->protocol = protocol;
+		cl->state = LG_CONNECTING;
+		cl->lastResend = now;
+		LG_SendConnect( cl );
+	} else if ( !Q_strncmp( s, "connectResponse", 15 ) ) {
+		if ( cl->state != LG_CONNECTING || atoi( s + 15 ) != cl->challenge ) {
+			return;
+		}
+		Netchan_Setup( NS_CLIENT, &cl->netchan, &lgServer, cl->qport, cl->challenge, qfalse );
+		cl->state = LG_CONNECTED;
+		cl->nextPacket = now;
+	} else if ( !Q_strncmp( s, "print", 5 ) ) {
+		s = MSG_ReadString( msg );
+		if ( !Q_strncmp( s, "[err_dialog]", 12 ) || !Q_strncmp( s, "[err_prot]", 10 ) ) {
+			s = strchr( s, ']' ) + 1;
+		}
+		if ( cl->state < LG_CONNECTED ) {
+			// the server refused the connection
+			LG_Drop( cl, va( "refused: %s", s ) );
+		}
+	} else if ( !Q_strncmp( s, "disconnect", 10 ) ) {
+		if ( cl->state >= LG_CONNECTED ) {
+			LG_Drop( cl, "server disconnected" );
+		}
+	}
+}
+
+/*
+================
+LG_PacketEvent
+================
+*/
+static void LG_PacketEvent( lgClient_t *cl, msg_t *msg, int64_t now ) {
+	if ( msg->cursize < 4 ) {
+		return;
+	}
+
+	if ( *(int32_t *)msg->data == -1 ) {
+		LG_ConnectionlessPacket( cl, msg, now );
+		return;
+	}
+
+	if ( cl->state < LG_CONNECTED || cl->state == LG_DROPPED ) {
+		return;
+	}
+
+	if ( !Netchan_Process( &cl->netchan, msg ) ) {
+		return;
+	}
+
+	cl->serverMessageSequence = LittleLong( *(int32_t *)msg->data );
+	cl->lastPacketTime = now;
+
+	LG_ParseServerMessage( cl, msg, now );
+}
+
+/*
+================
+LG_OpenSocket
+================
+*/
+static SOCKET LG_OpenSocket( const netadr_t *source ) {
+	struct sockaddr_in	addr;
+	SOCKET				s;
+#ifdef _WIN32
+	u_long				nonblocking = 1;
+#endif
+	int					size = 256 * 1024;
+
+	s = socket( AF_INET, SOCK_DGRAM, IPPROTO_UDP );
+	if ( s == INVALID_SOCKET ) {
+		return INVALID_SOCKET;
+	}
+
+	// a gamestate arrives as a burst of fragments
+	setsockopt( s, SOL_SOCKET, SO_RCVBUF, (const char *)&size, sizeof( size ) );
+
+	LG_AdrToSockaddr( source, &addr );
+	if ( bind( s, (struct sockaddr *)&addr, sizeof( addr ) ) != 0 ) {
+		closesocket( s );
+		return INVALID_SOCKET;
+	}
+
+#ifdef _WIN32
+	ioctlsocket( s, FIONBIO, &nonblocking );
+#else
+	fcntl( s, F_SETFL, fcntl( s, F_GETFL, 0 ) | O_NONBLOCK );
+#endif
+
+	return s;
+}
+
+/*
+================
+LG_ClientFrame
+
+Handshake retransmits, packets and timeouts
+================
+*/
+static void LG_ClientFrame( lgClient_t *cl, int64_t now ) {
+	lgCurrent = cl;
+	qport->integer = cl->qport;
+
+	switch ( cl->state ) {
+	case LG_WAITING:
+		if ( now < cl->startTime ) {
+			break;
+		}
+		cl->sock = LG_OpenSocket( &cl->source );
+		if ( cl->sock == INVALID_SOCKET ) {
+			LG_Drop( cl, va( "couldn't bind to %s", NET_AdrToString( &cl->source ) ) );
+			break;
+		}
+		cl->state = LG_CHALLENGING;
+		cl->lastResend = now;
+		NET_OutOfBandPrint( NS_CLIENT, &lgServer, "getchallenge %d %s", cl->clientChallenge, GAMENAME_FOR_MASTER );
+		break;
+
+	case LG_CHALLENGING:
+	case LG_CONNECTING:
+		if ( now - cl->lastResend < LG_RESEND_MSEC * 1000 ) {
+			break;
+		}
+		cl->lastResend = now;
+		if ( cl->state == LG_CHALLENGING ) {
+			NET_OutOfBandPrint( NS_CLIENT, &lgServer, "getchallenge %d %s", cl->clientChallenge, GAMENAME_FOR_MASTER );
+		} else {
+			LG_SendConnect( cl );
+		}
+		break;
+
+	case LG_CONNECTED:
+	case LG_PRIMED:
+	case LG_ACTIVE:
+		if ( cl->lastPacketTime && now - cl->lastPacketTime > LG_PACKET_TIMEOUT * 1000 ) {
+			LG_Drop( cl, "server timed out" );
+			break;
+		}
+		if ( now >= cl->nextPacket ) {
+			LG_WritePacket( cl, now );
+			cl->nextPacket += 1000000 / lgFps;
+			if ( cl->nextPacket < now ) {
+				cl->nextPacket = now + 1000000 / lgFps;
+			}
+		}
+		break;
+
+	default:
+		break;
+	}
+
+	lgCurrent = NULL;
+}
+
+/*
+================
+LG_ReadPackets
+================
+*/
+static void LG_ReadPackets( lgClient_t *cl, int64_t now ) {
+	static byte			buf[MAX_MSGLEN_BUF];
+	struct sockaddr_in	from;
+	socklen_t			fromlen;
+	msg_t				msg;
+	int					len;
+
+	while ( cl->sock != INVALID_SOCKET ) {
+		fromlen = sizeof( from );
+		len = recvfrom( cl->sock, (char *)buf, MAX_PACKETLEN * 2, 0, (struct sockaddr *)&from, &fromlen );
+		if ( len <= 0 ) {
+			break;
+		}
+		if ( from.sin_port != lgServer.port || memcmp( &from.sin_addr, lgServer.ipv._4, 4 ) ) {
+			continue;
+		}
+		if ( cl->state == LG_DROPPED ) {
+			continue;
+		}
+
+		MSG_Init( &msg, buf, MAX_MSGLEN );
+		msg.cursize = len;
+
+		lgCurrent = cl;
+		qport->integer = cl->qport;
+		lgAbortSet = qtrue;
+		if ( setjmp( lgAbort ) ) {
+			lgAbortSet = qfalse;
+			LG_Drop( cl, va( "bad server message: %s", cl->dropReason ) );
+			break;
+		}
+		LG_PacketEvent( cl, &msg, now );
+		lgAbortSet = qfalse;
+	}
+
+	lgCurrent = NULL;
+}
+
+/*
+================
+LG_Disconnect
+
+Sends the disconnect a few times in case one is dropped, like CL_Disconnect
+================
+*/
+static void LG_Disconnect( lgClient_t *cl, int64_t now ) {
+	if ( cl->state < LG_CONNECTED || cl->state == LG_DROPPED ) {
+		return;
+	}
+
+	lgCurrent = cl;
+	qport->integer = cl->qport;
+	LG_AddReliableCommand( cl, "disconnect" );
+	LG_WritePacket( cl, now );
+	LG_WritePacket( cl, now );
+	LG_WritePacket( cl, now );
+	lgCurrent = NULL;
+}
+
+/*
+================
+LG_RunFrames
+
+Services every client until the deadline or until done() says so
+================
+*/
+static void LG_RunFrames( int64_t deadline, qboolean ( *done )( void ) ) {
+	struct timeval	tv;
+	fd_set			fds;
+	SOCKET			maxfd;
+	lgClient_t		*cl;
+	int64_t			now, next;
+	int				i;
+
+	while ( ( now = LG_Microseconds() ) < deadline ) {
+		if ( done && done() ) {
+			return;
+		}
+
+		next = deadline;
+		FD_ZERO( &fds );
+		maxfd = 0;
+		for ( i = 0, cl = lgClients; i < lgNumClients; i++, cl++ ) {
+			LG_ClientFrame( cl, now );
+			if ( cl->state == LG_WAITING ) {
+				next = MIN( next, cl->startTime );
+			} else if ( cl->state >= LG_CONNECTED && cl->state != LG_DROPPED ) {
+				next = MIN( next, cl->nextPacket );
+			} else if ( cl->state != LG_DROPPED ) {
+				next = MIN( next, cl->lastResend + LG_RESEND_MSEC * 1000 );
+			}
+			if ( cl->sock != INVALID_SOCKET ) {
+				FD_SET( cl->sock, &fds );
+				maxfd = MAX( maxfd, cl->sock );
+			}
+		}
+
+		now = LG_Microseconds();
+		next = MAX( next - now, 0 );
+		tv.tv_sec = next / 1000000;
+		tv.tv_usec = next % 1000000;
+		if ( select( maxfd + 1, &fds, NULL, NULL, &tv ) <= 0 ) {
+			continue;
+		}
+
+		now = LG_Microseconds();
+		for ( i = 0, cl = lgClients; i < lgNumClients; i++, cl++ ) {
+			if ( cl->sock != INVALID_SOCKET && FD_ISSET( cl->sock, &fds ) ) {
+				LG_ReadPackets( cl, now );
+			}
+		}
+	}
+}
+
+static qboolean LG_AllSettled( void ) {
+	int i;
+
+	for ( i = 0; i < lgNumClients; i++ ) {
+		if ( lgClients[i].state != LG_ACTIVE && lgClients[i].state != LG_DROPPED ) {
+			return qfalse;
+		}
+	}
+
+	return qtrue;
+}
+
+
+/*
+==============================================================
+
+SERVER METRICS
+
+==============================================================
+*/
+
+/*
+================
+LG_ReadServerFrames
+
+Scrapes the frame time histogram served on sv_metricsPort
+================
+*/
+static qboolean LG_ReadServerFrames( int port, lgServerFrames_t *frames ) {
+	static char			buf[256 * 1024];
+	static const char	request[] = "GET /metrics HTTP/1.0\r\n\r\n";
+	struct sockaddr_in	addr;
+	SOCKET				s;
+	const char			*line, *p;
+	int					len, n;
+
+	memset( frames, 0, sizeof( *frames ) );
+	frames->load = -1;
+
+	s = socket( AF_INET, SOCK_STREAM, IPPROTO_TCP );
+	if ( s == INVALID_SOCKET ) {
+		return qfalse;
+	}
+
+	LG_AdrToSockaddr( &lgServer, &addr );
+	addr.sin_port = htons( port );
+	if ( connect( s, (struct sockaddr *)&addr, sizeof( addr ) ) != 0
+		|| send( s, request, sizeof( request ) - 1, 0 ) != sizeof( request ) - 1 ) {
+		closesocket( s );
+		return qfalse;
+	}
+
+	len = 0;
+	while ( len < sizeof( buf ) - 1 && ( n = recv( s, buf + len, sizeof( buf ) - 1 - len, 0 ) ) > 0 ) {
+		len += n;
+	}
+	buf[len] = '\0';
+	closesocket( s );
+
+	for ( line = buf; line && *line; line = ( p = strchr( line, '\n' ) ) ? p + 1 : NULL ) {
+		if ( !Q_strncmp( line, "ete_server_frame_seconds_bucket{le=\"", 36 ) ) {
+			if ( frames->numBuckets < ARRAY_LEN( frames->bounds ) ) {
+				frames->bounds[frames->numBuckets] = line[36] == '+' ? 0 : atof( line + 36 );
+				p = strchr( line, '}' );
+				frames->counts[frames->numBuckets++] = p ? strtoll( p + 1, NULL, 10 ) : 0;
+			}
+		} else if ( !Q_strncmp( line, "ete_server_frame_seconds_sum ", 29 ) ) {
+			frames->sum = atof( line + 29 );
+		} else if ( !Q_strncmp( line, "ete_server_frame_seconds_count ", 31 ) ) {
+			frames->count = strtoll( line + 31, NULL, 10 );
+		} else if ( !Q_strncmp( line, "ete_server_load_percent ", 24 ) ) {
+			frames->load = atoi( line + 24 );
+		}
+	}
+
+	return frames->numBuckets > 0;
+}
+
+/*
+================
+LG_PrintServerFrames
+================
+*/
+static void LG_PrintServerFrames( const lgServerFrames_t *before, const lgServerFrames_t *after ) {
+	int64_t	count, inBucket, prev;
+	int		i;
+
+	count = after->count - before->count;
+	if ( count <= 0 || after->numBuckets != before->numBuckets ) {
+		Com_Printf( "Server frames: no data\n" );
+		return;
+	}
+
+	Com_Printf( "Server frames: %lli, mean %.2f ms", (long long)count, ( after->sum - before->sum ) * 1000.0 / count );
+	if ( after->load >= 0 ) {
+		Com_Printf( ", load %i%%", after->load );
+	}
+	Com_Printf( "\n" );
+
+	prev = 0;
+	for ( i = 0; i < after->numBuckets; i++ ) {
+		const int64_t cumulative = after->counts[i] - before->counts[i];
+
+		inBucket = cumulative - prev;
+		prev = cumulative;
+		if ( !inBucket ) {
+			continue;
+		}
+		if ( i == after->numBuckets - 1 ) {
+			Com_Printf( "  %8s ms  %6.2f%%\n", "longer", inBucket * 100.0 / count );
+		} else {
+			Com_Printf( "  <= %5g ms  %6.2f%%\n", after->bounds[i] * 1000.0, inBucket * 100.0 / count );
+		}
+	}
+}
+
+
+/*
+==============================================================
+
+REPORT
+
+==============================================================
+*/
+
+/*
+================
+LG_Report
+
+Returns the number of clients that didn't make it through the run
+================
+*/
+static int LG_Report( double seconds ) {
+	lgSamples_t	allLatency, allJitter;
+	lgClient_t	*cl;
+	int64_t		bytesIn, bytesOut, dropped;
+	float		mean;
+	int			i, late, failed, snapshots;
+
+	memset( &allLatency, 0, sizeof( allLatency ) );
+	memset( &allJitter, 0, sizeof( allJitter ) );
+	failed = 0;
+	snapshots = 0;
+
+	Com_Printf( "\nclient  state     snaps  in kB/s  out kB/s  drop  latency ms: mean    p50    p99    max\n" );
+	for ( i = 0, cl = lgClients; i < lgNumClients; i++, cl++ ) {
+		bytesIn = cl->netchan.stats.bytesReceived - cl->startStats.bytesReceived;
+		bytesOut = cl->netchan.stats.bytesSent - cl->startStats.bytesSent;
+		dropped = cl->netchan.stats.dropped - cl->startStats.dropped;
+
+		LG_AppendSamples( &allLatency, &cl->latency );
+		LG_AppendSamples( &allJitter, &cl->jitter );
+		mean = LG_SortSamples( &cl->latency );
+
+		Com_Printf( "%6i  %-8s %6i  %7.1f  %8.1f  %4lli  %16.1f %6.1f %6.1f %6.1f\n", cl->num,
+			lgStateNames[cl->state], cl->snapshotCount, bytesIn / 1024.0 / seconds, bytesOut / 1024.0 / seconds,
+			(long long)dropped, mean, LG_Percentile( &cl->latency, 0.5f ), LG_Percentile( &cl->latency, 0.99f ),
+			LG_Percentile( &cl->latency, 1.0f ) );
+
+		if ( cl->state != LG_ACTIVE ) {
+			failed++;
+		}
+		snapshots += cl->snapshotCount;
+	}
+
+	mean = LG_SortSamples( &allLatency );
+	Com_Printf( "\nClients in game: %i of %i\n", lgNumClients - failed, lgNumClients );
+	Com_Printf( "Latency: mean %.1f ms, p50 %.1f, p99 %.1f, max %.1f\n", mean,
+		LG_Percentile( &allLatency, 0.5f ), LG_Percentile( &allLatency, 0.99f ), LG_Percentile( &allLatency, 1.0f ) );
+
+	mean = LG_SortSamples( &allJitter );
+	for ( i = 0, late = 0; i < allJitter.count; i++ ) {
+		if ( allJitter.values[i] > 1000.0f / lgSnaps / 2 ) {
+			late++;
+		}
+	}
+	Com_Printf( "Snapshots: %i (%.1f/s per client), arrival vs server time: mean %+.2f ms, p1 %+.2f, p99 %+.2f, max %+.2f, %i late by half an interval\n",
+		snapshots, lgNumClients - failed ? snapshots / seconds / ( lgNumClients - failed ) : 0.0, mean,
+		LG_Percentile( &allJitter, 0.01f ), LG_Percentile( &allJitter, 0.99f ), LG_Percentile( &allJitter, 1.0f ), late );
+
+	return failed;
+}
+
+/*
+================
+LG_Usage
+================
+*/
+static void NORETURN LG_Usage( void ) {
+	fprintf( stderr, "usage: loadgen [-clients <n>] [-duration <sec>] [-fps <n>] [-cmds <file>] [-seed <n>]\n"
+		"               [-rate <n>] [-snaps <n>] [-source <ip>] [-perip <n>] [-stagger <msec>]\n"
+		"               [-timeout <sec>] [-basepath <dir>]... [-cmd <text>]... [-metrics <port>]\n"
+		"               <server[:port]>\n" );
+	exit( 1 );
+}
+
+
+/*
+================
+main
+================
+*/
+int main( int argc, char **argv ) {
+	const char			*serverName = NULL;
+	const char			*sourceName = "127.0.0.1";
+	int					duration = 30;
+	int					perIP = 1;
+	int					stagger = 50;
+	int					timeout = 20;
+	int					metricsPort = 0;
+	unsigned int		seed = 1;
+	lgServerFrames_t	framesBefore, framesAfter;
+	qboolean			haveFrames = qfalse;
+	netadr_t			source;
+	lgClient_t			*cl;
+	int64_t				start;
+	uint32_t			firstSource;
+	int					i, failed;
+#ifdef _WIN32
+	WSADATA				winsockdata;
+#endif
+
+	for ( i = 1; i < argc; i++ ) {
+		if ( !strcmp( argv[i], "-clients" ) && i + 1 < argc ) {
+			lgNumClients = atoi( argv[++i] );
+		} else if ( !strcmp( argv[i], "-duration" ) && i + 1 < argc ) {
+			duration = atoi( argv[++i] );
+		} else if ( !strcmp( argv[i], "-fps" ) && i + 1 < argc ) {
+			lgFps = atoi( argv[++i] );
+		} else if ( !strcmp( argv[i], "-cmds" ) && i + 1 < argc ) {
+			LG_LoadStream( argv[++i] );
+		} else if ( !strcmp( argv[i], "-seed" ) && i + 1 < argc ) {
+			seed = strtoul( argv[++i], NULL, 0 );
+		} else if ( !strcmp( argv[i], "-rate" ) && i + 1 < argc ) {
+			lgRate = atoi( argv[++i] );
+		} else if ( !strcmp( argv[i], "-snaps" ) && i + 1 < argc ) {
+			lgSnaps = atoi( argv[++i] );
+		} else if ( !strcmp( argv[i], "-source" ) && i + 1 < argc ) {
+			sourceName = argv[++i];
+		} else if ( !strcmp( argv[i], "-perip" ) && i + 1 < argc ) {
+			perIP = atoi( argv[++i] );
+		} else if ( !strcmp( argv[i], "-stagger" ) && i + 1 < argc ) {
+			stagger = atoi( argv[++i] );
+		} else if ( !strcmp( argv[i], "-timeout" ) && i + 1 < argc ) {
+			timeout = atoi( argv[++i] );
+		} else if ( !strcmp( argv[i], "-basepath" ) && i + 1 < argc && lgNumBasepaths < MAX_LG_BASEPATHS ) {
+			lgBasepaths[lgNumBasepaths++] = argv[++i];
+		} else if ( !strcmp( argv[i], "-cmd" ) && i + 1 < argc && lgNumCommands < MAX_LG_COMMANDS ) {
+			lgCommands[lgNumCommands++] = argv[++i];
+		} else if ( !strcmp( argv[i], "-metrics" ) && i + 1 < argc ) {
+			metricsPort = atoi( argv[++i] );
+		} else if ( argv[i][0] != '-' && !serverName ) {
+			serverName = argv[i];
+		} else {
+			LG_Usage();
+		}
+	}
+
+	if ( !serverName || lgNumClients <= 0 || lgNumClients > MAX_LG_CLIENTS || duration <= 0
+		|| lgFps <= 0 || lgFps > 1000 || lgSnaps <= 0 || perIP <= 0 || stagger < 0 || timeout <= 0 ) {
+		LG_Usage();
+	}
+
+#ifdef _WIN32
+	if ( WSAStartup( MAKEWORD( 2, 2 ), &winsockdata ) != 0 ) {
+		Com_Error( ERR_FATAL, "Winsock initialization failed" );
+	}
+#endif
+
+	Netchan_Init( 0 );
+
+	if ( !NET_StringToAdr( serverName, &lgServer, NA_IP ) || lgServer.type != NA_IP ) {
+		Com_Error( ERR_FATAL, "Couldn't resolve %s", serverName );
+	}
+	if ( !Sys_StringToAdr( sourceName, &source, NA_IP ) ) {
+		Com_Error( ERR_FATAL, "Couldn't resolve %s", sourceName );
+	}
+	memcpy( &firstSource, source.ipv._4, 4 );
+	firstSource = ntohl( firstSource );
+
+	lgClients = calloc( lgNumClients, sizeof( lgClient_t ) );
+	if ( !lgClients ) {
+		Com_Error( ERR_FATAL, "Out of memory for %i clients", lgNumClients );
+	}
+
+	start = LG_Microseconds();
+	for ( i = 0, cl = lgClients; i < lgNumClients; i++, cl++ ) {
+		uint32_t addr = htonl( firstSource + i / perIP );
+
+		cl->num = i;
+		cl->sock = INVALID_SOCKET;
+		cl->source = source;
+		cl->source.port = 0;
+		memcpy( cl->source.ipv._4, &addr, 4 );
+		cl->startTime = start + (int64_t)i * stagger * 1000;
+		cl->clientChallenge = ( ( rand() << 16 ) ^ rand() ^ (int)start ) & 0x7fffffff;
+		cl->qport = ( ( seed * 7919 + i * 104729 ) & 0x7fff ) + 1;
+		cl->seed = seed + i * 7919;
+		cl->streamPos = lgStream ? i * lgStreamCmds / lgNumClients : 0;
+	}
+
+	Com_Printf( "Connecting %i clients to %s\n", lgNumClients, NET_AdrToString( &lgServer ) );
+	LG_RunFrames( start + (int64_t)( timeout * 1000 + lgNumClients * stagger ) * 1000, LG_AllSettled );
+
+	for ( i = 0, cl = lgClients; i < lgNumClients; i++, cl++ ) {
+		if ( cl->state != LG_ACTIVE && cl->state != LG_DROPPED ) {
+			LG_Drop( cl, va( "not in game after %i seconds (%s)", timeout, lgStateNames[cl->state] ) );
+		}
+	}
+	Com_Printf( "Connected in %.2f s, measuring for %i s\n", ( LG_Microseconds() - start ) / 1e6, duration );
+
+	// measure from here on
+	for ( i = 0, cl = lgClients; i < lgNumClients; i++, cl++ ) {
+		cl->startStats = cl->netchan.stats;
+		cl->snapshotCount = 0;
+		cl->latency.count = 0;
+		cl->jitter.count = 0;
+	}
+	if ( metricsPort ) {
+		haveFrames = LG_ReadServerFrames( metricsPort, &framesBefore );
+		if ( !haveFrames ) {
+			Com_Printf( "WARNING: couldn't read metrics from port %i\n", metricsPort );
+		}
+	}
+
+	start = LG_Microseconds();
+	LG_RunFrames( start + (int64_t)duration * 1000000, NULL );
+
+	failed = LG_Report( ( LG_Microseconds() - start ) / 1e6 );
+
+	if ( haveFrames && LG_ReadServerFrames( metricsPort, &framesAfter ) ) {
+		LG_PrintServerFrames( &framesBefore, &framesAfter );
+	}
+
+	for ( i = 0, cl = lgClients; i < lgNumClients; i++, cl++ ) {
+		LG_Disconnect( cl, LG_Microseconds() );
+		if ( cl->sock != INVALID_SOCKET ) {
+			closesocket( cl->sock );
+		}
+	}
+
+	return failed ? 1 : 0;
+}
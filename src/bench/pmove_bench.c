@@ -0,0 +1,796 @@
+/*
+===========================================================================
+
+Wolfenstein: Enemy Territory GPL Source Code
+Copyright (C) 1999-2010 id Software LLC, a ZeniMax Media company.
+
+This file is part of the Wolfenstein: Enemy Territory GPL Source Code (Wolf ET Source Code).
+
+Wolf ET Source Code is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Wolf ET Source Code is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Wolf ET Source Code.  If not, see <http://www.gnu.org/licenses/>.
+
+In addition, the Wolf: ET Source Code is also subject to certain additional terms. You should have received a copy of these additional terms immediately following the terms and conditions of the GNU General Public License which accompanied the Wolf ET Source Code.  If not, please request a copy in writing from id Software at the address below.
+
+If you have questions concerning this license or the applicable additional terms, you may contact in writing id Software LLC, c/o ZeniMax Media Inc., Suite 120, Rockville, Maryland 20850 USA.
+
+===========================================================================
+*/
+
+// pmove_bench.c -- standalone Pmove determinism and throughput benchmark
+//
+// Loads a bsp through CM_LoadMap and replays usercmd streams through the
+// shared bg_pmove.c code against the world collision model. No renderer,
+// window, filesystem or VM is involved, the handful of engine services the
+// collision code needs are provided below.
+//
+// pmovebench [options] <file.bsp>
+//   -cmds <file>      replay a recorded usercmd stream (may be repeated)
+//   -gen <count>      generate a synthetic stream of <count> commands
+//   -seed <n>         seed for -gen (default 1)
+//   -msec <n>         command interval for -gen (default 8)
+//   -write <file>     save the generated stream for later replay
+//   -iterations <n>   replay every stream <n> times (default 10)
+//   -gametype <n>     g_gametype seen by Pmove (default 2)
+//   -origin <x y z>   start position instead of the first spawn point
+//   -expect <hex>     exit with failure if the checksum differs
+//   -stress <threads> compare random traces from several threads against
+//                     a single threaded run
+//   -queries <n>      queries per thread for -stress (default 1000000)
+//   -cvar <name> <v>  override the default of an engine cvar, the patch
+//                     cache (cm_patchCache) is off unless enabled here
+
+#include "../qcommon/q_shared.h"
+#include "../qcommon/qcommon.h"
+#include "../qcommon/cm_public.h"
+#include "pmove_bench.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#endif
+
+#define MAX_STREAMS		64
+
+typedef struct {
+	char		name[MAX_OSPATH];
+	usercmd_t	*cmds;
+	int			numCmds;
+} pmbStream_t;
+
+static pmbStream_t	pmbStreams[MAX_STREAMS];
+static int			pmbNumStreams;
+
+cvar_t	*com_sv_running;
+int		cl_optimizedPatchServer;
+
+
+/*
+==============================================================
+
+ENGINE SERVICES
+
+Minimal replacements for what the collision model pulls in
+from common.c, cvar.c and files.c.
+
+==============================================================
+*/
+
+void QDECL Com_Printf( const char *fmt, ... ) {
+	va_list argptr;
+
+	va_start( argptr, fmt );
+	vprintf( fmt, argptr );
+	va_end( argptr );
+}
+
+void QDECL Com_DPrintf( const char *fmt, ... ) {
+}
+
+void NORETURN QDECL Com_Error( errorParm_t code, const char *fmt, ... ) {
+	va_list argptr;
+
+	va_start( argptr, fmt );
+	fprintf( stderr, "ERROR: " );
+	vfprintf( stderr, fmt, argptr );
+	fprintf( stderr, "\n" );
+	va_end( argptr );
+
+	exit( 1 );
+}
+
+// -cvar overrides for the defaults the engine code registers
+#define MAX_PMB_CVARS	16
+static const char	*pmbCvarNames[MAX_PMB_CVARS] = { "cm_patchCache" };
+static const char	*pmbCvarValues[MAX_PMB_CVARS] = { "0" };
+static int			pmbNumCvars = 1;
+
+cvar_t *Cvar_Get( const char *var_name, const char *value, int flags ) {
+	cvar_t *var;
+	int i;
+
+	for ( i = 0; i < pmbNumCvars; i++ ) {
+		if ( !Q_stricmp( pmbCvarNames[i], var_name ) ) {
+			value = pmbCvarValues[i];
+		}
+	}
+
+	var = calloc( 1, sizeof( *var ) );
+	var->name = strdup( var_name );
+	var->string = strdup( value );
+	var->flags = flags;
+	var->value = atof( value );
+	var->integer = atoi( value );
+
+	return var;
+}
+
+void Cvar_SetDescription( cvar_t *var, const char *var_description ) {
+}
+
+#ifdef HUNK_DEBUG
+void *Hunk_AllocDebug( int size, ha_pref preference, char *label, char *file, int line ) {
+#else
+void *Hunk_Alloc( int size, ha_pref preference ) {
+#endif
+	void *buf;
+
+	buf = calloc( 1, size );
+	if ( !buf ) {
+		Com_Error( ERR_FATAL, "Hunk_Alloc failed on %i", size );
+	}
+
+	return buf;
+}
+
+#ifdef ZONE_DEBUG
+void *Z_MallocDebug( int size, char *label, char *file, int line ) {
+#else
+void *Z_Malloc( int size ) {
+#endif
+	void *buf;
+
+	buf = calloc( 1, size );
+	if ( !buf ) {
+		Com_Error( ERR_FATAL, "Z_Malloc: failed on allocation of %i bytes", size );
+	}
+
+	return buf;
+}
+
+void Z_Free( void *ptr ) {
+	free( ptr );
+}
+
+// qpaths are plain OS paths here
+int FS_ReadFile( const char *qpath, void **buffer ) {
+	FILE	*f;
+	byte	*buf;
+	long	len;
+
+	if ( buffer ) {
+		*buffer = NULL;
+	}
+
+	f = Sys_FOpen( qpath, "rb" );
+	if ( !f ) {
+		return -1;
+	}
+
+	fseek( f, 0, SEEK_END );
+	len = ftell( f );
+	fseek( f, 0, SEEK_SET );
+
+	if ( !buffer ) {
+		fclose( f );
+		return len;
+	}
+
+	buf = malloc( len + 1 );
+	if ( fread( buf, 1, len, f ) != len ) {
+		Com_Error( ERR_FATAL, "Short read on %s", qpath );
+	}
+	buf[len] = '\0';
+	fclose( f );
+
+	*buffer = buf;
+	return len;
+}
+
+void FS_FreeFile( void *buffer ) {
+	free( buffer );
+}
+
+int FS_ReadBSP( const char *qpath, const void **buffer ) {
+	return FS_ReadFile( qpath, (void **)buffer );
+}
+
+void FS_FreeBSP( const void *buffer ) {
+	FS_FreeFile( (void *)buffer );
+}
+
+void *Hunk_AllocateTempMemory( int size ) {
+	return Z_Malloc( size );
+}
+
+void Hunk_FreeTempMemory( void *buf ) {
+	free( buf );
+}
+
+// external .ent overrides are not supported
+int FS_FOpenFileRead( const char *qpath, fileHandle_t *file, qboolean uniqueFILE ) {
+	*file = FS_INVALID_HANDLE;
+	return -1;
+}
+
+// handles for the patch cache, relative to the working directory
+#define MAX_PMB_FILES	4
+static FILE	*pmbFiles[MAX_PMB_FILES];
+
+static fileHandle_t PMB_OpenFile( const char *qpath, const char *mode ) {
+	fileHandle_t f;
+
+	for ( f = 1; f < MAX_PMB_FILES; f++ ) {
+		if ( !pmbFiles[f] ) {
+			pmbFiles[f] = Sys_FOpen( qpath, mode );
+			return pmbFiles[f] ? f : FS_INVALID_HANDLE;
+		}
+	}
+
+	return FS_INVALID_HANDLE;
+}
+
+int FS_Home_FOpenFileRead( const char *filename, fileHandle_t *file ) {
+	long len;
+
+	*file = PMB_OpenFile( filename, "rb" );
+	if ( *file == FS_INVALID_HANDLE ) {
+		return -1;
+	}
+
+	fseek( pmbFiles[*file], 0, SEEK_END );
+	len = ftell( pmbFiles[*file] );
+	fseek( pmbFiles[*file], 0, SEEK_SET );
+
+	return len;
+}
+
+fileHandle_t FS_FOpenFileWrite( const char *qpath ) {
+	char	dir[MAX_OSPATH], *s;
+
+	Q_strncpyz( dir, qpath, sizeof( dir ) );
+	s = strrchr( dir, '/' );
+	if ( s ) {
+		*s = '\0';
+#ifdef _WIN32
+		CreateDirectoryA( dir, NULL );
+#else
+		mkdir( dir, 0755 );
+#endif
+	}
+
+	return PMB_OpenFile( qpath, "wb" );
+}
+
+int FS_Read( void *buffer, int len, fileHandle_t f ) {
+	if ( f <= 0 || f >= MAX_PMB_FILES || !pmbFiles[f] ) {
+		return 0;
+	}
+	return fread( buffer, 1, len, pmbFiles[f] );
+}
+
+int FS_Write( const void *buffer, int len, fileHandle_t f ) {
+	if ( f <= 0 || f >= MAX_PMB_FILES || !pmbFiles[f] ) {
+		return 0;
+	}
+	return fwrite( buffer, 1, len, pmbFiles[f] );
+}
+
+void FS_FCloseFile( fileHandle_t f ) {
+	if ( f > 0 && f < MAX_PMB_FILES && pmbFiles[f] ) {
+		fclose( pmbFiles[f] );
+		pmbFiles[f] = NULL;
+	}
+}
+
+FILE *Sys_FOpen( const char *ospath, const char *mode ) {
+	return fopen( ospath, mode );
+}
+
+int Cmd_Argc( void ) {
+	return 0;
+}
+
+const char *Cmd_Argv( int arg ) {
+	return "";
+}
+
+int64_t Sys_Microseconds( void ) {
+	return PMB_Nanoseconds() / 1000;
+}
+
+struct sysThread_s {
+#ifdef _WIN32
+	HANDLE			handle;
+#else
+	pthread_t		handle;
+#endif
+	sysThreadFunc_t	func;
+	void			*arg;
+};
+
+#ifdef _WIN32
+static DWORD WINAPI PMB_ThreadMain( LPVOID arg ) {
+	( (sysThread_t *)arg )->func( ( (sysThread_t *)arg )->arg );
+	return 0;
+}
+#else
+static void *PMB_ThreadMain( void *arg ) {
+	( (sysThread_t *)arg )->func( ( (sysThread_t *)arg )->arg );
+	return NULL;
+}
+#endif
+
+sysThread_t *Sys_CreateThread( sysThreadFunc_t func, void *arg ) {
+	sysThread_t *thread;
+
+	thread = calloc( 1, sizeof( *thread ) );
+	thread->func = func;
+	thread->arg = arg;
+#ifdef _WIN32
+	thread->handle = CreateThread( NULL, 0, PMB_ThreadMain, thread, 0, NULL );
+	if ( !thread->handle ) {
+#else
+	if ( pthread_create( &thread->handle, NULL, PMB_ThreadMain, thread ) != 0 ) {
+#endif
+		free( thread );
+		return NULL;
+	}
+
+	return thread;
+}
+
+void Sys_JoinThread( sysThread_t *thread ) {
+#ifdef _WIN32
+	WaitForSingleObject( thread->handle, INFINITE );
+	CloseHandle( thread->handle );
+#else
+	pthread_join( thread->handle, NULL );
+#endif
+	free( thread );
+}
+
+int Sys_NumCPUs( void ) {
+#ifdef _WIN32
+	SYSTEM_INFO info;
+
+	GetSystemInfo( &info );
+	return MAX( 1, (int)info.dwNumberOfProcessors );
+#else
+	return MAX( 1, (int)sysconf( _SC_NPROCESSORS_ONLN ) );
+#endif
+}
+
+
+/*
+==============================================================
+
+COLLISION CALLBACKS
+
+==============================================================
+*/
+
+/*
+================
+PMB_Trace
+
+Same as SV_Trace with passEntityNum -2, world only
+================
+*/
+void PMB_Trace( trace_t *results, const vec3_t start, const vec3_t mins, const vec3_t maxs, const vec3_t end, int passEntityNum, int contentMask ) {
+	CM_BoxTrace( results, start, end, mins, maxs, 0, contentMask, qfalse );
+	results->entityNum = results->fraction != 1.0 ? ENTITYNUM_WORLD : ENTITYNUM_NONE;
+}
+
+
+/*
+================
+PMB_PointContents
+================
+*/
+int PMB_PointContents( const vec3_t point, int passEntityNum ) {
+	return CM_PointContents( point, 0 );
+}
+
+
+/*
+================
+PMB_Nanoseconds
+================
+*/
+int64_t PMB_Nanoseconds( void ) {
+#ifdef _WIN32
+	static LARGE_INTEGER freq;
+	LARGE_INTEGER count;
+
+	if ( !freq.QuadPart ) {
+		QueryPerformanceFrequency( &freq );
+	}
+	QueryPerformanceCounter( &count );
+
+	return (int64_t)( (double)count.QuadPart * 1e9 / (double)freq.QuadPart );
+#else
+	struct timespec ts;
+
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+
+	return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#endif
+}
+
+
+/*
+==============================================================
+
+STREAMS
+
+==============================================================
+*/
+
+/*
+================
+PMB_AllocStream
+================
+*/
+static pmbStream_t *PMB_AllocStream( const char *name, int numCmds ) {
+	pmbStream_t *stream;
+
+	if ( pmbNumStreams >= MAX_STREAMS ) {
+		Com_Error( ERR_FATAL, "Too many streams, max %i", MAX_STREAMS );
+	}
+
+	stream = &pmbStreams[pmbNumStreams++];
+	Q_strncpyz( stream->name, name, sizeof( stream->name ) );
+	stream->numCmds = numCmds;
+	stream->cmds = calloc( numCmds, sizeof( usercmd_t ) );
+	if ( !stream->cmds ) {
+		Com_Error( ERR_FATAL, "Out of memory for %i commands", numCmds );
+	}
+
+	return stream;
+}
+
+
+/*
+================
+PMB_LoadStream
+================
+*/
+static void PMB_LoadStream( const char *filename ) {
+	pmbStream_t	*stream;
+	usercmd_t	*cmd;
+	byte		*buf, *p;
+	int			len, numCmds, i;
+
+	len = FS_ReadFile( filename, (void **)&buf );
+	if ( !buf ) {
+		Com_Error( ERR_FATAL, "Couldn't load %s", filename );
+	}
+
+	if ( len < 12 || LittleLong( ( (int *)buf )[0] ) != PMB_STREAM_IDENT ) {
+		Com_Error( ERR_FATAL, "%s is not a usercmd stream", filename );
+	}
+	if ( LittleLong( ( (int *)buf )[1] ) != PMB_STREAM_VERSION ) {
+		Com_Error( ERR_FATAL, "%s has wrong version number (%i should be %i)", filename,
+			LittleLong( ( (int *)buf )[1] ), PMB_STREAM_VERSION );
+	}
+
+	numCmds = LittleLong( ( (int *)buf )[2] );
+	if ( numCmds <= 0 || numCmds > ( len - 12 ) / PMB_STREAM_CMDSIZE ) {
+		Com_Error( ERR_FATAL, "%s is truncated", filename );
+	}
+
+	stream = PMB_AllocStream( filename, numCmds );
+
+	p = buf + 12;
+	for ( i = 0, cmd = stream->cmds; i < numCmds; i++, cmd++, p += PMB_STREAM_CMDSIZE ) {
+		cmd->serverTime = LittleLong( ( (int *)p )[0] );
+		cmd->angles[0] = LittleLong( ( (int *)p )[1] );
+		cmd->angles[1] = LittleLong( ( (int *)p )[2] );
+		cmd->angles[2] = LittleLong( ( (int *)p )[3] );
+		cmd->buttons = p[16];
+		cmd->wbuttons = p[17];
+		cmd->weapon = p[18];
+		cmd->flags = p[19];
+		cmd->forwardmove = (signed char)p[20];
+		cmd->rightmove = (signed char)p[21];
+		cmd->upmove = (signed char)p[22];
+		cmd->doubleTap = p[23];
+	}
+
+	FS_FreeFile( buf );
+}
+
+
+/*
+================
+PMB_WriteStream
+================
+*/
+static void PMB_WriteStream( const pmbStream_t *stream, const char *filename ) {
+	const usercmd_t	*cmd;
+	byte			rec[PMB_STREAM_CMDSIZE];
+	int				header[3];
+	FILE			*f;
+	int				i;
+
+	f = Sys_FOpen( filename, "wb" );
+	if ( !f ) {
+		Com_Error( ERR_FATAL, "Couldn't write %s", filename );
+	}
+
+	header[0] = LittleLong( PMB_STREAM_IDENT );
+	header[1] = LittleLong( PMB_STREAM_VERSION );
+	header[2] = LittleLong( stream->numCmds );
+	fwrite( header, sizeof( header ), 1, f );
+
+	for ( i = 0, cmd = stream->cmds; i < stream->numCmds; i++, cmd++ ) {
+		( (int *)rec )[0] = LittleLong( cmd->serverTime );
+		( (int *)rec )[1] = LittleLong( cmd->angles[0] );
+		( (int *)rec )[2] = LittleLong( cmd->angles[1] );
+		( (int *)rec )[3] = LittleLong( cmd->angles[2] );
+		rec[16] = cmd->buttons;
+		rec[17] = cmd->wbuttons;
+		rec[18] = cmd->weapon;
+		rec[19] = cmd->flags;
+		rec[20] = (byte)cmd->forwardmove;
+		rec[21] = (byte)cmd->rightmove;
+		rec[22] = (byte)cmd->upmove;
+		rec[23] = cmd->doubleTap;
+		fwrite( rec, sizeof( rec ), 1, f );
+	}
+
+	fclose( f );
+	Com_Printf( "Wrote %i commands to %s\n", stream->numCmds, filename );
+}
+
+
+/*
+================
+PMB_FindSpawnPoint
+
+Returns the first player spawn from the entity string
+================
+*/
+static qboolean PMB_FindSpawnPoint( vec3_t origin, float *yaw ) {
+	static const char *spawnClasses[] = {
+		"team_CTF_redplayer", "team_CTF_blueplayer",
+		"team_CTF_redspawn", "team_CTF_bluespawn",
+		"info_player_deathmatch", "info_player_start", NULL
+	};
+	const char	*text, *token;
+	char		key[MAX_TOKEN_CHARS];
+	char		classname[MAX_TOKEN_CHARS];
+	vec3_t		entOrigin;
+	float		entYaw;
+	qboolean	hasOrigin;
+	int			i;
+
+	text = CM_EntityString();
+
+	while ( 1 ) {
+		token = COM_Parse( &text );
+		if ( !text || token[0] != '{' ) {
+			return qfalse;
+		}
+
+		classname[0] = '\0';
+		hasOrigin = qfalse;
+		entYaw = 0;
+
+		while ( 1 ) {
+			token = COM_Parse( &text );
+			if ( !text || token[0] == '}' ) {
+				break;
+			}
+			Q_strncpyz( key, token, sizeof( key ) );
+			token = COM_Parse( &text );
+
+			if ( !Q_stricmp( key, "classname" ) ) {
+				Q_strncpyz( classname, token, sizeof( classname ) );
+			} else if ( !Q_stricmp( key, "origin" ) ) {
+				hasOrigin = ( sscanf( token, "%f %f %f", &entOrigin[0], &entOrigin[1], &entOrigin[2] ) == 3 );
+			} else if ( !Q_stricmp( key, "angle" ) ) {
+				entYaw = atof( token );
+			}
+		}
+
+		if ( !hasOrigin ) {
+			continue;
+		}
+
+		for ( i = 0; spawnClasses[i]; i++ ) {
+			if ( !Q_stricmp( classname, spawnClasses[i] ) ) {
+				VectorCopy( entOrigin, origin );
+				*yaw = entYaw;
+				return qtrue;
+			}
+		}
+	}
+}
+
+
+/*
+================
+PMB_Usage
+================
+*/
+static void NORETURN PMB_Usage( void ) {
+	fprintf( stderr, "usage: pmovebench [-cmds <file>]... [-gen <count>] [-seed <n>] [-msec <n>]\n"
+		"                  [-write <file>] [-iterations <n>] [-gametype <n>]\n"
+		"                  [-origin <x> <y> <z>] [-expect <hex>]\n"
+		"                  [-stress <threads>] [-queries <n>] [-cvar <name> <value>]...\n"
+		"                  <file.bsp>\n" );
+	exit( 1 );
+}
+
+
+/*
+================
+main
+================
+*/
+int main( int argc, char **argv ) {
+	const char		*mapName = NULL;
+	const char		*writeName = NULL;
+	int				genCount = 0;
+	unsigned int	seed = 1;
+	int				msec = 8;
+	int				iterations = 10;
+	int				gametype = 2;
+	qboolean		haveOrigin = qfalse;
+	qboolean		haveExpect = qfalse;
+	unsigned int	expect = 0;
+	int				stressThreads = 0;
+	int				stressQueries = 1000000;
+	vec3_t			origin;
+	float			yaw = 0;
+	int				mapChecksum;
+	unsigned int	checksum, passChecksum;
+	int64_t			start, elapsed, total;
+	int				totalCmds;
+	pmbStream_t		*stream;
+	int				i, n;
+
+	for ( i = 1; i < argc; i++ ) {
+		if ( !strcmp( argv[i], "-cmds" ) && i + 1 < argc ) {
+			PMB_LoadStream( argv[++i] );
+		} else if ( !strcmp( argv[i], "-gen" ) && i + 1 < argc ) {
+			genCount = atoi( argv[++i] );
+		} else if ( !strcmp( argv[i], "-seed" ) && i + 1 < argc ) {
+			seed = strtoul( argv[++i], NULL, 0 );
+		} else if ( !strcmp( argv[i], "-msec" ) && i + 1 < argc ) {
+			msec = atoi( argv[++i] );
+		} else if ( !strcmp( argv[i], "-write" ) && i + 1 < argc ) {
+			writeName = argv[++i];
+		} else if ( !strcmp( argv[i], "-iterations" ) && i + 1 < argc ) {
+			iterations = atoi( argv[++i] );
+		} else if ( !strcmp( argv[i], "-gametype" ) && i + 1 < argc ) {
+			gametype = atoi( argv[++i] );
+		} else if ( !strcmp( argv[i], "-origin" ) && i + 3 < argc ) {
+			origin[0] = atof( argv[++i] );
+			origin[1] = atof( argv[++i] );
+			origin[2] = atof( argv[++i] );
+			haveOrigin = qtrue;
+		} else if ( !strcmp( argv[i], "-expect" ) && i + 1 < argc ) {
+			expect = strtoul( argv[++i], NULL, 16 );
+			haveExpect = qtrue;
+		} else if ( !strcmp( argv[i], "-stress" ) && i + 1 < argc ) {
+			stressThreads = atoi( argv[++i] );
+		} else if ( !strcmp( argv[i], "-queries" ) && i + 1 < argc ) {
+			stressQueries = atoi( argv[++i] );
+		} else if ( !strcmp( argv[i], "-cvar" ) && i + 2 < argc && pmbNumCvars < MAX_PMB_CVARS ) {
+			pmbCvarNames[pmbNumCvars] = argv[++i];
+			pmbCvarValues[pmbNumCvars] = argv[++i];
+			pmbNumCvars++;
+		} else if ( argv[i][0] != '-' && !mapName ) {
+			mapName = argv[i];
+		} else {
+			PMB_Usage();
+		}
+	}
+
+	if ( !mapName || msec <= 0 || iterations <= 0 ) {
+		PMB_Usage();
+	}
+
+	if ( genCount > 0 ) {
+		stream = PMB_AllocStream( va( "generated seed %u", seed ), genCount );
+		PMB_GenerateStream( stream->cmds, genCount, seed, msec );
+		if ( writeName ) {
+			PMB_WriteStream( stream, writeName );
+		}
+	}
+
+	if ( !pmbNumStreams && stressThreads <= 0 ) {
+		PMB_Usage();
+	}
+
+	com_sv_running = Cvar_Get( "sv_running", "1", CVAR_ROM );
+
+	start = PMB_Nanoseconds();
+	CM_LoadMap( mapName, qfalse, &mapChecksum );
+	elapsed = PMB_Nanoseconds() - start;
+	Com_Printf( "Loaded %s in %.2f ms, checksum %08x\n", mapName, elapsed / 1e6, (unsigned int)mapChecksum );
+
+	// concurrent collision queries against single threaded results
+	if ( stressThreads > 0 ) {
+		if ( CM_StressTest( stressThreads, stressQueries, seed ) != 0 ) {
+			return 1;
+		}
+		if ( !pmbNumStreams ) {
+			return 0;
+		}
+	}
+
+	if ( !haveOrigin && !PMB_FindSpawnPoint( origin, &yaw ) ) {
+		Com_Error( ERR_FATAL, "No spawn point in %s, use -origin", mapName );
+	}
+	Com_Printf( "Start position ( %.1f %.1f %.1f ) yaw %.1f\n", origin[0], origin[1], origin[2], yaw );
+
+	PMB_InitGame( gametype );
+
+	checksum = 2166136261u;
+	total = 0;
+	totalCmds = 0;
+
+	for ( i = 0, stream = pmbStreams; i < pmbNumStreams; i++, stream++ ) {
+		unsigned int streamChecksum = 2166136261u;
+		int64_t best = 0;
+
+		for ( n = 0; n < iterations; n++ ) {
+			passChecksum = 2166136261u;
+			elapsed = PMB_RunStream( stream->cmds, stream->numCmds, origin, yaw, &passChecksum );
+
+			if ( n == 0 ) {
+				streamChecksum = passChecksum;
+			} else if ( passChecksum != streamChecksum ) {
+				Com_Error( ERR_FATAL, "%s: iteration %i produced checksum %08x, expected %08x",
+					stream->name, n, passChecksum, streamChecksum );
+			}
+
+			if ( n == 0 || elapsed < best ) {
+				best = elapsed;
+			}
+			total += elapsed;
+			totalCmds += stream->numCmds;
+		}
+
+		Com_Printf( "%-40s %7i cmds  best %8.1f ns/cmd  checksum %08x\n", stream->name,
+			stream->numCmds, (double)best / stream->numCmds, streamChecksum );
+
+		checksum = ( checksum ^ streamChecksum ) * 16777619u;
+	}
+
+	Com_Printf( "Total: %i cmds, %.1f ns/cmd average, checksum %08x\n", totalCmds, (double)total / totalCmds, checksum );
+
+	if ( haveExpect && checksum != expect ) {
+		Com_Printf( "Checksum mismatch, expected %08x\n", expect );
+		return 1;
+	}
+
+	return 0;
+}
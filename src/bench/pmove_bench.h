@@ -0,0 +1,59 @@
+/*
+===========================================================================
+
+Wolfenstein: Enemy Territory GPL Source Code
+Copyright (C) 1999-2010 id Software LLC, a ZeniMax Media company.
+
+This file is part of the Wolfenstein: Enemy Territory GPL Source Code (Wolf ET Source Code).
+
+Wolf ET Source Code is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Wolf ET Source Code is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Wolf ET Source Code.  If not, see <http://www.gnu.org/licenses/>.
+
+In addition, the Wolf: ET Source Code is also subject to certain additional terms. You should have received a copy of these additional terms immediately following the terms and conditions of the GNU General Public License which accompanied the Wolf ET Source Code.  If not, please request a copy in writing from id Software at the address below.
+
+If you have questions concerning this license or the applicable additional terms, you may contact in writing id Software LLC, c/o ZeniMax Media Inc., Suite 120, Rockville, Maryland 20850 USA.
+
+===========================================================================
+*/
+
+// pmove_bench.h -- interface between the engine and game halves of the
+// standalone pmove benchmark. The engine half (pmove_bench.c) is built
+// against qcommon and owns the collision model, the game half
+// (pmove_bench_game.c) is built with GAMEDLL and owns the bg_* code, so
+// only q_shared.h types may cross this boundary.
+
+#ifndef __PMOVE_BENCH_H__
+#define __PMOVE_BENCH_H__
+
+// usercmd stream file layout, all values little endian:
+//   int32 PMB_STREAM_IDENT, int32 PMB_STREAM_VERSION, int32 numCmds
+//   numCmds * { int32 serverTime, int32 angles[3],
+//               byte buttons, wbuttons, weapon, flags,
+//               int8 forwardmove, rightmove, upmove, byte doubleTap }
+#define PMB_STREAM_IDENT    ( ( 'D' << 24 ) + ( 'M' << 16 ) + ( 'C' << 8 ) + 'P' )
+#define PMB_STREAM_VERSION  1
+#define PMB_STREAM_CMDSIZE  24
+
+// engine half
+void	PMB_Trace( trace_t *results, const vec3_t start, const vec3_t mins, const vec3_t maxs, const vec3_t end, int passEntityNum, int contentMask );
+int		PMB_PointContents( const vec3_t point, int passEntityNum );
+int64_t	PMB_Nanoseconds( void );
+
+// game half
+void	PMB_InitGame( int gametype );
+void	PMB_GenerateStream( usercmd_t *cmds, int numCmds, unsigned int seed, int msec );
+// runs the whole stream from a fresh spawn, returns time spent inside Pmove
+// and folds every resulting playerState into *checksum
+int64_t	PMB_RunStream( const usercmd_t *cmds, int numCmds, const vec3_t origin, float yaw, unsigned int *checksum );
+
+#endif // __PMOVE_BENCH_H__
@@ -0,0 +1,334 @@
+/*
+===========================================================================
+
+Wolfenstein: Enemy Territory GPL Source Code
+Copyright (C) 1999-2010 id Software LLC, a ZeniMax Media company.
+
+This file is part of the Wolfenstein: Enemy Territory GPL Source Code (Wolf ET Source Code).
+
+Wolf ET Source Code is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Wolf ET Source Code is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Wolf ET Source Code.  If not, see <http://www.gnu.org/licenses/>.
+
+In addition, the Wolf: ET Source Code is also subject to certain additional terms. You should have received a copy of these additional terms immediately following the terms and conditions of the GNU General Public License which accompanied the Wolf ET Source Code.  If not, please request a copy in writing from id Software at the address below.
+
+If you have questions concerning this license or the applicable additional terms, you may contact in writing id Software LLC, c/o ZeniMax Media Inc., Suite 120, Rockville, Maryland 20850 USA.
+
+===========================================================================
+*/
+
+// pmove_bench_game.c -- game half of the pmove benchmark, compiled with
+// GAMEDLL so bg_pmove.c sees the same configuration as qagame
+
+#include "../qcommon/q_shared.h"
+#include "../game/bg_public.h"
+#include "pmove_bench.h"
+
+// values used by the server side of Pmove, see g_client.c / g_active.c
+#define PMB_GRAVITY		800
+#define PMB_SPEED		320
+
+static const vec3_t pmbMins = { -18, -18, -24 };
+static const vec3_t pmbMaxs = { 18, 18, 48 };
+
+vmCvar_t g_gametype;
+vmCvar_t g_movespeed;
+vmCvar_t g_developer;
+
+// an empty animation script is parsed, so all script lookups fall through
+static animScriptData_t	pmbScriptData;
+static animModelInfo_t	pmbAnimModelInfo;
+static bg_character_t	pmbCharacter;
+
+
+/*
+==============================================================
+
+GAME MODULE STUBS
+
+Only the parts of the qagame syscall surface referenced by bg_*.c.
+
+==============================================================
+*/
+
+bg_character_t *BG_GetCharacterForPlayerstate( playerState_t *ps ) {
+	return &pmbCharacter;
+}
+
+void ClientStoreSurfaceFlags( int clientNum, int surfaceFlags ) {
+}
+
+void G_BroadcastServerCommand( int ignoreClient, const char *command ) {
+}
+
+void trap_SnapVector( float *v ) {
+	SnapVector( v );
+}
+
+void trap_Cvar_Register( vmCvar_t *cvar, const char *var_name, const char *value, int flags ) {
+	if ( cvar ) {
+		Q_strncpyz( cvar->string, value, sizeof( cvar->string ) );
+		cvar->value = atof( value );
+		cvar->integer = atoi( value );
+	}
+}
+
+void trap_Cvar_Update( vmCvar_t *cvar ) {
+}
+
+void trap_Cvar_Set( const char *var_name, const char *value ) {
+}
+
+void trap_Cvar_VariableStringBuffer( const char *var_name, char *buffer, int bufsize ) {
+	if ( bufsize > 0 ) {
+		*buffer = '\0';
+	}
+}
+
+int trap_PC_ReadToken( int handle, pc_token_t *pc_token ) {
+	return 0;
+}
+
+int trap_PC_SourceFileAndLine( int handle, char *filename, int *line ) {
+	return 0;
+}
+
+
+/*
+==============================================================
+
+BENCHMARK DRIVER
+
+==============================================================
+*/
+
+/*
+================
+PMB_InitGame
+================
+*/
+void PMB_InitGame( int gametype ) {
+	g_gametype.integer = gametype;
+	g_movespeed.integer = 76;
+	g_developer.integer = 0;
+
+	// also registers the condition table Pmove updates every frame
+	BG_AnimParseAnimScript( &pmbAnimModelInfo, &pmbScriptData, "pmovebench", "" );
+	pmbCharacter.animModelInfo = &pmbAnimModelInfo;
+}
+
+
+/*
+================
+PMB_SpawnPlayer
+
+Mirrors the movement related parts of ClientSpawn
+================
+*/
+static void PMB_SpawnPlayer( playerState_t *ps, pmoveExt_t *pmext, const vec3_t origin, float yaw ) {
+	memset( ps, 0, sizeof( *ps ) );
+	memset( pmext, 0, sizeof( *pmext ) );
+
+	VectorCopy( origin, ps->origin );
+	ps->origin[2] += 9;
+	ps->viewangles[YAW] = yaw;
+	ps->delta_angles[YAW] = ANGLE2SHORT( yaw );
+
+	ps->pm_type = PM_NORMAL;
+	ps->persistant[PERS_TEAM] = TEAM_AXIS;
+	ps->stats[STAT_PLAYER_CLASS] = PC_SOLDIER;
+	ps->stats[STAT_HEALTH] = ps->stats[STAT_MAX_HEALTH] = 100;
+
+	VectorCopy( pmbMins, ps->mins );
+	VectorCopy( pmbMaxs, ps->maxs );
+	ps->crouchViewHeight = CROUCH_VIEWHEIGHT;
+	ps->standViewHeight = DEFAULT_VIEWHEIGHT;
+	ps->deadViewHeight = DEAD_VIEWHEIGHT;
+	ps->viewheight = DEFAULT_VIEWHEIGHT;
+	ps->crouchMaxZ = ps->maxs[2] - ( ps->standViewHeight - ps->crouchViewHeight );
+	ps->runSpeedScale = 0.8;
+	ps->sprintSpeedScale = 1.1;
+	ps->crouchSpeedScale = 0.25;
+	ps->friction = 1.0;
+	ps->weaponstate = WEAPON_READY;
+
+	COM_BitSet( ps->weapons, WP_KNIFE );
+	COM_BitSet( ps->weapons, WP_MP40 );
+	ps->ammoclip[BG_FindClipForWeapon( WP_MP40 )] = 30;
+	ps->ammo[BG_FindAmmoForWeapon( WP_MP40 )] = 90;
+	ps->weapon = WP_MP40;
+
+	pmext->sprintTime = SPRINTTIME;
+}
+
+
+/*
+================
+PMB_Random
+
+Private LCG so generated streams don't depend on the C library
+================
+*/
+static unsigned int PMB_Random( unsigned int *seed ) {
+	*seed = *seed * 1103515245u + 12345u;
+	return ( *seed >> 16 ) & 0x7fff;
+}
+
+
+/*
+================
+PMB_GenerateStream
+
+Synthesizes a plausible movement stream: runs of straight, strafing,
+crouched and prone movement with jumps, sprinting, leaning, turning
+and the occasional burst of fire
+================
+*/
+void PMB_GenerateStream( usercmd_t *cmds, int numCmds, unsigned int seed, int msec ) {
+	static const signed char moves[3] = { -127, 0, 127 };
+	usercmd_t	cmd;
+	int			segment, yawSpeed;
+	int			i;
+
+	memset( &cmd, 0, sizeof( cmd ) );
+	cmd.serverTime = 1000;
+	cmd.weapon = WP_MP40;
+
+	segment = 0;
+	yawSpeed = 0;
+
+	for ( i = 0; i < numCmds; i++ ) {
+		if ( --segment <= 0 ) {
+			segment = ( 250 + PMB_Random( &seed ) % 750 ) / msec + 1;
+
+			cmd.forwardmove = moves[PMB_Random( &seed ) % 3];
+			cmd.rightmove = moves[PMB_Random( &seed ) % 3];
+			cmd.upmove = 0;
+			cmd.buttons = 0;
+			cmd.wbuttons = 0;
+
+			switch ( PMB_Random( &seed ) % 8 ) {
+			case 0:
+				cmd.upmove = -127;
+				break;
+			case 1:
+				cmd.wbuttons |= WBUTTON_PRONE;
+				break;
+			case 2:
+				cmd.wbuttons |= ( PMB_Random( &seed ) & 1 ) ? WBUTTON_LEANLEFT : WBUTTON_LEANRIGHT;
+				break;
+			case 3:
+				cmd.buttons |= BUTTON_ATTACK;
+				break;
+			default:
+				if ( PMB_Random( &seed ) & 1 ) {
+					cmd.buttons |= BUTTON_SPRINT;
+				}
+				break;
+			}
+
+			yawSpeed = (int)( PMB_Random( &seed ) % 181 ) - 90;
+			cmd.angles[PITCH] = ANGLE2SHORT( (int)( PMB_Random( &seed ) % 61 ) - 30 );
+		}
+
+		// jumps are edge triggered, so pulse them
+		if ( cmd.upmove >= 0 ) {
+			cmd.upmove = ( PMB_Random( &seed ) % 64 ) == 0 ? 127 : 0;
+		}
+
+		cmd.angles[YAW] += ANGLE2SHORT( yawSpeed * msec / 1000.0f );
+		cmd.serverTime += msec;
+		cmds[i] = cmd;
+	}
+}
+
+
+/*
+================
+PMB_ChecksumState
+
+FNV-1a over the whole state, both structures are memset on spawn
+so padding stays deterministic
+================
+*/
+static unsigned int PMB_ChecksumState( unsigned int hash, const void *data, int length ) {
+	const byte *p = (const byte *)data;
+	int i;
+
+	for ( i = 0; i < length; i++ ) {
+		hash ^= p[i];
+		hash *= 16777619u;
+	}
+
+	return hash;
+}
+
+
+/*
+================
+PMB_RunStream
+================
+*/
+int64_t PMB_RunStream( const usercmd_t *cmds, int numCmds, const vec3_t origin, float yaw, unsigned int *checksum ) {
+	playerState_t	ps;
+	pmoveExt_t		pmext;
+	pmove_t			pm;
+	int				skill[SK_NUM_SKILLS];
+	usercmd_t		oldcmd;
+	int64_t			start, total;
+	int				i;
+
+	PMB_SpawnPlayer( &ps, &pmext, origin, yaw );
+
+	// weapon spread and recoil use rand(), and animation conditions
+	// are kept per client outside the playerState
+	srand( 0 );
+	memset( pmbScriptData.clientConditions, 0, sizeof( pmbScriptData.clientConditions ) );
+
+	memset( skill, 0, sizeof( skill ) );
+	memset( &oldcmd, 0, sizeof( oldcmd ) );
+
+	if ( numCmds > 0 ) {
+		ps.commandTime = cmds[0].serverTime - 8;
+	}
+
+	total = 0;
+
+	for ( i = 0; i < numCmds; i++ ) {
+		ps.gravity = PMB_GRAVITY;
+		ps.speed = PMB_SPEED;
+
+		memset( &pm, 0, sizeof( pm ) );
+		pm.ps = &ps;
+		pm.pmext = &pmext;
+		pm.character = &pmbCharacter;
+		pm.cmd = cmds[i];
+		pm.oldcmd = oldcmd;
+		pm.skill = skill;
+		pm.tracemask = MASK_PLAYERSOLID;
+		pm.trace = PMB_Trace;
+		pm.pointcontents = PMB_PointContents;
+		pm.gametype = g_gametype.integer;
+		pm.noWeapClips = qfalse;
+
+		start = PMB_Nanoseconds();
+		(void)Pmove( &pm );
+		total += PMB_Nanoseconds() - start;
+
+		*checksum = PMB_ChecksumState( *checksum, &ps, sizeof( ps ) );
+		*checksum = PMB_ChecksumState( *checksum, &pmext, sizeof( pmext ) );
+
+		oldcmd = cmds[i];
+	}
+
+	return total;
+}
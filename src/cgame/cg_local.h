@@ -3451,6 +3451,7 @@ extern  qboolean intShaderTime;
 extern  qboolean linearLight;
 extern	qboolean removeAllDefines;
 extern	qboolean getClipboardData;
+extern	qboolean cvarChanges;
 extern	qboolean engine_is_ete;
 
 qboolean trap_GetValue( char *value, int valueSize, const char *key );
@@ -3458,8 +3459,10 @@ void trap_R_AddRefEntityToScene2( const refEntity_t *re );
 void trap_R_AddLinearLightToScene( const vec3_t start, const vec3_t end, float intensity, float r, float g, float b );
 void trap_PC_RemoveAllGlobalDefines( void );
 void trap_GetClipboardData( char *buf, int len );
+int trap_Cvar_Changes( int *handles, int maxHandles );
 extern int dll_com_trapGetValue;
 extern int dll_trap_R_AddRefEntityToScene2;
 extern int dll_trap_R_AddLinearLightToScene;
 extern int dll_trap_PC_RemoveAllGlobalDefines;
 extern int dll_trap_GetClipboardData;
+extern int dll_trap_Cvar_Changes;
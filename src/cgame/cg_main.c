@@ -48,6 +48,7 @@ qboolean intShaderTime = qfalse;
 qboolean linearLight = qfalse;
 qboolean removeAllDefines = qfalse;
 qboolean getClipboardData = qfalse;
+qboolean cvarChanges = qfalse;
 qboolean engine_is_ete = qfalse;
 
 int dll_com_trapGetValue;
@@ -55,6 +56,7 @@ int dll_trap_R_AddRefEntityToScene2;
 int dll_trap_R_AddLinearLightToScene;
 int dll_trap_PC_RemoveAllGlobalDefines;
 int dll_trap_GetClipboardData;
+int dll_trap_Cvar_Changes;
 
 /*
 ================
@@ -600,15 +602,28 @@ CG_UpdateCvars
 =================
 */
 void CG_UpdateCvars( void ) {
+	int changes[MAX_CVAR_CHANGES];
+	int numChanges;
 	qboolean fSetFlags = qfalse;
 
 	if ( !cvarsLoaded ) {
 		return;
 	}
 
+	// only look at the cvars the engine reports as changed
+	if ( cvarChanges ) {
+		numChanges = trap_Cvar_Changes( changes, ARRAY_LEN( changes ) );
+		if ( numChanges == 0 ) {
+			return;
+		}
+		BG_CvarSetChanges( changes, numChanges );
+	}
+
 	fSetFlags = BG_CvarUpdateArray( cg_infoFlags ) > 0 ? qtrue : qfalse;
 	BG_CvarUpdateArray( cg_cvars );
 
+	BG_CvarSetChanges( NULL, -1 );
+
 	// Send any relevent updates
 	if ( fSetFlags ) {
 		CG_setClientFlags();
@@ -2683,6 +2698,10 @@ void CG_Init( int serverMessageNum, int serverCommandSequence, int clientNum, qb
 			dll_trap_GetClipboardData = atoi( value );
 			getClipboardData = qtrue;
 		}
+		if ( trap_GetValue( value, sizeof( value ), "trap_Cvar_Changes_ETE" ) ) {
+			dll_trap_Cvar_Changes = atoi( value );
+			cvarChanges = qtrue;
+		}
 	}
 
 	// load a few needed things before we do any screen updates
@@ -277,6 +277,7 @@ typedef enum {
 	CG_PC_REMOVE_ALL_GLOBAL_DEFINES,
 	CG_GETCLIPBOARDDATA,
 	CG_CMDBACKUP_EXT,
+	CG_CVAR_CHANGES,	// ( int *handles, int maxHandles );
 
 	CG_TRAP_GETVALUE = COM_TRAP_GETVALUE,
 #endif
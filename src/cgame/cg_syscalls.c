@@ -898,4 +898,8 @@ void trap_PC_RemoveAllGlobalDefines( void ) {
 
 void trap_GetClipboardData( char *buf, int len ) {
 	SystemCall( dll_trap_GetClipboardData, buf, len );
+}
+
+int trap_Cvar_Changes( int *handles, int maxHandles ) {
+	return SystemCall( dll_trap_Cvar_Changes, handles, maxHandles );
 }
\ No newline at end of file
@@ -0,0 +1,714 @@
+/*
+===========================================================================
+
+Wolfenstein: Enemy Territory GPL Source Code
+Copyright (C) 1999-2010 id Software LLC, a ZeniMax Media company.
+
+This file is part of the Wolfenstein: Enemy Territory GPL Source Code (Wolf ET Source Code).
+
+Wolf ET Source Code is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Wolf ET Source Code is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Wolf ET Source Code.  If not, see <http://www.gnu.org/licenses/>.
+
+In addition, the Wolf: ET Source Code is also subject to certain additional terms. You should have received a copy of these additional terms immediately following the terms and conditions of the GNU General Public License which accompanied the Wolf ET Source Code.  If not, please request a copy in writing from id Software at the address below.
+
+If you have questions concerning this license or the applicable additional terms, you may contact in writing id Software LLC, c/o ZeniMax Media Inc., Suite 120, Rockville, Maryland 20850 USA.
+
+===========================================================================
+*/
+
+// cl_bench.c -- timedemo benchmark runs with per-frame timing reports
+//
+// "benchmark demo1 demo2 ..." plays the demos back to back as timedemos and
+// times every rendered frame. Each frame is split into the time spent in
+// cgame, the renderer front end (re.RenderScene) and the renderer back end
+// (re.EndFrame); whatever is left of CL_Frame is accounted to the client.
+// When the last demo ends the per-frame samples and a percentile summary
+// are written to cl_benchmarkOutput as csv and json.
+
+#include "client.h"
+
+#define MAX_BENCH_DEMOS		64
+
+typedef enum {
+	BS_IDLE,
+	BS_LOADING,		// "demo" command queued, waiting for playback to start
+	BS_PLAYING
+} benchState_t;
+
+typedef struct {
+	int		usec[ BENCH_NUM_SECTIONS ];
+} benchSample_t;
+
+typedef struct {
+	int		avg;
+	int		p50;
+	int		p95;
+	int		p99;
+	int		max;
+} benchStats_t;
+
+typedef struct {
+	char			name[ MAX_QPATH ];
+	int				first;			// index of the first sample
+	int				count;
+	int				frames;			// timedemo frames
+	int				msec;			// timedemo wall clock time
+	int				hitches;
+	qboolean		completed;
+	benchStats_t	stats[ BENCH_NUM_SECTIONS ];
+} benchDemo_t;
+
+typedef struct {
+	benchState_t	state;
+	int				numDemos;
+	int				current;
+	int				waitFrames;
+	benchDemo_t		demos[ MAX_BENCH_DEMOS ];
+
+	benchSample_t	*samples;
+	int				numSamples;
+	int				maxSamples;
+
+	int64_t			frameStart;
+	int				frameCounter;	// clc.timeDemoFrames when the frame started
+	int64_t			sectionStart[ BENCH_NUM_SECTIONS ];
+	int				sectionUsec[ BENCH_NUM_SECTIONS ];
+
+	char			savedTimedemo[ 16 ];
+} bench_t;
+
+static bench_t bench;
+
+static cvar_t *cl_benchmarkOutput;
+static cvar_t *cl_benchmarkHitch;
+static cvar_t *cl_benchmarkConfig;
+static cvar_t *cl_benchmarkQuit;
+
+static const char *benchSectionNames[ BENCH_NUM_SECTIONS ] = {
+	"frame", "client", "cgame", "rfront", "rback"
+};
+
+
+/*
+================
+CL_BenchBegin
+================
+*/
+void CL_BenchBegin( benchSection_t section ) {
+	if ( bench.state == BS_PLAYING ) {
+		bench.sectionStart[ section ] = Sys_Microseconds();
+	}
+}
+
+
+/*
+================
+CL_BenchEnd
+================
+*/
+void CL_BenchEnd( benchSection_t section ) {
+	if ( bench.state == BS_PLAYING && bench.sectionStart[ section ] ) {
+		bench.sectionUsec[ section ] += (int)( Sys_Microseconds() - bench.sectionStart[ section ] );
+		bench.sectionStart[ section ] = 0;
+	}
+}
+
+
+/*
+================
+CL_BenchAddSample
+================
+*/
+static void CL_BenchAddSample( const benchSample_t *sample ) {
+	if ( bench.numSamples == bench.maxSamples ) {
+		benchSample_t *samples;
+		int max;
+
+		max = bench.maxSamples ? bench.maxSamples * 2 : 4096;
+		samples = realloc( bench.samples, max * sizeof( samples[0] ) );
+		if ( !samples ) {
+			return; // keep what we have, the report will be short
+		}
+		bench.samples = samples;
+		bench.maxSamples = max;
+	}
+
+	bench.samples[ bench.numSamples++ ] = *sample;
+}
+
+
+/*
+================
+CL_BenchCompareInt
+================
+*/
+static int CL_BenchCompareInt( const void *a, const void *b ) {
+	return *(const int *)a - *(const int *)b;
+}
+
+
+/*
+================
+CL_BenchPercentile
+
+Nearest rank percentile of a sorted array
+================
+*/
+static int CL_BenchPercentile( const int *sorted, int count, int percent ) {
+	int index;
+
+	index = ( count * percent + 99 ) / 100 - 1;
+	if ( index < 0 ) {
+		index = 0;
+	}
+
+	return sorted[ index ];
+}
+
+
+/*
+================
+CL_BenchComputeStats
+
+Fills stats for every section of samples [first, first + count) and
+returns the number of hitches, frames slower than cl_benchmarkHitch.
+================
+*/
+static int CL_BenchComputeStats( int first, int count, benchStats_t *stats ) {
+	int		*values;
+	int64_t	sum;
+	int		hitchUsec, hitches;
+	int		i, s;
+
+	Com_Memset( stats, 0, BENCH_NUM_SECTIONS * sizeof( stats[0] ) );
+
+	if ( count <= 0 ) {
+		return 0;
+	}
+
+	values = malloc( count * sizeof( values[0] ) );
+	if ( !values ) {
+		return 0;
+	}
+
+	hitchUsec = (int)( cl_benchmarkHitch->value * 1000.0f );
+	hitches = 0;
+
+	for ( s = 0; s < BENCH_NUM_SECTIONS; s++ ) {
+		sum = 0;
+		for ( i = 0; i < count; i++ ) {
+			values[i] = bench.samples[ first + i ].usec[ s ];
+			sum += values[i];
+			if ( s == BENCH_FRAME && values[i] > hitchUsec ) {
+				hitches++;
+			}
+		}
+
+		qsort( values, count, sizeof( values[0] ), CL_BenchCompareInt );
+
+		stats[s].avg = (int)( sum / count );
+		stats[s].p50 = CL_BenchPercentile( values, count, 50 );
+		stats[s].p95 = CL_BenchPercentile( values, count, 95 );
+		stats[s].p99 = CL_BenchPercentile( values, count, 99 );
+		stats[s].max = values[ count - 1 ];
+	}
+
+	free( values );
+
+	return hitches;
+}
+
+
+/*
+================
+CL_BenchWriteString
+
+Writes a json string literal
+================
+*/
+static void CL_BenchWriteString( fileHandle_t f, const char *s ) {
+	char	buf[ MAX_STRING_CHARS * 2 ];
+	int		n;
+
+	n = 0;
+	buf[ n++ ] = '"';
+	for ( ; *s && n < (int)sizeof( buf ) - 8; s++ ) {
+		if ( *s == '"' || *s == '\\' ) {
+			buf[ n++ ] = '\\';
+			buf[ n++ ] = *s;
+		} else if ( (byte)*s < ' ' ) {
+			n += Com_sprintf( buf + n, sizeof( buf ) - n, "\\u%04x", (byte)*s );
+		} else {
+			buf[ n++ ] = *s;
+		}
+	}
+	buf[ n++ ] = '"';
+
+	FS_Write( buf, n, f );
+}
+
+
+/*
+================
+CL_BenchWriteStats
+================
+*/
+static void CL_BenchWriteStats( fileHandle_t f, const benchStats_t *stats ) {
+	int s;
+
+	for ( s = 0; s < BENCH_NUM_SECTIONS; s++ ) {
+		FS_Printf( f, ", \"%s\": {\"avg\": %.3f, \"p50\": %.3f, \"p95\": %.3f, \"p99\": %.3f, \"max\": %.3f}",
+			benchSectionNames[s], stats[s].avg / 1000.0, stats[s].p50 / 1000.0,
+			stats[s].p95 / 1000.0, stats[s].p99 / 1000.0, stats[s].max / 1000.0 );
+	}
+}
+
+
+/*
+================
+CL_BenchOpenFile
+================
+*/
+static fileHandle_t CL_BenchOpenFile( char *filename, int size, const char *suffix ) {
+	fileHandle_t	f;
+	const char		*ext;
+
+	Q_strncpyz( filename, cl_benchmarkOutput->string, size );
+	COM_StripExtension( filename, filename, size );
+	Q_strcat( filename, size, suffix );
+
+	if ( !FS_AllowedExtension( filename, qfalse, &ext ) ) {
+		Com_Printf( "%s: Invalid filename extension: '%s'.\n", __func__, ext );
+		return FS_INVALID_HANDLE;
+	}
+
+	f = FS_FOpenFileWrite( filename );
+	if ( f == FS_INVALID_HANDLE ) {
+		Com_Printf( "%s: couldn't open %s\n", __func__, filename );
+	}
+
+	return f;
+}
+
+
+/*
+================
+CL_BenchWriteReports
+================
+*/
+static void CL_BenchWriteReports( const benchDemo_t *total ) {
+	char			filename[ MAX_QPATH ];
+	fileHandle_t	f;
+	const benchDemo_t *demo;
+	const benchSample_t *sample;
+	int				d, i, s;
+
+	// summary, one row per demo and section
+	f = CL_BenchOpenFile( filename, sizeof( filename ), ".csv" );
+	if ( f != FS_INVALID_HANDLE ) {
+		FS_Printf( f, "demo,frames,seconds,fps,hitches,section,avg_ms,p50_ms,p95_ms,p99_ms,max_ms\n" );
+		for ( d = 0; d <= bench.numDemos; d++ ) {
+			demo = ( d < bench.numDemos ) ? &bench.demos[d] : total;
+			for ( s = 0; s < BENCH_NUM_SECTIONS; s++ ) {
+				FS_Printf( f, "%s,%i,%.3f,%.2f,%i,%s,%.3f,%.3f,%.3f,%.3f,%.3f\n",
+					demo->name, demo->frames, demo->msec / 1000.0,
+					demo->msec > 0 ? demo->frames * 1000.0 / demo->msec : 0.0, demo->hitches,
+					benchSectionNames[s], demo->stats[s].avg / 1000.0, demo->stats[s].p50 / 1000.0,
+					demo->stats[s].p95 / 1000.0, demo->stats[s].p99 / 1000.0, demo->stats[s].max / 1000.0 );
+			}
+		}
+		FS_FCloseFile( f );
+		Com_Printf( "Wrote %s\n", filename );
+	}
+
+	// raw per-frame samples
+	f = CL_BenchOpenFile( filename, sizeof( filename ), "_frames.csv" );
+	if ( f != FS_INVALID_HANDLE ) {
+		FS_Printf( f, "demo,frame" );
+		for ( s = 0; s < BENCH_NUM_SECTIONS; s++ ) {
+			FS_Printf( f, ",%s_ms", benchSectionNames[s] );
+		}
+		FS_Printf( f, "\n" );
+		for ( d = 0; d < bench.numDemos; d++ ) {
+			demo = &bench.demos[d];
+			for ( i = 0; i < demo->count; i++ ) {
+				sample = &bench.samples[ demo->first + i ];
+				FS_Printf( f, "%s,%i", demo->name, i );
+				for ( s = 0; s < BENCH_NUM_SECTIONS; s++ ) {
+					FS_Printf( f, ",%.3f", sample->usec[s] / 1000.0 );
+				}
+				FS_Printf( f, "\n" );
+			}
+		}
+		FS_FCloseFile( f );
+		Com_Printf( "Wrote %s\n", filename );
+	}
+
+	f = CL_BenchOpenFile( filename, sizeof( filename ), ".json" );
+	if ( f != FS_INVALID_HANDLE ) {
+		FS_Printf( f, "{\n\"renderer\": " );
+		CL_BenchWriteString( f, cls.glconfig.renderer_string );
+		FS_Printf( f, ",\n\"module\": " );
+		CL_BenchWriteString( f, Cvar_VariableString( "cl_renderer" ) );
+		FS_Printf( f, ",\n\"width\": %i,\n\"height\": %i,\n\"swapInterval\": %i,\n\"hitchMsec\": %g,\n\"demos\": [\n",
+			cls.glconfig.vidWidth, cls.glconfig.vidHeight,
+			Cvar_VariableIntegerValue( "r_swapInterval" ), cl_benchmarkHitch->value );
+		for ( d = 0; d <= bench.numDemos; d++ ) {
+			demo = ( d < bench.numDemos ) ? &bench.demos[d] : total;
+			if ( d == bench.numDemos ) {
+				FS_Printf( f, "\n],\n\"total\": " );
+			} else if ( d > 0 ) {
+				FS_Printf( f, ",\n" );
+			}
+			FS_Printf( f, "{\"name\": " );
+			CL_BenchWriteString( f, demo->name );
+			FS_Printf( f, ", \"completed\": %s, \"frames\": %i, \"seconds\": %.3f, \"fps\": %.2f, \"hitches\": %i",
+				demo->completed ? "true" : "false", demo->frames, demo->msec / 1000.0,
+				demo->msec > 0 ? demo->frames * 1000.0 / demo->msec : 0.0, demo->hitches );
+			CL_BenchWriteStats( f, demo->stats );
+			FS_Printf( f, "}" );
+		}
+		FS_Printf( f, "\n}\n" );
+		FS_FCloseFile( f );
+		Com_Printf( "Wrote %s\n", filename );
+	}
+}
+
+
+/*
+================
+CL_BenchPrintDemo
+================
+*/
+static void CL_BenchPrintDemo( const benchDemo_t *demo ) {
+	const benchStats_t *st;
+	int s;
+
+	Com_Printf( "%s: %i frames, %.2f seconds, %.1f fps, %i hitches%s\n", demo->name,
+		demo->frames, demo->msec / 1000.0, demo->msec > 0 ? demo->frames * 1000.0 / demo->msec : 0.0,
+		demo->hitches, demo->completed ? "" : S_COLOR_YELLOW " (incomplete)" );
+
+	for ( s = 0; s < BENCH_NUM_SECTIONS; s++ ) {
+		st = &demo->stats[s];
+		Com_Printf( "  %-6s avg %7.3f  p50 %7.3f  p95 %7.3f  p99 %7.3f  max %7.3f ms\n", benchSectionNames[s],
+			st->avg / 1000.0, st->p50 / 1000.0, st->p95 / 1000.0, st->p99 / 1000.0, st->max / 1000.0 );
+	}
+}
+
+
+/*
+================
+CL_BenchFinish
+================
+*/
+static void CL_BenchFinish( void ) {
+	benchDemo_t	total;
+	int			d;
+
+	Com_Memset( &total, 0, sizeof( total ) );
+	Q_strncpyz( total.name, "total", sizeof( total.name ) );
+	total.completed = qtrue;
+
+	for ( d = 0; d < bench.numDemos; d++ ) {
+		total.frames += bench.demos[d].frames;
+		total.msec += bench.demos[d].msec;
+		total.completed &= bench.demos[d].completed;
+	}
+	total.count = bench.numSamples;
+	total.hitches = CL_BenchComputeStats( 0, total.count, total.stats );
+
+	Com_Printf( "----- Benchmark results -----\n" );
+	for ( d = 0; d < bench.numDemos; d++ ) {
+		CL_BenchPrintDemo( &bench.demos[d] );
+	}
+	if ( bench.numDemos > 1 ) {
+		CL_BenchPrintDemo( &total );
+	}
+
+	CL_BenchWriteReports( &total );
+
+	Cvar_Set( "timedemo", bench.savedTimedemo );
+
+	free( bench.samples );
+	Com_Memset( &bench, 0, sizeof( bench ) );
+
+	if ( cl_benchmarkQuit->integer ) {
+		Cbuf_AddText( "quit\n" );
+	}
+}
+
+
+/*
+================
+CL_BenchEndDemo
+
+Closes the statistics of the current demo
+================
+*/
+static void CL_BenchEndDemo( qboolean completed ) {
+	benchDemo_t *demo;
+	int64_t usec;
+	int i;
+
+	demo = &bench.demos[ bench.current ];
+	demo->completed = completed;
+	demo->count = bench.numSamples - demo->first;
+	demo->hitches = CL_BenchComputeStats( demo->first, demo->count, demo->stats );
+
+	if ( !completed ) {
+		// no timedemo totals, fall back to what was measured
+		demo->frames = demo->count;
+		usec = 0;
+		for ( i = 0; i < demo->count; i++ ) {
+			usec += bench.samples[ demo->first + i ].usec[ BENCH_FRAME ];
+		}
+		demo->msec = (int)( usec / 1000 );
+	}
+}
+
+
+/*
+================
+CL_BenchPlayDemo
+================
+*/
+static void CL_BenchPlayDemo( int index ) {
+	bench.current = index;
+	bench.demos[ index ].first = bench.numSamples;
+	bench.state = BS_LOADING;
+	bench.waitFrames = 0;
+	Cbuf_AddText( va( "demo \"%s\"\n", bench.demos[ index ].name ) );
+}
+
+
+/*
+================
+CL_BenchNextDemo
+================
+*/
+static void CL_BenchNextDemo( void ) {
+	if ( bench.current + 1 >= bench.numDemos ) {
+		CL_BenchFinish();
+	} else {
+		CL_BenchPlayDemo( bench.current + 1 );
+	}
+}
+
+
+/*
+================
+CL_BenchAbort
+
+Reports the demos played so far
+================
+*/
+static void CL_BenchAbort( void ) {
+	CL_BenchEndDemo( qfalse );
+	bench.numDemos = bench.current + 1;
+	CL_BenchFinish();
+}
+
+
+/*
+================
+CL_BenchDemoCompleted
+
+Called when a demo reaches its end, before the client disconnects.
+Returns qtrue if the benchmark takes care of what plays next.
+================
+*/
+qboolean CL_BenchDemoCompleted( void ) {
+	benchDemo_t *demo;
+
+	if ( bench.state != BS_PLAYING ) {
+		return qfalse;
+	}
+
+	demo = &bench.demos[ bench.current ];
+	demo->frames = clc.timeDemoFrames;
+	demo->msec = clc.timeDemoStart ? Sys_Milliseconds() - clc.timeDemoStart : 0;
+
+	CL_BenchEndDemo( qtrue );
+	CL_BenchNextDemo();
+
+	return qtrue;
+}
+
+
+/*
+================
+CL_BenchFrameBegin
+================
+*/
+void CL_BenchFrameBegin( void ) {
+	if ( bench.state == BS_LOADING && clc.demoplaying ) {
+		bench.state = BS_PLAYING;
+	}
+
+	if ( bench.state != BS_PLAYING ) {
+		return;
+	}
+
+	Com_Memset( bench.sectionStart, 0, sizeof( bench.sectionStart ) );
+	Com_Memset( bench.sectionUsec, 0, sizeof( bench.sectionUsec ) );
+	bench.frameCounter = clc.timeDemoFrames;
+	bench.frameStart = Sys_Microseconds();
+}
+
+
+/*
+================
+CL_BenchFrameEnd
+================
+*/
+void CL_BenchFrameEnd( void ) {
+	benchSample_t sample;
+	int *usec;
+
+	if ( bench.state == BS_LOADING ) {
+		// the queued demo command has had a few frames to run
+		if ( !clc.demoplaying && ++bench.waitFrames > 10 ) {
+			Com_Printf( S_COLOR_YELLOW "benchmark: couldn't play %s\n", bench.demos[ bench.current ].name );
+			CL_BenchEndDemo( qfalse );
+			CL_BenchNextDemo();
+		}
+		return;
+	}
+
+	if ( bench.state != BS_PLAYING ) {
+		return;
+	}
+
+	if ( !clc.demoplaying ) {
+		// disconnected or dropped without reaching the end of the demo
+		Com_Printf( S_COLOR_YELLOW "benchmark: %s was interrupted\n", bench.demos[ bench.current ].name );
+		CL_BenchAbort();
+		return;
+	}
+
+	// only frames that advanced the timedemo clock are measured, this
+	// leaves out the loading screens
+	if ( cls.state != CA_ACTIVE || clc.timeDemoFrames == bench.frameCounter ) {
+		return;
+	}
+
+	usec = sample.usec;
+	Com_Memcpy( usec, bench.sectionUsec, sizeof( sample.usec ) );
+	usec[ BENCH_FRAME ] = (int)( Sys_Microseconds() - bench.frameStart );
+
+	// the scene is rendered from inside cgame
+	usec[ BENCH_CGAME ] -= usec[ BENCH_RFRONT ];
+	if ( usec[ BENCH_CGAME ] < 0 ) {
+		usec[ BENCH_CGAME ] = 0;
+	}
+
+	usec[ BENCH_CLIENT ] = usec[ BENCH_FRAME ] - usec[ BENCH_CGAME ] - usec[ BENCH_RFRONT ] - usec[ BENCH_RBACK ];
+	if ( usec[ BENCH_CLIENT ] < 0 ) {
+		usec[ BENCH_CLIENT ] = 0;
+	}
+
+	CL_BenchAddSample( &sample );
+}
+
+
+/*
+================
+CL_Benchmark_f
+
+benchmark <demo> [demo ...]
+benchmark stop
+================
+*/
+void CL_Benchmark_f( void ) {
+	int i, n;
+
+	if ( Cmd_Argc() == 2 && !Q_stricmp( Cmd_Argv( 1 ), "stop" ) ) {
+		if ( bench.state == BS_IDLE ) {
+			Com_Printf( "No benchmark running.\n" );
+			return;
+		}
+		CL_BenchAbort();
+		CL_Disconnect( qtrue );
+		return;
+	}
+
+	if ( Cmd_Argc() < 2 ) {
+		Com_Printf( "Usage: benchmark <demo> [demo ...]\n"
+			"       benchmark stop\n" );
+		return;
+	}
+
+	if ( bench.state != BS_IDLE ) {
+		Com_Printf( "A benchmark is already running, use 'benchmark stop' first.\n" );
+		return;
+	}
+
+	n = Cmd_Argc() - 1;
+	if ( n > MAX_BENCH_DEMOS ) {
+		Com_Printf( "Too many demos, only the first %i will be played.\n", MAX_BENCH_DEMOS );
+		n = MAX_BENCH_DEMOS;
+	}
+
+	Com_Memset( &bench, 0, sizeof( bench ) );
+	for ( i = 0; i < n; i++ ) {
+		Q_strncpyz( bench.demos[i].name, Cmd_Argv( i + 1 ), sizeof( bench.demos[i].name ) );
+	}
+	bench.numDemos = n;
+
+	// every demo is played as a timedemo so all runs sample the same game times
+	Q_strncpyz( bench.savedTimedemo, Cvar_VariableString( "timedemo" ), sizeof( bench.savedTimedemo ) );
+	Cvar_Set( "timedemo", "1" );
+
+	if ( cl_benchmarkConfig->string[0] ) {
+		Cbuf_AddText( va( "exec \"%s\"\n", cl_benchmarkConfig->string ) );
+	}
+
+	CL_BenchPlayDemo( 0 );
+}
+
+
+/*
+================
+CL_BenchShutdown
+================
+*/
+void CL_BenchShutdown( void ) {
+	if ( bench.state != BS_IDLE ) {
+		Cvar_Set( "timedemo", bench.savedTimedemo );
+	}
+
+	free( bench.samples );
+	Com_Memset( &bench, 0, sizeof( bench ) );
+}
+
+
+/*
+================
+CL_BenchInit
+================
+*/
+void CL_BenchInit( void ) {
+	cl_benchmarkOutput = Cvar_Get( "cl_benchmarkOutput", "benchmarks/benchmark", CVAR_ARCHIVE_ND );
+	Cvar_SetDescription( cl_benchmarkOutput, "Report name for the benchmark command, written as .csv, _frames.csv and .json" );
+
+	cl_benchmarkHitch = Cvar_Get( "cl_benchmarkHitch", "50", CVAR_ARCHIVE_ND );
+	Cvar_CheckRange( cl_benchmarkHitch, "1", "1000", CV_FLOAT );
+	Cvar_SetDescription( cl_benchmarkHitch, "Frames slower than this many milliseconds are counted as hitches by the benchmark command" );
+
+	cl_benchmarkConfig = Cvar_Get( "cl_benchmarkConfig", "", CVAR_ARCHIVE_ND );
+	Cvar_SetDescription( cl_benchmarkConfig, "Config executed before the first demo of a benchmark run, to pin the settings being compared" );
+
+	cl_benchmarkQuit = Cvar_Get( "cl_benchmarkQuit", "0", CVAR_TEMP );
+	Cvar_CheckRange( cl_benchmarkQuit, "0", "1", CV_INTEGER );
+	Cvar_SetDescription( cl_benchmarkQuit, "Quit once a benchmark run has written its reports, for scripted runs" );
+}
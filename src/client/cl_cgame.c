@@ -565,7 +565,9 @@ static void CL_CM_LoadMap( const char *mapname ) {
 		Cvar_Set( "com_errorDiagnoseIP", "" );
 	}
 
+	PROFILE_BEGIN( "CM_LoadMap" );
 	CM_LoadMap( mapname, qtrue, &checksum );
+	PROFILE_END();
 	tc_vis_init();
 }
 
@@ -643,6 +645,11 @@ static qboolean CL_CG_GetValue( char* value, int valueSize, const char* key ) {
 		return qtrue;
 	}
 
+	if ( !Q_stricmp( key, "trap_Cvar_Changes_ETE" ) ) {
+		Com_sprintf( value, valueSize, "%i", CG_CVAR_CHANGES );
+		return qtrue;
+	}
+
 	// UTF-8 not yet supported
 	if ( !Q_stricmp( key, "cap_UTF8" ) ) {
 		Com_sprintf( value, valueSize, "%i", 0 );
@@ -721,7 +728,7 @@ static intptr_t CL_CgameSystemCalls( intptr_t *args ) {
 	case CG_MILLISECONDS:
 		return Sys_Milliseconds();
 	case CG_CVAR_REGISTER:
-		Cvar_Register( VMA(1), VMA(2), VMA(3), args[4], cgvm->privateFlag );
+		Cvar_Register( VMA(1), VMA(2), VMA(3), args[4], cgvm->privateFlag, VM_CGAME );
 		return 0;
 	case CG_CVAR_UPDATE:
 		Cvar_Update( VMA(1), cgvm->privateFlag );
@@ -938,7 +945,9 @@ static intptr_t CL_CgameSystemCalls( intptr_t *args ) {
 		{
 			const refdef_t *scene_ref = VMA(1);
 			tc_vis_render();
+			CL_BenchBegin( BENCH_RFRONT );
 			re.RenderScene( scene_ref );
+			CL_BenchEnd( BENCH_RFRONT );
 		}
 		return 0;
 	case CG_R_SAVEVIEWPARMS:
@@ -1210,6 +1219,9 @@ static intptr_t CL_CgameSystemCalls( intptr_t *args ) {
 		cl.cmdMask = CMD_MASK_EXT;
 		return 0;
 
+	case CG_CVAR_CHANGES:
+		return Cvar_ReadChanges( VM_CGAME, VMA(1), args[2] );
+
 	case CG_TRAP_GETVALUE:
 		return CL_CG_GetValue( VMA(1), args[2], VMA(3) );
 
@@ -1402,6 +1414,12 @@ void CL_InitCGame( void ) {
 
 	Com_Printf( "CL_InitCGame: %5.2f seconds\n", (t2-t1)/1000.0 );
 
+	// both the clip model and the renderer have the world now
+	FS_FlushBSP();
+
+	// media for this map is loaded, drop prefetched leftovers
+	Com_PrefetchFinished();
+
 	// have the renderer touch all its images, so they are present
 	// on the card even if the driver does deferred loading
 	re.EndRegistration();
@@ -1451,7 +1469,9 @@ CL_CGameRendering
 =====================
 */
 void CL_CGameRendering( stereoFrame_t stereo ) {
+	CL_BenchBegin( BENCH_CGAME );
 	VM_Call( cgvm, CG_DRAW_ACTIVE_FRAME, cl.serverTime, stereo, clc.demoplaying );
+	CL_BenchEnd( BENCH_CGAME );
 #ifdef _DEBUG
 	VM_Debug( 0 );
 #endif
@@ -106,8 +106,8 @@ void CL_LoadJPG( const char *filename, byte **pic, int *width, int *height )
 	byte *out;
 	int len;
 	union {
-		byte *b;
-		void *v;
+		const byte *b;
+		const void *v;
 	} fbuffer;
 	byte  *buf;
 
@@ -117,7 +117,7 @@ void CL_LoadJPG( const char *filename, byte **pic, int *width, int *height )
 	 * requires it in order to read binary files.
 	*/
 
-	len = FS_ReadFile( ( char * ) filename, &fbuffer.v );
+	len = FS_MapFile( filename, &fbuffer.v );
 	if ( !fbuffer.b || len < 0 ) {
 		return;
 	}
@@ -140,7 +140,7 @@ void CL_LoadJPG( const char *filename, byte **pic, int *width, int *height )
 		* We need to clean up the JPEG object, close the input file, and return.
 		*/
 		jpeg_destroy_decompress( &cinfo );
-		FS_FreeFile( fbuffer.v );
+		FS_UnmapFile( fbuffer.v );
 
 		/* Append the filename to the error for easier debugging */
 		Com_Printf( ", loading file %s\n", filename );
@@ -194,7 +194,7 @@ void CL_LoadJPG( const char *filename, byte **pic, int *width, int *height )
     )
   {
     // Free the memory to make sure we don't leak memory
-    FS_FreeFile( fbuffer.v );
+    FS_UnmapFile( fbuffer.v );
     jpeg_destroy_decompress(&cinfo);
   
     Com_Error( ERR_DROP, "LoadJPG: %s has an invalid image format: %dx%d*4=%d, components: %d", filename,
@@ -259,7 +259,7 @@ void CL_LoadJPG( const char *filename, byte **pic, int *width, int *height )
    * so as to simplify the setjmp error logic above.  (Actually, I don't
    * think that jpeg_destroy can do an error exit, but why assume anything...)
    */
-  FS_FreeFile( fbuffer.v );
+  FS_UnmapFile( fbuffer.v );
 
   /* At this point you may want to check to see whether any corrupt-data
    * warnings occurred (test whether jerr.pub.num_warnings is nonzero).
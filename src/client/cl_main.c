@@ -756,6 +756,8 @@ CL_DemoCompleted
 =================
 */
 static void CL_DemoCompleted( void ) {
+	qboolean benchmark;
+
 	if ( com_timedemo->integer ) {
 		int	time;
 
@@ -772,8 +774,13 @@ static void CL_DemoCompleted( void ) {
 	//	clc.waverecording = qfalse;
 	//}
 
+	// the benchmark queues its next demo itself
+	benchmark = CL_BenchDemoCompleted();
+
 	CL_Disconnect( qtrue );
-	CL_NextDemo();
+	if ( !benchmark ) {
+		CL_NextDemo();
+	}
 }
 
 
@@ -916,6 +923,20 @@ static void CL_CompleteDemoName( char *args, int argNum )
 }
 
 
+/*
+====================
+CL_CompleteBenchmark
+====================
+*/
+static void CL_CompleteBenchmark( char *args, int argNum )
+{
+	if ( argNum >= 2 )
+	{
+		CL_CompleteDemoName( args, 2 );
+	}
+}
+
+
 /*
 ====================
 CL_PlayDemo_f
@@ -3330,6 +3351,8 @@ void CL_Frame( int msec, int realMsec ) {
 		return;
 	}
 
+	CL_BenchFrameBegin();
+
 	// save the msec before checking pause
 	cls.realFrametime = realMsec;
 
@@ -3469,6 +3492,8 @@ void CL_Frame( int msec, int realMsec ) {
 		cls.discordInit = qfalse;
 	}
 #endif
+
+	CL_BenchFrameEnd();
 }
 
 
@@ -3911,6 +3936,8 @@ static void CL_InitRef( void ) {
 	rimp.Error = Com_Error;
 	rimp.Milliseconds = CL_ScaledMilliseconds;
 	rimp.Microseconds = Sys_Microseconds;
+	rimp.Com_ProfileBegin = Com_ProfileBegin;
+	rimp.Com_ProfileEnd = Com_ProfileEnd;
 	rimp.Malloc = CL_RefMalloc;
 	rimp.Free = Z_Free;
 	rimp.Tag_Free = CL_RefTagFree;
@@ -3928,6 +3955,10 @@ static void CL_InitRef( void ) {
 
 	rimp.FS_ReadFile = FS_ReadFile;
 	rimp.FS_FreeFile = FS_FreeFile;
+	rimp.FS_ReadBSP = FS_ReadBSP;
+	rimp.FS_FreeBSP = FS_FreeBSP;
+	rimp.FS_MapFile = FS_MapFile;
+	rimp.FS_UnmapFile = FS_UnmapFile;
 	rimp.FS_WriteFile = FS_WriteFile;
 	rimp.FS_FreeFileList = FS_FreeFileList;
 	rimp.FS_ListFiles = FS_ListFiles;
@@ -4393,6 +4424,7 @@ static void CL_InitGLimp_Cvars( void )
 
 static const cmdListItem_t cl_cmds[] = {
 	{ "addFavorite", CL_AddFavorite_f, NULL },
+	{ "benchmark", CL_Benchmark_f, CL_CompleteBenchmark },
 	{ "cache_endgather", CL_Cache_EndGather_f, NULL },
 	{ "cache_mapchange", CL_Cache_MapChange_f, NULL },
 	{ "cache_setindex", CL_Cache_SetIndex_f, NULL },
@@ -4668,6 +4700,8 @@ void CL_Init( void ) {
 	// ETJump
 	Cvar_Get( "shared", "0", CVAR_SYSTEMINFO | CVAR_ROM );
 
+	CL_BenchInit();
+
 	//
 	// register client commands
 	//
@@ -4729,6 +4763,7 @@ void CL_Shutdown( const char *finalmsg, qboolean quit ) {
 
 	noGameRestart = quit;
 	cl_shutdownQuit = quit;
+	CL_BenchShutdown();
 	CL_Disconnect( qfalse );
 
 	// clear and mute all sounds until next registration
@@ -4762,28 +4797,28 @@ void CL_Shutdown( const char *finalmsg, qboolean quit ) {
 }
 
 
-static void CL_SetServerInfo( serverInfo_t *server, const char *info, int ping ) {
+static void CL_SetServerInfo( serverInfo_t *server, const infoDict_t *info, int ping ) {
 	if ( server ) {
 		if ( info ) {
-			server->clients = atoi( Info_ValueForKey( info, "clients" ) );
-			Q_strncpyz( server->hostName, Info_ValueForKey( info, "hostname" ), sizeof( server->hostName ) );
-			server->load = atoi( Info_ValueForKey( info, "serverload" ) );
-			Q_strncpyz( server->mapName, Info_ValueForKey( info, "mapname" ), sizeof( server->mapName ) );
-			server->maxClients = atoi( Info_ValueForKey( info, "sv_maxclients" ) );
-			Q_strncpyz( server->game, Info_ValueForKey( info, "game" ), sizeof( server->game ) );
-			server->gameType = atoi( Info_ValueForKey( info, "gametype" ) );
-			server->netType = atoi( Info_ValueForKey( info, "nettype" ) );
-			server->minPing = atoi( Info_ValueForKey( info, "minping" ) );
-			server->maxPing = atoi( Info_ValueForKey( info, "maxping" ) );
-			server->friendlyFire = atoi( Info_ValueForKey( info, "friendlyFire" ) );         // NERVE - SMF
-			server->maxlives = atoi( Info_ValueForKey( info, "maxlives" ) );                 // NERVE - SMF
-			server->needpass = atoi( Info_ValueForKey( info, "needpass" ) );                 // NERVE - SMF
-			server->punkbuster = atoi( Info_ValueForKey( info, "punkbuster" ) );             // DHM - Nerve
-			Q_strncpyz( server->gameName, Info_ValueForKey( info, "gamename" ), sizeof( server->gameName ) );   // Arnout
-			server->antilag = atoi( Info_ValueForKey( info, "g_antilag" ) );
-			server->weaprestrict = atoi( Info_ValueForKey( info, "weaprestrict" ) );
-			server->balancedteams = atoi( Info_ValueForKey( info, "balancedteams" ) );
-			server->oss = atoi( Info_ValueForKey( info, "oss" ) );
+			server->clients = atoi( Info_DictValue( info, "clients" ) );
+			Q_strncpyz( server->hostName, Info_DictValue( info, "hostname" ), sizeof( server->hostName ) );
+			server->load = atoi( Info_DictValue( info, "serverload" ) );
+			Q_strncpyz( server->mapName, Info_DictValue( info, "mapname" ), sizeof( server->mapName ) );
+			server->maxClients = atoi( Info_DictValue( info, "sv_maxclients" ) );
+			Q_strncpyz( server->game, Info_DictValue( info, "game" ), sizeof( server->game ) );
+			server->gameType = atoi( Info_DictValue( info, "gametype" ) );
+			server->netType = atoi( Info_DictValue( info, "nettype" ) );
+			server->minPing = atoi( Info_DictValue( info, "minping" ) );
+			server->maxPing = atoi( Info_DictValue( info, "maxping" ) );
+			server->friendlyFire = atoi( Info_DictValue( info, "friendlyFire" ) );         // NERVE - SMF
+			server->maxlives = atoi( Info_DictValue( info, "maxlives" ) );                 // NERVE - SMF
+			server->needpass = atoi( Info_DictValue( info, "needpass" ) );                 // NERVE - SMF
+			server->punkbuster = atoi( Info_DictValue( info, "punkbuster" ) );             // DHM - Nerve
+			Q_strncpyz( server->gameName, Info_DictValue( info, "gamename" ), sizeof( server->gameName ) );   // Arnout
+			server->antilag = atoi( Info_DictValue( info, "g_antilag" ) );
+			server->weaprestrict = atoi( Info_DictValue( info, "weaprestrict" ) );
+			server->balancedteams = atoi( Info_DictValue( info, "balancedteams" ) );
+			server->oss = atoi( Info_DictValue( info, "oss" ) );
 		}
 		server->ping = ping;
 	}
@@ -4791,23 +4826,36 @@ static void CL_SetServerInfo( serverInfo_t *server, const char *info, int ping )
 
 
 static void CL_SetServerInfoByAddress(const netadr_t *from, const char *info, int ping) {
+	static infoDict_t dict;
+	const infoDict_t *parsed;
 	int i;
 
+	// the same info may be stored for several list entries
+	if ( info ) {
+		if ( !Info_DictParse( &dict, info ) ) {
+			Com_DPrintf( "Ignoring oversized info string from %s\n", NET_AdrToString( from ) );
+			return;
+		}
+		parsed = &dict;
+	} else {
+		parsed = NULL;
+	}
+
 	for (i = 0; i < MAX_OTHER_SERVERS; i++) {
 		if (NET_CompareAdr(from, &cls.localServers[i].adr) ) {
-			CL_SetServerInfo(&cls.localServers[i], info, ping);
+			CL_SetServerInfo(&cls.localServers[i], parsed, ping);
 		}
 	}
 
 	for (i = 0; i < MAX_GLOBAL_SERVERS; i++) {
 		if (NET_CompareAdr(from, &cls.globalServers[i].adr)) {
-			CL_SetServerInfo(&cls.globalServers[i], info, ping);
+			CL_SetServerInfo(&cls.globalServers[i], parsed, ping);
 		}
 	}
 
 	for (i = 0; i < MAX_OTHER_SERVERS; i++) {
 		if (NET_CompareAdr(from, &cls.favoriteServers[i].adr)) {
-			CL_SetServerInfo(&cls.favoriteServers[i], info, ping);
+			CL_SetServerInfo(&cls.favoriteServers[i], parsed, ping);
 		}
 	}
 }
@@ -660,11 +660,13 @@ void SCR_UpdateScreen( void ) {
 			SCR_DrawScreenField( STEREO_CENTER );
 		}
 
+		CL_BenchBegin( BENCH_RBACK );
 		if ( com_speeds->integer ) {
 			re.EndFrame( &time_frontend, &time_backend );
 		} else {
 			re.EndFrame( NULL, NULL );
 		}
+		CL_BenchEnd( BENCH_RBACK );
 	}
 
 	recursive = 0;
@@ -879,7 +879,7 @@ static intptr_t CL_UISystemCalls( intptr_t *args ) {
 		return Sys_Milliseconds();
 
 	case UI_CVAR_REGISTER:
-		Cvar_Register( VMA(1), VMA(2), VMA(3), args[4], uivm->privateFlag );
+		Cvar_Register( VMA(1), VMA(2), VMA(3), args[4], uivm->privateFlag, VM_UI );
 		return 0;
 
 	case UI_CVAR_UPDATE:
@@ -910,7 +910,7 @@ static intptr_t CL_UISystemCalls( intptr_t *args ) {
 		return 0;
 
 	case UI_CVAR_CREATE:
-		Cvar_Register( NULL, VMA(1), VMA(2), args[3], uivm->privateFlag );
+		Cvar_Register( NULL, VMA(1), VMA(2), args[3], uivm->privateFlag, VM_UI );
 		return 0;
 
 	case UI_CVAR_INFOSTRINGBUFFER:
@@ -807,6 +807,27 @@ void CL_WriteAVIAudioFrame( const byte *pcmBuffer, int size );
 qboolean CL_CloseAVI( qboolean reopen );
 aviRecordingState_t CL_VideoRecording( void );
 
+//
+// cl_bench.c
+//
+typedef enum {
+	BENCH_FRAME,		// all of CL_Frame
+	BENCH_CLIENT,		// CL_Frame without the sections below
+	BENCH_CGAME,		// CG_DRAW_ACTIVE_FRAME without scene rendering
+	BENCH_RFRONT,		// re.RenderScene
+	BENCH_RBACK,		// re.EndFrame
+	BENCH_NUM_SECTIONS
+} benchSection_t;
+
+void CL_BenchInit( void );
+void CL_BenchShutdown( void );
+void CL_Benchmark_f( void );
+void CL_BenchFrameBegin( void );
+void CL_BenchFrameEnd( void );
+void CL_BenchBegin( benchSection_t section );
+void CL_BenchEnd( benchSection_t section );
+qboolean CL_BenchDemoCompleted( void );
+
 //
 // cl_tc_vis.c
 //
@@ -179,6 +179,19 @@ void *S_CodecLoad( const char *filename, snd_info_t *info )
 }
 
 
+/*
+=================
+S_CodecFree
+
+Releases the image returned by S_CodecLoad
+=================
+*/
+void S_CodecFree( void *data )
+{
+	FS_UnmapFile( data );
+}
+
+
 /*
 =================
 S_CodecOpenStream
@@ -210,47 +210,161 @@ snd_codec_t wav_codec =
 
 /*
 =================
-S_WAV_CodecLoad
+S_BufferLittleLong
 =================
 */
-void *S_WAV_CodecLoad(const char *filename, snd_info_t *info)
+static int S_BufferLittleLong( const byte *p ) {
+	return p[0] | ( p[1] << 8 ) | ( p[2] << 16 ) | ( p[3] << 24 );
+}
+
+/*
+=================
+S_BufferLittleShort
+=================
+*/
+static short S_BufferLittleShort( const byte *p ) {
+	return p[0] | ( p[1] << 8 );
+}
+
+/*
+=================
+S_FindRIFFChunkInBuffer
+
+Same as S_FindRIFFChunk for a file image, advances *ofs
+to the chunk data
+=================
+*/
+static int S_FindRIFFChunkInBuffer( const byte *buf, int length, int *ofs, const char *chunk ) {
+	int		len;
+
+	while( *ofs + 8 <= length )
+	{
+		len = S_BufferLittleLong( buf + *ofs + 4 );
+		if( len < 0 ) {
+			Com_Printf( S_COLOR_YELLOW "WARNING: Negative chunk length\n" );
+			return -1;
+		}
+
+		*ofs += 8;
+
+		// If this is the right chunk, return
+		if( !Q_strncmp( (const char *)buf + *ofs - 8, chunk, 4 ) )
+			return len;
+
+		// Not the right chunk - skip it
+		if( len > length - *ofs )
+			break;
+		*ofs += PAD( len, 2 );
+	}
+
+	return -1;
+}
+
+/*
+=================
+S_ParseRIFFHeader
+
+Same as S_ReadRIFFHeader for a file image, the samples
+start info->dataofs bytes into the image
+=================
+*/
+static qboolean S_ParseRIFFHeader( const byte *buf, int length, snd_info_t *info )
 {
-	fileHandle_t file;
-	void *buffer;
+	int bits;
+	int fmtlen;
+	int ofs;
 
-	// Try to open the file
-	FS_FOpenFileRead(filename, &file, qtrue);
-	if ( file == FS_INVALID_HANDLE )
+	// skip the riff wav header
+	ofs = 12;
+
+	// Scan for the format chunk
+	if((fmtlen = S_FindRIFFChunkInBuffer(buf, length, &ofs, "fmt ")) < 16 || fmtlen > length - ofs)
 	{
-		return NULL;
+		Com_Printf( S_COLOR_RED "ERROR: Couldn't find \"fmt\" chunk\n");
+		return qfalse;
 	}
 
-	// Read the RIFF header
-	if(!S_ReadRIFFHeader(file, info))
+	// Save the parameters
+	info->channels = S_BufferLittleShort( buf + ofs + 2 );
+	info->rate = S_BufferLittleLong( buf + ofs + 4 );
+	bits = S_BufferLittleShort( buf + ofs + 14 );
+
+	if( bits < 8 )
+	{
+	  Com_Printf( S_COLOR_RED "ERROR: Less than 8 bit sound is not supported\n");
+	  return qfalse;
+	}
+
+	if( info->channels <= 0 )
+	{
+	  Com_Printf( S_COLOR_RED "ERROR: Bad channel count\n");
+	  return qfalse;
+	}
+
+	info->width = bits / 8;
+
+	// Skip the rest of the format chunk
+	ofs += PAD( fmtlen, 2 );
+
+	// Scan for the data chunk
+	if( (info->size = S_FindRIFFChunkInBuffer(buf, length, &ofs, "data")) < 0)
+	{
+		Com_Printf( S_COLOR_RED "ERROR: Couldn't find \"data\" chunk\n");
+		return qfalse;
+	}
+
+	// truncated files play what is there
+	if( info->size > length - ofs )
+		info->size = length - ofs;
+
+	info->dataofs = ofs;
+	info->samples = (info->size / info->width) / info->channels;
+
+	return qtrue;
+}
+
+/*
+=================
+S_WAV_CodecLoad
+
+Returns the whole file image, mapped straight from disk when the samples
+don't need byteswapping. The samples start info->dataofs bytes in
+=================
+*/
+void *S_WAV_CodecLoad(const char *filename, snd_info_t *info)
+{
+	union {
+		byte *b;
+		void *v;
+		const void *cv;
+	} buffer;
+	int length;
+
+#ifdef Q3_BIG_ENDIAN
+	// samples get byteswapped in place
+	length = FS_ReadFile(filename, &buffer.v);
+#else
+	length = FS_MapFile(filename, &buffer.cv);
+#endif
+	if ( !buffer.v || length < 0 )
 	{
-		FS_FCloseFile(file);
-		Com_Printf( S_COLOR_RED "ERROR: Incorrect/unsupported format in \"%s\"\n",
-				filename);
 		return NULL;
 	}
 
-	// Allocate some memory
-	buffer = Hunk_AllocateTempMemory(info->size);
-	if(!buffer)
+	// Parse the RIFF header
+	if(length < 12 || !S_ParseRIFFHeader(buffer.b, length, info))
 	{
-		FS_FCloseFile(file);
-		Com_Printf( S_COLOR_RED "ERROR: Out of memory reading \"%s\"\n",
+		FS_UnmapFile(buffer.v);
+		Com_Printf( S_COLOR_RED "ERROR: Incorrect/unsupported format in \"%s\"\n",
 				filename);
 		return NULL;
 	}
 
-	// Read, byteswap
-	FS_Read(buffer, info->size, file);
-	S_ByteSwapRawSamples(info->samples, info->width, info->channels, (byte *)buffer);
+#ifdef Q3_BIG_ENDIAN
+	S_ByteSwapRawSamples(info->samples, info->width, info->channels, buffer.b + info->dataofs);
+#endif
 
-	// Close and return
-	FS_FCloseFile(file);
-	return buffer;
+	return buffer.v;
 }
 
 /*
@@ -321,7 +321,9 @@ void S_Update( int msec )
 	}*/
 	
 	if( si.Update ) {
+		PROFILE_BEGIN( "S_Update" );
 		si.Update( msec );
+		PROFILE_END();
 	}
 }
 
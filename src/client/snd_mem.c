@@ -337,7 +337,7 @@ qboolean S_LoadSound( sfx_t *sfx )
 	sfx->soundChannels = info.channels;
 	
 	Hunk_FreeTempMemory(samples);
-	Hunk_FreeTempMemory(data);
+	S_CodecFree(data);
 
 	return qtrue;
 }
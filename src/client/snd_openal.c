@@ -385,7 +385,7 @@ static void S_AL_BufferLoad(sfxHandle_t sfx, qboolean cache)
 	if (!cache)
 	{
 		// Don't create AL cache
-		Hunk_FreeTempMemory(data);
+		S_CodecFree(data);
 		return;
 	}
 
@@ -395,7 +395,7 @@ static void S_AL_BufferLoad(sfxHandle_t sfx, qboolean cache)
 	if (!S_AL_GenBuffers(1, &curSfx->buffer, curSfx->filename))
 	{
 		S_AL_BufferUseDefault(sfx);
-		Hunk_FreeTempMemory(data);
+		S_CodecFree(data);
 		return;
 	}
 
@@ -408,7 +408,7 @@ static void S_AL_BufferLoad(sfxHandle_t sfx, qboolean cache)
 		qalBufferData(curSfx->buffer, AL_FORMAT_MONO16, (void *)dummyData, 2, 22050);
 	}
 	else
-		qalBufferData(curSfx->buffer, format, data, info.size, info.rate);
+		qalBufferData(curSfx->buffer, format, (byte *)data + info.dataofs, info.size, info.rate);
 
 	error = qalGetError();
 
@@ -419,13 +419,13 @@ static void S_AL_BufferLoad(sfxHandle_t sfx, qboolean cache)
 		{
 			qalDeleteBuffers(1, &curSfx->buffer);
 			S_AL_BufferUseDefault(sfx);
-			Hunk_FreeTempMemory(data);
+			S_CodecFree(data);
 			Com_Printf( S_COLOR_RED "ERROR: Out of memory loading %s\n", curSfx->filename);
 			return;
 		}
 
 		// Try load it again
-		qalBufferData(curSfx->buffer, format, data, info.size, info.rate);
+		qalBufferData(curSfx->buffer, format, (byte *)data + info.dataofs, info.size, info.rate);
 		error = qalGetError();
 	}
 
@@ -434,7 +434,7 @@ static void S_AL_BufferLoad(sfxHandle_t sfx, qboolean cache)
 	{
 		qalDeleteBuffers(1, &curSfx->buffer);
 		S_AL_BufferUseDefault(sfx);
-		Hunk_FreeTempMemory(data);
+		S_CodecFree(data);
 		Com_Printf( S_COLOR_RED "ERROR: Can't fill sound buffer for %s - %s\n",
 				curSfx->filename, S_AL_ErrorMsg(error));
 		return;
@@ -443,7 +443,7 @@ static void S_AL_BufferLoad(sfxHandle_t sfx, qboolean cache)
 	curSfx->info = info;
 	
 	// Free the memory
-	Hunk_FreeTempMemory(data);
+	S_CodecFree(data);
 
 	// Woo!
 	curSfx->inMemory = qtrue;
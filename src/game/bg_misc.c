@@ -5094,12 +5094,43 @@ void G_BroadcastServerCommand( int ignoreClient, const char *command );
 #endif
 void trap_Cvar_Update( vmCvar_t *cvar );
 
+// cvar handles the engine reported as changed, -1 when unknown
+static const int *bgCvarChanges;
+static int bgNumCvarChanges = -1;
+
+/*
+================
+BG_CvarSetChanges
+
+Limits BG_CvarUpdateTable to the given cvar handles,
+numHandles -1 goes back to updating every cvar
+================
+*/
+void BG_CvarSetChanges( const int *handles, int numHandles ) {
+	bgCvarChanges = handles;
+	bgNumCvarChanges = handles ? numHandles : -1;
+}
+
+static qboolean BG_CvarChanged( const vmCvar_t *cvar ) {
+	int i;
+
+	if ( bgNumCvarChanges < 0 )
+		return qtrue;
+
+	for( i = 0; i < bgNumCvarChanges; i++ ) {
+		if ( bgCvarChanges[i] == cvar->handle )
+			return qtrue;
+	}
+
+	return qfalse;
+}
+
 int BG_CvarUpdateTable( const vmCvarTableItem_t *cvars, int count ) {
 	int i, updated = 0;
 	for( i = 0; i < count; i++ ) {
 		const vmCvarTableItem_t *item = &cvars[i];
 		int modCount;
-		if ( !item->cvar )
+		if ( !item->cvar || !BG_CvarChanged( item->cvar ) )
 			continue;
 		modCount = item->cvar->modificationCount;
 		trap_Cvar_Update( item->cvar );
@@ -2336,4 +2336,7 @@ void BG_CvarRegisterTable( const vmCvarTableItem_t *cvars, int count );
 int BG_CvarUpdateTable( const vmCvarTableItem_t *cvars, int count );
 #define BG_CvarUpdateArray( a ) BG_CvarUpdateTable( a, ARRAY_LEN(a) )
 
+#define MAX_CVAR_CHANGES 64
+void BG_CvarSetChanges( const int *handles, int numHandles );
+
 #endif
@@ -1274,6 +1274,7 @@ qboolean ClientUserinfoChanged( int clientNum ) {
 	const char    *s;
 	char oldname[MAX_NETNAME];
 	char userinfo[MAX_INFO_STRING];
+	static infoDict_t dict;
 	gclient_t   *client;
 	int i;
 	char skillStr[16] = "";
@@ -1314,8 +1315,15 @@ qboolean ClientUserinfoChanged( int clientNum ) {
 		G_Printf( "Userinfo: %s\n", userinfo );
 	}
 
+	if ( !Info_DictParse( &dict, userinfo ) ) {
+		G_Printf( "Client %i Userinfo: too many keys\n", clientNum );
+		Q_strncpyz( ban_reason, "bad userinfo", sizeof( ban_reason ) );
+		trap_DropClient( clientNum, ban_reason, 0 );
+		return qfalse;
+	}
+
 	// check for local client
-	s = Info_ValueForKey( userinfo, "ip" );
+	s = Info_DictValue( &dict, "ip" );
 	if ( s && !strcmp( s, "localhost" ) ) {
 		client->pers.localClient = qtrue;
 		level.fLocalHost = qtrue;
@@ -1330,7 +1338,7 @@ qboolean ClientUserinfoChanged( int clientNum ) {
 		client->pmext.bAutoReload = qtrue;
 		client->pers.predictItemPickup = qfalse;
 	} else {
-		s = Info_ValueForKey( userinfo, "cg_uinfo" );
+		s = Info_DictValue( &dict, "cg_uinfo" );
 		sscanf( s, "%i %i %i",
 				&client->pers.clientFlags,
 				&client->pers.clientTimeNudge,
@@ -1350,7 +1358,7 @@ qboolean ClientUserinfoChanged( int clientNum ) {
 
 	// set name
 	Q_strncpyz( oldname, client->pers.netname, sizeof( oldname ) );
-	s = Info_ValueForKey( userinfo, "name" );
+	s = Info_DictValue( &dict, "name" );
 	BG_CleanName( s, client->pers.netname, sizeof( client->pers.netname ), "ETPlayer" );
 
 	if ( client->pers.connected == CON_CONNECTED ) {
@@ -1369,7 +1377,7 @@ qboolean ClientUserinfoChanged( int clientNum ) {
 	client->ps.stats[STAT_MAX_HEALTH] = client->pers.maxHealth;
 
 	// check for custom character
-	s = Info_ValueForKey( userinfo, "ch" );
+	s = Info_DictValue( &dict, "ch" );
 	if ( *s ) {
 		characterIndex = atoi( s );
 	} else {
@@ -1399,7 +1407,7 @@ qboolean ClientUserinfoChanged( int clientNum ) {
 		s = va( "n\\%s\\t\\%i\\skill\\%s\\c\\%i\\r\\%i\\m\\%s\\s\\%s%s\\dn\\%s\\dr\\%i\\w\\%i\\lw\\%i\\sw\\%i\\mu\\%i",
 				client->pers.netname,
 				client->sess.sessionTeam,
-				Info_ValueForKey( userinfo, "skill" ),
+				Info_DictValue( &dict, "skill" ),
 				client->sess.playerType,
 				client->sess.rank,
 				medalStr,
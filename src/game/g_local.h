@@ -2136,11 +2136,17 @@ qboolean G_LandmineSnapshotCallback( int entityNum, int clientNum );
 // extension interface
 extern	qboolean addCommand;
 extern	qboolean removeCommand;
+extern	qboolean cvarChanges;
+extern	qboolean asyncLog;
 extern	qboolean engine_is_ete;
 
 qboolean trap_GetValue( char *value, int valueSize, const char *key );
 void trap_SV_AddCommand( const char *cmdName );
 void trap_SV_RemoveCommand( const char *cmdName );
+int trap_Cvar_Changes( int *handles, int maxHandles );
+qboolean trap_FS_AsyncLog( fileHandle_t f );
 extern int dll_com_trapGetValue;
 extern int dll_trap_SV_AddCommand;
 extern int dll_trap_SV_RemoveCommand;
+extern int dll_trap_Cvar_Changes;
+extern int dll_trap_FS_AsyncLog;
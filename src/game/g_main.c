@@ -630,6 +630,8 @@ void CheckExitRules( void );
 
 qboolean addCommand;
 qboolean removeCommand;
+qboolean cvarChanges;
+qboolean asyncLog;
 qboolean engine_is_ete = qfalse;
 
 qboolean G_SnapshotCallback( int entityNum, int clientNum ) {
@@ -648,6 +650,8 @@ qboolean G_SnapshotCallback( int entityNum, int clientNum ) {
 int dll_com_trapGetValue;
 int dll_trap_SV_AddCommand;
 int dll_trap_SV_RemoveCommand;
+int dll_trap_Cvar_Changes;
+int dll_trap_FS_AsyncLog;
 
 /*
 ================
@@ -1432,15 +1436,28 @@ G_UpdateCvars
 =================
 */
 void G_UpdateCvars( void ) {
+	int changes[MAX_CVAR_CHANGES];
+	int numChanges;
 	qboolean fToggles = qfalse;
 	qboolean fVoteFlags = qfalse;
 	qboolean chargetimechanged = qfalse;
 
+	// only look at the cvars the engine reports as changed
+	if ( cvarChanges ) {
+		numChanges = trap_Cvar_Changes( changes, ARRAY_LEN( changes ) );
+		if ( numChanges == 0 ) {
+			return;
+		}
+		BG_CvarSetChanges( changes, numChanges );
+	}
+
 	BG_CvarUpdateArray( game_cvars );
 	chargetimechanged = BG_CvarUpdateArray( chargetime_cvars ) > 0 ? qtrue : qfalse;
 	fVoteFlags = BG_CvarUpdateArray( vote_allow_cvars ) > 0 ? qtrue : qfalse;
 	fToggles = BG_CvarUpdateArray( server_toggle_cvars ) > 0 ? qtrue : qfalse;
 
+	BG_CvarSetChanges( NULL, -1 );
+
 	if ( fVoteFlags ) {
 		G_voteFlags();
 	}
@@ -1622,6 +1639,14 @@ void G_InitGame( int levelTime, int randomSeed, int restart ) {
 			dll_trap_SV_RemoveCommand = atoi( value );
 			removeCommand = qtrue;
 		}
+		if ( trap_GetValue( value, sizeof( value ), "trap_Cvar_Changes_ETE" ) ) {
+			dll_trap_Cvar_Changes = atoi( value );
+			cvarChanges = qtrue;
+		}
+		if ( trap_GetValue( value, sizeof( value ), "trap_FS_AsyncLog_ETE" ) ) {
+			dll_trap_FS_AsyncLog = atoi( value );
+			asyncLog = qtrue;
+		}
 	}
 
 	srand( randomSeed );
@@ -1780,6 +1805,10 @@ void G_InitGame( int levelTime, int randomSeed, int restart ) {
 		if ( !level.logFile ) {
 			G_Printf( "WARNING: Couldn't open logfile: %s\n", g_logFile.string );
 		} else {
+			// a line for every kill and chat, let the engine write it in the background
+			if ( asyncLog ) {
+				trap_FS_AsyncLog( level.logFile );
+			}
 			G_LogPrintf( "------------------------------------------------------------\n" );
 			G_LogPrintf( "InitGame: %s\n", cs );
 		}
@@ -2413,7 +2442,6 @@ void BeginIntermission( void ) {
 
 	// send the current scoring to all clients
 	SendScoreboardMessageToAllClients();
-
 }
 
 
@@ -476,6 +476,8 @@ typedef enum {
 	// engine extensions
 	G_ADDCOMMAND,
 	G_REMOVECOMMAND,
+	G_CVAR_CHANGES,	// ( int *handles, int maxHandles );
+	G_FS_ASYNC_LOG,	// ( fileHandle_t f );
 	G_TRAP_GETVALUE = COM_TRAP_GETVALUE
 #endif
 
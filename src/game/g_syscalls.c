@@ -384,4 +384,12 @@ void trap_SV_AddCommand( const char *cmdName ) {
 
 void trap_SV_RemoveCommand( const char *cmdName ) {
 	SystemCall( dll_trap_SV_RemoveCommand, cmdName );
+}
+
+int trap_Cvar_Changes( int *handles, int maxHandles ) {
+	return SystemCall( dll_trap_Cvar_Changes, handles, maxHandles );
+}
+
+qboolean trap_FS_AsyncLog( fileHandle_t f ) {
+	return SystemCall( dll_trap_FS_AsyncLog, f );
 }
\ No newline at end of file
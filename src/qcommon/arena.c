@@ -0,0 +1,370 @@
+/*
+===========================================================================
+
+Wolfenstein: Enemy Territory GPL Source Code
+Copyright (C) 1999-2010 id Software LLC, a ZeniMax Media company.
+
+This file is part of the Wolfenstein: Enemy Territory GPL Source Code (Wolf ET Source Code).
+
+Wolf ET Source Code is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Wolf ET Source Code is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Wolf ET Source Code.  If not, see <http://www.gnu.org/licenses/>.
+
+In addition, the Wolf: ET Source Code is also subject to certain additional terms. You should have received a copy of these additional terms immediately following the terms and conditions of the GNU General Public License which accompanied the Wolf ET Source Code.  If not, please request a copy in writing from id Software at the address below.
+
+If you have questions concerning this license or the applicable additional terms, you may contact in writing id Software LLC, c/o ZeniMax Media Inc., Suite 120, Rockville, Maryland 20850 USA.
+
+===========================================================================
+*/
+
+// arena.c -- bump allocators for worker threads
+//
+// Z_Malloc and the hunk are main thread only.  Worker jobs allocate from
+// memArena_t blocks taken straight from malloc instead: an arena belongs
+// to one thread at a time, so allocating needs no locks, and scoped
+// frames are released in one step with Arena_Mark / Arena_Release.
+// Every thread also has an implicit temp stack (Com_ThreadTempAlloc)
+// for short lived scratch memory.
+//
+// Results go back to the main thread in an arena given away with
+// Arena_Handoff, the pk3 scan workers hand over their central directories
+// this way.
+
+#include "q_shared.h"
+#include "qcommon.h"
+
+#define ARENA_ALIGN			16
+#define ARENA_HEADER		PAD( sizeof( arenaBlock_t ), ARENA_ALIGN )
+#define ARENA_DATA( b )		( (byte *)(b) + ARENA_HEADER )
+
+#define THREAD_TEMP_BLOCK	( 256 * 1024 )
+
+typedef struct arenaBlock_s {
+	struct arenaBlock_s	*prev;
+	int					size;		// usable bytes after the header
+	int					used;
+} arenaBlock_t;
+
+struct memArena_s {
+	arenaBlock_t	*block;			// current block, older ones chained through prev
+	arenaBlock_t	*spare;			// released block kept for the next frame
+	int				blockSize;
+	const void		*owner;			// thread using the arena, NULL after a handoff
+};
+
+// the address of a thread local variable identifies the calling thread
+static Q_THREADLOCAL byte		com_threadTag;
+static Q_THREADLOCAL memArena_t	*com_threadTemp;
+
+static const void		*com_mainThread;
+
+#define THREAD_ID	( (const void *)&com_threadTag )
+
+
+/*
+================
+Com_InitThreadMemory
+
+Called first thing by Com_Init, on the main thread
+================
+*/
+void Com_InitThreadMemory( void ) {
+	com_mainThread = THREAD_ID;
+}
+
+
+/*
+================
+Com_IsMainThread
+
+Everything runs on the main thread until Com_Init has started
+================
+*/
+qboolean Com_IsMainThread( void ) {
+	return ( !com_mainThread || com_mainThread == THREAD_ID ) ? qtrue : qfalse;
+}
+
+
+/*
+==============================================================
+
+ARENAS
+
+Arena functions are reentrant, but an arena itself must only be used by
+one thread at a time.
+
+==============================================================
+*/
+
+/*
+================
+Arena_Claim
+
+Debug check for arenas shared without a handoff
+================
+*/
+static void Arena_Claim( memArena_t *arena ) {
+	if ( !arena->owner ) {
+		arena->owner = THREAD_ID;
+	}
+	assert( arena->owner == THREAD_ID && "memArena_t used by two threads" );
+}
+
+
+/*
+================
+Arena_Create
+
+Returns NULL on failure, blockSize 0 selects the default
+================
+*/
+memArena_t *Arena_Create( int blockSize ) {
+	memArena_t *arena;
+
+	arena = malloc( sizeof( *arena ) );
+	if ( !arena ) {
+		return NULL;
+	}
+
+	arena->block = NULL;
+	arena->spare = NULL;
+	arena->blockSize = PAD( blockSize > 0 ? blockSize : ARENA_DEFAULT_BLOCK, ARENA_ALIGN );
+	arena->owner = THREAD_ID;
+
+	return arena;
+}
+
+
+/*
+================
+Arena_FreeBlock
+
+Keeps one released block of the regular size around, so a frame that
+is reset every iteration stops calling malloc after the first one.
+Oversized blocks always go back to the system.
+================
+*/
+static void Arena_FreeBlock( memArena_t *arena, arenaBlock_t *block ) {
+	if ( arena->spare || block->size != arena->blockSize ) {
+		free( block );
+		return;
+	}
+
+	arena->spare = block;
+}
+
+
+/*
+================
+Arena_Alloc
+
+16 byte aligned, not cleared, NULL when malloc fails
+================
+*/
+void *Arena_Alloc( memArena_t *arena, int size ) {
+	arenaBlock_t	*block;
+	int				blockSize;
+	void			*buf;
+
+	Arena_Claim( arena );
+
+	if ( size < 0 ) {
+		return NULL;
+	}
+
+	size = PAD( size, ARENA_ALIGN );
+
+	block = arena->block;
+	if ( !block || block->size - block->used < size ) {
+		blockSize = MAX( arena->blockSize, size );
+
+		if ( arena->spare && blockSize == arena->blockSize ) {
+			block = arena->spare;
+			arena->spare = NULL;
+		} else {
+			block = malloc( ARENA_HEADER + blockSize );
+			if ( !block ) {
+				return NULL;
+			}
+			block->size = blockSize;
+		}
+
+		block->used = 0;
+		block->prev = arena->block;
+		arena->block = block;
+	}
+
+	buf = ARENA_DATA( block ) + block->used;
+	block->used += size;
+
+	return buf;
+}
+
+
+/*
+================
+Arena_Mark
+================
+*/
+arenaMark_t Arena_Mark( memArena_t *arena ) {
+	arenaMark_t mark;
+
+	Arena_Claim( arena );
+
+	mark.block = arena->block;
+	mark.used = arena->block ? arena->block->used : 0;
+
+	return mark;
+}
+
+
+/*
+================
+Arena_Release
+
+Frees everything allocated since the mark was taken
+================
+*/
+void Arena_Release( memArena_t *arena, arenaMark_t mark ) {
+	arenaBlock_t *block;
+
+	Arena_Claim( arena );
+
+	while ( arena->block != mark.block ) {
+		block = arena->block;
+		assert( block && "Arena_Release: mark is not from this arena" );
+		arena->block = block->prev;
+		Arena_FreeBlock( arena, block );
+	}
+
+	if ( arena->block ) {
+		arena->block->used = mark.used;
+	}
+}
+
+
+/*
+================
+Arena_Reset
+================
+*/
+void Arena_Reset( memArena_t *arena ) {
+	arenaMark_t mark;
+
+	mark.block = NULL;
+	mark.used = 0;
+
+	Arena_Release( arena, mark );
+}
+
+
+/*
+================
+Arena_Destroy
+================
+*/
+void Arena_Destroy( memArena_t *arena ) {
+	if ( !arena ) {
+		return;
+	}
+
+	Arena_Reset( arena );
+	free( arena->spare );
+	free( arena );
+}
+
+
+/*
+================
+Arena_Handoff
+
+Gives up ownership before the arena is published to another thread,
+which then owns it from its first arena call. The publishing itself
+must go through a mutex or a thread join.
+================
+*/
+void Arena_Handoff( memArena_t *arena ) {
+	Arena_Claim( arena );
+	arena->owner = NULL;
+}
+
+
+/*
+==============================================================
+
+THREAD TEMP STACK
+
+==============================================================
+*/
+
+/*
+================
+Com_ThreadTempAlloc
+
+Scratch memory of the calling thread, freed by the enclosing
+Com_ThreadTempRelease. NULL when malloc fails.
+================
+*/
+void *Com_ThreadTempAlloc( int size ) {
+	if ( !com_threadTemp ) {
+		com_threadTemp = Arena_Create( THREAD_TEMP_BLOCK );
+		if ( !com_threadTemp ) {
+			return NULL;
+		}
+	}
+
+	return Arena_Alloc( com_threadTemp, size );
+}
+
+
+/*
+================
+Com_ThreadTempMark
+================
+*/
+arenaMark_t Com_ThreadTempMark( void ) {
+	arenaMark_t mark;
+
+	if ( com_threadTemp ) {
+		return Arena_Mark( com_threadTemp );
+	}
+
+	mark.block = NULL;
+	mark.used = 0;
+
+	return mark;
+}
+
+
+/*
+================
+Com_ThreadTempRelease
+================
+*/
+void Com_ThreadTempRelease( arenaMark_t mark ) {
+	if ( com_threadTemp ) {
+		Arena_Release( com_threadTemp, mark );
+	}
+}
+
+
+/*
+================
+Com_FreeThreadMemory
+
+Called by the Sys_CreateThread trampoline when the thread function returns
+================
+*/
+void Com_FreeThreadMemory( void ) {
+	Arena_Destroy( com_threadTemp );
+	com_threadTemp = NULL;
+}
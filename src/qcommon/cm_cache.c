@@ -0,0 +1,309 @@
+/*
+===========================================================================
+
+Wolfenstein: Enemy Territory GPL Source Code
+Copyright (C) 1999-2010 id Software LLC, a ZeniMax Media company.
+
+This file is part of the Wolfenstein: Enemy Territory GPL Source Code (Wolf ET Source Code).
+
+Wolf ET Source Code is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Wolf ET Source Code is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Wolf ET Source Code.  If not, see <http://www.gnu.org/licenses/>.
+
+In addition, the Wolf: ET Source Code is also subject to certain additional terms. You should have received a copy of these additional terms immediately following the terms and conditions of the GNU General Public License which accompanied the Wolf ET Source Code.  If not, please request a copy in writing from id Software at the address below.
+
+If you have questions concerning this license or the applicable additional terms, you may contact in writing id Software LLC, c/o ZeniMax Media Inc., Suite 120, Rockville, Maryland 20850 USA.
+
+===========================================================================
+*/
+
+// cm_cache.c -- keeps the generated patch collision data of the last loaded
+// map on disk, so loading it again doesn't have to subdivide the curves
+
+#include "cm_local.h"
+#include "cm_patch.h"
+
+#define PATCH_CACHE_IDENT	(('C'<<24)+('M'<<16)+('C'<<8)+'P')	// "PCMC", wrong order on other endianess
+#define PATCH_CACHE_VERSION	1		// bump when the layout or the generated data changes
+
+// facets are stored up to the runtime data
+#define FACET_CACHE_SIZE	( offsetof( facet_t, borders ) )
+
+typedef struct {
+	int			ident;
+	int			version;
+	int			checksum;			// of the whole bsp
+	int			vanilla;			// generated with the vanilla patch plane optimization
+	int			numSurfaces;
+	int			numPatches;
+	int			length;				// of the whole file
+	int			dataChecksum;		// of everything after the header
+} patchCacheHeader_t;
+
+typedef struct {
+	int			surfaceNum;
+	vec3_t		bounds[2];
+	int			numPlanes;
+	int			numFacets;
+	// followed by numPlanes patchPlane_t and numFacets FACET_CACHE_SIZE facets
+} patchCacheRecord_t;
+
+static struct {
+	byte		*buffer;
+	const byte	*cursor;
+	const byte	*end;
+	char		name[MAX_QPATH];
+	qboolean	rewrite;			// some patches were generated
+} patchCache;
+
+
+/*
+==================
+CM_PatchCacheName
+==================
+*/
+static void CM_PatchCacheName( const char *mapname, char *name, int size ) {
+	char base[MAX_QPATH];
+
+	COM_StripExtension( COM_SkipPath( (char *)mapname ), base, sizeof( base ) );
+	Com_sprintf( name, size, "cmcache/%s.cmc", base );
+}
+
+
+/*
+==================
+CM_OpenPatchCache
+
+Reads the cache of the map that is being loaded, a cache of another
+version of the map, or one made with other settings, is ignored and
+replaced once the map is loaded
+==================
+*/
+void CM_OpenPatchCache( const char *mapname ) {
+	patchCacheHeader_t	*header;
+	fileHandle_t		f;
+	int					length;
+
+	Com_Memset( &patchCache, 0, sizeof( patchCache ) );
+
+	if ( !cm_patchCache->integer ) {
+		return;
+	}
+
+	CM_PatchCacheName( mapname, patchCache.name, sizeof( patchCache.name ) );
+	patchCache.rewrite = qtrue;
+
+	length = FS_Home_FOpenFileRead( patchCache.name, &f );
+	if ( f == FS_INVALID_HANDLE ) {
+		return;
+	}
+
+	if ( length < (int)sizeof( *header ) ) {
+		FS_FCloseFile( f );
+		return;
+	}
+
+	patchCache.buffer = Hunk_AllocateTempMemory( length );
+	if ( FS_Read( patchCache.buffer, length, f ) != length ) {
+		FS_FCloseFile( f );
+		Hunk_FreeTempMemory( patchCache.buffer );
+		patchCache.buffer = NULL;
+		return;
+	}
+	FS_FCloseFile( f );
+
+	header = (patchCacheHeader_t *)patchCache.buffer;
+	if ( header->ident != PATCH_CACHE_IDENT || header->version != PATCH_CACHE_VERSION
+		|| header->checksum != cm.checksum || header->vanilla != CM_UseVanillaOptimization()
+		|| header->numSurfaces != cm.numSurfaces || header->length != length
+		|| header->dataChecksum != (int)Com_BlockChecksum( header + 1, length - sizeof( *header ) ) ) {
+		Com_DPrintf( "%s is out of date\n", patchCache.name );
+		Hunk_FreeTempMemory( patchCache.buffer );
+		patchCache.buffer = NULL;
+		return;
+	}
+
+	patchCache.cursor = patchCache.buffer + sizeof( *header );
+	patchCache.end = patchCache.buffer + length;
+	patchCache.rewrite = qfalse;
+}
+
+
+/*
+==================
+CM_CachedPatchCollide
+
+Returns the cached patch collision data for surfaceNum, surfaces must
+be asked for in order. NULL if it has to be generated.
+==================
+*/
+struct patchCollide_s *CM_CachedPatchCollide( int surfaceNum ) {
+	const patchCacheRecord_t	*record;
+	const facet_t				*facet;
+	patchCollide_t				*pc;
+	const byte					*data;
+	int							i, j, length;
+
+	if ( !patchCache.cursor ) {
+		patchCache.rewrite = qtrue;
+		return NULL;
+	}
+
+	record = (const patchCacheRecord_t *)patchCache.cursor;
+	if ( patchCache.end - patchCache.cursor < (int)sizeof( *record ) || record->surfaceNum != surfaceNum
+		|| record->numPlanes < 0 || record->numPlanes > MAX_PATCH_PLANES
+		|| record->numFacets < 0 || record->numFacets > MAX_FACETS ) {
+		goto invalid;
+	}
+
+	data = patchCache.cursor + sizeof( *record );
+	length = record->numPlanes * sizeof( patchPlane_t ) + record->numFacets * FACET_CACHE_SIZE;
+	if ( patchCache.end - data < length ) {
+		goto invalid;
+	}
+
+	pc = Hunk_Alloc( sizeof( *pc ), h_high );
+	VectorCopy( record->bounds[0], pc->bounds[0] );
+	VectorCopy( record->bounds[1], pc->bounds[1] );
+
+	pc->numPlanes = record->numPlanes;
+	pc->planes = Hunk_Alloc( pc->numPlanes * sizeof( *pc->planes ), h_high );
+	Com_Memcpy( pc->planes, data, pc->numPlanes * sizeof( *pc->planes ) );
+	data += pc->numPlanes * sizeof( *pc->planes );
+
+	pc->numFacets = record->numFacets;
+	pc->facets = Hunk_Alloc( pc->numFacets * sizeof( *pc->facets ), h_high );
+	for ( i = 0; i < pc->numFacets; i++, data += FACET_CACHE_SIZE ) {
+		Com_Memcpy( &pc->facets[i], data, FACET_CACHE_SIZE );
+
+		// never trust plane numbers read from disk
+		facet = &pc->facets[i];
+		if ( facet->surfacePlane < 0 || facet->surfacePlane >= pc->numPlanes
+			|| facet->numBorders < 0 || facet->numBorders > ARRAY_LEN( facet->borderPlanes ) ) {
+			goto invalid;
+		}
+		for ( j = 0; j < facet->numBorders; j++ ) {
+			if ( facet->borderPlanes[j] < 0 || facet->borderPlanes[j] >= pc->numPlanes ) {
+				goto invalid;
+			}
+		}
+	}
+
+#ifdef CM_SIMD
+	CM_SetFacetBorders( pc );
+#endif
+
+	patchCache.cursor = data;
+
+	return pc;
+
+invalid:
+	// the hunk space of a partly read patch is lost until the next map, like on any other load error
+	Com_DPrintf( S_COLOR_YELLOW "%s: bad record for surface %i\n", patchCache.name, surfaceNum );
+	patchCache.cursor = NULL;
+	patchCache.rewrite = qtrue;
+	return NULL;
+}
+
+
+/*
+==================
+CM_WritePatchCache
+==================
+*/
+static void CM_WritePatchCache( void ) {
+	patchCacheHeader_t	*header;
+	patchCacheRecord_t	*record;
+	const patchCollide_t *pc;
+	fileHandle_t		f;
+	byte				*buffer, *data;
+	int					i, j, length;
+
+	length = sizeof( *header );
+	for ( i = 0; i < cm.numSurfaces; i++ ) {
+		if ( cm.surfaces[i] && cm.surfaces[i]->pc ) {
+			pc = cm.surfaces[i]->pc;
+			length += sizeof( *record ) + pc->numPlanes * sizeof( patchPlane_t ) + pc->numFacets * FACET_CACHE_SIZE;
+		}
+	}
+
+	buffer = Hunk_AllocateTempMemory( length );
+
+	header = (patchCacheHeader_t *)buffer;
+	header->ident = PATCH_CACHE_IDENT;
+	header->version = PATCH_CACHE_VERSION;
+	header->checksum = cm.checksum;
+	header->vanilla = CM_UseVanillaOptimization();
+	header->numSurfaces = cm.numSurfaces;
+	header->numPatches = 0;
+	header->length = length;
+
+	data = buffer + sizeof( *header );
+	for ( i = 0; i < cm.numSurfaces; i++ ) {
+		if ( !cm.surfaces[i] || !cm.surfaces[i]->pc ) {
+			continue;
+		}
+		pc = cm.surfaces[i]->pc;
+
+		record = (patchCacheRecord_t *)data;
+		record->surfaceNum = i;
+		VectorCopy( pc->bounds[0], record->bounds[0] );
+		VectorCopy( pc->bounds[1], record->bounds[1] );
+		record->numPlanes = pc->numPlanes;
+		record->numFacets = pc->numFacets;
+		data += sizeof( *record );
+
+		Com_Memcpy( data, pc->planes, pc->numPlanes * sizeof( patchPlane_t ) );
+		data += pc->numPlanes * sizeof( patchPlane_t );
+
+		for ( j = 0; j < pc->numFacets; j++, data += FACET_CACHE_SIZE ) {
+			Com_Memcpy( data, &pc->facets[j], FACET_CACHE_SIZE );
+		}
+
+		header->numPatches++;
+	}
+
+	header->dataChecksum = (int)Com_BlockChecksum( header + 1, length - sizeof( *header ) );
+
+	f = FS_FOpenFileWrite( patchCache.name );
+	if ( f != FS_INVALID_HANDLE ) {
+		if ( FS_Write( buffer, length, f ) != length ) {
+			// a short file fails the length check next time
+			Com_Printf( S_COLOR_YELLOW "%s: couldn't write %s\n", __func__, patchCache.name );
+		}
+		FS_FCloseFile( f );
+		Com_DPrintf( "Wrote %i patches to %s\n", header->numPatches, patchCache.name );
+	}
+
+	Hunk_FreeTempMemory( buffer );
+}
+
+
+/*
+==================
+CM_ClosePatchCache
+
+Called once all patches are loaded, writes a new cache if anything
+had to be generated
+==================
+*/
+void CM_ClosePatchCache( void ) {
+	if ( patchCache.rewrite && patchCache.name[0] ) {
+		CM_WritePatchCache();
+	}
+
+	if ( patchCache.buffer ) {
+		Hunk_FreeTempMemory( patchCache.buffer );
+	}
+
+	Com_Memset( &patchCache, 0, sizeof( patchCache ) );
+}
@@ -49,22 +49,24 @@ void SetPlaneSignbits( cplane_t *out ) {
 #endif //BSPC
 
 // to allow boxes to be treated as brush models, we allocate
-// some extra indexes along with those needed by the map
+// some extra indexes along with those needed by the map, the
+// brush itself lives in cm_boxHull
 #define BOX_LEAF_BRUSHES    1   // ydnar
 #define	BOX_BRUSHES		1
-#define	BOX_SIDES		6
 #define	BOX_LEAFS		2
-#define	BOX_PLANES		12
 
 #define	LL(x) x=LittleLong(x)
 
 
 clipMap_t	cm;
-int			c_pointcontents;
-int			c_traces, c_brush_traces, c_patch_traces;
+Q_THREADLOCAL cmBoxHull_t	cm_boxHull;
+Q_THREADLOCAL int			c_pointcontents;
+Q_THREADLOCAL int			c_traces, c_brush_traces, c_patch_traces;
 
+static Q_THREADLOCAL cmCheck_t	cm_check;
 
-static byte *cmod_base;
+
+static const byte *cmod_base;
 
 #ifndef BSPC
 cvar_t		*cm_noAreas;
@@ -72,15 +74,14 @@ cvar_t		*cm_noCurves;
 cvar_t		*cm_playerCurveClip;
 cvar_t      *cm_optimize;
 cvar_t		*cm_optimizePatchPlanes;
+cvar_t		*cm_debugSurfaceUpdate;
+cvar_t		*cm_patchCache;
+#ifdef CM_SIMD
+cvar_t		*cm_simd;
+#endif
 #endif
-
-static cmodel_t box_model;
-static cplane_t *box_planes;
-static cbrush_t *box_brush;
-
 
 
-static void	CM_InitBoxHull (void);
 void	CM_FloodAreaConnections (void);
 
 
@@ -238,6 +239,37 @@ static void CM_BoundBrush( cbrush_t *b ) {
 }
 
 
+#ifdef CM_SIMD
+/*
+=================
+CM_SetBrushPlanes
+
+Copies the side planes into the layout the SIMD trace code loads from.
+Padding planes are far behind the trace, so they never clip anything.
+=================
+*/
+static void CM_SetBrushPlanes( cbrush_t *b ) {
+	const cplane_t *plane;
+	int i, stride;
+
+	stride = CM_SIMD_PAD( b->numsides );
+	b->planes = Hunk_Alloc( 4 * stride * sizeof( float ), h_high );
+
+	for ( i = 0; i < stride; i++ ) {
+		if ( i < b->numsides ) {
+			plane = b->sides[i].plane;
+			b->planes[0 * stride + i] = plane->normal[0];
+			b->planes[1 * stride + i] = plane->normal[1];
+			b->planes[2 * stride + i] = plane->normal[2];
+			b->planes[3 * stride + i] = plane->dist;
+		} else {
+			b->planes[3 * stride + i] = 1e30f;
+		}
+	}
+}
+#endif
+
+
 /*
 =================
 CMod_LoadBrushes
@@ -255,7 +287,7 @@ static void CMod_LoadBrushes( const lump_t *l ) {
 
 	count = l->filelen / sizeof(*in);
 
-	cm.brushes = Hunk_Alloc( ( BOX_BRUSHES + count ) * sizeof( *cm.brushes ), h_high );
+	cm.brushes = Hunk_Alloc( count * sizeof( *cm.brushes ), h_high );
 	cm.numBrushes = count;
 
 	out = cm.brushes;
@@ -271,6 +303,12 @@ static void CMod_LoadBrushes( const lump_t *l ) {
 		out->contents = cm.shaders[out->shaderNum].contentFlags;
 
 		CM_BoundBrush( out );
+
+#ifdef CM_SIMD
+		if ( out->numsides > 0 ) {
+			CM_SetBrushPlanes( out );
+		}
+#endif
 	}
 
 }
@@ -344,7 +382,7 @@ static void CMod_LoadPlanes( const lump_t *l )
 	if ( count < 1 )
 		Com_Error( ERR_DROP, "%s: map with no planes", __func__ );
 
-	cm.planes = Hunk_Alloc( ( BOX_PLANES + count ) * sizeof( *cm.planes ), h_high );
+	cm.planes = Hunk_Alloc( count * sizeof( *cm.planes ), h_high );
 	cm.numPlanes = count;
 
 	out = cm.planes;
@@ -462,7 +500,7 @@ static void CMod_LoadBrushSides( const lump_t *l )
 	}
 	count = l->filelen / sizeof(*in);
 
-	cm.brushsides = Hunk_Alloc( ( BOX_SIDES + count ) * sizeof( *cm.brushsides ), h_high );
+	cm.brushsides = Hunk_Alloc( count * sizeof( *cm.brushsides ), h_high );
 	cm.numBrushSides = count;
 
 	out = cm.brushsides;
@@ -535,8 +573,8 @@ static void CMod_LoadVisibility( const lump_t *l ) {
 
 	cm.vised = qtrue;
 	cm.visibility = Hunk_Alloc( len, h_high );
-	cm.numClusters = LittleLong( ((int *)buf)[0] );
-	cm.clusterBytes = LittleLong( ((int *)buf)[1] );
+	cm.numClusters = LittleLong( ((const int *)buf)[0] );
+	cm.clusterBytes = LittleLong( ((const int *)buf)[1] );
 	memcpy( cm.visibility, buf + VIS_HEADER, len - VIS_HEADER );
 }
 
@@ -549,8 +587,8 @@ CMod_LoadPatches
 =================
 */
 #define	MAX_PATCH_VERTS		1024
-static void CMod_LoadPatches( const lump_t *surfs, const lump_t *verts ) {
-	drawVert_t	*dv, *dv_p;
+static void CMod_LoadPatches( const lump_t *surfs, const lump_t *verts, const char *name ) {
+	const drawVert_t	*dv, *dv_p;
 	const dsurface_t	*in;
 	int			count;
 	int			i, j;
@@ -567,7 +605,11 @@ static void CMod_LoadPatches( const lump_t *surfs, const lump_t *verts ) {
 	cm.numSurfaces = count = surfs->filelen / sizeof(*in);
 	cm.surfaces = Hunk_Alloc( cm.numSurfaces * sizeof( cm.surfaces[0] ), h_high );
 
-	dv = (drawVert_t *)(cmod_base + verts->fileofs);
+#ifndef BSPC
+	CM_OpenPatchCache( name );
+#endif
+
+	dv = (const drawVert_t *)(cmod_base + verts->fileofs);
 	if (verts->filelen % sizeof(*dv))
 		Com_Error( ERR_DROP, "%s: funny vert lump size", __func__ );
 
@@ -601,8 +643,18 @@ static void CMod_LoadPatches( const lump_t *surfs, const lump_t *verts ) {
 		patch->surfaceFlags = cm.shaders[shaderNum].surfaceFlags;
 
 		// create the internal facet structure
+#ifndef BSPC
+		patch->pc = CM_CachedPatchCollide( i );
+		if ( patch->pc ) {
+			continue;
+		}
+#endif
 		patch->pc = CM_GeneratePatchCollide( width, height, points );
 	}
+
+#ifndef BSPC
+	CM_ClosePatchCache();
+#endif
 }
 
 //==================================================================
@@ -642,7 +694,7 @@ Loads in the map and all submodels
 ==================
 */
 void CM_LoadMap( const char *name, qboolean clientload, int *checksum ) {
-	void			*buf;
+	const void		*buf;
 	int				i;
 	dheader_t		header;
 	int				length;
@@ -659,6 +711,14 @@ void CM_LoadMap( const char *name, qboolean clientload, int *checksum ) {
 	cm_playerCurveClip = Cvar_Get( "cm_playerCurveClip", "1", CVAR_ARCHIVE_ND | CVAR_CHEAT );
 	Cvar_SetDescription( cm_playerCurveClip, "Collide player against curves" );
 	cm_optimize = Cvar_Get( "cm_optimize", "1", CVAR_CHEAT );
+	// traces must not register cvars, they may run outside the main thread
+	cm_debugSurfaceUpdate = Cvar_Get( "r_debugSurfaceUpdate", "1", 0 );
+	cm_patchCache = Cvar_Get( "cm_patchCache", "1", CVAR_ARCHIVE_ND );
+	Cvar_SetDescription( cm_patchCache, "Keep generated curve collision data in cmcache/ so the next load of the same map can skip it" );
+#ifdef CM_SIMD
+	cm_simd = Cvar_Get( "cm_simd", "1", 0 );
+	Cvar_SetDescription( cm_simd, "Test four brush or patch planes at once, gives the same results as the plain code" );
+#endif
 #endif
 
 	// We only care about this cvar on server, client will parse it out of systeminfo directly
@@ -697,9 +757,10 @@ void CM_LoadMap( const char *name, qboolean clientload, int *checksum ) {
 	// load the file
 	//
 #ifndef BSPC
-	length = FS_ReadFile( name, &buf );
+	// shared with the renderer, read only
+	length = FS_ReadBSP( name, &buf );
 #else
-	length = LoadQuakeFile( (quakefile_t *) name, &buf );
+	length = LoadQuakeFile( (quakefile_t *) name, (void **)&buf );
 #endif
 
 	if ( !buf ) {
@@ -711,7 +772,7 @@ void CM_LoadMap( const char *name, qboolean clientload, int *checksum ) {
 
 	*checksum = cm.checksum = LittleLong( Com_BlockChecksum( buf, length ) );
 
-	header = *(dheader_t *)buf;
+	header = *(const dheader_t *)buf;
 	for ( i = 0; i < sizeof( dheader_t ) / sizeof( int32_t ); i++ ) {
 		( (int32_t *)&header )[i] = LittleLong( ( (int32_t *)&header )[i] );
 	}
@@ -728,7 +789,7 @@ void CM_LoadMap( const char *name, qboolean clientload, int *checksum ) {
 		}
 	}
 
-	cmod_base = (byte *)buf;
+	cmod_base = (const byte *)buf;
 
 	// load into heap
 	CMod_LoadShaders( &header.lumps[LUMP_SHADERS] );
@@ -742,14 +803,19 @@ void CM_LoadMap( const char *name, qboolean clientload, int *checksum ) {
 	CMod_LoadNodes (&header.lumps[LUMP_NODES]);
 	CMod_LoadEntityString (&header.lumps[LUMP_ENTITIES], name);
 	CMod_LoadVisibility( &header.lumps[LUMP_VISIBILITY] );
-	CMod_LoadPatches( &header.lumps[LUMP_SURFACES], &header.lumps[LUMP_DRAWVERTS] );
+	CMod_LoadPatches( &header.lumps[LUMP_SURFACES], &header.lumps[LUMP_DRAWVERTS], name );
 
 	CMod_CheckLeafBrushes();
 
-	// we are NOT freeing the file, because it is cached for the ref
-	FS_FreeFile( buf );
+	// the image itself stays cached for the ref
+#ifndef BSPC
+	FS_FreeBSP( buf );
+#else
+	FS_FreeFile( (void *)buf );
+#endif
 
-	CM_InitBoxHull();
+	// link the temp box brush
+	cm.leafbrushes[cm.numLeafBrushes] = cm.numBrushes;
 
 	CM_FloodAreaConnections();
 
@@ -784,7 +850,7 @@ cmodel_t *CM_ClipHandleToModel( clipHandle_t handle ) {
 		return &cm.cmodels[handle];
 	}
 	if ( handle == BOX_MODEL_HANDLE || handle == CAPSULE_MODEL_HANDLE ) {
-		return &box_model;
+		return &cm_boxHull.model;
 	}
 	if ( handle < MAX_SUBMODELS ) {
 		Com_Error( ERR_DROP, "CM_ClipHandleToModel: bad handle %i < %i < %i", 
@@ -846,46 +912,39 @@ int CM_LeafArea( int leafnum ) {
 ===================
 CM_InitBoxHull
 
-Set up the planes and nodes so that the six floats of a bounding box
+Set up the planes and sides so that the six floats of a bounding box
 can just be stored out and get a proper clipping hull structure.
+Every thread has its own box hull, so this runs once per thread.
 ===================
 */
-static void CM_InitBoxHull( void )
+static void CM_InitBoxHull( cmBoxHull_t *box )
 {
 	int			i;
 	int			side;
 	cplane_t	*p;
 	cbrushside_t	*s;
 
-	box_planes = &cm.planes[cm.numPlanes];
-
-	box_brush = &cm.brushes[cm.numBrushes];
-	box_brush->numsides = 6;
-	box_brush->sides = cm.brushsides + cm.numBrushSides;
-	box_brush->contents = CONTENTS_BODY;
-
-	box_model.leaf.numLeafBrushes = 1;
-//	box_model.leaf.firstLeafBrush = cm.numBrushes;
-	box_model.leaf.firstLeafBrush = cm.numLeafBrushes;
-	cm.leafbrushes[cm.numLeafBrushes] = cm.numBrushes;
+	box->brush.numsides = 6;
+	box->brush.sides = box->sides;
+	box->brush.contents = CONTENTS_BODY;
 
 	for ( i = 0; i < 6; i++ )
 	{
 		side = i & 1;
 
 		// brush sides
-		s = &cm.brushsides[cm.numBrushSides + i];
-		s->plane = cm.planes + ( cm.numPlanes + i * 2 + side );
+		s = &box->sides[i];
+		s->plane = &box->planes[i * 2 + side];
 		s->surfaceFlags = 0;
 
 		// planes
-		p = &box_planes[i * 2];
+		p = &box->planes[i * 2];
 		p->type = i >> 1;
 		p->signbits = 0;
 		VectorClear( p->normal );
 		p->normal[i >> 1] = 1;
 
-		p = &box_planes[i * 2 + 1];
+		p = &box->planes[i * 2 + 1];
 		p->type = 3 + ( i >> 1 );
 		p->signbits = 0;
 		VectorClear( p->normal );
@@ -893,6 +952,8 @@ static void CM_InitBoxHull( void )
 
 		SetPlaneSignbits( p );
 	}
+
+	box->initialized = qtrue;
 }
 
 
@@ -903,43 +964,123 @@ CM_TempBoxModel
 To keep everything totally uniform, bounding boxes are turned into small
 BSP trees instead of being compared directly.
 Capsules are handled differently though.
+The box is private to the calling thread, so the handle is only valid
+for traces issued by the same thread.
 ===================
 */
 clipHandle_t CM_TempBoxModel( const vec3_t mins, const vec3_t maxs, int capsule ) {
+	cmBoxHull_t *box = &cm_boxHull;
+	cplane_t *planes;
 
-	VectorCopy( mins, box_model.mins );
-	VectorCopy( maxs, box_model.maxs );
+	if ( !box->initialized ) {
+		CM_InitBoxHull( box );
+	}
+
+	// the leaf brush index moves with every map
+	box->model.leaf.numLeafBrushes = 1;
+	box->model.leaf.firstLeafBrush = cm.numLeafBrushes;
+
+	VectorCopy( mins, box->model.mins );
+	VectorCopy( maxs, box->model.maxs );
+
+	// the planes are set up for capsules too, with ALWAYS_BBOX_VS_BBOX they
+	// are traced as boxes and would otherwise use whatever box came last
+	planes = box->planes;
+	planes[0].dist = maxs[0];
+	planes[1].dist = -maxs[0];
+	planes[2].dist = mins[0];
+	planes[3].dist = -mins[0];
+	planes[4].dist = maxs[1];
+	planes[5].dist = -maxs[1];
+	planes[6].dist = mins[1];
+	planes[7].dist = -mins[1];
+	planes[8].dist = maxs[2];
+	planes[9].dist = -maxs[2];
+	planes[10].dist = mins[2];
+	planes[11].dist = -mins[2];
+
+	VectorCopy( mins, box->brush.bounds[0] );
+	VectorCopy( maxs, box->brush.bounds[1] );
 
 	if ( capsule ) {
 		return CAPSULE_MODEL_HANDLE;
 	}
 
-	box_planes[0].dist = maxs[0];
-	box_planes[1].dist = -maxs[0];
-	box_planes[2].dist = mins[0];
-	box_planes[3].dist = -mins[0];
-	box_planes[4].dist = maxs[1];
-	box_planes[5].dist = -maxs[1];
-	box_planes[6].dist = mins[1];
-	box_planes[7].dist = -mins[1];
-	box_planes[8].dist = maxs[2];
-	box_planes[9].dist = -maxs[2];
-	box_planes[10].dist = mins[2];
-	box_planes[11].dist = -mins[2];
-
-	VectorCopy( mins, box_brush->bounds[0] );
-	VectorCopy( maxs, box_brush->bounds[1] );
-
 	return BOX_MODEL_HANDLE;
 }
 
 // DHM - Nerve
 void CM_SetTempBoxModelContents( int contents ) {
 
-	box_brush->contents = contents;
+	if ( !cm_boxHull.initialized ) {
+		CM_InitBoxHull( &cm_boxHull );
+	}
+
+	cm_boxHull.brush.contents = contents;
 }
 // dhm
 
+
+/*
+===================
+CM_BeginCheck
+
+Returns the stamps of the calling thread with a fresh checkcount,
+growing them if the current map has more brushes or surfaces than
+any map this thread traced before
+===================
+*/
+cmCheck_t *CM_BeginCheck( void ) {
+	cmCheck_t *check = &cm_check;
+	int *list;
+	int count;
+
+	count = cm.numBrushes + BOX_BRUSHES;
+	if ( check->numBrushes < count ) {
+		// not zone memory, the zone isn't thread safe
+		list = realloc( check->brushes, count * sizeof( *list ) );
+		if ( !list ) {
+			Com_Error( ERR_FATAL, "%s: failed to allocate %i brush stamps", __func__, count );
+		}
+		// checkcount never goes backwards, so zero is always stale
+		Com_Memset( list + check->numBrushes, 0, ( count - check->numBrushes ) * sizeof( *list ) );
+		check->brushes = list;
+		check->numBrushes = count;
+	}
+
+	count = cm.numSurfaces;
+	if ( check->numSurfaces < count ) {
+		list = realloc( check->surfaces, count * sizeof( *list ) );
+		if ( !list ) {
+			Com_Error( ERR_FATAL, "%s: failed to allocate %i surface stamps", __func__, count );
+		}
+		Com_Memset( list + check->numSurfaces, 0, ( count - check->numSurfaces ) * sizeof( *list ) );
+		check->surfaces = list;
+		check->numSurfaces = count;
+	}
+
+	check->checkcount++;
+
+	return check;
+}
+
+
+/*
+===================
+CM_ThreadShutdown
+
+Frees the collision state of the calling thread, must be called by every
+thread other than the main thread that used the collision model
+===================
+*/
+void CM_ThreadShutdown( void ) {
+	cmCheck_t *check = &cm_check;
+
+	free( check->brushes );
+	free( check->surfaces );
+	Com_Memset( check, 0, sizeof( *check ) );
+}
+
 /*
 ===================
 CM_ModelBounds
@@ -89,6 +89,18 @@ static ID_INLINE vec_t VectorNormalizeDP( vec3_t v ) {
 // enable to make the collision detection a bunch faster
 #define MRE_OPTIMIZE
 
+// brush sides and patch facet borders are also stored as separate normal
+// and dist arrays so four planes can be tested at once, SSE2 is always
+// there on x86_64. The vector code does the same arithmetic in the same
+// order as the scalar code, so traces give bit identical results.
+#if idx64 && !defined(BSPC)
+#define CM_SIMD
+#include <emmintrin.h>
+#endif
+
+#define CM_SIMD_WIDTH   4
+#define CM_SIMD_PAD(n)  PAD( (n), CM_SIMD_WIDTH )
+
 typedef struct {
 	cplane_t    *plane;
 	int children[2];                // negative numbers are leafs
@@ -122,12 +134,11 @@ typedef struct {
 	vec3_t bounds[2];
 	int numsides;
 	cbrushside_t    *sides;
-	int checkcount;             // to avoid repeated testings
+	float       *planes;        // [4][CM_SIMD_PAD(numsides)] normals and dists, NULL if not set up
 } cbrush_t;
 
 
 typedef struct {
-	int checkcount;                     // to avoid repeated testings
 	int surfaceFlags;
 	int contents;
 	struct patchCollide_s   *pc;
@@ -185,23 +196,91 @@ typedef struct {
 	cPatch_t    **surfaces;         // non-patches will be NULL
 
 	int floodvalid;
-	int checkcount;                         // incremented on each trace
 	unsigned int checksum;
 } clipMap_t;
 
 
+// Everything in clipMap_t is read only once CM_LoadMap returns, except for
+// the area portal state which may only be changed from the main thread.
+// What a single trace needs to write lives in the calling thread instead.
+
+// brush and patch stamps to avoid repeated testings of the same brush or
+// patch when it is linked into more than one leaf
+typedef struct {
+	int checkcount;             // incremented on each trace
+	int numBrushes;
+	int numSurfaces;
+	int *brushes;               // [numBrushes] checkcount of the last test
+	int *surfaces;              // [numSurfaces]
+} cmCheck_t;
+
+// to allow boxes to be treated as brush models, the temp box model is
+// a single brush linked past the end of cm.leafbrushes
+typedef struct {
+	qboolean initialized;
+	cmodel_t model;
+	cbrush_t brush;
+	cbrushside_t sides[6];
+	cplane_t planes[12];
+} cmBoxHull_t;
+
+
 // keep 1/8 unit away to keep the position valid before network snapping
 // and to avoid various numeric issues
 #define SURFACE_CLIP_EPSILON    ( 0.125 )
 
 extern clipMap_t cm;
-extern int c_pointcontents;
-extern int c_traces, c_brush_traces, c_patch_traces;
+extern Q_THREADLOCAL cmBoxHull_t cm_boxHull;
+extern Q_THREADLOCAL int c_pointcontents;
+extern Q_THREADLOCAL int c_traces, c_brush_traces, c_patch_traces;
 extern cvar_t      *cm_noAreas;
 extern cvar_t      *cm_noCurves;
 extern cvar_t      *cm_playerCurveClip;
 extern cvar_t      *cm_optimize;
 extern cvar_t      *cm_optimizePatchPlanes;
+extern cvar_t      *cm_debugSurfaceUpdate;
+extern cvar_t      *cm_patchCache;
+#ifdef CM_SIMD
+extern cvar_t      *cm_simd;
+#endif
+
+// cm_load.c
+
+cmCheck_t	*CM_BeginCheck( void );
+
+#ifdef CM_SIMD
+// lane helpers for the SIMD plane tests, the dot products add up in the
+// same order as DotProduct and DotProductDP
+static ID_INLINE __m128 CM_SelectPS( __m128 mask, __m128 a, __m128 b ) {
+	return _mm_or_ps( _mm_and_ps( mask, b ), _mm_andnot_ps( mask, a ) );
+}
+
+static ID_INLINE __m128d CM_SelectPD( __m128d mask, __m128d a, __m128d b ) {
+	return _mm_or_pd( _mm_and_pd( mask, b ), _mm_andnot_pd( mask, a ) );
+}
+
+static ID_INLINE __m128 CM_DotPS( const __m128 *x, const __m128 *y ) {
+	return _mm_add_ps( _mm_add_ps( _mm_mul_ps( x[0], y[0] ), _mm_mul_ps( x[1], y[1] ) ), _mm_mul_ps( x[2], y[2] ) );
+}
+
+static ID_INLINE __m128d CM_DotPD( const __m128d *x, const __m128d *y ) {
+	return _mm_add_pd( _mm_add_pd( _mm_mul_pd( x[0], y[0] ), _mm_mul_pd( x[1], y[1] ) ), _mm_mul_pd( x[2], y[2] ) );
+}
+#endif
+
+/*
+==================
+CM_LeafBrush
+
+The temp box brush is private to every thread
+==================
+*/
+static ID_INLINE cbrush_t *CM_LeafBrush( int brushnum ) {
+	if ( brushnum == cm.numBrushes ) {
+		return &cm_boxHull.brush;
+	}
+	return &cm.brushes[brushnum];
+}
 
 // cm_test.c
 
@@ -227,6 +306,7 @@ typedef struct {
 	qboolean isPoint;       // optimized case
 	trace_t trace;          // returned from trace call
 	sphere_t sphere;        // sphere for oriendted capsule collision
+	cmCheck_t *check;       // stamps of the calling thread
 #ifdef MRE_OPTIMIZE
 	cplane_t tracePlane1;
 	cplane_t tracePlane2;
@@ -243,6 +323,7 @@ typedef struct leafList_s {
 	int     *list;
 	vec3_t bounds[2];
 	int lastLeaf;           // for overflows where each leaf can't be stored individually
+	cmCheck_t *check;       // only used by CM_StoreBrushes
 	void ( *storeLeafs )( struct leafList_s *ll, int nodenum );
 } leafList_t;
 
@@ -264,4 +345,14 @@ struct patchCollide_s	*CM_GeneratePatchCollide( int width, int height, vec3_t *p
 void CM_TraceThroughPatchCollide( traceWork_t *tw, const struct patchCollide_s *pc );
 qboolean CM_PositionTestInPatchCollide( traceWork_t *tw, const struct patchCollide_s *pc );
 void CM_ClearLevelPatches( void );
+qboolean CM_UseVanillaOptimization( void );
+#ifdef CM_SIMD
+void CM_SetFacetBorders( struct patchCollide_s *pf );
+#endif
+
+// cm_cache.c
+
+void CM_OpenPatchCache( const char *mapname );
+struct patchCollide_s *CM_CachedPatchCollide( int surfaceNum );
+void CM_ClosePatchCache( void );
 #endif
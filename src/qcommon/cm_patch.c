@@ -112,8 +112,9 @@ typedef struct {
 
 static int c_totalPatchBlocks;
 
-static const patchCollide_t	*debugPatchCollide;
-static const facet_t		*debugFacet;
+// kept per thread, so only traces from the main thread are drawn
+static Q_THREADLOCAL const patchCollide_t	*debugPatchCollide;
+static Q_THREADLOCAL const facet_t		*debugFacet;
 static qboolean		debugBlock;
 static vec3_t		debugBlockPoints[4];
 
@@ -865,7 +866,7 @@ static qboolean CM_ValidateFacet( const facet_t *facet ) {
 
 // Returns true for vanilla ET behavior, false for fixed behavior
 // See further comments in area where function is used as well
-static ID_INLINE qboolean CM_UseVanillaOptimization( void ) {
+qboolean CM_UseVanillaOptimization( void ) {
 #ifdef DEDICATED
 	return cm_optimizePatchPlanes->integer != 0;
 #else
@@ -1083,6 +1084,56 @@ typedef enum {
 	EN_LEFT
 } edgeName_t;
 
+#ifdef CM_SIMD
+/*
+==================
+CM_SetFacetBorders
+
+Copies the border planes of all facets into the layout the SIMD trace
+code loads from. The planes keep their stored orientation and the flip
+is applied when tracing, like the plain code does.
+==================
+*/
+void CM_SetFacetBorders( patchCollide_t *pf ) {
+	const patchPlane_t *pp;
+	facet_t	*facet;
+	float	*borders;
+	int		i, j, stride, total;
+
+	total = 0;
+	for ( i = 0; i < pf->numFacets; i++ ) {
+		total += 5 * CM_SIMD_PAD( pf->facets[i].numBorders );
+	}
+
+	if ( !total ) {
+		return;
+	}
+
+	borders = Hunk_Alloc( total * sizeof( float ), h_high );
+
+	for ( i = 0, facet = pf->facets; i < pf->numFacets; i++, facet++ ) {
+		stride = CM_SIMD_PAD( facet->numBorders );
+		facet->borders = borders;
+		for ( j = 0; j < stride; j++ ) {
+			if ( j < facet->numBorders ) {
+				pp = &pf->planes[ facet->borderPlanes[j] ];
+				borders[0 * stride + j] = pp->plane[0];
+				borders[1 * stride + j] = pp->plane[1];
+				borders[2 * stride + j] = pp->plane[2];
+				borders[3 * stride + j] = pp->plane[3];
+				borders[4 * stride + j] = facet->borderInward[j] ? -1.0f : 1.0f;
+			} else {
+				// far behind any trace
+				borders[3 * stride + j] = 1e30f;
+				borders[4 * stride + j] = 1.0f;
+			}
+		}
+		borders += 5 * stride;
+	}
+}
+#endif
+
+
 /*
 ==================
 CM_PatchCollideFromGrid
@@ -1243,6 +1294,10 @@ static void CM_PatchCollideFromGrid( const cGrid_t *grid, patchCollide_t *pf ) {
 	Com_Memcpy( pf->facets, facets, numFacets * sizeof( *pf->facets ) );
 	pf->planes = Hunk_Alloc( numPlanes * sizeof( *pf->planes ), h_high );
 	Com_Memcpy( pf->planes, planes, numPlanes * sizeof( *pf->planes ) );
+
+#ifdef CM_SIMD
+	CM_SetFacetBorders( pf );
+#endif
 }
 
 
@@ -1348,9 +1403,6 @@ static void CM_TracePointThroughPatchCollide( traceWork_t *tw, const struct patc
 	int			i, j, k;
 	float		offset;
 	float		d1, d2;
-#ifndef BSPC
-	static cvar_t *cv;
-#endif //BSPC
 
 #ifndef BSPC
 	if ( !cm_playerCurveClip->integer && !tw->isPoint ) {
@@ -1408,10 +1460,7 @@ static void CM_TracePointThroughPatchCollide( traceWork_t *tw, const struct patc
 		if ( j == facet->numBorders ) {
 			// we hit this facet
 #ifndef BSPC
-			if (!cv) {
-				cv = Cvar_Get( "r_debugSurfaceUpdate", "1", 0 );
-			}
-			if (cv->integer) {
+			if ( cm_debugSurfaceUpdate->integer ) {
 				debugPatchCollide = pc;
 				debugFacet = facet;
 			}
@@ -1437,17 +1486,14 @@ static void CM_TracePointThroughPatchCollide( traceWork_t *tw, const struct patc
 
 /*
 ====================
-CM_CheckFacetPlane
+CM_ClipFacetPlane
 ====================
 */
-static int CM_CheckFacetPlane( const float *plane, const vec3_t start, const vec3_t end, float *enterFrac, float *leaveFrac, int *hit ) {
-	float d1, d2, f;
+static int CM_ClipFacetPlane( float d1, float d2, float *enterFrac, float *leaveFrac, int *hit ) {
+	float f;
 
 	*hit = qfalse;
 
-	d1 = DotProduct( start, plane ) - plane[3];
-	d2 = DotProduct( end, plane ) - plane[3];
-
 	// if completely in front of face, no intersection with the entire facet
 	if (d1 > 0 && ( d2 >= SURFACE_CLIP_EPSILON || d2 >= d1 )  ) {
 		return qfalse;
@@ -1482,6 +1528,114 @@ static int CM_CheckFacetPlane( const float *plane, const vec3_t start, const vec
 }
 
 
+/*
+====================
+CM_CheckFacetPlane
+====================
+*/
+static int CM_CheckFacetPlane( const float *plane, const vec3_t start, const vec3_t end, float *enterFrac, float *leaveFrac, int *hit ) {
+	float d1, d2;
+
+	d1 = DotProduct( start, plane ) - plane[3];
+	d2 = DotProduct( end, plane ) - plane[3];
+
+	return CM_ClipFacetPlane( d1, d2, enterFrac, leaveFrac, hit );
+}
+
+
+#ifdef CM_SIMD
+#define MAX_FACET_BORDERS	CM_SIMD_PAD( 4 + 6 + 16 )
+
+/*
+====================
+CM_FacetBorderDists
+
+Start and end distances to all borders of a facet, four at a time, with
+the same float arithmetic the plain loops use. The adjusted border dists
+are returned for the hit plane. d2 may be NULL for position tests.
+Returns qfalse if the trace is completely in front of any border, the
+plain loops drop the facet at that border and the ones before it don't
+matter then.
+====================
+*/
+static qboolean CM_FacetBorderDists( const traceWork_t *tw, const facet_t *facet, float *d1, float *d2, float *dists ) {
+	__m128	n[3], o[3], s[3], e[3], sp[3], ep[3], spAdd[3], epAdd[3], off[3];
+	__m128	flip, d, dd1, dd2, mask, front;
+	const float *borders;
+	vec3_t	startp, endp;
+	int		i, k, stride;
+
+	stride = CM_SIMD_PAD( facet->numBorders );
+	borders = facet->borders;
+
+	if ( tw->sphere.use ) {
+		VectorSubtract( tw->start, tw->sphere.offset, startp );
+		VectorSubtract( tw->end, tw->sphere.offset, endp );
+		for ( k = 0; k < 3; k++ ) {
+			sp[k] = _mm_set1_ps( startp[k] );
+			ep[k] = _mm_set1_ps( endp[k] );
+			spAdd[k] = _mm_set1_ps( tw->start[k] + tw->sphere.offset[k] );
+			epAdd[k] = _mm_set1_ps( tw->end[k] + tw->sphere.offset[k] );
+			off[k] = _mm_set1_ps( tw->sphere.offset[k] );
+		}
+	} else {
+		for ( k = 0; k < 3; k++ ) {
+			sp[k] = _mm_set1_ps( tw->start[k] );
+			ep[k] = _mm_set1_ps( tw->end[k] );
+		}
+	}
+
+	front = _mm_setzero_ps();
+
+	for ( i = 0; i < stride; i += CM_SIMD_WIDTH ) {
+		flip = _mm_loadu_ps( borders + 4 * stride + i );
+		for ( k = 0; k < 3; k++ ) {
+			n[k] = _mm_mul_ps( _mm_loadu_ps( borders + k * stride + i ), flip );
+		}
+		d = _mm_mul_ps( _mm_loadu_ps( borders + 3 * stride + i ), flip );
+
+		if ( tw->sphere.use ) {
+			// adjust the plane distance appropriately for radius
+			d = _mm_add_ps( d, _mm_set1_ps( tw->sphere.radius ) );
+
+			// find the closest point on the capsule to the plane
+			mask = _mm_cmpgt_ps( CM_DotPS( n, off ), _mm_setzero_ps() );
+			for ( k = 0; k < 3; k++ ) {
+				s[k] = CM_SelectPS( mask, spAdd[k], sp[k] );
+				e[k] = CM_SelectPS( mask, epAdd[k], ep[k] );
+			}
+		} else {
+			// offsets are picked by the signbits of the stored plane
+			for ( k = 0; k < 3; k++ ) {
+				mask = _mm_cmplt_ps( _mm_loadu_ps( borders + k * stride + i ), _mm_setzero_ps() );
+				o[k] = CM_SelectPS( mask, _mm_set1_ps( tw->size[0][k] ), _mm_set1_ps( tw->size[1][k] ) );
+				s[k] = sp[k];
+				e[k] = ep[k];
+			}
+			// plane[3] += fabs( offset )
+			d = _mm_add_ps( d, _mm_andnot_ps( _mm_set1_ps( -0.0f ), CM_DotPS( o, n ) ) );
+		}
+
+		dd1 = _mm_sub_ps( CM_DotPS( s, n ), d );
+		_mm_storeu_ps( dists + i, d );
+		_mm_storeu_ps( d1 + i, dd1 );
+
+		mask = _mm_cmpgt_ps( dd1, _mm_setzero_ps() );
+		if ( d2 ) {
+			dd2 = _mm_sub_ps( CM_DotPS( e, n ), d );
+			_mm_storeu_ps( d2 + i, dd2 );
+			// d1 > 0 && ( d2 >= SURFACE_CLIP_EPSILON || d2 >= d1 )
+			mask = _mm_and_ps( mask, _mm_or_ps( _mm_cmpge_ps( dd2, _mm_set1_ps( SURFACE_CLIP_EPSILON ) ),
+				_mm_cmpge_ps( dd2, dd1 ) ) );
+		}
+		front = _mm_or_ps( front, mask );
+	}
+
+	return _mm_movemask_ps( front ) == 0;
+}
+#endif
+
+
 /*
 ====================
 CM_TraceThroughPatchCollide
@@ -1494,9 +1648,9 @@ void CM_TraceThroughPatchCollide( traceWork_t *tw, const struct patchCollide_s *
 	facet_t	*facet;
 	float plane[4], bestplane[4];
 	vec3_t startp, endp;
-#ifndef BSPC
-	static cvar_t *cv;
-#endif //BSPC
+#ifdef CM_SIMD
+	float d1[MAX_FACET_BORDERS], d2[MAX_FACET_BORDERS], dists[MAX_FACET_BORDERS];
+#endif
 
 	if ( !CM_BoundsIntersect( tw->bounds[0], tw->bounds[1],
 				pc->bounds[0], pc->bounds[1] ) ) {
@@ -1548,6 +1702,26 @@ void CM_TraceThroughPatchCollide( traceWork_t *tw, const struct patchCollide_s *
 			Vector4Copy(plane, bestplane);
 		}
 
+#ifdef CM_SIMD
+		if ( facet->borders && cm_simd->integer ) {
+			if ( !CM_FacetBorderDists( tw, facet, d1, d2, dists ) ) {
+				continue;
+			}
+			for ( j = 0; j < facet->numBorders; j++ ) {
+				CM_ClipFacetPlane( d1[j], d2[j], &enterFrac, &leaveFrac, &hit );
+				if ( hit ) {
+					hitnum = j;
+					pp = &pc->planes[ facet->borderPlanes[j] ];
+					if ( facet->borderInward[j] ) {
+						VectorNegate( pp->plane, bestplane );
+					} else {
+						VectorCopy( pp->plane, bestplane );
+					}
+					bestplane[3] = dists[j];
+				}
+			}
+		} else
+#endif
 		for ( j = 0; j < facet->numBorders; j++ ) {
 			pp = &pc->planes[ facet->borderPlanes[j] ];
 			if (facet->borderInward[j]) {
@@ -1599,10 +1773,7 @@ void CM_TraceThroughPatchCollide( traceWork_t *tw, const struct patchCollide_s *
 				//	enterFrac = 0;
 				//}
 #ifndef BSPC
-				if (!cv) {
-					cv = Cvar_Get( "r_debugSurfaceUpdate", "1", 0 );
-				}
-				if (cv && cv->integer) {
+				if ( cm_debugSurfaceUpdate->integer ) {
 					debugPatchCollide = pc;
 					debugFacet = facet;
 				}
@@ -1637,6 +1808,9 @@ qboolean CM_PositionTestInPatchCollide( traceWork_t *tw, const struct patchColli
 	facet_t	*facet;
 	float plane[4];
 	vec3_t startp;
+#ifdef CM_SIMD
+	float d1[MAX_FACET_BORDERS], dists[MAX_FACET_BORDERS];
+#endif
 
 	if (tw->isPoint) {
 		return qfalse;
@@ -1670,6 +1844,16 @@ qboolean CM_PositionTestInPatchCollide( traceWork_t *tw, const struct patchColli
 			continue;
 		}
 
+#ifdef CM_SIMD
+		if ( facet->borders && cm_simd->integer ) {
+			if ( !CM_FacetBorderDists( tw, facet, d1, NULL, dists ) ) {
+				continue;
+			}
+			// inside this patch facet
+			return qtrue;
+		}
+#endif
+
 		for ( j = 0; j < facet->numBorders; j++ ) {
 			pp = &pc->planes[ facet->borderPlanes[j] ];
 			if (facet->borderInward[j]) {
@@ -84,6 +84,7 @@ typedef struct {
 	int borderPlanes[4 + 6 + 16];
 	qboolean borderInward[4 + 6 + 16];
 	qboolean borderNoAdjust[4 + 6 + 16];
+	float *borders;             // [5][CM_SIMD_PAD(numBorders)] border normals, dists and inward flips
 } facet_t;
 
 typedef struct patchCollide_s {
@@ -75,6 +75,14 @@ qboolean    CM_AreasConnected( int area1, int area2 );
 
 int         CM_WriteAreaBits( byte *buffer, int area );
 
+// frees the per thread collision state, the queries above may be called
+// from any thread as long as no map is loaded at the same time
+void        CM_ThreadShutdown( void );
+
 // cm_patch.c
 void CM_DrawDebugSurface( void ( *drawPoly )( int color, int numPoints, float *points ) );
+
+// cm_stress.c
+int			CM_StressTest( int numThreads, int queriesPerThread, unsigned int seed );
+void		CM_StressTest_f( void );
 #endif
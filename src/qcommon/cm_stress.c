@@ -0,0 +1,405 @@
+/*
+===========================================================================
+
+Wolfenstein: Enemy Territory GPL Source Code
+Copyright (C) 1999-2010 id Software LLC, a ZeniMax Media company.
+
+This file is part of the Wolfenstein: Enemy Territory GPL Source Code (Wolf ET Source Code).
+
+Wolf ET Source Code is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Wolf ET Source Code is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Wolf ET Source Code.  If not, see <http://www.gnu.org/licenses/>.
+
+In addition, the Wolf: ET Source Code is also subject to certain additional terms. You should have received a copy of these additional terms immediately following the terms and conditions of the GNU General Public License which accompanied the Wolf ET Source Code.  If not, please request a copy in writing from id Software at the address below.
+
+If you have questions concerning this license or the applicable additional terms, you may contact in writing id Software LLC, c/o ZeniMax Media Inc., Suite 120, Rockville, Maryland 20850 USA.
+
+===========================================================================
+*/
+
+// cm_stress.c -- runs the same random queries against the loaded map from
+// several threads at once and compares them against a single threaded run
+
+#include "cm_local.h"
+
+#define STRESS_MAX_THREADS	64
+#define STRESS_NUM_CASES	16384
+#define STRESS_MAX_LEAFS	128
+#define STRESS_MASK			( CONTENTS_SOLID | CONTENTS_PLAYERCLIP | CONTENTS_BODY )	// MASK_PLAYERSOLID
+
+typedef enum {
+	STRESS_BOX_TRACE,
+	STRESS_POINT_TRACE,
+	STRESS_CAPSULE_TRACE,
+	STRESS_POSITION_TEST,
+	STRESS_MODEL_TRACE,
+	STRESS_TEMPBOX_TRACE,
+	STRESS_POINT_CONTENTS,
+	STRESS_BOX_LEAFNUMS,
+
+	STRESS_NUM_TYPES
+} stressType_t;
+
+typedef struct {
+	stressType_t	type;
+	vec3_t			start, end;
+	vec3_t			mins, maxs;
+	clipHandle_t	model;			// inline model for STRESS_MODEL_TRACE
+	vec3_t			origin, angles;
+	vec3_t			boxMins, boxMaxs;	// for STRESS_TEMPBOX_TRACE
+	qboolean		capsule;
+} stressCase_t;
+
+// compared with memcmp, so always cleared before filling in
+typedef struct {
+	qboolean	allsolid, startsolid;
+	float		fraction;
+	vec3_t		endpos;
+	vec3_t		normal;
+	float		dist;
+	int			surfaceFlags;
+	int			contents;
+	int			numLeafs;
+	int			lastLeaf;
+	unsigned int	leafHash;
+} stressResult_t;
+
+typedef struct {
+	const stressCase_t		*cases;
+	const stressResult_t	*reference;
+	int						first;
+	int						count;
+	int						mismatches;
+	int						firstMismatch;
+} stressWorker_t;
+
+
+/*
+==================
+CM_StressRandom
+==================
+*/
+static float CM_StressRandom( unsigned int *seed ) {
+	*seed = *seed * 1103515245u + 12345u;
+	return ( ( *seed >> 8 ) & 0xffff ) / 65535.0f;
+}
+
+
+/*
+==================
+CM_StressRandomPoint
+==================
+*/
+static void CM_StressRandomPoint( unsigned int *seed, const vec3_t mins, const vec3_t maxs, vec3_t point ) {
+	int i;
+
+	for ( i = 0; i < 3; i++ ) {
+		point[i] = mins[i] + CM_StressRandom( seed ) * ( maxs[i] - mins[i] );
+	}
+}
+
+
+/*
+==================
+CM_StressGenerate
+==================
+*/
+static void CM_StressGenerate( stressCase_t *c, unsigned int *seed ) {
+	static const vec3_t playerMins = { -18, -18, -24 };
+	static const vec3_t playerMaxs = { 18, 18, 48 };
+	const cmodel_t *world = &cm.cmodels[0];
+	vec3_t delta;
+	int i;
+
+	Com_Memset( c, 0, sizeof( *c ) );
+
+	c->type = (stressType_t)( (int)( CM_StressRandom( seed ) * STRESS_NUM_TYPES ) % STRESS_NUM_TYPES );
+
+	CM_StressRandomPoint( seed, world->mins, world->maxs, c->start );
+	for ( i = 0; i < 3; i++ ) {
+		delta[i] = ( CM_StressRandom( seed ) - 0.5f ) * 1024.0f;
+	}
+	VectorAdd( c->start, delta, c->end );
+
+	if ( CM_StressRandom( seed ) < 0.5f ) {
+		VectorCopy( playerMins, c->mins );
+		VectorCopy( playerMaxs, c->maxs );
+	} else {
+		for ( i = 0; i < 3; i++ ) {
+			c->mins[i] = -CM_StressRandom( seed ) * 32.0f;
+			c->maxs[i] = CM_StressRandom( seed ) * 32.0f;
+		}
+	}
+
+	switch ( c->type ) {
+	case STRESS_POINT_TRACE:
+		VectorClear( c->mins );
+		VectorClear( c->maxs );
+		break;
+	case STRESS_CAPSULE_TRACE:
+		c->capsule = qtrue;
+		break;
+	case STRESS_POSITION_TEST:
+		VectorCopy( c->start, c->end );
+		break;
+	case STRESS_MODEL_TRACE:
+		if ( cm.numSubModels > 1 ) {
+			c->model = 1 + (int)( CM_StressRandom( seed ) * ( cm.numSubModels - 1 ) ) % ( cm.numSubModels - 1 );
+			// trace towards the model so it actually gets hit now and then
+			VectorAdd( cm.cmodels[c->model].mins, cm.cmodels[c->model].maxs, c->end );
+			VectorScale( c->end, 0.5f, c->end );
+			if ( CM_StressRandom( seed ) < 0.5f ) {
+				c->angles[YAW] = CM_StressRandom( seed ) * 360.0f;
+			}
+		}
+		break;
+	case STRESS_TEMPBOX_TRACE:
+		// a bounding box or capsule somewhere on the trace line
+		for ( i = 0; i < 3; i++ ) {
+			c->origin[i] = c->start[i] + CM_StressRandom( seed ) * delta[i];
+			c->boxMins[i] = -8.0f - CM_StressRandom( seed ) * 24.0f;
+			c->boxMaxs[i] = 8.0f + CM_StressRandom( seed ) * 40.0f;
+		}
+		c->capsule = CM_StressRandom( seed ) < 0.25f;
+		break;
+	default:
+		break;
+	}
+}
+
+
+/*
+==================
+CM_StressStoreTrace
+==================
+*/
+static void CM_StressStoreTrace( stressResult_t *r, const trace_t *tr ) {
+	r->allsolid = tr->allsolid;
+	r->startsolid = tr->startsolid;
+	r->fraction = tr->fraction;
+	VectorCopy( tr->endpos, r->endpos );
+	VectorCopy( tr->plane.normal, r->normal );
+	r->dist = tr->plane.dist;
+	r->surfaceFlags = tr->surfaceFlags;
+	r->contents = tr->contents;
+}
+
+
+/*
+==================
+CM_StressRun
+==================
+*/
+static void CM_StressRun( const stressCase_t *c, stressResult_t *r ) {
+	int leafs[STRESS_MAX_LEAFS];
+	vec3_t mins, maxs;
+	clipHandle_t h;
+	trace_t tr;
+	int i;
+
+	Com_Memset( r, 0, sizeof( *r ) );
+
+	switch ( c->type ) {
+	case STRESS_BOX_TRACE:
+	case STRESS_POINT_TRACE:
+	case STRESS_CAPSULE_TRACE:
+	case STRESS_POSITION_TEST:
+		CM_BoxTrace( &tr, c->start, c->end, c->mins, c->maxs, 0, STRESS_MASK, c->capsule );
+		CM_StressStoreTrace( r, &tr );
+		break;
+
+	case STRESS_MODEL_TRACE:
+		CM_TransformedBoxTrace( &tr, c->start, c->end, c->mins, c->maxs, c->model,
+			STRESS_MASK, c->origin, c->angles, qfalse );
+		CM_StressStoreTrace( r, &tr );
+		break;
+
+	case STRESS_TEMPBOX_TRACE:
+		h = CM_TempBoxModel( c->boxMins, c->boxMaxs, c->capsule );
+		CM_SetTempBoxModelContents( CONTENTS_BODY );
+		CM_TransformedBoxTrace( &tr, c->start, c->end, c->mins, c->maxs, h,
+			STRESS_MASK, c->origin, vec3_origin, qfalse );
+		CM_StressStoreTrace( r, &tr );
+		break;
+
+	case STRESS_POINT_CONTENTS:
+		r->contents = CM_PointContents( c->start, 0 );
+		break;
+
+	case STRESS_BOX_LEAFNUMS:
+		for ( i = 0; i < 3; i++ ) {
+			mins[i] = MIN( c->start[i], c->end[i] );
+			maxs[i] = MAX( c->start[i], c->end[i] );
+		}
+		r->numLeafs = CM_BoxLeafnums( mins, maxs, leafs, STRESS_MAX_LEAFS, &r->lastLeaf );
+		r->leafHash = 2166136261u;
+		for ( i = 0; i < r->numLeafs; i++ ) {
+			r->leafHash = ( r->leafHash ^ (unsigned int)leafs[i] ) * 16777619u;
+		}
+		break;
+
+	default:
+		break;
+	}
+}
+
+
+/*
+==================
+CM_StressWorker
+==================
+*/
+static void CM_StressWorker( void *arg ) {
+	stressWorker_t *w = (stressWorker_t *)arg;
+	stressResult_t result;
+	int i, n;
+
+	w->mismatches = 0;
+	w->firstMismatch = -1;
+
+	for ( i = 0; i < w->count; i++ ) {
+		n = ( w->first + i ) % STRESS_NUM_CASES;
+		CM_StressRun( &w->cases[n], &result );
+		if ( memcmp( &result, &w->reference[n], sizeof( result ) ) ) {
+			if ( !w->mismatches ) {
+				w->firstMismatch = n;
+			}
+			w->mismatches++;
+		}
+	}
+
+	CM_ThreadShutdown();
+}
+
+
+/*
+==================
+CM_StressTest
+
+Returns the number of queries which gave a different result than the
+single threaded run, or -1 if the test couldn't be run
+==================
+*/
+int CM_StressTest( int numThreads, int queriesPerThread, unsigned int seed ) {
+	stressWorker_t	workers[STRESS_MAX_THREADS];
+	sysThread_t		*threads[STRESS_MAX_THREADS];
+	stressCase_t	*cases;
+	stressResult_t	*reference;
+	stressResult_t	check;
+	int64_t			start, singleTime, multiTime;
+	int				i, mismatches;
+
+	if ( !cm.numNodes ) {
+		Com_Printf( "%s: map not loaded\n", __func__ );
+		return -1;
+	}
+
+	numThreads = MAX( 1, MIN( numThreads, STRESS_MAX_THREADS ) );
+	queriesPerThread = MAX( 1, queriesPerThread );
+
+	// workers only read these, the zone isn't thread safe anyway
+	cases = malloc( STRESS_NUM_CASES * sizeof( *cases ) );
+	reference = malloc( STRESS_NUM_CASES * sizeof( *reference ) );
+	if ( !cases || !reference ) {
+		free( cases );
+		free( reference );
+		Com_Printf( "%s: out of memory\n", __func__ );
+		return -1;
+	}
+
+	for ( i = 0; i < STRESS_NUM_CASES; i++ ) {
+		CM_StressGenerate( &cases[i], &seed );
+	}
+
+	// single threaded reference, run twice to make sure results don't
+	// depend on what was traced before
+	start = Sys_Microseconds();
+	for ( i = 0; i < STRESS_NUM_CASES; i++ ) {
+		CM_StressRun( &cases[i], &reference[i] );
+	}
+	singleTime = Sys_Microseconds() - start;
+
+	mismatches = 0;
+	for ( i = STRESS_NUM_CASES - 1; i >= 0; i-- ) {
+		CM_StressRun( &cases[i], &check );
+		if ( memcmp( &check, &reference[i], sizeof( check ) ) ) {
+			mismatches++;
+		}
+	}
+	if ( mismatches ) {
+		Com_Printf( S_COLOR_YELLOW "%s: %i queries not repeatable on a single thread\n", __func__, mismatches );
+	}
+
+	Com_Printf( "%s: %i threads x %i queries...\n", __func__, numThreads, queriesPerThread );
+
+	start = Sys_Microseconds();
+	for ( i = 0; i < numThreads; i++ ) {
+		workers[i].cases = cases;
+		workers[i].reference = reference;
+		// every thread starts somewhere else so they touch different
+		// brushes at the same time
+		workers[i].first = ( i * STRESS_NUM_CASES ) / numThreads;
+		workers[i].count = queriesPerThread;
+		threads[i] = Sys_CreateThread( CM_StressWorker, &workers[i] );
+		if ( !threads[i] ) {
+			Com_Printf( S_COLOR_YELLOW "%s: couldn't create thread %i, running it here\n", __func__, i );
+			CM_StressWorker( &workers[i] );
+		}
+	}
+	for ( i = 0; i < numThreads; i++ ) {
+		if ( threads[i] ) {
+			Sys_JoinThread( threads[i] );
+		}
+	}
+	multiTime = Sys_Microseconds() - start;
+
+	for ( i = 0; i < numThreads; i++ ) {
+		if ( workers[i].mismatches ) {
+			Com_Printf( S_COLOR_RED "thread %i: %i mismatches, first at query %i (type %i)\n", i,
+				workers[i].mismatches, workers[i].firstMismatch, cases[workers[i].firstMismatch].type );
+		}
+		mismatches += workers[i].mismatches;
+	}
+
+	Com_Printf( "single thread: %.3f usec/query\n", (double)singleTime / STRESS_NUM_CASES );
+	Com_Printf( "%i threads: %.3f usec/query, %.0f queries/sec\n", numThreads,
+		(double)multiTime / ( (double)numThreads * queriesPerThread ),
+		multiTime > 0 ? (double)numThreads * queriesPerThread * 1000000.0 / multiTime : 0.0 );
+	Com_Printf( "%i mismatches\n", mismatches );
+
+	free( cases );
+	free( reference );
+
+	return mismatches;
+}
+
+
+/*
+==================
+CM_StressTest_f
+==================
+*/
+void CM_StressTest_f( void ) {
+	int numThreads, numQueries;
+	unsigned int seed;
+
+	if ( Cmd_Argc() > 4 ) {
+		Com_Printf( "usage: cm_stress [threads] [queries per thread] [seed]\n" );
+		return;
+	}
+
+	numThreads = Cmd_Argc() > 1 ? atoi( Cmd_Argv( 1 ) ) : MAX( 2, Sys_NumCPUs() );
+	numQueries = Cmd_Argc() > 2 ? atoi( Cmd_Argv( 2 ) ) : 1000000;
+	seed = Cmd_Argc() > 3 ? (unsigned int)atoi( Cmd_Argv( 3 ) ) : 1;
+
+	CM_StressTest( numThreads, numQueries, seed );
+}
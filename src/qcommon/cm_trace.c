@@ -151,6 +151,258 @@ static float SquareRootFloat(float number) {
 }
 
 
+#ifdef CM_SIMD
+/*
+===============================================================================
+
+SIMD BRUSH SIDE TESTS
+
+Distances to four brush sides at a time. Everything the scalar loops
+compute in float is done in float lanes, everything done through
+DotProductDP in double lanes, so the distances and with them all
+decisions made on them are exactly the same.
+
+===============================================================================
+*/
+
+typedef struct {
+	__m128		size[2][3];		// tw->size, tw->offsets[signbits] picks from these
+	__m128		radius;
+	__m128d		sized[2][3];
+	__m128d		start[3];
+	__m128d		end[3];
+	__m128d		startAdd[3];	// start + sphere offset, start holds start - offset
+	__m128d		endAdd[3];
+	__m128d		offset[3];		// sphere offset
+} cmSimdWork_t;
+
+
+/*
+================
+CM_SetupSimdWork
+
+Done for each brush as tw->start and tw->sphere change within a trace
+when tracing against capsules
+================
+*/
+static void CM_SetupSimdWork( const traceWork_t *tw, cmSimdWork_t *sw ) {
+	vec3_t	startp, endp;
+	int		k;
+
+	for ( k = 0; k < 3; k++ ) {
+		sw->size[0][k] = _mm_set1_ps( tw->size[0][k] );
+		sw->size[1][k] = _mm_set1_ps( tw->size[1][k] );
+		sw->sized[0][k] = _mm_set1_pd( tw->size[0][k] );
+		sw->sized[1][k] = _mm_set1_pd( tw->size[1][k] );
+	}
+	sw->radius = _mm_set1_ps( tw->sphere.radius );
+
+	if ( tw->sphere.use ) {
+		VectorSubtract( tw->start, tw->sphere.offset, startp );
+		VectorSubtract( tw->end, tw->sphere.offset, endp );
+	} else {
+		VectorCopy( tw->start, startp );
+		VectorCopy( tw->end, endp );
+	}
+
+	for ( k = 0; k < 3; k++ ) {
+		sw->start[k] = _mm_set1_pd( startp[k] );
+		sw->end[k] = _mm_set1_pd( endp[k] );
+		sw->startAdd[k] = _mm_set1_pd( tw->start[k] + tw->sphere.offset[k] );
+		sw->endAdd[k] = _mm_set1_pd( tw->end[k] + tw->sphere.offset[k] );
+		sw->offset[k] = _mm_set1_pd( tw->sphere.offset[k] );
+	}
+}
+
+
+/*
+================
+CM_BrushSideDists
+
+Start and end distances of sides i to i + 3. The plane distance is
+adjusted for the box offsets in float when floatOffsets is set, like
+CM_TestBoxInBrush does, and in double otherwise, like
+CM_TraceThroughBrush does. d2 may be NULL.
+Returns a bit for each side the start or end point is in front of.
+================
+*/
+static int CM_BrushSideDists( const traceWork_t *tw, const cmSimdWork_t *sw, const float *planes, int stride, int i,
+								qboolean floatOffsets, double *d1, double *d2 ) {
+	__m128		n4[3], o4[3], dist4, mask4;
+	__m128d		n[3], o[3], sp[3], ep[3], dist, mask, d;
+	int			h, k, front;
+
+	for ( k = 0; k < 3; k++ ) {
+		n4[k] = _mm_loadu_ps( planes + k * stride + i );
+	}
+	dist4 = _mm_loadu_ps( planes + 3 * stride + i );
+
+	if ( tw->sphere.use ) {
+		// dist = plane->dist + tw->sphere.radius
+		dist4 = _mm_add_ps( dist4, sw->radius );
+	} else if ( floatOffsets ) {
+		// dist = plane->dist - DotProduct( tw->offsets[ plane->signbits ], plane->normal )
+		for ( k = 0; k < 3; k++ ) {
+			mask4 = _mm_cmplt_ps( n4[k], _mm_setzero_ps() );
+			o4[k] = CM_SelectPS( mask4, sw->size[0][k], sw->size[1][k] );
+		}
+		dist4 = _mm_sub_ps( dist4, CM_DotPS( o4, n4 ) );
+	}
+
+	front = 0;
+
+	for ( h = 0; h < 2; h++ ) {
+		for ( k = 0; k < 3; k++ ) {
+			n[k] = _mm_cvtps_pd( h ? _mm_movehl_ps( n4[k], n4[k] ) : n4[k] );
+		}
+		dist = _mm_cvtps_pd( h ? _mm_movehl_ps( dist4, dist4 ) : dist4 );
+
+		if ( tw->sphere.use ) {
+			// find the closest point on the capsule to the plane
+			mask = _mm_cmpgt_pd( CM_DotPD( n, sw->offset ), _mm_setzero_pd() );
+			for ( k = 0; k < 3; k++ ) {
+				sp[k] = CM_SelectPD( mask, sw->startAdd[k], sw->start[k] );
+				ep[k] = CM_SelectPD( mask, sw->endAdd[k], sw->end[k] );
+			}
+		} else {
+			if ( !floatOffsets ) {
+				// dist = plane->dist - DotProductDP( tw->offsets[ plane->signbits ], plane->normal )
+				for ( k = 0; k < 3; k++ ) {
+					mask = _mm_cmplt_pd( n[k], _mm_setzero_pd() );
+					o[k] = CM_SelectPD( mask, sw->sized[0][k], sw->sized[1][k] );
+				}
+				dist = _mm_sub_pd( dist, CM_DotPD( o, n ) );
+			}
+			for ( k = 0; k < 3; k++ ) {
+				sp[k] = sw->start[k];
+				ep[k] = sw->end[k];
+			}
+		}
+
+		d = _mm_sub_pd( CM_DotPD( sp, n ), dist );
+		_mm_storeu_pd( d1 + h * 2, d );
+		front |= _mm_movemask_pd( _mm_cmpgt_pd( d, _mm_setzero_pd() ) ) << ( h * 2 );
+
+		if ( d2 ) {
+			d = _mm_sub_pd( CM_DotPD( ep, n ), dist );
+			_mm_storeu_pd( d2 + h * 2, d );
+			front |= _mm_movemask_pd( _mm_cmpgt_pd( d, _mm_setzero_pd() ) ) << ( h * 2 );
+		}
+	}
+
+	return front;
+}
+
+
+/*
+================
+CM_TestBrushSidesSIMD
+
+Returns qfalse if the box is in front of any of the non axial sides
+================
+*/
+static qboolean CM_TestBrushSidesSIMD( const traceWork_t *tw, const cbrush_t *brush ) {
+	cmSimdWork_t	sw;
+	double			d1[CM_SIMD_WIDTH];
+	int				i, valid, stride;
+
+	if ( brush->numsides <= 6 ) {
+		return qtrue;
+	}
+
+	CM_SetupSimdWork( tw, &sw );
+	stride = CM_SIMD_PAD( brush->numsides );
+
+	// the first six planes are the axial planes, start with the block holding side 6
+	for ( i = 6 & ~( CM_SIMD_WIDTH - 1 ); i < brush->numsides; i += CM_SIMD_WIDTH ) {
+		valid = ( 1 << CM_SIMD_WIDTH ) - 1;
+		if ( i < 6 ) {
+			valid &= ~( ( 1 << ( 6 - i ) ) - 1 );
+		}
+		if ( brush->numsides - i < CM_SIMD_WIDTH ) {
+			valid &= ( 1 << ( brush->numsides - i ) ) - 1;
+		}
+
+		// if completely in front of face, no intersection
+		if ( CM_BrushSideDists( tw, &sw, brush->planes, stride, i, qtrue, d1, NULL ) & valid ) {
+			return qfalse;
+		}
+	}
+
+	return qtrue;
+}
+
+
+/*
+================
+CM_ClipBrushSidesSIMD
+
+Same as the side loops of CM_TraceThroughBrush, returns qfalse if the
+trace is completely in front of any side
+================
+*/
+static qboolean CM_ClipBrushSidesSIMD( const traceWork_t *tw, const cbrush_t *brush, float *enterFrac, float *leaveFrac,
+										cbrushside_t **leadside, qboolean *startout, qboolean *getout ) {
+	cmSimdWork_t	sw;
+	double			d1[CM_SIMD_WIDTH], d2[CM_SIMD_WIDTH];
+	int				i, k, n, stride;
+	float			f;
+
+	CM_SetupSimdWork( tw, &sw );
+	stride = CM_SIMD_PAD( brush->numsides );
+
+	for ( i = 0; i < brush->numsides; i += CM_SIMD_WIDTH ) {
+		// sides with both points behind them don't matter
+		if ( !CM_BrushSideDists( tw, &sw, brush->planes, stride, i, qfalse, d1, d2 ) ) {
+			continue;
+		}
+
+		n = MIN( CM_SIMD_WIDTH, brush->numsides - i );
+		for ( k = 0; k < n; k++ ) {
+			if ( d2[k] > 0 ) {
+				*getout = qtrue;	// endpoint is not in solid
+			}
+			if ( d1[k] > 0 ) {
+				*startout = qtrue;
+			}
+
+			// if completely in front of face, no intersection with the entire brush
+			if ( d1[k] > 0 && ( d2[k] >= SURFACE_CLIP_EPSILON || d2[k] >= d1[k] ) ) {
+				return qfalse;
+			}
+
+			// if it doesn't cross the plane, the plane isn't relevant
+			if ( d1[k] <= 0 && d2[k] <= 0 ) {
+				continue;
+			}
+
+			// crosses face
+			if ( d1[k] > d2[k] ) {	// enter
+				f = ( d1[k] - SURFACE_CLIP_EPSILON ) / ( d1[k] - d2[k] );
+				if ( f < 0 ) {
+					f = 0;
+				}
+				if ( f > *enterFrac ) {
+					*enterFrac = f;
+					*leadside = brush->sides + i + k;
+				}
+			} else {	// leave
+				f = ( d1[k] + SURFACE_CLIP_EPSILON ) / ( d1[k] - d2[k] );
+				if ( f > 1 ) {
+					f = 1;
+				}
+				if ( f < *leaveFrac ) {
+					*leaveFrac = f;
+				}
+			}
+		}
+	}
+
+	return qtrue;
+}
+#endif // CM_SIMD
+
+
 /*
 ===============================================================================
 
@@ -189,6 +441,13 @@ static void CM_TestBoxInBrush( traceWork_t *tw, const cbrush_t *brush ) {
 		return;
 	}
 
+#ifdef CM_SIMD
+	if ( brush->planes && cm_simd->integer ) {
+		if ( !CM_TestBrushSidesSIMD( tw, brush ) ) {
+			return;
+		}
+	} else
+#endif
 	if ( tw->sphere.use ) {
 		// the first six planes are the axial planes, so we only
 		// need to test the remainder
@@ -247,18 +506,18 @@ CM_TestInLeaf
 */
 static void CM_TestInLeaf( traceWork_t *tw, const cLeaf_t *leaf ) {
 	int			k;
-	int			brushnum;
+	int			brushnum, surfnum;
 	cbrush_t	*b;
 	cPatch_t	*patch;
 
 	// test box position against all brushes in the leaf
 	for (k=0 ; k<leaf->numLeafBrushes ; k++) {
 		brushnum = cm.leafbrushes[leaf->firstLeafBrush+k];
-		b = &cm.brushes[brushnum];
-		if (b->checkcount == cm.checkcount) {
+		if ( tw->check->brushes[brushnum] == tw->check->checkcount ) {
 			continue;	// already checked this brush in another leaf
 		}
-		b->checkcount = cm.checkcount;
+		tw->check->brushes[brushnum] = tw->check->checkcount;
+		b = CM_LeafBrush( brushnum );
 
 		if ( !(b->contents & tw->contents)) {
 			continue;
@@ -277,14 +536,15 @@ static void CM_TestInLeaf( traceWork_t *tw, const cLeaf_t *leaf ) {
 	if ( !cm_noCurves->integer ) {
 #endif //BSPC
 		for ( k = 0 ; k < leaf->numLeafSurfaces ; k++ ) {
-			patch = cm.surfaces[ cm.leafsurfaces[ leaf->firstLeafSurface + k ] ];
+			surfnum = cm.leafsurfaces[ leaf->firstLeafSurface + k ];
+			patch = cm.surfaces[ surfnum ];
 			if ( !patch ) {
 				continue;
 			}
-			if ( patch->checkcount == cm.checkcount ) {
+			if ( tw->check->surfaces[surfnum] == tw->check->checkcount ) {
 				continue;	// already checked this brush in another leaf
 			}
-			patch->checkcount = cm.checkcount;
+			tw->check->surfaces[surfnum] = tw->check->checkcount;
 
 			if ( !(patch->contents & tw->contents)) {
 				continue;
@@ -436,14 +696,10 @@ static void CM_PositionTest( traceWork_t *tw ) {
 	ll.storeLeafs = CM_StoreLeafs;
 	ll.lastLeaf = 0;
 	ll.overflowed = qfalse;
-
-	cm.checkcount++;
+	ll.check = NULL;
 
 	CM_BoxLeafnums_r( &ll, 0 );
 
-
-	cm.checkcount++;
-
 	// test the contents of the leafs
 	for (i=0 ; i < ll.count ; i++) {
 		CM_TestInLeaf( tw, &cm.leafs[leafs[i]] );
@@ -613,6 +869,16 @@ static void CM_TraceThroughBrush( traceWork_t *tw, const cbrush_t *brush ) {
 
 	leadside = NULL;
 
+#ifdef CM_SIMD
+	if ( brush->planes && cm_simd->integer ) {
+		if ( !CM_ClipBrushSidesSIMD( tw, brush, &enterFrac, &leaveFrac, &leadside, &startout, &getout ) ) {
+			return;
+		}
+		if ( leadside ) {
+			clipplane = leadside->plane;
+		}
+	} else
+#endif
 	if ( tw->sphere.use ) {
 		//
 		// compare the trace against all planes of the brush
@@ -775,7 +1041,7 @@ CM_TraceThroughLeaf
 */
 static void CM_TraceThroughLeaf( traceWork_t *tw, const cLeaf_t *leaf ) {
 	int k;
-	int brushnum;
+	int brushnum, surfnum;
 	cbrush_t    *brush;
 	cPatch_t    *patch;
 
@@ -787,11 +1053,11 @@ static void CM_TraceThroughLeaf( traceWork_t *tw, const cLeaf_t *leaf ) {
 	for ( k = 0 ; k < leaf->numLeafBrushes ; k++ ) {
 		brushnum = cm.leafbrushes[leaf->firstLeafBrush + k];
 
-		brush = &cm.brushes[brushnum];
-		if ( brush->checkcount == cm.checkcount ) {
+		if ( tw->check->brushes[brushnum] == tw->check->checkcount ) {
 			continue;   // already checked this brush in another leaf
 		}
-		brush->checkcount = cm.checkcount;
+		tw->check->brushes[brushnum] = tw->check->checkcount;
+		brush = CM_LeafBrush( brushnum );
 
 		if ( !( brush->contents & tw->contents ) ) {
 			continue;
@@ -830,14 +1096,15 @@ static void CM_TraceThroughLeaf( traceWork_t *tw, const cLeaf_t *leaf ) {
 	if ( !cm_noCurves->integer ) {
 #endif
 		for ( k = 0 ; k < leaf->numLeafSurfaces ; k++ ) {
-			patch = cm.surfaces[ cm.leafsurfaces[ leaf->firstLeafSurface + k ] ];
+			surfnum = cm.leafsurfaces[ leaf->firstLeafSurface + k ];
+			patch = cm.surfaces[ surfnum ];
 			if ( !patch ) {
 				continue;
 			}
-			if ( patch->checkcount == cm.checkcount ) {
+			if ( tw->check->surfaces[surfnum] == tw->check->checkcount ) {
 				continue;	// already checked this patch in another leaf
 			}
-			patch->checkcount = cm.checkcount;
+			tw->check->surfaces[surfnum] = tw->check->checkcount;
 
 			if ( !(patch->contents & tw->contents) ) {
 				continue;
@@ -1320,8 +1587,6 @@ static void CM_Trace( trace_t *results, const vec3_t start, const vec3_t end, co
 
 	cmod = CM_ClipHandleToModel( model );
 
-	cm.checkcount++;		// for multi-check avoidance
-
 	c_traces++;				// for statistics, may be zeroed
 
 	// fill in a default trace
@@ -1335,6 +1600,8 @@ static void CM_Trace( trace_t *results, const vec3_t start, const vec3_t end, co
 		return;	// map not loaded, shouldn't happen
 	}
 
+	tw.check = CM_BeginCheck();	// for multi-check avoidance
+
 	// allow NULL to be passed in for 0,0,0
 	if ( !mins ) {
 		mins = vec3_origin;
@@ -492,6 +492,7 @@ static void Cmd_Echo_f( void )
 typedef struct cmd_function_s
 {
 	struct cmd_function_s	*next;
+	struct cmd_function_s	*hashNext;
 	char					*name;
 	xcommand_t				function;
 	xcommandCompFunc_t		complete;
@@ -505,7 +506,10 @@ static	char		*cmd_argv[MAX_STRING_TOKENS];		// points into cmd_tokenized
 static	char		cmd_tokenized[BIG_INFO_STRING+MAX_STRING_TOKENS];	// will have 0 bytes inserted
 static	char		cmd_cmd[BIG_INFO_STRING]; // the original command we received (no token processing)
 
-static	cmd_function_t	*cmd_functions;		// possible commands to execute
+static	cmd_function_t	*cmd_functions;		// possible commands to execute, sorted by name
+
+#define CMD_HASH_SIZE	512
+static	cmd_function_t	*cmd_hashTable[CMD_HASH_SIZE];	// same commands, for lookups by name
 
 /*
 ============
@@ -662,41 +666,25 @@ void Cmd_Args_Sanitize( const char *separators, qboolean caplength )
 
 /*
 ============
-Cmd_TokenizeString
+Cmd_ScanTokens
 
-Parses the given string into command line tokens.
-The text is copied to a separate buffer and 0 characters
-are inserted in the appropriate place, The argv array
-will point into this temporary buffer.
+Finds the command line tokens in text without copying them.
+Tokens are separated by whitespace and comments, a
+quoted string is a single token unless ignoreQuotes is set.
 ============
 */
 // NOTE TTimo define that to track tokenization issues
 //#define TKN_DBG
-static void Cmd_TokenizeString2( const char *text_in, qboolean ignoreQuotes ) {
-	const char *text;
-	char *textOut;
-
-#ifdef TKN_DBG
-	// FIXME TTimo blunt hook to try to find the tokenization of userinfo
-	Com_DPrintf("Cmd_TokenizeString: %s\n", text_in);
-#endif
-
-	// clear previous args
-	cmd_argc = 0;
-	cmd_cmd[0] = '\0';
-
-	if ( !text_in ) {
-		return;
-	}
-
-	Q_strncpyz( cmd_cmd, text_in, sizeof( cmd_cmd ) );
+static int Cmd_ScanTokens( const char *text, cmdSpan_t *spans, int maxSpans, qboolean ignoreQuotes ) {
+	const char *base;
+	int count;
 
-	text = cmd_cmd; // read from safe-length buffer
-	textOut = cmd_tokenized;
+	base = text;
+	count = 0;
 
 	while ( 1 ) {
-		if ( cmd_argc >= ARRAY_LEN( cmd_argv ) ) {
-			return;			// this is usually something malicious
+		if ( count >= maxSpans ) {
+			return count;		// this is usually something malicious
 		}
 
 		while ( 1 ) {
@@ -705,14 +693,14 @@ static void Cmd_TokenizeString2( const char *text_in, qboolean ignoreQuotes ) {
 				text++;
 			}
 			if ( !*text ) {
-				return;			// all tokens parsed
+				return count;	// all tokens parsed
 			}
 
 			// skip // comments
 			if ( text[0] == '/' && text[1] == '/' ) {
 				// accept protocol headers (e.g. http://) in command lines that matching "*?[a-z]://" pattern
-				if ( text < cmd_cmd + 3 || text[-1] != ':' || text[-2] < 'a' || text[-2] > 'z' ) {
-					return; // all tokens parsed
+				if ( text < base + 3 || text[-1] != ':' || text[-2] < 'a' || text[-2] > 'z' ) {
+					return count; // all tokens parsed
 				}
 			}
 
@@ -722,7 +710,7 @@ static void Cmd_TokenizeString2( const char *text_in, qboolean ignoreQuotes ) {
 					text++;
 				}
 				if ( !*text ) {
-					return;		// all tokens parsed
+					return count;	// all tokens parsed
 				}
 				text += 2;
 			} else {
@@ -733,23 +721,22 @@ static void Cmd_TokenizeString2( const char *text_in, qboolean ignoreQuotes ) {
 		// handle quoted strings
 		// NOTE TTimo this doesn't handle \" escaping
 		if ( !ignoreQuotes && *text == '"' ) {
-			cmd_argv[cmd_argc] = textOut;
-			cmd_argc++;
 			text++;
+			spans[count].start = text;
 			while ( *text && *text != '"' ) {
-				*textOut++ = *text++;
+				text++;
 			}
-			*textOut++ = '\0';
+			spans[count].length = (int)( text - spans[count].start );
+			count++;
 			if ( !*text ) {
-				return;		// all tokens parsed
+				return count;	// all tokens parsed
 			}
 			text++;
 			continue;
 		}
 
 		// regular token
-		cmd_argv[cmd_argc] = textOut;
-		cmd_argc++;
+		spans[count].start = text;
 
 		// skip until whitespace, quote, or command
 		while ( *text > ' ' ) {
@@ -759,7 +746,7 @@ static void Cmd_TokenizeString2( const char *text_in, qboolean ignoreQuotes ) {
 
 			if ( text[0] == '/' && text[1] == '/' ) {
 				// accept protocol headers (e.g. http://) in command lines that matching "*?[a-z]://" pattern
-				if ( text < cmd_cmd + 3 || text[-1] != ':' || text[-2] < 'a' || text[-2] > 'z' ) {
+				if ( text < base + 3 || text[-1] != ':' || text[-2] < 'a' || text[-2] > 'z' ) {
 					break;
 				}
 			}
@@ -769,18 +756,80 @@ static void Cmd_TokenizeString2( const char *text_in, qboolean ignoreQuotes ) {
 				break;
 			}
 
-			*textOut++ = *text++;
+			text++;
 		}
 
-		*textOut++ = '\0';
+		spans[count].length = (int)( text - spans[count].start );
+		count++;
 
 		if ( !*text ) {
-			return;		// all tokens parsed
+			return count;	// all tokens parsed
 		}
 	}
 }
 
 
+/*
+============
+Cmd_TokenizeSpans
+
+Zero-copy tokenizer, follows the same rules as Cmd_TokenizeString
+but only records where each token is in text. The current command
+arguments are left untouched.
+============
+*/
+int Cmd_TokenizeSpans( const char *text, cmdSpan_t *spans, int maxSpans, qboolean ignoreQuotes ) {
+	if ( !text || maxSpans <= 0 ) {
+		return 0;
+	}
+
+	return Cmd_ScanTokens( text, spans, maxSpans, ignoreQuotes );
+}
+
+
+/*
+============
+Cmd_TokenizeString
+
+Parses the given string into command line tokens.
+The text is copied to a separate buffer and 0 characters
+are inserted in the appropriate place, The argv array
+will point into this temporary buffer.
+============
+*/
+static void Cmd_TokenizeString2( const char *text_in, qboolean ignoreQuotes ) {
+	static cmdSpan_t spans[MAX_STRING_TOKENS];
+	char *textOut;
+	int i;
+
+#ifdef TKN_DBG
+	// FIXME TTimo blunt hook to try to find the tokenization of userinfo
+	Com_DPrintf("Cmd_TokenizeString: %s\n", text_in);
+#endif
+
+	// clear previous args
+	cmd_argc = 0;
+	cmd_cmd[0] = '\0';
+
+	if ( !text_in ) {
+		return;
+	}
+
+	Q_strncpyz( cmd_cmd, text_in, sizeof( cmd_cmd ) );
+
+	// read from safe-length buffer
+	cmd_argc = Cmd_ScanTokens( cmd_cmd, spans, ARRAY_LEN( cmd_argv ), ignoreQuotes );
+
+	textOut = cmd_tokenized;
+	for ( i = 0; i < cmd_argc; i++ ) {
+		cmd_argv[i] = textOut;
+		Com_Memcpy( textOut, spans[i].start, spans[i].length );
+		textOut += spans[i].length;
+		*textOut++ = '\0';
+	}
+}
+
+
 /*
 ============
 Cmd_TokenizeString
@@ -809,7 +858,11 @@ Cmd_FindCommand
 static cmd_function_t *Cmd_FindCommand( const char *cmd_name )
 {
 	cmd_function_t *cmd;
-	for( cmd = cmd_functions; cmd; cmd = cmd->next )
+	long hash;
+
+	hash = Com_GenerateHashValue( cmd_name, CMD_HASH_SIZE );
+
+	for( cmd = cmd_hashTable[hash]; cmd; cmd = cmd->hashNext )
 		if( !Q_stricmp( cmd_name, cmd->name ) )
 			return cmd;
 	return NULL;
@@ -823,6 +876,7 @@ Cmd_AddCommand
 */
 void Cmd_AddCommand( const char *cmd_name, xcommand_t function ) {
 	cmd_function_t *cmd;
+	long hash;
 
 	// fail if the command already exists
 	cmd = Cmd_FindCommand( cmd_name );
@@ -842,6 +896,10 @@ void Cmd_AddCommand( const char *cmd_name, xcommand_t function ) {
 	cmd->init_module = MODULE_NONE;
 	cmd->modules = 0;
 
+	hash = Com_GenerateHashValue( cmd_name, CMD_HASH_SIZE );
+	cmd->hashNext = cmd_hashTable[hash];
+	cmd_hashTable[hash] = cmd;
+
 	// add the command
 	if ( cmd_functions == NULL || Q_stricmp(cmd_functions->name, cmd_name) > 0 ) {
 		// insert as the first command
@@ -899,8 +957,11 @@ Cmd_RemoveCommand
 */
 void Cmd_RemoveCommand( const char *cmd_name ) {
 	cmd_function_t *cmd, **back;
+	long hash;
+
+	hash = Com_GenerateHashValue( cmd_name, CMD_HASH_SIZE );
 
-	back = &cmd_functions;
+	back = &cmd_hashTable[hash];
 	while( 1 ) {
 		cmd = *back;
 		if ( !cmd ) {
@@ -908,12 +969,17 @@ void Cmd_RemoveCommand( const char *cmd_name ) {
 			return;
 		}
 		if ( !Q_stricmp( cmd_name, cmd->name ) ) {
-			*back = cmd->next;
-			Cmd_Free( cmd );
-			return;
+			*back = cmd->hashNext;
+			break;
 		}
-		back = &cmd->next;
+		back = &cmd->hashNext;
 	}
+
+	for ( back = &cmd_functions; *back != cmd; back = &(*back)->next )
+		;
+	*back = cmd->next;
+
+	Cmd_Free( cmd );
 }
 
 
@@ -981,16 +1047,16 @@ Cmd_CompleteArgument
 qboolean Cmd_CompleteArgument( const char *command, char *args, int argNum ) {
 	const cmd_function_t *cmd;
 
-	for( cmd = cmd_functions; cmd; cmd = cmd->next ) {
-		if ( !Q_stricmp( command, cmd->name ) ) {
-			if ( cmd->complete ) {
-				cmd->complete( args, argNum );
-			}
-			return qtrue;
-		}
+	cmd = Cmd_FindCommand( command );
+	if ( !cmd ) {
+		return qfalse;
+	}
+
+	if ( cmd->complete ) {
+		cmd->complete( args, argNum );
 	}
 
-	return qfalse;
+	return qtrue;
 }
 
 
@@ -1002,7 +1068,7 @@ A complete command line has been parsed, so try to execute it
 ============
 */
 void Cmd_ExecuteString( const char *text ) {
-	cmd_function_t *cmd, **prev;
+	const cmd_function_t *cmd;
 
 	// execute the command line
 	Cmd_TokenizeString( text );
@@ -1010,25 +1076,12 @@ void Cmd_ExecuteString( const char *text ) {
 		return;		// no tokens
 	}
 
-	// check registered command functions
-	for ( prev = &cmd_functions ; *prev ; prev = &cmd->next ) {
-		cmd = *prev;
-		if ( !Q_stricmp( cmd_argv[0], cmd->name ) ) {
-			// rearrange the links so that the command will be
-			// near the head of the list next time it is used
-			*prev = cmd->next;
-			cmd->next = cmd_functions;
-			cmd_functions = cmd;
-
-			// perform the action
-			if ( !cmd->function ) {
-				// let the cgame or game handle it
-				break;
-			} else {
-				cmd->function();
-			}
-			return;
-		}
+	// check registered command functions, commands
+	// without a function are left to the cgame or game
+	cmd = Cmd_FindCommand( cmd_argv[0] );
+	if ( cmd && cmd->function ) {
+		cmd->function();
+		return;
 	}
 
 	// check cvars
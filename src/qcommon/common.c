@@ -65,8 +65,6 @@ static jmp_buf abortframe;	// an ERR_DROP occurred, exit the entire frame
 int		CPU_Flags = 0;
 
 static fileHandle_t logfile = FS_INVALID_HANDLE;
-static fileHandle_t com_journalFile = FS_INVALID_HANDLE ; // events are written here
-fileHandle_t com_journalDataFile = FS_INVALID_HANDLE; // config files are written here
 
 cvar_t	*com_crashed = NULL;        // ydnar: set in case of a crash, prevents CVAR_UNSAFE variables from being set from a cfg
 //bani - explicit NULL to make win32 teh happy
@@ -271,6 +269,10 @@ static int FORMAT_PRINTF(2, 0) QDECL Com_VPrintf( qboolean devPrint, const char
 					// data even if we are crashing
 					FS_ForceFlush( logfile );
 				}
+
+				// written from a background thread unless com_logAsync is off,
+				// exit and crash paths flush it through Com_LogFlush
+				FS_SetAsyncLog( logfile );
 			} else {
 				Com_Printf( S_COLOR_YELLOW "Opening %s failed!\n", logName );
 				Cvar_Set( "logfile", "0" );
@@ -392,6 +394,7 @@ void NORETURN FORMAT_PRINTF(2, 3) QDECL Com_Error( errorParm_t code, const char
 		VM_Forced_Unload_Done();
 
 		// make sure we can get at our local stuff
+		FS_FlushBSP();
 		FS_PureServerSetLoadedPaks( "", "" );
 		com_errorEntered = qfalse;
 
@@ -408,6 +411,7 @@ void NORETURN FORMAT_PRINTF(2, 3) QDECL Com_Error( errorParm_t code, const char
 #endif
 		VM_Forced_Unload_Done();
 
+		FS_FlushBSP();
 		FS_PureServerSetLoadedPaks( "", "" );
 		com_errorEntered = qfalse;
 
@@ -1015,6 +1019,7 @@ all big things are allocated on the hunk.
 
 #define USE_STATIC_TAGS
 #define USE_TRASH_TEST
+#define USE_ZONE_SLABS // small allocations from size-class slabs
 
 #ifdef ZONE_DEBUG
 typedef struct zonedebug_s {
@@ -1341,6 +1346,295 @@ static void MergeBlock( memblock_t *curr_free, const memblock_t *next )
 }
 
 
+#ifdef USE_ZONE_SLABS
+/*
+==============================================================================
+
+Allocations of up to SLAB_MAX_SIZE bytes come from slabs of equal sized
+slots instead of the block list, one set of slabs per size class. Slots
+keep a memblock_t header with their own id, so Z_Free and the trash test
+work the same, allocated slots are linked per tag for Z_FreeTags.
+
+Slab pages are carved from 2MB chunks of the main zone, static blocks
+that are never freed, so slabs count against com_zoneMegs like any other
+allocation. A page that becomes empty goes back to a shared pool unless
+it is the last one with free slots in its class.
+
+==============================================================================
+*/
+
+#define SLABID			0x1d4a12
+#define SLAB_MAX_SIZE	256
+#define SLAB_PAGE_SIZE	( 64 * 1024 )
+#define SLAB_CHUNK_SIZE	( 1 << 21 )
+#define SLAB_CLASSES	8
+
+typedef struct slabPage_s {
+	struct slabPage_s	*next, *prev;		// pages of the class, or the pool
+	struct slabPage_s	*nextPartial, *prevPartial;
+	struct slabClass_s	*cls;
+	memblock_t			*free;				// free slots, linked through next
+	int					used;
+	int					capacity;
+} slabPage_t;
+
+typedef struct slabClass_s {
+	int			payload;			// largest allocation
+	int			size;				// slot size, header and trash tester included
+	slabPage_t	*pages;
+	slabPage_t	*partial;			// pages with free slots
+	int			numPages;
+	int			used;				// slots in use
+} slabClass_t;
+
+static slabClass_t slabClasses[ SLAB_CLASSES ] = {
+	{ 16 }, { 32 }, { 48 }, { 64 }, { 96 }, { 128 }, { 192 }, { 256 }
+};
+
+// size class for each 16 byte step of the allocation size
+static byte slabClassIndex[ SLAB_MAX_SIZE / 16 + 1 ];
+
+static struct {
+	qboolean	initialized;
+	qboolean	enabled;
+	memblock_t	tags[ TAG_COUNT ];	// allocated slots of each tag
+	slabPage_t	*pool;				// empty pages
+	int			poolPages;
+	int			chunks;
+} slab;
+
+
+/*
+================
+Z_InitSlabs
+================
+*/
+static void Z_InitSlabs( void ) {
+	slabClass_t *cls;
+	int i, c;
+
+	for ( i = 0; i < TAG_COUNT; i++ ) {
+		slab.tags[i].next = slab.tags[i].prev = &slab.tags[i];
+	}
+
+	for ( c = 0; c < SLAB_CLASSES; c++ ) {
+		cls = &slabClasses[c];
+		cls->size = sizeof( memblock_t ) + cls->payload;
+#ifdef USE_TRASH_TEST
+		cls->size += 4;
+#endif
+		cls->size = PAD( cls->size, sizeof( intptr_t ) );
+	}
+
+	for ( i = 0, c = 0; i <= SLAB_MAX_SIZE / 16; i++ ) {
+		while ( slabClasses[c].payload < i * 16 ) {
+			c++;
+		}
+		slabClassIndex[i] = c;
+	}
+
+	slab.initialized = qtrue;
+	slab.enabled = qtrue;
+}
+
+
+/*
+================
+Z_NewSlabPage
+================
+*/
+static slabPage_t *Z_NewSlabPage( slabClass_t *cls ) {
+	slabPage_t *page;
+	memblock_t *block;
+	byte *base, *chunk;
+	int i;
+
+	if ( !slab.pool ) {
+		chunk = Z_TagMalloc( SLAB_CHUNK_SIZE + SLAB_PAGE_SIZE, TAG_STATIC );
+		// pages are aligned so a slot finds its page from its address
+		base = (byte *)PADP( chunk, SLAB_PAGE_SIZE );
+		for ( i = 0; i < SLAB_CHUNK_SIZE / SLAB_PAGE_SIZE; i++ ) {
+			page = (slabPage_t *)( base + i * SLAB_PAGE_SIZE );
+			page->next = slab.pool;
+			slab.pool = page;
+			slab.poolPages++;
+		}
+		slab.chunks++;
+	}
+
+	page = slab.pool;
+	slab.pool = page->next;
+	slab.poolPages--;
+
+	page->cls = cls;
+	page->used = 0;
+	page->capacity = ( SLAB_PAGE_SIZE - PAD( sizeof( *page ), 16 ) ) / cls->size;
+
+	// thread the free list in address order
+	page->free = NULL;
+	base = (byte *)page + PAD( sizeof( *page ), 16 );
+	for ( i = page->capacity - 1; i >= 0; i-- ) {
+		block = (memblock_t *)( base + i * cls->size );
+		block->next = page->free;
+		block->prev = NULL;
+		block->size = cls->size;
+		block->tag = TAG_FREE;
+		block->id = SLABID;
+		page->free = block;
+	}
+
+	page->prev = NULL;
+	page->next = cls->pages;
+	if ( cls->pages ) {
+		cls->pages->prev = page;
+	}
+	cls->pages = page;
+
+	page->prevPartial = NULL;
+	page->nextPartial = cls->partial;
+	if ( cls->partial ) {
+		cls->partial->prevPartial = page;
+	}
+	cls->partial = page;
+
+	cls->numPages++;
+
+	return page;
+}
+
+
+/*
+================
+Z_UnlinkPartial
+================
+*/
+static void Z_UnlinkPartial( slabClass_t *cls, slabPage_t *page ) {
+	if ( page->prevPartial ) {
+		page->prevPartial->nextPartial = page->nextPartial;
+	} else {
+		cls->partial = page->nextPartial;
+	}
+	if ( page->nextPartial ) {
+		page->nextPartial->prevPartial = page->prevPartial;
+	}
+	page->nextPartial = page->prevPartial = NULL;
+}
+
+
+/*
+================
+Z_SlabAlloc
+================
+*/
+static memblock_t *Z_SlabAlloc( int size, memtag_t tag ) {
+	slabClass_t *cls;
+	slabPage_t *page;
+	memblock_t *block, *head;
+
+	cls = &slabClasses[ slabClassIndex[ ( size + 15 ) >> 4 ] ];
+
+	page = cls->partial;
+	if ( !page ) {
+		page = Z_NewSlabPage( cls );
+	}
+
+	block = page->free;
+	page->free = block->next;
+	if ( ++page->used == page->capacity ) {
+		Z_UnlinkPartial( cls, page );
+	}
+	cls->used++;
+
+	head = &slab.tags[ tag ];
+	block->prev = head;
+	block->next = head->next;
+	head->next->prev = block;
+	head->next = block;
+
+	block->tag = tag;
+	block->id = SLABID;
+
+#ifdef USE_TRASH_TEST
+	*(int *)((byte *)block + block->size - 4) = ZONEID;
+#endif
+
+	return block;
+}
+
+
+/*
+================
+Z_SlabFree
+================
+*/
+static void Z_SlabFree( memblock_t *block ) {
+	slabClass_t *cls;
+	slabPage_t *page;
+
+	page = (slabPage_t *)( (intptr_t)block & ~(intptr_t)( SLAB_PAGE_SIZE - 1 ) );
+	cls = page->cls;
+
+	block->prev->next = block->next;
+	block->next->prev = block->prev;
+
+	Com_Memset( block + 1, 0xaa, block->size - sizeof( *block ) );
+
+	block->tag = TAG_FREE;
+	block->prev = NULL;
+	block->next = page->free;
+	page->free = block;
+
+	cls->used--;
+	if ( page->used-- == page->capacity ) {
+		page->prevPartial = NULL;
+		page->nextPartial = cls->partial;
+		if ( cls->partial ) {
+			cls->partial->prevPartial = page;
+		}
+		cls->partial = page;
+	}
+
+	// keep one page with free slots around
+	if ( page->used == 0 && ( page->nextPartial || page->prevPartial ) ) {
+		Z_UnlinkPartial( cls, page );
+		if ( page->prev ) {
+			page->prev->next = page->next;
+		} else {
+			cls->pages = page->next;
+		}
+		if ( page->next ) {
+			page->next->prev = page->prev;
+		}
+		cls->numPages--;
+
+		page->next = slab.pool;
+		slab.pool = page;
+		slab.poolPages++;
+	}
+}
+
+
+/*
+================
+Z_SlabFreeTags
+================
+*/
+static int Z_SlabFreeTags( memtag_t tag ) {
+	memblock_t *head;
+	int count;
+
+	head = &slab.tags[ tag ];
+	count = 0;
+	while ( head->next != head ) {
+		Z_SlabFree( head->next );
+		count++;
+	}
+
+	return count;
+}
+#endif // USE_ZONE_SLABS
+
+
 /*
 ========================
 Z_Free
@@ -1350,12 +1644,18 @@ void Z_Free( void *ptr ) {
 	memblock_t	*block, *other;
 	memzone_t *zone;
 
+	Com_AssertMainThread( "Z_Free" );
+
 	if (!ptr) {
 		Com_Error( ERR_DROP, "Z_Free: NULL pointer" );
 	}
 
 	block = (memblock_t *) ( (byte *)ptr - sizeof(memblock_t));
+#ifdef USE_ZONE_SLABS
+	if (block->id != ZONEID && block->id != SLABID) {
+#else
 	if (block->id != ZONEID) {
+#endif
 		Com_Error( ERR_FATAL, "Z_Free: freed a pointer without ZONEID" );
 	}
 
@@ -1377,6 +1677,13 @@ void Z_Free( void *ptr ) {
 	}
 #endif
 
+#ifdef USE_ZONE_SLABS
+	if ( block->id == SLABID ) {
+		Z_SlabFree( block );
+		return;
+	}
+#endif
+
 	if ( block->tag == TAG_SMALL ) {
 		zone = smallzone;
 	} else {
@@ -1446,6 +1753,11 @@ int Z_FreeTags( memtag_t tag ) {
 	}
 
 	count = 0;
+#ifdef USE_ZONE_SLABS
+	if ( slab.initialized ) {
+		count = Z_SlabFreeTags( tag );
+	}
+#endif
 	for ( block = zone->blocklist.next ; ; ) {
 		if ( block->tag == tag && block->id == ZONEID ) {
 			if ( block->prev->tag == TAG_FREE )
@@ -1466,6 +1778,39 @@ int Z_FreeTags( memtag_t tag ) {
 }
 
 
+// every 16th allocation is timed for meminfo
+#define ZONE_SAMPLE_MASK	15
+
+typedef struct {
+	int			samples;
+	int64_t		total;			// usec
+	int			max;
+} allocLatency_t;
+
+static struct {
+	unsigned int	allocs;
+	allocLatency_t	slab;
+	allocLatency_t	zone;
+} zoneLatency;
+
+
+/*
+================
+Z_SampleLatency
+================
+*/
+static void Z_SampleLatency( allocLatency_t *latency, int64_t start ) {
+	int usec;
+
+	usec = (int)( Sys_Microseconds() - start );
+	latency->samples++;
+	latency->total += usec;
+	if ( usec > latency->max ) {
+		latency->max = usec;
+	}
+}
+
+
 /*
 ================
 Z_TagMalloc
@@ -1483,6 +1828,9 @@ void *Z_TagMalloc( int size, memtag_t tag ) {
 #endif
 	memblock_t *base;
 	memzone_t *zone;
+	int64_t	sampleStart;
+
+	Com_AssertMainThread( "Z_TagMalloc" );
 
 	if ( tag == TAG_FREE ) {
 		Com_Error( ERR_FATAL, "Z_TagMalloc: tried to use with TAG_FREE" );
@@ -1498,6 +1846,24 @@ void *Z_TagMalloc( int size, memtag_t tag ) {
 	allocSize = size;
 #endif
 
+	sampleStart = ( ++zoneLatency.allocs & ZONE_SAMPLE_MASK ) ? 0 : Sys_Microseconds();
+
+#ifdef USE_ZONE_SLABS
+	if ( (unsigned)size <= SLAB_MAX_SIZE && slab.enabled ) {
+		base = Z_SlabAlloc( size, tag );
+#ifdef ZONE_DEBUG
+		base->d.label = label;
+		base->d.file = file;
+		base->d.line = line;
+		base->d.allocSize = allocSize;
+#endif
+		if ( sampleStart ) {
+			Z_SampleLatency( &zoneLatency.slab, sampleStart );
+		}
+		return (void *) ( base + 1 );
+	}
+#endif
+
 #ifdef USE_MULTI_SEGMENT
 	if ( size < (sizeof( freeblock_t ) ) ) {
 		size = (sizeof( freeblock_t ) );
@@ -1586,6 +1952,10 @@ void *Z_TagMalloc( int size, memtag_t tag ) {
 	*(int *)((byte *)base + base->size - 4) = ZONEID;
 #endif
 
+	if ( sampleStart ) {
+		Z_SampleLatency( &zoneLatency.zone, sampleStart );
+	}
+
 	return (void *) ( base + 1 );
 }
 
@@ -1729,6 +2099,50 @@ static void Z_LogZoneHeap( memzone_t *zone, const char *name ) {
 }
 
 
+#ifdef USE_ZONE_SLABS
+/*
+========================
+Z_LogSlabHeap
+========================
+*/
+static void Z_LogSlabHeap( void ) {
+	const memblock_t *head, *block;
+	char	buf[4096];
+	int		size, allocSize, numBlocks;
+	int		len, tag;
+
+	if ( logfile == FS_INVALID_HANDLE || !FS_Initialized() || !slab.initialized )
+		return;
+
+	size = allocSize = numBlocks = 0;
+	len = Com_sprintf( buf, sizeof(buf), "\r\n================\r\nSLAB log\r\n================\r\n" );
+	FS_Write( buf, len, logfile );
+	for ( tag = 0; tag < TAG_COUNT; tag++ ) {
+		head = &slab.tags[ tag ];
+		for ( block = head->next; block != head; block = block->next ) {
+#ifdef ZONE_DEBUG
+			len = Com_sprintf( buf, sizeof(buf), "size = %8d: %s, line: %d (%s) tag %i\r\n", block->d.allocSize, block->d.file, block->d.line, block->d.label, tag );
+			FS_Write( buf, len, logfile );
+			allocSize += block->d.allocSize;
+#endif
+			size += block->size;
+			numBlocks++;
+		}
+	}
+#ifndef ZONE_DEBUG
+	allocSize = numBlocks * sizeof(memblock_t);
+#else
+	allocSize = size - allocSize;
+#endif
+	len = Com_sprintf( buf, sizeof( buf ), "%d SLAB memory in %d blocks\r\n", size, numBlocks );
+	FS_Write( buf, len, logfile );
+	len = Com_sprintf( buf, sizeof( buf ), "%d SLAB memory overhead\r\n", allocSize );
+	FS_Write( buf, len, logfile );
+	FS_Flush( logfile );
+}
+#endif
+
+
 /*
 ========================
 Z_LogHeap
@@ -1737,6 +2151,9 @@ Z_LogHeap
 void Z_LogHeap( void ) {
 	Z_LogZoneHeap( mainzone, "MAIN" );
 	Z_LogZoneHeap( smallzone, "SMALL" );
+#ifdef USE_ZONE_SLABS
+	Z_LogSlabHeap();
+#endif
 }
 
 #ifdef USE_STATIC_TAGS
@@ -1857,6 +2274,22 @@ static	hunkUsed_t	*hunk_permanent, *hunk_temp;
 static	byte	*s_hunkData = NULL;
 static	int		s_hunkTotal;
 
+// the hunk and main zone come straight from the system pages
+typedef struct {
+	byte		*base;
+	size_t		size;
+	pageKind_t	kind;
+	size_t		pageSize;
+	int			prefaultThreads;	// 0 if left to page faults
+	int64_t		prefaultTime;		// usec
+} memRegion_t;
+
+#define	MAX_PREFAULT_THREADS	16
+
+static	cvar_t		*com_hugePages;
+static	cvar_t		*com_prefault;
+static	memRegion_t	zoneRegion, hunkRegion;
+
 static const char *tagName[ TAG_COUNT ] = {
 	"FREE",
 	"GENERAL",
@@ -1954,6 +2387,102 @@ static void Zone_Stats( const char *name, const memzone_t *z, qboolean printDeta
 }
 
 
+/*
+=================
+Zone_Fragmentation
+
+Share of free memory that is not in the largest free block
+=================
+*/
+static float Zone_Fragmentation( const zone_stats_t *st ) {
+	if ( st->freeBytes <= 0 ) {
+		return 0.0f;
+	}
+	return 100.0f * ( st->freeBytes - st->freeLargest ) / st->freeBytes;
+}
+
+
+#ifdef USE_ZONE_SLABS
+/*
+=================
+Slab_Stats
+=================
+*/
+static void Slab_Stats( qboolean printDetails ) {
+	const slabClass_t *cls;
+	const memblock_t *head, *block;
+	int pages, slots, used, usedBytes;
+	int tagBytes[ TAG_COUNT ];
+	int c, tag;
+
+	if ( !slab.initialized ) {
+		return;
+	}
+
+	pages = slots = used = usedBytes = 0;
+	for ( c = 0; c < SLAB_CLASSES; c++ ) {
+		const slabPage_t *page;
+		int capacity = 0;
+
+		cls = &slabClasses[c];
+		for ( page = cls->pages; page; page = page->next ) {
+			capacity += page->capacity;
+		}
+		if ( printDetails ) {
+			Com_Printf( "slab %3i bytes: %6i of %6i slots in %4i pages\n", cls->payload, cls->used, capacity, cls->numPages );
+		}
+		pages += cls->numPages;
+		slots += capacity;
+		used += cls->used;
+		usedBytes += cls->used * cls->size;
+	}
+
+	Com_Memset( tagBytes, 0, sizeof( tagBytes ) );
+	for ( tag = 0; tag < TAG_COUNT; tag++ ) {
+		head = &slab.tags[ tag ];
+		for ( block = head->next; block != head; block = block->next ) {
+			tagBytes[ tag ] += block->size;
+		}
+	}
+
+	Com_Printf( "\n%9i bytes (%6.2f MB) total slabs in %i main zone chunks\n\n", slab.chunks * SLAB_CHUNK_SIZE,
+		slab.chunks * SLAB_CHUNK_SIZE / Square( 1024.f ), slab.chunks );
+	Com_Printf( "%9i bytes (%6.2f MB) in %i slab slots, %i pages\n", usedBytes, usedBytes / Square( 1024.f ), used, pages );
+	Com_Printf( "        %9i bytes (%6.2f MB) small\n", tagBytes[ TAG_SMALL ], tagBytes[ TAG_SMALL ] / Square( 1024.f ) );
+	Com_Printf( "        %9i bytes (%6.2f MB) in parser/lexer\n", tagBytes[ TAG_BOTLIB ], tagBytes[ TAG_BOTLIB ] / Square( 1024.f ) );
+	Com_Printf( "        %9i bytes (%6.2f MB) in renderer\n", tagBytes[ TAG_RENDERER ], tagBytes[ TAG_RENDERER ] / Square( 1024.f ) );
+	Com_Printf( "        %8i free slots in used pages (%.1f%% unused), %i pages pooled\n", slots - used,
+		slots ? 100.0f * ( slots - used ) / slots : 0.0f, slab.poolPages );
+}
+#endif
+
+
+/*
+=================
+Com_RegionInfo
+=================
+*/
+static void Com_RegionInfo( const char *name, const memRegion_t *region ) {
+	static const char *kinds[] = { "", " transparent huge", " huge" };
+
+	int64_t huge;
+
+	Com_Printf( "        %s in %i KB%s pages", name, (int)( region->pageSize / 1024 ), kinds[ region->kind ] );
+	if ( region->kind == PAGES_TRANSPARENT ) {
+		huge = Sys_HugePageBytes( region->base, region->size );
+		if ( huge >= 0 ) {
+			Com_Printf( " (%.1f%% backed)", 100.0 * huge / region->size );
+		}
+	}
+	if ( region->prefaultThreads ) {
+		Com_Printf( ", prefaulted in %.1f msec on %i thread%s\n", region->prefaultTime / 1000.0,
+			region->prefaultThreads, region->prefaultThreads > 1 ? "s" : "" );
+	} else {
+		Com_Printf( "\n" );
+	}
+}
+
+
 /*
 =================
 Com_Meminfo_f
@@ -1964,6 +2493,7 @@ static void Com_Meminfo_f( void ) {
 	int		unused;
 
 	Com_Printf( "%9i bytes (%6.2f MB) total hunk\n", s_hunkTotal, s_hunkTotal / Square( 1024.f ) );
+	Com_RegionInfo( "hunk", &hunkRegion );
 	Com_Printf( "\n" );
 	Com_Printf( "%9i bytes (%6.2f MB) low mark\n", hunk_low.mark, hunk_low.mark / Square( 1024.f ) );
 	Com_Printf( "%9i bytes (%6.2f MB) low permanent\n", hunk_low.permanent, hunk_low.permanent / Square( 1024.f ) );
@@ -1991,7 +2521,9 @@ static void Com_Meminfo_f( void ) {
 	Com_Printf( "\n" );
 
 	Zone_Stats( "main", mainzone, !Q_stricmp( Cmd_Argv(1), "main" ) || !Q_stricmp( Cmd_Argv(1), "all" ), &st );
-	Com_Printf( "%9i bytes (%6.2f MB) total main zone\n\n", mainzone->size, mainzone->size / Square( 1024.f ) );
+	Com_Printf( "%9i bytes (%6.2f MB) total main zone\n", mainzone->size, mainzone->size / Square( 1024.f ) );
+	Com_RegionInfo( "zone", &zoneRegion );
+	Com_Printf( "\n" );
 	Com_Printf( "%9i bytes (%6.2f MB) in %i main zone blocks%s\n", st.zoneBytes, st.zoneBytes / Square( 1024.f ), st.zoneBlocks,
 		st.zoneSegments > 1 ? va( " and %i segments", st.zoneSegments ) : "" );
 	Com_Printf( "        %9i bytes (%6.2f MB) in parser/lexer\n", st.botlibBytes, st.botlibBytes / Square( 1024.f ) );
@@ -1999,7 +2531,8 @@ static void Com_Meminfo_f( void ) {
 	Com_Printf( "        %9i bytes (%6.2f MB) in other\n", st.zoneBytes - ( st.botlibBytes + st.rendererBytes ), ( st.zoneBytes - ( st.botlibBytes + st.rendererBytes ) ) / Square( 1024.f ) );
 	Com_Printf( "        %8i bytes (%6.2f MB) in %i free blocks\n", st.freeBytes, st.freeBytes / Square( 1024.f ), st.freeBlocks );
 	if ( st.freeBlocks > 1 ) {
-		Com_Printf( "        (largest: %i bytes, smallest: %i bytes)\n\n", st.freeLargest, st.freeSmallest );
+		Com_Printf( "        (largest: %i bytes, smallest: %i bytes, %.1f%% fragmented)\n\n", st.freeLargest, st.freeSmallest,
+			Zone_Fragmentation( &st ) );
 	}
 
 	Zone_Stats( "small", smallzone, !Q_stricmp( Cmd_Argv(1), "small" ) || !Q_stricmp( Cmd_Argv(1), "all" ), &st );
@@ -2008,8 +2541,178 @@ static void Com_Meminfo_f( void ) {
 		st.zoneSegments > 1 ? va( " and %i segments", st.zoneSegments ) : "" );
 	Com_Printf( "        %8i bytes in %i free blocks\n", st.freeBytes, st.freeBlocks );
 	if ( st.freeBlocks > 1 ) {
-		Com_Printf( "        (largest: %i bytes, smallest: %i bytes)\n\n", st.freeLargest, st.freeSmallest );
+		Com_Printf( "        (largest: %i bytes, smallest: %i bytes, %.1f%% fragmented)\n\n", st.freeLargest, st.freeSmallest,
+			Zone_Fragmentation( &st ) );
 	}
+
+#ifdef USE_ZONE_SLABS
+	Slab_Stats( !Q_stricmp( Cmd_Argv(1), "slab" ) || !Q_stricmp( Cmd_Argv(1), "all" ) );
+#endif
+
+	Com_Printf( "\nallocation time, 1 in %i sampled:\n", ZONE_SAMPLE_MASK + 1 );
+#ifdef USE_ZONE_SLABS
+	Com_Printf( "        slabs: %.3f usec average, %i usec worst\n",
+		zoneLatency.slab.total / (double)MAX( zoneLatency.slab.samples, 1 ), zoneLatency.slab.max );
+#endif
+	Com_Printf( "        zone:  %.3f usec average, %i usec worst\n",
+		zoneLatency.zone.total / (double)MAX( zoneLatency.zone.samples, 1 ), zoneLatency.zone.max );
+}
+
+
+/*
+=================
+Com_ZoneBenchRandom
+=================
+*/
+static unsigned int Com_ZoneBenchRandom( unsigned int *seed ) {
+	*seed = *seed * 1103515245u + 12345u;
+	return ( *seed >> 16 ) & 0x7fff;
+}
+
+
+typedef struct {
+	int		slot;
+	int		size;		// 0 frees the slot
+} zoneTraceOp_t;
+
+/*
+=================
+Com_ZoneBenchTrace
+
+Synthetic allocation trace shaped like a long running server: mostly
+short strings and small structures, some larger buffers, a fifth of
+everything kept until the end
+=================
+*/
+static int Com_ZoneBenchTrace( zoneTraceOp_t *ops, int numOps, unsigned int seed, int *numSlots ) {
+	int		*live;
+	int		numLive, slots, i, n, r;
+
+	live = malloc( numOps * sizeof( *live ) );
+	numLive = slots = 0;
+
+	for ( i = 0; i < numOps; i++ ) {
+		if ( numLive == 0 || Com_ZoneBenchRandom( &seed ) % 100 < 52 ) {
+			r = Com_ZoneBenchRandom( &seed ) % 100;
+			if ( r < 50 ) {
+				ops[i].size = 8 + Com_ZoneBenchRandom( &seed ) % 40;
+			} else if ( r < 80 ) {
+				ops[i].size = 48 + Com_ZoneBenchRandom( &seed ) % 208;
+			} else if ( r < 95 ) {
+				ops[i].size = 256 + Com_ZoneBenchRandom( &seed ) % 1792;
+			} else {
+				ops[i].size = 2048 + Com_ZoneBenchRandom( &seed ) % 14336;
+			}
+			ops[i].slot = slots++;
+			if ( Com_ZoneBenchRandom( &seed ) % 5 ) {
+				live[ numLive++ ] = ops[i].slot;
+			}
+		} else {
+			n = ( Com_ZoneBenchRandom( &seed ) << 15 | Com_ZoneBenchRandom( &seed ) ) % numLive;
+			ops[i].slot = live[n];
+			ops[i].size = 0;
+			live[n] = live[ --numLive ];
+		}
+	}
+
+	free( live );
+
+	*numSlots = slots;
+	return numOps;
+}
+
+
+/*
+=================
+Com_ZoneBenchReplay
+=================
+*/
+static int64_t Com_ZoneBenchReplay( const zoneTraceOp_t *ops, int numOps, void **slots, int numSlots, zone_stats_t *st ) {
+	int64_t start, total;
+	int i;
+
+	Com_Memset( slots, 0, numSlots * sizeof( slots[0] ) );
+
+	start = Sys_Microseconds();
+	for ( i = 0; i < numOps; i++ ) {
+		if ( ops[i].size ) {
+			slots[ ops[i].slot ] = Z_TagMalloc( ops[i].size, TAG_GENERAL );
+		} else {
+			Z_Free( slots[ ops[i].slot ] );
+			slots[ ops[i].slot ] = NULL;
+		}
+	}
+	total = Sys_Microseconds() - start;
+
+	// what the long lived allocations left behind
+	Zone_Stats( "main", mainzone, qfalse, st );
+
+	for ( i = 0; i < numSlots; i++ ) {
+		if ( slots[i] ) {
+			Z_Free( slots[i] );
+		}
+	}
+
+	return total;
+}
+
+
+/*
+=================
+Com_ZoneBench_f
+
+Replays a synthetic allocation trace through the zone with and
+without slabs
+=================
+*/
+static void Com_ZoneBench_f( void ) {
+	zoneTraceOp_t	*ops;
+	void			**slots;
+	zone_stats_t	before, zoneOnly, slabs;
+	int64_t			zoneTime, slabTime;
+	unsigned int	seed;
+	int				numOps, numSlots;
+
+	numOps = Cmd_Argc() > 1 ? atoi( Cmd_Argv( 1 ) ) : 1000000;
+	seed = Cmd_Argc() > 2 ? atoi( Cmd_Argv( 2 ) ) : 1;
+	if ( numOps <= 0 ) {
+		Com_Printf( "Usage: zonebench [operations] [seed]\n" );
+		return;
+	}
+
+	ops = malloc( numOps * sizeof( *ops ) );
+	slots = malloc( numOps * sizeof( *slots ) );
+	if ( !ops || !slots ) {
+		free( ops );
+		free( slots );
+		Com_Printf( "Couldn't allocate a trace of %i operations\n", numOps );
+		return;
+	}
+
+	Com_ZoneBenchTrace( ops, numOps, seed, &numSlots );
+
+	Zone_Stats( "main", mainzone, qfalse, &before );
+
+#ifdef USE_ZONE_SLABS
+	slab.enabled = qfalse;
+#endif
+	zoneTime = Com_ZoneBenchReplay( ops, numOps, slots, numSlots, &zoneOnly );
+#ifdef USE_ZONE_SLABS
+	slab.enabled = qtrue;
+#endif
+	slabTime = Com_ZoneBenchReplay( ops, numOps, slots, numSlots, &slabs );
+
+	Com_Printf( "%i operations, %i allocations\n", numOps, numSlots );
+	Com_Printf( "zone only:  %8.1f msec, %6.1f nsec per operation, %6i free blocks left (%.1f%% fragmented)\n",
+		zoneTime / 1000.0, zoneTime * 1000.0 / numOps, zoneOnly.freeBlocks - before.freeBlocks, Zone_Fragmentation( &zoneOnly ) );
+#ifdef USE_ZONE_SLABS
+	Com_Printf( "with slabs: %8.1f msec, %6.1f nsec per operation, %6i free blocks left (%.1f%% fragmented), %.2fx\n",
+		slabTime / 1000.0, slabTime * 1000.0 / numOps, slabs.freeBlocks - before.freeBlocks, Zone_Fragmentation( &slabs ),
+		(double)zoneTime / MAX( slabTime, 1 ) );
+#endif
+
+	free( ops );
+	free( slots );
 }
 
 
@@ -2057,12 +2760,121 @@ void Com_TouchMemory( void ) {
 		}
 	}
 
+#ifdef USE_ZONE_SLABS
+	if ( slab.initialized ) {
+		const slabPage_t *page;
+		int c;
+
+		for ( c = 0; c < SLAB_CLASSES; c++ ) {
+			for ( page = slabClasses[c].pages; page; page = page->next ) {
+				j = SLAB_PAGE_SIZE >> 2;
+				for ( i = 0 ; i < j ; i+=64 ) {			// only need to touch each page
+					sum += ((const unsigned int *)page)[i];
+				}
+			}
+		}
+	}
+#endif
+
 	end = Sys_Milliseconds();
 
 	Com_Printf( "Com_TouchMemory: %i msec\n", end - start );
 }
 
 
+/*
+=================
+Com_PrefaultRange
+=================
+*/
+typedef struct {
+	byte	*start;
+	size_t	size;
+	size_t	step;
+} prefaultRange_t;
+
+static void Com_PrefaultRange( void *arg ) {
+	const prefaultRange_t *range = (const prefaultRange_t *)arg;
+	volatile byte *p = range->start;
+	size_t i;
+
+	// the pages are still zero, writing makes the kernel back them
+	for ( i = 0; i < range->size; i += range->step ) {
+		p[i] = 0;
+	}
+}
+
+
+/*
+=================
+Com_PrefaultRegion
+
+Faults in the whole region on com_prefault threads, each working on
+whole huge pages so they never wait on the same one
+=================
+*/
+static void Com_PrefaultRegion( memRegion_t *region ) {
+	prefaultRange_t	ranges[ MAX_PREFAULT_THREADS ];
+	sysThread_t		*threads[ MAX_PREFAULT_THREADS ];
+	size_t			chunk, offset;
+	int64_t			start;
+	int				i, numThreads;
+
+	numThreads = com_prefault->integer;
+	if ( numThreads <= 0 ) {
+		return;
+	}
+
+	start = Sys_Microseconds();
+
+	chunk = PAD( ( region->size + numThreads - 1 ) / numThreads, 2 * 1024 * 1024 );
+	offset = 0;
+
+	for ( i = 0; i < numThreads; i++ ) {
+		ranges[i].start = region->base + offset;
+		ranges[i].size = MIN( chunk, region->size - offset );
+		ranges[i].step = region->kind == PAGES_HUGE ? region->pageSize : 4096;
+		offset += ranges[i].size;
+
+		// the last range runs on this thread
+		threads[i] = NULL;
+		if ( i < numThreads - 1 ) {
+			threads[i] = Sys_CreateThread( Com_PrefaultRange, &ranges[i] );
+		}
+		if ( !threads[i] ) {
+			Com_PrefaultRange( &ranges[i] );
+		}
+	}
+
+	for ( i = 0; i < numThreads; i++ ) {
+		if ( threads[i] ) {
+			Sys_JoinThread( threads[i] );
+		}
+	}
+
+	region->prefaultThreads = numThreads;
+	region->prefaultTime = Sys_Microseconds() - start;
+}
+
+
+/*
+=================
+Com_AllocRegion
+=================
+*/
+static void *Com_AllocRegion( memRegion_t *region, size_t size ) {
+	region->base = Sys_AllocPages( size, com_hugePages->integer ? qtrue : qfalse, &region->kind, &region->pageSize );
+	if ( !region->base ) {
+		return NULL;
+	}
+
+	region->size = size;
+	Com_PrefaultRegion( region );
+
+	return region->base;
+}
+
+
 /*
 =================
 Com_InitSmallZoneMemory
@@ -2099,6 +2911,14 @@ static void Com_InitZoneMemory( void ) {
 	Cvar_CheckRange( cv, "1", NULL, CV_INTEGER );
 	Cvar_SetDescription( cv, "Initial amount of memory (RAM) allocated for the main block zone (in MB)" );
 
+	// same restriction as com_zoneMegs, these also apply to the hunk
+	com_hugePages = Cvar_Get( "com_hugePages", "0", CVAR_LATCH | CVAR_ARCHIVE );
+	Cvar_CheckRange( com_hugePages, "0", "1", CV_INTEGER );
+	Cvar_SetDescription( com_hugePages, "Back the hunk and main zone with huge pages (2 MB) where the system allows it, otherwise regular pages are used" );
+	com_prefault = Cvar_Get( "com_prefault", "0", CVAR_LATCH | CVAR_ARCHIVE );
+	Cvar_CheckRange( com_prefault, "0", XSTRING( MAX_PREFAULT_THREADS ), CV_INTEGER );
+	Cvar_SetDescription( com_prefault, "Number of threads faulting in the hunk and main zone at startup, 0 leaves it to the first use" );
+
 #ifndef USE_MULTI_SEGMENT
 	if ( cv->integer < DEF_COMZONEMEGS )
 		mainZoneSize = 1024 * 1024 * DEF_COMZONEMEGS;
@@ -2106,11 +2926,16 @@ static void Com_InitZoneMemory( void ) {
 #endif
 		mainZoneSize = cv->integer * 1024 * 1024;
 
-	mainzone = calloc( mainZoneSize, 1 );
+	mainzone = Com_AllocRegion( &zoneRegion, mainZoneSize );
 	if ( !mainzone ) {
 		Com_Error( ERR_FATAL, "Zone data failed to allocate %i megs", mainZoneSize / (1024*1024) );
 	}
 	Z_ClearZone( mainzone, mainzone, mainZoneSize, 1 );
+
+#ifdef USE_ZONE_SLABS
+	// slab chunks come from the main zone, the small zone is used until here
+	Z_InitSlabs();
+#endif
 }
 
 
@@ -2231,13 +3056,12 @@ static void Com_InitHunkMemory( void ) {
 
 	s_hunkTotal = cv->integer * 1024 * 1024;
 
-	s_hunkData = calloc( s_hunkTotal + 63, 1 );
+	// page aligned
+	s_hunkData = Com_AllocRegion( &hunkRegion, s_hunkTotal );
 	if ( !s_hunkData ) {
 		Com_Error( ERR_FATAL, "Hunk data failed to allocate %i megs", s_hunkTotal / (1024*1024) );
 	}
 
-	// cacheline align
-	s_hunkData = PADP( s_hunkData, 64 );
 	Hunk_Clear();
 
 	Cmd_RegisterArray( hunk_cmds, MODULE_COMMON );
@@ -2259,6 +3083,33 @@ int	Hunk_MemoryRemaining( void ) {
 }
 
 
+/*
+=================
+Com_MemoryUsage
+=================
+*/
+void Com_MemoryUsage( memUsage_t *usage ) {
+	usage->hunkTotal = s_hunkTotal;
+	usage->hunkUsed = s_hunkTotal - Hunk_MemoryRemaining();
+	usage->zoneTotal = mainzone->size;
+	usage->zoneUsed = mainzone->used;
+	usage->smallZoneTotal = smallzone->size;
+	usage->smallZoneUsed = smallzone->used;
+
+	usage->slabTotal = usage->slabUsed = 0;
+#ifdef USE_ZONE_SLABS
+	{
+		int c;
+
+		usage->slabTotal = slab.chunks * SLAB_CHUNK_SIZE;
+		for ( c = 0; c < SLAB_CLASSES; c++ ) {
+			usage->slabUsed += slabClasses[c].used * slabClasses[c].size;
+		}
+	}
+#endif
+}
+
+
 /*
 ===================
 Hunk_SetMark
@@ -2375,6 +3226,8 @@ void *Hunk_Alloc( int size, ha_pref preference ) {
 #endif
 	void	*buf;
 
+	Com_AssertMainThread( "Hunk_Alloc" );
+
 	if ( s_hunkData == NULL)
 	{
 		Com_Error( ERR_FATAL, "Hunk_Alloc: Hunk memory system not initialized" );
@@ -2458,6 +3311,8 @@ void *Hunk_AllocateTempMemory( int size ) {
 	void		*buf;
 	hunkHeader_t	*hdr;
 
+	Com_AssertMainThread( "Hunk_AllocateTempMemory" );
+
 	// return a Z_Malloc'd block if the hunk has not been initialized
 	// this allows the config and product id files ( journal files too ) to be loaded
 	// by the file system without redundant routines in the file system utilizing different
@@ -2510,6 +3365,8 @@ Hunk_FreeTempMemory
 void Hunk_FreeTempMemory( void *buf ) {
 	hunkHeader_t	*hdr;
 
+	Com_AssertMainThread( "Hunk_FreeTempMemory" );
+
 	// free with Z_Free if the hunk has not been initialized
 	// this allows the config and product id files ( journal files too ) to be loaded
 	// by the file system without redundant routines in the file system utilizing different
@@ -2576,41 +3433,6 @@ static int com_pushedEventsTail = 0;
 static sysEvent_t com_pushedEvents[MAX_PUSHED_EVENTS];
 
 
-/*
-=================
-Com_InitJournaling
-=================
-*/
-static void Com_InitJournaling( void ) {
-	if ( !com_journal->integer ) {
-		return;
-	}
-
-	if ( com_journal->integer == 1 ) {
-		Com_Printf( "Journaling events\n" );
-		com_journalFile = FS_FOpenFileWrite( "journal.dat" );
-		com_journalDataFile = FS_FOpenFileWrite( "journaldata.dat" );
-	} else if ( com_journal->integer == 2 ) {
-		Com_Printf( "Replaying journaled events\n" );
-		FS_FOpenFileRead( "journal.dat", &com_journalFile, qtrue );
-		FS_FOpenFileRead( "journaldata.dat", &com_journalDataFile, qtrue );
-	}
-
-	if ( com_journalFile == FS_INVALID_HANDLE || com_journalDataFile == FS_INVALID_HANDLE ) {
-		Cvar_Set( "com_journal", "0" );
-		if ( com_journalFile != FS_INVALID_HANDLE ) {
-			FS_FCloseFile( com_journalFile );
-			com_journalFile = FS_INVALID_HANDLE;
-		}
-		if ( com_journalDataFile != FS_INVALID_HANDLE ) {
-			FS_FCloseFile( com_journalDataFile );
-			com_journalDataFile = FS_INVALID_HANDLE;
-		}
-		Com_Printf( "Couldn't open journal files\n" );
-	}
-}
-
-
 /*
 ========================================================================
 
@@ -2635,7 +3457,9 @@ static const char *Sys_EventName( sysEventType_t evType ) {
 		"SE_CHAR",
 		"SE_MOUSE",
 		"SE_JOYSTICK_AXIS",
-		"SE_CONSOLE"
+		"SE_CONSOLE",
+		"SE_PACKET",
+		"SE_CHECKSUM"
 	};
 
 	if ( (unsigned)evType >= ARRAY_LEN( evNames ) ) {
@@ -2749,47 +3573,20 @@ Com_GetRealEvent
 =================
 */
 static sysEvent_t Com_GetRealEvent( void ) {
+	sysEvent_t	ev;
 
 	// get or save an event from/to the journal file
-	if ( com_journalFile != FS_INVALID_HANDLE ) {
-		int			r;
-		sysEvent_t	ev;
-
-		if ( com_journal->integer == 2 ) {
-			Sys_SendKeyEvents();
-			r = FS_Read( &ev, sizeof(ev), com_journalFile );
-			if ( r != sizeof(ev) ) {
-				Com_Error( ERR_FATAL, "Error reading from journal file" );
-			}
-			if ( ev.evPtrLength ) {
-				ev.evPtr = Z_Malloc( ev.evPtrLength );
-				r = FS_Read( ev.evPtr, ev.evPtrLength, com_journalFile );
-				if ( r != ev.evPtrLength ) {
-					Com_Error( ERR_FATAL, "Error reading from journal file" );
-				}
-			}
-		} else {
-			ev = Com_GetSystemEvent();
+	if ( Com_JournalReplaying() ) {
+		Sys_SendKeyEvents();
+		return Com_JournalReadEvent();
+	}
 
-			// write the journal value out if needed
-			if ( com_journal->integer == 1 ) {
-				r = FS_Write( &ev, sizeof(ev), com_journalFile );
-				if ( r != sizeof(ev) ) {
-					Com_Error( ERR_FATAL, "Error writing to journal file" );
-				}
-				if ( ev.evPtrLength ) {
-					r = FS_Write( ev.evPtr, ev.evPtrLength, com_journalFile );
-					if ( r != ev.evPtrLength ) {
-						Com_Error( ERR_FATAL, "Error writing to journal file" );
-					}
-				}
-			}
-		}
+	ev = Com_GetSystemEvent();
 
-		return ev;
-	}
+	// write the journal value out if needed
+	Com_JournalWriteEvent( &ev );
 
-	return Com_GetSystemEvent();
+	return ev;
 }
 
 
@@ -2900,6 +3697,12 @@ int Com_EventLoop( void ) {
 
 		// if no more events are available
 		if ( ev.evType == SE_NONE ) {
+			// finished background reads
+			FS_AsyncFrame();
+
+			// queued log lines
+			Com_LogFrame();
+
 			// manually send packet events for the loopback channel
 #ifndef DEDICATED
 			while ( NET_GetLoopPacket( NS_CLIENT, &evFrom, &buf ) ) {
@@ -3913,6 +4716,150 @@ static void Com_SetAffinityMask( const char *str )
 }
 #endif // USE_AFFINITY_MASK
 
+
+// what a current client sends on connect
+static const char *infoBenchUserinfo =
+	"\\cg_uinfo\\13 0 30\\g_password\\none\\cl_guid\\7D8C4A9E1F0B23C6D5E4F3A2B1C0D9E8"
+	"\\cl_wwwDownload\\1\\name\\^1Bench^7Player\\rate\\25000\\snaps\\20\\cl_anonymous\\0"
+	"\\cl_punkbuster\\0\\cg_etVersion\\Enemy Territory, ETe\\cl_maxpackets\\125"
+	"\\cl_timenudge\\0\\ch\\-1\\password\\\\protocol\\84\\qport\\27044"
+	"\\challenge\\-1852349812\\client\\ETe";
+
+/*
+=================
+Com_InfoBenchScan
+
+Userinfo handling of a connect before infoDict_t: SV_DirectConnect,
+SV_UserinfoChanged and ClientUserinfoChanged in the game
+=================
+*/
+static int Com_InfoBenchScan( char *userinfo ) {
+	int sum;
+
+	Q_strncpyz( userinfo, infoBenchUserinfo, MAX_INFO_STRING );
+
+	sum = atoi( Info_ValueForKey( userinfo, "challenge" ) );
+	sum += atoi( Info_ValueForKey( userinfo, "protocol" ) );
+	sum += atoi( Info_ValueForKey( userinfo, "qport" ) );
+	sum += atoi( Info_ValueForKey( userinfo, "qport" ) );
+	sum += *Info_ValueForKey( userinfo, "client" );
+	Info_RemoveKey( userinfo, "challenge" );
+	Info_RemoveKey( userinfo, "qport" );
+	Info_RemoveKey( userinfo, "protocol" );
+	Info_RemoveKey( userinfo, "client" );
+	Info_SetValueForKey( userinfo, "ip", "192.0.2.45:27960" );
+	Info_SetValueForKey( userinfo, "tld", "ZZ" );
+	sum += *Info_ValueForKey( userinfo, "password" );
+
+	sum += atoi( Info_ValueForKey( userinfo, "rate" ) );
+	sum += atoi( Info_ValueForKey( userinfo, "snaps" ) );
+	sum += *Info_ValueForKey( userinfo, "name" );
+	sum += *Info_ValueForKey( userinfo, "cl_guid" );
+	sum += atoi( Info_ValueForKey( userinfo, "cl_wwwDownload" ) );
+	Info_SetValueForKey( userinfo, "ip", "192.0.2.45:27960" );
+	Info_SetValueForKey( userinfo, "tld", "ZZ" );
+
+	sum += *Info_ValueForKey( userinfo, "ip" );
+	sum += *Info_ValueForKey( userinfo, "cg_uinfo" );
+	sum += *Info_ValueForKey( userinfo, "name" );
+	sum += atoi( Info_ValueForKey( userinfo, "ch" ) );
+
+	return sum;
+}
+
+
+/*
+=================
+Com_InfoBenchDict
+
+Same as Com_InfoBenchScan, each stage parses the userinfo once
+=================
+*/
+static int Com_InfoBenchDict( char *userinfo ) {
+	infoDict_t dict;
+	int sum;
+
+	Info_DictParse( &dict, infoBenchUserinfo );
+
+	sum = atoi( Info_DictValue( &dict, "challenge" ) );
+	sum += atoi( Info_DictValue( &dict, "protocol" ) );
+	sum += atoi( Info_DictValue( &dict, "qport" ) );
+	sum += atoi( Info_DictValue( &dict, "qport" ) );
+	sum += *Info_DictValue( &dict, "client" );
+	Info_DictRemove( &dict, "challenge" );
+	Info_DictRemove( &dict, "qport" );
+	Info_DictRemove( &dict, "protocol" );
+	Info_DictRemove( &dict, "client" );
+	Info_DictSet( &dict, "ip", "192.0.2.45:27960" );
+	Info_DictSet( &dict, "tld", "ZZ" );
+	Info_DictWrite( &dict, userinfo, MAX_INFO_STRING );
+	sum += *Info_DictValue( &dict, "password" );
+
+	Info_DictParse( &dict, userinfo );
+	sum += atoi( Info_DictValue( &dict, "rate" ) );
+	sum += atoi( Info_DictValue( &dict, "snaps" ) );
+	sum += *Info_DictValue( &dict, "name" );
+	sum += *Info_DictValue( &dict, "cl_guid" );
+	sum += atoi( Info_DictValue( &dict, "cl_wwwDownload" ) );
+	Info_DictSet( &dict, "ip", "192.0.2.45:27960" );
+	Info_DictSet( &dict, "tld", "ZZ" );
+	Info_DictWrite( &dict, userinfo, MAX_INFO_STRING );
+
+	Info_DictParse( &dict, userinfo );
+	sum += *Info_DictValue( &dict, "ip" );
+	sum += *Info_DictValue( &dict, "cg_uinfo" );
+	sum += *Info_DictValue( &dict, "name" );
+	sum += atoi( Info_DictValue( &dict, "ch" ) );
+
+	return sum;
+}
+
+
+/*
+=================
+Com_InfoBench_f
+
+Times the userinfo processing of a client connect
+with info string scans and with infoDict_t
+=================
+*/
+static void Com_InfoBench_f( void ) {
+	char	scanInfo[MAX_INFO_STRING], dictInfo[MAX_INFO_STRING];
+	int64_t	start, scanTime, dictTime;
+	int		scanSum, dictSum;
+	int		i, count;
+
+	count = Cmd_Argc() > 1 ? atoi( Cmd_Argv( 1 ) ) : 100000;
+	if ( count <= 0 ) {
+		Com_Printf( "Usage: infobench [connects]\n" );
+		return;
+	}
+
+	scanSum = dictSum = 0;
+
+	start = Sys_Microseconds();
+	for ( i = 0; i < count; i++ ) {
+		scanSum += Com_InfoBenchScan( scanInfo );
+	}
+	scanTime = Sys_Microseconds() - start;
+
+	start = Sys_Microseconds();
+	for ( i = 0; i < count; i++ ) {
+		dictSum += Com_InfoBenchDict( dictInfo );
+	}
+	dictTime = Sys_Microseconds() - start;
+
+	Com_Printf( "%i connects, %i byte userinfo\n", count, (int)strlen( infoBenchUserinfo ) );
+	Com_Printf( "info strings: %8.1f msec, %6.0f nsec per connect\n", scanTime / 1000.0, scanTime * 1000.0 / count );
+	Com_Printf( "infoDict_t:   %8.1f msec, %6.0f nsec per connect, %.2fx\n", dictTime / 1000.0, dictTime * 1000.0 / count,
+		(double)scanTime / MAX( dictTime, 1 ) );
+
+	if ( scanSum != dictSum || strcmp( scanInfo, dictInfo ) ) {
+		Com_Printf( S_COLOR_YELLOW "results differ:\n%s\n%s\n", scanInfo, dictInfo );
+	}
+}
+
+
 static const cmdListItem_t com_cmds[] = {
 	{ "changeVectors", MSG_ReportChangeVectors_f, NULL },
 #ifdef _DEBUG
@@ -3921,10 +4868,18 @@ static const cmdListItem_t com_cmds[] = {
 	{ "freeze", Com_Freeze_f, NULL },
 #endif
 	{ "game_restart", Com_GameRestart_f, NULL },
+	{ "prefetchmap", Com_PrefetchMap_f, NULL },
 	{ "quit", Com_Quit_f, NULL },
 	{ "writeconfig", Com_WriteConfig_f, Cmd_CompleteWriteCfgName },
 };
 
+// self benchmarks stall the frame, only with developer set at startup
+static const cmdListItem_t com_benchCmds[] = {
+	{ "cm_stress", CM_StressTest_f, NULL },
+	{ "infobench", Com_InfoBench_f, NULL },
+	{ "zonebench", Com_ZoneBench_f, NULL },
+};
+
 
 /*
 =================
@@ -3940,6 +4895,9 @@ void Com_Init( char *commandLine ) {
 	// get the initial time base
 	Sys_Milliseconds();
 
+	// identifies the main thread for the allocator checks
+	Com_InitThreadMemory();
+
 	Com_Printf( "%s %s %s\n", Q3_VERSION, PLATFORM_STRING, __DATE__ ); // GIT/SVN_VERSION?
 
 	if ( Q_setjmp( abortframe ) ) {
@@ -4039,10 +4997,16 @@ void Com_Init( char *commandLine ) {
 
 	FS_InitFilesystem();
 
+	Com_InitPrefetch();
+
 #ifndef DEDICATED
 	Sys_SteamInit();
 #endif
 
+	Com_InitLogWriter();
+
+	Com_InitProfiler();
+
 	com_logfile = Cvar_Get( "logfile", "0", CVAR_TEMP );
 	Cvar_CheckRange( com_logfile, "0", "4", CV_INTEGER );
 	Cvar_SetDescription( com_logfile, "System console logging:\n"
@@ -4174,6 +5138,9 @@ void Com_Init( char *commandLine ) {
 	}
 
 	Cmd_RegisterArray( com_cmds, MODULE_COMMON );
+	if ( com_developer->integer ) {
+		Cmd_RegisterArray( com_benchCmds, MODULE_COMMON );
+	}
 
 	s = va( "%s %s %s", Q3_VERSION, PLATFORM_STRING, __DATE__ );
 	com_version = Cvar_Get( "version", s, CVAR_PROTECTED | CVAR_ROM | CVAR_SERVERINFO );
@@ -4476,6 +5443,7 @@ void Com_Frame( qboolean noDelay ) {
 	int	sleepMsec;
 	int	timeVal;
 	int	timeValSV;
+	int	timeValNet;
 
 	int	timeBeforeFirstEvents;
 	int	timeBeforeServer;
@@ -4490,6 +5458,8 @@ void Com_Frame( qboolean noDelay ) {
 		return;			// an ERR_DROP was thrown
 	}
 
+	Com_ProfileFrame();
+
 	minMsec = 0; // silent compiler warning
 
 	// bk001204 - init to zero.
@@ -4563,6 +5533,8 @@ void Com_Frame( qboolean noDelay ) {
 	// waiting for incoming packets
 	if ( noDelay == qfalse )
 	do {
+		// wake up in time for packets held back by the network emulator
+		timeValNet = NET_FlushPacketQueue();
 		if ( com_sv_running->integer ) {
 			timeValSV = SV_SendQueuedPackets();
 			timeVal = Com_TimeVal( minMsec );
@@ -4571,6 +5543,8 @@ void Com_Frame( qboolean noDelay ) {
 		} else {
 			timeVal = Com_TimeVal( minMsec );
 		}
+		if ( timeValNet < timeVal )
+			timeVal = timeValNet;
 		sleepMsec = timeVal;
 #ifndef DEDICATED
 		if ( !gw_minimized && timeVal > com_yieldCPU->integer )
@@ -4578,14 +5552,23 @@ void Com_Frame( qboolean noDelay ) {
 		if ( timeVal > sleepMsec )
 			Com_EventLoop();
 #endif
+		// replayed packets come from the journal, don't wait for them
+		if ( Com_JournalReplaying() )
+			continue;
 		NET_Sleep( sleepMsec * 1000 - 500 );
 	} while( Com_TimeVal( minMsec ) );
 
+	PROFILE_BEGIN( "Com_Frame" );
+
+	PROFILE_BEGIN( "Com_EventLoop" );
 	lastTime = com_frameTime;
 	com_frameTime = Com_EventLoop();
 	realMsec = com_frameTime - lastTime;
+	PROFILE_END();
 
+	PROFILE_BEGIN( "Cbuf_Execute" );
 	Cbuf_Execute();
+	PROFILE_END();
 
 	// mess with msec if needed
 	msec = Com_ModifyMsec( realMsec );
@@ -4597,7 +5580,9 @@ void Com_Frame( qboolean noDelay ) {
 		timeBeforeServer = Sys_Milliseconds();
 	}
 
+	PROFILE_BEGIN( "SV_Frame" );
 	SV_Frame( msec );
+	PROFILE_END();
 
 	// if "dedicated" has been modified, start up
 	// or shut down the client system.
@@ -4658,7 +5643,9 @@ void Com_Frame( qboolean noDelay ) {
 			timeBeforeClient = Sys_Milliseconds();
 		}
 
+		PROFILE_BEGIN( "CL_Frame" );
 		CL_Frame( msec, realMsec );
+		PROFILE_END();
 
 		if ( com_speeds->integer ) {
 			timeAfter = Sys_Milliseconds();
@@ -4716,8 +5703,8 @@ void Com_Frame( qboolean noDelay ) {
 	//
 	if ( com_showtrace->integer ) {
 
-		extern	int c_traces, c_brush_traces, c_patch_traces;
-		extern	int	c_pointcontents;
+		extern	Q_THREADLOCAL int c_traces, c_brush_traces, c_patch_traces;
+		extern	Q_THREADLOCAL int	c_pointcontents;
 
 		Com_Printf ("%4i traces  (%ib %ip) %4i points\n", c_traces,
 			c_brush_traces, c_patch_traces, c_pointcontents);
@@ -4727,6 +5714,8 @@ void Com_Frame( qboolean noDelay ) {
 		c_pointcontents = 0;
 	}
 
+	PROFILE_END();
+
 	com_frameNumber++;
 }
 
@@ -4750,20 +5739,14 @@ static void Com_Shutdown( qboolean badProfile ) {
 	Com_CheckDefaultProfile();
 #endif
 
+	Com_ShutdownJournaling();
+
 	if ( logfile != FS_INVALID_HANDLE ) {
 		FS_FCloseFile( logfile );
 		logfile = FS_INVALID_HANDLE;
 	}
 
-	if ( com_journalFile != FS_INVALID_HANDLE ) {
-		FS_FCloseFile( com_journalFile );
-		com_journalFile = FS_INVALID_HANDLE;
-	}
-
-	if ( com_journalDataFile != FS_INVALID_HANDLE ) {
-		FS_FCloseFile( com_journalDataFile );
-		com_journalDataFile = FS_INVALID_HANDLE;
-	}
+	Com_ShutdownLogWriter();
 
 #ifndef DEDICATED
 	Sys_SteamShutdown();
@@ -5222,13 +6205,25 @@ void Com_RandomBytes( byte *string, int len )
 {
 	int i;
 
-	if ( Sys_RandomBytes( string, len ) )
+	// a replayed session gets the bytes handed out when it was recorded
+	if ( com_journalDataFile != FS_INVALID_HANDLE && com_journal->integer == 2 ) {
+		if ( FS_Read( string, len, com_journalDataFile ) != len ) {
+			Com_Error( ERR_FATAL, "Read from journalDataFile failed" );
+		}
 		return;
+	}
 
-	Com_Printf( S_COLOR_YELLOW "Com_RandomBytes: using weak randomization\n" );
-	srand( time( NULL ) );
-	for( i = 0; i < len; i++ )
-		string[i] = (unsigned char)( rand() % 256 );
+	if ( !Sys_RandomBytes( string, len ) ) {
+		Com_Printf( S_COLOR_YELLOW "Com_RandomBytes: using weak randomization\n" );
+		srand( time( NULL ) );
+		for( i = 0; i < len; i++ )
+			string[i] = (unsigned char)( rand() % 256 );
+	}
+
+	if ( com_journalDataFile != FS_INVALID_HANDLE && com_journal->integer == 1 ) {
+		FS_Write( string, len, com_journalDataFile );
+		FS_Flush( com_journalDataFile );
+	}
 }
 
 
@@ -45,6 +45,19 @@ static int	cvar_group[ CVG_MAX ];
 static	cvar_t	*hashTable[FILE_HASH_SIZE];
 static	qboolean cvar_sort = qfalse;
 
+// per module list of changed cvars, so modules don't have to poll
+// every registered cvar through a syscall each frame
+#define CVAR_JOURNAL_SIZE	128
+
+typedef struct {
+	int			handles[CVAR_JOURNAL_SIZE];
+	int			count;
+	qboolean	overflow;			// changes were lost, module must update everything
+	qboolean	active;				// module has asked for changes at least once
+} cvarJournal_t;
+
+static	cvarJournal_t cvar_journals[VM_COUNT];
+
 /*
 ================
 return a hash value for the filename
@@ -741,6 +754,41 @@ static void Cvar_Print( const cvar_t *v ) {
 }
 
 
+/*
+============
+Cvar_JournalChange
+
+Queues a changed cvar for the modules that registered it
+============
+*/
+static void Cvar_JournalChange( cvar_t *var ) {
+	cvarJournal_t *journal;
+	int pending;
+	int i;
+
+	pending = var->journalModules & ~var->journalQueued;
+	if ( !pending ) {
+		return;
+	}
+
+	for ( i = 0; i < VM_COUNT; i++ ) {
+		if ( !( pending & ( 1 << i ) ) ) {
+			continue;
+		}
+		journal = &cvar_journals[i];
+		if ( !journal->active ) {
+			continue;
+		}
+		if ( journal->count >= ARRAY_LEN( journal->handles ) ) {
+			journal->overflow = qtrue;
+			continue;
+		}
+		journal->handles[journal->count++] = var - cvar_indexes;
+		var->journalQueued |= 1 << i;
+	}
+}
+
+
 /*
 ============
 Cvar_Set2
@@ -871,6 +919,7 @@ cvar_t *Cvar_Set2( const char *var_name, const char *value, qboolean force ) {
 			var->modified = qtrue;
 			var->modificationCount++;
 			cvar_group[ var->group ] = 1;
+			Cvar_JournalChange( var );
 			return var;
 		}
 	}
@@ -893,6 +942,7 @@ cvar_t *Cvar_Set2( const char *var_name, const char *value, qboolean force ) {
 	Z_Free( var->string ); // free the old value string
 	
 	var->string = CopyString( value );
+	Cvar_JournalChange( var );
 	var->value = Q_atof( var->string );
 	var->integer = atoi( var->string );
 
@@ -2316,7 +2366,7 @@ basically a slightly modified Cvar_Get for the interpreted modules
 =====================
 */
 #define INVALID_FLAGS ( CVAR_USER_CREATED | CVAR_SERVER_CREATED | CVAR_PROTECTED | CVAR_PRIVATE | CVAR_MODIFIED | CVAR_NONEXISTENT )
-void Cvar_Register( vmCvar_t *vmCvar, const char *varName, const char *defaultValue, int flags, int privateFlag )
+void Cvar_Register( vmCvar_t *vmCvar, const char *varName, const char *defaultValue, int flags, int privateFlag, vmIndex_t module )
 {
 	cvar_t	*cv;
 
@@ -2361,6 +2411,10 @@ void Cvar_Register( vmCvar_t *vmCvar, const char *varName, const char *defaultVa
 	if (!vmCvar)
 		return;
 
+	if ( (unsigned)module < VM_COUNT ) {
+		cv->journalModules |= 1 << module;
+	}
+
 	vmCvar->handle = cv - cvar_indexes;
 	vmCvar->modificationCount = -1;
 
@@ -2412,6 +2466,72 @@ void Cvar_Update( vmCvar_t *vmCvar, int privateFlag ) {
 }
 
 
+/*
+=====================
+Cvar_ReadChanges
+
+Hands the change journal of a module over to it. The first call
+only enables the journal and asks the module to update everything,
+as do calls after changes were dropped or don't fit into handles.
+=====================
+*/
+int Cvar_ReadChanges( vmIndex_t module, int *handles, int maxHandles ) {
+	cvarJournal_t *journal;
+	qboolean overflow;
+	int count;
+	int i, h;
+
+	if ( (unsigned)module >= VM_COUNT ) {
+		return -1;
+	}
+
+	journal = &cvar_journals[module];
+	if ( !journal->active ) {
+		journal->active = qtrue;
+		return -1;
+	}
+
+	count = journal->count;
+	overflow = journal->overflow || count > maxHandles;
+
+	for ( i = 0; i < count; i++ ) {
+		h = journal->handles[i];
+		cvar_indexes[h].journalQueued &= ~( 1 << module );
+		if ( !overflow ) {
+			handles[i] = h;
+		}
+	}
+
+	journal->count = 0;
+	journal->overflow = qfalse;
+
+	return overflow ? -1 : count;
+}
+
+
+/*
+=====================
+Cvar_ResetChanges
+=====================
+*/
+void Cvar_ResetChanges( vmIndex_t module ) {
+	int mask;
+	int i;
+
+	if ( (unsigned)module >= VM_COUNT ) {
+		return;
+	}
+
+	mask = ~( 1 << module );
+	for ( i = 0; i < cvar_numIndexes; i++ ) {
+		cvar_indexes[i].journalModules &= mask;
+		cvar_indexes[i].journalQueued &= mask;
+	}
+
+	Com_Memset( &cvar_journals[module], 0, sizeof( cvar_journals[module] ) );
+}
+
+
 /*
 ==================
 Cvar_CompleteCvarName
@@ -158,11 +158,10 @@ The filesystem can be safely shutdown and reinitialized with different
 basedir / cddir / game combinations, but all other subsystems that rely on it
 (sound, video) must also be forced to restart.
 
-Because the same files are loaded by both the clip model (CM_) and renderer (TR_)
-subsystems, a simple single-file caching scheme is used.  The CM_ subsystems will
-load the file with a request to cache.  Only one file will be kept cached at a time,
-so any models that are going to be referenced by both subsystems should alternate
-between the CM_ load function and the ref load function.
+Because the world map is loaded by both the clip model (CM_) and renderer (TR_)
+subsystems, a simple single-file caching scheme is used, see FS_ReadBSP.  The image
+is kept until the client has finished loading the level, or dropped right away
+when there is no client.
 
 TODO: A qpath that starts with a leading slash will always refer to the base game, even if another
 game is currently active.  This allows character models, skins, and sounds to be downloaded
@@ -243,6 +242,7 @@ typedef struct pack_s {
 	int				hashSize;					// hash table size (power of 2)
 	fileInPack_t*	*hashTable;					// hash table
 	fileInPack_t*	buildBuffer;				// buffer with the filenames etc.
+	fileInPack_t*	*sortedFiles;				// listing index, see FS_ListPakRange
 	int				index;
 
 	int				handleUsed;
@@ -270,6 +270,11 @@ typedef struct pack_s {
 typedef struct {
 	char		*path;		// c:\quake3
 	char		*gamedir;	// baseq3
+
+	// file index, see FS_IndexDirectory
+	char		*indexNames;	// every file in the tree, NULL when not indexed
+	int			indexCount;
+	sysWatch_t	*indexWatch;
 } directory_t;
 
 typedef enum {
@@ -283,6 +288,7 @@ typedef struct searchpath_s {
 	pack_t		*pack;		// only one of pack / dir will be non NULL
 	directory_t	*dir;
 	dirPolicy_t	policy;
+	int			order;		// position in fs_searchpaths, for the file index
 } searchpath_t;
 
 #define MAX_BASEGAMES 4
@@ -306,6 +312,11 @@ static	cvar_t		*fs_gamedirvar;
 static	cvar_t		*fs_locked;
 #endif
 static	cvar_t		*fs_excludeReference;
+static	cvar_t		*fs_index;
+static	cvar_t		*fs_scanThreads;
+static	cvar_t		*fs_asyncThreads;
+static	cvar_t		*fs_asyncBudget;
+static	cvar_t		*fs_prefetchBudget;
 
 static	searchpath_t	*fs_searchpaths;
 //static	int			fs_readCount UNUSED_VAR;	// total bytes read
@@ -340,6 +351,7 @@ typedef struct {
 	handleOwner_t	owner;
 	int			pakIndex;
 	pack_t		*pak;
+	int			logStream;		// Com_LogAttach stream + 1, 0 if written directly
 } fileHandleData_t;
 
 static fileHandleData_t	fsh[MAX_FILE_HANDLES];
@@ -371,6 +383,7 @@ static int FS_GetModList( char *listbuf, int bufsize );
 //static void FS_CheckIdPaks( void );
 void FS_Reload( void );
 static void FS_ListOpenFiles_f( void );
+static void FS_IndexChanged( void );
 
 
 /*
@@ -465,10 +478,59 @@ void FS_ForceFlush( fileHandle_t f ) {
 	FILE *file;
 
 	file = FS_FileForHandle(f);
+	if ( fsh[f].logStream ) {
+		return;
+	}
+
 	setvbuf( file, NULL, _IONBF, 0 );
 }
 
 
+/*
+================
+FS_SetAsyncLog
+
+Further writes to an append or write handle are queued for the
+log writer thread, returns qfalse if they stay synchronous
+================
+*/
+qboolean FS_SetAsyncLog( fileHandle_t f ) {
+	FILE *file;
+	int stream;
+
+	file = FS_FileForHandle( f );
+	if ( fsh[f].zipFile || fsh[f].logStream ) {
+		return qfalse;
+	}
+
+	// the writer bypasses the stdio buffer
+	fflush( file );
+
+	stream = Com_LogAttach( file, fsh[f].handleSync );
+	if ( stream < 0 ) {
+		return qfalse;
+	}
+
+	fsh[f].logStream = stream + 1;
+	return qtrue;
+}
+
+
+/*
+================
+FS_DetachLog
+
+Writes out what is queued for the handle, so it can be used directly again
+================
+*/
+static void FS_DetachLog( fileHandle_t f ) {
+	if ( fsh[f].logStream ) {
+		Com_LogDetach( fsh[f].logStream - 1 );
+		fsh[f].logStream = 0;
+	}
+}
+
+
 /*
 ================
 FS_FileLengthByHandle
@@ -683,6 +745,8 @@ void FS_CopyFile( const char *fromOSPath, const char *toOSPath ) {
 		}
 	}
 
+	FS_IndexChanged();
+
 	if ( fwrite( buf, 1, len, f ) != len ) {
 		free( buf );
 		fclose( f );
@@ -906,6 +970,8 @@ fileHandle_t FS_SV_FOpenFileWrite( const char *filename ) {
 		}
 	}
 
+	FS_IndexChanged();
+
 	Q_strncpyz( fd->name, filename, sizeof( fd->name ) );
 	fd->handleSync = qfalse;
 	fd->zipFile = qfalse;
@@ -1063,6 +1129,8 @@ void FS_SV_Rename( const char *from, const char *to ) {
 		FS_CopyFile( from_ospath, to_ospath );
 		FS_Remove( from_ospath );
 	}
+
+	FS_IndexChanged();
 }
 
 
@@ -1102,6 +1170,8 @@ void FS_Rename( const char *from, const char *to ) {
 		FS_CopyFile( from_ospath, to_ospath );
 		FS_Remove( from_ospath );
 	}
+
+	FS_IndexChanged();
 }
 
 #ifdef USE_HANDLE_CACHE
@@ -1198,6 +1268,8 @@ void FS_FCloseFile( fileHandle_t f ) {
 		Com_Error( ERR_FATAL, "Filesystem call made without initialization" );
 	}
 
+	FS_DetachLog( f );
+
 	fd = &fsh[ f ];
 
 	if ( fd->zipFile && fd->pak ) {
@@ -1289,6 +1361,8 @@ fileHandle_t FS_FOpenFileWrite( const char *filename ) {
 		}
 	}
 
+	FS_IndexChanged();
+
 	Q_strncpyz( fd->name, filename, sizeof( fd->name ) );
 	fd->handleSync = qfalse;
 	fd->zipFile = qfalse;
@@ -1350,6 +1424,8 @@ static fileHandle_t FS_FOpenDLLWrite( const char *filename ) {
 		}
 	}
 
+	FS_IndexChanged();
+
 	Q_strncpyz(fd->name, filename, sizeof(fd->name));
 	fd->handleSync = qfalse;
 	fd->zipFile = qfalse;
@@ -1405,6 +1481,8 @@ fileHandle_t FS_FOpenFileAppend( const char *filename ) {
 		}
 	}
 
+	FS_IndexChanged();
+
 	Q_strncpyz( fd->name, filename, sizeof( fd->name ) );
 	fd->handleSync = qfalse;
 	fd->zipFile = qfalse;
@@ -1542,6 +1620,31 @@ static qboolean FS_GeneralRef( const char *filename, const char *pakfile )
 }
 
 
+/*
+===========
+FS_ReferencePakFile
+
+Marks the pak as having been referenced and marks specifics on cgame and ui
+===========
+*/
+static void FS_ReferencePakFile( pack_t *pak, const char *filename )
+{
+	if ( !( pak->referenced & FS_GENERAL_REF ) && FS_GeneralRef( filename, pak->pakFilename ) ) {
+		pak->referenced |= FS_GENERAL_REF;
+	}
+	if ( !( pak->referenced & FS_CGAME_REF ) && !FS_FilenameCompare( filename, SYS_DLLNAME_CGAME ) ) {
+		pak->referenced |= FS_CGAME_REF;
+	}
+	if ( !( pak->referenced & FS_UI_REF ) && !FS_FilenameCompare( filename, SYS_DLLNAME_UI ) ) {
+		pak->referenced |= FS_UI_REF;
+	}
+}
+
+
+// set while asynchronous reads look up their file, they reference it on delivery
+static qboolean fs_noReference;
+
+
 /*
 ===========
 FS_BypassPure
@@ -1574,15 +1677,8 @@ static int FS_OpenFileInPak( fileHandle_t *file, pack_t *pak, fileInPack_t *pakF
 	// mark the pak as having been referenced and mark specifics on cgame and ui
 	// these are loaded from all pk3s
 	// from every pk3 file.
-
-	if ( !( pak->referenced & FS_GENERAL_REF ) && FS_GeneralRef( pakFile->name, pak->pakFilename ) ) {
-		pak->referenced |= FS_GENERAL_REF;
-	}
-		if ( !( pak->referenced & FS_CGAME_REF ) && !FS_FilenameCompare( pakFile->name, SYS_DLLNAME_CGAME ) ) {
-		pak->referenced |= FS_CGAME_REF;
-	}
-	if ( !( pak->referenced & FS_UI_REF ) && !FS_FilenameCompare( pakFile->name, SYS_DLLNAME_UI ) ) {
-		pak->referenced |= FS_UI_REF;
+	if ( !fs_noReference ) {
+		FS_ReferencePakFile( pak, pakFile->name );
 	}
 
 	if ( !pak->handle ) {
@@ -1654,1113 +1750,3026 @@ static int FS_OpenFileInPak( fileHandle_t *file, pack_t *pak, fileInPack_t *pakF
 
 
 /*
-===========
-FS_FOpenFileRead
+=============================================================================
 
-Finds the file in the search path.
-Returns filesize and an open FILE pointer.
-Used for streaming data out of either a
-separate file or a ZIP file.
-===========
+FILE INDEX
+
+Every file of every search path is kept in a single hash table, so a lookup
+is one probe that yields the few search paths that actually have the file,
+instead of a walk over all of them with an fopen per loose directory.
+
+Loose directories are listed once and watched for files being created or
+renamed, a directory that can't be watched (or listed completely) is not
+indexed and always probed as before. Pure and filter rules are still
+applied by FS_FOpenFileRead to the candidates, in search path order.
+
+=============================================================================
 */
-extern qboolean		com_fullyInitialized;
 
-// see FS_FOpenFileRead_Filtered
-static int fs_filter_flag = 0;
+#define FS_INDEX_MAX_DEPTH		16
+#define FS_INDEX_MAX_CANDIDATES	32
+
+typedef struct fileIndex_s {
+	const char			*name;
+	searchpath_t		*search;
+	struct fileIndex_s	*next;
+} fileIndex_t;
+
+static struct {
+	fileIndex_t		**table;
+	fileIndex_t		*entries;
+	int				tableSize;			// power of 2
+	int				numEntries;
+	searchpath_t	**dirs;				// all loose directories
+	int				numDirs;
+	int				lastPoll;
+	qboolean		pollNow;
+} fs_fileIndex;
+
+static struct {
+	int				lookups;
+	int				indexed;			// answered from the index
+	int				probes;				// loose directory opens
+	int				skipped;			// loose directory opens avoided
+	int64_t			probeTime;
+	int64_t			lookupTime;
+	int				rebuilds;
+	int				buildTime;			// msec
+} fs_indexStats;
+
+// pk3 scanning at the last filesystem startup
+static struct {
+	int				scanned;			// central directories read
+	int				cached;				// taken from the pk3 cache
+	int				threads;
+	int64_t			scanTime;
+	int64_t			buildTime;
+} fs_scanStats;
+
+// file lists, see FS_ListFilteredFiles
+static struct {
+	int				lists;
+	int				indexed;			// answered from the listing index
+	int				examined;			// pk3 names looked at
+	int64_t			listTime;
+	int				sorted;				// pk3 listing indexes built
+	int64_t			sortTime;
+} fs_listStats;
 
-void FS_SetFilterFlag(int flag)
-{
-	fs_filter_flag = flag;
+typedef struct {
+	searchpath_t	*list[FS_INDEX_MAX_CANDIDATES];
+	int				count;
+	int				current;
+	searchpath_t	*walk;				// plain search path walk
+} searchIter_t;
+
+typedef struct {
+	char			*names;
+	int				size;
+	int				used;
+	int				count;
+	qboolean		complete;
+} indexBuild_t;
+
+
+/*
+=================
+FS_IndexableName
+
+Only names the OS can't resolve to some other listed path
+=================
+*/
+static qboolean FS_IndexableName( const char *name ) {
+	const char *s;
+	char prev;
+
+	prev = '/';
+	for ( s = name; *s; s++ ) {
+		if ( *s == '/' || *s == '\\' ) {
+			// empty, "." or trimmed components
+			if ( prev == '/' || prev == '.' || prev == ' ' ) {
+				return qfalse;
+			}
+			prev = '/';
+		} else if ( *s == ':' ) {
+			return qfalse;
+		} else {
+			prev = *s;
+		}
+	}
+
+	return prev != '/' && prev != '.' && prev != ' ';
 }
 
-int FS_FOpenFileRead( const char *filename, fileHandle_t *file, qboolean uniqueFILE ) {
-	const searchpath_t	*search;
-	char			*netpath;
-	pack_t			*pak;
-	fileInPack_t	*pakFile;
-	directory_t		*dir;
-	long			hash;
-	long			fullHash;
-	FILE			*temp;
-	int				length;
-	fileHandleData_t *f;
 
-	if ( !fs_searchpaths ) {
-		Com_Error( ERR_FATAL, "Filesystem call made without initialization" );
+/*
+=================
+FS_IndexAddName
+=================
+*/
+static void FS_IndexAddName( indexBuild_t *b, const char *qpath, const char *name ) {
+	int len;
+
+	len = ( *qpath ? strlen( qpath ) + 1 : 0 ) + strlen( name ) + 1;
+	if ( b->used + len > b->size ) {
+		char *names;
+
+		b->size = MAX( b->size * 2, b->used + len + 65536 );
+		names = Z_Malloc( b->size );
+		if ( b->names ) {
+			Com_Memcpy( names, b->names, b->used );
+			Z_Free( b->names );
+		}
+		b->names = names;
 	}
 
-	if ( !filename ) {
-		Com_Error( ERR_FATAL, "FS_FOpenFileRead: NULL 'filename' parameter passed" );
+	if ( *qpath ) {
+		Com_sprintf( b->names + b->used, len, "%s/%s", qpath, name );
+	} else {
+		strcpy( b->names + b->used, name );
 	}
 
-	// qpaths are not supposed to have a leading slash
-	if ( filename[0] == '/' || filename[0] == '\\' ) {
-		filename++;
+	b->used += len;
+	b->count++;
+}
+
+
+/*
+=================
+FS_IndexTree
+=================
+*/
+static void FS_IndexTree( indexBuild_t *b, const char *root, const char *qpath, int depth ) {
+	char	ospath[MAX_OSPATH*2+1];
+	char	subpath[MAX_OSPATH];
+	char	**list;
+	int		i, count;
+
+	if ( depth > FS_INDEX_MAX_DEPTH ) {
+		b->complete = qfalse;
+		return;
 	}
 
-	// make absolutely sure that it can't back up the path.
-	// The searchpaths do guarantee that something will always
-	// be prepended, so we don't need to worry about "c:" or "//limbo"
-	if ( FS_CheckDirTraversal( filename ) ) {
-		*file = FS_INVALID_HANDLE;
-		return -1;
+	if ( *qpath ) {
+		Com_sprintf( ospath, sizeof( ospath ), "%s%c%s", root, PATH_SEP, qpath );
+		FS_ReplaceSeparators( ospath );
+	} else {
+		Q_strncpyz( ospath, root, sizeof( ospath ) );
 	}
 
-	// we will calculate full hash only once then just mask it by current pack->hashSize
-	// we can do that as long as we know properties of our hash function
-	fullHash = FS_HashFileName( filename, 0U );
+	list = Sys_ListFiles( ospath, "", NULL, &count, qfalse );
+	if ( count >= MAX_FOUND_FILES - 1 ) {
+		b->complete = qfalse;
+	}
+	for ( i = 0; i < count; i++ ) {
+		FS_IndexAddName( b, qpath, list[i] );
+	}
+	Sys_FreeFileList( list );
 
-	if ( file == NULL ) {
-		// just wants to see if file is there
-		for ( search = fs_searchpaths ; search ; search = search->next ) {
-			// is the element a pak file?
-			if ( search->pack && search->pack->hashTable[ (hash = fullHash & (search->pack->hashSize-1)) ] ) {
-				if (fs_filter_flag & FS_EXCLUDE_PK3)
-					continue;
-				if (fs_filter_flag & FS_EXCLUDE_ETMAIN)
-				{
-					if (FS_IsBaseGame(search->pack->pakGamename))
-						continue;
-				}
-				if (fs_filter_flag & FS_EXCLUDE_OTHERGAMES)
-				{
-					if (Q_stricmp(search->pack->pakGamename, fs_gamedir) != 0)
-						continue;
-				}
-				// skip non-pure files
-				if ( !FS_PakIsPure( search->pack ) )
-					continue;
-				// look through all the pak file elements
-				pak = search->pack;
-				pakFile = pak->hashTable[hash];
-				do {
-					// case and separator insensitive comparisons
-					if ( !FS_FilenameCompare( pakFile->name, filename ) ) {
-						// found it!
-						return pakFile->size; 
-					}
-					pakFile = pakFile->next;
-				} while ( pakFile != NULL );
-			} else if ( search->dir /*&& search->policy != DIR_DENY*/ ) {
-				if (fs_filter_flag & FS_EXCLUDE_DIR)
-					continue;
-				if (fs_filter_flag & FS_EXCLUDE_ETMAIN)
-				{
-					if (FS_IsBaseGame(search->dir->gamedir))
-						continue;
-				}
-				if (fs_filter_flag & FS_EXCLUDE_OTHERGAMES)
-				{
-					if (Q_stricmp(search->dir->gamedir, fs_gamedir) != 0)
-						continue;
-				}
-				if ( search->policy == DIR_DENY && fs_numServerPaks )
-				{
-					// allowed non-ref extensions
-					static const char *extList[] = { "cfg", "menu", "game", "dat", "botents" };
-					static const char *demoList[] = { DEMOEXT "84", DEMOEXT "85" };
+	list = Sys_ListFiles( ospath, "/", NULL, &count, qfalse );
+	if ( count >= MAX_FOUND_FILES - 1 ) {
+		b->complete = qfalse;
+	}
+	for ( i = 0; i < count && b->complete; i++ ) {
+		if ( !strcmp( list[i], "." ) || !strcmp( list[i], ".." ) ) {
+			continue;
+		}
+		// pk3dirs are search paths of their own
+		if ( !*qpath && FS_IsExt( list[i], ".pk3dir", strlen( list[i] ) ) ) {
+			continue;
+		}
+		if ( *qpath ) {
+			Com_sprintf( subpath, sizeof( subpath ), "%s/%s", qpath, list[i] );
+		} else {
+			Q_strncpyz( subpath, list[i], sizeof( subpath ) );
+		}
+		FS_IndexTree( b, root, subpath, depth + 1 );
+	}
+	Sys_FreeFileList( list );
+}
 
-					if ( !FS_HasExt( filename, extList, ARRAY_LEN( extList ) ) &&
-						!FS_HasExt( filename, demoList, ARRAY_LEN( demoList ) ) &&
-						!FS_IsExt( filename, "bots.txt", strlen( filename ) ) )
-					{
-						continue;
-					}
-				}
 
-				dir = search->dir;
-				netpath = FS_BuildOSPath( dir->path, dir->gamedir, filename );
-				temp = Sys_FOpen( netpath, "rb" );
-				if ( temp ) {
-					length = FS_FileLength( temp );
-					fclose( temp );
-					return length;
-				}
-			}
+/*
+=================
+FS_UnindexDirectory
+=================
+*/
+static void FS_UnindexDirectory( directory_t *dir ) {
+	if ( dir->indexWatch ) {
+		Sys_UnwatchTree( dir->indexWatch );
+		dir->indexWatch = NULL;
+	}
+	if ( dir->indexNames ) {
+		Z_Free( dir->indexNames );
+		dir->indexNames = NULL;
+	}
+	dir->indexCount = 0;
+}
+
+
+/*
+=================
+FS_IndexDirectory
+
+Lists the whole tree, the watch is set up first so nothing
+created in between goes unnoticed
+=================
+*/
+static void FS_IndexDirectory( directory_t *dir ) {
+	char root[MAX_OSPATH*2+1];
+	indexBuild_t b;
+
+	FS_UnindexDirectory( dir );
+
+	Q_strncpyz( root, FS_BuildOSPath( dir->path, dir->gamedir, NULL ), sizeof( root ) );
+
+	dir->indexWatch = Sys_WatchTree( root );
+	if ( !dir->indexWatch ) {
+		return;
+	}
+
+	Com_Memset( &b, 0, sizeof( b ) );
+	b.complete = qtrue;
+
+	FS_IndexTree( &b, root, "", 0 );
+
+	if ( !b.complete || !b.names ) {
+		if ( b.names ) {
+			Z_Free( b.names );
 		}
-		return -1;
+		// an empty directory stays indexed, with nothing in it
+		if ( b.complete ) {
+			dir->indexNames = Z_Malloc( 1 );
+			return;
+		}
+		Com_DPrintf( "not indexing %s, too many files\n", root );
+		FS_UnindexDirectory( dir );
+		return;
 	}
 
-	// make sure the q3key file is only readable by the quake3.exe at initialization
-	// any other time the key should only be accessed in memory using the provided functions
-	if ( com_fullyInitialized && strstr( filename, "etkey" ) ) {
-		*file = FS_INVALID_HANDLE;
-		return -1;
+	dir->indexNames = b.names;
+	dir->indexCount = b.count;
+}
+
+
+/*
+=================
+FS_NumberSearchPaths
+=================
+*/
+static void FS_NumberSearchPaths( void ) {
+	searchpath_t *search;
+	int i;
+
+	for ( search = fs_searchpaths, i = 0; search; search = search->next, i++ ) {
+		search->order = i;
 	}
+}
 
-	//
-	// search through the path, one element at a time
-	//
-	for ( search = fs_searchpaths ; search ; search = search->next ) {
-		// is the element a pak file?
-		if ( search->pack && search->pack->hashTable[ (hash = fullHash & (search->pack->hashSize-1)) ] ) {
-			if (fs_filter_flag & FS_EXCLUDE_PK3)
-			{
-				continue;
-			}
-			if (fs_filter_flag & FS_EXCLUDE_ETMAIN)
-			{
-				if (FS_IsBaseGame(search->pack->pakGamename))
-				{
-					continue;
-				}
-			}
-			if (fs_filter_flag & FS_EXCLUDE_OTHERGAMES)
-			{
-				if (Q_stricmp(search->pack->pakGamename, fs_gamedir) != 0)
-				{
-					continue;
-				}
-			}
-			// disregard if it doesn't match one of the allowed pure pak files
-			if ( !FS_PakIsPure( search->pack ) ) {
-				continue;
-			}
-			// look through all the pak file elements
-			pak = search->pack;
-			pakFile = pak->hashTable[hash];
-			do {
-				// case and separator insensitive comparisons
-				if ( !FS_FilenameCompare( pakFile->name, filename ) ) {
-					// found it!
-					return FS_OpenFileInPak( file, pak, pakFile, uniqueFILE );
-				}
-				pakFile = pakFile->next;
-			} while ( pakFile != NULL );
-		} else if ( search->dir /*&& search->policy != DIR_DENY*/ ) {
-			if (fs_filter_flag & FS_EXCLUDE_DIR)
-			{
-				continue;
-			}
-			if (fs_filter_flag & FS_EXCLUDE_ETMAIN)
-			{
-				if (FS_IsBaseGame(search->dir->gamedir))
-				{
-					continue;
-				}
+
+/*
+=================
+FS_BuildIndexTable
+=================
+*/
+static void FS_BuildIndexTable( void ) {
+	searchpath_t	*search;
+	fileIndex_t		*entry;
+	const char		*name;
+	long			hash;
+	int				count, i;
+
+	if ( fs_fileIndex.table ) {
+		Z_Free( fs_fileIndex.table );
+		fs_fileIndex.table = NULL;
+	}
+	if ( fs_fileIndex.entries ) {
+		Z_Free( fs_fileIndex.entries );
+		fs_fileIndex.entries = NULL;
+	}
+
+	count = 0;
+	for ( search = fs_searchpaths; search; search = search->next ) {
+		if ( search->pack ) {
+			count += search->pack->numfiles;
+		} else if ( search->dir->indexNames ) {
+			count += search->dir->indexCount;
+		}
+	}
+
+	fs_fileIndex.tableSize = 1024;
+	while ( fs_fileIndex.tableSize < count ) {
+		fs_fileIndex.tableSize <<= 1;
+	}
+
+	fs_fileIndex.table = Z_Malloc( fs_fileIndex.tableSize * sizeof( fs_fileIndex.table[0] ) );
+	fs_fileIndex.entries = entry = Z_Malloc( MAX( count, 1 ) * sizeof( fs_fileIndex.entries[0] ) );
+	fs_fileIndex.numEntries = count;
+
+	for ( search = fs_searchpaths; search; search = search->next ) {
+		if ( search->pack ) {
+			for ( i = 0; i < search->pack->numfiles; i++, entry++ ) {
+				entry->name = search->pack->buildBuffer[i].name;
+				entry->search = search;
+				hash = FS_HashFileName( entry->name, fs_fileIndex.tableSize );
+				entry->next = fs_fileIndex.table[hash];
+				fs_fileIndex.table[hash] = entry;
 			}
-			if (fs_filter_flag & FS_EXCLUDE_OTHERGAMES)
-			{
-				if (Q_stricmp(search->dir->gamedir, fs_gamedir) != 0)
-				{
-					continue;
-				}
+		} else if ( search->dir->indexNames ) {
+			name = search->dir->indexNames;
+			for ( i = 0; i < search->dir->indexCount; i++, entry++ ) {
+				entry->name = name;
+				entry->search = search;
+				hash = FS_HashFileName( entry->name, fs_fileIndex.tableSize );
+				entry->next = fs_fileIndex.table[hash];
+				fs_fileIndex.table[hash] = entry;
+				name += strlen( name ) + 1;
 			}
-			if ( search->policy == DIR_DENY && fs_numServerPaks )
-			{
-				// allowed non-ref extensions
-				static const char *extList[] = { "cfg", "menu", "game", "dat", "botents" };
-				static const char *demoList[] = { DEMOEXT "84", DEMOEXT "85" };
+		}
+	}
 
-				if ( !FS_HasExt( filename, extList, ARRAY_LEN( extList ) ) &&
-					!FS_HasExt( filename, demoList, ARRAY_LEN( demoList ) ) &&
-					!FS_IsExt( filename, "bots.txt", strlen( filename ) ) )
-				{
-					continue;
-				}
-			}
-			// check a file in the directory tree
-			dir = search->dir;
+	fs_indexStats.rebuilds++;
+}
 
-			netpath = FS_BuildOSPath( dir->path, dir->gamedir, filename );
 
-			temp = Sys_FOpen( netpath, "rb" );
-			if ( temp == NULL ) {
-				continue;
+/*
+=================
+FS_FreeIndex
+=================
+*/
+static void FS_FreeIndex( void ) {
+	int i;
+
+	for ( i = 0; i < fs_fileIndex.numDirs; i++ ) {
+		FS_UnindexDirectory( fs_fileIndex.dirs[i]->dir );
+	}
+	if ( fs_fileIndex.dirs ) {
+		Z_Free( fs_fileIndex.dirs );
+	}
+	if ( fs_fileIndex.table ) {
+		Z_Free( fs_fileIndex.table );
+	}
+	if ( fs_fileIndex.entries ) {
+		Z_Free( fs_fileIndex.entries );
+	}
+
+	Com_Memset( &fs_fileIndex, 0, sizeof( fs_fileIndex ) );
+}
+
+
+/*
+=================
+FS_BuildIndex
+=================
+*/
+static void FS_BuildIndex( void ) {
+	searchpath_t *search;
+	int start;
+
+	FS_FreeIndex();
+	FS_NumberSearchPaths();
+
+	if ( !fs_index->integer ) {
+		return;
+	}
+
+	start = Sys_Milliseconds();
+
+	fs_fileIndex.dirs = Z_Malloc( ( fs_dirCount + fs_pk3dirCount + 1 ) * sizeof( fs_fileIndex.dirs[0] ) );
+	for ( search = fs_searchpaths; search; search = search->next ) {
+		if ( search->dir ) {
+			fs_fileIndex.dirs[ fs_fileIndex.numDirs++ ] = search;
+			FS_IndexDirectory( search->dir );
+		}
+	}
+
+	FS_BuildIndexTable();
+
+	fs_fileIndex.lastPoll = Sys_Milliseconds();
+	fs_indexStats.buildTime = fs_fileIndex.lastPoll - start;
+}
+
+
+/*
+=================
+FS_PollIndex
+
+Picks up files created in indexed directories since the last poll
+=================
+*/
+static void FS_PollIndex( void ) {
+	qboolean changed;
+	directory_t *dir;
+	int i, now;
+
+	now = Sys_Milliseconds();
+	if ( now == fs_fileIndex.lastPoll && !fs_fileIndex.pollNow ) {
+		return;
+	}
+
+	fs_fileIndex.lastPoll = now;
+	fs_fileIndex.pollNow = qfalse;
+
+	changed = qfalse;
+	for ( i = 0; i < fs_fileIndex.numDirs; i++ ) {
+		dir = fs_fileIndex.dirs[i]->dir;
+		if ( dir->indexWatch && Sys_TreeChanged( dir->indexWatch ) ) {
+			FS_IndexDirectory( dir );
+			changed = qtrue;
+		}
+	}
+
+	if ( changed ) {
+		FS_BuildIndexTable();
+	}
+}
+
+
+/*
+=================
+FS_IndexChanged
+
+Called after the filesystem itself has created a file, so the
+next lookup doesn't wait for the poll interval
+=================
+*/
+static void FS_IndexChanged( void ) {
+	fs_fileIndex.pollNow = qtrue;
+}
+
+
+/*
+=================
+FS_FirstSearchPath
+
+Starts iterating the search paths that may have the file, in search
+path order. That is either every search path, or the candidates from
+the index followed by the directories that aren't indexed
+=================
+*/
+static searchpath_t *FS_FirstSearchPath( searchIter_t *it, const char *filename, long fullHash ) {
+	const fileIndex_t *entry;
+	searchpath_t *search;
+	int i, j;
+
+	it->count = 0;
+	it->current = 0;
+	it->walk = NULL;
+
+	if ( !fs_fileIndex.table || !FS_IndexableName( filename ) ) {
+		it->walk = fs_searchpaths;
+		return it->walk;
+	}
+
+	FS_PollIndex();
+
+	for ( entry = fs_fileIndex.table[ fullHash & ( fs_fileIndex.tableSize - 1 ) ]; entry; entry = entry->next ) {
+		if ( FS_FilenameCompare( entry->name, filename ) ) {
+			continue;
+		}
+		// a pak may have the same name twice
+		for ( i = 0; i < it->count; i++ ) {
+			if ( it->list[i] == entry->search ) {
+				break;
 			}
+		}
+		if ( i < it->count ) {
+			continue;
+		}
+		if ( it->count == FS_INDEX_MAX_CANDIDATES ) {
+			it->walk = fs_searchpaths;
+			return it->walk;
+		}
+		it->list[ it->count++ ] = entry->search;
+	}
 
-			*file = FS_HandleForFile();
-			f = &fsh[ *file ];
-			FS_InitHandle( f );
+	for ( i = 0; i < fs_fileIndex.numDirs; i++ ) {
+		if ( fs_fileIndex.dirs[i]->dir->indexNames ) {
+			continue;
+		}
+		if ( it->count == FS_INDEX_MAX_CANDIDATES ) {
+			it->walk = fs_searchpaths;
+			return it->walk;
+		}
+		it->list[ it->count++ ] = fs_fileIndex.dirs[i];
+	}
 
-			f->handleFiles.file.o = temp;
-			Q_strncpyz( f->name, filename, sizeof( f->name ) );
-			f->zipFile = qfalse;
+	// insertion sort, there are only a few
+	for ( i = 1; i < it->count; i++ ) {
+		search = it->list[i];
+		for ( j = i; j > 0 && it->list[j-1]->order > search->order; j-- ) {
+			it->list[j] = it->list[j-1];
+		}
+		it->list[j] = search;
+	}
 
-			if ( fs_debug->integer ) {
-				Com_Printf( "%s: %s (found in '%s/%s')\n", __func__, filename,
-					dir->path, dir->gamedir );
+	fs_indexStats.indexed++;
+
+	return it->count ? it->list[0] : NULL;
+}
+
+
+/*
+=================
+FS_NextSearchPath
+=================
+*/
+static searchpath_t *FS_NextSearchPath( searchIter_t *it ) {
+	if ( it->walk ) {
+		it->walk = it->walk->next;
+		return it->walk;
+	}
+
+	if ( ++it->current >= it->count ) {
+		return NULL;
+	}
+
+	return it->list[ it->current ];
+}
+
+
+/*
+=================
+FS_CountSkippedProbes
+
+Indexed loose directories before the winner that would have been probed,
+ignores filters so it is an upper bound
+=================
+*/
+static void FS_CountSkippedProbes( const searchIter_t *it, const searchpath_t *found ) {
+	const directory_t *dir;
+	int i, j;
+
+	if ( it->walk ) {
+		return;
+	}
+
+	for ( i = 0; i < fs_fileIndex.numDirs; i++ ) {
+		if ( found && fs_fileIndex.dirs[i]->order >= found->order ) {
+			continue;
+		}
+		dir = fs_fileIndex.dirs[i]->dir;
+		if ( !dir->indexNames ) {
+			continue;
+		}
+		for ( j = 0; j < it->count; j++ ) {
+			if ( it->list[j] == fs_fileIndex.dirs[i] ) {
+				break;
 			}
+		}
+		if ( j == it->count ) {
+			fs_indexStats.skipped++;
+		}
+	}
+}
 
-			return FS_FileLength( f->handleFiles.file.o );
+
+/*
+=================
+FS_ProbeDirectory
+
+Opens a loose file, timed for fs_stats
+=================
+*/
+static FILE *FS_ProbeDirectory( const directory_t *dir, const char *filename ) {
+	const char *netpath;
+	int64_t start;
+	FILE *f;
+
+	netpath = FS_BuildOSPath( dir->path, dir->gamedir, filename );
+
+	start = Sys_Microseconds();
+	f = Sys_FOpen( netpath, "rb" );
+	fs_indexStats.probeTime += Sys_Microseconds() - start;
+	fs_indexStats.probes++;
+
+	return f;
+}
+
+
+static void FS_PrintListStats( void );
+static void FS_PrintAsyncStats( void );
+static void FS_PrintPrefetchStats( void );
+
+/*
+=================
+FS_PrintScanStats
+=================
+*/
+static void FS_PrintScanStats( void ) {
+	Com_Printf( "pk3 scan: %i read on %i thread%s in %.3f msec, %i cached, %.3f msec building packs\n",
+		fs_scanStats.scanned, fs_scanStats.threads, fs_scanStats.threads == 1 ? "" : "s",
+		fs_scanStats.scanTime / 1000.0, fs_scanStats.cached, fs_scanStats.buildTime / 1000.0 );
+}
+
+
+/*
+=================
+FS_Stats_f
+=================
+*/
+static void FS_Stats_f( void ) {
+	int i, indexed;
+
+	if ( Cmd_Argc() > 1 && !Q_stricmp( Cmd_Argv( 1 ), "reset" ) ) {
+		fs_indexStats.lookups = 0;
+		fs_indexStats.indexed = 0;
+		fs_indexStats.probes = 0;
+		fs_indexStats.skipped = 0;
+		fs_indexStats.probeTime = 0;
+		fs_indexStats.lookupTime = 0;
+		fs_listStats.lists = 0;
+		fs_listStats.indexed = 0;
+		fs_listStats.examined = 0;
+		fs_listStats.listTime = 0;
+		return;
+	}
+
+	FS_PrintScanStats();
+	FS_PrintListStats();
+	FS_PrintAsyncStats();
+	FS_PrintPrefetchStats();
+
+	indexed = 0;
+	for ( i = 0; i < fs_fileIndex.numDirs; i++ ) {
+		if ( fs_fileIndex.dirs[i]->dir->indexNames ) {
+			indexed++;
 		}
 	}
 
-#ifdef FS_MISSING
-	if ( missingFiles ) {
-		fprintf( missingFiles, "%s\n", filename );
+	if ( fs_fileIndex.table ) {
+		Com_Printf( "index: %i files, %i/%i loose directories, built in %i msec, %i rebuilds\n",
+			fs_fileIndex.numEntries, indexed, fs_fileIndex.numDirs, fs_indexStats.buildTime, fs_indexStats.rebuilds );
+	} else {
+		Com_Printf( "index: disabled\n" );
+	}
+
+	Com_Printf( "lookups: %i, %i through the index, %.3f msec total\n",
+		fs_indexStats.lookups, fs_indexStats.indexed, fs_indexStats.lookupTime / 1000.0 );
+	Com_Printf( "loose directory opens: %i, %.3f msec total\n",
+		fs_indexStats.probes, fs_indexStats.probeTime / 1000.0 );
+
+	if ( fs_indexStats.probes ) {
+		Com_Printf( "loose directory opens avoided: %i, about %.3f msec saved\n", fs_indexStats.skipped,
+			fs_indexStats.skipped * (double)fs_indexStats.probeTime / fs_indexStats.probes / 1000.0 );
+	} else {
+		Com_Printf( "loose directory opens avoided: %i\n", fs_indexStats.skipped );
+	}
+}
+
+
+/*
+===========
+FS_FOpenFileRead
+
+Finds the file in the search path.
+Returns filesize and an open FILE pointer.
+Used for streaming data out of either a
+separate file or a ZIP file.
+===========
+*/
+extern qboolean		com_fullyInitialized;
+
+// see FS_FOpenFileRead_Filtered
+static int fs_filter_flag = 0;
+
+void FS_SetFilterFlag(int flag)
+{
+	fs_filter_flag = flag;
+}
+
+static int FS_FindFile( const char *filename, fileHandle_t *file, qboolean uniqueFILE ) {
+	searchIter_t	it;
+	searchpath_t	*search;
+	pack_t			*pak;
+	fileInPack_t	*pakFile;
+	directory_t		*dir;
+	long			hash;
+	long			fullHash;
+	FILE			*temp;
+	int				length;
+	fileHandleData_t *f;
+
+	if ( !fs_searchpaths ) {
+		Com_Error( ERR_FATAL, "Filesystem call made without initialization" );
+	}
+
+	if ( !filename ) {
+		Com_Error( ERR_FATAL, "FS_FOpenFileRead: NULL 'filename' parameter passed" );
+	}
+
+	// qpaths are not supposed to have a leading slash
+	if ( filename[0] == '/' || filename[0] == '\\' ) {
+		filename++;
+	}
+
+	// make absolutely sure that it can't back up the path.
+	// The searchpaths do guarantee that something will always
+	// be prepended, so we don't need to worry about "c:" or "//limbo"
+	if ( FS_CheckDirTraversal( filename ) ) {
+		*file = FS_INVALID_HANDLE;
+		return -1;
+	}
+
+	// we will calculate full hash only once then just mask it by current pack->hashSize
+	// we can do that as long as we know properties of our hash function
+	fullHash = FS_HashFileName( filename, 0U );
+
+	if ( file == NULL ) {
+		// just wants to see if file is there
+		for ( search = FS_FirstSearchPath( &it, filename, fullHash ) ; search ; search = FS_NextSearchPath( &it ) ) {
+			// is the element a pak file?
+			if ( search->pack && search->pack->hashTable[ (hash = fullHash & (search->pack->hashSize-1)) ] ) {
+				if (fs_filter_flag & FS_EXCLUDE_PK3)
+					continue;
+				if (fs_filter_flag & FS_EXCLUDE_ETMAIN)
+				{
+					if (FS_IsBaseGame(search->pack->pakGamename))
+						continue;
+				}
+				if (fs_filter_flag & FS_EXCLUDE_OTHERGAMES)
+				{
+					if (Q_stricmp(search->pack->pakGamename, fs_gamedir) != 0)
+						continue;
+				}
+				// skip non-pure files
+				if ( !FS_PakIsPure( search->pack ) )
+					continue;
+				// look through all the pak file elements
+				pak = search->pack;
+				pakFile = pak->hashTable[hash];
+				do {
+					// case and separator insensitive comparisons
+					if ( !FS_FilenameCompare( pakFile->name, filename ) ) {
+						// found it!
+						FS_CountSkippedProbes( &it, search );
+						return pakFile->size; 
+					}
+					pakFile = pakFile->next;
+				} while ( pakFile != NULL );
+			} else if ( search->dir /*&& search->policy != DIR_DENY*/ ) {
+				if (fs_filter_flag & FS_EXCLUDE_DIR)
+					continue;
+				if (fs_filter_flag & FS_EXCLUDE_ETMAIN)
+				{
+					if (FS_IsBaseGame(search->dir->gamedir))
+						continue;
+				}
+				if (fs_filter_flag & FS_EXCLUDE_OTHERGAMES)
+				{
+					if (Q_stricmp(search->dir->gamedir, fs_gamedir) != 0)
+						continue;
+				}
+				if ( search->policy == DIR_DENY && fs_numServerPaks )
+				{
+					// allowed non-ref extensions
+					static const char *extList[] = { "cfg", "menu", "game", "dat", "botents" };
+					static const char *demoList[] = { DEMOEXT "84", DEMOEXT "85" };
+
+					if ( !FS_HasExt( filename, extList, ARRAY_LEN( extList ) ) &&
+						!FS_HasExt( filename, demoList, ARRAY_LEN( demoList ) ) &&
+						!FS_IsExt( filename, "bots.txt", strlen( filename ) ) )
+					{
+						continue;
+					}
+				}
+
+				dir = search->dir;
+				temp = FS_ProbeDirectory( dir, filename );
+				if ( temp ) {
+					length = FS_FileLength( temp );
+					fclose( temp );
+					FS_CountSkippedProbes( &it, search );
+					return length;
+				}
+			}
+		}
+		FS_CountSkippedProbes( &it, NULL );
+		return -1;
+	}
+
+	// make sure the q3key file is only readable by the quake3.exe at initialization
+	// any other time the key should only be accessed in memory using the provided functions
+	if ( com_fullyInitialized && strstr( filename, "etkey" ) ) {
+		*file = FS_INVALID_HANDLE;
+		return -1;
+	}
+
+	//
+	// search through the path, one element at a time
+	//
+	for ( search = FS_FirstSearchPath( &it, filename, fullHash ) ; search ; search = FS_NextSearchPath( &it ) ) {
+		// is the element a pak file?
+		if ( search->pack && search->pack->hashTable[ (hash = fullHash & (search->pack->hashSize-1)) ] ) {
+			if (fs_filter_flag & FS_EXCLUDE_PK3)
+			{
+				continue;
+			}
+			if (fs_filter_flag & FS_EXCLUDE_ETMAIN)
+			{
+				if (FS_IsBaseGame(search->pack->pakGamename))
+				{
+					continue;
+				}
+			}
+			if (fs_filter_flag & FS_EXCLUDE_OTHERGAMES)
+			{
+				if (Q_stricmp(search->pack->pakGamename, fs_gamedir) != 0)
+				{
+					continue;
+				}
+			}
+			// disregard if it doesn't match one of the allowed pure pak files
+			if ( !FS_PakIsPure( search->pack ) ) {
+				continue;
+			}
+			// look through all the pak file elements
+			pak = search->pack;
+			pakFile = pak->hashTable[hash];
+			do {
+				// case and separator insensitive comparisons
+				if ( !FS_FilenameCompare( pakFile->name, filename ) ) {
+					// found it!
+					FS_CountSkippedProbes( &it, search );
+					return FS_OpenFileInPak( file, pak, pakFile, uniqueFILE );
+				}
+				pakFile = pakFile->next;
+			} while ( pakFile != NULL );
+		} else if ( search->dir /*&& search->policy != DIR_DENY*/ ) {
+			if (fs_filter_flag & FS_EXCLUDE_DIR)
+			{
+				continue;
+			}
+			if (fs_filter_flag & FS_EXCLUDE_ETMAIN)
+			{
+				if (FS_IsBaseGame(search->dir->gamedir))
+				{
+					continue;
+				}
+			}
+			if (fs_filter_flag & FS_EXCLUDE_OTHERGAMES)
+			{
+				if (Q_stricmp(search->dir->gamedir, fs_gamedir) != 0)
+				{
+					continue;
+				}
+			}
+			if ( search->policy == DIR_DENY && fs_numServerPaks )
+			{
+				// allowed non-ref extensions
+				static const char *extList[] = { "cfg", "menu", "game", "dat", "botents" };
+				static const char *demoList[] = { DEMOEXT "84", DEMOEXT "85" };
+
+				if ( !FS_HasExt( filename, extList, ARRAY_LEN( extList ) ) &&
+					!FS_HasExt( filename, demoList, ARRAY_LEN( demoList ) ) &&
+					!FS_IsExt( filename, "bots.txt", strlen( filename ) ) )
+				{
+					continue;
+				}
+			}
+			// check a file in the directory tree
+			dir = search->dir;
+
+			temp = FS_ProbeDirectory( dir, filename );
+			if ( temp == NULL ) {
+				continue;
+			}
+
+			FS_CountSkippedProbes( &it, search );
+
+			*file = FS_HandleForFile();
+			f = &fsh[ *file ];
+			FS_InitHandle( f );
+
+			f->handleFiles.file.o = temp;
+			Q_strncpyz( f->name, filename, sizeof( f->name ) );
+			f->zipFile = qfalse;
+
+			if ( fs_debug->integer ) {
+				Com_Printf( "%s: %s (found in '%s/%s')\n", __func__, filename,
+					dir->path, dir->gamedir );
+			}
+
+			return FS_FileLength( f->handleFiles.file.o );
+		}
+	}
+
+#ifdef FS_MISSING
+	if ( missingFiles ) {
+		fprintf( missingFiles, "%s\n", filename );
+	}
+#endif
+
+	FS_CountSkippedProbes( &it, NULL );
+
+	*file = FS_INVALID_HANDLE;
+	return -1;
+}
+
+
+int FS_FOpenFileRead( const char *filename, fileHandle_t *file, qboolean uniqueFILE ) {
+	int64_t start;
+	int length;
+
+	start = Sys_Microseconds();
+	length = FS_FindFile( filename, file, uniqueFILE );
+	fs_indexStats.lookupTime += Sys_Microseconds() - start;
+	fs_indexStats.lookups++;
+
+	return length;
+}
+
+
+int FS_FOpenFileRead_Filtered( const char *qpath, fileHandle_t *file, qboolean uniqueFILE, int filter_flag ) {
+	int ret;
+
+	fs_filter_flag = filter_flag;
+	ret = FS_FOpenFileRead( qpath, file, uniqueFILE );
+	fs_filter_flag = 0;
+
+	return ret;
+}
+
+
+/*
+===========
+FS_TouchFileInPak
+===========
+*/
+int FS_TouchFileInPak(const char *filename) {
+	const searchpath_t *search;
+	long			fullHash, hash;
+	pack_t			*pak;
+	fileInPack_t	*pakFile;
+
+	fullHash = FS_HashFileName( filename, 0U );
+
+	for ( search = fs_searchpaths ; search ; search = search->next ) {
+		
+		// is the element a pak file?
+		if ( !search->pack )
+			continue;
+		
+		if ( search->pack->exclude ) // skip paks in \fs_excludeReference list
+			continue;
+
+		if ( search->pack->hashTable[ (hash = fullHash & (search->pack->hashSize-1)) ] ) {
+			pak = search->pack;
+			pakFile = pak->hashTable[hash];
+			do {
+				// case and separator insensitive comparisons
+				if ( !FS_FilenameCompare( pakFile->name, filename ) ) {
+					// found it!
+					FS_ReferencePakFile( pak, filename );
+					return pak->referenced;
+				}
+				pakFile = pakFile->next;
+			} while ( pakFile != NULL );
+		}
+	}
+	return 0;
+}
+
+
+/*
+===========
+FS_Home_FOpenFileRead
+===========
+*/
+int FS_Home_FOpenFileRead( const char *filename, fileHandle_t *file ) 
+{
+	char path[ MAX_OSPATH*3 + 1 ];
+	fileHandleData_t *fd;
+	fileHandle_t f;	
+
+	if ( !fs_searchpaths ) {
+		Com_Error( ERR_FATAL, "Filesystem call made without initialization" );
+	}
+
+	// should never happen but for safe
+	if ( !file ) { 
+		return -1;
+	}
+
+	// allocate new file handle
+	f = FS_HandleForFile(); 
+	fd = &fsh[ f ];
+	FS_InitHandle( fd );
+
+	Com_sprintf( path, sizeof( path ), "%s%c%s%c%s", fs_homepath->string,
+		PATH_SEP, fs_gamedir, PATH_SEP, filename );
+
+	if ( fs_debug->integer ) {
+		Com_Printf( "%s: %s\n", __func__, path );
+	}
+
+	fd->handleFiles.file.o = Sys_FOpen( path, "rb" );
+	if ( fd->handleFiles.file.o != NULL ) {
+		Q_strncpyz( fd->name, filename, sizeof( fd->name ) );
+		fd->handleSync = qfalse;
+		fd->zipFile = qfalse;
+		*file = f;
+		return FS_FileLength( fd->handleFiles.file.o );
+	}
+
+	*file = FS_INVALID_HANDLE;
+	return -1;
+}
+
+
+// TTimo
+// relevant to client only
+#if !defined(DEDICATED)
+/*
+==================
+FS_CL_ExtractFromPakFile
+
+NERVE - SMF - Extracts the latest file from a pak file.
+
+Compares packed file against extracted file. If no differences, does not copy.
+This is necessary for exe/dlls which may or may not be locked.
+
+NOTE TTimo:
+  fullpath gives the full OS path to the dll that will potentially be loaded
+	on win32 it's always in fs_basepath/<fs_game>/
+	on linux it can be in fs_homepath/<fs_game>/ or fs_basepath/<fs_game>/
+  the dll is extracted to fs_homepath (== fs_basepath on win32) if needed
+
+  the return value doesn't tell wether file was extracted or not, it just says wether it's ok to continue
+  (i.e. either the right file was extracted successfully, or it was already present)
+
+  cvar_lastVersion is the optional name of a CVAR_ARCHIVE used to store the wolf version for the last extracted .so
+  show_bug.cgi?id=463
+
+==================
+*/
+qboolean FS_CL_ExtractFromPakFile(const char *fullpath, const char *gamedir, const char *filename, const char *cvar_lastVersion)
+{
+	int srcLength;
+	int destLength;
+	byte *srcData;
+	byte *destData;
+	qboolean needToCopy = qtrue;
+	FILE *destHandle;
+
+	// read in compressed file (force it to exclude files from directories)
+	fs_filter_flag = FS_EXCLUDE_DIR;
+	srcLength = FS_ReadFile(filename, (void **)&srcData);
+	fs_filter_flag = 0;
+
+	// if its not in the pak, we bail
+	if (srcLength <= 0)
+	{
+		return qfalse;
+	}
+
+	// read in local file
+	destHandle = Sys_FOpen(fullpath, "rb");
+
+	// if we have a local file, we need to compare the two
+	if (destHandle)
+	{
+		fseek(destHandle, 0, SEEK_END);
+		destLength = ftell(destHandle);
+		fseek(destHandle, 0, SEEK_SET);
+
+		if (destLength > 0)
+		{
+			destData = (byte *)Z_Malloc(destLength);
+
+			//			fread( destData, 1, destLength, destHandle );
+			if (fread(destData, destLength, 1, destHandle) != 1 && (!feof(destHandle) || ferror(destHandle)))
+			{
+				Z_Free(destData);
+				FS_FreeFile(srcData);
+				fclose(destHandle);
+				Com_Error(ERR_FATAL, "FS_CL_ExtractFromPakFile: Short read '%s'", filename);
+			}
+
+			// compare files
+			if (destLength == srcLength)
+			{
+				if (memcmp(srcData, destData, srcLength) == 0)
+				{
+					needToCopy = qfalse;
+				}
+			}
+
+			Z_Free(destData); // TTimo
+		}
+
+		fclose(destHandle);
+	}
+
+	// write file
+	if (needToCopy)
+	{
+		fileHandle_t f;
+
+		// Com_DPrintf("FS_ExtractFromPakFile: FS_FOpenFileWrite '%s'\n", filename);
+		f = FS_FOpenDLLWrite(filename);
+		if (f == FS_INVALID_HANDLE)
+		{
+			Com_Printf("Failed to open %s\n", filename);
+			FS_FreeFile(srcData);
+			return qfalse;
+		}
+
+		FS_Write(srcData, srcLength, f);
+
+		FS_FCloseFile(f);
+
+#ifdef __linux__
+		// show_bug.cgi?id=463
+		// need to keep track of what versions we extract
+		if (cvar_lastVersion)
+		{
+			Cvar_Set(cvar_lastVersion, Cvar_VariableString("version"));
+		}
+#endif
+	}
+
+	FS_FreeFile(srcData);
+	return qtrue;
+}
+#endif
+
+
+/*
+==============
+FS_AllowDeletion
+==============
+*/
+static qboolean FS_AllowDeletion(const char *filename)
+{
+	// for safety, only allow deletion from the save, profiles and demo directory
+	if (Q_strncmp(filename, "save/", 5) != 0 &&
+		Q_strncmp(filename, "profiles/", 9) != 0 &&
+		Q_strncmp(filename, "demos/", 6) != 0 &&
+		!strstr(filename, ".pid"))
+	{
+		return qfalse;
+	}
+
+	return qtrue;
+}
+
+
+/*
+==============
+FS_DeleteDir
+==============
+*/
+static int FS_DeleteDir(const char *dirname, qboolean nonEmpty, qboolean recursive)
+{
+	const char *ospath;
+	char **pFiles = NULL;
+	int i, nFiles = 0;
+
+	if (!fs_searchpaths)
+	{
+		Com_Error(ERR_FATAL, "Filesystem call made without initialization");
+	}
+
+	if (!dirname || dirname[0] == 0)
+	{
+		return 0;
+	}
+
+	if (!FS_AllowDeletion(dirname))
+	{
+		return 0;
+	}
+
+	if (recursive)
+	{
+		ospath = FS_BuildOSPath(fs_homepath->string, fs_gamedir, dirname);
+		pFiles = Sys_ListFiles(ospath, "/", NULL, &nFiles, qfalse);
+		for (i = 0; i < nFiles; i++)
+		{
+			char temp[MAX_OSPATH];
+
+			if (!Q_stricmp(pFiles[i], "..") || !Q_stricmp(pFiles[i], "."))
+			{
+				continue;
+			}
+
+			Com_sprintf(temp, sizeof(temp), "%s/%s", dirname, pFiles[i]);
+
+			if (!FS_DeleteDir(temp, nonEmpty, recursive))
+			{
+				return 0;
+			}
+		}
+		Sys_FreeFileList(pFiles);
+	}
+
+	if (nonEmpty)
+	{
+		ospath = FS_BuildOSPath(fs_homepath->string, fs_gamedir, dirname);
+		pFiles = Sys_ListFiles(ospath, NULL, NULL, &nFiles, qfalse);
+		for (i = 0; i < nFiles; i++)
+		{
+			ospath = FS_BuildOSPath(fs_homepath->string, fs_gamedir, va("%s/%s", dirname, pFiles[i]));
+
+			if (remove(ospath) == -1)
+			{ // failure
+				return 0;
+			}
+		}
+		Sys_FreeFileList(pFiles);
+	}
+
+	ospath = FS_BuildOSPath(fs_homepath->string, fs_gamedir, dirname);
+
+	if (Q_rmdir(ospath) == 0)
+	{
+		return 1;
+	}
+
+	return 0;
+}
+
+
+/*
+==============
+FS_Delete
+TTimo - this was not in the 1.30 filesystem code
+using fs_homepath for the file to remove
+==============
+*/
+int FS_Delete(const char *filename)
+{
+	const char *ospath;
+	int stat;
+
+	if (!fs_searchpaths)
+	{
+		Com_Error(ERR_FATAL, "Filesystem call made without initialization");
+	}
+
+	if (!filename || filename[0] == 0)
+	{
+		return 0;
+	}
+
+	if (!FS_AllowDeletion(filename))
+	{
+		return 0;
+	}
+
+	FS_CheckFilenameIsNotAllowed(filename, __func__, qfalse);
+
+	ospath = FS_BuildOSPath(fs_homepath->string, fs_gamedir, filename);
+
+	stat = Sys_PathIsDir(ospath);
+	if (stat == -1)
+	{
+		return 0;
+	}
+
+	if (stat == 1)
+	{
+		return (FS_DeleteDir(filename, qtrue, qtrue));
+	}
+	else
+	{
+		if (remove(ospath) != -1)
+		{ // success
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+
+/*
+=================
+FS_Read
+
+Properly handles partial reads
+=================
+*/
+int FS_Read( void *buffer, int len, fileHandle_t f ) {
+	int		block, remaining;
+	int		read;
+	byte	*buf;
+	int		tries;
+
+	if ( !fs_searchpaths ) {
+		Com_Error( ERR_FATAL, "Filesystem call made without initialization" );
+	}
+
+	if ( f <= 0 || f >= MAX_FILE_HANDLES ) {
+		return 0;
+	}
+
+	FS_DetachLog( f );
+
+	buf = (byte *)buffer;
+	//fs_readCount += len;
+
+	if ( !fsh[f].zipFile ) {
+		remaining = len;
+		tries = 0;
+		while (remaining) {
+			block = remaining;
+			read = fread( buf, 1, block, fsh[f].handleFiles.file.o );
+			if (read == 0) {
+				// we might have been trying to read from a CD, which
+				// sometimes returns a 0 read on windows
+				if (!tries) {
+					tries = 1;
+				} else {
+					return len-remaining;	//Com_Error (ERR_FATAL, "FS_Read: 0 bytes read");
+				}
+			}
+
+			if (read == -1) {
+				Com_Error (ERR_FATAL, "FS_Read: -1 bytes read");
+			}
+
+			remaining -= read;
+			buf += read;
+		}
+		return len;
+	} else {
+		return unzReadCurrentFile( fsh[f].handleFiles.file.z, buffer, len );
+	}
+}
+
+
+/*
+=================
+FS_ReadWhole
+
+Reads a freshly opened file in one go, pk3 entries skip
+the streaming decoder
+=================
+*/
+static int FS_ReadWhole( void *buffer, int len, fileHandle_t f ) {
+	if ( fsh[f].zipFile ) {
+		return unzReadCurrentFileWhole( fsh[f].handleFiles.file.z, buffer, len );
+	}
+	return FS_Read( buffer, len, f );
+}
+
+
+/*
+=================
+FS_Write
+
+Properly handles partial writes
+=================
+*/
+int FS_Write( const void *buffer, int len, fileHandle_t h ) {
+	int		block, remaining;
+	int		written;
+	byte	*buf;
+	int		tries;
+	FILE	*f;
+
+	if ( !fs_searchpaths ) {
+		Com_Error( ERR_FATAL, "Filesystem call made without initialization" );
+	}
+
+	// ENSI NOTE q3e has commented out <= 0 and >= max handles
+	//if ( !h ) {
+	//	return 0;
+	//}
+
+	if ( fsh[h].logStream ) {
+		if ( Com_LogWrite( fsh[h].logStream - 1, buffer, len ) ) {
+			return len;
+		}
+		// the writer has been shut down and wrote out the rest
+		fsh[h].logStream = 0;
+	}
+
+	f = FS_FileForHandle(h);
+	buf = (byte *)buffer;
+
+	remaining = len;
+	tries = 0;
+	while (remaining) {
+		block = remaining;
+		written = fwrite (buf, 1, block, f);
+		if (written == 0) {
+			if (!tries) {
+				tries = 1;
+			} else {
+				Com_Printf( "%s: 0 bytes written (%d attempted)\n", __func__, block );
+				return 0;
+			}
+		}
+
+		if (written < 0) {
+			Com_Printf( "%s: %d bytes written (%d attempted)\n", __func__, written, block );
+			return 0;
+		}
+
+		remaining -= written;
+		buf += written;
+	}
+	if ( fsh[h].handleSync ) {
+		fflush( f );
+	}
+	return len;
+}
+
+void FORMAT_PRINTF(2, 3) QDECL FS_Printf( fileHandle_t h, const char *fmt, ... ) {
+	va_list		argptr;
+	char		msg[MAXPRINTMSG];
+
+	va_start (argptr,fmt);
+	Q_vsnprintf (msg, sizeof(msg), fmt, argptr);
+	va_end (argptr);
+
+	FS_Write(msg, strlen(msg), h);
+}
+
+#define PK3_SEEK_BUFFER_SIZE 65536
+
+/*
+=================
+FS_Seek
+
+=================
+*/
+int FS_Seek( fileHandle_t f, long offset, fsOrigin_t origin ) {
+	int		_origin;
+
+	if ( !fs_searchpaths ) {
+		Com_Error( ERR_FATAL, "Filesystem call made without initialization" );
+		return -1;
+	}
+
+	FS_DetachLog( f );
+
+	if ( fsh[f].zipFile == qtrue ) {
+		//FIXME: this is really, really crappy
+		//(but better than what was here before)
+		byte	buffer[PK3_SEEK_BUFFER_SIZE];
+		int		remainder;
+		int		currentPosition = FS_FTell( f );
+
+		// change negative offsets into FS_SEEK_SET
+		if ( offset < 0 ) {
+			switch( origin ) {
+				case FS_SEEK_END:
+					remainder = fsh[f].zipFileLen + offset;
+					break;
+
+				case FS_SEEK_CUR:
+					remainder = currentPosition + offset;
+					break;
+
+				case FS_SEEK_SET:
+				default:
+					remainder = 0;
+					break;
+			}
+
+			if ( remainder < 0 ) {
+				remainder = 0;
+			}
+
+			origin = FS_SEEK_SET;
+		} else {
+			if ( origin == FS_SEEK_END ) {
+				remainder = fsh[f].zipFileLen - currentPosition + offset;
+			} else {
+				remainder = offset;
+			}
+		}
+
+		switch( origin ) {
+			case FS_SEEK_SET:
+				if ( remainder == currentPosition ) {
+					return offset;
+				}
+				unzSetCurrentFileInfoPosition( fsh[f].handleFiles.file.z, fsh[f].zipFilePos );
+				unzOpenCurrentFile( fsh[f].handleFiles.file.z );
+				//fallthrough
+
+			case FS_SEEK_END:
+			case FS_SEEK_CUR:
+				while( remainder > PK3_SEEK_BUFFER_SIZE ) {
+					FS_Read( buffer, PK3_SEEK_BUFFER_SIZE, f );
+					remainder -= PK3_SEEK_BUFFER_SIZE;
+				}
+				FS_Read( buffer, remainder, f );
+				return offset;
+
+			default:
+				Com_Error( ERR_FATAL, "Bad origin in FS_Seek" );
+				return -1;
+		}
+	} else {
+		FILE *file;
+		file = FS_FileForHandle( f );
+		switch( origin ) {
+		case FS_SEEK_CUR:
+			_origin = SEEK_CUR;
+			break;
+		case FS_SEEK_END:
+			_origin = SEEK_END;
+			break;
+		case FS_SEEK_SET:
+			_origin = SEEK_SET;
+			break;
+		default:
+			Com_Error( ERR_FATAL, "Bad origin in FS_Seek" );
+			return -1;
+		}
+
+		return fseek( file, offset, _origin );
+	}
+}
+
+
+/*
+======================================================================================
+
+CONVENIENCE FUNCTIONS FOR ENTIRE FILES
+
+======================================================================================
+*/
+
+static byte *FS_TakePrefetched( fileHandle_t h, const char *qpath, int length );
+static qboolean FS_CopyPrefetched( fileHandle_t h, const char *qpath, void *buffer, int length );
+
+qboolean FS_FileIsInPAK( const char *filename, int *pChecksum, char *pakName ) {
+	const searchpath_t	*search;
+	const pack_t		*pak;
+	const fileInPack_t	*pakFile;
+	long			hash;
+	long			fullHash;
+
+	if ( !fs_searchpaths ) {
+		Com_Error( ERR_FATAL, "Filesystem call made without initialization" );
+	}
+
+	if ( !filename ) {
+		Com_Error( ERR_FATAL, "FS_FileIsInPAK: NULL 'filename' parameter passed" );
+	}
+
+	// qpaths are not supposed to have a leading slashes
+	while ( filename[0] == '/' || filename[0] == '\\' )
+		filename++;
+
+	// make absolutely sure that it can't back up the path.
+	// The searchpaths do guarantee that something will always
+	// be prepended, so we don't need to worry about "c:" or "//limbo"
+	if ( FS_CheckDirTraversal( filename ) ) {
+		return qfalse;
+	}
+
+	if (fs_filter_flag & FS_EXCLUDE_PK3) {
+		return qfalse;
+	}
+
+	fullHash = FS_HashFileName( filename, 0U );
+
+	//
+	// search through the path, one element at a time
+	//
+	for ( search = fs_searchpaths ; search ; search = search->next ) {
+
+		// is the element a pak file?
+		if ( search->pack && search->pack->hashTable[ (hash = fullHash & (search->pack->hashSize-1)) ] ) {
+			// disregard if it doesn't match one of the allowed pure pak files
+			//if ( !FS_PakIsPure( search->pack ) ) {
+			//	continue;
+			//}
+			//
+			if ( search->pack->exclude ) {
+				continue;
+			}
+
+			if (fs_filter_flag & FS_EXCLUDE_ETMAIN)
+			{
+				if (FS_IsBaseGame(search->pack->pakGamename))
+				{
+					continue;
+				}
+			}
+			if (fs_filter_flag & FS_EXCLUDE_OTHERGAMES)
+			{
+				if (Q_stricmp(search->pack->pakGamename, fs_gamedir) != 0)
+				{
+					continue;
+				}
+			}
+
+			// look through all the pak file elements
+			pak = search->pack;
+			pakFile = pak->hashTable[hash];
+			do {
+				// case and separator insensitive comparisons
+				if ( !FS_FilenameCompare( pakFile->name, filename ) ) {
+					if ( pChecksum ) {
+						*pChecksum = pak->pure_checksum;
+					}
+					if ( pakName ) {
+						Com_sprintf( pakName, MAX_OSPATH, "%s/%s", pak->pakGamename, pak->pakBasename );
+					}
+					return qtrue;
+				}
+				pakFile = pakFile->next;
+			} while ( pakFile != NULL );
+		}
+	}
+	return qfalse;
+}
+
+
+/*
+============
+FS_ReadFile
+
+Filename are relative to the quake search path
+a null buffer will just return the file length without loading
+============
+*/
+int FS_ReadFile( const char *qpath, void **buffer ) {
+	fileHandle_t	h;
+	byte*			buf;
+	qboolean		isConfig;
+	long			len;
+
+	if ( !fs_searchpaths ) {
+		Com_Error( ERR_FATAL, "Filesystem call made without initialization" );
+	}
+
+	if ( !qpath || !qpath[0] ) {
+		Com_Error( ERR_FATAL, "FS_ReadFile with empty name" );
+	}
+
+	buf = NULL;	// quiet compiler warning
+	isConfig = qfalse;
+
+	// if this is a .cfg file and we are playing back a journal, read
+	// it from the journal file
+	if ( com_journalDataFile != FS_INVALID_HANDLE && strstr( qpath, ".cfg" ) ) {
+		if ( com_journal->integer == 2 ) {
+			int		r;
+
+			Com_DPrintf( "Loading %s from journal file.\n", qpath );
+			r = FS_Read( &len, sizeof( len ), com_journalDataFile );
+			if ( r != sizeof( len ) ) {
+				if (buffer != NULL) *buffer = NULL;
+				return -1;
+			}
+			// if the file didn't exist when the journal was created
+			if (!len) {
+				if (buffer == NULL) {
+					return 1;			// hack for old journal files
+				}
+				*buffer = NULL;
+				return -1;
+			}
+			if (buffer == NULL) {
+				return len;
+			}
+
+			buf = Hunk_AllocateTempMemory(len+1);
+			*buffer = buf;
+
+			r = FS_Read( buf, len, com_journalDataFile );
+			if ( r != len ) {
+				Com_Error( ERR_FATAL, "Read from journalDataFile failed" );
+			}
+
+			fs_loadCount++;
+			fs_loadStack++;
+
+			// guarantee that it will have a trailing 0 for string operations
+			buf[len] = '\0';
+
+			return len;
+		} else if ( com_journal->integer == 1 ) {
+			isConfig = qtrue;
+		}
+	}
+
+	// look for it in the filesystem or pack files
+	len = FS_FOpenFileRead( qpath, &h, qfalse );
+	if ( h == FS_INVALID_HANDLE ) {
+		if ( buffer ) {
+			*buffer = NULL;
+		}
+		// if we are journaling and it is a config file, write a zero to the journal file
+		if ( isConfig ) {
+			Com_DPrintf( "Writing zero for %s to journal file.\n", qpath );
+			len = 0;
+			FS_Write( &len, sizeof( len ), com_journalDataFile );
+			FS_Flush( com_journalDataFile );
+		}
+		return -1;
+	}
+
+	if ( !buffer ) {
+		if ( isConfig ) {
+			Com_DPrintf( "Writing len for %s to journal file.\n", qpath );
+			FS_Write( &len, sizeof( len ), com_journalDataFile );
+			FS_Flush( com_journalDataFile );
+		}
+		FS_FCloseFile( h );
+		return len;
+	}
+
+	buf = Hunk_AllocateTempMemory( len + 1 );
+	*buffer = buf;
+
+	if ( !FS_CopyPrefetched( h, qpath, buf, len ) ) {
+		FS_ReadWhole( buf, len, h );
+	}
+
+	fs_loadCount++;
+	fs_loadStack++;
+
+	// guarantee that it will have a trailing 0 for string operations
+	buf[ len ] = '\0';
+	FS_FCloseFile( h );
+
+	// if we are journaling and it is a config file, write it to the journal file
+	if ( isConfig ) {
+		Com_DPrintf( "Writing %s to journal file.\n", qpath );
+		FS_Write( &len, sizeof( len ), com_journalDataFile );
+		FS_Write( buf, len, com_journalDataFile );
+		FS_Flush( com_journalDataFile );
+	}
+	return len;
+}
+
+
+int FS_ReadFile_Filtered( const char *qpath, void **buffer, int filter_flag  ) {
+	int ret;
+
+	fs_filter_flag = filter_flag;
+	ret = FS_ReadFile( qpath, buffer );
+	fs_filter_flag = 0;
+
+	return ret;
+}
+
+
+/*
+=============
+FS_FreeFile
+=============
+*/
+void FS_FreeFile( void *buffer ) {
+	if ( !fs_searchpaths ) {
+		Com_Error( ERR_FATAL, "Filesystem call made without initialization" );
+	}
+	if ( !buffer ) {
+		Com_Error( ERR_FATAL, "FS_FreeFile( NULL )" );
+	}
+	fs_loadStack--;
+
+	Hunk_FreeTempMemory( buffer );
+
+	// if all of our temp files are free, clear all of our space
+	if ( fs_loadStack == 0 ) {
+		Hunk_ClearTempMemory();
+	}
+}
+
+
+/*
+=============================================================================
+
+MAPPED FILES
+
+Read only views of game files for loaders that only parse them. Pk3 entries
+stored without compression are mapped straight from disk, everything else
+falls back to a temp hunk copy like FS_ReadFile. Loose files are always
+copied, another process truncating a mapped file would raise SIGBUS on the
+next access, while pk3 files are not rewritten as long as they are loaded.
+
+=============================================================================
+*/
+
+#define MAX_FILE_MAPPINGS	64
+#define FS_MAP_MIN_SIZE		( 16 * 1024 )	// smaller files are cheaper to copy
+
+typedef struct {
+	const byte		*data;
+	int				length;
+	sysMapping_t	*mapping;
+} fileMapping_t;
+
+static fileMapping_t fs_mappings[ MAX_FILE_MAPPINGS ];
+
+
+/*
+============
+FS_MapHandle
+
+Maps the remaining length bytes of a freshly opened pk3 entry,
+returns NULL if the file can't be mapped
+============
+*/
+static sysMapping_t *FS_MapHandle( fileHandle_t h, int length, const void **data ) {
+	fileHandleData_t *fd = &fsh[ h ];
+	unsigned long pos;
+	int stored;
+
+	if ( !fd->zipFile ) {
+		return NULL;
+	}
+
+	if ( unzGetCurrentFileDataPos( fd->handleFiles.file.z, &pos, &stored ) == UNZ_OK && stored ) {
+		return Sys_MapFile( ((unz_s *)fd->handleFiles.file.z)->file, pos, length, data );
+	}
+
+	return NULL;
+}
+
+
+/*
+============
+FS_MapFile
+
+Returns a read only image of the file that must be released with
+FS_UnmapFile. Unlike FS_ReadFile there is no trailing 0 byte
+============
+*/
+int FS_MapFile( const char *qpath, const void **buffer ) {
+	fileMapping_t	*m;
+	fileHandle_t	h;
+	byte			*buf;
+	int				len;
+	int				i;
+
+	if ( !fs_searchpaths ) {
+		Com_Error( ERR_FATAL, "Filesystem call made without initialization" );
+	}
+
+	if ( !qpath || !qpath[0] ) {
+		Com_Error( ERR_FATAL, "FS_MapFile with empty name" );
+	}
+
+	// journaled configs have to go through the journal
+	if ( com_journalDataFile != FS_INVALID_HANDLE && strstr( qpath, ".cfg" ) ) {
+		return FS_ReadFile( qpath, (void **)buffer );
+	}
+
+	*buffer = NULL;
+
+	len = FS_FOpenFileRead( qpath, &h, qfalse );
+	if ( h == FS_INVALID_HANDLE ) {
+		return -1;
+	}
+
+	if ( len >= FS_MAP_MIN_SIZE ) {
+		for ( i = 0, m = fs_mappings; i < MAX_FILE_MAPPINGS; i++, m++ ) {
+			if ( !m->mapping ) {
+				break;
+			}
+		}
+		// with all slots in use it is read like FS_ReadFile
+		if ( i < MAX_FILE_MAPPINGS ) {
+			m->mapping = FS_MapHandle( h, len, (const void **)&m->data );
+			if ( m->mapping ) {
+				m->length = len;
+				FS_FCloseFile( h );
+				fs_loadCount++;
+				*buffer = m->data;
+				return len;
+			}
+		}
+	}
+
+	buf = Hunk_AllocateTempMemory( len + 1 );
+	if ( !FS_CopyPrefetched( h, qpath, buf, len ) ) {
+		FS_ReadWhole( buf, len, h );
+	}
+	buf[ len ] = '\0';
+	FS_FCloseFile( h );
+
+	fs_loadCount++;
+	fs_loadStack++;
+
+	*buffer = buf;
+	return len;
+}
+
+
+/*
+=============
+FS_UnmapFile
+
+Also accepts pointers into the image
+=============
+*/
+void FS_UnmapFile( const void *buffer ) {
+	const byte		*p = (const byte *)buffer;
+	fileMapping_t	*m;
+	int				i;
+
+	if ( !buffer ) {
+		Com_Error( ERR_FATAL, "FS_UnmapFile( NULL )" );
+	}
+
+	for ( i = 0, m = fs_mappings; i < MAX_FILE_MAPPINGS; i++, m++ ) {
+		if ( m->mapping && p >= m->data && p <= m->data + m->length ) {
+			Sys_UnmapFile( m->mapping );
+			Com_Memset( m, 0, sizeof( *m ) );
+			return;
+		}
+	}
+
+	FS_FreeFile( (void *)buffer );
+}
+
+
+/*
+=============================================================================
+
+SHARED WORLD MAP IMAGE
+
+The clip model and the renderer both parse the same bsp right after each
+other, so a single read only image is kept between the two loads. Pk3
+entries stored without compression are mapped straight from disk, loose
+files and deflated entries are read once into a private copy.
+
+=============================================================================
+*/
+
+typedef struct {
+	char			name[MAX_QPATH];
+	const void		*data;
+	int				length;
+	int				refs;
+	sysMapping_t	*mapping;		// mapped image
+	void			*copy;			// or decompressed image
+} bspImage_t;
+
+static bspImage_t fs_bsp;
+
+
+/*
+============
+FS_MapBSP
+============
+*/
+static void FS_MapBSP( fileHandle_t h, int length ) {
+	fs_bsp.mapping = FS_MapHandle( h, length, &fs_bsp.data );
+
+	if ( fs_bsp.mapping ) {
+		return;
+	}
+
+	fs_bsp.copy = FS_TakePrefetched( h, fs_bsp.name, length );
+	if ( fs_bsp.copy ) {
+		fs_bsp.data = fs_bsp.copy;
+		return;
+	}
+
+	fs_bsp.copy = malloc( length );
+	if ( !fs_bsp.copy ) {
+		FS_FCloseFile( h );
+		Com_Error( ERR_DROP, "%s: couldn't allocate %i bytes for %s", __func__, length, fs_bsp.name );
+	}
+
+	if ( FS_ReadWhole( fs_bsp.copy, length, h ) != length ) {
+		free( fs_bsp.copy );
+		fs_bsp.copy = NULL;
+		FS_FCloseFile( h );
+		Com_Error( ERR_DROP, "%s: short read on %s", __func__, fs_bsp.name );
+	}
+
+	fs_bsp.data = fs_bsp.copy;
+}
+
+
+/*
+============
+FS_ReadBSP
+
+Returns a read only image of the world map, without a trailing 0 byte
+============
+*/
+int FS_ReadBSP( const char *qpath, const void **buffer ) {
+	fileHandle_t	h;
+	int				len;
+
+	if ( !fs_searchpaths ) {
+		Com_Error( ERR_FATAL, "Filesystem call made without initialization" );
+	}
+
+	if ( !qpath || !qpath[0] ) {
+		Com_Error( ERR_FATAL, "FS_ReadBSP with empty name" );
+	}
+
+	if ( fs_bsp.data && !Q_stricmp( fs_bsp.name, qpath ) ) {
+		fs_bsp.refs++;
+		*buffer = fs_bsp.data;
+		return fs_bsp.length;
+	}
+
+	// the image is still in use by another map
+	if ( fs_bsp.refs ) {
+		return FS_ReadFile( qpath, (void **)buffer );
+	}
+
+	FS_FlushBSP();
+
+	len = FS_FOpenFileRead( qpath, &h, qfalse );
+	if ( h == FS_INVALID_HANDLE ) {
+		*buffer = NULL;
+		return -1;
+	}
+
+	if ( len <= 0 ) {
+		FS_FCloseFile( h );
+		*buffer = NULL;
+		return -1;
+	}
+
+	Q_strncpyz( fs_bsp.name, qpath, sizeof( fs_bsp.name ) );
+	FS_MapBSP( h, len );
+	FS_FCloseFile( h );
+
+	fs_bsp.length = len;
+	fs_bsp.refs = 1;
+	fs_loadCount++;
+
+	if ( fs_debug->integer ) {
+		Com_Printf( "%s: %s (%s)\n", __func__, qpath, fs_bsp.mapping ? "mapped" : "copied" );
+	}
+
+	*buffer = fs_bsp.data;
+	return len;
+}
+
+
+/*
+=============
+FS_FreeBSP
+=============
+*/
+void FS_FreeBSP( const void *buffer ) {
+	if ( !buffer ) {
+		Com_Error( ERR_FATAL, "FS_FreeBSP( NULL )" );
 	}
-#endif
 
-	*file = FS_INVALID_HANDLE;
-	return -1;
-}
+	if ( buffer != fs_bsp.data ) {
+		FS_FreeFile( (void *)buffer );
+		return;
+	}
 
+	if ( fs_bsp.refs > 0 ) {
+		fs_bsp.refs--;
+	}
 
-int FS_FOpenFileRead_Filtered( const char *qpath, fileHandle_t *file, qboolean uniqueFILE, int filter_flag ) {
-	int ret;
+	if ( fs_bsp.refs > 0 ) {
+		return;
+	}
 
-	fs_filter_flag = filter_flag;
-	ret = FS_FOpenFileRead( qpath, file, uniqueFILE );
-	fs_filter_flag = 0;
+#ifndef DEDICATED
+	// keep it for the renderer when there is one
+	if ( com_cl_running && com_cl_running->integer ) {
+		return;
+	}
+#endif
 
-	return ret;
+	FS_FlushBSP();
 }
 
 
 /*
-===========
-FS_TouchFileInPak
-===========
+=============
+FS_FlushBSP
+=============
 */
-int FS_TouchFileInPak(const char *filename) {
-	const searchpath_t *search;
-	long			fullHash, hash;
-	pack_t			*pak;
-	fileInPack_t	*pakFile;
-
-	fullHash = FS_HashFileName( filename, 0U );
-
-	for ( search = fs_searchpaths ; search ; search = search->next ) {
-		
-		// is the element a pak file?
-		if ( !search->pack )
-			continue;
-		
-		if ( search->pack->exclude ) // skip paks in \fs_excludeReference list
-			continue;
-
-		if ( search->pack->hashTable[ (hash = fullHash & (search->pack->hashSize-1)) ] ) {
-			pak = search->pack;
-			pakFile = pak->hashTable[hash];
-			do {
-				// case and separator insensitive comparisons
-				if ( !FS_FilenameCompare( pakFile->name, filename ) ) {
-					// found it!
-					if ( !( pak->referenced & FS_GENERAL_REF ) && FS_GeneralRef( filename, pak->pakFilename ) ) {
-						pak->referenced |= FS_GENERAL_REF;
-					}
-					if ( !( pak->referenced & FS_CGAME_REF ) && !FS_FilenameCompare( filename, SYS_DLLNAME_CGAME ) ) {
-						pak->referenced |= FS_CGAME_REF;
-					}
-					if ( !( pak->referenced & FS_UI_REF ) && !FS_FilenameCompare( filename, SYS_DLLNAME_UI ) ) {
-						pak->referenced |= FS_UI_REF;
-					}
-					return pak->referenced;
-				}
-				pakFile = pakFile->next;
-			} while ( pakFile != NULL );
-		}
+void FS_FlushBSP( void ) {
+	if ( fs_bsp.mapping ) {
+		Sys_UnmapFile( fs_bsp.mapping );
 	}
-	return 0;
+	if ( fs_bsp.copy ) {
+		free( fs_bsp.copy );
+	}
+	Com_Memset( &fs_bsp, 0, sizeof( fs_bsp ) );
 }
 
 
 /*
-===========
-FS_Home_FOpenFileRead
-===========
+============
+FS_WriteFile
+
+Filename are relative to the quake search path
+============
 */
-int FS_Home_FOpenFileRead( const char *filename, fileHandle_t *file ) 
-{
-	char path[ MAX_OSPATH*3 + 1 ];
-	fileHandleData_t *fd;
-	fileHandle_t f;	
+void FS_WriteFile( const char *qpath, const void *buffer, int size ) {
+	fileHandle_t f;
 
 	if ( !fs_searchpaths ) {
 		Com_Error( ERR_FATAL, "Filesystem call made without initialization" );
 	}
 
-	// should never happen but for safe
-	if ( !file ) { 
-		return -1;
+	if ( !qpath || !buffer ) {
+		Com_Error( ERR_FATAL, "FS_WriteFile: NULL parameter" );
 	}
 
-	// allocate new file handle
-	f = FS_HandleForFile(); 
-	fd = &fsh[ f ];
-	FS_InitHandle( fd );
-
-	Com_sprintf( path, sizeof( path ), "%s%c%s%c%s", fs_homepath->string,
-		PATH_SEP, fs_gamedir, PATH_SEP, filename );
-
-	if ( fs_debug->integer ) {
-		Com_Printf( "%s: %s\n", __func__, path );
+	f = FS_FOpenFileWrite( qpath );
+	if ( f == FS_INVALID_HANDLE ) {
+		Com_Printf( "Failed to open %s\n", qpath );
+		return;
 	}
 
-	fd->handleFiles.file.o = Sys_FOpen( path, "rb" );
-	if ( fd->handleFiles.file.o != NULL ) {
-		Q_strncpyz( fd->name, filename, sizeof( fd->name ) );
-		fd->handleSync = qfalse;
-		fd->zipFile = qfalse;
-		*file = f;
-		return FS_FileLength( fd->handleFiles.file.o );
-	}
+	FS_Write( buffer, size, f );
 
-	*file = FS_INVALID_HANDLE;
-	return -1;
+	FS_FCloseFile( f );
 }
 
 
-// TTimo
-// relevant to client only
-#if !defined(DEDICATED)
-/*
-==================
-FS_CL_ExtractFromPakFile
-
-NERVE - SMF - Extracts the latest file from a pak file.
-
-Compares packed file against extracted file. If no differences, does not copy.
-This is necessary for exe/dlls which may or may not be locked.
 
-NOTE TTimo:
-  fullpath gives the full OS path to the dll that will potentially be loaded
-	on win32 it's always in fs_basepath/<fs_game>/
-	on linux it can be in fs_homepath/<fs_game>/ or fs_basepath/<fs_game>/
-  the dll is extracted to fs_homepath (== fs_basepath on win32) if needed
+/*
+=============================================================================
 
-  the return value doesn't tell wether file was extracted or not, it just says wether it's ok to continue
-  (i.e. either the right file was extracted successfully, or it was already present)
+ASYNCHRONOUS READS
 
-  cvar_lastVersion is the optional name of a CVAR_ARCHIVE used to store the wolf version for the last extracted .so
-  show_bug.cgi?id=463
+FS_ReadFileAsync finds the file on the main thread, so pure checks and
+filters behave exactly like FS_ReadFile. The pak is only referenced when
+the data is handed to its callback, prefetches that are never used stay
+out of the referenced and pure checksum lists. Reading and
+decompressing is left to a few worker threads, which open pk3 files on
+their own (like unzReOpen does for unique handles) and only use malloc.
+Completions are handed back to the main thread by FS_AsyncFrame, which
+Com_EventLoop calls once all events are processed.
 
-==================
+=============================================================================
 */
-qboolean FS_CL_ExtractFromPakFile(const char *fullpath, const char *gamedir, const char *filename, const char *cvar_lastVersion)
-{
-	int srcLength;
-	int destLength;
-	byte *srcData;
-	byte *destData;
-	qboolean needToCopy = qtrue;
-	FILE *destHandle;
-
-	// read in compressed file (force it to exclude files from directories)
-	fs_filter_flag = FS_EXCLUDE_DIR;
-	srcLength = FS_ReadFile(filename, (void **)&srcData);
-	fs_filter_flag = 0;
 
-	// if its not in the pak, we bail
-	if (srcLength <= 0)
-	{
-		return qfalse;
-	}
+#define MAX_ASYNC_REQUESTS	256
+#define MAX_ASYNC_THREADS	8
 
-	// read in local file
-	destHandle = Sys_FOpen(fullpath, "rb");
+typedef enum {
+	ASYNC_FREE,
+	ASYNC_QUEUED,
+	ASYNC_RUNNING,
+	ASYNC_DONE
+} asyncState_t;
 
-	// if we have a local file, we need to compare the two
-	if (destHandle)
-	{
-		fseek(destHandle, 0, SEEK_END);
-		destLength = ftell(destHandle);
-		fseek(destHandle, 0, SEEK_SET);
+typedef struct {
+	asyncState_t		state;
+	int					id;
+	int					priority;
+	qboolean			cancelled;
+	char				qpath[ MAX_ZPATH ];
+	char				*pakFilename;	// NULL for loose files
+	unsigned long		zipPos;
+	FILE				*file;			// loose file, opened on the main thread
+	int					length;
+	byte				*buffer;		// NULL if the read failed
+	fsAsyncCallback_t	callback;
+	void				*userdata;
+	qboolean			reference;		// reference the pak on delivery
+} asyncRequest_t;
 
-		if (destLength > 0)
-		{
-			destData = (byte *)Z_Malloc(destLength);
+typedef struct {
+	char				*pakFilename;	// currently open pk3
+	unz_s				zip;
+} asyncWorker_t;
+
+static struct {
+	asyncRequest_t		requests[ MAX_ASYNC_REQUESTS ];
+	asyncWorker_t		workers[ MAX_ASYNC_THREADS ];
+	sysThread_t			*threads[ MAX_ASYNC_THREADS ];
+	int					numThreads;
+	qboolean			initialized;
+	qboolean			quit;
+	sysMutex_t			*lock;			// guards requests, inFlight and quit
+	sysSemaphore_t		*wake;
+	int					nextId;
+	int					pending;		// requests not delivered yet, main thread only
+	int					inFlight;		// bytes held by running and finished requests
+	int					budget;
+} fs_async;
+
+static struct {
+	int					requests;
+	int					completed;
+	int					failed;
+	int					cancelled;
+	double				bytes;
+	int					peakInFlight;
+} fs_asyncStats;
 
-			//			fread( destData, 1, destLength, destHandle );
-			if (fread(destData, destLength, 1, destHandle) != 1 && (!feof(destHandle) || ferror(destHandle)))
-			{
-				Z_Free(destData);
-				FS_FreeFile(srcData);
-				fclose(destHandle);
-				Com_Error(ERR_FATAL, "FS_CL_ExtractFromPakFile: Short read '%s'", filename);
-			}
 
-			// compare files
-			if (destLength == srcLength)
-			{
-				if (memcmp(srcData, destData, srcLength) == 0)
-				{
-					needToCopy = qfalse;
-				}
-			}
+/*
+=================
+FS_AsyncRead
 
-			Z_Free(destData); // TTimo
-		}
+Reads one request into a fresh malloc'd buffer, runs on the workers
+=================
+*/
+static void FS_AsyncRead( asyncWorker_t *worker, asyncRequest_t *req )
+{
+	byte *buf;
+	int r;
 
-		fclose(destHandle);
+	buf = malloc( req->length + 1 );
+	if ( !buf ) {
+		return;
 	}
 
-	// write file
-	if (needToCopy)
-	{
-		fileHandle_t f;
-
-		// Com_DPrintf("FS_ExtractFromPakFile: FS_FOpenFileWrite '%s'\n", filename);
-		f = FS_FOpenDLLWrite(filename);
-		if (f == FS_INVALID_HANDLE)
-		{
-			Com_Printf("Failed to open %s\n", filename);
-			FS_FreeFile(srcData);
-			return qfalse;
+	if ( req->file ) {
+		r = ( req->length == 0 || fread( buf, req->length, 1, req->file ) == 1 ) ? req->length : -1;
+		fclose( req->file );
+		req->file = NULL;
+	} else {
+		// keep the last pk3 open, requests usually come in batches from the same one
+		if ( worker->pakFilename && strcmp( worker->pakFilename, req->pakFilename ) ) {
+			unzCloseInto( &worker->zip );
+			free( worker->pakFilename );
+			worker->pakFilename = NULL;
+		}
+		if ( !worker->pakFilename && unzOpenInto( req->pakFilename, &worker->zip ) == UNZ_OK ) {
+			// the request keeps its own name, the main thread may still look at it
+			worker->pakFilename = malloc( strlen( req->pakFilename ) + 1 );
+			if ( worker->pakFilename ) {
+				strcpy( worker->pakFilename, req->pakFilename );
+			} else {
+				unzCloseInto( &worker->zip );
+			}
 		}
+		r = worker->pakFilename ? unzReadEntryInto( &worker->zip, req->zipPos, buf, req->length ) : -1;
+	}
 
-		FS_Write(srcData, srcLength, f);
-
-		FS_FCloseFile(f);
-
-#ifdef __linux__
-		// show_bug.cgi?id=463
-		// need to keep track of what versions we extract
-		if (cvar_lastVersion)
-		{
-			Cvar_Set(cvar_lastVersion, Cvar_VariableString("version"));
-		}
-#endif
+	if ( r != req->length ) {
+		free( buf );
+		return;
 	}
 
-	FS_FreeFile(srcData);
-	return qtrue;
+	// guarantee that it will have a trailing 0 for string operations
+	buf[ req->length ] = '\0';
+	req->buffer = buf;
 }
-#endif
 
 
 /*
-==============
-FS_AllowDeletion
-==============
+=================
+FS_AsyncNextRequest
+
+Highest priority queued request that fits in the memory budget,
+oldest first. Called with the lock held
+=================
 */
-static qboolean FS_AllowDeletion(const char *filename)
+static asyncRequest_t *FS_AsyncNextRequest( void )
 {
-	// for safety, only allow deletion from the save, profiles and demo directory
-	if (Q_strncmp(filename, "save/", 5) != 0 &&
-		Q_strncmp(filename, "profiles/", 9) != 0 &&
-		Q_strncmp(filename, "demos/", 6) != 0 &&
-		!strstr(filename, ".pid"))
-	{
-		return qfalse;
+	asyncRequest_t *req, *best;
+	int i;
+
+	best = NULL;
+	for ( i = 0, req = fs_async.requests; i < MAX_ASYNC_REQUESTS; i++, req++ ) {
+		if ( req->state != ASYNC_QUEUED ) {
+			continue;
+		}
+		if ( !best || req->priority > best->priority || ( req->priority == best->priority && req->id < best->id ) ) {
+			best = req;
+		}
 	}
 
-	return qtrue;
+	// a request larger than the whole budget runs alone
+	if ( best && fs_async.inFlight > 0 && fs_async.inFlight + best->length > fs_async.budget ) {
+		return NULL;
+	}
+
+	return best;
 }
 
 
 /*
-==============
-FS_DeleteDir
-==============
+=================
+FS_AsyncWorker
+=================
 */
-static int FS_DeleteDir(const char *dirname, qboolean nonEmpty, qboolean recursive)
+static void FS_AsyncWorker( void *arg )
 {
-	const char *ospath;
-	char **pFiles = NULL;
-	int i, nFiles = 0;
+	asyncWorker_t *worker = (asyncWorker_t *)arg;
+	asyncRequest_t *req;
 
-	if (!fs_searchpaths)
-	{
-		Com_Error(ERR_FATAL, "Filesystem call made without initialization");
-	}
+	Sys_LockMutex( fs_async.lock );
 
-	if (!dirname || dirname[0] == 0)
-	{
-		return 0;
+	while ( !fs_async.quit ) {
+		req = FS_AsyncNextRequest();
+		if ( !req ) {
+			Sys_UnlockMutex( fs_async.lock );
+			Sys_WaitSemaphore( fs_async.wake );
+			Sys_LockMutex( fs_async.lock );
+			continue;
+		}
+
+		req->state = ASYNC_RUNNING;
+		fs_async.inFlight += req->length;
+		fs_asyncStats.peakInFlight = MAX( fs_asyncStats.peakInFlight, fs_async.inFlight );
+		Sys_UnlockMutex( fs_async.lock );
+
+		FS_AsyncRead( worker, req );
+
+		Sys_LockMutex( fs_async.lock );
+		req->state = ASYNC_DONE;
 	}
 
-	if (!FS_AllowDeletion(dirname))
-	{
-		return 0;
+	Sys_UnlockMutex( fs_async.lock );
+
+	if ( worker->pakFilename ) {
+		unzCloseInto( &worker->zip );
+		free( worker->pakFilename );
+		worker->pakFilename = NULL;
 	}
+}
 
-	if (recursive)
-	{
-		ospath = FS_BuildOSPath(fs_homepath->string, fs_gamedir, dirname);
-		pFiles = Sys_ListFiles(ospath, "/", NULL, &nFiles, qfalse);
-		for (i = 0; i < nFiles; i++)
-		{
-			char temp[MAX_OSPATH];
 
-			if (!Q_stricmp(pFiles[i], "..") || !Q_stricmp(pFiles[i], "."))
-			{
-				continue;
-			}
+/*
+=================
+FS_AsyncInit
 
-			Com_sprintf(temp, sizeof(temp), "%s/%s", dirname, pFiles[i]);
+Starts the workers on first use. With no threads requests are
+read one at a time by FS_AsyncFrame
+=================
+*/
+static void FS_AsyncInit( void )
+{
+	int i, numThreads;
 
-			if (!FS_DeleteDir(temp, nonEmpty, recursive))
-			{
-				return 0;
-			}
-		}
-		Sys_FreeFileList(pFiles);
+	if ( fs_async.initialized ) {
+		return;
 	}
 
-	if (nonEmpty)
-	{
-		ospath = FS_BuildOSPath(fs_homepath->string, fs_gamedir, dirname);
-		pFiles = Sys_ListFiles(ospath, NULL, NULL, &nFiles, qfalse);
-		for (i = 0; i < nFiles; i++)
-		{
-			ospath = FS_BuildOSPath(fs_homepath->string, fs_gamedir, va("%s/%s", dirname, pFiles[i]));
+	fs_async.initialized = qtrue;
+	fs_async.quit = qfalse;
+	fs_async.numThreads = 0;
 
-			if (remove(ospath) == -1)
-			{ // failure
-				return 0;
-			}
-		}
-		Sys_FreeFileList(pFiles);
+	numThreads = MIN( fs_asyncThreads->integer, MAX_ASYNC_THREADS );
+	if ( numThreads <= 0 ) {
+		return;
 	}
 
-	ospath = FS_BuildOSPath(fs_homepath->string, fs_gamedir, dirname);
+	fs_async.lock = Sys_CreateMutex();
+	fs_async.wake = Sys_CreateSemaphore();
+	if ( !fs_async.lock || !fs_async.wake ) {
+		if ( fs_async.lock ) {
+			Sys_DestroyMutex( fs_async.lock );
+			fs_async.lock = NULL;
+		}
+		if ( fs_async.wake ) {
+			Sys_DestroySemaphore( fs_async.wake );
+			fs_async.wake = NULL;
+		}
+		Com_Printf( S_COLOR_YELLOW "Couldn't create async read locks, reading on the main thread\n" );
+		return;
+	}
 
-	if (Q_rmdir(ospath) == 0)
-	{
-		return 1;
+	for ( i = 0; i < numThreads; i++ ) {
+		fs_async.threads[i] = Sys_CreateThread( FS_AsyncWorker, &fs_async.workers[i] );
+		if ( !fs_async.threads[i] ) {
+			break;
+		}
+		fs_async.numThreads++;
 	}
 
-	return 0;
+	if ( fs_async.numThreads == 0 ) {
+		Sys_DestroySemaphore( fs_async.wake );
+		Sys_DestroyMutex( fs_async.lock );
+		fs_async.wake = NULL;
+		fs_async.lock = NULL;
+		Com_Printf( S_COLOR_YELLOW "Couldn't start async read threads, reading on the main thread\n" );
+	}
 }
 
 
 /*
-==============
-FS_Delete
-TTimo - this was not in the 1.30 filesystem code
-using fs_homepath for the file to remove
-==============
+=================
+FS_AsyncLock
+=================
 */
-int FS_Delete(const char *filename)
+static void FS_AsyncLock( void )
 {
-	const char *ospath;
-	int stat;
-
-	if (!fs_searchpaths)
-	{
-		Com_Error(ERR_FATAL, "Filesystem call made without initialization");
+	if ( fs_async.lock ) {
+		Sys_LockMutex( fs_async.lock );
 	}
+}
 
-	if (!filename || filename[0] == 0)
-	{
-		return 0;
-	}
 
-	if (!FS_AllowDeletion(filename))
-	{
-		return 0;
+/*
+=================
+FS_AsyncUnlock
+=================
+*/
+static void FS_AsyncUnlock( void )
+{
+	if ( fs_async.lock ) {
+		Sys_UnlockMutex( fs_async.lock );
 	}
+}
 
-	FS_CheckFilenameIsNotAllowed(filename, __func__, qfalse);
-
-	ospath = FS_BuildOSPath(fs_homepath->string, fs_gamedir, filename);
 
-	stat = Sys_PathIsDir(ospath);
-	if (stat == -1)
-	{
-		return 0;
-	}
+/*
+=================
+FS_AsyncRelease
 
-	if (stat == 1)
-	{
-		return (FS_DeleteDir(filename, qtrue, qtrue));
-	}
-	else
-	{
-		if (remove(ospath) != -1)
-		{ // success
-			return 1;
-		}
+Frees everything a request still owns and marks its slot free,
+called with the lock held
+=================
+*/
+static void FS_AsyncRelease( asyncRequest_t *req )
+{
+	if ( req->file ) {
+		fclose( req->file );
 	}
-
-	return 0;
+	free( req->pakFilename );
+	free( req->buffer );
+	Com_Memset( req, 0, sizeof( *req ) );
+	fs_async.pending--;
 }
 
 
 /*
 =================
-FS_Read
-
-Properly handles partial reads
+FS_ReadFileAsync
 =================
 */
-int FS_Read( void *buffer, int len, fileHandle_t f ) {
-	int		block, remaining;
-	int		read;
-	byte	*buf;
-	int		tries;
+int FS_ReadFileAsync( const char *qpath, int priority, fsAsyncCallback_t callback, void *userdata )
+{
+	asyncRequest_t		*req;
+	fileHandleData_t	*fd;
+	fileHandle_t		h;
+	int					i, len;
 
 	if ( !fs_searchpaths ) {
 		Com_Error( ERR_FATAL, "Filesystem call made without initialization" );
 	}
 
-	if ( f <= 0 || f >= MAX_FILE_HANDLES ) {
+	if ( !qpath || !qpath[0] || !callback ) {
+		Com_Error( ERR_FATAL, "FS_ReadFileAsync with empty name or callback" );
+	}
+
+	// journaled config files have to be read in order
+	if ( com_journalDataFile != FS_INVALID_HANDLE && strstr( qpath, ".cfg" ) ) {
 		return 0;
 	}
 
-	buf = (byte *)buffer;
-	//fs_readCount += len;
+	FS_AsyncInit();
 
-	if ( !fsh[f].zipFile ) {
-		remaining = len;
-		tries = 0;
-		while (remaining) {
-			block = remaining;
-			read = fread( buf, 1, block, fsh[f].handleFiles.file.o );
-			if (read == 0) {
-				// we might have been trying to read from a CD, which
-				// sometimes returns a 0 read on windows
-				if (!tries) {
-					tries = 1;
-				} else {
-					return len-remaining;	//Com_Error (ERR_FATAL, "FS_Read: 0 bytes read");
-				}
-			}
+	if ( fs_async.pending >= MAX_ASYNC_REQUESTS ) {
+		return 0;
+	}
 
-			if (read == -1) {
-				Com_Error (ERR_FATAL, "FS_Read: -1 bytes read");
-			}
+	fs_noReference = qtrue;
+	len = FS_FOpenFileRead( qpath, &h, qfalse );
+	fs_noReference = qfalse;
+	if ( h == FS_INVALID_HANDLE ) {
+		return 0;
+	}
 
-			remaining -= read;
-			buf += read;
+	FS_AsyncLock();
+
+	for ( i = 0, req = fs_async.requests; i < MAX_ASYNC_REQUESTS; i++, req++ ) {
+		if ( req->state == ASYNC_FREE ) {
+			break;
 		}
-		return len;
+	}
+
+	fd = &fsh[ h ];
+	if ( fd->zipFile ) {
+		// workers free it, so it can't come from the zone
+		req->pakFilename = malloc( strlen( fd->pak->pakFilename ) + 1 );
+		if ( !req->pakFilename ) {
+			FS_AsyncUnlock();
+			FS_FCloseFile( h );
+			return 0;
+		}
+		strcpy( req->pakFilename, fd->pak->pakFilename );
+		req->zipPos = fd->zipFilePos;
 	} else {
-		return unzReadCurrentFile( fsh[f].handleFiles.file.z, buffer, len );
+		// the worker takes over the open file
+		req->file = fd->handleFiles.file.o;
+		fd->handleFiles.file.o = NULL;
+	}
+
+	Q_strncpyz( req->qpath, qpath, sizeof( req->qpath ) );
+	req->id = ++fs_async.nextId;
+	req->priority = priority;
+	req->length = len;
+	req->callback = callback;
+	req->userdata = userdata;
+	req->reference = qtrue;
+	req->state = ASYNC_QUEUED;
+
+	fs_async.budget = fs_asyncBudget->integer * 1024 * 1024;
+	fs_async.pending++;
+
+	FS_AsyncUnlock();
+
+	FS_FCloseFile( h );
+
+	if ( fs_async.wake ) {
+		Sys_PostSemaphore( fs_async.wake );
 	}
+
+	fs_asyncStats.requests++;
+	fs_loadCount++;
+
+	return req->id;
 }
 
 
 /*
 =================
-FS_Write
+FS_CancelAsync
 
-Properly handles partial writes
+The callback is not called for a cancelled request. Requests
+already being read are dropped when they finish
 =================
 */
-int FS_Write( const void *buffer, int len, fileHandle_t h ) {
-	int		block, remaining;
-	int		written;
-	byte	*buf;
-	int		tries;
-	FILE	*f;
+void FS_CancelAsync( int request )
+{
+	asyncRequest_t *req;
+	int i;
 
-	if ( !fs_searchpaths ) {
-		Com_Error( ERR_FATAL, "Filesystem call made without initialization" );
+	if ( request <= 0 ) {
+		return;
 	}
 
-	// ENSI NOTE q3e has commented out <= 0 and >= max handles
-	//if ( !h ) {
-	//	return 0;
-	//}
-
-	f = FS_FileForHandle(h);
-	buf = (byte *)buffer;
+	FS_AsyncLock();
 
-	remaining = len;
-	tries = 0;
-	while (remaining) {
-		block = remaining;
-		written = fwrite (buf, 1, block, f);
-		if (written == 0) {
-			if (!tries) {
-				tries = 1;
-			} else {
-				Com_Printf( "%s: 0 bytes written (%d attempted)\n", __func__, block );
-				return 0;
-			}
+	for ( i = 0, req = fs_async.requests; i < MAX_ASYNC_REQUESTS; i++, req++ ) {
+		if ( req->state == ASYNC_FREE || req->id != request ) {
+			continue;
 		}
-
-		if (written < 0) {
-			Com_Printf( "%s: %d bytes written (%d attempted)\n", __func__, written, block );
-			return 0;
+		if ( req->state == ASYNC_QUEUED ) {
+			FS_AsyncRelease( req );
+		} else {
+			req->cancelled = qtrue;
 		}
-
-		remaining -= written;
-		buf += written;
+		fs_asyncStats.cancelled++;
+		break;
 	}
-	if ( fsh[h].handleSync ) {
-		fflush( f );
+
+	FS_AsyncUnlock();
+}
+
+
+/*
+=================
+FS_ReferenceAsync
+
+The pak a request was read from may be gone after a filesystem
+restart, so it is looked up again by name
+=================
+*/
+static void FS_ReferenceAsync( const char *pakFilename, const char *qpath )
+{
+	const searchpath_t *search;
+
+	for ( search = fs_searchpaths; search; search = search->next ) {
+		if ( search->pack && !strcmp( search->pack->pakFilename, pakFilename ) ) {
+			FS_ReferencePakFile( search->pack, qpath );
+			return;
+		}
 	}
-	return len;
 }
 
-void FORMAT_PRINTF(2, 3) QDECL FS_Printf( fileHandle_t h, const char *fmt, ... ) {
-	va_list		argptr;
-	char		msg[MAXPRINTMSG];
 
-	va_start (argptr,fmt);
-	Q_vsnprintf (msg, sizeof(msg), fmt, argptr);
-	va_end (argptr);
+/*
+=================
+FS_FreeAsync
+
+Frees a buffer kept by an asynchronous read callback
+=================
+*/
+void FS_FreeAsync( void *buffer )
+{
+	free( buffer );
+}
+
 
-	FS_Write(msg, strlen(msg), h);
+/*
+=================
+FS_AsyncPending
+=================
+*/
+int FS_AsyncPending( void )
+{
+	return fs_async.pending;
 }
 
-#define PK3_SEEK_BUFFER_SIZE 65536
 
 /*
 =================
-FS_Seek
+FS_AsyncFrame
 
+Delivers finished reads on the main thread
 =================
 */
-int FS_Seek( fileHandle_t f, long offset, fsOrigin_t origin ) {
-	int		_origin;
+void FS_AsyncFrame( void )
+{
+	asyncRequest_t	done;
+	asyncRequest_t	*req;
+	int				i;
 
-	if ( !fs_searchpaths ) {
-		Com_Error( ERR_FATAL, "Filesystem call made without initialization" );
-		return -1;
+	if ( !fs_async.pending ) {
+		return;
 	}
 
-	if ( fsh[f].zipFile == qtrue ) {
-		//FIXME: this is really, really crappy
-		//(but better than what was here before)
-		byte	buffer[PK3_SEEK_BUFFER_SIZE];
-		int		remainder;
-		int		currentPosition = FS_FTell( f );
-
-		// change negative offsets into FS_SEEK_SET
-		if ( offset < 0 ) {
-			switch( origin ) {
-				case FS_SEEK_END:
-					remainder = fsh[f].zipFileLen + offset;
-					break;
+	// no workers, read the next request here
+	if ( !fs_async.numThreads ) {
+		req = FS_AsyncNextRequest();
+		if ( req ) {
+			req->state = ASYNC_RUNNING;
+			fs_async.inFlight += req->length;
+			fs_asyncStats.peakInFlight = MAX( fs_asyncStats.peakInFlight, fs_async.inFlight );
+			FS_AsyncRead( &fs_async.workers[0], req );
+			req->state = ASYNC_DONE;
+		}
+	}
 
-				case FS_SEEK_CUR:
-					remainder = currentPosition + offset;
-					break;
+	for ( i = 0; i < MAX_ASYNC_REQUESTS; i++ ) {
+		FS_AsyncLock();
 
-				case FS_SEEK_SET:
-				default:
-					remainder = 0;
-					break;
-			}
+		req = &fs_async.requests[i];
+		if ( req->state != ASYNC_DONE ) {
+			FS_AsyncUnlock();
+			continue;
+		}
 
-			if ( remainder < 0 ) {
-				remainder = 0;
-			}
+		fs_async.inFlight -= req->length;
 
-			origin = FS_SEEK_SET;
-		} else {
-			if ( origin == FS_SEEK_END ) {
-				remainder = fsh[f].zipFileLen - currentPosition + offset;
-			} else {
-				remainder = offset;
-			}
+		// the data is used now, count it like a synchronous read
+		if ( req->buffer && req->reference && !req->cancelled && req->pakFilename ) {
+			FS_ReferenceAsync( req->pakFilename, req->qpath );
 		}
 
-		switch( origin ) {
-			case FS_SEEK_SET:
-				if ( remainder == currentPosition ) {
-					return offset;
-				}
-				unzSetCurrentFileInfoPosition( fsh[f].handleFiles.file.z, fsh[f].zipFilePos );
-				unzOpenCurrentFile( fsh[f].handleFiles.file.z );
-				//fallthrough
+		// the slot is reused as soon as the lock is dropped
+		done = *req;
+		req->buffer = NULL;
+		FS_AsyncRelease( req );
 
-			case FS_SEEK_END:
-			case FS_SEEK_CUR:
-				while( remainder > PK3_SEEK_BUFFER_SIZE ) {
-					FS_Read( buffer, PK3_SEEK_BUFFER_SIZE, f );
-					remainder -= PK3_SEEK_BUFFER_SIZE;
-				}
-				FS_Read( buffer, remainder, f );
-				return offset;
+		FS_AsyncUnlock();
 
-			default:
-				Com_Error( ERR_FATAL, "Bad origin in FS_Seek" );
-				return -1;
+		if ( fs_async.wake ) {
+			Sys_PostSemaphore( fs_async.wake );
 		}
-	} else {
-		FILE *file;
-		file = FS_FileForHandle( f );
-		switch( origin ) {
-		case FS_SEEK_CUR:
-			_origin = SEEK_CUR;
-			break;
-		case FS_SEEK_END:
-			_origin = SEEK_END;
-			break;
-		case FS_SEEK_SET:
-			_origin = SEEK_SET;
-			break;
-		default:
-			Com_Error( ERR_FATAL, "Bad origin in FS_Seek" );
-			return -1;
+
+		if ( done.cancelled ) {
+			free( done.buffer );
+			continue;
 		}
 
-		return fseek( file, offset, _origin );
+		if ( done.buffer ) {
+			fs_asyncStats.completed++;
+			fs_asyncStats.bytes += done.length;
+		} else {
+			fs_asyncStats.failed++;
+			Com_Printf( S_COLOR_YELLOW "Couldn't read %s\n", done.qpath );
+		}
+
+		if ( !done.callback( done.userdata, done.qpath, done.buffer, done.buffer ? done.length : -1 ) ) {
+			free( done.buffer );
+		}
 	}
 }
 
 
 /*
-======================================================================================
+=================
+FS_PrintAsyncStats
+=================
+*/
+static void FS_PrintAsyncStats( void )
+{
+	Com_Printf( "async reads: %i requested, %i completed, %i failed, %i cancelled, %.1f MB, %.1f MB peak in flight, %i pending\n",
+		fs_asyncStats.requests, fs_asyncStats.completed, fs_asyncStats.failed, fs_asyncStats.cancelled,
+		fs_asyncStats.bytes / ( 1024 * 1024 ), fs_asyncStats.peakInFlight / ( 1024.0 * 1024.0 ), fs_async.pending );
+}
 
-CONVENIENCE FUNCTIONS FOR ENTIRE FILES
 
-======================================================================================
-*/
+/*
+=================
+FS_AsyncShutdown
 
-qboolean FS_FileIsInPAK( const char *filename, int *pChecksum, char *pakName ) {
-	const searchpath_t	*search;
-	const pack_t		*pak;
-	const fileInPack_t	*pakFile;
-	long			hash;
-	long			fullHash;
+Drops all requests without calling their callbacks and stops the workers
+=================
+*/
+static void FS_AsyncShutdown( void )
+{
+	int i;
 
-	if ( !fs_searchpaths ) {
-		Com_Error( ERR_FATAL, "Filesystem call made without initialization" );
+	if ( !fs_async.initialized ) {
+		return;
 	}
 
-	if ( !filename ) {
-		Com_Error( ERR_FATAL, "FS_FileIsInPAK: NULL 'filename' parameter passed" );
-	}
+	if ( fs_async.numThreads ) {
+		Sys_LockMutex( fs_async.lock );
+		fs_async.quit = qtrue;
+		Sys_UnlockMutex( fs_async.lock );
 
-	// qpaths are not supposed to have a leading slashes
-	while ( filename[0] == '/' || filename[0] == '\\' )
-		filename++;
+		for ( i = 0; i < fs_async.numThreads; i++ ) {
+			Sys_PostSemaphore( fs_async.wake );
+		}
+		for ( i = 0; i < fs_async.numThreads; i++ ) {
+			Sys_JoinThread( fs_async.threads[i] );
+			fs_async.threads[i] = NULL;
+		}
 
-	// make absolutely sure that it can't back up the path.
-	// The searchpaths do guarantee that something will always
-	// be prepended, so we don't need to worry about "c:" or "//limbo"
-	if ( FS_CheckDirTraversal( filename ) ) {
-		return qfalse;
+		Sys_DestroySemaphore( fs_async.wake );
+		Sys_DestroyMutex( fs_async.lock );
+		fs_async.wake = NULL;
+		fs_async.lock = NULL;
+	} else if ( fs_async.workers[0].pakFilename ) {
+		unzCloseInto( &fs_async.workers[0].zip );
+		free( fs_async.workers[0].pakFilename );
+		fs_async.workers[0].pakFilename = NULL;
 	}
 
-	if (fs_filter_flag & FS_EXCLUDE_PK3) {
-		return qfalse;
+	for ( i = 0; i < MAX_ASYNC_REQUESTS; i++ ) {
+		if ( fs_async.requests[i].state != ASYNC_FREE ) {
+			FS_AsyncRelease( &fs_async.requests[i] );
+		}
 	}
 
-	fullHash = FS_HashFileName( filename, 0U );
+	fs_async.numThreads = 0;
+	fs_async.inFlight = 0;
+	fs_async.pending = 0;
+	fs_async.initialized = qfalse;
+}
 
-	//
-	// search through the path, one element at a time
-	//
-	for ( search = fs_searchpaths ; search ; search = search->next ) {
 
-		// is the element a pak file?
-		if ( search->pack && search->pack->hashTable[ (hash = fullHash & (search->pack->hashSize-1)) ] ) {
-			// disregard if it doesn't match one of the allowed pure pak files
-			//if ( !FS_PakIsPure( search->pack ) ) {
-			//	continue;
-			//}
-			//
-			if ( search->pack->exclude ) {
-				continue;
-			}
+/*
+=============================================================================
 
-			if (fs_filter_flag & FS_EXCLUDE_ETMAIN)
-			{
-				if (FS_IsBaseGame(search->pack->pakGamename))
-				{
-					continue;
-				}
-			}
-			if (fs_filter_flag & FS_EXCLUDE_OTHERGAMES)
-			{
-				if (Q_stricmp(search->pack->pakGamename, fs_gamedir) != 0)
-				{
-					continue;
-				}
-			}
+PREFETCHED FILES
 
-			// look through all the pak file elements
-			pak = search->pack;
-			pakFile = pak->hashTable[hash];
-			do {
-				// case and separator insensitive comparisons
-				if ( !FS_FilenameCompare( pakFile->name, filename ) ) {
-					if ( pChecksum ) {
-						*pChecksum = pak->pure_checksum;
-					}
-					if ( pakName ) {
-						Com_sprintf( pakName, MAX_OSPATH, "%s/%s", pak->pakGamename, pak->pakBasename );
-					}
-					return qtrue;
-				}
-				pakFile = pakFile->next;
-			} while ( pakFile != NULL );
-		}
+Files read ahead of time with FS_ReadFileAsync and kept in memory until
+the next synchronous read of the same file. The cache survives filesystem
+restarts, so every entry remembers where it was read from and is only
+used if FS_FOpenFileRead still resolves the name to the same place.
+
+=============================================================================
+*/
+
+#define MAX_PREFETCH_FILES	1024
+
+typedef struct {
+	char					qpath[ MAX_ZPATH ];
+	int						request;		// still being read
+	char					*pakFilename;	// NULL for loose files
+	unsigned long			zipPos;
+	int						length;
+	byte					*buffer;
+	fsPrefetchCallback_t	callback;
+} prefetchFile_t;
+
+static prefetchFile_t fs_prefetchFiles[ MAX_PREFETCH_FILES ];
+
+static struct {
+	int					count;			// used slots
+	int					bytes;			// cached and reserved by running reads
+	int					cached;
+	int					hits;
+	double				hitBytes;
+	int					unused;			// flushed without being read
+} fs_prefetch;
+
+
+/*
+=================
+FS_ClearPrefetch
+=================
+*/
+static void FS_ClearPrefetch( prefetchFile_t *pf )
+{
+	if ( pf->request ) {
+		FS_CancelAsync( pf->request );
 	}
-	return qfalse;
+	fs_prefetch.bytes -= pf->length;
+	free( pf->pakFilename );
+	free( pf->buffer );
+	Com_Memset( pf, 0, sizeof( *pf ) );
+	fs_prefetch.count--;
 }
 
 
 /*
-============
-FS_ReadFile
-
-Filename are relative to the quake search path
-a null buffer will just return the file length without loading
-============
+=================
+FS_PrefetchDone
+=================
 */
-int FS_ReadFile( const char *qpath, void **buffer ) {
-	fileHandle_t	h;
-	byte*			buf;
-	qboolean		isConfig;
-	long			len;
+static qboolean FS_PrefetchDone( void *userdata, const char *qpath, void *buffer, int length )
+{
+	prefetchFile_t *pf = (prefetchFile_t *)userdata;
 
-	if ( !fs_searchpaths ) {
-		Com_Error( ERR_FATAL, "Filesystem call made without initialization" );
-	}
+	pf->request = 0;
 
-	if ( !qpath || !qpath[0] ) {
-		Com_Error( ERR_FATAL, "FS_ReadFile with empty name" );
+	if ( !buffer ) {
+		FS_ClearPrefetch( pf );
+		return qfalse;
 	}
 
-	buf = NULL;	// quiet compiler warning
-	isConfig = qfalse;
-
-	// if this is a .cfg file and we are playing back a journal, read
-	// it from the journal file
-	if ( com_journalDataFile != FS_INVALID_HANDLE && strstr( qpath, ".cfg" ) ) {
-		if ( com_journal->integer == 2 ) {
-			int		r;
-
-			Com_DPrintf( "Loading %s from journal file.\n", qpath );
-			r = FS_Read( &len, sizeof( len ), com_journalDataFile );
-			if ( r != sizeof( len ) ) {
-				if (buffer != NULL) *buffer = NULL;
-				return -1;
-			}
-			// if the file didn't exist when the journal was created
-			if (!len) {
-				if (buffer == NULL) {
-					return 1;			// hack for old journal files
-				}
-				*buffer = NULL;
-				return -1;
-			}
-			if (buffer == NULL) {
-				return len;
-			}
+	pf->buffer = buffer;
+	fs_prefetch.cached++;
 
-			buf = Hunk_AllocateTempMemory(len+1);
-			*buffer = buf;
+	if ( pf->callback ) {
+		pf->callback( pf->qpath, pf->buffer, pf->length );
+	}
 
-			r = FS_Read( buf, len, com_journalDataFile );
-			if ( r != len ) {
-				Com_Error( ERR_FATAL, "Read from journalDataFile failed" );
-			}
+	return qtrue;
+}
 
-			fs_loadCount++;
-			fs_loadStack++;
 
-			// guarantee that it will have a trailing 0 for string operations
-			buf[len] = '\0';
+/*
+=================
+FS_PrefetchFile
+=================
+*/
+qboolean FS_PrefetchFile( const char *qpath, int priority, fsPrefetchCallback_t callback )
+{
+	asyncRequest_t			*req;
+	prefetchFile_t			*pf, *slot;
+	int						i;
 
-			return len;
-		} else if ( com_journal->integer == 1 ) {
-			isConfig = qtrue;
-		}
+	if ( !fs_searchpaths || !qpath || !qpath[0] ) {
+		return qfalse;
 	}
 
-	// look for it in the filesystem or pack files
-	len = FS_FOpenFileRead( qpath, &h, qfalse );
-	if ( h == FS_INVALID_HANDLE ) {
-		if ( buffer ) {
-			*buffer = NULL;
+	slot = NULL;
+	for ( i = 0, pf = fs_prefetchFiles; i < MAX_PREFETCH_FILES; i++, pf++ ) {
+		if ( !pf->qpath[0] ) {
+			if ( !slot ) {
+				slot = pf;
+			}
+			continue;
 		}
-		// if we are journaling and it is a config file, write a zero to the journal file
-		if ( isConfig ) {
-			Com_DPrintf( "Writing zero for %s to journal file.\n", qpath );
-			len = 0;
-			FS_Write( &len, sizeof( len ), com_journalDataFile );
-			FS_Flush( com_journalDataFile );
+		if ( !FS_FilenameCompare( pf->qpath, qpath ) ) {
+			return qtrue;
 		}
-		return -1;
 	}
 
-	if ( !buffer ) {
-		if ( isConfig ) {
-			Com_DPrintf( "Writing len for %s to journal file.\n", qpath );
-			FS_Write( &len, sizeof( len ), com_journalDataFile );
-			FS_Flush( com_journalDataFile );
-		}
-		FS_FCloseFile( h );
-		return len;
+	if ( !slot || fs_prefetch.bytes >= fs_prefetchBudget->integer * 1024 * 1024 ) {
+		return qfalse;
 	}
 
-	buf = Hunk_AllocateTempMemory( len + 1 );
-	*buffer = buf;
+	Q_strncpyz( slot->qpath, qpath, sizeof( slot->qpath ) );
+	slot->callback = callback;
+	slot->request = FS_ReadFileAsync( qpath, priority, FS_PrefetchDone, slot );
+	if ( !slot->request ) {
+		slot->qpath[0] = '\0';
+		return qfalse;
+	}
 
-	FS_Read( buf, len, h );
+	fs_prefetch.count++;
 
-	fs_loadCount++;
-	fs_loadStack++;
+	// the request is not released before its callback, so this is safe without the lock
+	for ( i = 0, req = fs_async.requests; i < MAX_ASYNC_REQUESTS; i++, req++ ) {
+		if ( req->state != ASYNC_FREE && req->id == slot->request ) {
+			break;
+		}
+	}
 
-	// guarantee that it will have a trailing 0 for string operations
-	buf[ len ] = '\0';
-	FS_FCloseFile( h );
+	// referenced by the FS_ReadFile that takes it, if any
+	req->reference = qfalse;
 
-	// if we are journaling and it is a config file, write it to the journal file
-	if ( isConfig ) {
-		Com_DPrintf( "Writing %s to journal file.\n", qpath );
-		FS_Write( &len, sizeof( len ), com_journalDataFile );
-		FS_Write( buf, len, com_journalDataFile );
-		FS_Flush( com_journalDataFile );
+	slot->length = req->length;
+	slot->zipPos = req->zipPos;
+	if ( req->pakFilename ) {
+		slot->pakFilename = malloc( strlen( req->pakFilename ) + 1 );
+		if ( !slot->pakFilename ) {
+			FS_ClearPrefetch( slot );
+			return qfalse;
+		}
+		strcpy( slot->pakFilename, req->pakFilename );
 	}
-	return len;
-}
 
+	fs_prefetch.bytes += slot->length;
 
-int FS_ReadFile_Filtered( const char *qpath, void **buffer, int filter_flag  ) {
-	int ret;
-
-	fs_filter_flag = filter_flag;
-	ret = FS_ReadFile( qpath, buffer );
-	fs_filter_flag = 0;
+	// too large for what is left of the budget
+	if ( fs_prefetch.bytes > fs_prefetchBudget->integer * 1024 * 1024 ) {
+		FS_ClearPrefetch( slot );
+		return qfalse;
+	}
 
-	return ret;
+	return qtrue;
 }
 
 
 /*
-=============
-FS_FreeFile
-=============
+=================
+FS_TakePrefetched
+
+Returns the cached copy of the file just opened as h, with a trailing
+0 byte, the caller frees it. Returns NULL if there is none
+=================
 */
-void FS_FreeFile( void *buffer ) {
-	if ( !fs_searchpaths ) {
-		Com_Error( ERR_FATAL, "Filesystem call made without initialization" );
+static byte *FS_TakePrefetched( fileHandle_t h, const char *qpath, int length )
+{
+	const fileHandleData_t	*fd;
+	prefetchFile_t			*pf;
+	byte					*buffer;
+	int						i;
+
+	if ( !fs_prefetch.count ) {
+		return NULL;
 	}
-	if ( !buffer ) {
-		Com_Error( ERR_FATAL, "FS_FreeFile( NULL )" );
+
+	// qpaths are not supposed to have a leading slash
+	if ( qpath[0] == '/' || qpath[0] == '\\' ) {
+		qpath++;
 	}
-	fs_loadStack--;
 
-	Hunk_FreeTempMemory( buffer );
+	for ( i = 0, pf = fs_prefetchFiles; i < MAX_PREFETCH_FILES; i++, pf++ ) {
+		if ( pf->qpath[0] && !FS_FilenameCompare( pf->qpath, qpath ) ) {
+			break;
+		}
+	}
 
-	// if all of our temp files are free, clear all of our space
-	if ( fs_loadStack == 0 ) {
-		Hunk_ClearTempMemory();
+	if ( i == MAX_PREFETCH_FILES ) {
+		return NULL;
+	}
+
+	fd = &fsh[ h ];
+
+	// still being read, or the search paths changed since
+	if ( !pf->buffer || pf->length != length || ( pf->pakFilename != NULL ) != fd->zipFile ||
+		( fd->zipFile && ( pf->zipPos != (unsigned long)fd->zipFilePos || strcmp( pf->pakFilename, fd->pak->pakFilename ) ) ) ) {
+		fs_prefetch.unused++;
+		FS_ClearPrefetch( pf );
+		return NULL;
+	}
+
+	buffer = pf->buffer;
+	pf->buffer = NULL;
+	FS_ClearPrefetch( pf );
+
+	fs_prefetch.hits++;
+	fs_prefetch.hitBytes += length;
+
+	if ( fs_debug->integer ) {
+		Com_Printf( "%s: %s\n", __func__, qpath );
 	}
+
+	return buffer;
 }
 
 
 /*
-============
-FS_WriteFile
-
-Filename are relative to the quake search path
-============
+=================
+FS_CopyPrefetched
+=================
 */
-void FS_WriteFile( const char *qpath, const void *buffer, int size ) {
-	fileHandle_t f;
+static qboolean FS_CopyPrefetched( fileHandle_t h, const char *qpath, void *buffer, int length )
+{
+	byte *cached;
 
-	if ( !fs_searchpaths ) {
-		Com_Error( ERR_FATAL, "Filesystem call made without initialization" );
+	cached = FS_TakePrefetched( h, qpath, length );
+	if ( !cached ) {
+		return qfalse;
 	}
 
-	if ( !qpath || !buffer ) {
-		Com_Error( ERR_FATAL, "FS_WriteFile: NULL parameter" );
-	}
+	Com_Memcpy( buffer, cached, length );
+	free( cached );
 
-	f = FS_FOpenFileWrite( qpath );
-	if ( f == FS_INVALID_HANDLE ) {
-		Com_Printf( "Failed to open %s\n", qpath );
-		return;
-	}
+	return qtrue;
+}
 
-	FS_Write( buffer, size, f );
 
-	FS_FCloseFile( f );
+/*
+=================
+FS_FlushPrefetch
+=================
+*/
+void FS_FlushPrefetch( void )
+{
+	prefetchFile_t *pf;
+	int i;
+
+	for ( i = 0, pf = fs_prefetchFiles; i < MAX_PREFETCH_FILES && fs_prefetch.count; i++, pf++ ) {
+		if ( pf->qpath[0] ) {
+			fs_prefetch.unused++;
+			FS_ClearPrefetch( pf );
+		}
+	}
 }
 
 
+/*
+=================
+FS_PrintPrefetchStats
+=================
+*/
+static void FS_PrintPrefetchStats( void )
+{
+	Com_Printf( "prefetch: %i files held, %.1f MB, %i read ahead, %i used (%.1f MB), %i unused\n",
+		fs_prefetch.count, fs_prefetch.bytes / ( 1024.0 * 1024.0 ), fs_prefetch.cached,
+		fs_prefetch.hits, fs_prefetch.hitBytes / ( 1024 * 1024 ), fs_prefetch.unused );
+}
+
 
 /*
 ==========================================================================
@@ -3450,24 +5459,241 @@ static void FS_LoadCache( void )
 #endif // USE_PK3_CACHE
 
 
+/*
+=================================================================================
+
+PK3 SCANNING
+
+Reading a central directory only needs an arena and its own FILE, so
+FS_AddGameDirectory scans all new pk3 files of a directory on worker
+threads first. Each scan's arena is handed to the main thread, which
+builds the pack_t structures from it in the usual search order.
+
+=================================================================================
+*/
+
+#define MAX_SCAN_THREADS	16
+#define MIN_THREADED_SCANS	4		// fewer pk3 files are scanned right away
+
+typedef struct {
+	unsigned long	pos;			// position in the central directory
+	unsigned long	size;			// uncompressed size
+	unsigned long	crc;
+	unsigned long	method;			// compression method
+	const char		*name;			// in pk3Scan_t.arena
+} pk3Entry_t;
+
+typedef struct {
+	char			*zipfile;
+	pack_t			*cached;		// found in the pk3 cache, not scanned
+	unz_s			zip;			// left open for the pack handle
+	memArena_t		*arena;			// entries and names
+	pk3Entry_t		*entries;
+	int				numEntries;
+	qboolean		valid;
+	qboolean		noMemory;
+} pk3Scan_t;
+
+typedef struct {
+	pk3Scan_t		*scans;
+	int				numScans;
+	int				first;
+	int				stride;
+} pk3ScanWorker_t;
+
+
 /*
 =================
-FS_LoadZipFile
+FS_ScanZipFile
+
+Reads the central directory of scan->zipfile, may run on any thread
+=================
+*/
+static void FS_ScanZipFile( pk3Scan_t *scan )
+{
+	unz_s			*zip = &scan->zip;
+	unz_global_info gi;
+	unz_file_info	file_info;
+	char			filename_inzip[MAX_ZPATH];
+	pk3Entry_t		*entry;
+	unsigned int	i;
+	int				len;
+	char			*name;
+	int				err;
+
+	if ( unzOpenInto( scan->zipfile, zip ) != UNZ_OK ) {
+		return;
+	}
+
+	if ( unzGetGlobalInfo( zip, &gi ) != UNZ_OK ) {
+		unzCloseInto( zip );
+		return;
+	}
+
+	scan->arena = Arena_Create( 0 );
+	if ( scan->arena ) {
+		scan->entries = Arena_Alloc( scan->arena, ( gi.number_entry + 1 ) * sizeof( scan->entries[0] ) );
+	}
+	if ( !scan->entries ) {
+		scan->noMemory = qtrue;
+		unzCloseInto( zip );
+		return;
+	}
+
+	unzGoToFirstFile( zip );
+	for ( i = 0; i < gi.number_entry; i++ )
+	{
+		err = unzGetCurrentFileInfo( zip, &file_info, filename_inzip, sizeof(filename_inzip), NULL, 0, NULL, 0 );
+		filename_inzip[sizeof(filename_inzip)-1] = '\0';
+		if (err != UNZ_OK) {
+			break;
+		}
+
+		len = (int) strlen( filename_inzip ) + 1;
+		name = Arena_Alloc( scan->arena, len );
+		if ( !name ) {
+			scan->noMemory = qtrue;
+			break;
+		}
+
+		FS_ConvertFilename( filename_inzip );
+
+		entry = &scan->entries[ scan->numEntries++ ];
+		unzGetCurrentFileInfoPosition( zip, &entry->pos );
+		entry->size = file_info.uncompressed_size;
+		entry->crc = file_info.crc;
+		entry->method = file_info.compression_method;
+		entry->name = name;
+		Com_Memcpy( name, filename_inzip, len );
+
+		unzGoToNextFile( zip );
+	}
+
+	if ( scan->noMemory ) {
+		unzCloseInto( zip );
+		return;
+	}
+
+	scan->valid = qtrue;
+}
+
+
+/*
+=================
+FS_FreeScan
+=================
+*/
+static void FS_FreeScan( pk3Scan_t *scan )
+{
+	if ( scan->zip.file ) {
+		unzCloseInto( &scan->zip );
+	}
+	Arena_Destroy( scan->arena );
+	scan->arena = NULL;
+	scan->entries = NULL;
+}
+
+
+/*
+=================
+FS_ScanWorker
+=================
+*/
+static void FS_ScanWorker( void *arg )
+{
+	const pk3ScanWorker_t *worker = (const pk3ScanWorker_t *)arg;
+	int i;
+
+	for ( i = worker->first; i < worker->numScans; i += worker->stride ) {
+		if ( worker->scans[i].zipfile && !worker->scans[i].cached ) {
+			FS_ScanZipFile( &worker->scans[i] );
+			// the join publishes it, FS_BuildPak and FS_FreeScan run on the main thread
+			if ( worker->scans[i].arena ) {
+				Arena_Handoff( worker->scans[i].arena );
+			}
+		}
+	}
+}
+
+
+/*
+=================
+FS_ScanZipFiles
+
+Scans everything not found in the pk3 cache, spread over
+fs_scanThreads threads
+=================
+*/
+static void FS_ScanZipFiles( pk3Scan_t *scans, int numScans )
+{
+	pk3ScanWorker_t	workers[ MAX_SCAN_THREADS ];
+	sysThread_t		*threads[ MAX_SCAN_THREADS ];
+	int				numThreads, pending;
+	int				i;
+
+	pending = 0;
+	for ( i = 0; i < numScans; i++ ) {
+		if ( scans[i].zipfile && !scans[i].cached ) {
+			pending++;
+		}
+	}
+
+	numThreads = fs_scanThreads->integer;
+	if ( numThreads <= 0 ) {
+		numThreads = Sys_NumCPUs();
+	}
+	numThreads = MIN( numThreads, MAX_SCAN_THREADS );
+
+	if ( pending < MIN_THREADED_SCANS || numThreads == 1 ) {
+		workers[0].scans = scans;
+		workers[0].numScans = numScans;
+		workers[0].first = 0;
+		workers[0].stride = 1;
+		FS_ScanWorker( &workers[0] );
+		fs_scanStats.threads = MAX( fs_scanStats.threads, 1 );
+		return;
+	}
+
+	numThreads = MIN( numThreads, pending );
+
+	// workers take every numThreads-th pk3 so large and small ones mix
+	for ( i = 0; i < numThreads; i++ ) {
+		workers[i].scans = scans;
+		workers[i].numScans = numScans;
+		workers[i].first = i;
+		workers[i].stride = numThreads;
+		threads[i] = i ? Sys_CreateThread( FS_ScanWorker, &workers[i] ) : NULL;
+	}
+
+	// the main thread takes the first share, and any thread that failed to start
+	FS_ScanWorker( &workers[0] );
+	for ( i = 1; i < numThreads; i++ ) {
+		if ( threads[i] ) {
+			Sys_JoinThread( threads[i] );
+		} else {
+			FS_ScanWorker( &workers[i] );
+		}
+	}
+
+	fs_scanStats.threads = MAX( fs_scanStats.threads, numThreads );
+}
+
+
+/*
+=================
+FS_BuildPak
 
-Creates a new pak_t in the search chain for the contents
-of a zip file.
+Creates a new pak_t from a scanned central directory
 =================
 */
-static pack_t *FS_LoadZipFile( const char *zipfile )
+static pack_t *FS_BuildPak( pk3Scan_t *scan )
 {
 	fileInPack_t	*curFile;
 	pack_t			*pack;
-	unzFile			uf;
-	int				err;
-	unz_global_info gi;
-	char			filename_inzip[MAX_ZPATH];
-	unz_file_info	file_info;
-	unsigned int	i, namelen, hashSize, size;
+	const pk3Entry_t *entry;
+	const char		*zipfile;
+	const char		*filename_inzip;
+	unsigned int	namelen, hashSize, size;
 	long			hash;
 	int				fs_numHeaderLongs;
 	int				*fs_headerLongs;
@@ -3476,24 +5702,17 @@ static pack_t *FS_LoadZipFile( const char *zipfile )
 	const char		*basename;
 	int				fileNameLen;
 	int				baseNameLen;
+	int				i;
 
-#ifdef USE_PK3_CACHE
-	pack = FS_LoadCachedPK3( zipfile );
-	if ( pack )
-	{
-		// update pure checksum
-		if ( pack->checksumFeed != fs_checksumFeed )
-		{
-			pack->headerLongs[ 0 ] = LittleLong( fs_checksumFeed );
-			pack->pure_checksum = Com_BlockChecksum( pack->headerLongs, sizeof( pack->headerLongs[0] ) * pack->numHeaderLongs );
-			pack->pure_checksum = LittleLong( pack->pure_checksum );
-			pack->checksumFeed = fs_checksumFeed;
-		}
+	if ( scan->noMemory ) {
+		Com_Error( ERR_FATAL, "%s: out of memory scanning %s", __func__, scan->zipfile );
+	}
 
-		pack->touched = qtrue;
-		return pack; // loaded from cache
+	if ( !scan->valid ) {
+		return NULL;
 	}
-#endif
+
+	zipfile = scan->zipfile;
 
 	// extract basename from zip path
 	basename = strrchr( zipfile, PATH_SEP );
@@ -3506,35 +5725,20 @@ static pack_t *FS_LoadZipFile( const char *zipfile )
 	fileNameLen = (int) strlen( zipfile ) + 1;
 	baseNameLen = (int) strlen( basename ) + 1;
 
-	uf = unzOpen( zipfile );
-	err = unzGetGlobalInfo( uf, &gi );
-
-	if ( err != UNZ_OK ) {
-		return NULL;
-	}
-
 	namelen = 0;
 	filecount = 0;
-	unzGoToFirstFile( uf );
-	for (i = 0; i < gi.number_entry; i++)
+	for ( i = 0, entry = scan->entries; i < scan->numEntries; i++, entry++ )
 	{
-		err = unzGetCurrentFileInfo(uf, &file_info, filename_inzip, sizeof(filename_inzip), NULL, 0, NULL, 0);
-		filename_inzip[sizeof(filename_inzip)-1] = '\0';
-		if (err != UNZ_OK) {
-			break;
-		}
-		if ( file_info.compression_method != 0 && file_info.compression_method != 8 /*Z_DEFLATED*/ ) {
-			Com_Printf( S_COLOR_YELLOW "%s|%s: unsupported compression method %i\n", basename, filename_inzip, (int)file_info.compression_method );
-			unzGoToNextFile( uf );
+		filename_inzip = entry->name;
+		if ( entry->method != 0 && entry->method != 8 /*Z_DEFLATED*/ ) {
+			Com_Printf( S_COLOR_YELLOW "%s|%s: unsupported compression method %i\n", basename, filename_inzip, (int)entry->method );
 			continue;
-		} 
+		}
 		namelen += strlen( filename_inzip ) + 1;
-		unzGoToNextFile( uf );
 		filecount++;
 	}
 
 	if ( filecount == 0 ) {
-		unzClose( uf );
 		return NULL;
 	}
 
@@ -3552,7 +5756,7 @@ static pack_t *FS_LoadZipFile( const char *zipfile )
 	pack = Z_TagMalloc( size, TAG_PACK );
 	Com_Memset( pack, 0, size );
 
-	pack->handle = uf;
+	pack->handle = unzAdopt( &scan->zip );
 	pack->numfiles = filecount;
 	pack->hashSize = hashSize;
 	pack->hashTable = (fileInPack_t **)( pack + 1 );
@@ -3578,28 +5782,21 @@ static pack_t *FS_LoadZipFile( const char *zipfile )
 	// strip .pk3 if needed
 	FS_StripExt( pack->pakBasename, ".pk3" );
 
-	unzGoToFirstFile( uf );
 	curFile = pack->buildBuffer;
-	for ( i = 0; i < gi.number_entry; i++ )
+	for ( i = 0, entry = scan->entries; i < scan->numEntries; i++, entry++ )
 	{
-		err = unzGetCurrentFileInfo( uf, &file_info, filename_inzip, sizeof(filename_inzip), NULL, 0, NULL, 0 );
-		filename_inzip[sizeof(filename_inzip)-1] = '\0';
-		if (err != UNZ_OK) {
-			break;
-		}
-		if ( file_info.compression_method != 0 && file_info.compression_method != 8 /*Z_DEFLATED*/ ) {
-			unzGoToNextFile( uf );
+		filename_inzip = entry->name;
+		if ( entry->method != 0 && entry->method != 8 /*Z_DEFLATED*/ ) {
 			continue;
-		} 
-		if ( file_info.uncompressed_size > 0 ) {
-			fs_headerLongs[fs_numHeaderLongs++] = LittleLong( file_info.crc );
+		}
+		if ( entry->size > 0 ) {
+			fs_headerLongs[fs_numHeaderLongs++] = LittleLong( entry->crc );
 		}
 
-		FS_ConvertFilename( filename_inzip );
 		if ( !FS_BannedPakFile( pack->pakBasename, filename_inzip ) ) {
 			// store the file position in the zip
-			unzGetCurrentFileInfoPosition( uf, &curFile->pos );
-			curFile->size = file_info.uncompressed_size;
+			curFile->pos = entry->pos;
+			curFile->size = entry->size;
 			curFile->name = namePtr;
 			strcpy( curFile->name, filename_inzip );
 			namePtr += strlen( filename_inzip ) + 1;
@@ -3612,8 +5809,6 @@ static pack_t *FS_LoadZipFile( const char *zipfile )
 		} else {
 			pack->numfiles--;
 		}
-
-		unzGoToNextFile( uf );
 	}
 
 	pack->checksum = Com_BlockChecksum( fs_headerLongs + 1, sizeof( fs_headerLongs[0] ) * ( fs_numHeaderLongs - 1 ) );
@@ -3651,6 +5846,153 @@ static pack_t *FS_LoadZipFile( const char *zipfile )
 }
 
 
+#ifdef USE_PK3_CACHE
+/*
+=================
+FS_TouchCachedPK3
+=================
+*/
+static pack_t *FS_TouchCachedPK3( pack_t *pack )
+{
+	// update pure checksum
+	if ( pack->checksumFeed != fs_checksumFeed )
+	{
+		pack->headerLongs[ 0 ] = LittleLong( fs_checksumFeed );
+		pack->pure_checksum = Com_BlockChecksum( pack->headerLongs, sizeof( pack->headerLongs[0] ) * pack->numHeaderLongs );
+		pack->pure_checksum = LittleLong( pack->pure_checksum );
+		pack->checksumFeed = fs_checksumFeed;
+	}
+
+	pack->touched = qtrue;
+	return pack; // loaded from cache
+}
+#endif
+
+
+/*
+=================
+FS_LoadZipFile
+
+Creates a new pak_t in the search chain for the contents
+of a zip file.
+=================
+*/
+static pack_t *FS_LoadZipFile( const char *zipfile )
+{
+	pk3Scan_t		scan;
+	pack_t			*pack;
+
+#ifdef USE_PK3_CACHE
+	pack = FS_LoadCachedPK3( zipfile );
+	if ( pack )
+	{
+		return FS_TouchCachedPK3( pack );
+	}
+#endif
+
+	Com_Memset( &scan, 0, sizeof( scan ) );
+	scan.zipfile = (char *)zipfile;
+
+	FS_ScanZipFile( &scan );
+	pack = FS_BuildPak( &scan );
+	FS_FreeScan( &scan );
+
+	return pack;
+}
+
+
+/*
+=================
+FS_PrepareScans
+
+One scan per file name, the pk3 cache is checked here so only
+new or changed files are handed to the workers
+=================
+*/
+static pk3Scan_t *FS_PrepareScans( const char *path, const char *dir, char **pakfiles, int numfiles )
+{
+	pk3Scan_t	*scans;
+	const char	*pakfile;
+	size_t		len;
+	int			i;
+
+	scans = calloc( numfiles, sizeof( scans[0] ) );
+	if ( !scans ) {
+		Com_Error( ERR_FATAL, "%s: out of memory", __func__ );
+	}
+
+	for ( i = 0; i < numfiles; i++ ) {
+		len = strlen( pakfiles[i] );
+		if ( !FS_IsExt( pakfiles[i], ".pk3", len ) ) {
+			continue;
+		}
+
+		pakfile = FS_BuildOSPath( path, dir, pakfiles[i] );
+		len = strlen( pakfile ) + 1;
+		scans[i].zipfile = malloc( len );
+		if ( !scans[i].zipfile ) {
+			Com_Error( ERR_FATAL, "%s: out of memory", __func__ );
+		}
+		Com_Memcpy( scans[i].zipfile, pakfile, len );
+
+#ifdef USE_PK3_CACHE
+		scans[i].cached = FS_LoadCachedPK3( scans[i].zipfile );
+#endif
+		if ( scans[i].cached ) {
+			fs_scanStats.cached++;
+		} else {
+			fs_scanStats.scanned++;
+		}
+	}
+
+	return scans;
+}
+
+
+/*
+=================
+FS_LoadScannedZipFile
+=================
+*/
+static pack_t *FS_LoadScannedZipFile( pk3Scan_t *scan )
+{
+	pack_t *pack;
+
+#ifdef USE_PK3_CACHE
+	if ( scan->cached ) {
+		return FS_TouchCachedPK3( scan->cached );
+	}
+#endif
+
+	pack = FS_BuildPak( scan );
+	FS_FreeScan( scan );
+
+	return pack;
+}
+
+
+/*
+=================
+FS_FreeScans
+=================
+*/
+static void FS_FreeScans( pk3Scan_t *scans, int numScans )
+{
+	int i;
+
+	if ( !scans ) {
+		return;
+	}
+
+	for ( i = 0; i < numScans; i++ ) {
+		FS_FreeScan( &scans[i] );
+		free( scans[i].zipfile );
+	}
+
+	free( scans );
+}
+
+
 /*
 =================
 FS_FreePak
@@ -3670,6 +6012,12 @@ static void FS_FreePak( pack_t *pak )
 		pak->handle = NULL;
 	}
 
+	if ( pak->sortedFiles )
+	{
+		Z_Free( pak->sortedFiles );
+		pak->sortedFiles = NULL;
+	}
+
 	Z_Free( pak );
 }
 
@@ -3758,69 +6106,273 @@ static int FS_ReturnPath( const char *zname, char *zpath, int *depth ) {
 	zpath[len] = '\0';
 	*depth = newdep;
 
-	return len;
-}
+	return len;
+}
+
+
+char *FS_CopyString( const char *in ) {
+	char *out;
+	//out = S_Malloc( strlen( in ) + 1 );
+	out = Z_Malloc( strlen( in ) + 1 );
+	strcpy( out, in );
+	return out;
+}
+
+
+/*
+==================
+FS_AddFileToList
+==================
+*/
+static int FS_AddFileToList( const char *name, char **list, int nfiles ) {
+	int		i;
+
+	if ( nfiles == MAX_FOUND_FILES - 1 ) {
+		return nfiles;
+	}
+	for ( i = 0 ; i < nfiles ; i++ ) {
+		if ( !Q_stricmp( name, list[i] ) ) {
+			return nfiles; // already in list
+		}
+	}
+	list[ nfiles ] = FS_CopyString( name );
+	nfiles++;
+
+	return nfiles;
+}
+
+
+#define FILELIST_HASH_SIZE	4096
+
+// case insensitive set of the names in a file list
+typedef struct {
+	short	hash[FILELIST_HASH_SIZE];	// first entry + 1
+	short	next[MAX_FOUND_FILES];
+} fileListHash_t;
+
+
+/*
+==================
+FS_AddFileToListHashed
+
+FS_AddFileToList without comparing against every name in the list
+==================
+*/
+static int FS_AddFileToListHashed( const char *name, char **list, int nfiles, fileListHash_t *h ) {
+	long	hash;
+	int		i;
+
+	if ( nfiles == MAX_FOUND_FILES - 1 ) {
+		return nfiles;
+	}
+
+	hash = FS_HashFileName( name, FILELIST_HASH_SIZE );
+	for ( i = h->hash[ hash ] - 1; i >= 0; i = h->next[ i ] - 1 ) {
+		if ( !Q_stricmp( name, list[i] ) ) {
+			return nfiles; // already in list
+		}
+	}
+
+	list[ nfiles ] = FS_CopyString( name );
+	h->next[ nfiles ] = h->hash[ hash ];
+	h->hash[ hash ] = nfiles + 1;
+	nfiles++;
+
+	return nfiles;
+}
+
+
+/*
+===============
+FS_AllowListExternal
+===============
+*/
+static qboolean FS_AllowListExternal( const char *extension ) 
+{
+	if ( !extension )
+		return qfalse;
+
+	if ( !Q_stricmp( extension, ".shader" ) )
+		return qfalse;
+
+	if ( !Q_stricmp( extension, ".shaderx" ) )
+		return qfalse;
+	
+	if ( !Q_stricmp( extension, ".mtr" ) )
+		return qfalse;
+
+	return qtrue;
+}
+
+static fnamecallback_f fnamecallback = NULL;
+
+void FS_SetFilenameCallback( fnamecallback_f func ) 
+{
+	fnamecallback = func;
+}
+
+
+/*
+=================================================================================
+
+PK3 LISTING INDEX
+
+Each pk3 keeps its file names sorted case insensitively, so everything
+under a directory is one contiguous range found by binary search. The
+order is built by the first listing that needs it and stays with the
+pack, which the pk3 cache keeps across filesystem restarts.
+
+=================================================================================
+*/
+
+static qboolean fs_listScan;	// fs_listbench, list the old way
+
+
+/*
+=================
+FS_ComparePakNames
+=================
+*/
+static int QDECL FS_ComparePakNames( const void *a, const void *b ) {
+	const fileInPack_t *f1 = *(const fileInPack_t **)a;
+	const fileInPack_t *f2 = *(const fileInPack_t **)b;
+	int cmp;
+
+	// same ordering as the Q_stricmpn range lookup
+	cmp = Q_stricmp( f1->name, f2->name );
+	if ( cmp ) {
+		return cmp;
+	}
+
+	return f1 - f2;
+}
+
+
+/*
+=================
+FS_ComparePakOrder
+
+Back to the order of the pk3 directory
+=================
+*/
+static int QDECL FS_ComparePakOrder( const void *a, const void *b ) {
+	return *(const fileInPack_t **)a - *(const fileInPack_t **)b;
+}
+
+
+/*
+=================
+FS_SortPakNames
+=================
+*/
+static void FS_SortPakNames( pack_t *pak ) {
+	int64_t start;
+	int i;
+
+	start = Sys_Microseconds();
 
+	pak->sortedFiles = Z_Malloc( MAX( pak->numfiles, 1 ) * sizeof( pak->sortedFiles[0] ) );
+	for ( i = 0; i < pak->numfiles; i++ ) {
+		pak->sortedFiles[i] = &pak->buildBuffer[i];
+	}
 
-char *FS_CopyString( const char *in ) {
-	char *out;
-	//out = S_Malloc( strlen( in ) + 1 );
-	out = Z_Malloc( strlen( in ) + 1 );
-	strcpy( out, in );
-	return out;
+	qsort( pak->sortedFiles, pak->numfiles, sizeof( pak->sortedFiles[0] ), FS_ComparePakNames );
+
+	fs_listStats.sorted++;
+	fs_listStats.sortTime += Sys_Microseconds() - start;
 }
 
 
 /*
-==================
-FS_AddFileToList
-==================
+=================
+FS_ListPakRange
+
+Files of the pk3 whose name starts with the first length characters
+of path, as positions in sortedFiles
+=================
 */
-static int FS_AddFileToList( const char *name, char **list, int nfiles ) {
-	int		i;
+static int FS_ListPakRange( pack_t *pak, const char *path, int length, int *end ) {
+	int lo, hi, mid, first;
 
-	if ( nfiles == MAX_FOUND_FILES - 1 ) {
-		return nfiles;
+	if ( !pak->sortedFiles ) {
+		FS_SortPakNames( pak );
 	}
-	for ( i = 0 ; i < nfiles ; i++ ) {
-		if ( !Q_stricmp( name, list[i] ) ) {
-			return nfiles; // already in list
+
+	lo = 0;
+	hi = pak->numfiles;
+	while ( lo < hi ) {
+		mid = ( lo + hi ) >> 1;
+		if ( Q_stricmpn( pak->sortedFiles[mid]->name, path, length ) < 0 ) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
 		}
 	}
-	list[ nfiles ] = FS_CopyString( name );
-	nfiles++;
+	first = lo;
 
-	return nfiles;
+	hi = pak->numfiles;
+	while ( lo < hi ) {
+		mid = ( lo + hi ) >> 1;
+		if ( Q_stricmpn( pak->sortedFiles[mid]->name, path, length ) <= 0 ) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+	*end = lo;
+
+	return first;
+}
+
+
+/*
+=================
+FS_PrintListStats
+=================
+*/
+static void FS_PrintListStats( void ) {
+	Com_Printf( "file lists: %i, %i through the index, %i pk3 names looked at, %.3f msec\n",
+		fs_listStats.lists, fs_listStats.indexed, fs_listStats.examined, fs_listStats.listTime / 1000.0 );
+	Com_Printf( "list index: %i pk3 files sorted in %.3f msec\n", fs_listStats.sorted, fs_listStats.sortTime / 1000.0 );
 }
 
 
 /*
 ===============
-FS_AllowListExternal
+FS_ListMatchName
+
+Extension or custom filename filter of FS_ListFilteredFiles
 ===============
 */
-static qboolean FS_AllowListExternal( const char *extension ) 
-{
-	if ( !extension )
-		return qfalse;
+static qboolean FS_ListMatchName( const char *name, const char *extension, int extLen, qboolean hasPatterns ) {
+	const char *x;
+	int length;
 
-	if ( !Q_stricmp( extension, ".shader" ) )
-		return qfalse;
+	length = (int)strlen( name );
 
-	if ( !Q_stricmp( extension, ".shaderx" ) )
-		return qfalse;
-	
-	if ( !Q_stricmp( extension, ".mtr" ) )
-		return qfalse;
+	if ( fnamecallback ) {
+		// use custom filter
+		return fnamecallback( name, length ) ? qtrue : qfalse;
+	}
 
-	return qtrue;
-}
+	if ( length < extLen ) {
+		return qfalse;
+	}
 
-static fnamecallback_f fnamecallback = NULL;
+	if ( *extension ) {
+		if ( hasPatterns ) {
+			x = strrchr( name, '.' );
+			if ( !x || !Com_FilterExt( extension, x+1 ) ) {
+				return qfalse;
+			}
+		} else {
+			if ( Q_stricmp( name + length - extLen, extension ) ) {
+				return qfalse;
+			}
+		}
+	}
 
-void FS_SetFilenameCallback( fnamecallback_f func ) 
-{
-	fnamecallback = func;
+	return qtrue;
 }
 
 
@@ -3837,6 +6389,11 @@ static char **FS_ListFilteredFiles( const char *path, const char *extension, con
 	char			**listCopy;
 	char			*list[MAX_FOUND_FILES];
 	const searchpath_t	*search;
+	fileListHash_t	*listHash;
+	fileInPack_t	**matches;
+	int				numMatches, maxMatches;
+	qboolean		useIndex;
+	int				first, end;
 	int				i;
 	int				pathLength;
 	int				extLen;
@@ -3845,7 +6402,7 @@ static char **FS_ListFilteredFiles( const char *path, const char *extension, con
 	fileInPack_t	*buildBuffer;
 	char			zpath[MAX_ZPATH];
 	qboolean		hasPatterns;
-	const char		*x;
+	int64_t			start;
 
 	if ( !fs_searchpaths ) {
 		Com_Error( ERR_FATAL, "Filesystem call made without initialization" );
@@ -3866,6 +6423,8 @@ static char **FS_ListFilteredFiles( const char *path, const char *extension, con
 		extension = "";
 	}
 
+	start = Sys_Microseconds();
+
 	extLen = (int)strlen( extension );
 	hasPatterns = Com_HasPatterns( extension );
 	if ( hasPatterns && extension[0] == '.' && extension[1] != '\0' ) {
@@ -3879,6 +6438,21 @@ static char **FS_ListFilteredFiles( const char *path, const char *extension, con
 	nfiles = 0;
 	FS_ReturnPath(path, zpath, &pathDepth);
 
+	temp = pathLength;
+	if (pathLength) {
+		temp++;		// include the '/'
+	}
+
+	// directory listings only look at the pk3 names under path
+	useIndex = !filter && fs_index->integer && !fs_listScan;
+	if ( useIndex && ( flags & FS_MATCH_PK3s ) ) {
+		fs_listStats.indexed++;
+	}
+	matches = NULL;
+	maxMatches = 0;
+
+	listHash = Z_Malloc( sizeof( *listHash ) );
+
 	//
 	// search through the path, one element at a time, adding to list
 	//
@@ -3892,8 +6466,44 @@ static char **FS_ListFilteredFiles( const char *path, const char *extension, con
 				continue;
 			}
 
-			// look through all the pak file elements
 			pak = search->pack;
+
+			if ( useIndex ) {
+				first = FS_ListPakRange( pak, path, pathLength, &end );
+				if ( end - first > maxMatches ) {
+					if ( matches ) {
+						Z_Free( matches );
+					}
+					maxMatches = end - first;
+					matches = Z_Malloc( maxMatches * sizeof( matches[0] ) );
+				}
+
+				numMatches = 0;
+				for ( i = first; i < end; i++ ) {
+					const char *name;
+					int zpathLen, depth;
+
+					name = pak->sortedFiles[i]->name;
+					zpathLen = FS_ReturnPath( name, zpath, &depth );
+					if ( (depth-pathDepth)>2 || pathLength > zpathLen ) {
+						continue;
+					}
+					if ( !FS_ListMatchName( name, extension, extLen, hasPatterns ) ) {
+						continue;
+					}
+					matches[ numMatches++ ] = pak->sortedFiles[i];
+				}
+				fs_listStats.examined += end - first;
+
+				qsort( matches, numMatches, sizeof( matches[0] ), FS_ComparePakOrder );
+				for ( i = 0; i < numMatches; i++ ) {
+					// unique the match
+					nfiles = FS_AddFileToListHashed( matches[i]->name + temp, list, nfiles, listHash );
+				}
+				continue;
+			}
+
+			// look through all the pak file elements
 			buildBuffer = pak->buildBuffer;
 			for (i = 0; i < pak->numfiles; i++) {
 				const char *name;
@@ -3907,7 +6517,7 @@ static char **FS_ListFilteredFiles( const char *path, const char *extension, con
 					if ( !Com_FilterPath( filter, name ) )
 						continue;
 					// unique the match
-					nfiles = FS_AddFileToList( name, list, nfiles );
+					nfiles = FS_AddFileToListHashed( name, list, nfiles, listHash );
 				}
 				else {
 
@@ -3918,37 +6528,15 @@ static char **FS_ListFilteredFiles( const char *path, const char *extension, con
 					}
 
 					// check for extension match
-					length = (int)strlen( name );
-
-					if ( fnamecallback ) {
-						// use custom filter
-						if ( !fnamecallback( name, length ) )
-							continue;
-					} else {
-						if ( length < extLen )
-							continue;
-						if ( *extension ) {
-							if ( hasPatterns ) {
-								x = strrchr( name, '.' );
-								if ( !x || !Com_FilterExt( extension, x+1 ) ) {
-									continue;
-								}
-							} else {
-								if ( Q_stricmp( name + length - extLen, extension ) ) {
-									continue;
-								}
-							}
-						}
+					if ( !FS_ListMatchName( name, extension, extLen, hasPatterns ) ) {
+						continue;
 					}
-					// unique the match
 
-					temp = pathLength;
-					if (pathLength) {
-						temp++;		// include the '/'
-					}
-					nfiles = FS_AddFileToList( name + temp, list, nfiles );
+					// unique the match
+					nfiles = FS_AddFileToListHashed( name + temp, list, nfiles, listHash );
 				}
 			}
+			fs_listStats.examined += pak->numfiles;
 		} else if ( search->dir && ( flags & FS_MATCH_EXTERN ) && search->policy != DIR_DENY ) { // scan for files in the filesystem
 			const char *netpath;
 			int		numSysFiles;
@@ -3967,12 +6555,20 @@ static char **FS_ListFilteredFiles( const char *path, const char *extension, con
 						continue;
 				} // else - should be already filtered by Sys_ListFiles
 
-				nfiles = FS_AddFileToList( name, list, nfiles );
+				nfiles = FS_AddFileToListHashed( name, list, nfiles, listHash );
 			}
 			Sys_FreeFileList( sysFiles );
 		}
 	}
 
+	if ( matches ) {
+		Z_Free( matches );
+	}
+	Z_Free( listHash );
+
+	fs_listStats.listTime += Sys_Microseconds() - start;
+	fs_listStats.lists++;
+
 	// return a copy of the list
 	*numfiles = nfiles;
 
@@ -4671,6 +7267,350 @@ static void FS_Which_f( void ) {
 	}
 }
 
+/*
+============
+FS_InflateBench_f
+
+Decompresses every deflated entry of a pk3 with both the streaming
+decoder used by FS_Read and the whole buffer one used by FS_ReadFile
+============
+*/
+static void FS_InflateBench_f( void ) {
+	const searchpath_t	*search;
+	const pack_t		*pak;
+	const char			*name;
+	unz_file_info		info;
+	unzFile				uf;
+	byte				*streamBuf, *wholeBuf;
+	unsigned long		bufSize;
+	int64_t				streamTime, wholeTime, start;
+	double				bytes, compressed;
+	int					entries, mismatches;
+	int					r1, r2, err;
+
+	name = Cmd_Argc() > 1 ? Cmd_Argv( 1 ) : "pak0";
+
+	pak = NULL;
+	for ( search = fs_searchpaths; search; search = search->next ) {
+		if ( search->pack && !Q_stricmp( search->pack->pakBasename, name ) ) {
+			pak = search->pack;
+			break;
+		}
+	}
+
+	if ( !pak ) {
+		Com_Printf( "Usage: fs_inflatebench [pk3 basename]\n%s.pk3 is not loaded\n", name );
+		return;
+	}
+
+	// a private handle keeps the shared one's read position intact
+	uf = unzOpen( pak->pakFilename );
+	if ( !uf ) {
+		Com_Printf( "Couldn't open %s\n", pak->pakFilename );
+		return;
+	}
+
+	streamBuf = wholeBuf = NULL;
+	bufSize = 0;
+	streamTime = wholeTime = 0;
+	bytes = compressed = 0;
+	entries = mismatches = 0;
+
+	for ( err = unzGoToFirstFile( uf ); err == UNZ_OK; err = unzGoToNextFile( uf ) ) {
+		if ( unzGetCurrentFileInfo( uf, &info, NULL, 0, NULL, 0, NULL, 0 ) != UNZ_OK ) {
+			break;
+		}
+
+		if ( info.compression_method != 8 /* Z_DEFLATED */ || !info.uncompressed_size ) {
+			continue;
+		}
+
+		if ( info.uncompressed_size > bufSize ) {
+			free( streamBuf );
+			free( wholeBuf );
+			bufSize = info.uncompressed_size;
+			streamBuf = malloc( bufSize );
+			wholeBuf = malloc( bufSize );
+			if ( !streamBuf || !wholeBuf ) {
+				Com_Printf( S_COLOR_YELLOW "Couldn't allocate %lu bytes\n", bufSize );
+				break;
+			}
+		}
+
+		// first read pulls the entry into the os cache
+		unzOpenCurrentFile( uf );
+		unzReadCurrentFileWhole( uf, wholeBuf, info.uncompressed_size );
+		unzCloseCurrentFile( uf );
+
+		unzOpenCurrentFile( uf );
+		start = Sys_Microseconds();
+		r1 = unzReadCurrentFile( uf, streamBuf, info.uncompressed_size );
+		streamTime += Sys_Microseconds() - start;
+		unzCloseCurrentFile( uf );
+
+		unzOpenCurrentFile( uf );
+		start = Sys_Microseconds();
+		r2 = unzReadCurrentFileWhole( uf, wholeBuf, info.uncompressed_size );
+		wholeTime += Sys_Microseconds() - start;
+		unzCloseCurrentFile( uf );
+
+		if ( r1 != (int)info.uncompressed_size || r2 != r1 || memcmp( streamBuf, wholeBuf, r1 ) ) {
+			mismatches++;
+		}
+
+		entries++;
+		bytes += info.uncompressed_size;
+		compressed += info.compressed_size;
+	}
+
+	free( streamBuf );
+	free( wholeBuf );
+	unzClose( uf );
+
+	Com_Printf( "%s: %i deflated entries, %.1f MB from %.1f MB\n", pak->pakFilename,
+		entries, bytes / ( 1024 * 1024 ), compressed / ( 1024 * 1024 ) );
+	if ( !entries ) {
+		return;
+	}
+	Com_Printf( "streaming:    %8.1f msec %8.1f MB/s\n", streamTime / 1000.0,
+		bytes / ( 1024 * 1024 ) / ( MAX( streamTime, 1 ) / 1000000.0 ) );
+	Com_Printf( "whole buffer: %8.1f msec %8.1f MB/s, %.2fx\n", wholeTime / 1000.0,
+		bytes / ( 1024 * 1024 ) / ( MAX( wholeTime, 1 ) / 1000000.0 ), (double)streamTime / MAX( wholeTime, 1 ) );
+	if ( mismatches ) {
+		Com_Printf( S_COLOR_YELLOW "%i entries decoded differently\n", mismatches );
+	}
+}
+
+
+/*
+============
+FS_ListBench_f
+
+Builds the file lists the menus ask for by walking every pk3 and
+through the listing index, checks they are the same
+============
+*/
+static void FS_ListBench_f( void ) {
+	static const char *queries[][2] = {
+		{ "scripts", ".arena" },
+		{ "scripts", ".campaign" },
+		{ "maps", ".bsp" },
+		{ "profiles", "/" },
+		{ "demos", ".dm_??" },
+		{ "video", "roq" },
+		{ "sound/chat", ".wav" },
+		{ "models/players", "/" }
+	};
+	const searchpath_t	*search;
+	const char	*path, *ext;
+	char		**scanList, **indexList;
+	int64_t		scanTime, indexTime, sortTime, start;
+	int			numQueries, q, i, n, runs, names, sorted;
+	int			numScan, numIndex, mismatches, files;
+
+	if ( !fs_index->integer ) {
+		Com_Printf( "fs_index is off\n" );
+		return;
+	}
+
+	numQueries = ARRAY_LEN( queries );
+	if ( Cmd_Argc() > 1 ) {
+		numQueries = 1;
+	}
+
+	runs = 10;
+	scanTime = indexTime = 0;
+	mismatches = files = 0;
+
+	// sort every pk3 up front so the index build is timed separately
+	names = sorted = 0;
+	start = Sys_Microseconds();
+	for ( search = fs_searchpaths; search; search = search->next ) {
+		if ( search->pack ) {
+			if ( !search->pack->sortedFiles ) {
+				FS_SortPakNames( search->pack );
+				sorted++;
+			}
+			names += search->pack->numfiles;
+		}
+	}
+	sortTime = Sys_Microseconds() - start;
+
+	for ( q = 0; q < numQueries; q++ ) {
+		if ( Cmd_Argc() > 1 ) {
+			path = Cmd_Argv( 1 );
+			ext = Cmd_Argv( 2 );
+		} else {
+			path = queries[q][0];
+			ext = queries[q][1];
+		}
+
+		for ( n = 0; n < runs; n++ ) {
+			fs_listScan = qtrue;
+			start = Sys_Microseconds();
+			scanList = FS_ListFilteredFiles( path, ext, NULL, &numScan, FS_MATCH_PK3s );
+			scanTime += Sys_Microseconds() - start;
+			fs_listScan = qfalse;
+
+			start = Sys_Microseconds();
+			indexList = FS_ListFilteredFiles( path, ext, NULL, &numIndex, FS_MATCH_PK3s );
+			indexTime += Sys_Microseconds() - start;
+
+			if ( n == 0 ) {
+				files += numScan;
+				if ( numScan != numIndex ) {
+					mismatches++;
+				} else {
+					for ( i = 0; i < numScan; i++ ) {
+						if ( strcmp( scanList[i], indexList[i] ) ) {
+							mismatches++;
+							break;
+						}
+					}
+				}
+				if ( Cmd_Argc() > 1 || com_developer->integer ) {
+					Com_Printf( "%s %s: %i files\n", path, ext, numScan );
+				}
+			}
+
+			FS_FreeFileList( scanList );
+			FS_FreeFileList( indexList );
+		}
+	}
+
+	Com_Printf( "%i pk3 files, %i names, %i lists x %i runs, %i files listed\n", fs_packCount,
+		names, numQueries, runs, files );
+	Com_Printf( "index build: %8.3f msec, %i pk3 files sorted now\n", sortTime / 1000.0, sorted );
+	Com_Printf( "pk3 walk:    %8.3f msec per run\n", scanTime / 1000.0 / runs );
+	Com_Printf( "index:       %8.3f msec per run, %.1fx\n", indexTime / 1000.0 / runs,
+		(double)scanTime / MAX( indexTime, 1 ) );
+	if ( mismatches ) {
+		Com_Printf( S_COLOR_YELLOW "%i lists differ\n", mismatches );
+	}
+}
+
+
+typedef struct {
+	unsigned int	checksum;
+	int64_t			checksumTime;
+} asyncBench_t;
+
+/*
+============
+FS_AsyncBenchDone
+============
+*/
+static qboolean FS_AsyncBenchDone( void *userdata, const char *qpath, void *buffer, int length ) {
+	asyncBench_t *bench = (asyncBench_t *)userdata;
+	int64_t start;
+
+	if ( buffer ) {
+		start = Sys_Microseconds();
+		bench->checksum ^= Com_BlockChecksum( buffer, length );
+		bench->checksumTime += Sys_Microseconds() - start;
+	}
+
+	return qfalse;
+}
+
+
+/*
+============
+FS_AsyncBench_f
+
+Reads every file of a pk3 with FS_ReadFile and then with FS_ReadFileAsync,
+reports the wall time of both and how long the main thread was busy
+============
+*/
+static void FS_AsyncBench_f( void ) {
+	const searchpath_t	*search;
+	const pack_t		*pak;
+	const char			*name;
+	void				*buffer;
+	asyncBench_t		bench;
+	unsigned int		syncChecksum;
+	int64_t				syncTime, asyncTime, busyTime, start, t;
+	double				bytes;
+	int					i, len, files, queued;
+
+	name = Cmd_Argc() > 1 ? Cmd_Argv( 1 ) : "pak0";
+
+	pak = NULL;
+	for ( search = fs_searchpaths; search; search = search->next ) {
+		if ( search->pack && !Q_stricmp( search->pack->pakBasename, name ) ) {
+			pak = search->pack;
+			break;
+		}
+	}
+
+	if ( !pak ) {
+		Com_Printf( "Usage: fs_asyncbench [pk3 basename]\n%s.pk3 is not loaded\n", name );
+		return;
+	}
+
+	if ( FS_AsyncPending() ) {
+		Com_Printf( "Asynchronous reads are in progress\n" );
+		return;
+	}
+
+	// first pass pulls the pk3 into the os cache
+	bytes = 0;
+	files = 0;
+	syncChecksum = 0;
+	syncTime = 0;
+	for ( i = 0; i < pak->numfiles; i++ ) {
+		start = Sys_Microseconds();
+		len = FS_ReadFile( pak->buildBuffer[i].name, &buffer );
+		syncTime += Sys_Microseconds() - start;
+		if ( !buffer ) {
+			continue;
+		}
+		syncChecksum ^= Com_BlockChecksum( buffer, len );
+		FS_FreeFile( buffer );
+		bytes += len;
+		files++;
+	}
+
+	Com_Memset( &bench, 0, sizeof( bench ) );
+	busyTime = 0;
+	queued = 0;
+	start = Sys_Microseconds();
+	for ( i = 0; i < pak->numfiles; i++ ) {
+		while ( FS_AsyncPending() >= MAX_ASYNC_REQUESTS ) {
+			t = Sys_Microseconds();
+			FS_AsyncFrame();
+			busyTime += Sys_Microseconds() - t;
+			Sys_Sleep( 0 );
+		}
+		t = Sys_Microseconds();
+		if ( FS_ReadFileAsync( pak->buildBuffer[i].name, 0, FS_AsyncBenchDone, &bench ) ) {
+			queued++;
+		}
+		busyTime += Sys_Microseconds() - t;
+	}
+	while ( FS_AsyncPending() ) {
+		t = Sys_Microseconds();
+		FS_AsyncFrame();
+		busyTime += Sys_Microseconds() - t;
+		Sys_Sleep( 0 );
+	}
+	asyncTime = Sys_Microseconds() - start;
+
+	// the checksums are not part of the reads
+	busyTime -= bench.checksumTime;
+
+	Com_Printf( "%s: %i files, %.1f MB\n", pak->pakFilename, files, bytes / ( 1024 * 1024 ) );
+	Com_Printf( "FS_ReadFile:      %8.1f msec\n", syncTime / 1000.0 );
+	Com_Printf( "FS_ReadFileAsync: %8.1f msec on %i thread%s, main thread busy %.1f msec\n", asyncTime / 1000.0,
+		fs_async.numThreads, fs_async.numThreads == 1 ? "" : "s", busyTime / 1000.0 );
+	if ( queued != files ) {
+		Com_Printf( S_COLOR_YELLOW "%i files couldn't be queued\n", files - queued );
+	} else if ( bench.checksum != syncChecksum ) {
+		Com_Printf( S_COLOR_YELLOW "file contents differ\n" );
+	}
+}
+
+
 
 //===========================================================================
 
@@ -4689,7 +7629,6 @@ static void FS_AddGameDirectory( const char *path, const char *dir ) {
 	const char		*gamedir;
 	pack_t			*pak;
 	char			curpath[MAX_OSPATH*2 + 1];
-	char			*pakfile;
 	int				numfiles;
 	char			**pakfiles;
 	int				pakfilesi;
@@ -4699,6 +7638,8 @@ static void FS_AddGameDirectory( const char *path, const char *dir ) {
 	int				pakwhich;
 	int				path_len;
 	int				dir_len;
+	pk3Scan_t		*scans;
+	int64_t			start;
 
 	for ( sp = fs_searchpaths ; sp ; sp = sp->next ) {
 		if ( sp->dir && !Q_stricmp( sp->dir->path, path ) && !Q_stricmp( sp->dir->gamedir, dir )) {
@@ -4740,6 +7681,15 @@ static void FS_AddGameDirectory( const char *path, const char *dir ) {
 	if ( numfiles >= 2 )
 		FS_SortFileList( pakfiles, numfiles - 1 );
 
+	// read all new central directories up front
+	start = Sys_Microseconds();
+	scans = NULL;
+	if ( numfiles > 0 ) {
+		scans = FS_PrepareScans( path, dir, pakfiles, numfiles );
+		FS_ScanZipFiles( scans, numfiles );
+	}
+	fs_scanStats.scanTime += Sys_Microseconds() - start;
+
 	pakfilesi = 0;
 	pakdirsi = 0;
 
@@ -4780,8 +7730,10 @@ static void FS_AddGameDirectory( const char *path, const char *dir ) {
 			}
 
 			// The next .pk3 file is before the next .pk3dir
-			pakfile = FS_BuildOSPath( path, dir, pakfiles[pakfilesi] );
-			if ( (pak = FS_LoadZipFile( pakfile ) ) == NULL ) {
+			start = Sys_Microseconds();
+			pak = FS_LoadScannedZipFile( &scans[pakfilesi] );
+			fs_scanStats.buildTime += Sys_Microseconds() - start;
+			if ( pak == NULL ) {
 				// This isn't a .pk3! Next!
 				pakfilesi++;
 				continue;
@@ -4842,6 +7794,7 @@ static void FS_AddGameDirectory( const char *path, const char *dir ) {
 	}
 
 	// done
+	FS_FreeScans( scans, numfiles );
 	Sys_FreeFileList( pakdirs );
 	Sys_FreeFileList( pakfiles );
 }
@@ -5035,10 +7988,18 @@ static const cmdListItem_t fs_cmds[] = {
 	{ "fs_restart", FS_Reload, NULL },
 	{ "lsof", FS_ListOpenFiles_f, NULL },
 	{ "path", FS_Path_f, NULL },
+	{ "fs_stats", FS_Stats_f, NULL },
 	{ "touchFile", FS_TouchFile_f, NULL },
 	{ "which", FS_Which_f, FS_CompleteFileName },
 };
 
+// self benchmarks read whole pk3s on the main thread, developer mode only
+static const cmdListItem_t fs_benchCmds[] = {
+	{ "fs_asyncbench", FS_AsyncBench_f, NULL },
+	{ "fs_inflatebench", FS_InflateBench_f, NULL },
+	{ "fs_listbench", FS_ListBench_f, NULL },
+};
+
 
 /*
 ================
@@ -5052,6 +8013,12 @@ void FS_Shutdown( qboolean closemfp )
 	searchpath_t	*p, *next;
 	int i;
 
+	// reads in progress and read ahead files outlive restarts
+	if ( closemfp ) {
+		FS_AsyncShutdown();
+		FS_FlushPrefetch();
+	}
+
 	// close opened files
 	if ( closemfp ) 
 	{
@@ -5071,6 +8038,9 @@ void FS_Shutdown( qboolean closemfp )
 	}
 #endif
 
+	FS_FlushBSP();
+	FS_FreeIndex();
+
 #ifdef USE_PK3_CACHE
 	FS_ResetCacheReferences();
 #endif
@@ -5105,6 +8075,7 @@ void FS_Shutdown( qboolean closemfp )
 	fs_dirCount = 0;
 
 	Cmd_UnregisterArray( fs_cmds );
+	Cmd_UnregisterArray( fs_benchCmds );
 
 #ifdef FS_MISSING
 	if (closemfp)
@@ -5195,6 +8166,8 @@ static void FS_ReorderPurePaks( void )
 			p_previous = &s->next;
 		}
 	}
+
+	FS_NumberSearchPaths();
 }
 
 
@@ -5353,6 +8326,27 @@ static void FS_Startup( void ) {
 		Cvar_ForceReset( "fs_game" );
 	}
 
+	fs_index = Cvar_Get( "fs_index", "1", CVAR_ARCHIVE_ND | CVAR_LATCH );
+	Cvar_SetDescription( fs_index, "Index the files of all search paths on startup, so looking up a file doesn't have to try every directory" );
+
+	fs_scanThreads = Cvar_Get( "fs_scanThreads", "0", CVAR_ARCHIVE_ND );
+	Cvar_CheckRange( fs_scanThreads, "0", XSTRING( MAX_SCAN_THREADS ), CV_INTEGER );
+	Cvar_SetDescription( fs_scanThreads, "Number of threads reading pk3 directories on filesystem startup:\n"
+		" 0 - one per CPU core\n"
+		" 1 - read them on the main thread" );
+
+	fs_asyncThreads = Cvar_Get( "fs_asyncThreads", "2", CVAR_ARCHIVE_ND | CVAR_LATCH );
+	Cvar_CheckRange( fs_asyncThreads, "0", XSTRING( MAX_ASYNC_THREADS ), CV_INTEGER );
+	Cvar_SetDescription( fs_asyncThreads, "Number of threads serving asynchronous file reads, 0 reads them one per frame on the main thread" );
+
+	fs_asyncBudget = Cvar_Get( "fs_asyncBudget", "64", CVAR_ARCHIVE_ND );
+	Cvar_CheckRange( fs_asyncBudget, "1", "1024", CV_INTEGER );
+	Cvar_SetDescription( fs_asyncBudget, "Megabytes asynchronous file reads may hold before they are delivered" );
+
+	fs_prefetchBudget = Cvar_Get( "fs_prefetchBudget", "256", CVAR_ARCHIVE_ND );
+	Cvar_CheckRange( fs_prefetchBudget, "0", "4096", CV_INTEGER );
+	Cvar_SetDescription( fs_prefetchBudget, "Megabytes of files read ahead of time, like the next map during intermission, that may be kept in memory" );
+
 	fs_excludeReference = Cvar_Get( "fs_excludeReference", "", CVAR_ARCHIVE_ND | CVAR_LATCH );
 	Cvar_SetDescription( fs_excludeReference,
 		"Exclude specified pak files from download list on client side.\n"
@@ -5360,6 +8354,8 @@ static void FS_Startup( void ) {
 
 	start = Sys_Milliseconds();
 
+	Com_Memset( &fs_scanStats, 0, sizeof( fs_scanStats ) );
+
 #ifdef USE_PK3_CACHE
 #ifdef USE_PK3_CACHE_FILE
 	FS_LoadCache();
@@ -5437,14 +8433,20 @@ static void FS_Startup( void ) {
 	// get the pure checksums of the pk3 files loaded by the server
 	FS_LoadedPakPureChecksums();
 
+	FS_BuildIndex();
+
 	end = Sys_Milliseconds();
 
 	// add our commands
 	Cmd_RegisterArray( fs_cmds, MODULE_COMMON );
+	if ( com_developer->integer ) {
+		Cmd_RegisterArray( fs_benchCmds, MODULE_COMMON );
+	}
 
 	// print the current search paths
 	//FS_Path_f();
 	Com_Printf( "...loaded in %i milliseconds\n", end - start );
+	FS_PrintScanStats();
 
 	Com_Printf( "----------------------\n" );
 	Com_Printf( "%d files in %d pk3 files\n", fs_packFiles, fs_packCount );
@@ -6391,6 +9393,7 @@ int	FS_FOpenFileByMode( const char *qpath, fileHandle_t *f, fsMode_t mode ) {
 
 int FS_FTell( fileHandle_t f ) {
 	int pos;
+	FS_DetachLog( f );
 	if ( fsh[f].zipFile ) {
 		pos = unztell( fsh[f].handleFiles.file.z );
 	} else {
@@ -6402,6 +9405,10 @@ int FS_FTell( fileHandle_t f ) {
 
 void FS_Flush( fileHandle_t f ) 
 {
+	// the log writer doesn't buffer
+	if ( fsh[f].logStream ) {
+		return;
+	}
 	fflush( fsh[f].handleFiles.file.o );
 }
 
@@ -6499,6 +9506,18 @@ void FS_VM_CloseFile( fileHandle_t f, handleOwner_t owner ) {
 }
 
 
+qboolean FS_VM_SetAsyncLog( fileHandle_t f, handleOwner_t owner ) {
+
+	if ( f <= 0 || f >= MAX_FILE_HANDLES )
+		return qfalse;
+
+	if ( fsh[f].owner != owner || !fsh[f].handleFiles.file.v || fsh[f].zipFile )
+		return qfalse;
+
+	return FS_SetAsyncLog( f );
+}
+
+
 void FS_VM_CloseFiles( handleOwner_t owner ) 
 {
 	int i;
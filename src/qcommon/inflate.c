@@ -0,0 +1,571 @@
+/*
+===========================================================================
+
+Wolfenstein: Enemy Territory GPL Source Code
+Copyright (C) 1999-2010 id Software LLC, a ZeniMax Media company.
+
+This file is part of the Wolfenstein: Enemy Territory GPL Source Code (Wolf ET Source Code).
+
+Wolf ET Source Code is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Wolf ET Source Code is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Wolf ET Source Code.  If not, see <http://www.gnu.org/licenses/>.
+
+In addition, the Wolf: ET Source Code is also subject to certain additional terms. You should have received a copy of these additional terms immediately following the terms and conditions of the GNU General Public License which accompanied the Wolf ET Source Code.  If not, please request a copy in writing from id Software at the address below.
+
+If you have questions concerning this license or the applicable additional terms, you may contact in writing id Software LLC, c/o ZeniMax Media Inc., Suite 120, Rockville, Maryland 20850 USA.
+
+===========================================================================
+*/
+
+// inflate.c -- whole buffer deflate decoder for pk3 entries whose compressed
+// and uncompressed sizes are known up front. Streaming reads stay on the
+// zlib code in unzip.c
+
+#include "q_shared.h"
+#include "qcommon.h"
+
+#define LITLEN_SYMS			288
+#define DIST_SYMS			32
+#define PRECODE_SYMS		19
+#define MAX_CODE_LEN		15
+
+#define LITLEN_TABLEBITS	10
+#define DIST_TABLEBITS		8
+#define PRECODE_TABLEBITS	7
+
+// worst case sizes, every long code in a subtable of its own
+#define LITLEN_ENOUGH		( ( 1 << LITLEN_TABLEBITS ) + LITLEN_SYMS * ( 1 << ( MAX_CODE_LEN - LITLEN_TABLEBITS ) ) )
+#define DIST_ENOUGH			( ( 1 << DIST_TABLEBITS ) + DIST_SYMS * ( 1 << ( MAX_CODE_LEN - DIST_TABLEBITS ) ) )
+
+// decode table entries:
+//  bits 0-7	bits consumed by the code
+//  bits 8-11	extra bits of a length or distance, or subtable bits
+//  bits 12-15	flags
+//  bits 16-31	literal, base value or subtable start
+#define E_LITERAL			0x1000
+#define E_END_OF_BLOCK		0x2000
+#define E_SUBTABLE			0x4000
+#define E_INVALID			0x8000
+
+#define E_VALUE( e )		( (e) >> 16 )
+#define E_EXTRA( e )		( ( (e) >> 8 ) & 15 )
+#define E_LENGTH( e )		( (e) & 255 )
+
+// room for the longest match plus a word copy overrun
+#define OUT_MARGIN			( 258 + 8 )
+
+typedef struct {
+	uint32_t	litlen[ LITLEN_ENOUGH ];
+	uint32_t	dist[ DIST_ENOUGH ];
+	uint32_t	precode[ 1 << PRECODE_TABLEBITS ];
+	byte		lens[ LITLEN_SYMS + DIST_SYMS ];
+	uint16_t	sorted[ LITLEN_SYMS ];
+} inflateState_t;
+
+static const uint16_t lengthBase[ 29 ] = {
+	3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+	35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+
+static const byte lengthExtra[ 29 ] = {
+	0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+	3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+
+static const uint16_t distBase[ 30 ] = {
+	1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+	257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+};
+
+static const byte distExtra[ 30 ] = {
+	0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+	7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+
+static const byte precodeOrder[ PRECODE_SYMS ] = {
+	16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15
+};
+
+
+/*
+=================
+Inflate_LitLenEntry
+=================
+*/
+static uint32_t Inflate_LitLenEntry( int sym ) {
+	if ( sym < 256 ) {
+		return ( sym << 16 ) | E_LITERAL;
+	}
+	if ( sym == 256 ) {
+		return E_END_OF_BLOCK;
+	}
+	if ( sym < 286 ) {
+		sym -= 257;
+		return ( lengthBase[ sym ] << 16 ) | ( lengthExtra[ sym ] << 8 );
+	}
+	return E_INVALID;
+}
+
+
+/*
+=================
+Inflate_DistEntry
+=================
+*/
+static uint32_t Inflate_DistEntry( int sym ) {
+	if ( sym < 30 ) {
+		return ( distBase[ sym ] << 16 ) | ( distExtra[ sym ] << 8 );
+	}
+	return E_INVALID;
+}
+
+
+/*
+=================
+Inflate_PrecodeEntry
+=================
+*/
+static uint32_t Inflate_PrecodeEntry( int sym ) {
+	return sym << 16;
+}
+
+
+/*
+=================
+Inflate_Reverse
+
+Deflate stores huffman codes most significant bit first
+=================
+*/
+static unsigned Inflate_Reverse( unsigned code, int len ) {
+	unsigned rev = 0;
+
+	while ( len-- > 0 ) {
+		rev = ( rev << 1 ) | ( code & 1 );
+		code >>= 1;
+	}
+
+	return rev;
+}
+
+
+/*
+=================
+Inflate_BuildTable
+
+Builds a decode table indexed by the next tableBits bits of input, codes
+longer than that continue in subtables. Incomplete codes are allowed, the
+unused entries decode as errors
+=================
+*/
+static qboolean Inflate_BuildTable( inflateState_t *st, uint32_t *table, int tableBits, int enough,
+		const byte *lens, int numSyms, uint32_t (*entry)( int sym ) ) {
+	int			count[ MAX_CODE_LEN + 1 ];
+	int			offs[ MAX_CODE_LEN + 2 ];
+	unsigned	codes[ LITLEN_SYMS ];
+	unsigned	code, prefix, curPrefix;
+	int			left, len, sym, i, j, k;
+	int			next, subBits, subStart;
+
+	Com_Memset( count, 0, sizeof( count ) );
+	for ( sym = 0; sym < numSyms; sym++ ) {
+		count[ lens[ sym ] ]++;
+	}
+
+	// reject over subscribed codes
+	left = 1;
+	for ( len = 1; len <= MAX_CODE_LEN; len++ ) {
+		left = ( left << 1 ) - count[ len ];
+		if ( left < 0 ) {
+			return qfalse;
+		}
+	}
+
+	offs[ 1 ] = 0;
+	for ( len = 1; len <= MAX_CODE_LEN; len++ ) {
+		offs[ len + 1 ] = offs[ len ] + count[ len ];
+	}
+	for ( sym = 0; sym < numSyms; sym++ ) {
+		if ( lens[ sym ] ) {
+			st->sorted[ offs[ lens[ sym ] ]++ ] = sym;
+		}
+	}
+
+	for ( i = 0; i < ( 1 << tableBits ); i++ ) {
+		table[ i ] = E_INVALID;
+	}
+
+	// canonical codes in ( length, symbol ) order
+	code = 0;
+	len = 0;
+	for ( i = 0; i < offs[ MAX_CODE_LEN + 1 ]; i++ ) {
+		int symLen = lens[ st->sorted[ i ] ];
+		if ( i ) {
+			code++;
+		}
+		code <<= symLen - len;
+		len = symLen;
+		codes[ i ] = code;
+	}
+
+	next = 1 << tableBits;
+	subBits = 0;
+	subStart = 0;
+	curPrefix = ~0u;
+
+	for ( i = 0; i < offs[ MAX_CODE_LEN + 1 ]; i++ ) {
+		sym = st->sorted[ i ];
+		len = lens[ sym ];
+		code = codes[ i ];
+
+		if ( len <= tableBits ) {
+			uint32_t e = entry( sym ) | len;
+			for ( k = Inflate_Reverse( code, len ); k < ( 1 << tableBits ); k += 1 << len ) {
+				table[ k ] = e;
+			}
+			continue;
+		}
+
+		prefix = code >> ( len - tableBits );
+		if ( prefix != curPrefix ) {
+			// the codes sharing a prefix are contiguous, the last one is the longest
+			for ( j = i + 1; j < offs[ MAX_CODE_LEN + 1 ]; j++ ) {
+				int l = lens[ st->sorted[ j ] ];
+				if ( ( codes[ j ] >> ( l - tableBits ) ) != prefix ) {
+					break;
+				}
+			}
+			subBits = lens[ st->sorted[ j - 1 ] ] - tableBits;
+			subStart = next;
+			next += 1 << subBits;
+			if ( next > enough ) {
+				return qfalse;
+			}
+			for ( k = subStart; k < next; k++ ) {
+				table[ k ] = E_INVALID;
+			}
+			table[ Inflate_Reverse( prefix, tableBits ) ] = ( subStart << 16 ) | ( subBits << 8 ) | E_SUBTABLE;
+			curPrefix = prefix;
+		}
+
+		len -= tableBits;
+		{
+			uint32_t e = entry( sym ) | len;
+			for ( k = Inflate_Reverse( code, len ); k < ( 1 << subBits ); k += 1 << len ) {
+				table[ subStart + k ] = e;
+			}
+		}
+	}
+
+	return qtrue;
+}
+
+
+/*
+=================
+Com_Inflate
+
+Decodes a raw deflate stream that must produce exactly outLen bytes
+=================
+*/
+qboolean Com_Inflate( void *outBuf, int outLen, const void *inBuf, int inLen ) {
+	inflateState_t	*st;
+	const byte		*in = (const byte *)inBuf;
+	const byte		*inEnd = in + inLen;
+	byte			*out = (byte *)outBuf;
+	byte			*outStart = out;
+	byte			*outEnd = out + outLen;
+	uint64_t		bitbuf;
+	int				bitsleft;
+	int				overrun;
+	int				final, type;
+	qboolean		ok;
+	arenaMark_t		mark;
+
+	if ( outLen < 0 || inLen < 0 ) {
+		return qfalse;
+	}
+
+	// runs on pk3 reader threads as well
+	mark = Com_ThreadTempMark();
+	st = Com_ThreadTempAlloc( sizeof( *st ) );
+	if ( !st ) {
+		return qfalse;
+	}
+
+	bitbuf = 0;
+	bitsleft = 0;
+	overrun = 0;
+	ok = qfalse;
+
+	// keeps at least 56 bits in the buffer, past the end of the input
+	// zero bytes are shifted in and counted
+#ifdef Q3_LITTLE_ENDIAN
+#define REFILL() \
+	if ( inEnd - in >= 8 ) { \
+		uint64_t w; \
+		memcpy( &w, in, 8 ); \
+		bitbuf |= w << bitsleft; \
+		in += ( 63 - bitsleft ) >> 3; \
+		bitsleft |= 56; \
+	} else { \
+		while ( bitsleft < 56 ) { \
+			if ( in < inEnd ) \
+				bitbuf |= (uint64_t)*in++ << bitsleft; \
+			else \
+				overrun++; \
+			bitsleft += 8; \
+		} \
+		if ( overrun > 16 ) \
+			goto done; \
+	}
+#else
+#define REFILL() \
+	while ( bitsleft < 56 ) { \
+		if ( in < inEnd ) \
+			bitbuf |= (uint64_t)*in++ << bitsleft; \
+		else \
+			overrun++; \
+		bitsleft += 8; \
+	} \
+	if ( overrun > 16 ) \
+		goto done;
+#endif
+
+#define BITS( n )		( (unsigned)bitbuf & ( ( 1u << (n) ) - 1 ) )
+#define DROP( n )		{ bitbuf >>= (n); bitsleft -= (n); }
+
+	do {
+		REFILL();
+
+		final = BITS( 1 );
+		DROP( 1 );
+		type = BITS( 2 );
+		DROP( 2 );
+
+		if ( type == 0 ) {
+			unsigned len, nlen;
+
+			// go back to byte boundary, giving back the whole bytes
+			DROP( bitsleft & 7 );
+			if ( ( bitsleft >> 3 ) < overrun ) {
+				goto done;
+			}
+			in -= ( bitsleft >> 3 ) - overrun;
+			bitbuf = 0;
+			bitsleft = 0;
+			overrun = 0;
+
+			if ( inEnd - in < 4 ) {
+				goto done;
+			}
+			len = in[0] | ( in[1] << 8 );
+			nlen = in[2] | ( in[3] << 8 );
+			in += 4;
+			if ( len != ( ~nlen & 0xffff ) || len > inEnd - in || len > outEnd - out ) {
+				goto done;
+			}
+			memcpy( out, in, len );
+			in += len;
+			out += len;
+			continue;
+		}
+
+		if ( type == 1 ) {
+			int i;
+
+			for ( i = 0; i < 144; i++ ) st->lens[ i ] = 8;
+			for ( ; i < 256; i++ ) st->lens[ i ] = 9;
+			for ( ; i < 280; i++ ) st->lens[ i ] = 7;
+			for ( ; i < LITLEN_SYMS; i++ ) st->lens[ i ] = 8;
+			for ( i = 0; i < DIST_SYMS; i++ ) st->lens[ LITLEN_SYMS + i ] = 5;
+
+			if ( !Inflate_BuildTable( st, st->litlen, LITLEN_TABLEBITS, LITLEN_ENOUGH, st->lens, LITLEN_SYMS, Inflate_LitLenEntry ) ||
+				!Inflate_BuildTable( st, st->dist, DIST_TABLEBITS, DIST_ENOUGH, st->lens + LITLEN_SYMS, DIST_SYMS, Inflate_DistEntry ) ) {
+				goto done;
+			}
+		} else if ( type == 2 ) {
+			byte precodeLens[ PRECODE_SYMS ];
+			int numLitLen, numDist, numPrecode;
+			int i, n;
+
+			numLitLen = BITS( 5 ) + 257;
+			DROP( 5 );
+			numDist = BITS( 5 ) + 1;
+			DROP( 5 );
+			numPrecode = BITS( 4 ) + 4;
+			DROP( 4 );
+			if ( numLitLen > 286 || numDist > 30 ) {
+				goto done;
+			}
+
+			// 19 * 3 bits may not fit after the header
+			REFILL();
+			Com_Memset( precodeLens, 0, sizeof( precodeLens ) );
+			for ( i = 0; i < numPrecode; i++ ) {
+				precodeLens[ precodeOrder[ i ] ] = BITS( 3 );
+				DROP( 3 );
+				if ( i == 14 ) {
+					REFILL();
+				}
+			}
+			if ( !Inflate_BuildTable( st, st->precode, PRECODE_TABLEBITS, 1 << PRECODE_TABLEBITS, precodeLens, PRECODE_SYMS, Inflate_PrecodeEntry ) ) {
+				goto done;
+			}
+
+			n = numLitLen + numDist;
+			for ( i = 0; i < n; ) {
+				uint32_t e;
+				int sym, rep;
+				byte val;
+
+				REFILL();
+				e = st->precode[ BITS( PRECODE_TABLEBITS ) ];
+				if ( e & E_INVALID ) {
+					goto done;
+				}
+				DROP( E_LENGTH( e ) );
+				sym = E_VALUE( e );
+
+				if ( sym < 16 ) {
+					st->lens[ i++ ] = sym;
+					continue;
+				}
+				if ( sym == 16 ) {
+					if ( !i ) {
+						goto done;
+					}
+					val = st->lens[ i - 1 ];
+					rep = 3 + BITS( 2 );
+					DROP( 2 );
+				} else if ( sym == 17 ) {
+					val = 0;
+					rep = 3 + BITS( 3 );
+					DROP( 3 );
+				} else {
+					val = 0;
+					rep = 11 + BITS( 7 );
+					DROP( 7 );
+				}
+				if ( rep > n - i ) {
+					goto done;
+				}
+				while ( rep-- ) {
+					st->lens[ i++ ] = val;
+				}
+			}
+
+			if ( !st->lens[ 256 ] ) {
+				goto done;
+			}
+
+			// the literal/length and distance code lengths are one sequence
+			memmove( st->lens + LITLEN_SYMS, st->lens + numLitLen, numDist );
+			Com_Memset( st->lens + numLitLen, 0, LITLEN_SYMS - numLitLen );
+			Com_Memset( st->lens + LITLEN_SYMS + numDist, 0, DIST_SYMS - numDist );
+
+			if ( !Inflate_BuildTable( st, st->litlen, LITLEN_TABLEBITS, LITLEN_ENOUGH, st->lens, LITLEN_SYMS, Inflate_LitLenEntry ) ||
+				!Inflate_BuildTable( st, st->dist, DIST_TABLEBITS, DIST_ENOUGH, st->lens + LITLEN_SYMS, DIST_SYMS, Inflate_DistEntry ) ) {
+				goto done;
+			}
+		} else {
+			goto done;
+		}
+
+		// a refill covers the longest length and distance codes with their extra bits
+		for ( ;; ) {
+			uint32_t	e;
+			int			length, dist;
+			const byte	*src;
+			byte		*end;
+
+			REFILL();
+
+			e = st->litlen[ BITS( LITLEN_TABLEBITS ) ];
+			if ( e & E_SUBTABLE ) {
+				DROP( LITLEN_TABLEBITS );
+				e = st->litlen[ E_VALUE( e ) + BITS( E_EXTRA( e ) ) ];
+			}
+			DROP( E_LENGTH( e ) );
+
+			if ( e & E_LITERAL ) {
+				if ( out == outEnd ) {
+					goto done;
+				}
+				*out++ = E_VALUE( e );
+				continue;
+			}
+
+			if ( e & ( E_END_OF_BLOCK | E_INVALID ) ) {
+				if ( e & E_INVALID ) {
+					goto done;
+				}
+				break;
+			}
+
+			length = E_VALUE( e ) + BITS( E_EXTRA( e ) );
+			DROP( E_EXTRA( e ) );
+
+			e = st->dist[ BITS( DIST_TABLEBITS ) ];
+			if ( e & E_SUBTABLE ) {
+				DROP( DIST_TABLEBITS );
+				e = st->dist[ E_VALUE( e ) + BITS( E_EXTRA( e ) ) ];
+			}
+			if ( e & E_INVALID ) {
+				goto done;
+			}
+			DROP( E_LENGTH( e ) );
+			dist = E_VALUE( e ) + BITS( E_EXTRA( e ) );
+			DROP( E_EXTRA( e ) );
+
+			if ( dist > out - outStart || length > outEnd - out ) {
+				goto done;
+			}
+
+			src = out - dist;
+			end = out + length;
+
+			if ( outEnd - out >= OUT_MARGIN ) {
+				if ( dist >= 8 ) {
+					// may write up to 7 bytes past the match
+					do {
+						memcpy( out, src, 8 );
+						out += 8;
+						src += 8;
+					} while ( out < end );
+				} else if ( dist == 1 ) {
+					memset( out, *src, length );
+				} else {
+					do {
+						*out++ = *src++;
+					} while ( out < end );
+				}
+			} else {
+				do {
+					*out++ = *src++;
+				} while ( out < end );
+			}
+			out = end;
+		}
+	} while ( !final );
+
+	// the zero bytes shifted in past the end must not have been used
+	ok = ( out == outEnd && bitsleft >= overrun * 8 ) ? qtrue : qfalse;
+
+done:
+	Com_ThreadTempRelease( mark );
+	return ok;
+
+#undef REFILL
+#undef BITS
+#undef DROP
+}
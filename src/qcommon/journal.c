@@ -0,0 +1,559 @@
+/*
+===========================================================================
+
+Wolfenstein: Enemy Territory GPL Source Code
+Copyright (C) 1999-2010 id Software LLC, a ZeniMax Media company.
+
+This file is part of the Wolfenstein: Enemy Territory GPL Source Code (Wolf ET Source Code).
+
+Wolf ET Source Code is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Wolf ET Source Code is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Wolf ET Source Code.  If not, see <http://www.gnu.org/licenses/>.
+
+In addition, the Wolf: ET Source Code is also subject to certain additional terms. You should have received a copy of these additional terms immediately following the terms and conditions of the GNU General Public License which accompanied the Wolf ET Source Code.  If not, please request a copy in writing from id Software at the address below.
+
+If you have questions concerning this license or the applicable additional terms, you may contact in writing id Software LLC, c/o ZeniMax Media Inc., Suite 120, Rockville, Maryland 20850 USA.
+
+===========================================================================
+*/
+
+// journal.c -- event journaling and deterministic session replay
+//
+// With journal 1 every system event, every packet handed to the server or
+// client, config file reads and random bytes are written to journal.dat and
+// journaldata.dat, and the server adds a checksum of the game state after
+// each frame that ran the game module.
+//
+// journal 2 plays the session back: events and packets come from the
+// journal, nothing is sent on the wire and the main loop never sleeps, so a
+// recorded dedicated server session runs as fast as the machine allows.
+// Every replayed frame is checksummed again and compared with the recording,
+// and a wall clock report per frame phase is printed when the replay ends.
+// Set journal_strict 1 to abort with an error on the first divergence.
+
+#include "q_shared.h"
+#include "qcommon.h"
+
+#define JOURNAL_MAX_REPORTED	8		// mismatches printed in detail
+
+typedef enum {
+	JP_NET,				// replayed packets handed to the server
+	JP_GAME,			// GAME_RUN_FRAME
+	JP_SNAPSHOTS,		// SV_SendClientMessages
+	JP_SERVER,			// all of SV_Frame
+	JP_FRAME,			// whole main loop iteration
+	JP_NUM_PHASES
+} journalPhase_t;
+
+static const char *journalPhaseNames[ JP_NUM_PHASES ] = {
+	"net",
+	"game",
+	"snapshots",
+	"server",
+	"frame"
+};
+
+typedef struct {
+	int				usec[ JP_NUM_PHASES ];
+} journalSample_t;
+
+typedef struct {
+	int				eventTime;			// time of the last journaled event
+	int				firstEventTime;
+	qboolean		haveEventTime;
+
+	sysEvent_t		peek;				// record pushed back by a checksum lookup
+	qboolean		peeked;
+
+	int64_t			startUsec;
+	int64_t			frameUsec;			// end of the previous frame sample
+	int				netUsec;			// packet dispatch since the previous sample
+
+	int				packets;
+	int				verified;
+	int				mismatches;
+
+	journalSample_t	*samples;
+	int				numSamples;
+	int				maxSamples;
+} journal_t;
+
+static journal_t journal;
+
+static fileHandle_t com_journalFile = FS_INVALID_HANDLE; // events are written here
+fileHandle_t com_journalDataFile = FS_INVALID_HANDLE; // config files are written here
+
+static cvar_t *journal_strict;
+
+
+/*
+=================
+Com_InitJournaling
+=================
+*/
+void Com_InitJournaling( void ) {
+	if ( !com_journal->integer ) {
+		return;
+	}
+
+	if ( com_journal->integer == 1 ) {
+		Com_Printf( "Journaling events\n" );
+		com_journalFile = FS_FOpenFileWrite( "journal.dat" );
+		com_journalDataFile = FS_FOpenFileWrite( "journaldata.dat" );
+	} else if ( com_journal->integer == 2 ) {
+		Com_Printf( "Replaying journaled events\n" );
+		FS_FOpenFileRead( "journal.dat", &com_journalFile, qtrue );
+		FS_FOpenFileRead( "journaldata.dat", &com_journalDataFile, qtrue );
+	}
+
+	if ( com_journalFile == FS_INVALID_HANDLE || com_journalDataFile == FS_INVALID_HANDLE ) {
+		Cvar_Set( "journal", "0" );
+		if ( com_journalFile != FS_INVALID_HANDLE ) {
+			FS_FCloseFile( com_journalFile );
+			com_journalFile = FS_INVALID_HANDLE;
+		}
+		if ( com_journalDataFile != FS_INVALID_HANDLE ) {
+			FS_FCloseFile( com_journalDataFile );
+			com_journalDataFile = FS_INVALID_HANDLE;
+		}
+		Com_Printf( "Couldn't open journal files\n" );
+		return;
+	}
+
+	journal_strict = Cvar_Get( "journal_strict", "0", CVAR_INIT | CVAR_PROTECTED );
+	Cvar_CheckRange( journal_strict, "0", "1", CV_INTEGER );
+	Cvar_SetDescription( journal_strict, "Abort a journal replay with an error when the game state diverges from the recording" );
+
+	journal.startUsec = Sys_Microseconds();
+	journal.frameUsec = journal.startUsec;
+}
+
+
+/*
+=================
+Com_JournalPercentile
+
+Nearest rank percentile of a sorted array
+=================
+*/
+static int Com_JournalPercentile( const int *sorted, int count, int percent ) {
+	int index;
+
+	index = ( count * percent + 99 ) / 100 - 1;
+	if ( index < 0 ) {
+		index = 0;
+	}
+
+	return sorted[ index ];
+}
+
+
+/*
+=================
+Com_JournalCompareInt
+=================
+*/
+static int Com_JournalCompareInt( const void *a, const void *b ) {
+	return *(const int *)a - *(const int *)b;
+}
+
+
+/*
+=================
+Com_JournalReport
+=================
+*/
+static void Com_JournalReport( void ) {
+	int64_t	sum;
+	int		*values;
+	int		recorded, wall;
+	int		p, i;
+
+	wall = (int)( ( Sys_Microseconds() - journal.startUsec ) / 1000 );
+	recorded = journal.eventTime - journal.firstEventTime;
+
+	Com_Printf( "Journal replay: %i frames, %i packets, %i.%03i s recorded in %i.%03i s",
+		journal.numSamples, journal.packets, recorded / 1000, recorded % 1000, wall / 1000, wall % 1000 );
+	if ( wall > 0 ) {
+		Com_Printf( " (%.1fx)", (float)recorded / wall );
+	}
+	Com_Printf( "\n" );
+
+	Com_Printf( "Checksums: %i verified, %i mismatched\n", journal.verified, journal.mismatches );
+
+	if ( journal.numSamples ) {
+		values = malloc( journal.numSamples * sizeof( *values ) );
+		if ( values ) {
+			Com_Printf( "%-10s %8s %8s %8s %8s %8s  (usec)\n", "phase", "avg", "p50", "p95", "p99", "max" );
+			for ( p = 0; p < JP_NUM_PHASES; p++ ) {
+				sum = 0;
+				for ( i = 0; i < journal.numSamples; i++ ) {
+					values[i] = journal.samples[i].usec[p];
+					sum += values[i];
+				}
+				qsort( values, journal.numSamples, sizeof( values[0] ), Com_JournalCompareInt );
+				Com_Printf( "%-10s %8i %8i %8i %8i %8i\n", journalPhaseNames[p],
+					(int)( sum / journal.numSamples ),
+					Com_JournalPercentile( values, journal.numSamples, 50 ),
+					Com_JournalPercentile( values, journal.numSamples, 95 ),
+					Com_JournalPercentile( values, journal.numSamples, 99 ),
+					values[ journal.numSamples - 1 ] );
+			}
+			free( values );
+		}
+	}
+
+	if ( journal.mismatches ) {
+		Com_Printf( S_COLOR_RED "Replay diverged from the recording\n" );
+	} else {
+		Com_Printf( "Replay matched the recording\n" );
+	}
+}
+
+
+/*
+=================
+Com_ShutdownJournaling
+=================
+*/
+void Com_ShutdownJournaling( void ) {
+	if ( Com_JournalReplaying() ) {
+		Com_JournalReport();
+	}
+
+	if ( com_journalFile != FS_INVALID_HANDLE ) {
+		FS_FCloseFile( com_journalFile );
+		com_journalFile = FS_INVALID_HANDLE;
+	}
+
+	if ( com_journalDataFile != FS_INVALID_HANDLE ) {
+		FS_FCloseFile( com_journalDataFile );
+		com_journalDataFile = FS_INVALID_HANDLE;
+	}
+
+	if ( journal.peeked && journal.peek.evPtr ) {
+		Z_Free( journal.peek.evPtr );
+	}
+
+	free( journal.samples );
+	Com_Memset( &journal, 0, sizeof( journal ) );
+}
+
+
+/*
+=================
+Com_JournalRecording
+=================
+*/
+qboolean Com_JournalRecording( void ) {
+	return com_journalFile != FS_INVALID_HANDLE && com_journal->integer == 1;
+}
+
+
+/*
+=================
+Com_JournalReplaying
+=================
+*/
+qboolean Com_JournalReplaying( void ) {
+	return com_journalFile != FS_INVALID_HANDLE && com_journal->integer == 2;
+}
+
+
+/*
+=================
+Com_EventTime
+
+Time of the last journaled event while journaling, real time otherwise.
+Intervals that decide what the server does (rate limits, pings) are measured
+with this, so they come out the same when the session is replayed.
+=================
+*/
+int Com_EventTime( void ) {
+	if ( com_journalFile != FS_INVALID_HANDLE ) {
+		return journal.eventTime;
+	}
+	return Sys_Milliseconds();
+}
+
+
+/*
+=================
+Com_JournalSetTime
+=================
+*/
+static void Com_JournalSetTime( int evTime ) {
+	if ( !journal.haveEventTime ) {
+		journal.firstEventTime = evTime;
+		journal.haveEventTime = qtrue;
+	}
+	journal.eventTime = evTime;
+}
+
+
+/*
+=================
+Com_JournalWrite
+=================
+*/
+static void Com_JournalWrite( const void *data, int length ) {
+	if ( FS_Write( data, length, com_journalFile ) != length ) {
+		Com_Error( ERR_FATAL, "Error writing to journal file" );
+	}
+}
+
+
+/*
+=================
+Com_JournalWriteEvent
+
+Records an event returned by the system, if journaling
+=================
+*/
+void Com_JournalWriteEvent( const sysEvent_t *ev ) {
+	if ( !Com_JournalRecording() ) {
+		return;
+	}
+
+	Com_JournalSetTime( ev->evTime );
+
+	Com_JournalWrite( ev, sizeof( *ev ) );
+	if ( ev->evPtrLength ) {
+		Com_JournalWrite( ev->evPtr, ev->evPtrLength );
+	}
+}
+
+
+/*
+=================
+Com_JournalPacket
+
+Records a packet before it is handed to the server or the client
+=================
+*/
+void Com_JournalPacket( const netadr_t *from, const msg_t *msg ) {
+	sysEvent_t ev;
+
+	if ( !Com_JournalRecording() ) {
+		return;
+	}
+
+	Com_Memset( &ev, 0, sizeof( ev ) );
+	ev.evTime = journal.eventTime;
+	ev.evType = SE_PACKET;
+	ev.evValue = msg->cursize;
+	ev.evValue2 = msg->readcount;
+	ev.evPtrLength = sizeof( *from ) + msg->cursize;
+
+	Com_JournalWrite( &ev, sizeof( ev ) );
+	Com_JournalWrite( from, sizeof( *from ) );
+	Com_JournalWrite( msg->data, msg->cursize );
+}
+
+
+/*
+=================
+Com_JournalRead
+
+Returns qfalse at the end of the journal
+=================
+*/
+static qboolean Com_JournalRead( sysEvent_t *ev ) {
+	if ( journal.peeked ) {
+		*ev = journal.peek;
+		journal.peeked = qfalse;
+		return qtrue;
+	}
+
+	if ( FS_Read( ev, sizeof( *ev ), com_journalFile ) != sizeof( *ev ) ) {
+		return qfalse;
+	}
+
+	if ( (unsigned)ev->evType >= SE_MAX || ev->evPtrLength < 0 ) {
+		Com_Error( ERR_FATAL, "Error reading from journal file" );
+	}
+
+	ev->evPtr = NULL;
+	if ( ev->evPtrLength ) {
+		ev->evPtr = Z_Malloc( ev->evPtrLength );
+		if ( FS_Read( ev->evPtr, ev->evPtrLength, com_journalFile ) != ev->evPtrLength ) {
+			// the recording was cut off in the middle of a record
+			Z_Free( ev->evPtr );
+			return qfalse;
+		}
+	}
+
+	return qtrue;
+}
+
+
+/*
+=================
+Com_JournalMismatch
+=================
+*/
+static void FORMAT_PRINTF(2, 3) Com_JournalMismatch( int serverTime, const char *fmt, ... ) {
+	va_list		argptr;
+	char		text[ MAX_STRING_CHARS ];
+
+	va_start( argptr, fmt );
+	Q_vsnprintf( text, sizeof( text ), fmt, argptr );
+	va_end( argptr );
+
+	journal.mismatches++;
+
+	if ( journal_strict->integer ) {
+		Com_Error( ERR_FATAL, "Journal replay diverged at server time %i: %s", serverTime, text );
+	}
+
+	if ( journal.mismatches <= JOURNAL_MAX_REPORTED ) {
+		Com_Printf( S_COLOR_YELLOW "Journal replay diverged at server time %i: %s\n", serverTime, text );
+	} else if ( journal.mismatches == JOURNAL_MAX_REPORTED + 1 ) {
+		Com_Printf( S_COLOR_YELLOW "Further journal mismatches are not reported\n" );
+	}
+}
+
+
+/*
+=================
+Com_JournalReplayPacket
+=================
+*/
+static void Com_JournalReplayPacket( const sysEvent_t *ev ) {
+	static byte	bufData[ MAX_MSGLEN_BUF ];
+	netadr_t	from;
+	msg_t		msg;
+	int64_t		start;
+
+	if ( ev->evValue < 0 || ev->evValue > MAX_MSGLEN || ev->evValue2 < 0 || ev->evValue2 > ev->evValue
+		|| ev->evPtrLength != (int)sizeof( from ) + ev->evValue ) {
+		Com_Error( ERR_FATAL, "Bad packet record in journal file" );
+	}
+
+	Com_Memcpy( &from, ev->evPtr, sizeof( from ) );
+
+	MSG_Init( &msg, bufData, MAX_MSGLEN );
+	Com_Memcpy( msg.data, (const byte *)ev->evPtr + sizeof( from ), ev->evValue );
+	msg.cursize = ev->evValue;
+	msg.readcount = ev->evValue2;
+
+	start = Sys_Microseconds();
+	NET_DispatchPacket( &from, &msg );
+	journal.netUsec += (int)( Sys_Microseconds() - start );
+	journal.packets++;
+}
+
+
+/*
+=================
+Com_JournalReadEvent
+
+Next system event of a replayed session. Packets recorded in between are
+dispatched on the way, as they were when the journal was written.
+=================
+*/
+sysEvent_t Com_JournalReadEvent( void ) {
+	sysEvent_t	ev;
+
+	while ( Com_JournalRead( &ev ) ) {
+		switch ( ev.evType ) {
+		case SE_PACKET:
+			Com_JournalReplayPacket( &ev );
+			break;
+		case SE_CHECKSUM:
+			Com_JournalMismatch( ev.evValue, "recorded frame was not replayed" );
+			break;
+		default:
+			Com_JournalSetTime( ev.evTime );
+			return ev;
+		}
+
+		if ( ev.evPtr ) {
+			Z_Free( ev.evPtr );
+		}
+	}
+
+	Com_Printf( "End of journal\n" );
+	Cbuf_ExecuteText( EXEC_NOW, "quit" );
+
+	// not reached
+	Com_Memset( &ev, 0, sizeof( ev ) );
+	ev.evTime = journal.eventTime;
+	return ev;
+}
+
+
+/*
+=================
+Com_JournalServerFrame
+
+Called after each server frame that ran the game module. Recording stores
+the game state checksum, replay compares against it and keeps the timing.
+=================
+*/
+void Com_JournalServerFrame( int serverTime, unsigned int checksum, int gameUsec, int snapshotsUsec, int serverUsec ) {
+	journalSample_t	*sample;
+	sysEvent_t		ev;
+	int64_t			now;
+
+	if ( Com_JournalRecording() ) {
+		Com_Memset( &ev, 0, sizeof( ev ) );
+		ev.evTime = journal.eventTime;
+		ev.evType = SE_CHECKSUM;
+		ev.evValue = serverTime;
+		ev.evValue2 = (int)checksum;
+		Com_JournalWrite( &ev, sizeof( ev ) );
+		return;
+	}
+
+	if ( !Com_JournalReplaying() ) {
+		return;
+	}
+
+	if ( Com_JournalRead( &ev ) ) {
+		if ( ev.evType != SE_CHECKSUM ) {
+			// leave it for the event loop
+			journal.peek = ev;
+			journal.peeked = qtrue;
+			Com_JournalMismatch( serverTime, "frame is not in the recording" );
+		} else if ( ev.evValue != serverTime ) {
+			Com_JournalMismatch( serverTime, "recorded frame has server time %i", ev.evValue );
+		} else if ( (unsigned int)ev.evValue2 != checksum ) {
+			Com_JournalMismatch( serverTime, "game state checksum %08x, recorded %08x", checksum, (unsigned int)ev.evValue2 );
+		} else {
+			journal.verified++;
+		}
+	}
+
+	if ( journal.numSamples == journal.maxSamples ) {
+		int newMax = journal.maxSamples ? journal.maxSamples * 2 : 4096;
+		journalSample_t *newSamples = realloc( journal.samples, newMax * sizeof( *newSamples ) );
+		if ( !newSamples ) {
+			return;
+		}
+		journal.samples = newSamples;
+		journal.maxSamples = newMax;
+	}
+
+	now = Sys_Microseconds();
+
+	sample = &journal.samples[ journal.numSamples++ ];
+	sample->usec[ JP_NET ] = journal.netUsec;
+	sample->usec[ JP_GAME ] = gameUsec;
+	sample->usec[ JP_SNAPSHOTS ] = snapshotsUsec;
+	sample->usec[ JP_SERVER ] = serverUsec;
+	sample->usec[ JP_FRAME ] = (int)( now - journal.frameUsec );
+
+	journal.netUsec = 0;
+	journal.frameUsec = now;
+}
+
@@ -0,0 +1,560 @@
+/*
+===========================================================================
+
+Wolfenstein: Enemy Territory GPL Source Code
+Copyright (C) 1999-2010 id Software LLC, a ZeniMax Media company.
+
+This file is part of the Wolfenstein: Enemy Territory GPL Source Code (Wolf ET Source Code).
+
+Wolf ET Source Code is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Wolf ET Source Code is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Wolf ET Source Code.  If not, see <http://www.gnu.org/licenses/>.
+
+In addition, the Wolf: ET Source Code is also subject to certain additional terms. You should have received a copy of these additional terms immediately following the terms and conditions of the GNU General Public License which accompanied the Wolf ET Source Code.  If not, please request a copy in writing from id Software at the address below.
+
+If you have questions concerning this license or the applicable additional terms, you may contact in writing id Software LLC, c/o ZeniMax Media Inc., Suite 120, Rockville, Maryland 20850 USA.
+
+===========================================================================
+*/
+
+// logwriter.c -- writes the console and game logs on a background thread
+//
+// FS_Write on a handle passed to FS_SetAsyncLog only copies the text into
+// a per file ring buffer; a writer thread empties the rings with one
+// gathered write per file. The main thread is the only producer and the
+// writer the only consumer, so the rings need no locks. When a ring is
+// full messages are dropped and counted instead of stalling the frame.
+//
+// The lock only keeps the writer away while a file is attached, detached
+// or flushed synchronously on exit. The exit flush can run from a signal
+// handler, so it never waits on the lock for long.
+
+#include "q_shared.h"
+#include "qcommon.h"
+
+#if defined( _MSC_VER )
+#include <intrin.h>
+#define LOG_LOAD( p )		( (unsigned int)_InterlockedOr( (volatile long *)(p), 0 ) )
+#define LOG_STORE( p, v )	_InterlockedExchange( (volatile long *)(p), (long)(v) )
+#else
+#define LOG_LOAD( p )		__atomic_load_n( (p), __ATOMIC_ACQUIRE )
+#define LOG_STORE( p, v )	__atomic_store_n( (p), (v), __ATOMIC_RELEASE )
+#endif
+
+#define MAX_LOG_STREAMS		4
+#define LOG_FLUSH_WAIT		100			// msec the crash path waits for the writer
+
+typedef struct {
+	qboolean		active;
+	FILE			*file;
+	qboolean		sync;			// wake the writer on every message
+
+	byte			*ring;
+	unsigned int	head;			// advanced by the main thread
+	unsigned int	tail;			// advanced by whoever drains
+	unsigned int	kicked;			// head at the last wakeup
+	unsigned int	unsynced;		// written since the last fsync
+
+	// main thread
+	int				dropped;		// since the last marker
+	int				droppedTotal;
+	int64_t			droppedBytes;
+
+	// writer, under the lock
+	int64_t			bytes;
+	int				batches;
+	int				syncs;
+	int				errors;
+	int				lastSync;
+} logStream_t;
+
+static struct {
+	sysThread_t		*thread;
+	sysMutex_t		*lock;
+	sysSemaphore_t	*wake;
+	unsigned int	quit;
+	unsigned int	fsyncMsec;
+	int				lastKick;
+
+	unsigned int	ringSize;
+	logStream_t		streams[ MAX_LOG_STREAMS ];
+} logw;
+
+static Q_THREADLOCAL qboolean logIsWriter;
+
+static cvar_t	*com_logAsync;
+static cvar_t	*com_logBuffer;
+static cvar_t	*com_logFsync;
+
+
+/*
+================
+Com_LogDrain
+
+Writes out everything queued so far, called with the lock held
+================
+*/
+static void Com_LogDrain( logStream_t *s ) {
+	sysIoVec_t		vec[2];
+	unsigned int	head, start, len, first;
+	int				count;
+
+	head = LOG_LOAD( &s->head );
+	len = head - s->tail;
+	if ( !len ) {
+		return;
+	}
+
+	start = s->tail & ( logw.ringSize - 1 );
+	first = MIN( len, logw.ringSize - start );
+
+	vec[0].data = s->ring + start;
+	vec[0].length = first;
+	count = 1;
+
+	// wrapped around the end of the ring
+	if ( first < len ) {
+		vec[1].data = s->ring;
+		vec[1].length = len - first;
+		count = 2;
+	}
+
+	if ( !Sys_WriteFileV( s->file, vec, count ) ) {
+		s->errors++;
+	}
+
+	s->bytes += len;
+	s->batches++;
+	LOG_STORE( &s->unsynced, 1 );
+	LOG_STORE( &s->tail, head );
+}
+
+
+/*
+================
+Com_LogSync
+
+Periodic fsync policy, called with the lock held
+================
+*/
+static void Com_LogSync( logStream_t *s, qboolean force ) {
+	unsigned int	interval;
+	int				now;
+
+	if ( !LOG_LOAD( &s->unsynced ) ) {
+		return;
+	}
+
+	interval = LOG_LOAD( &logw.fsyncMsec );
+	if ( !interval ) {
+		return;
+	}
+
+	now = Sys_Milliseconds();
+	if ( !force && now - s->lastSync < (int)interval ) {
+		return;
+	}
+
+	Sys_SyncFile( s->file );
+	s->syncs++;
+	s->lastSync = now;
+	LOG_STORE( &s->unsynced, 0 );
+}
+
+
+/*
+================
+Com_LogThread
+================
+*/
+static void Com_LogThread( void *arg ) {
+	logStream_t	*s;
+	int			i;
+
+	logIsWriter = qtrue;
+
+	while ( 1 ) {
+		Sys_WaitSemaphore( logw.wake );
+
+		if ( LOG_LOAD( &logw.quit ) ) {
+			break;
+		}
+
+		Sys_LockMutex( logw.lock );
+		for ( i = 0, s = logw.streams; i < MAX_LOG_STREAMS; i++, s++ ) {
+			if ( s->active ) {
+				Com_LogDrain( s );
+				Com_LogSync( s, qfalse );
+			}
+		}
+		Sys_UnlockMutex( logw.lock );
+	}
+}
+
+
+/*
+================
+Com_LogStart
+
+The thread is only started for the first attached log
+================
+*/
+static qboolean Com_LogStart( void ) {
+	if ( logw.thread ) {
+		return qtrue;
+	}
+
+	logw.lock = Sys_CreateMutex();
+	logw.wake = Sys_CreateSemaphore();
+	if ( logw.lock && logw.wake ) {
+		logw.ringSize = 1024;
+		while ( logw.ringSize < (unsigned int)com_logBuffer->integer * 1024 ) {
+			logw.ringSize <<= 1;
+		}
+
+		LOG_STORE( &logw.quit, 0 );
+		LOG_STORE( &logw.fsyncMsec, com_logFsync->integer );
+		logw.thread = Sys_CreateThread( Com_LogThread, NULL );
+	}
+
+	if ( !logw.thread ) {
+		if ( logw.wake ) {
+			Sys_DestroySemaphore( logw.wake );
+		}
+		if ( logw.lock ) {
+			Sys_DestroyMutex( logw.lock );
+		}
+		logw.wake = NULL;
+		logw.lock = NULL;
+		return qfalse;
+	}
+
+	return qtrue;
+}
+
+
+/*
+================
+Com_LogAttach
+
+Returns the stream the file is written through from now on,
+or -1 if it should be written directly. f must be flushed.
+================
+*/
+int Com_LogAttach( FILE *f, qboolean sync ) {
+	logStream_t	*s;
+	int			i;
+
+	if ( !com_logAsync || !com_logAsync->integer || !Com_LogStart() ) {
+		return -1;
+	}
+
+	for ( i = 0, s = logw.streams; i < MAX_LOG_STREAMS; i++, s++ ) {
+		if ( !s->active ) {
+			break;
+		}
+	}
+	if ( i == MAX_LOG_STREAMS ) {
+		return -1;
+	}
+
+	if ( !s->ring ) {
+		s->ring = malloc( logw.ringSize );
+		if ( !s->ring ) {
+			return -1;
+		}
+	}
+
+	Sys_LockMutex( logw.lock );
+	s->file = f;
+	s->sync = sync;
+	s->head = s->tail = s->kicked = 0;
+	s->unsynced = 0;
+	s->dropped = 0;
+	s->lastSync = Sys_Milliseconds();
+	s->active = qtrue;
+	Sys_UnlockMutex( logw.lock );
+
+	return i;
+}
+
+
+/*
+================
+Com_LogDetach
+
+Writes out the rest synchronously, the file can be closed afterwards
+================
+*/
+void Com_LogDetach( int stream ) {
+	logStream_t *s = &logw.streams[ stream ];
+
+	if ( !logw.thread ) {
+		return;
+	}
+
+	Sys_LockMutex( logw.lock );
+	Com_LogDrain( s );
+	Com_LogSync( s, qtrue );
+	s->active = qfalse;
+	s->file = NULL;
+	Sys_UnlockMutex( logw.lock );
+}
+
+
+/*
+================
+Com_LogCopy
+================
+*/
+static void Com_LogCopy( logStream_t *s, const void *data, unsigned int len ) {
+	unsigned int start, first;
+
+	start = s->head & ( logw.ringSize - 1 );
+	first = MIN( len, logw.ringSize - start );
+
+	memcpy( s->ring + start, data, first );
+	memcpy( s->ring, (const byte *)data + first, len - first );
+
+	LOG_STORE( &s->head, s->head + len );
+}
+
+
+/*
+================
+Com_LogWrite
+
+Never blocks, messages that don't fit are dropped and replaced
+by a marker once there is room again. Returns qfalse once the
+writer is shut down, the file is written directly then.
+================
+*/
+qboolean Com_LogWrite( int stream, const void *data, int len ) {
+	logStream_t		*s = &logw.streams[ stream ];
+	unsigned int	used, half;
+	char			marker[ 64 ];
+	int				n;
+
+	if ( !s->active ) {
+		return qfalse;
+	}
+
+	if ( len <= 0 ) {
+		return qtrue;
+	}
+
+	used = s->head - LOG_LOAD( &s->tail );
+	half = logw.ringSize / 2;
+
+	if ( s->dropped ) {
+		n = Com_sprintf( marker, sizeof( marker ), "[%i log messages dropped]\n", s->dropped );
+		if ( used + n <= logw.ringSize ) {
+			Com_LogCopy( s, marker, n );
+			used += n;
+			s->dropped = 0;
+		}
+	}
+
+	if ( (unsigned int)len > logw.ringSize - used ) {
+		s->dropped++;
+		s->droppedTotal++;
+		s->droppedBytes += len;
+		return qtrue;
+	}
+
+	Com_LogCopy( s, data, len );
+
+	// don't wait for the end of the frame once the ring fills up
+	if ( s->sync || ( used <= half && used + len > half ) ) {
+		s->kicked = s->head;
+		Sys_PostSemaphore( logw.wake );
+	}
+
+	return qtrue;
+}
+
+
+/*
+================
+Com_LogFrame
+
+Wakes the writer once per frame if anything was queued,
+or when a periodic fsync is due
+================
+*/
+void Com_LogFrame( void ) {
+	logStream_t	*s;
+	qboolean	kick;
+	int			i, now;
+
+	if ( !logw.thread ) {
+		return;
+	}
+
+	if ( com_logFsync->modified ) {
+		LOG_STORE( &logw.fsyncMsec, com_logFsync->integer );
+		com_logFsync->modified = qfalse;
+	}
+
+	now = Sys_Milliseconds();
+	kick = qfalse;
+
+	for ( i = 0, s = logw.streams; i < MAX_LOG_STREAMS; i++, s++ ) {
+		if ( !s->active ) {
+			continue;
+		}
+		if ( s->kicked != s->head ) {
+			s->kicked = s->head;
+			kick = qtrue;
+		} else if ( com_logFsync->integer && LOG_LOAD( &s->unsynced ) && now - logw.lastKick >= com_logFsync->integer ) {
+			kick = qtrue;
+		}
+	}
+
+	if ( kick ) {
+		logw.lastKick = now;
+		Sys_PostSemaphore( logw.wake );
+	}
+}
+
+
+/*
+================
+Com_LogFlush
+
+Synchronous flush for exit and crash paths. A fault on the writer thread
+leaves the lock held by a dead writer, the rings are drained without it
+then. Otherwise the writer gets a moment to finish its batch, and the rest
+is given up rather than blocking a signal handler.
+================
+*/
+void Com_LogFlush( void ) {
+	logStream_t	*s;
+	qboolean	locked;
+	int			i, start;
+
+	if ( !logw.thread ) {
+		return;
+	}
+
+	locked = qfalse;
+	if ( !logIsWriter ) {
+		start = Sys_Milliseconds();
+		while ( !( locked = Sys_TryLockMutex( logw.lock ) ) ) {
+			if ( Sys_Milliseconds() - start >= LOG_FLUSH_WAIT ) {
+				return;
+			}
+		}
+	}
+
+	for ( i = 0, s = logw.streams; i < MAX_LOG_STREAMS; i++, s++ ) {
+		if ( s->active ) {
+			Com_LogDrain( s );
+			Com_LogSync( s, qtrue );
+		}
+	}
+
+	if ( locked ) {
+		Sys_UnlockMutex( logw.lock );
+	}
+}
+
+
+/*
+================
+Com_LogStats_f
+================
+*/
+static void Com_LogStats_f( void ) {
+	logStream_t	*s;
+	int			i, n;
+
+	if ( !logw.thread ) {
+		Com_Printf( "log writer not running\n" );
+		return;
+	}
+
+	Com_Printf( "log writer: %i KB ring per file, fsync %s\n", logw.ringSize / 1024,
+		com_logFsync->integer ? va( "every %i msec", com_logFsync->integer ) : "off" );
+
+	Sys_LockMutex( logw.lock );
+	for ( i = 0, s = logw.streams, n = 0; i < MAX_LOG_STREAMS; i++, s++ ) {
+		if ( !s->active ) {
+			continue;
+		}
+		Com_Printf( "%i: %.1f KB in %i writes, %i queued, %i fsyncs, %i errors, %i dropped (%.1f KB)%s\n", i,
+			s->bytes / 1024.0, s->batches, s->head - s->tail, s->syncs, s->errors,
+			s->droppedTotal, s->droppedBytes / 1024.0, s->sync ? ", sync" : "" );
+		n++;
+	}
+	Sys_UnlockMutex( logw.lock );
+
+	if ( !n ) {
+		Com_Printf( "no files attached\n" );
+	}
+}
+
+
+/*
+================
+Com_InitLogWriter
+================
+*/
+void Com_InitLogWriter( void ) {
+	com_logAsync = Cvar_Get( "com_logAsync", "1", CVAR_ARCHIVE_ND );
+	Cvar_CheckRange( com_logAsync, "0", "1", CV_INTEGER );
+	Cvar_SetDescription( com_logAsync, "Write the console log and the game log on a background thread, applies to logs opened afterwards" );
+
+	com_logBuffer = Cvar_Get( "com_logBuffer", "512", CVAR_ARCHIVE_ND | CVAR_LATCH );
+	Cvar_CheckRange( com_logBuffer, "16", "65536", CV_INTEGER );
+	Cvar_SetDescription( com_logBuffer, "Kilobytes buffered per log file before messages are dropped" );
+
+	com_logFsync = Cvar_Get( "com_logFsync", "0", CVAR_ARCHIVE_ND );
+	Cvar_CheckRange( com_logFsync, "0", NULL, CV_INTEGER );
+	Cvar_SetDescription( com_logFsync, "Flush written logs to disk at most every N milliseconds, 0 leaves it to the system" );
+
+	Cmd_AddCommand( "logstats", Com_LogStats_f );
+}
+
+
+/*
+================
+Com_ShutdownLogWriter
+
+Attached files are written out, closing them is up to their owners
+================
+*/
+void Com_ShutdownLogWriter( void ) {
+	int i;
+
+	if ( !logw.thread ) {
+		return;
+	}
+
+	LOG_STORE( &logw.quit, 1 );
+	Sys_PostSemaphore( logw.wake );
+	Sys_JoinThread( logw.thread );
+	logw.thread = NULL;
+
+	for ( i = 0; i < MAX_LOG_STREAMS; i++ ) {
+		if ( logw.streams[i].active ) {
+			Com_LogDrain( &logw.streams[i] );
+			Com_LogSync( &logw.streams[i], qtrue );
+		}
+		free( logw.streams[i].ring );
+	}
+
+	Sys_DestroySemaphore( logw.wake );
+	Sys_DestroyMutex( logw.lock );
+
+	Com_Memset( &logw, 0, sizeof( logw ) );
+}
@@ -450,7 +450,7 @@ void Com_MD5Init( void )
 		byte key2[MD5_BLOCK_SIZE];
 	} secret;
 
-	Sys_RandomBytes( (byte*)&secret, sizeof( secret ) );
+	Com_RandomBytes( (byte*)&secret, sizeof( secret ) );
 
 	// initialize inner context
 	MD5Init( &hmac_ctx_in );
@@ -145,9 +145,13 @@ void Netchan_TransmitNextFragment( netchan_t *chan ) {
 	NET_SendPacket( chan->sock, send.cursize, send.data, &chan->remoteAddress );
 
 	// Store send time and size of this packet for rate control
-	chan->lastSentTime = Sys_Milliseconds();
+	chan->lastSentTime = Com_EventTime();
 	chan->lastSentSize = send.cursize;
 
+	chan->stats.bytesSent += send.cursize;
+	chan->stats.packetsSent++;
+	chan->stats.fragmentsSent++;
+
 	if ( showpackets->integer ) {
 		Com_Printf ("%s send %4i : s=%i fragment=%i,%i\n"
 			, netsrcString[ chan->sock ]
@@ -217,9 +221,12 @@ void Netchan_Transmit( netchan_t *chan, int length, const byte *data ) {
 	NET_SendPacket( chan->sock, send.cursize, send.data, &chan->remoteAddress );
 
 	// Store send time and size of this packet for rate control
-	chan->lastSentTime = Sys_Milliseconds();
+	chan->lastSentTime = Com_EventTime();
 	chan->lastSentSize = send.cursize;
 
+	chan->stats.bytesSent += send.cursize;
+	chan->stats.packetsSent++;
+
 	if ( showpackets->integer ) {
 		Com_Printf( "%s send %4i : s=%i ack=%i\n"
 			, netsrcString[ chan->sock ]
@@ -247,6 +254,9 @@ qboolean Netchan_Process( netchan_t *chan, msg_t *msg ) {
 	int			fragmentStart, fragmentLength;
 	qboolean	fragmented;
 
+	chan->stats.bytesReceived += msg->cursize;
+	chan->stats.packetsReceived++;
+
 	// get sequence numbers
 	MSG_BeginReadingOOB( msg );
 	sequence = MSG_ReadLong( msg );
@@ -314,6 +324,7 @@ qboolean Netchan_Process( netchan_t *chan, msg_t *msg ) {
 	//
 	chan->dropped = sequence - (chan->incomingSequence+1);
 	if ( chan->dropped > 0 ) {
+		chan->stats.dropped += chan->dropped;
 		if ( showdrop->integer || showpackets->integer ) {
 			Com_Printf( "%s:Dropped %i packets at %i\n"
 			, NET_AdrToString( &chan->remoteAddress )
@@ -473,106 +484,29 @@ static void NET_SendLoopPacket( netsrc_t sock, int length, const void *data )
 
 //=============================================================================
 
-typedef struct packetQueue_s {
-	struct packetQueue_s *next;
-	int length;
-	byte *data;
-	netadr_t to;
-	netsrc_t sock; // only used for loopback type
-	int release;
-} packetQueue_t;
-
-static packetQueue_t *packetQueue = NULL;
-
-static void NET_QueuePacket( int length, const void *data, const netsrc_t sock, const netadr_t *to, int offset )
-{
-	packetQueue_t *newp, *next = packetQueue;
-
-	if(offset > 999)
-		offset = 999;
-
-	newp = S_Malloc(sizeof(packetQueue_t));
-	newp->data = S_Malloc(length);
-	Com_Memcpy(newp->data, data, length);
-	newp->length = length;
-	newp->sock = sock;
-	newp->to = *to;
-	newp->release = Sys_Milliseconds() + (int)((float)offset / com_timescale->value);	
-	newp->next = NULL;
-
-	if(!packetQueue) {
-		packetQueue = newp;
+/*
+===============
+NET_SendPacket
+===============
+*/
+void NET_SendPacket( netsrc_t sock, int length, const void *data, const netadr_t *to ) {
+	// dropped or delayed by the network emulator
+	if ( NET_EmuSend( sock, length, data, to ) ) {
 		return;
 	}
-	while(next) {
-		if(!next->next) {
-			next->next = newp;
-			return;
-		}
-		next = next->next;
-	}
-}
-
 
-void NET_FlushPacketQueue( void )
-{
-	packetQueue_t *last;
-	int now;
-
-	while ( packetQueue ) {
-		now = Sys_Milliseconds();
-		if ( packetQueue->release - now >= 0 )
-			break;
-
-		if ( showpackets->integer ) {
-			// todo delayed ms display doesn't work with this code
-			// because of above check stopping calls if not ready to send
-			Com_Printf( "delayed packet %4i\n", packetQueue->length );
-		}
-
-		if ( packetQueue->to.type == NA_LOOPBACK )
-			NET_SendLoopPacket( packetQueue->sock, packetQueue->length, packetQueue->data );
-		else
-			Sys_SendPacket( packetQueue->length, packetQueue->data, &packetQueue->to );
-		last = packetQueue;
-		packetQueue = packetQueue->next;
-		Z_Free( last->data );
-		Z_Free( last );
-	}
+	NET_TransmitPacket( sock, length, data, to );
 }
 
 
-void NET_SendPacket( netsrc_t sock, int length, const void *data, const netadr_t *to ) {
-#ifndef DEDICATED
-	if ( sock == NS_CLIENT && cl_packetloss->integer > 0 ) {
-		if ( ( (float)rand() / (float)RAND_MAX ) * 100 <= cl_packetloss->integer ) {
-			if ( showpackets->integer ) {
-				Com_Printf( "drop packet %4i\n", length );
-			}
-			return;
-		}
-	}
-#endif
-	if ( sock == NS_SERVER && sv_packetloss->integer > 0 ) {
-		if ( ( (float)rand() / (float)RAND_MAX ) * 100 <= sv_packetloss->integer ) {
-			if ( showpackets->integer ) {
-				Com_Printf( "drop packet %4i\n", length );
-			}
-			return;
-		}
-	}
-
-#ifndef DEDICATED
-	if ( to->type >= NA_LOOPBACK && sock == NS_CLIENT && cl_packetdelay->integer > 0 ) {
-		NET_QueuePacket( length, data, sock, to, cl_packetdelay->integer );
-		return;
-	}
-#endif
-	if ( to->type >= NA_LOOPBACK && sock == NS_SERVER && sv_packetdelay->integer > 0 ) {
-		NET_QueuePacket( length, data, sock, to, sv_packetdelay->integer );
-		return;
-	}
+/*
+===============
+NET_TransmitPacket
 
+Sends a packet right away, bypassing the network emulator
+===============
+*/
+void NET_TransmitPacket( netsrc_t sock, int length, const void *data, const netadr_t *to ) {
 	// sequenced packets are shown in netchan, so just show oob
 	if ( showpackets->integer && *(int32_t *)data == -1 ) {
 		Com_Printf ("send packet %4i\n", length);
@@ -589,6 +523,11 @@ void NET_SendPacket( netsrc_t sock, int length, const void *data, const netadr_t
 		return;
 	}
 
+	// a replayed session never reaches the wire
+	if ( Com_JournalReplaying() ) {
+		return;
+	}
+
 	Sys_SendPacket( length, data, to );
 }
 
@@ -0,0 +1,804 @@
+/*
+===========================================================================
+
+Wolfenstein: Enemy Territory GPL Source Code
+Copyright (C) 1999-2010 id Software LLC, a ZeniMax Media company.
+
+This file is part of the Wolfenstein: Enemy Territory GPL Source Code (Wolf ET Source Code).
+
+Wolf ET Source Code is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Wolf ET Source Code is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Wolf ET Source Code.  If not, see <http://www.gnu.org/licenses/>.
+
+In addition, the Wolf: ET Source Code is also subject to certain additional terms. You should have received a copy of these additional terms immediately following the terms and conditions of the GNU General Public License which accompanied the Wolf ET Source Code.  If not, please request a copy in writing from id Software at the address below.
+
+If you have questions concerning this license or the applicable additional terms, you may contact in writing id Software LLC, c/o ZeniMax Media Inc., Suite 120, Rockville, Maryland 20850 USA.
+
+===========================================================================
+*/
+
+// net_emu.c -- deterministic network impairment for netcode testing
+//
+// Outgoing and incoming packets can each be run through a link profile
+// with latency, jitter, Gilbert-Elliott burst loss, a bandwidth cap with a
+// bounded queue and reordering. Profiles are strings such as
+//
+//   set net_emuOut "delay 60 jitter 8 dist normal loss 0.5 burst 2 25 rate 2000 limit 200"
+//
+// All random decisions come from per-link generators seeded by net_emuSeed,
+// so the same traffic sees the same impairment on every run. Delayed
+// packets are copied into pooled buffers and parked on a timing wheel with
+// one millisecond slots; NET_FlushPacketQueue releases them when due.
+// cl_packetdelay, cl_packetloss, sv_packetdelay and sv_packetloss are
+// handled here as well, on top of the net_emuOut profile.
+
+#include "q_shared.h"
+#include "qcommon.h"
+
+#define EMU_WHEEL_SLOTS		1024				// must be a power of two
+#define EMU_WHEEL_MASK		( EMU_WHEEL_SLOTS - 1 )
+
+#define EMU_SMALL_PACKET	( MAX_PACKETLEN + 128 )
+#define EMU_SMALL_CHUNK		64
+#define EMU_LARGE_CHUNK		4
+#define EMU_MAX_SMALL		8192
+#define EMU_MAX_LARGE		64
+
+#define EMU_UDP_OVERHEAD	28					// IPv4 + UDP headers, for the rate limit
+#define EMU_MAX_DELAY		10000
+
+typedef enum {
+	EMU_OUT,
+	EMU_IN,
+	EMU_NUM_LINKS
+} emuDirection_t;
+
+typedef enum {
+	EMU_DIST_UNIFORM,
+	EMU_DIST_NORMAL,
+	EMU_DIST_PARETO
+} emuDist_t;
+
+typedef struct {
+	int			delay;			// msec
+	int			jitter;			// msec, half range, deviation or scale depending on dist
+	emuDist_t	dist;
+	float		loss;			// percent, in the good state
+	float		burstEnter;		// percent per packet, good -> bad
+	float		burstLeave;		// percent per packet, bad -> good
+	float		burstLoss;		// percent, in the bad state
+	int			rate;			// kbit/s, 0 is unlimited
+	int			limit;			// msec of queued data before tail drop
+	float		reorder;		// percent of packets that skip the delay
+} emuProfile_t;
+
+typedef struct {
+	int			packets;
+	int			delivered;
+	int			lost;
+	int			overflow;		// tail drops from the rate limit queue or the pool
+	int			reordered;
+	int64_t		delaySum;		// msec, of the delivered packets
+	int			maxQueued;
+} emuStats_t;
+
+typedef struct {
+	const char	*name;
+	qboolean	active;
+	emuProfile_t profile;
+	uint64_t	rng;
+	qboolean	bad;			// Gilbert-Elliott state
+	double		linkFree;		// msec when the rate limited link is idle again
+	int			queued;
+	emuStats_t	stats;
+} emuLink_t;
+
+typedef struct emuPacket_s {
+	struct emuPacket_s *next;
+	int			release;
+	int			sent;
+	int			length;
+	int			readcount;		// incoming only, NET_GetPacket may skip a SOCKS header
+	qboolean	large;
+	emuDirection_t dir;
+	netsrc_t	sock;
+	netadr_t	adr;
+	byte		*data;
+} emuPacket_t;
+
+typedef struct {
+	emuPacket_t	*head;
+	emuPacket_t	*tail;
+} emuSlot_t;
+
+typedef struct {
+	qboolean	initialized;
+	emuLink_t	links[ EMU_NUM_LINKS ];
+	emuSlot_t	wheel[ EMU_WHEEL_SLOTS ];
+	int			wheelTime;		// last msec the wheel was advanced to
+	int			queued;
+
+	emuPacket_t	*freeSmall;
+	emuPacket_t	*freeLarge;
+	int			numSmall;
+	int			numLarge;
+} netEmu_t;
+
+static netEmu_t emu;
+
+static cvar_t *net_emuOut;
+static cvar_t *net_emuIn;
+static cvar_t *net_emuSeed;
+
+
+/*
+================
+NET_EmuRandom
+
+xorshift64*, returns [0,1)
+================
+*/
+static double NET_EmuRandom( emuLink_t *link ) {
+	uint64_t x;
+
+	x = link->rng;
+	x ^= x >> 12;
+	x ^= x << 25;
+	x ^= x >> 27;
+	link->rng = x;
+
+	return ( ( x * 0x2545F4914F6CDD1DULL ) >> 11 ) * ( 1.0 / 9007199254740992.0 );
+}
+
+
+/*
+================
+NET_EmuChance
+================
+*/
+static qboolean NET_EmuChance( emuLink_t *link, float percent ) {
+	if ( percent <= 0.0f ) {
+		return qfalse;
+	}
+
+	return NET_EmuRandom( link ) * 100.0 < percent ? qtrue : qfalse;
+}
+
+
+/*
+================
+NET_EmuJitter
+================
+*/
+static double NET_EmuJitter( emuLink_t *link ) {
+	const emuProfile_t *p = &link->profile;
+	double u, v;
+
+	if ( p->jitter <= 0 ) {
+		return 0.0;
+	}
+
+	switch ( p->dist ) {
+	case EMU_DIST_NORMAL:
+		// Box-Muller
+		u = 1.0 - NET_EmuRandom( link );
+		v = NET_EmuRandom( link );
+		return p->jitter * sqrt( -2.0 * log( u ) ) * cos( 2.0 * M_PI * v );
+	case EMU_DIST_PARETO:
+		// one sided heavy tail, shape 3 so the mean stays finite
+		u = 1.0 - NET_EmuRandom( link );
+		return p->jitter * ( pow( u, -1.0 / 3.0 ) - 1.0 );
+	default:
+		return p->jitter * ( 2.0 * NET_EmuRandom( link ) - 1.0 );
+	}
+}
+
+
+/*
+================
+NET_EmuSeedLinks
+================
+*/
+static void NET_EmuSeedLinks( void ) {
+	uint64_t seed;
+	int i;
+
+	for ( i = 0; i < EMU_NUM_LINKS; i++ ) {
+		// splitmix64 of the seed and the direction, never zero
+		seed = (uint64_t)(unsigned int)net_emuSeed->integer + ( i + 1 ) * 0x9E3779B97F4A7C15ULL;
+		seed = ( seed ^ ( seed >> 30 ) ) * 0xBF58476D1CE4E5B9ULL;
+		seed = ( seed ^ ( seed >> 27 ) ) * 0x94D049BB133111EBULL;
+		seed ^= seed >> 31;
+		emu.links[i].rng = seed ? seed : 1;
+		emu.links[i].bad = qfalse;
+	}
+}
+
+
+/*
+================
+NET_EmuParseProfile
+================
+*/
+static qboolean NET_EmuParseProfile( const char *s, emuProfile_t *p, const char *cvarName ) {
+	const char *token;
+
+	Com_Memset( p, 0, sizeof( *p ) );
+	p->burstLoss = 100.0f;
+	p->limit = 1000;
+
+	while ( 1 ) {
+		token = COM_ParseExt( &s, qfalse );
+		if ( !token[0] ) {
+			break;
+		}
+
+		if ( !Q_stricmp( token, "delay" ) ) {
+			p->delay = atoi( COM_ParseExt( &s, qfalse ) );
+		} else if ( !Q_stricmp( token, "jitter" ) ) {
+			p->jitter = atoi( COM_ParseExt( &s, qfalse ) );
+		} else if ( !Q_stricmp( token, "dist" ) ) {
+			token = COM_ParseExt( &s, qfalse );
+			if ( !Q_stricmp( token, "uniform" ) ) {
+				p->dist = EMU_DIST_UNIFORM;
+			} else if ( !Q_stricmp( token, "normal" ) ) {
+				p->dist = EMU_DIST_NORMAL;
+			} else if ( !Q_stricmp( token, "pareto" ) ) {
+				p->dist = EMU_DIST_PARETO;
+			} else {
+				Com_Printf( S_COLOR_YELLOW "%s: unknown distribution '%s'\n", cvarName, token );
+				return qfalse;
+			}
+		} else if ( !Q_stricmp( token, "loss" ) ) {
+			p->loss = atof( COM_ParseExt( &s, qfalse ) );
+		} else if ( !Q_stricmp( token, "burst" ) ) {
+			p->burstEnter = atof( COM_ParseExt( &s, qfalse ) );
+			p->burstLeave = atof( COM_ParseExt( &s, qfalse ) );
+		} else if ( !Q_stricmp( token, "burstloss" ) ) {
+			p->burstLoss = atof( COM_ParseExt( &s, qfalse ) );
+		} else if ( !Q_stricmp( token, "rate" ) ) {
+			p->rate = atoi( COM_ParseExt( &s, qfalse ) );
+		} else if ( !Q_stricmp( token, "limit" ) ) {
+			p->limit = atoi( COM_ParseExt( &s, qfalse ) );
+		} else if ( !Q_stricmp( token, "reorder" ) ) {
+			p->reorder = atof( COM_ParseExt( &s, qfalse ) );
+		} else {
+			Com_Printf( S_COLOR_YELLOW "%s: unknown keyword '%s'\n", cvarName, token );
+			return qfalse;
+		}
+	}
+
+	p->delay = MAX( 0, MIN( p->delay, EMU_MAX_DELAY ) );
+	p->jitter = MAX( 0, MIN( p->jitter, EMU_MAX_DELAY ) );
+	p->rate = MAX( 0, p->rate );
+	p->limit = MAX( 1, p->limit );
+	if ( p->burstEnter > 0.0f && p->burstLeave <= 0.0f ) {
+		Com_Printf( S_COLOR_YELLOW "%s: burst needs both the enter and the leave percentage\n", cvarName );
+		return qfalse;
+	}
+
+	return qtrue;
+}
+
+
+/*
+================
+NET_EmuUpdate
+
+Picks up profile and seed changes
+================
+*/
+static void NET_EmuUpdate( void ) {
+	cvar_t	*cvars[ EMU_NUM_LINKS ];
+	emuLink_t *link;
+	int		i;
+
+	cvars[ EMU_OUT ] = net_emuOut;
+	cvars[ EMU_IN ] = net_emuIn;
+
+	for ( i = 0; i < EMU_NUM_LINKS; i++ ) {
+		link = &emu.links[i];
+		if ( !NET_EmuParseProfile( cvars[i]->string, &link->profile, cvars[i]->name ) ) {
+			Com_Memset( &link->profile, 0, sizeof( link->profile ) );
+			link->active = qfalse;
+		} else {
+			link->active = cvars[i]->string[0] ? qtrue : qfalse;
+		}
+		link->linkFree = 0.0;
+		cvars[i]->modified = qfalse;
+	}
+
+	NET_EmuSeedLinks();
+	net_emuSeed->modified = qfalse;
+}
+
+
+/*
+================
+NET_EmuAllocPacket
+================
+*/
+static emuPacket_t *NET_EmuAllocPacket( int length ) {
+	emuPacket_t	*p, **freeList;
+	qboolean	large;
+	byte		*chunk;
+	int			count, size, i;
+
+	large = ( length > EMU_SMALL_PACKET ) ? qtrue : qfalse;
+	freeList = large ? &emu.freeLarge : &emu.freeSmall;
+
+	if ( !*freeList ) {
+		if ( large ) {
+			if ( emu.numLarge >= EMU_MAX_LARGE ) {
+				return NULL;
+			}
+			count = EMU_LARGE_CHUNK;
+			size = PAD( MAX_MSGLEN_BUF, sizeof( void * ) );
+		} else {
+			if ( emu.numSmall >= EMU_MAX_SMALL ) {
+				return NULL;
+			}
+			count = EMU_SMALL_CHUNK;
+			size = PAD( EMU_SMALL_PACKET, sizeof( void * ) );
+		}
+
+		// pooled buffers are never given back
+		chunk = malloc( count * ( sizeof( emuPacket_t ) + size ) );
+		if ( !chunk ) {
+			return NULL;
+		}
+		for ( i = 0; i < count; i++ ) {
+			p = (emuPacket_t *)( chunk + i * ( sizeof( emuPacket_t ) + size ) );
+			p->data = (byte *)( p + 1 );
+			p->large = large;
+			p->next = *freeList;
+			*freeList = p;
+		}
+
+		if ( large ) {
+			emu.numLarge += count;
+		} else {
+			emu.numSmall += count;
+		}
+	}
+
+	p = *freeList;
+	*freeList = p->next;
+
+	return p;
+}
+
+
+/*
+================
+NET_EmuFreePacket
+================
+*/
+static void NET_EmuFreePacket( emuPacket_t *p ) {
+	emuPacket_t **freeList;
+
+	freeList = p->large ? &emu.freeLarge : &emu.freeSmall;
+	p->next = *freeList;
+	*freeList = p;
+}
+
+
+/*
+================
+NET_EmuSchedule
+
+Parks a packet on the timing wheel
+================
+*/
+static void NET_EmuSchedule( emuPacket_t *p ) {
+	emuSlot_t *slot;
+	emuLink_t *link;
+
+	// anything already due goes to the next slot the wheel looks at
+	if ( p->release - emu.wheelTime <= 0 ) {
+		slot = &emu.wheel[ ( emu.wheelTime + 1 ) & EMU_WHEEL_MASK ];
+	} else {
+		slot = &emu.wheel[ p->release & EMU_WHEEL_MASK ];
+	}
+
+	p->next = NULL;
+	if ( slot->tail ) {
+		slot->tail->next = p;
+	} else {
+		slot->head = p;
+	}
+	slot->tail = p;
+
+	link = &emu.links[ p->dir ];
+	link->queued++;
+	if ( link->queued > link->stats.maxQueued ) {
+		link->stats.maxQueued = link->queued;
+	}
+	emu.queued++;
+}
+
+
+/*
+================
+NET_EmuImpair
+
+Runs a packet through a link. Returns the delay in msec, or -1 if the
+packet is lost.
+================
+*/
+static int NET_EmuImpair( emuLink_t *link, int length, int extraDelay, int now ) {
+	const emuProfile_t *p = &link->profile;
+	double	start, delay;
+	float	loss;
+
+	link->stats.packets++;
+
+	if ( link->active ) {
+		// Gilbert-Elliott, the state moves once per packet
+		if ( p->burstEnter > 0.0f ) {
+			if ( link->bad ) {
+				if ( NET_EmuChance( link, p->burstLeave ) ) {
+					link->bad = qfalse;
+				}
+			} else if ( NET_EmuChance( link, p->burstEnter ) ) {
+				link->bad = qtrue;
+			}
+		}
+
+		loss = link->bad ? p->burstLoss : p->loss;
+		if ( NET_EmuChance( link, loss ) ) {
+			link->stats.lost++;
+			return -1;
+		}
+	}
+
+	delay = extraDelay;
+	start = now;
+
+	if ( link->active ) {
+		if ( p->rate > 0 ) {
+			// kbit/s is bits per msec
+			if ( link->linkFree > start ) {
+				start = link->linkFree;
+			}
+			if ( start - now > p->limit ) {
+				link->stats.overflow++;
+				return -1;
+			}
+			link->linkFree = start + ( length + EMU_UDP_OVERHEAD ) * 8.0 / p->rate;
+			delay += link->linkFree - now;
+		}
+
+		if ( NET_EmuChance( link, p->reorder ) ) {
+			link->stats.reordered++;
+		} else {
+			delay += p->delay + NET_EmuJitter( link );
+		}
+	}
+
+	if ( com_timescale->value > 0.0001f ) {
+		delay /= com_timescale->value;
+	}
+
+	return (int)MAX( 0.0, MIN( delay, (double)EMU_MAX_DELAY ) );
+}
+
+
+/*
+================
+NET_EmuQueue
+================
+*/
+static qboolean NET_EmuQueue( emuDirection_t dir, netsrc_t sock, const netadr_t *adr, const byte *data, int length, int readcount, int delay, int now ) {
+	emuPacket_t *p;
+
+	p = NET_EmuAllocPacket( length );
+	if ( !p ) {
+		emu.links[ dir ].stats.overflow++;
+		return qfalse;
+	}
+
+	Com_Memcpy( p->data, data, length );
+	p->length = length;
+	p->readcount = readcount;
+	p->dir = dir;
+	p->sock = sock;
+	p->adr = *adr;
+	p->sent = now;
+	p->release = now + delay;
+
+	NET_EmuSchedule( p );
+
+	return qtrue;
+}
+
+
+/*
+================
+NET_EmuSend
+
+Returns qtrue if the packet was dropped or delayed
+================
+*/
+qboolean NET_EmuSend( netsrc_t sock, int length, const void *data, const netadr_t *to ) {
+	emuLink_t	*link;
+	int			loss, extraDelay, delay, now;
+
+	if ( !emu.initialized ) {
+		return qfalse;
+	}
+
+	if ( net_emuOut->modified || net_emuIn->modified || net_emuSeed->modified ) {
+		NET_EmuUpdate();
+	}
+
+	loss = 0;
+	extraDelay = 0;
+#ifndef DEDICATED
+	if ( sock == NS_CLIENT ) {
+		loss = cl_packetloss->integer;
+		extraDelay = cl_packetdelay->integer;
+	}
+#endif
+	if ( sock == NS_SERVER ) {
+		loss = sv_packetloss->integer;
+		extraDelay = sv_packetdelay->integer;
+	}
+
+	link = &emu.links[ EMU_OUT ];
+	if ( !link->active && loss <= 0 && extraDelay <= 0 ) {
+		return qfalse;
+	}
+
+	if ( to->type < NA_LOOPBACK ) {
+		return qfalse;
+	}
+
+	if ( NET_EmuChance( link, loss ) ) {
+		if ( showpackets->integer ) {
+			Com_Printf( "drop packet %4i\n", length );
+		}
+		link->stats.packets++;
+		link->stats.lost++;
+		return qtrue;
+	}
+
+	now = Sys_Milliseconds();
+	delay = NET_EmuImpair( link, length, MIN( MAX( extraDelay, 0 ), 999 ), now );
+	if ( delay < 0 ) {
+		if ( showpackets->integer ) {
+			Com_Printf( "drop packet %4i\n", length );
+		}
+		return qtrue;
+	}
+
+	NET_EmuQueue( EMU_OUT, sock, to, data, length, 0, delay, now );
+
+	return qtrue;
+}
+
+
+/*
+================
+NET_EmuReceive
+
+Returns qtrue if the packet was dropped or delayed
+================
+*/
+qboolean NET_EmuReceive( const netadr_t *from, const msg_t *msg ) {
+	emuLink_t	*link;
+	int			delay, now;
+
+	if ( !emu.initialized ) {
+		return qfalse;
+	}
+
+	if ( net_emuOut->modified || net_emuIn->modified || net_emuSeed->modified ) {
+		NET_EmuUpdate();
+	}
+
+	link = &emu.links[ EMU_IN ];
+	if ( !link->active ) {
+		return qfalse;
+	}
+
+	now = Sys_Milliseconds();
+	delay = NET_EmuImpair( link, msg->cursize, 0, now );
+	if ( delay >= 0 ) {
+		NET_EmuQueue( EMU_IN, NS_SERVER, from, msg->data, msg->cursize, msg->readcount, delay, now );
+	}
+
+	return qtrue;
+}
+
+
+/*
+================
+NET_EmuDeliver
+================
+*/
+static void NET_EmuDeliver( emuPacket_t *p, int now ) {
+	emuLink_t	*link;
+	byte		bufData[ MAX_MSGLEN_BUF ];
+	msg_t		msg;
+	netadr_t	from;
+
+	link = &emu.links[ p->dir ];
+	link->queued--;
+	link->stats.delivered++;
+	link->stats.delaySum += now - p->sent;
+	emu.queued--;
+
+	if ( p->dir == EMU_IN ) {
+		MSG_Init( &msg, bufData, MAX_MSGLEN );
+		Com_Memcpy( msg.data, p->data, p->length );
+		msg.cursize = p->length;
+		msg.readcount = p->readcount;
+		from = p->adr;
+		NET_EmuFreePacket( p );
+		NET_DispatchPacket( &from, &msg );
+		return;
+	}
+
+	if ( showpackets->integer ) {
+		Com_Printf( "delayed packet %4i\n", p->length );
+	}
+
+	NET_TransmitPacket( p->sock, p->length, p->data, &p->adr );
+	NET_EmuFreePacket( p );
+}
+
+
+/*
+================
+NET_FlushPacketQueue
+
+Releases every packet that is due. Returns the msec until the next one
+is, for the frame sleep.
+================
+*/
+int NET_FlushPacketQueue( void ) {
+	emuSlot_t	*slot;
+	emuPacket_t	*p, *next;
+	int			now, steps, t, i, d;
+
+	now = Sys_Milliseconds();
+
+	if ( !emu.queued ) {
+		emu.wheelTime = now;
+		return INT_MAX;
+	}
+
+	steps = now - emu.wheelTime;
+	if ( steps > EMU_WHEEL_SLOTS ) {
+		steps = EMU_WHEEL_SLOTS;
+	}
+
+	for ( i = 1; i <= steps; i++ ) {
+		t = emu.wheelTime + i;
+		slot = &emu.wheel[ t & EMU_WHEEL_MASK ];
+
+		// detach the slot, delivery may schedule new packets
+		p = slot->head;
+		slot->head = slot->tail = NULL;
+
+		for ( ; p; p = next ) {
+			next = p->next;
+			if ( p->release - now <= 0 ) {
+				NET_EmuDeliver( p, now );
+			} else {
+				// a later turn of the wheel
+				p->next = NULL;
+				if ( slot->tail ) {
+					slot->tail->next = p;
+				} else {
+					slot->head = p;
+				}
+				slot->tail = p;
+			}
+		}
+	}
+
+	if ( steps > 0 ) {
+		emu.wheelTime = now;
+	}
+
+	if ( !emu.queued ) {
+		return INT_MAX;
+	}
+
+	// find the next tick with a packet due
+	for ( d = 1; d <= EMU_WHEEL_SLOTS; d++ ) {
+		for ( p = emu.wheel[ ( now + d ) & EMU_WHEEL_MASK ].head; p; p = p->next ) {
+			if ( p->release - now <= d ) {
+				return d;
+			}
+		}
+	}
+
+	return EMU_WHEEL_SLOTS;
+}
+
+
+/*
+================
+NET_EmuPrintLink
+================
+*/
+static void NET_EmuPrintLink( const emuLink_t *link, const cvar_t *cv ) {
+	const emuStats_t *s = &link->stats;
+
+	Com_Printf( "%s: %s\n", link->name, link->active ? cv->string : "off" );
+	Com_Printf( "  %i packets, %i delivered, %i lost, %i overflowed, %i reordered\n",
+		s->packets, s->delivered, s->lost, s->overflow, s->reordered );
+	Com_Printf( "  %i queued (max %i), avg delay %.1f msec%s\n", link->queued, s->maxQueued,
+		s->delivered ? (double)s->delaySum / s->delivered : 0.0, link->bad ? ", in a loss burst" : "" );
+}
+
+
+/*
+================
+NET_Emu_f
+================
+*/
+static void NET_Emu_f( void ) {
+	int i;
+
+	if ( net_emuOut->modified || net_emuIn->modified || net_emuSeed->modified ) {
+		NET_EmuUpdate();
+	}
+
+	if ( Cmd_Argc() > 1 && !Q_stricmp( Cmd_Argv( 1 ), "reset" ) ) {
+		for ( i = 0; i < EMU_NUM_LINKS; i++ ) {
+			Com_Memset( &emu.links[i].stats, 0, sizeof( emu.links[i].stats ) );
+			emu.links[i].linkFree = 0.0;
+		}
+		NET_EmuSeedLinks();
+		Com_Printf( "Network emulator statistics cleared, links reseeded.\n" );
+		return;
+	}
+
+	NET_EmuPrintLink( &emu.links[ EMU_OUT ], net_emuOut );
+	NET_EmuPrintLink( &emu.links[ EMU_IN ], net_emuIn );
+	Com_Printf( "seed %i, pool %i small + %i large buffers\n", net_emuSeed->integer, emu.numSmall, emu.numLarge );
+}
+
+
+/*
+================
+NET_EmuInit
+================
+*/
+void NET_EmuInit( void ) {
+	if ( emu.initialized ) {
+		return;
+	}
+
+	net_emuOut = Cvar_Get( "net_emuOut", "", CVAR_CHEAT );
+	Cvar_SetDescription( net_emuOut, "Impairment of outgoing packets, any of: delay <msec> jitter <msec> dist uniform|normal|pareto loss <%> burst <enter%> <leave%> burstloss <%> rate <kbit/s> limit <msec> reorder <%>" );
+
+	net_emuIn = Cvar_Get( "net_emuIn", "", CVAR_CHEAT );
+	Cvar_SetDescription( net_emuIn, "Impairment of incoming packets, same syntax as net_emuOut" );
+
+	net_emuSeed = Cvar_Get( "net_emuSeed", "1", 0 );
+	Cvar_CheckRange( net_emuSeed, NULL, NULL, CV_INTEGER );
+	Cvar_SetDescription( net_emuSeed, "Random seed of the network emulator, the same seed and traffic give the same impairment" );
+
+	emu.links[ EMU_OUT ].name = "out";
+	emu.links[ EMU_IN ].name = "in";
+	emu.wheelTime = Sys_Milliseconds();
+	emu.initialized = qtrue;
+
+	NET_EmuUpdate();
+
+	Cmd_AddCommand( "net_emu", NET_Emu_f );
+}
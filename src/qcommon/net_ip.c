@@ -84,6 +84,7 @@ static qboolean	winsockInitialized = qfalse;
 #	include <sys/ioctl.h>
 #	include <sys/types.h>
 #	include <sys/time.h>
+#	include <poll.h>
 #	include <unistd.h>
 #	if !defined(__sun) && !defined(__sgi)
 #		include <ifaddrs.h>
@@ -1792,6 +1793,8 @@ void NET_Init( void ) {
 #endif
 
 	NET_Config( qtrue );
+
+	NET_EmuInit();
 	
 	Cmd_AddCommand( "net_restart", NET_Restart_f );
 }
@@ -1842,14 +1845,11 @@ static void NET_Event( const fd_set *fdr )
 					continue; // drop this packet
 			}
 
-#ifdef DEDICATED
-			Com_RunAndTimeServerPacket( &from, &netmsg );
-#else
-			if ( com_sv_running->integer || com_dedicated->integer )
-				Com_RunAndTimeServerPacket( &from, &netmsg );
-			else
-				CL_PacketEvent( &from, &netmsg );
-#endif
+			// dropped or delayed by the network emulator
+			if ( NET_EmuReceive( &from, &netmsg ) )
+				continue;
+
+			NET_DispatchPacket( &from, &netmsg );
 		}
 		else
 			break;
@@ -1857,6 +1857,28 @@ static void NET_Event( const fd_set *fdr )
 }
 
 
+/*
+====================
+NET_DispatchPacket
+
+Hands a received packet to the server or the client
+====================
+*/
+void NET_DispatchPacket( const netadr_t *from, msg_t *msg )
+{
+	Com_JournalPacket( from, msg );
+
+#ifdef DEDICATED
+	Com_RunAndTimeServerPacket( from, msg );
+#else
+	if ( com_sv_running->integer || com_dedicated->integer )
+		Com_RunAndTimeServerPacket( from, msg );
+	else
+		CL_PacketEvent( from, msg );
+#endif
+}
+
+
 /*
 ====================
 NET_Sleep
@@ -1941,3 +1963,214 @@ static void NET_Restart_f( void )
 {
 	NET_Config( qtrue );
 }
+
+
+//=============================================================================
+
+// blocking TCP streams for worker threads, nothing here touches the
+// state above so the calls are reentrant
+
+#ifdef MSG_NOSIGNAL
+#define TCP_SEND_FLAGS	MSG_NOSIGNAL
+#else
+#define TCP_SEND_FLAGS	0
+#endif
+
+/*
+====================
+NET_TCPWait
+
+Waits until s is readable, or writable if write is set,
+qfalse on timeout or error
+====================
+*/
+static qboolean NET_TCPWait( SOCKET s, qboolean write, int timeoutMsec ) {
+#ifdef _WIN32
+	// winsock fd_sets hold socket handles, not a bitmask indexed by them
+	struct timeval	tv;
+	fd_set			fds;
+
+	FD_ZERO( &fds );
+	FD_SET( s, &fds );
+
+	tv.tv_sec = timeoutMsec / 1000;
+	tv.tv_usec = ( timeoutMsec % 1000 ) * 1000;
+
+	return select( s + 1, write ? NULL : &fds, write ? &fds : NULL, NULL, &tv ) > 0 ? qtrue : qfalse;
+#else
+	// workers may get descriptors past FD_SETSIZE, which select can't take
+	struct pollfd	pfd;
+
+	pfd.fd = s;
+	pfd.events = write ? POLLOUT : POLLIN;
+	pfd.revents = 0;
+
+	return poll( &pfd, 1, timeoutMsec ) > 0 ? qtrue : qfalse;
+#endif
+}
+
+
+/*
+====================
+NET_TCPListen
+
+Opens an IPv4 listener on address:port, an empty address listens on
+every interface. Main thread only, the returned socket can be handed
+to a worker.
+====================
+*/
+tcpSocket_t NET_TCPListen( const char *address, int port ) {
+	struct sockaddr_in	sadr;
+	SOCKET				s;
+	int					i = 1;
+
+#ifdef _WIN32
+	if ( !winsockInitialized ) {
+		return INVALID_TCP_SOCKET;
+	}
+#endif
+
+	Com_Memset( &sadr, 0, sizeof( sadr ) );
+
+	if ( !address || !address[0] ) {
+		sadr.sin_family = AF_INET;
+		sadr.sin_addr.s_addr = INADDR_ANY;
+	} else if ( !Sys_StringToSockaddr( address, (sockaddr_t *)&sadr, sizeof( sadr ), AF_INET, SOCK_STREAM ) ) {
+		return INVALID_TCP_SOCKET;
+	}
+
+	sadr.sin_port = htons( (unsigned short)port );
+
+	if ( ( s = socket( PF_INET, SOCK_STREAM, IPPROTO_TCP ) ) == INVALID_SOCKET ) {
+		Com_Printf( "WARNING: %s: socket: %s\n", __func__, NET_ErrorString() );
+		return INVALID_TCP_SOCKET;
+	}
+
+	// don't keep the port blocked by connections in TIME_WAIT after a restart
+	setsockopt( s, SOL_SOCKET, SO_REUSEADDR, (char *)&i, sizeof( i ) );
+
+	if ( bind( s, (void *)&sadr, sizeof( sadr ) ) == SOCKET_ERROR ) {
+		Com_Printf( "WARNING: %s: bind %s:%i: %s\n", __func__, address, port, NET_ErrorString() );
+		closesocket( s );
+		return INVALID_TCP_SOCKET;
+	}
+
+	if ( listen( s, 8 ) == SOCKET_ERROR ) {
+		Com_Printf( "WARNING: %s: listen: %s\n", __func__, NET_ErrorString() );
+		closesocket( s );
+		return INVALID_TCP_SOCKET;
+	}
+
+	return (tcpSocket_t)s;
+}
+
+
+/*
+====================
+NET_TCPAccept
+
+Returns INVALID_TCP_SOCKET if nobody connected within timeoutMsec
+====================
+*/
+tcpSocket_t NET_TCPAccept( tcpSocket_t listener, int timeoutMsec ) {
+	SOCKET	s;
+
+	ioctlarg_t	_true = 1;
+
+	if ( !NET_TCPWait( (SOCKET)listener, qfalse, timeoutMsec ) ) {
+		return INVALID_TCP_SOCKET;
+	}
+
+	s = accept( (SOCKET)listener, NULL, NULL );
+	if ( s == INVALID_SOCKET ) {
+		return INVALID_TCP_SOCKET;
+	}
+
+	// reads and writes wait in NET_TCPWait, so a peer that stops reading can't block send
+	if ( ioctlsocket( s, FIONBIO, &_true ) == SOCKET_ERROR ) {
+		closesocket( s );
+		return INVALID_TCP_SOCKET;
+	}
+
+#ifdef SO_NOSIGPIPE
+	{
+		int i = 1;
+		setsockopt( s, SOL_SOCKET, SO_NOSIGPIPE, (char *)&i, sizeof( i ) );
+	}
+#endif
+
+	return (tcpSocket_t)s;
+}
+
+
+/*
+====================
+NET_TCPRecv
+
+Returns the number of bytes read, 0 on timeout or a closed connection
+and -1 on errors
+====================
+*/
+int NET_TCPRecv( tcpSocket_t s, void *buf, int len, int timeoutMsec ) {
+	int	ret;
+
+	if ( !NET_TCPWait( (SOCKET)s, qfalse, timeoutMsec ) ) {
+		return 0;
+	}
+
+	ret = recv( (SOCKET)s, buf, len, 0 );
+	if ( ret == SOCKET_ERROR ) {
+		return socketError == EAGAIN ? 0 : -1;
+	}
+
+	return ret;
+}
+
+
+/*
+====================
+NET_TCPSend
+
+Sends what fits within timeoutMsec, returns the number of bytes sent,
+0 on timeout and -1 on errors or a closed connection
+====================
+*/
+int NET_TCPSend( tcpSocket_t s, const void *data, int len, int timeoutMsec ) {
+	const char	*p = (const char *)data;
+	int			start, remaining, ret;
+
+	start = Sys_Milliseconds();
+	remaining = timeoutMsec;
+
+	while ( len > 0 && NET_TCPWait( (SOCKET)s, qtrue, remaining ) ) {
+		ret = send( (SOCKET)s, p, len, TCP_SEND_FLAGS );
+		if ( ret == SOCKET_ERROR ) {
+			if ( socketError != EAGAIN ) {
+				return -1;
+			}
+		} else if ( ret == 0 ) {
+			return -1;
+		} else {
+			p += ret;
+			len -= ret;
+		}
+		remaining = timeoutMsec - ( Sys_Milliseconds() - start );
+		if ( remaining <= 0 ) {
+			break;
+		}
+	}
+
+	return (int)( p - (const char *)data );
+}
+
+
+/*
+====================
+NET_TCPClose
+====================
+*/
+void NET_TCPClose( tcpSocket_t s ) {
+	if ( s != INVALID_TCP_SOCKET ) {
+		closesocket( (SOCKET)s );
+	}
+}
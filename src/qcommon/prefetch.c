@@ -0,0 +1,239 @@
+/*
+===========================================================================
+
+Wolfenstein: Enemy Territory GPL Source Code
+Copyright (C) 1999-2010 id Software LLC, a ZeniMax Media company.
+
+This file is part of the Wolfenstein: Enemy Territory GPL Source Code (Wolf ET Source Code).
+
+Wolf ET Source Code is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Wolf ET Source Code is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Wolf ET Source Code.  If not, see <http://www.gnu.org/licenses/>.
+
+In addition, the Wolf: ET Source Code is also subject to certain additional terms. You should have received a copy of these additional terms immediately following the terms and conditions of the GNU General Public License which accompanied the Wolf ET Source Code.  If not, please request a copy in writing from id Software at the address below.
+
+If you have questions concerning this license or the applicable additional terms, you may contact in writing id Software LLC, c/o ZeniMax Media Inc., Suite 120, Rockville, Maryland 20850 USA.
+
+===========================================================================
+*/
+
+// prefetch.c -- reads the next map's files during intermission, so the
+// actual map change mostly finds them in memory
+
+#include "q_shared.h"
+#include "qcommon.h"
+
+// read order, the world map first
+#define PREFETCH_BSP		3
+#define PREFETCH_SCRIPTS	2
+#define PREFETCH_MEDIA		1
+
+static cvar_t	*com_prefetch;
+static char		com_prefetchMap[ MAX_QPATH ];
+
+
+/*
+================
+Com_PrefetchMedia
+
+Textures, models and sounds are only loaded by a client
+================
+*/
+static qboolean Com_PrefetchMedia( void ) {
+#ifdef DEDICATED
+	return qfalse;
+#else
+	return !com_dedicated->integer;
+#endif
+}
+
+
+/*
+================
+Com_PrefetchEntities
+
+Models and sounds named by map entities
+================
+*/
+static void Com_PrefetchEntities( const char *entities ) {
+	char		key[ MAX_TOKEN_CHARS ];
+	const char	*token;
+	const char	*ext;
+
+	while ( 1 ) {
+		token = COM_ParseExt( &entities, qtrue );
+		if ( !token[0] ) {
+			break;
+		}
+		if ( token[0] == '{' || token[0] == '}' ) {
+			continue;
+		}
+
+		Q_strncpyz( key, token, sizeof( key ) );
+		token = COM_ParseExt( &entities, qfalse );
+		if ( !token[0] ) {
+			break;
+		}
+
+		if ( !Q_stricmp( key, "model" ) || !Q_stricmp( key, "model2" ) ) {
+			// brush models live in the bsp
+			if ( token[0] != '*' ) {
+				FS_PrefetchFile( token, PREFETCH_MEDIA, NULL );
+			}
+		} else if ( !Q_stricmp( key, "noise" ) || !Q_stricmp( key, "music" ) ) {
+			ext = COM_GetExtension( token );
+			if ( *ext ) {
+				FS_PrefetchFile( token, PREFETCH_MEDIA, NULL );
+			} else {
+				FS_PrefetchFile( va( "%s.wav", token ), PREFETCH_MEDIA, NULL );
+			}
+		}
+	}
+}
+
+
+/*
+================
+Com_PrefetchBSPDone
+
+Queues what the world map refers to once it is in memory
+================
+*/
+static void Com_PrefetchBSPDone( const char *qpath, const void *buffer, int length ) {
+	const dheader_t	*header;
+	const dshader_t	*shaders;
+	const lump_t	*lump;
+	char			*entities;
+	int				i, count;
+
+	if ( !Com_PrefetchMedia() || length < (int)sizeof( *header ) ) {
+		return;
+	}
+
+	header = (const dheader_t *)buffer;
+	if ( LittleLong( header->ident ) != BSP_IDENT || LittleLong( header->version ) != BSP_VERSION ) {
+		return;
+	}
+
+	// shaders without a script are a single image of the same name
+	lump = &header->lumps[ LUMP_SHADERS ];
+	if ( LittleLong( lump->fileofs ) >= 0 && LittleLong( lump->filelen ) >= 0 &&
+		LittleLong( lump->fileofs ) + LittleLong( lump->filelen ) <= length ) {
+		shaders = (const dshader_t *)( (const byte *)buffer + LittleLong( lump->fileofs ) );
+		count = LittleLong( lump->filelen ) / sizeof( *shaders );
+		for ( i = 0; i < count; i++ ) {
+			if ( !memchr( shaders[i].shader, '\0', sizeof( shaders[i].shader ) ) ) {
+				continue;
+			}
+			FS_PrefetchFile( va( "%s.tga", shaders[i].shader ), PREFETCH_MEDIA, NULL );
+			FS_PrefetchFile( va( "%s.jpg", shaders[i].shader ), PREFETCH_MEDIA, NULL );
+		}
+	}
+
+	lump = &header->lumps[ LUMP_ENTITIES ];
+	if ( LittleLong( lump->fileofs ) >= 0 && LittleLong( lump->filelen ) > 0 &&
+		LittleLong( lump->fileofs ) + LittleLong( lump->filelen ) <= length ) {
+		entities = Z_Malloc( LittleLong( lump->filelen ) + 1 );
+		Com_Memcpy( entities, (const byte *)buffer + LittleLong( lump->fileofs ), LittleLong( lump->filelen ) );
+		entities[ LittleLong( lump->filelen ) ] = '\0';
+		Com_PrefetchEntities( entities );
+		Z_Free( entities );
+	}
+}
+
+
+/*
+================
+Com_PrefetchMap
+
+Starts reading the files of mapname in the background
+================
+*/
+void Com_PrefetchMap( const char *mapname ) {
+	if ( !com_prefetch || !com_prefetch->integer || !mapname || !mapname[0] ) {
+		return;
+	}
+
+	if ( !Q_stricmp( com_prefetchMap, mapname ) ) {
+		return;
+	}
+
+	// nothing read for another map is going to be used
+	FS_FlushPrefetch();
+
+	Q_strncpyz( com_prefetchMap, mapname, sizeof( com_prefetchMap ) );
+
+	if ( !FS_PrefetchFile( va( "maps/%s.bsp", mapname ), PREFETCH_BSP, Com_PrefetchBSPDone ) ) {
+		Com_DPrintf( "Couldn't prefetch map %s\n", mapname );
+		com_prefetchMap[0] = '\0';
+		return;
+	}
+
+	Com_DPrintf( "Prefetching map %s\n", mapname );
+
+	FS_PrefetchFile( va( "maps/%s.script", mapname ), PREFETCH_SCRIPTS, NULL );
+	FS_PrefetchFile( va( "scripts/%s.arena", mapname ), PREFETCH_SCRIPTS, NULL );
+	FS_PrefetchFile( va( "maps/%s_tracemap.tga", mapname ), PREFETCH_SCRIPTS, NULL );
+
+	if ( Com_PrefetchMedia() ) {
+		FS_PrefetchFile( va( "levelshots/%s.tga", mapname ), PREFETCH_SCRIPTS, NULL );
+		FS_PrefetchFile( va( "levelshots/%s.jpg", mapname ), PREFETCH_SCRIPTS, NULL );
+		FS_PrefetchFile( va( "levelshots/%s_cc.tga", mapname ), PREFETCH_SCRIPTS, NULL );
+	}
+}
+
+
+/*
+================
+Com_PrefetchFinished
+
+Called once a map is loaded, whatever was not used is dropped
+================
+*/
+void Com_PrefetchFinished( void ) {
+	if ( !com_prefetchMap[0] ) {
+		return;
+	}
+
+	FS_FlushPrefetch();
+	com_prefetchMap[0] = '\0';
+}
+
+
+/*
+================
+Com_PrefetchMap_f
+================
+*/
+void Com_PrefetchMap_f( void ) {
+	if ( Cmd_Argc() != 2 ) {
+		Com_Printf( "Usage: prefetchmap <mapname>\n" );
+		if ( com_prefetchMap[0] ) {
+			Com_Printf( "Prefetching %s\n", com_prefetchMap );
+		}
+		return;
+	}
+
+	Com_PrefetchMap( Cmd_Argv( 1 ) );
+}
+
+
+/*
+================
+Com_InitPrefetch
+================
+*/
+void Com_InitPrefetch( void ) {
+	com_prefetch = Cvar_Get( "com_prefetch", "1", CVAR_ARCHIVE_ND );
+	Cvar_CheckRange( com_prefetch, "0", "1", CV_INTEGER );
+	Cvar_SetDescription( com_prefetch, "Read the next map's files in the background during intermission" );
+}
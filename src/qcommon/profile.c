@@ -0,0 +1,378 @@
+/*
+===========================================================================
+
+Wolfenstein: Enemy Territory GPL Source Code
+Copyright (C) 1999-2010 id Software LLC, a ZeniMax Media company.
+
+This file is part of the Wolfenstein: Enemy Territory GPL Source Code (Wolf ET Source Code).
+
+Wolf ET Source Code is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Wolf ET Source Code is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Wolf ET Source Code.  If not, see <http://www.gnu.org/licenses/>.
+
+In addition, the Wolf: ET Source Code is also subject to certain additional terms. You should have received a copy of these additional terms immediately following the terms and conditions of the GNU General Public License which accompanied the Wolf ET Source Code.  If not, please request a copy in writing from id Software at the address below.
+
+If you have questions concerning this license or the applicable additional terms, you may contact in writing id Software LLC, c/o ZeniMax Media Inc., Suite 120, Rockville, Maryland 20850 USA.
+
+===========================================================================
+*/
+
+// profile.c -- scoped timing markers exported as a Chrome trace
+//
+// PROFILE_BEGIN / PROFILE_END pairs record complete events into a ring
+// owned by the calling thread, so recording never takes a lock. Rings are
+// allocated on the first marker a thread hits while com_profile is set and
+// stay on a global list that profile_dump walks. With com_profile at 0 a
+// marker costs one test of the cvar.
+//
+// The owning thread is the only writer of its ring. profile_dump copies the
+// ring and then throws away whatever the owner may have overwritten while
+// it was being copied, so other threads don't have to stop.
+
+#include "q_shared.h"
+#include "qcommon.h"
+
+#if defined( _MSC_VER )
+#include <intrin.h>
+#define PROF_LOAD( p )		( (unsigned int)_InterlockedOr( (volatile long *)(p), 0 ) )
+#define PROF_STORE( p, v )	_InterlockedExchange( (volatile long *)(p), (long)(v) )
+#else
+#define PROF_LOAD( p )		__atomic_load_n( (p), __ATOMIC_ACQUIRE )
+#define PROF_STORE( p, v )	__atomic_store_n( (p), (v), __ATOMIC_RELEASE )
+#endif
+
+#define PROFILE_MAX_DEPTH	32
+
+typedef struct {
+	const char		*name;			// must be a string literal
+	int64_t			start;			// usec since Com_InitProfiler
+	int				duration;		// usec
+} profileEvent_t;
+
+typedef struct profileThread_s {
+	struct profileThread_s *next;
+	int				id;
+	qboolean		main;
+	qboolean		exited;			// can be handed to the next new thread
+
+	profileEvent_t	*events;
+	unsigned int	size;			// power of two
+	unsigned int	head;			// advanced by the owner only
+
+	// open scopes, deeper ones are counted but not recorded
+	int				depth;
+	const char		*stackName[ PROFILE_MAX_DEPTH ];
+	int64_t			stackStart[ PROFILE_MAX_DEPTH ];
+} profileThread_t;
+
+static struct {
+	sysMutex_t		*lock;			// guards the thread list
+	profileThread_t	*threads;
+	int				numThreads;
+	int64_t			base;
+	unsigned int	paused;			// set while dumping
+} prof;
+
+static Q_THREADLOCAL profileThread_t *prof_thread;
+
+cvar_t			*com_profile;
+static cvar_t	*com_profileEvents;
+
+
+/*
+================
+Com_ProfileAttach
+
+Gives the calling thread a ring, reusing one left by an exited thread
+================
+*/
+static profileThread_t *Com_ProfileAttach( void ) {
+	profileThread_t	*t;
+	unsigned int	size;
+
+	if ( !prof.lock ) {
+		return NULL;
+	}
+
+	size = log2pad( com_profileEvents->integer, 1 );
+
+	Sys_LockMutex( prof.lock );
+
+	for ( t = prof.threads; t; t = t->next ) {
+		if ( t->exited && t->size == size ) {
+			break;
+		}
+	}
+
+	if ( !t ) {
+		t = calloc( 1, sizeof( *t ) );
+		if ( t ) {
+			t->events = malloc( size * sizeof( t->events[0] ) );
+			if ( !t->events ) {
+				free( t );
+				t = NULL;
+			}
+		}
+		if ( !t ) {
+			Sys_UnlockMutex( prof.lock );
+			return NULL;
+		}
+		t->size = size;
+		t->next = prof.threads;
+		prof.threads = t;
+	}
+
+	t->id = ++prof.numThreads;
+	t->main = Com_IsMainThread();
+	t->exited = qfalse;
+	t->head = 0;
+	t->depth = 0;
+
+	Sys_UnlockMutex( prof.lock );
+
+	prof_thread = t;
+	return t;
+}
+
+
+/*
+================
+Com_ProfileBegin
+================
+*/
+void Com_ProfileBegin( const char *name ) {
+	profileThread_t *t = prof_thread;
+
+	if ( !t && ( t = Com_ProfileAttach() ) == NULL ) {
+		return;
+	}
+
+	if ( t->depth < PROFILE_MAX_DEPTH ) {
+		t->stackName[ t->depth ] = name;
+		t->stackStart[ t->depth ] = Sys_Microseconds();
+	}
+
+	t->depth++;
+}
+
+
+/*
+================
+Com_ProfileEnd
+
+Closes the innermost scope opened by Com_ProfileBegin
+================
+*/
+void Com_ProfileEnd( void ) {
+	profileThread_t *t = prof_thread;
+	profileEvent_t	*ev;
+	int64_t			now;
+
+	if ( !t || t->depth <= 0 ) {
+		return;
+	}
+
+	t->depth--;
+
+	if ( t->depth >= PROFILE_MAX_DEPTH || PROF_LOAD( &prof.paused ) ) {
+		return;
+	}
+
+	now = Sys_Microseconds();
+
+	ev = &t->events[ t->head & ( t->size - 1 ) ];
+	ev->name = t->stackName[ t->depth ];
+	ev->start = t->stackStart[ t->depth ] - prof.base;
+	ev->duration = (int)( now - t->stackStart[ t->depth ] );
+
+	PROF_STORE( &t->head, t->head + 1 );
+}
+
+
+/*
+================
+Com_ProfileFrame
+
+Drops scopes left open on the main thread by an ERR_DROP or by
+com_profile changing between a begin and its end
+================
+*/
+void Com_ProfileFrame( void ) {
+	if ( prof_thread ) {
+		prof_thread->depth = 0;
+	}
+}
+
+
+/*
+================
+Com_ProfileThreadExit
+
+Called by the Sys_CreateThread trampoline when the thread function returns,
+the recorded events are kept until another thread takes over the ring
+================
+*/
+void Com_ProfileThreadExit( void ) {
+	if ( !prof_thread ) {
+		return;
+	}
+
+	Sys_LockMutex( prof.lock );
+	prof_thread->exited = qtrue;
+	Sys_UnlockMutex( prof.lock );
+
+	prof_thread = NULL;
+}
+
+
+/*
+================
+Com_ProfileWriteThread
+
+Returns the number of events written
+================
+*/
+static int Com_ProfileWriteThread( fileHandle_t f, const profileThread_t *t, profileEvent_t *copy, qboolean first ) {
+	unsigned int	head, oldest, count, skip, i;
+	char			name[ 32 ];
+
+	head = PROF_LOAD( &t->head );
+	oldest = head > t->size ? head - t->size : 0;
+	count = head - oldest;
+
+	for ( i = 0; i < count; i++ ) {
+		copy[i] = t->events[ ( oldest + i ) & ( t->size - 1 ) ];
+	}
+
+	// slots the owner wrapped over during the copy, plus the one it may
+	// be writing right now, can be torn
+	skip = PROF_LOAD( &t->head ) + 1 - oldest;
+	skip = skip > t->size ? skip - t->size : 0;
+	if ( skip > count ) {
+		skip = count;
+	}
+
+	if ( t->main ) {
+		Q_strncpyz( name, "main", sizeof( name ) );
+	} else {
+		Com_sprintf( name, sizeof( name ), "thread %i", t->id );
+	}
+
+	FS_Printf( f, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%i,\"args\":{\"name\":\"%s\"}}",
+		first ? "" : ",\n", t->id, name );
+
+	for ( i = skip; i < count; i++ ) {
+		FS_Printf( f, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%lli,\"dur\":%i,\"pid\":1,\"tid\":%i}",
+			copy[i].name, (long long)copy[i].start, copy[i].duration, t->id );
+	}
+
+	return count - skip;
+}
+
+
+/*
+================
+Com_ProfileDump_f
+================
+*/
+static void Com_ProfileDump_f( void ) {
+	char			filename[ MAX_QPATH ];
+	const char		*ext;
+	fileHandle_t	f;
+	profileThread_t	*t;
+	profileEvent_t	*copy;
+	unsigned int	size;
+	int				events, threads;
+
+	if ( Cmd_Argc() != 2 ) {
+		Com_Printf( "Usage: profile_dump <file.json>\n" );
+		return;
+	}
+
+	Q_strncpyz( filename, Cmd_Argv( 1 ), sizeof( filename ) );
+	COM_DefaultExtension( filename, sizeof( filename ), ".json" );
+
+	if ( !FS_AllowedExtension( filename, qfalse, &ext ) ) {
+		Com_Printf( "%s: Invalid filename extension: '%s'.\n", __func__, ext );
+		return;
+	}
+
+	Sys_LockMutex( prof.lock );
+
+	size = 0;
+	for ( t = prof.threads; t; t = t->next ) {
+		size = MAX( size, t->size );
+	}
+
+	if ( !size ) {
+		Sys_UnlockMutex( prof.lock );
+		Com_Printf( "Nothing recorded, set com_profile 1 first.\n" );
+		return;
+	}
+
+	copy = malloc( size * sizeof( copy[0] ) );
+	if ( !copy ) {
+		Sys_UnlockMutex( prof.lock );
+		Com_Printf( "%s: out of memory\n", __func__ );
+		return;
+	}
+
+	f = FS_FOpenFileWrite( filename );
+	if ( f == FS_INVALID_HANDLE ) {
+		Sys_UnlockMutex( prof.lock );
+		free( copy );
+		Com_Printf( "%s: couldn't open %s\n", __func__, filename );
+		return;
+	}
+
+	PROF_STORE( &prof.paused, 1 );
+
+	FS_Printf( f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n" );
+
+	events = threads = 0;
+	for ( t = prof.threads; t; t = t->next ) {
+		events += Com_ProfileWriteThread( f, t, copy, threads == 0 );
+		threads++;
+	}
+
+	FS_Printf( f, "\n]}\n" );
+
+	PROF_STORE( &prof.paused, 0 );
+
+	Sys_UnlockMutex( prof.lock );
+
+	FS_FCloseFile( f );
+	free( copy );
+
+	Com_Printf( "Wrote %i events from %i threads to %s\n", events, threads, filename );
+}
+
+
+/*
+================
+Com_InitProfiler
+================
+*/
+void Com_InitProfiler( void ) {
+	com_profile = Cvar_Get( "com_profile", "0", CVAR_TEMP );
+	Cvar_CheckRange( com_profile, "0", "1", CV_INTEGER );
+	Cvar_SetDescription( com_profile, "Record frame, server, client, renderer and map load timing markers for profile_dump" );
+
+	com_profileEvents = Cvar_Get( "com_profileEvents", "65536", CVAR_ARCHIVE_ND | CVAR_LATCH );
+	Cvar_CheckRange( com_profileEvents, "1024", "4194304", CV_INTEGER );
+	Cvar_SetDescription( com_profileEvents, "Timing markers kept per thread for profile_dump, the oldest are overwritten" );
+
+	prof.lock = Sys_CreateMutex();
+	prof.base = Sys_Microseconds();
+
+	Cmd_AddCommand( "profile_dump", Com_ProfileDump_f );
+}
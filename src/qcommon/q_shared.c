@@ -2461,6 +2461,362 @@ qboolean Info_SetValueForKey_s( char *s, int slen, const char *key, const char *
 }
 
 
+/*
+==================
+Info_DictHash
+==================
+*/
+static int Info_DictHash( const char *key, int keyLen )
+{
+	unsigned int hash;
+	int i;
+
+	hash = 0;
+	for ( i = 0; i < keyLen; i++ )
+	{
+		hash = hash * 101 + locase[ (byte)key[i] ];
+	}
+
+	return hash & ( INFO_HASH_SIZE - 1 );
+}
+
+
+/*
+==================
+Info_DictFind
+==================
+*/
+static int Info_DictFind( const infoDict_t *dict, const char *key, int keyLen, int hash )
+{
+	const infoPair_t *pair;
+	int i;
+
+	for ( i = dict->hash[ hash ]; i >= 0; i = pair->next )
+	{
+		pair = &dict->pairs[ i ];
+		if ( pair->keyLen == keyLen && Q_strkey( dict->text + pair->key, key, keyLen ) )
+		{
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+
+/*
+==================
+Info_DictAdd
+
+Appends a key that is not in the dictionary yet,
+returns qfalse when out of space
+==================
+*/
+static qboolean Info_DictAdd( infoDict_t *dict, const char *key, int keyLen, int hash, const char *value, int valueLen )
+{
+	infoPair_t *pair;
+	char *o;
+
+	if ( dict->numPairs >= MAX_INFO_PAIRS || dict->textUsed + keyLen + valueLen + 2 > (int)sizeof( dict->text ) )
+	{
+		return qfalse;
+	}
+
+	pair = &dict->pairs[ dict->numPairs ];
+	o = dict->text + dict->textUsed;
+
+	// the value directly follows the key, Info_DictCompact relies on it
+	pair->key = dict->textUsed;
+	pair->keyLen = keyLen;
+	memcpy( o, key, keyLen );
+	o[ keyLen ] = '\0';
+
+	pair->value = dict->textUsed + keyLen + 1;
+	pair->valueLen = valueLen;
+	memcpy( o + keyLen + 1, value, valueLen );
+	o[ keyLen + 1 + valueLen ] = '\0';
+
+	pair->removed = qfalse;
+
+	pair->next = dict->hash[ hash ];
+	dict->hash[ hash ] = dict->numPairs;
+
+	dict->numPairs++;
+	dict->textUsed += keyLen + valueLen + 2;
+	dict->length += keyLen + valueLen + 2;
+
+	return qtrue;
+}
+
+
+/*
+==================
+Info_DictUnlink
+==================
+*/
+static void Info_DictUnlink( infoDict_t *dict, int index )
+{
+	infoPair_t *pair;
+	short *link;
+
+	pair = &dict->pairs[ index ];
+
+	link = &dict->hash[ Info_DictHash( dict->text + pair->key, pair->keyLen ) ];
+	while ( *link != index )
+	{
+		link = &dict->pairs[ *link ].next;
+	}
+	*link = pair->next;
+
+	pair->removed = qtrue;
+	dict->length -= pair->keyLen + pair->valueLen + 2;
+}
+
+
+/*
+==================
+Info_DictCompact
+
+Drops removed pairs and their text, pairs are stored
+in text in the same order, so this works in place
+==================
+*/
+static void Info_DictCompact( infoDict_t *dict )
+{
+	infoPair_t pair;
+	int i, n, used, size, h;
+
+	memset( dict->hash, -1, sizeof( dict->hash ) );
+
+	n = used = 0;
+	for ( i = 0; i < dict->numPairs; i++ )
+	{
+		pair = dict->pairs[ i ];
+		if ( pair.removed )
+		{
+			continue;
+		}
+
+		size = pair.keyLen + pair.valueLen + 2;
+		memmove( dict->text + used, dict->text + pair.key, size );
+		pair.key = used;
+		pair.value = used + pair.keyLen + 1;
+		used += size;
+
+		h = Info_DictHash( dict->text + pair.key, pair.keyLen );
+		pair.next = dict->hash[ h ];
+		dict->hash[ h ] = n;
+
+		dict->pairs[ n++ ] = pair;
+	}
+
+	dict->numPairs = n;
+	dict->textUsed = used;
+}
+
+
+/*
+==================
+Info_DictInit
+==================
+*/
+void Info_DictInit( infoDict_t *dict )
+{
+	dict->length = 0;
+	dict->numPairs = 0;
+	dict->textUsed = 0;
+	memset( dict->hash, -1, sizeof( dict->hash ) );
+}
+
+
+/*
+==================
+Info_DictParse
+
+Splits the info string into the dictionary in one pass. Follows
+Info_ValueForKey: the first of duplicated keys wins and a trailing
+key without a value is ignored. Returns qfalse if the string was
+too long, the dictionary then holds the leading pairs.
+==================
+*/
+qboolean Info_DictParse( infoDict_t *dict, const char *s )
+{
+	const char *key, *value;
+	int keyLen, valueLen, hash;
+
+	Info_DictInit( dict );
+
+	if ( !s )
+		return qtrue;
+
+	if ( *s == '\\' )
+		s++;
+
+	while ( 1 )
+	{
+		key = s;
+		s = strchr( s, '\\' );
+		if ( !s )
+			return qtrue;
+		keyLen = (int)(s - key);
+		s++; // skip '\\'
+
+		value = s;
+		while ( *s != '\\' && *s != '\0' )
+			s++;
+		valueLen = (int)(s - value);
+
+		if ( keyLen > 0 )
+		{
+			hash = Info_DictHash( key, keyLen );
+			if ( Info_DictFind( dict, key, keyLen, hash ) < 0 && !Info_DictAdd( dict, key, keyLen, hash, value, valueLen ) )
+				return qfalse;
+		}
+
+		if ( *s == '\0' )
+			return qtrue;
+
+		s++;
+	}
+}
+
+
+/*
+==================
+Info_DictValue
+
+Returns the value for key or an empty string, the
+pointer stays valid until the dictionary is changed
+==================
+*/
+const char *Info_DictValue( const infoDict_t *dict, const char *key )
+{
+	int keyLen, i;
+
+	if ( !key || !*key )
+		return "";
+
+	keyLen = (int)strlen( key );
+	i = Info_DictFind( dict, key, keyLen, Info_DictHash( key, keyLen ) );
+	if ( i < 0 )
+		return "";
+
+	return dict->text + dict->pairs[ i ].value;
+}
+
+
+/*
+==================
+Info_DictSet
+
+Same rules as Info_SetValueForKey, the key is moved to
+the end and an empty or NULL value removes it
+==================
+*/
+qboolean Info_DictSet( infoDict_t *dict, const char *key, const char *value )
+{
+	int keyLen, valueLen, hash, i;
+
+	if ( !key || !Info_ValidateKeyValue( key ) || *key == '\0' ) {
+		Com_Printf( S_COLOR_YELLOW "Invalid key name: '%s'\n", key );
+		return qfalse;
+	}
+
+	if ( value && !Info_ValidateKeyValue( value ) ) {
+		Com_Printf( S_COLOR_YELLOW "Invalid value name: '%s'\n", value );
+		return qfalse;
+	}
+
+	keyLen = (int)strlen( key );
+	hash = Info_DictHash( key, keyLen );
+
+	i = Info_DictFind( dict, key, keyLen, hash );
+	if ( i >= 0 ) {
+		Info_DictUnlink( dict, i );
+	}
+
+	if ( value == NULL || *value == '\0' ) {
+		return qtrue;
+	}
+
+	valueLen = (int)strlen( value );
+
+	if ( dict->length + keyLen + valueLen + 2 >= MAX_INFO_STRING ) {
+		Com_Printf( S_COLOR_YELLOW "Info string length exceeded for key '%s'\n", key );
+		return qfalse;
+	}
+
+	if ( !Info_DictAdd( dict, key, keyLen, hash, value, valueLen ) ) {
+		// the length check above guarantees the compacted text has room
+		Info_DictCompact( dict );
+		Info_DictAdd( dict, key, keyLen, hash, value, valueLen );
+	}
+
+	return qtrue;
+}
+
+
+/*
+==================
+Info_DictRemove
+==================
+*/
+qboolean Info_DictRemove( infoDict_t *dict, const char *key )
+{
+	int keyLen, i;
+
+	if ( !key || !*key )
+		return qfalse;
+
+	keyLen = (int)strlen( key );
+	i = Info_DictFind( dict, key, keyLen, Info_DictHash( key, keyLen ) );
+	if ( i < 0 )
+		return qfalse;
+
+	Info_DictUnlink( dict, i );
+	return qtrue;
+}
+
+
+/*
+==================
+Info_DictWrite
+
+Converts the dictionary back to an info string, pairs that
+don't fit into buf are left out. Returns the string length.
+==================
+*/
+int Info_DictWrite( const infoDict_t *dict, char *buf, int bufSize )
+{
+	const infoPair_t *pair;
+	int i, len;
+
+	if ( bufSize <= 0 )
+		return 0;
+
+	len = 0;
+	for ( i = 0; i < dict->numPairs; i++ )
+	{
+		pair = &dict->pairs[ i ];
+		if ( pair->removed )
+			continue;
+
+		if ( len + pair->keyLen + pair->valueLen + 2 >= bufSize )
+			break;
+
+		buf[ len++ ] = '\\';
+		memcpy( buf + len, dict->text + pair->key, pair->keyLen );
+		len += pair->keyLen;
+		buf[ len++ ] = '\\';
+		memcpy( buf + len, dict->text + pair->value, pair->valueLen );
+		len += pair->valueLen;
+	}
+
+	buf[ len ] = '\0';
+	return len;
+}
+
+
 //====================================================================
 
 /*
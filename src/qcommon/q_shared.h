@@ -157,6 +157,15 @@ If you have questions concerning this license or the applicable additional terms
 #define FORMAT_PRINTF(x, y) /* nothing */
 #endif
 
+// storage class for variables which get a separate instance in every thread
+#if defined(__GNUC__) || defined(__clang__)
+#define Q_THREADLOCAL __thread
+#elif defined(_MSC_VER)
+#define Q_THREADLOCAL __declspec(thread)
+#else
+#define Q_THREADLOCAL /* nothing */
+#endif
+
 /**********************************************************************
   VM Considerations
 
@@ -1063,6 +1072,34 @@ qboolean Info_ValidateKeyValue( const char *s );
 const char *Info_NextPair( const char *s, char *key, char *value );
 int Info_RemoveKey( char *s, const char *key );
 
+// an info string of up to MAX_INFO_STRING parsed once for repeated lookups,
+// keys and values live in text and keep the order of the wire format
+#define MAX_INFO_PAIRS		((MAX_INFO_STRING/3)+1)
+#define INFO_HASH_SIZE		64
+
+typedef struct {
+	short		key, value;			// offsets into infoDict_t.text
+	short		keyLen, valueLen;
+	short		next;				// hash chain, -1 terminated
+	short		removed;
+} infoPair_t;
+
+typedef struct {
+	int			length;				// of the wire format
+	int			numPairs;			// including removed pairs
+	int			textUsed;
+	short		hash[INFO_HASH_SIZE];
+	infoPair_t	pairs[MAX_INFO_PAIRS];
+	char		text[MAX_INFO_STRING];
+} infoDict_t;
+
+void Info_DictInit( infoDict_t *dict );
+qboolean Info_DictParse( infoDict_t *dict, const char *s );
+const char *Info_DictValue( const infoDict_t *dict, const char *key );
+qboolean Info_DictSet( infoDict_t *dict, const char *key, const char *value );
+qboolean Info_DictRemove( infoDict_t *dict, const char *key );
+int Info_DictWrite( const infoDict_t *dict, char *buf, int bufSize );
+
 // this is only here so the functions in q_shared.c and bg_*.c can link
 void	NORETURN QDECL Com_Error( errorParm_t level, const char *fmt, ... ) FORMAT_PRINTF(2, 3);
 void	QDECL Com_Printf( const char *msg, ... ) FORMAT_PRINTF(1, 2);
@@ -1195,6 +1232,8 @@ struct cvar_s {
 	cvar_t		*hashPrev;
 	int			hashIndex;
 	cvarGroup_t	group;				// to track changes
+	int			journalModules;		// VMs that registered it, see Cvar_ReadChanges
+	int			journalQueued;		// VMs it is already queued for
 };
 
 #define	MAX_CVAR_VALUE_STRING	256
@@ -208,8 +208,9 @@ typedef struct {
 
 void		NET_Init( void );
 //void		NET_Shutdown( void );
-void		NET_FlushPacketQueue(void);
 void		NET_SendPacket( netsrc_t sock, int length, const void *data, const netadr_t *to );
+void		NET_TransmitPacket( netsrc_t sock, int length, const void *data, const netadr_t *to );
+void		NET_DispatchPacket( const netadr_t *from, msg_t *msg );
 void		QDECL NET_OutOfBandPrint( netsrc_t net_socket, const netadr_t *adr, const char *format, ...) FORMAT_PRINTF(3, 4);
 void		NET_OutOfBandCompress( netsrc_t sock, const netadr_t *adr, const byte *data, int len );
 
@@ -227,6 +228,22 @@ void		NET_LeaveMulticast6( void );
 #endif
 qboolean	NET_Sleep( int timeout );
 
+// network emulator, net_emu.c
+void		NET_EmuInit( void );
+qboolean	NET_EmuSend( netsrc_t sock, int length, const void *data, const netadr_t *to );
+qboolean	NET_EmuReceive( const netadr_t *from, const msg_t *msg );
+int			NET_FlushPacketQueue( void );	// msec until the next delayed packet is due
+
+// TCP streams for worker threads, every call waits at most timeoutMsec
+typedef intptr_t tcpSocket_t;
+#define INVALID_TCP_SOCKET	( (tcpSocket_t)-1 )
+
+tcpSocket_t	NET_TCPListen( const char *address, int port );	// main thread only
+tcpSocket_t	NET_TCPAccept( tcpSocket_t listener, int timeoutMsec );
+int			NET_TCPRecv( tcpSocket_t s, void *buf, int len, int timeoutMsec );
+int			NET_TCPSend( tcpSocket_t s, const void *data, int len, int timeoutMsec );
+void		NET_TCPClose( tcpSocket_t s );
+
 #define	MAX_PACKETLEN	1400	// max size of a network packet
 
 //----(SA)	increased for larger submodel entity counts
@@ -247,6 +264,16 @@ qboolean	NET_Sleep( int timeout );
 Netchan handles packet fragmentation and out of order / duplicate suppression
 */
 
+// traffic totals since Netchan_Setup
+typedef struct {
+	int64_t		bytesSent;
+	int64_t		bytesReceived;
+	int64_t		packetsSent;
+	int64_t		packetsReceived;
+	int64_t		fragmentsSent;		// packets carrying part of a large message
+	int64_t		dropped;			// gaps in the incoming sequence
+} netchanStats_t;
+
 typedef struct {
 	netsrc_t	sock;
 
@@ -278,8 +305,12 @@ typedef struct {
 	qboolean	compat; // ioq3 extension
 	qboolean	isLANAddress;
 
+	netchanStats_t	stats;
+
 } netchan_t;
 
+extern cvar_t *showpackets;
+
 void Netchan_Init( int qport );
 void Netchan_Setup( netsrc_t sock, netchan_t *chan, const netadr_t *adr, int port, int challenge, qboolean compat );
 
@@ -583,6 +614,16 @@ void	Cmd_TokenizeStringIgnoreQuotes( const char *text_in );
 // Takes a null terminated string.  Does not need to be /n terminated.
 // breaks the string up into arg tokens.
 
+typedef struct {
+	const char	*start;
+	int			length;		// the token is not NUL terminated
+} cmdSpan_t;
+
+int		Cmd_TokenizeSpans( const char *text, cmdSpan_t *spans, int maxSpans, qboolean ignoreQuotes );
+// Same rules as Cmd_TokenizeString, but only records where the tokens are
+// in text instead of copying them, the current arguments are not touched.
+// Returns the number of tokens found, at most maxSpans.
+
 void	Cmd_ExecuteString( const char *text );
 // Parses a single line of text into arguments and tries to execute it
 // as if it was typed at the console
@@ -621,12 +662,19 @@ cvar_t *Cvar_Get( const char *var_name, const char *value, int flags );
 // that allows variables to be unarchived without needing bitflags
 // if value is "", the value will not override a previously set value.
 
-void	Cvar_Register( vmCvar_t *vmCvar, const char *varName, const char *defaultValue, int flags, int privateFlag );
+void	Cvar_Register( vmCvar_t *vmCvar, const char *varName, const char *defaultValue, int flags, int privateFlag, vmIndex_t module );
 // basically a slightly modified Cvar_Get for the interpreted modules
 
 void	Cvar_Update( vmCvar_t *vmCvar, int privateFlag );
 // updates an interpreted modules' version of a cvar
 
+int		Cvar_ReadChanges( vmIndex_t module, int *handles, int maxHandles );
+// returns the handles of the cvars registered by module that changed since
+// the last call, or -1 when the module should update all of its cvars
+
+void	Cvar_ResetChanges( vmIndex_t module );
+// forgets the change journal of an unloaded module
+
 void 	Cvar_Set( const char *var_name, const char *value );
 // will create the variable with no flags if it doesn't exist
 
@@ -871,9 +919,54 @@ int		FS_ReadFile_Filtered( const char *qpath, void **buffer, int filter_flag );
 void	FS_ForceFlush( fileHandle_t f );
 // forces flush on files we're writing to.
 
+qboolean FS_SetAsyncLog( fileHandle_t f );
+// hands further writes to the log writer thread, see logwriter.c
+
 void	FS_FreeFile( void *buffer );
 // frees the memory returned by FS_ReadFile
 
+int		FS_ReadBSP( const char *qpath, const void **buffer );
+void	FS_FreeBSP( const void *buffer );
+// read only world map image shared by the clip model and the renderer,
+// mapped directly from disk when it is stored uncompressed in a pk3.
+// There is no trailing 0 byte, the image stays cached until FS_FlushBSP
+
+void	FS_FlushBSP( void );
+// releases the shared world map image
+
+int		FS_MapFile( const char *qpath, const void **buffer );
+void	FS_UnmapFile( const void *buffer );
+// read only file image for loaders that only parse it, large uncompressed
+// pk3 entries are mapped from disk instead of being copied. There is no
+// trailing 0 byte
+
+typedef qboolean ( *fsAsyncCallback_t )( void *userdata, const char *qpath, void *buffer, int length );
+// buffer is NULL and length -1 if the read failed. Return qtrue to keep
+// the buffer and release it later with FS_FreeAsync
+
+int		FS_ReadFileAsync( const char *qpath, int priority, fsAsyncCallback_t callback, void *userdata );
+// reads a whole file on a worker thread, higher priorities go first.
+// Returns a request number, or 0 if the file doesn't exist or the queue
+// is full. The callback runs on the main thread from Com_EventLoop and
+// the buffer has a trailing 0 byte like FS_ReadFile. Pending requests
+// survive fs_restart and are dropped without callbacks on shutdown
+
+void	FS_CancelAsync( int request );
+void	FS_FreeAsync( void *buffer );
+int		FS_AsyncPending( void );
+void	FS_AsyncFrame( void );
+// delivers finished asynchronous reads, called by Com_EventLoop
+
+typedef void ( *fsPrefetchCallback_t )( const char *qpath, const void *buffer, int length );
+
+qboolean FS_PrefetchFile( const char *qpath, int priority, fsPrefetchCallback_t callback );
+// reads a file in the background and keeps it in memory, within
+// fs_prefetchBudget, until FS_ReadFile, FS_MapFile or FS_ReadBSP asks for it.
+// The optional callback sees the read only buffer once it is cached
+
+void	FS_FlushPrefetch( void );
+// drops all files read ahead of time
+
 void	FS_WriteFile( const char *qpath, const void *buffer, int size );
 // writes a complete file, creating any subdirectories needed
 
@@ -938,6 +1031,7 @@ int FS_VM_ReadFile( void *buffer, int len, fileHandle_t f, handleOwner_t owner )
 int FS_VM_WriteFile( void *buffer, int len, fileHandle_t f, handleOwner_t owner );
 int FS_VM_SeekFile( fileHandle_t f, long offset, fsOrigin_t origin, handleOwner_t owner );
 void FS_VM_CloseFile( fileHandle_t f, handleOwner_t owner );
+qboolean FS_VM_SetAsyncLog( fileHandle_t f, handleOwner_t owner );
 void FS_VM_CloseFiles( handleOwner_t owner );
 
 const char *FS_GetCurrentGameDir( void );
@@ -1106,9 +1200,18 @@ void		Com_GameRestart( int checksumFeed, qboolean clientRestart );
 int			Com_EventLoop( void );
 int			Com_Milliseconds( void );	// will be journaled properly
 
+// background reads of the next map, see prefetch.c
+void		Com_InitPrefetch( void );
+void		Com_PrefetchMap( const char *mapname );
+void		Com_PrefetchMap_f( void );
+void		Com_PrefetchFinished( void );
+
 // MD4 functions
 unsigned	Com_BlockChecksum( const void *buffer, int length );
 
+// raw deflate decoder for buffers of known size, see inflate.c
+qboolean	Com_Inflate( void *out, int outLen, const void *in, int inLen );
+
 // MD5 functions
 
 char		*Com_MD5File(const char *filename, int length, const char *prefix, int prefix_len);
@@ -1293,6 +1396,19 @@ void Hunk_FreeTempMemory( void *buf );
 int	Hunk_MemoryRemaining( void );
 void Hunk_Log( void);
 
+typedef struct {
+	int		hunkTotal;
+	int		hunkUsed;			// permanent and temp
+	int		zoneTotal;			// all segments
+	int		zoneUsed;
+	int		smallZoneTotal;
+	int		smallZoneUsed;
+	int		slabTotal;			// small allocations kept outside the zones
+	int		slabUsed;
+} memUsage_t;
+
+void Com_MemoryUsage( memUsage_t *usage );	// no zone walk, cheap enough to poll
+
 void Com_TouchMemory( void );
 
 // commandLine should not include the executable name (argv[0])
@@ -1428,6 +1544,8 @@ typedef enum {
 	SE_MOUSE,	// evValue and evValue2 are relative signed x / y moves
 	SE_JOYSTICK_AXIS,	// evValue is an axis number and evValue2 is the current state (-127 to 127)
 	SE_CONSOLE,	// evPtr is a char*
+	SE_PACKET,	// journal only: evValue is the size, evValue2 the readcount, evPtr a netadr_t and the data
+	SE_CHECKSUM,	// journal only: evValue is the server time, evValue2 the game state checksum
 	SE_MAX,
 } sysEventType_t;
 
@@ -1439,6 +1557,17 @@ typedef struct {
 	void			*evPtr;			// this must be manually freed if not NULL
 } sysEvent_t;
 
+// event journaling and session replay, see journal.c
+void		Com_InitJournaling( void );
+void		Com_ShutdownJournaling( void );
+qboolean	Com_JournalRecording( void );
+qboolean	Com_JournalReplaying( void );
+int			Com_EventTime( void );		// real time that replays the same from a journal
+void		Com_JournalWriteEvent( const sysEvent_t *ev );
+sysEvent_t	Com_JournalReadEvent( void );
+void		Com_JournalPacket( const netadr_t *from, const msg_t *msg );
+void		Com_JournalServerFrame( int serverTime, unsigned int checksum, int gameUsec, int snapshotsUsec, int serverUsec );
+
 void	Sys_Init( void );
 void	Sys_QueEvent( int evTime, sysEventType_t evType, int value, int value2, int ptrLength, void *ptr );
 void	Sys_SendKeyEvents( void );
@@ -1467,6 +1596,83 @@ uint64_t Sys_GetAffinityMask( void );
 qboolean Sys_SetAffinityMask( const uint64_t mask );
 #endif
 
+// plain worker threads, the engine itself is not thread safe so thread
+// functions may only use code that is documented as reentrant
+typedef struct sysThread_s sysThread_t;
+typedef void ( *sysThreadFunc_t )( void *arg );
+
+sysThread_t *Sys_CreateThread( sysThreadFunc_t func, void *arg );	// NULL on failure
+void	Sys_JoinThread( sysThread_t *thread );
+int		Sys_NumCPUs( void );
+
+typedef struct sysMutex_s sysMutex_t;
+typedef struct sysSemaphore_s sysSemaphore_t;
+
+sysMutex_t *Sys_CreateMutex( void );	// NULL on failure
+void	Sys_DestroyMutex( sysMutex_t *mutex );
+void	Sys_LockMutex( sysMutex_t *mutex );
+qboolean Sys_TryLockMutex( sysMutex_t *mutex );	// qfalse if another thread holds it
+void	Sys_UnlockMutex( sysMutex_t *mutex );
+
+sysSemaphore_t *Sys_CreateSemaphore( void );	// NULL on failure, starts at zero
+void	Sys_DestroySemaphore( sysSemaphore_t *sem );
+void	Sys_PostSemaphore( sysSemaphore_t *sem );
+void	Sys_WaitSemaphore( sysSemaphore_t *sem );
+
+// lock free allocation for worker threads, see arena.c
+#define ARENA_DEFAULT_BLOCK		( 64 * 1024 )
+
+typedef struct memArena_s memArena_t;
+
+typedef struct {
+	void	*block;
+	int		used;
+} arenaMark_t;
+
+memArena_t *Arena_Create( int blockSize );	// NULL on failure
+void	Arena_Destroy( memArena_t *arena );
+void	*Arena_Alloc( memArena_t *arena, int size );	// NULL on failure, NOT 0 filled
+arenaMark_t Arena_Mark( memArena_t *arena );
+void	Arena_Release( memArena_t *arena, arenaMark_t mark );
+void	Arena_Reset( memArena_t *arena );
+void	Arena_Handoff( memArena_t *arena );
+
+void	*Com_ThreadTempAlloc( int size );	// NULL on failure, NOT 0 filled
+arenaMark_t Com_ThreadTempMark( void );
+void	Com_ThreadTempRelease( arenaMark_t mark );
+void	Com_FreeThreadMemory( void );
+
+void	Com_InitThreadMemory( void );
+qboolean Com_IsMainThread( void );
+
+// background log writes, see logwriter.c
+void	Com_InitLogWriter( void );
+void	Com_ShutdownLogWriter( void );
+int		Com_LogAttach( FILE *f, qboolean sync );	// -1 if not written asynchronously
+void	Com_LogDetach( int stream );
+qboolean Com_LogWrite( int stream, const void *data, int len );
+void	Com_LogFrame( void );
+void	Com_LogFlush( void );
+
+// scoped timing markers, see profile.c
+extern	cvar_t	*com_profile;
+
+void	Com_InitProfiler( void );
+void	Com_ProfileBegin( const char *name );	// name must be a string literal
+void	Com_ProfileEnd( void );
+void	Com_ProfileFrame( void );
+void	Com_ProfileThreadExit( void );
+
+#define PROFILE_BEGIN( name )	do { if ( com_profile->integer ) Com_ProfileBegin( name ); } while ( 0 )
+#define PROFILE_END()			do { if ( com_profile->integer ) Com_ProfileEnd(); } while ( 0 )
+
+// Z_Malloc, Z_Free and the hunk must not be used by worker threads
+#ifdef _DEBUG
+#define Com_AssertMainThread( func )	assert( Com_IsMainThread() && func " called from a worker thread" )
+#else
+#define Com_AssertMainThread( func )	do { } while ( 0 )
+#endif
+
 // Sys_Milliseconds should only be used for profiling purposes,
 // any game related timing information should come from event timestamps
 int		Sys_Milliseconds( void );
@@ -1490,6 +1696,35 @@ void		Sys_ShowIP(void);
 
 qboolean	Sys_Mkdir( const char *path );
 FILE	*Sys_FOpen( const char *ospath, const char *mode );
+
+typedef struct sysMapping_s sysMapping_t;
+sysMapping_t *Sys_MapFile( FILE *f, int64_t offset, int length, const void **data );
+void	Sys_UnmapFile( sysMapping_t *mapping );
+
+typedef enum {
+	PAGES_SMALL,		// regular pages
+	PAGES_TRANSPARENT,	// the kernel was asked to back the range with huge pages
+	PAGES_HUGE			// explicitly allocated huge/large pages
+} pageKind_t;
+
+// zeroed, page aligned memory that is never released, NULL on failure
+void	*Sys_AllocPages( size_t size, qboolean huge, pageKind_t *kind, size_t *pageSize );
+int64_t	Sys_HugePageBytes( const void *base, size_t size );	// huge page backed part of a range, -1 if unknown
+
+// unbuffered writes to the descriptor behind a stdio stream, which must
+// have been flushed, usable from any thread
+typedef struct {
+	const void	*data;
+	int			length;
+} sysIoVec_t;
+
+qboolean Sys_WriteFileV( FILE *f, const sysIoVec_t *vec, int count );
+void	Sys_SyncFile( FILE *f );
+
+typedef struct sysWatch_s sysWatch_t;
+sysWatch_t *Sys_WatchTree( const char *path );
+qboolean Sys_TreeChanged( sysWatch_t *watch );
+void	Sys_UnwatchTree( sysWatch_t *watch );
 qboolean Sys_ResetReadOnlyAttribute( const char *ospath );
 qboolean Sys_IsHiddenFolder( const char *ospath );
 
@@ -1348,18 +1348,13 @@ extern unzFile unzReOpen (const char* path, unzFile file)
 }
 
 /*
-  Open a Zip file. path contain the full pathname (by example,
-     on a Windows NT computer "c:\\test\\zlib109.zip" or on an Unix computer
-	 "zlib/zlib109.zip".
-	 If the zipfile cannot be opened (file don't exist or in not valid), the
-	   return value is NULL.
-     Else, the return value is a unzFile Handle, usable with other function
-	   of this unzip package.
+  Open a Zip file into caller provided storage. Nothing is allocated, so this
+  can be used from worker threads. Close it with unzCloseInto.
+  return UNZ_OK if there is no problem
 */
-extern unzFile unzOpen (const char* path)
+extern int unzOpenInto (const char* path, unz_s *s)
 {
 	unz_s us;
-	unz_s *s;
 	uLong central_pos,uL;
 	FILE * fin ;
 
@@ -1375,7 +1370,7 @@ extern unzFile unzOpen (const char* path)
 
     fin=F_OPEN(path,"rb");
 	if (fin==NULL)
-		return NULL;
+		return UNZ_ERRNO;
 
 	central_pos = unzlocal_SearchCentralDir(fin);
 	if (central_pos==0)
@@ -1429,7 +1424,7 @@ extern unzFile unzOpen (const char* path)
 	if (err!=UNZ_OK)
 	{
 		fclose(fin);
-		return NULL;
+		return err;
 	}
 
 	us.file=fin;
@@ -1438,10 +1433,47 @@ extern unzFile unzOpen (const char* path)
 	us.central_pos = central_pos;
     us.pfile_in_zip_read = NULL;
 	
-	s=(unz_s*)ALLOC(sizeof(unz_s));
 	*s=us;
-//	unzGoToFirstFile((unzFile)s);	
-	return (unzFile)s;	
+	return UNZ_OK;
+}
+
+
+/*
+  Open a Zip file. path contain the full pathname (by example,
+     on a Windows NT computer "c:\\test\\zlib109.zip" or on an Unix computer
+	 "zlib/zlib109.zip".
+	 If the zipfile cannot be opened (file don't exist or in not valid), the
+	   return value is NULL.
+     Else, the return value is a unzFile Handle, usable with other function
+	   of this unzip package.
+*/
+extern unzFile unzOpen (const char* path)
+{
+	unz_s us;
+
+	if (unzOpenInto(path,&us)!=UNZ_OK)
+		return NULL;
+
+	return unzAdopt(&us);
+}
+
+
+/*
+  Move a ZipFile opened with unzOpenInto into an allocated handle.
+  The caller provided storage is left closed.
+*/
+extern unzFile unzAdopt (unz_s *s)
+{
+	unz_s *us;
+
+	if (s==NULL || s->file==NULL)
+		return NULL;
+
+	us=(unz_s*)ALLOC(sizeof(unz_s));
+	*us=*s;
+	s->file=NULL;
+//	unzGoToFirstFile((unzFile)us);	
+	return (unzFile)us;	
 }
 
 
@@ -1466,6 +1498,23 @@ extern int unzClose (unzFile file)
 }
 
 
+/*
+  Close a ZipFile opened with unzOpenInto.
+*/
+extern int unzCloseInto (unz_s *s)
+{
+	if (s==NULL || s->file==NULL)
+		return UNZ_PARAMERROR;
+
+	if (s->pfile_in_zip_read!=NULL)
+		return UNZ_PARAMERROR;
+
+	fclose(s->file);
+	s->file=NULL;
+	return UNZ_OK;
+}
+
+
 /*
   Write info about the ZipFile in the *pglobal_info structure.
   No preparation of the structure is needed
@@ -2023,6 +2072,35 @@ extern int unzOpenCurrentFile (unzFile file)
 }
 
 
+/*
+  Get the position of the data of the current file (opened by unzOpenCurrentFile,
+  nothing read yet) in the archive file on disk, and whether it is stored
+  without compression
+*/
+extern int unzGetCurrentFileDataPos (unzFile file, unsigned long *pos, int *stored)
+{
+	unz_s* s;
+	file_in_zip_read_info_s* pfile_in_zip_read_info;
+
+	if (file==NULL)
+		return UNZ_PARAMERROR;
+	s=(unz_s*)file;
+	pfile_in_zip_read_info=s->pfile_in_zip_read;
+
+	if (pfile_in_zip_read_info==NULL)
+		return UNZ_PARAMERROR;
+
+	/* pos_in_zipfile only points at the start of the data before the first read */
+	if (pfile_in_zip_read_info->rest_read_compressed!=s->cur_file_info.compressed_size)
+		return UNZ_PARAMERROR;
+
+	*pos = pfile_in_zip_read_info->pos_in_zipfile + s->byte_before_the_zipfile;
+	*stored = (s->cur_file_info.compression_method==0);
+
+	return UNZ_OK;
+}
+
+
 /*
   Read bytes from the current file.
   buf contain buffer where data must be copied
@@ -2155,6 +2233,135 @@ extern int unzReadCurrentFile  (unzFile file, void *buf, unsigned len)
 }
 
 
+/*
+  Read the whole current file in one go. len must be its uncompressed size
+  and nothing may have been read yet, otherwise this is unzReadCurrentFile.
+  Deflated data goes through Com_Inflate instead of the streaming decoder,
+  which is still used as a fallback if the fast decoder rejects the data.
+
+  return the number of byte copied or an error code <0
+*/
+extern int unzReadCurrentFileWhole (unzFile file, void *buf, unsigned len)
+{
+	unz_s* s;
+	file_in_zip_read_info_s* pfile_in_zip_read_info;
+	unsigned long compressed;
+	void *comp;
+	arenaMark_t mark;
+
+	if (file==NULL)
+		return UNZ_PARAMERROR;
+	s=(unz_s*)file;
+    pfile_in_zip_read_info=s->pfile_in_zip_read;
+
+	if (pfile_in_zip_read_info==NULL)
+		return UNZ_PARAMERROR;
+
+	if (pfile_in_zip_read_info->read_buffer == NULL)
+		return UNZ_END_OF_LIST_OF_FILE;
+
+	compressed = pfile_in_zip_read_info->rest_read_compressed;
+
+	if (len==0 || len!=pfile_in_zip_read_info->rest_read_uncompressed ||
+		compressed!=s->cur_file_info.compressed_size ||
+		pfile_in_zip_read_info->compression_method!=Z_DEFLATED)
+		return unzReadCurrentFile(file, buf, len);
+
+	mark = Com_ThreadTempMark();
+	comp = Com_ThreadTempAlloc(compressed);
+	if (comp==NULL)
+		return unzReadCurrentFile(file, buf, len);
+
+	if (fseek(pfile_in_zip_read_info->file,
+			  pfile_in_zip_read_info->pos_in_zipfile +
+				 pfile_in_zip_read_info->byte_before_the_zipfile,SEEK_SET)!=0 ||
+		(compressed && fread(comp,compressed,1,pfile_in_zip_read_info->file)!=1))
+	{
+		Com_ThreadTempRelease(mark);
+		return UNZ_ERRNO;
+	}
+
+	if (!Com_Inflate(buf, len, comp, compressed))
+	{
+		Com_ThreadTempRelease(mark);
+		return unzReadCurrentFile(file, buf, len);
+	}
+
+	Com_ThreadTempRelease(mark);
+
+	pfile_in_zip_read_info->pos_in_zipfile += compressed;
+	pfile_in_zip_read_info->rest_read_compressed = 0;
+	pfile_in_zip_read_info->rest_read_uncompressed = 0;
+	pfile_in_zip_read_info->stream.total_out += len;
+
+	return len;
+}
+
+
+/*
+  Read a whole file of a ZipFile opened with unzOpenInto without opening
+  it as the current file, so no zone memory is needed.
+
+  return len or an error code <0
+*/
+extern int unzReadEntryInto (unz_s *s, unsigned long pos, void *buf, unsigned len)
+{
+	uInt iSizeVar;
+	uLong offset_local_extrafield;
+	uInt  size_local_extrafield;
+	uLong compressed;
+	void *comp;
+	arenaMark_t mark;
+	int ok;
+
+	if (s==NULL || s->file==NULL)
+		return UNZ_PARAMERROR;
+
+	unzSetCurrentFileInfoPosition((unzFile)s, pos);
+	if (!s->current_file_ok)
+		return UNZ_BADZIPFILE;
+
+	if (len!=s->cur_file_info.uncompressed_size)
+		return UNZ_PARAMERROR;
+
+	if (unzlocal_CheckCurrentFileCoherencyHeader(s,&iSizeVar,
+				&offset_local_extrafield,&size_local_extrafield)!=UNZ_OK)
+		return UNZ_BADZIPFILE;
+
+	if (fseek(s->file,s->cur_file_info_internal.offset_curfile + SIZEZIPLOCALHEADER +
+			  iSizeVar + s->byte_before_the_zipfile,SEEK_SET)!=0)
+		return UNZ_ERRNO;
+
+	if (len==0)
+		return 0;
+
+	if (s->cur_file_info.compression_method==0)
+	{
+		if (fread(buf,len,1,s->file)!=1)
+			return UNZ_ERRNO;
+		return len;
+	}
+
+	compressed = s->cur_file_info.compressed_size;
+	/* scratch from the calling thread's temp stack, this runs on pk3 readers */
+	mark = Com_ThreadTempMark();
+	comp = Com_ThreadTempAlloc(compressed);
+	if (comp==NULL)
+		return UNZ_INTERNALERROR;
+
+	if (compressed && fread(comp,compressed,1,s->file)!=1)
+	{
+		Com_ThreadTempRelease(mark);
+		return UNZ_ERRNO;
+	}
+
+	ok = Com_Inflate(buf, len, comp, compressed);
+	Com_ThreadTempRelease(mark);
+
+	return ok ? (int)len : Z_DATA_ERROR;
+}
+
+
 /*
   Give the current position in uncompressed data
 */
@@ -208,6 +208,19 @@ extern int unzClose (unzFile file);
     these files MUST be closed with unzipCloseCurrentFile before call unzipClose.
   return UNZ_OK if there is no problem. */
 
+extern int unzOpenInto (const char *path, unz_s *s);
+extern int unzCloseInto (unz_s *s);
+extern unzFile unzAdopt (unz_s *s);
+
+/*
+  Same as unzOpen and unzClose on caller provided storage. Nothing is
+  allocated, so these can be used from worker threads. The unz_s can be
+  passed to every function taking an unzFile except unzOpenCurrentFile,
+  which allocates.
+  unzAdopt moves a still open unz_s into a regular unzFile handle, it
+  must be called from the main thread.
+*/
+
 extern int unzGetGlobalInfo (unzFile file, unz_global_info *pglobal_info);
 
 /*
@@ -317,6 +330,32 @@ extern int unzReadCurrentFile (unzFile file, void* buf, unsigned len);
     (UNZ_ERRNO for IO error, or zLib error for uncompress error)
 */
 
+extern int unzReadCurrentFileWhole (unzFile file, void* buf, unsigned len);
+
+/*
+  Read the whole current file (opened by unzOpenCurrentFile, nothing read yet),
+  len must be its uncompressed size. Deflated files are decoded in one pass
+  by Com_Inflate, anything else goes through unzReadCurrentFile
+*/
+
+extern int unzReadEntryInto (unz_s *s, unsigned long pos, void *buf, unsigned len);
+
+/*
+  Read a whole file of a ZipFile opened with unzOpenInto, pos is the position
+  of its central directory entry (see unzGetCurrentFileInfoPosition) and len
+  its uncompressed size. Nothing is allocated from the zone, so this can be
+  used from worker threads. Data rejected by Com_Inflate is not retried with
+  the streaming decoder.
+  return len or an error code <0
+*/
+
+extern int unzGetCurrentFileDataPos (unzFile file, unsigned long *pos, int *stored);
+
+/*
+  Give the position of the data of the current file (opened by unzOpenCurrentFile,
+  nothing read yet) in the archive file, and whether it is stored uncompressed
+*/
+
 extern long unztell(unzFile file);
 
 /*
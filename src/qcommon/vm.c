@@ -255,6 +255,9 @@ void VM_Free( vm_t *vm ) {
 	if ( vm->dllHandle )
 		Sys_UnloadLibrary( vm->dllHandle );
 
+	if ( vm->name )
+		Cvar_ResetChanges( vm->index );
+
 	Com_Memset( vm, 0, sizeof( *vm ) );
 }
 
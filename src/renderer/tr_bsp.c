@@ -40,7 +40,7 @@ void RE_LoadWorldMap( const char *name );
 */
 
 static	world_t		s_worldData;
-static	byte		*fileBase;
+static	const byte	*fileBase;
 
 static int	c_gridVerts;
 
@@ -156,7 +156,7 @@ R_ProcessLightmap
 	returns maxIntensity
 ===============
 */
-float R_ProcessLightmap( byte **pic, int in_padding, int width, int height, byte **pic_out ) {
+float R_ProcessLightmap( const byte *pic, int in_padding, int width, int height, byte *pic_out ) {
 	int j;
 	float maxIntensity = 0;
 	//double sumIntensity = 0;
@@ -164,9 +164,9 @@ float R_ProcessLightmap( byte **pic, int in_padding, int width, int height, byte
 	if ( r_lightmap->integer > 1 ) { // color code by intensity as development tool	(FIXME: check range)
 		for ( j = 0; j < width * height; j++ )
 		{
-			float r = ( *pic )[j * in_padding + 0];
-			float g = ( *pic )[j * in_padding + 1];
-			float b = ( *pic )[j * in_padding + 2];
+			float r = pic[j * in_padding + 0];
+			float g = pic[j * in_padding + 1];
+			float b = pic[j * in_padding + 2];
 			float intensity;
 			float out[3] = {0.0f};
 
@@ -186,22 +186,22 @@ float R_ProcessLightmap( byte **pic, int in_padding, int width, int height, byte
 
 			if ( r_lightmap->integer == 3 ) {
 				// Arnout: artists wanted the colours to be inversed
-				( *pic_out )[j * 4 + 0] = out[2] * 255;
-				( *pic_out )[j * 4 + 1] = out[1] * 255;
-				( *pic_out )[j * 4 + 2] = out[0] * 255;
+				pic_out[j * 4 + 0] = out[2] * 255;
+				pic_out[j * 4 + 1] = out[1] * 255;
+				pic_out[j * 4 + 2] = out[0] * 255;
 			} else {
-				( *pic_out )[j * 4 + 0] = out[0] * 255;
-				( *pic_out )[j * 4 + 1] = out[1] * 255;
-				( *pic_out )[j * 4 + 2] = out[2] * 255;
+				pic_out[j * 4 + 0] = out[0] * 255;
+				pic_out[j * 4 + 1] = out[1] * 255;
+				pic_out[j * 4 + 2] = out[2] * 255;
 			}
-			( *pic_out )[j * 4 + 3] = 255;
+			pic_out[j * 4 + 3] = 255;
 
 			//sumIntensity += intensity;
 		}
 	} else {
 		for ( j = 0 ; j < width * height; j++ ) {
-			byte *dst = &( *pic_out )[j * 4];
-			R_ColorShiftLightingBytes( &( *pic )[j * in_padding], dst, qfalse );
+			byte *dst = &pic_out[j * 4];
+			R_ColorShiftLightingBytes( &pic[j * in_padding], dst, qfalse );
 			dst[3] = 255;
 		}
 	}
@@ -223,7 +223,7 @@ R_LoadMergedLightmaps
 */
 static void R_LoadMergedLightmaps( const lump_t *l )
 {
- 	byte		*buf, *buf_p;
+ 	const byte	*buf, *buf_p;
  	int			len;
 	int			offs;
 	byte		*image, *image_p;
@@ -350,7 +350,8 @@ R_LoadLightmaps
 ===============
 */
 static void R_LoadLightmaps( const lump_t *l ) {
-	byte        *buf, *buf_p, *image_p;
+	const byte  *buf, *buf_p;
+	byte        *image_p;
 	int len;
 	byte image[LIGHTMAP_SIZE * LIGHTMAP_SIZE * 4];
 	int i /*, j*/;
@@ -397,7 +398,7 @@ static void R_LoadLightmaps( const lump_t *l ) {
 		buf_p = buf + i * LIGHTMAP_SIZE * LIGHTMAP_SIZE * 3;
 		image_p = image;
 
-		intensity = R_ProcessLightmap( &buf_p, 3, LIGHTMAP_SIZE, LIGHTMAP_SIZE, &image_p );
+		intensity = R_ProcessLightmap( buf_p, 3, LIGHTMAP_SIZE, LIGHTMAP_SIZE, image_p );
 		if ( intensity > maxIntensity ) {
 			maxIntensity = intensity;
 		}
@@ -432,7 +433,7 @@ R_LoadVisibility
 */
 static void R_LoadVisibility( const lump_t *l ) {
 	int		len;
-	byte	*buf;
+	const byte	*buf;
 
 	len = PAD( s_worldData.numClusters, 64 );
 	s_worldData.novis = ri.Hunk_Alloc( len, h_low );
@@ -644,7 +645,7 @@ static void ParseMesh( const dsurface_t *ds, const drawVert_t *verts, msurface_t
 ParseTriSurf
 ===============
 */
-static void ParseTriSurf( const dsurface_t *ds, const drawVert_t *verts, msurface_t *surf, int *indexes ) {
+static void ParseTriSurf( const dsurface_t *ds, const drawVert_t *verts, msurface_t *surf, const int *indexes ) {
 	srfTriangles_t	*tri;
 	int				i, j;
 	int				numVerts, numIndexes;
@@ -730,7 +731,7 @@ ParseFoliage() - ydnar
 parses a foliage drawsurface
 */
 
-static void ParseFoliage( const dsurface_t *ds, const drawVert_t *verts, msurface_t *surf, int *indexes ) {
+static void ParseFoliage( const dsurface_t *ds, const drawVert_t *verts, msurface_t *surf, const int *indexes ) {
 	srfFoliage_t    *foliage;
 	int i, j, numVerts, numIndexes, numInstances, size;
 //	vec4_t          *xyz, *normal /*, *origin*/;
@@ -854,7 +855,7 @@ static void ParseFoliage( const dsurface_t *ds, const drawVert_t *verts, msurfac
 ParseFlare
 ===============
 */
-static void ParseFlare( const dsurface_t *ds, const drawVert_t *verts, msurface_t *surf, int *indexes ) {
+static void ParseFlare( const dsurface_t *ds, const drawVert_t *verts, msurface_t *surf, const int *indexes ) {
 	srfFlare_t		*flare;
 	int				i;
 
@@ -1592,7 +1593,7 @@ static void R_LoadSurfaces( const lump_t *surfs, const lump_t *verts, const lump
 	const dsurface_t  *in;
 	msurface_t  *out;
 	const drawVert_t  *dv;
-	int         *indexes;
+	const int   *indexes;
 	int count;
 	int numFaces, numMeshes, numTriSurfs, numFlares, numFoliage;
 	int i;
@@ -1603,16 +1604,16 @@ static void R_LoadSurfaces( const lump_t *surfs, const lump_t *verts, const lump
 	numFlares = 0;
 	numFoliage = 0;
 
-	in = (void *)(fileBase + surfs->fileofs);
+	in = (const void *)(fileBase + surfs->fileofs);
 	if (surfs->filelen % sizeof(*in))
 		ri.Error( ERR_DROP, "%s(): funny lump size in %s", __func__, s_worldData.name );
 	count = surfs->filelen / sizeof(*in);
 
-	dv = (void *)(fileBase + verts->fileofs);
+	dv = (const void *)(fileBase + verts->fileofs);
 	if (verts->filelen % sizeof(*dv))
 		ri.Error( ERR_DROP, "%s(): funny lump size in %s", __func__, s_worldData.name );
 
-	indexes = (void *)(fileBase + indexLump->fileofs);
+	indexes = (const void *)(fileBase + indexLump->fileofs);
 	if ( indexLump->filelen % sizeof(*indexes))
 		ri.Error( ERR_DROP, "%s(): funny lump size in %s", __func__, s_worldData.name );
 
@@ -1680,7 +1681,7 @@ static void R_LoadSubmodels( const lump_t *l ) {
 	bmodel_t	*out;
 	int			i, j, count;
 
-	in = (void *)(fileBase + l->fileofs);
+	in = (const void *)(fileBase + l->fileofs);
 	if (l->filelen % sizeof(*in))
 		ri.Error( ERR_DROP, "%s(): funny lump size in %s", __func__, s_worldData.name );
 	count = l->filelen / sizeof(*in);
@@ -1786,11 +1787,11 @@ R_LoadNodesAndLeafs
 static void R_LoadNodesAndLeafs( const lump_t *nodeLump, const lump_t *leafLump ) {
 	int			i, j, p;
 	const dnode_t		*in;
-	dleaf_t		*inLeaf;
+	const dleaf_t	*inLeaf;
 	mnode_t 	*out;
 	int			numNodes, numLeafs;
 
-	in = (void *)(fileBase + nodeLump->fileofs);
+	in = (const void *)(fileBase + nodeLump->fileofs);
 	if (nodeLump->filelen % sizeof(dnode_t) ||
 		leafLump->filelen % sizeof(dleaf_t) ) {
 		ri.Error( ERR_DROP, "%s(): funny lump size in %s", __func__, s_worldData.name );
@@ -1838,7 +1839,7 @@ static void R_LoadNodesAndLeafs( const lump_t *nodeLump, const lump_t *leafLump
 	}
 
 	// load leafs
-	inLeaf = ( void * )( fileBase + leafLump->fileofs );
+	inLeaf = ( const void * )( fileBase + leafLump->fileofs );
 	for ( i = 0 ; i < numLeafs ; i++, inLeaf++, out++ )
 	{
 		for ( j = 0 ; j < 3 ; j++ )
@@ -1910,9 +1911,10 @@ R_LoadShaders
 */
 static void R_LoadShaders( const lump_t *l ) {
 	int		i, count;
-	dshader_t	*in, *out;
+	const dshader_t	*in;
+	dshader_t	*out;
 	
-	in = (void *)(fileBase + l->fileofs);
+	in = (const void *)(fileBase + l->fileofs);
 	if (l->filelen % sizeof(*in))
 		ri.Error( ERR_DROP, "%s(): funny lump size in %s", __func__, s_worldData.name );
 	count = l->filelen / sizeof(*in);
@@ -1940,10 +1942,10 @@ R_LoadMarksurfaces
 static void R_LoadMarksurfaces( const lump_t *l )
 {	
 	int		i, j, count;
-	int		*in;
+	const int	*in;
 	msurface_t **out;
 	
-	in = (void *)(fileBase + l->fileofs);
+	in = (const void *)(fileBase + l->fileofs);
 	if (l->filelen % sizeof(*in))
 		ri.Error( ERR_DROP, "%s(): funny lump size in %s", __func__, s_worldData.name );
 	count = l->filelen / sizeof(*in);
@@ -1972,7 +1974,7 @@ static void R_LoadPlanes( const lump_t *l ) {
 	int count;
 	int bits;
 
-	in = (void *)(fileBase + l->fileofs);
+	in = (const void *)(fileBase + l->fileofs);
 	if (l->filelen % sizeof(*in))
 		ri.Error( ERR_DROP, "%s(): funny lump size in %s", __func__, s_worldData.name );
 	count = l->filelen / sizeof(*in);
@@ -2014,7 +2016,7 @@ static void R_LoadFogs( const lump_t *l, const lump_t *brushesLump, const lump_t
 	shader_t    *shader;
 	int firstSide = 0;
 
-	fogs = (void *)(fileBase + l->fileofs);
+	fogs = (const void *)(fileBase + l->fileofs);
 	if (l->filelen % sizeof(*fogs)) {
 		ri.Error( ERR_DROP, "%s(): funny lump size in %s", __func__, s_worldData.name );
 	}
@@ -2032,13 +2034,13 @@ static void R_LoadFogs( const lump_t *l, const lump_t *brushesLump, const lump_t
 		return;
 	}
 
-	brushes = (void *)(fileBase + brushesLump->fileofs);
+	brushes = (const void *)(fileBase + brushesLump->fileofs);
 	if (brushesLump->filelen % sizeof(*brushes)) {
 		ri.Error( ERR_DROP, "%s(): funny lump size in %s", __func__, s_worldData.name );
 	}
 	brushesCount = brushesLump->filelen / sizeof(*brushes);
 
-	sides = (void *)(fileBase + sidesLump->fileofs);
+	sides = (const void *)(fileBase + sidesLump->fileofs);
 	if (sidesLump->filelen % sizeof(*sides)) {
 		ri.Error( ERR_DROP, "%s(): funny lump size in %s", __func__, s_worldData.name );
 	}
@@ -2177,7 +2179,7 @@ static void R_LoadLightGrid( const lump_t *l ) {
 	}
 
 	w->lightGridData = ri.Hunk_Alloc( l->filelen, h_low );
-	memcpy( w->lightGridData, ( void * )( fileBase + l->fileofs ), l->filelen );
+	memcpy( w->lightGridData, ( const void * )( fileBase + l->fileofs ), l->filelen );
 
 	// deal with overbright bits
 	for ( i = 0 ; i < numGridPoints ; i++ ) {
@@ -2204,11 +2206,12 @@ static void R_LoadEntities( const lump_t *l ) {
 	w->lightGridSize[1] = 64;
 	w->lightGridSize[2] = 128;
 
-	p = (const char *)(fileBase + l->fileofs);
-
-	// store for reference by the cgame
+	// store for reference by the cgame, the lump doesn't have to be
+	// terminated in the file image
 	w->entityString = ri.Hunk_Alloc( l->filelen + 1, h_low );
-	strcpy( w->entityString, p );
+	Com_Memcpy( w->entityString, fileBase + l->fileofs, l->filelen );
+	w->entityString[l->filelen] = '\0';
+	p = w->entityString;
 	w->entityParsePoint = w->entityString;
 
 	token = COM_ParseExt( &p, qtrue );
@@ -2288,11 +2291,8 @@ Called directly from cgame
 void RE_LoadWorldMap( const char *name ) {
 	int			i;
 	int32_t		size;
-	dheader_t	*header;
-	union {
-		byte *b;
-		void *v;
-	} buffer;
+	dheader_t	header;
+	const void	*buffer;
 	byte		*startMarker;
 
 	skyboxportal = 0;
@@ -2301,6 +2301,8 @@ void RE_LoadWorldMap( const char *name ) {
 		ri.Error( ERR_DROP, "ERROR: attempted to redundantly load world map" );
 	}
 
+	R_PROFILE_BEGIN( "RE_LoadWorldMap" );
+
 	// set default sun direction to be used if it isn't
 	// overridden by a shader
 	tr.sunDirection[0] = 0.45f;
@@ -2328,8 +2330,9 @@ void RE_LoadWorldMap( const char *name ) {
 	tr.worldRawName[0] = '\0';
 
 	// load it
-	size = ri.FS_ReadFile( name, &buffer.v );
-	if ( !buffer.b ) {
+	// shared with the clip model, read only
+	size = ri.FS_ReadBSP( name, &buffer );
+	if ( !buffer ) {
 		ri.Error( ERR_DROP, "%s: couldn't load %s", __func__, name );
 	}
 	if ( size < sizeof( dheader_t ) ) {
@@ -2355,21 +2358,21 @@ void RE_LoadWorldMap( const char *name ) {
 	startMarker = ri.Hunk_Alloc(0, h_low);
 	c_gridVerts = 0;
 
-	header = (dheader_t *)buffer.b;
-	fileBase = (byte *)header;
+	header = *(const dheader_t *)buffer;
+	fileBase = (const byte *)buffer;
 
 	// swap all the lumps
 	for ( i = 0; i < sizeof( dheader_t ) / sizeof(int32_t); i++ ) {
-		( (int32_t *)header )[i] = LittleLong( ( (int32_t *)header )[i] );
+		( (int32_t *)&header )[i] = LittleLong( ( (int32_t *)&header )[i] );
 	}
 
-	if ( header->version != BSP_VERSION ) {
-		ri.Error( ERR_DROP, "%s: %s has wrong version number (%i should be %i)", __func__, name, header->version, BSP_VERSION );
+	if ( header.version != BSP_VERSION ) {
+		ri.Error( ERR_DROP, "%s: %s has wrong version number (%i should be %i)", __func__, name, header.version, BSP_VERSION );
 	}
 
 	for ( i = 0; i < HEADER_LUMPS; i++ ) {
-		int32_t ofs = header->lumps[i].fileofs;
-		int32_t len = header->lumps[i].filelen;
+		int32_t ofs = header.lumps[i].fileofs;
+		int32_t len = header.lumps[i].filelen;
 		if ( (uint32_t)ofs > MAX_QINT || (uint32_t)len > MAX_QINT || ofs + len > size || ofs + len < 0 ) {
 			ri.Error( ERR_DROP, "%s: %s has wrong lump[%i] size/offset", __func__, name, i );
 		}
@@ -2377,32 +2380,32 @@ void RE_LoadWorldMap( const char *name ) {
 
 	// load into heap
 	ri.SCR_UpdateScreen();
-	R_LoadShaders( &header->lumps[LUMP_SHADERS] );
+	R_LoadShaders( &header.lumps[LUMP_SHADERS] );
 	ri.SCR_UpdateScreen();
-	R_LoadLightmaps( &header->lumps[LUMP_LIGHTMAPS] );
+	R_LoadLightmaps( &header.lumps[LUMP_LIGHTMAPS] );
 	ri.SCR_UpdateScreen();
-	R_LoadPlanes( &header->lumps[LUMP_PLANES] );
+	R_LoadPlanes( &header.lumps[LUMP_PLANES] );
 	ri.SCR_UpdateScreen();
-	//%	R_LoadFogs( &header->lumps[LUMP_FOGS], &header->lumps[LUMP_BRUSHES], &header->lumps[LUMP_BRUSHSIDES] );
+	//%	R_LoadFogs( &header.lumps[LUMP_FOGS], &header.lumps[LUMP_BRUSHES], &header.lumps[LUMP_BRUSHSIDES] );
 	//%	ri.SCR_UpdateScreen();
-	R_LoadSurfaces( &header->lumps[LUMP_SURFACES], &header->lumps[LUMP_DRAWVERTS], &header->lumps[LUMP_DRAWINDEXES] );
+	R_LoadSurfaces( &header.lumps[LUMP_SURFACES], &header.lumps[LUMP_DRAWVERTS], &header.lumps[LUMP_DRAWINDEXES] );
 	ri.SCR_UpdateScreen();
-	R_LoadMarksurfaces( &header->lumps[LUMP_LEAFSURFACES] );
+	R_LoadMarksurfaces( &header.lumps[LUMP_LEAFSURFACES] );
 	ri.SCR_UpdateScreen();
-	R_LoadNodesAndLeafs( &header->lumps[LUMP_NODES], &header->lumps[LUMP_LEAFS] );
+	R_LoadNodesAndLeafs( &header.lumps[LUMP_NODES], &header.lumps[LUMP_LEAFS] );
 	ri.SCR_UpdateScreen();
-	R_LoadSubmodels( &header->lumps[LUMP_MODELS] );
+	R_LoadSubmodels( &header.lumps[LUMP_MODELS] );
 	ri.SCR_UpdateScreen();
 
 	// moved fog lump loading here, so fogs can be tagged with a model num
-	R_LoadFogs( &header->lumps[LUMP_FOGS], &header->lumps[LUMP_BRUSHES], &header->lumps[LUMP_BRUSHSIDES] );
+	R_LoadFogs( &header.lumps[LUMP_FOGS], &header.lumps[LUMP_BRUSHES], &header.lumps[LUMP_BRUSHSIDES] );
 	ri.SCR_UpdateScreen();
 
-	R_LoadVisibility( &header->lumps[LUMP_VISIBILITY] );
+	R_LoadVisibility( &header.lumps[LUMP_VISIBILITY] );
 	ri.SCR_UpdateScreen();
-	R_LoadEntities( &header->lumps[LUMP_ENTITIES] );
+	R_LoadEntities( &header.lumps[LUMP_ENTITIES] );
 	ri.SCR_UpdateScreen();
-	R_LoadLightGrid( &header->lumps[LUMP_LIGHTGRID] );
+	R_LoadLightGrid( &header.lumps[LUMP_LIGHTGRID] );
 	ri.SCR_UpdateScreen();
 
 #ifdef USE_VBO
@@ -2425,5 +2428,7 @@ void RE_LoadWorldMap( const char *name ) {
 	}
 
 //----(SA)	end
-	ri.FS_FreeFile( buffer.v );
+	ri.FS_FreeBSP( buffer );
+
+	R_PROFILE_END();
 }
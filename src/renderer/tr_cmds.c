@@ -110,7 +110,9 @@ static void R_IssueRenderCommands( void ) {
 	// actually start the commands going
 	if ( !r_skipBackEnd->integer ) {
 		// let it start on the new batch
+		R_PROFILE_BEGIN( "RB_ExecuteRenderCommands" );
 		RB_ExecuteRenderCommands( cmdList->cmds );
+		R_PROFILE_END();
 	}
 }
 
@@ -200,6 +200,8 @@ cvar_t  *r_cacheModels;
 
 cvar_t  *r_cacheGathering;
 
+cvar_t  *r_profile;
+
 cvar_t  *r_buildScript;
 
 cvar_t  *r_bonesDebug;
@@ -1873,6 +1875,7 @@ static void R_Register( void )
 	r_saveFontData = ri.Cvar_Get( "r_saveFontData", "0", 0 );
 	// Ridah
 	r_cacheGathering = ri.Cvar_Get( "cl_cacheGathering", "0", 0 );
+	r_profile = ri.Cvar_Get( "com_profile", "0", CVAR_TEMP );
 	r_bonesDebug = ri.Cvar_Get( "r_bonesDebug", "0", CVAR_CHEAT );
 	// done.
 
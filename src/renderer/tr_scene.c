@@ -735,7 +735,9 @@ void RE_RenderScene( const refdef_t *fd ) {
 
 	VectorCopy( fd->vieworg, parms.pvsOrigin );
 
+	R_PROFILE_BEGIN( "R_RenderView" );
 	R_RenderView( &parms );
+	R_PROFILE_END();
 
 	if ( fd->rdflags & RDF_RENDEROMNIBOT )
 		RE_RenderOmnibot();
@@ -50,11 +50,11 @@ void R_LoadBMP( const char *name, byte **pic, int *width, int *height )
 	unsigned	numPixels;
 	byte	*pixbuf;
 	int		row, column;
-	byte	*buf_p;
-	byte	*end;
+	const byte	*buf_p;
+	const byte	*end;
 	union {
-		byte *b;
-		void *v;
+		const byte *b;
+		const void *v;
 	} buffer;
 	int		length;
 	BMPHeader_t bmpHeader;
@@ -71,14 +71,14 @@ void R_LoadBMP( const char *name, byte **pic, int *width, int *height )
 	//
 	// load the file
 	//
-	length = ri.FS_ReadFile( ( char * ) name, &buffer.v);
+	length = ri.FS_MapFile( name, &buffer.v );
 	if (!buffer.b || length < 0) {
 		return;
 	}
 
 	if (length < 54)
 	{
-		ri.FS_FreeFile( buffer.v );
+		ri.FS_UnmapFile( buffer.v );
 		ri.Error( ERR_DROP, "LoadBMP: header too short (%s)", name );
 	}
 
@@ -120,7 +120,7 @@ void R_LoadBMP( const char *name, byte **pic, int *width, int *height )
 	{
 		if (buf_p + sizeof(bmpHeader.palette) > end)
 		{
-			ri.FS_FreeFile( buffer.v );
+			ri.FS_UnmapFile( buffer.v );
 			ri.Error( ERR_DROP, "LoadBMP: header too short (%s)", name );
 		}
 
@@ -129,7 +129,7 @@ void R_LoadBMP( const char *name, byte **pic, int *width, int *height )
 
 	if (buffer.b + bmpHeader.bitmapDataOffset > end)
 	{
-		ri.FS_FreeFile( buffer.v );
+		ri.FS_UnmapFile( buffer.v );
 		ri.Error( ERR_DROP, "LoadBMP: invalid offset value in header (%s)", name );
 	}
 
@@ -137,22 +137,22 @@ void R_LoadBMP( const char *name, byte **pic, int *width, int *height )
 
 	if ( bmpHeader.id[0] != 'B' && bmpHeader.id[1] != 'M' ) 
 	{
-		ri.FS_FreeFile( buffer.v );
+		ri.FS_UnmapFile( buffer.v );
 		ri.Error( ERR_DROP, "LoadBMP: only Windows-style BMP files supported (%s)", name );
 	}
 	if ( bmpHeader.fileSize != (uint32_t)length )
 	{
-		ri.FS_FreeFile (buffer.v );
+		ri.FS_UnmapFile( buffer.v );
 		ri.Error( ERR_DROP, "LoadBMP: header size does not match file size (%u vs. %i) (%s)", bmpHeader.fileSize, length, name );
 	}
 	if ( bmpHeader.compression != 0 )
 	{
-		ri.FS_FreeFile( buffer.v );
+		ri.FS_UnmapFile( buffer.v );
 		ri.Error( ERR_DROP, "LoadBMP: only uncompressed BMP files supported (%s)", name );
 	}
 	if ( bmpHeader.bitsPerPixel < 8 )
 	{
-		ri.FS_FreeFile( buffer.v );
+		ri.FS_UnmapFile( buffer.v );
 		ri.Error( ERR_DROP, "LoadBMP: monochrome and 4-bit BMP files not supported (%s)", name );
 	}
 
@@ -164,7 +164,7 @@ void R_LoadBMP( const char *name, byte **pic, int *width, int *height )
 		case 32:
 			break;
 		default:
-			ri.FS_FreeFile( buffer.v );
+			ri.FS_UnmapFile( buffer.v );
 			ri.Error( ERR_DROP, "LoadBMP: illegal pixel_size '%hu' in file '%s'", bmpHeader.bitsPerPixel, name );
 			break;
 	}
@@ -178,12 +178,12 @@ void R_LoadBMP( const char *name, byte **pic, int *width, int *height )
 	if(columns <= 0 || !rows || numPixels > 0x1FFFFFFF // 4*1FFFFFFF == 0x7FFFFFFC < 0x7FFFFFFF
 	    || ((numPixels * 4) / (uint32_t)columns) / 4 != (uint32_t)rows)
 	{
-	  ri.FS_FreeFile( buffer.v );
+	  ri.FS_UnmapFile( buffer.v );
 	  ri.Error (ERR_DROP, "LoadBMP: %s has an invalid image size", name);
 	}
 	if(buf_p + numPixels*bmpHeader.bitsPerPixel/8 > end)
 	{
-	  ri.FS_FreeFile( buffer.v );
+	  ri.FS_UnmapFile( buffer.v );
 	  ri.Error (ERR_DROP, "LoadBMP: file truncated (%s)", name);
 	}
 
@@ -246,5 +246,5 @@ void R_LoadBMP( const char *name, byte **pic, int *width, int *height )
 		}
 	}
 
-	ri.FS_FreeFile( buffer.v );
+	ri.FS_UnmapFile( buffer.v );
 }
@@ -60,17 +60,17 @@ typedef struct {
 void R_LoadPCX ( const char *filename, byte **pic, int *width, int *height)
 {
 	union {
-		byte *b;
-		void *v;
+		const byte *b;
+		const void *v;
 	} raw;
-	byte	*end;
-	pcx_t	*pcx;
+	const byte	*end;
+	const pcx_t	*pcx;
 	int		len;
 	byte dataByte = 0, runLength = 0;
 	byte	*out, *pix;
 	uint16_t w, h;
 	byte	*pic8;
-	byte	*palette;
+	const byte	*palette;
 	int	i;
 	unsigned size = 0;
 
@@ -83,14 +83,14 @@ void R_LoadPCX ( const char *filename, byte **pic, int *width, int *height)
 	//
 	// load the file
 	//
-	len = ri.FS_ReadFile( ( char * ) filename, &raw.v);
+	len = ri.FS_MapFile( filename, &raw.v );
 	if (!raw.b || len < 0) {
 		return;
 	}
 
 	if((unsigned)len < sizeof(pcx_t))
 	{
-		ri.FS_FreeFile (raw.v);
+		ri.FS_UnmapFile( raw.v );
 		ri.Printf (PRINT_ALL, "PCX truncated: %s\n", filename);
 		return;
 	}
@@ -113,7 +113,7 @@ void R_LoadPCX ( const char *filename, byte **pic, int *width, int *height)
 		|| w >= 1024
 		|| h >= 1024)
 	{
-		ri.FS_FreeFile (raw.v);
+		ri.FS_UnmapFile( raw.v );
 		ri.Printf (PRINT_ALL, "Bad or unsupported pcx file %s (%dx%d@%d)\n", filename, w, h, pcx->bits_per_pixel);
 		return;
 	}
@@ -148,14 +148,15 @@ void R_LoadPCX ( const char *filename, byte **pic, int *width, int *height)
 	if(pix < pic8+size)
 	{
 		ri.Printf (PRINT_ALL, "PCX file truncated: %s\n", filename);
-		ri.FS_FreeFile (pcx);
+		ri.FS_UnmapFile( pcx );
 		//ri.Free (pic8);
+		return;
 	}
 
-	if (raw.b-(byte*)pcx >= end - (byte*)769 || end[-769] != 0x0c)
+	if (raw.b-(const byte*)pcx >= end - (const byte*)769 || end[-769] != 0x0c)
 	{
 		ri.Printf (PRINT_ALL, "PCX missing palette: %s\n", filename);
-		ri.FS_FreeFile (pcx);
+		ri.FS_UnmapFile( pcx );
 		//ri.Free (pic8);
 		return;
 	}
@@ -181,6 +182,6 @@ void R_LoadPCX ( const char *filename, byte **pic, int *width, int *height)
 
 	*pic = out;
 
-	ri.FS_FreeFile (pcx);
+	ri.FS_UnmapFile( pcx );
 	//ri.Free (pic8);
 }
@@ -203,9 +203,9 @@ struct PNG_Chunk_IHDR
 
 struct BufferedFile
 {
-	byte *Buffer;
+	const byte *Buffer;
 	int   Length;
-	byte *Ptr;
+	const byte *Ptr;
 	int   BytesLeft;
 };
 
@@ -217,8 +217,8 @@ static struct BufferedFile *ReadBufferedFile(const char *name)
 {
 	struct BufferedFile *BF;
 	union {
-		byte *b;
-		void *v;
+		const byte *b;
+		const void *v;
 	} buffer;
 
 	/*
@@ -253,7 +253,7 @@ static struct BufferedFile *ReadBufferedFile(const char *name)
 	 *  Read the file.
 	 */
 
-	BF->Length = ri.FS_ReadFile(name, &buffer.v);
+	BF->Length = ri.FS_MapFile(name, &buffer.v);
 	BF->Buffer = buffer.b;
 
 	/*
@@ -287,7 +287,7 @@ static void CloseBufferedFile(struct BufferedFile *BF)
 	{
 		if(BF->Buffer)
 		{
-			ri.FS_FreeFile(BF->Buffer);
+			ri.FS_UnmapFile(BF->Buffer);
 		}
 
 		ri.Free(BF);
@@ -298,9 +298,9 @@ static void CloseBufferedFile(struct BufferedFile *BF)
  *  Get a pointer to the requested bytes.
  */
 
-static void *BufferedFileRead(struct BufferedFile *BF, unsigned Length)
+static const void *BufferedFileRead(struct BufferedFile *BF, unsigned Length)
 {
-	void *RetVal;
+	const void *RetVal;
 
 	/*
 	 *  input verification
@@ -430,7 +430,7 @@ static qboolean BufferedFileSkip(struct BufferedFile *BF, unsigned Offset)
 
 static qboolean FindChunk(struct BufferedFile *BF, uint32_t ChunkType)
 {
-	struct PNG_ChunkHeader *CH;
+	const struct PNG_ChunkHeader *CH;
 
 	uint32_t Length;
 	uint32_t Type;
@@ -514,7 +514,7 @@ static uint32_t DecompressIDATs(struct BufferedFile *BF, uint8_t **Buffer)
 	uint8_t  *CompressedDataPtr;
 	uint32_t  CompressedDataLength;
 
-	struct PNG_ChunkHeader *CH;
+	const struct PNG_ChunkHeader *CH;
 
 	uint32_t Length;
 	uint32_t Type;
@@ -675,7 +675,7 @@ static uint32_t DecompressIDATs(struct BufferedFile *BF, uint8_t **Buffer)
 
 		if(Length)
 		{
-			uint8_t *OrigCompressedData;
+			const uint8_t *OrigCompressedData;
 
 			OrigCompressedData = BufferedFileRead(BF, Length);
 			if(!OrigCompressedData)
@@ -995,7 +995,7 @@ static qboolean UnfilterImage(uint8_t  *DecompressedData,
  *  Convert a raw input pixel to Quake 3 RGA format.
  */
 
-static qboolean ConvertPixel(struct PNG_Chunk_IHDR *IHDR,
+static qboolean ConvertPixel(const struct PNG_Chunk_IHDR *IHDR,
 		byte                  *OutPtr,
 		uint8_t               *DecompPtr,
 		qboolean               HasTransparentColour,
@@ -1254,7 +1254,7 @@ static qboolean ConvertPixel(struct PNG_Chunk_IHDR *IHDR,
  *  Decode a non-interlaced image.
  */
 
-static qboolean DecodeImageNonInterlaced(struct PNG_Chunk_IHDR *IHDR,
+static qboolean DecodeImageNonInterlaced(const struct PNG_Chunk_IHDR *IHDR,
 		byte                  *OutBuffer, 
 		uint8_t               *DecompressedData,
 		uint32_t               DecompressedDataLength,
@@ -1531,7 +1531,7 @@ static qboolean DecodeImageNonInterlaced(struct PNG_Chunk_IHDR *IHDR,
  *  Decode an interlaced image.
  */
 
-static qboolean DecodeImageInterlaced(struct PNG_Chunk_IHDR *IHDR,
+static qboolean DecodeImageInterlaced(const struct PNG_Chunk_IHDR *IHDR,
 		byte                  *OutBuffer, 
 		uint8_t               *DecompressedData,
 		uint32_t               DecompressedDataLength,
@@ -1906,15 +1906,15 @@ void R_LoadPNG(const char *name, byte **pic, int *width, int *height)
 {
 	struct BufferedFile *ThePNG;
 	byte *OutBuffer;
-	uint8_t *Signature;
-	struct PNG_ChunkHeader *CH;
+	const uint8_t *Signature;
+	const struct PNG_ChunkHeader *CH;
 	uint32_t ChunkHeaderLength;
 	uint32_t ChunkHeaderType;
-	struct PNG_Chunk_IHDR *IHDR;
+	const struct PNG_Chunk_IHDR *IHDR;
 	uint32_t IHDR_Width;
 	uint32_t IHDR_Height;
-	PNG_ChunkCRC *CRC;
-	uint8_t *InPal;
+	const PNG_ChunkCRC *CRC;
+	const uint8_t *InPal;
 	uint8_t *DecompressedData;
 	uint32_t DecompressedDataLength;
 	uint32_t i;
@@ -2212,7 +2212,7 @@ void R_LoadPNG(const char *name, byte **pic, int *width, int *height)
 
 	if(FindChunk(ThePNG, PNG_ChunkType_tRNS))
 	{
-		uint8_t *Trans;
+		const uint8_t *Trans;
 
 		/*
 		 *  Read the chunk-header.
@@ -51,11 +51,11 @@ void R_LoadTGA ( const char *name, byte **pic, int *width, int *height)
 	uint32_t	columns, rows, numPixels;
 	byte		*pixbuf;
 	uint32_t	row, column;
-	byte		*buf_p;
-	byte		*end;
+	const byte	*buf_p;
+	const byte	*end;
 	union {
-		byte *b;
-		void *v;
+		const byte *b;
+		const void *v;
 	} buffer;
 	TargaHeader	targa_header;
 	byte		*targa_rgba;
@@ -71,14 +71,14 @@ void R_LoadTGA ( const char *name, byte **pic, int *width, int *height)
 	//
 	// load the file
 	//
-	length = ri.FS_ReadFile ( ( char * ) name, &buffer.v);
+	length = ri.FS_MapFile( name, &buffer.v );
 	if (!buffer.b || length < 0) {
 		return;
 	}
 
 	if(length < 18)
 	{
-		ri.FS_FreeFile( buffer.v );
+		ri.FS_UnmapFile( buffer.v );
 		ri.Error( ERR_DROP, "LoadTGA: header too short (%s)", name );
 	}
 
@@ -112,19 +112,19 @@ void R_LoadTGA ( const char *name, byte **pic, int *width, int *height)
 		&& targa_header.image_type!=10
 		&& targa_header.image_type != 3 ) 
 	{
-		ri.FS_FreeFile( buffer.v );
+		ri.FS_UnmapFile( buffer.v );
 		ri.Error( ERR_DROP, "LoadTGA: Only type 2 (RGB), 3 (gray), and 10 (RGB) TGA images supported" );
 	}
 
 	if ( targa_header.colormap_type != 0 )
 	{
-		ri.FS_FreeFile( buffer.v );
+		ri.FS_UnmapFile( buffer.v );
 		ri.Error( ERR_DROP, "LoadTGA: colormaps not supported" );
 	}
 
 	if ( ( targa_header.pixel_size != 32 && targa_header.pixel_size != 24 ) && targa_header.image_type != 3 )
 	{
-		ri.FS_FreeFile( buffer.v );
+		ri.FS_UnmapFile( buffer.v );
 		ri.Error( ERR_DROP, "LoadTGA: Only 32 or 24 bit images supported (no colormaps)" );
 	}
 
@@ -134,7 +134,7 @@ void R_LoadTGA ( const char *name, byte **pic, int *width, int *height)
 
 	if(!columns || !rows || numPixels > 0x7FFFFFFF || numPixels / columns / 4 != rows)
 	{
-		ri.FS_FreeFile( buffer.v );
+		ri.FS_UnmapFile( buffer.v );
 		ri.Error( ERR_DROP, "LoadTGA: %s has an invalid image size", name );
 	}
 
@@ -145,7 +145,7 @@ void R_LoadTGA ( const char *name, byte **pic, int *width, int *height)
 	if (targa_header.id_length != 0)
 	{
 		if (buf_p + targa_header.id_length > end) {
-			ri.FS_FreeFile( buffer.v );
+			ri.FS_UnmapFile( buffer.v );
 			ri.Error( ERR_DROP, "LoadTGA: header too short (%s)", name );
 		}
 
@@ -156,7 +156,7 @@ void R_LoadTGA ( const char *name, byte **pic, int *width, int *height)
 	{ 
 		if(buf_p + columns*rows*targa_header.pixel_size/8 > end)
 		{
-			ri.FS_FreeFile( buffer.v );
+			ri.FS_UnmapFile( buffer.v );
 			ri.Error( ERR_DROP, "LoadTGA: file truncated (%s)", name );
 		}
 
@@ -200,7 +200,7 @@ void R_LoadTGA ( const char *name, byte **pic, int *width, int *height)
 					*pixbuf++ = alphabyte;
 					break;
 				default:
-					ri.FS_FreeFile( buffer.v );
+					ri.FS_UnmapFile( buffer.v );
 					ri.Error( ERR_DROP, "LoadTGA: illegal pixel_size '%d' in file '%s'", targa_header.pixel_size, name );
 					break;
 				}
@@ -214,14 +214,14 @@ void R_LoadTGA ( const char *name, byte **pic, int *width, int *height)
 			pixbuf = targa_rgba + row*columns*4;
 			for(column=0; column<columns; ) {
 				if(buf_p + 1 > end) {
-					ri.FS_FreeFile( buffer.v );
+					ri.FS_UnmapFile( buffer.v );
 					ri.Error( ERR_DROP, "LoadTGA: file truncated (%s)", name );
 				}
 				packetHeader= *buf_p++;
 				packetSize = 1 + (packetHeader & 0x7f);
 				if (packetHeader & 0x80) {        // run-length packet
 					if(buf_p + targa_header.pixel_size/8 > end) {
-						ri.FS_FreeFile( buffer.v );
+						ri.FS_UnmapFile( buffer.v );
 						ri.Error( ERR_DROP, "LoadTGA: file truncated (%s)", name );
 					}
 					switch (targa_header.pixel_size) {
@@ -238,7 +238,7 @@ void R_LoadTGA ( const char *name, byte **pic, int *width, int *height)
 								alphabyte = *buf_p++;
 								break;
 						default:
-							ri.FS_FreeFile( buffer.v );
+							ri.FS_UnmapFile( buffer.v );
 							ri.Error( ERR_DROP, "LoadTGA: illegal pixel_size '%d' in file '%s'", targa_header.pixel_size, name );
 							break;
 					}
@@ -262,7 +262,7 @@ void R_LoadTGA ( const char *name, byte **pic, int *width, int *height)
 				else {                            // non run-length packet
 
 					if(buf_p + targa_header.pixel_size/8*packetSize > end) {
-						ri.FS_FreeFile( buffer.v );
+						ri.FS_UnmapFile( buffer.v );
 						ri.Error( ERR_DROP, "LoadTGA: file truncated (%s)", name );
 					}
 					for(j=0;j<packetSize;j++) {
@@ -287,7 +287,7 @@ void R_LoadTGA ( const char *name, byte **pic, int *width, int *height)
 									*pixbuf++ = alphabyte;
 									break;
 							default:
-								ri.FS_FreeFile( buffer.v );
+								ri.FS_UnmapFile( buffer.v );
 								ri.Error( ERR_DROP, "LoadTGA: illegal pixel_size '%d' in file '%s'", targa_header.pixel_size, name );
 								break;
 						}
@@ -337,7 +337,7 @@ void R_LoadTGA ( const char *name, byte **pic, int *width, int *height)
 
   *pic = targa_rgba;
 
-  ri.FS_FreeFile (buffer.v);
+  ri.FS_UnmapFile( buffer.v );
 }
 #ifdef _MSC_VER
 #pragma warning(pop)
@@ -32,7 +32,7 @@ If you have questions concerning this license or the applicable additional terms
 #include "tr_types.h"
 #include "vulkan/vulkan.h"
 
-#define REF_API_VERSION     8
+#define REF_API_VERSION     10
 
 //
 // these are the functions exported by the refresh module
@@ -181,6 +181,10 @@ typedef struct {
 
 	int64_t	(*Microseconds)( void );
 
+	// scoped timing markers for profile_dump, name must be a string literal
+	void	(*Com_ProfileBegin)( const char *name );
+	void	(*Com_ProfileEnd)( void );
+
 	// stack based memory allocation for per-level things that
 	// won't be freed
 	void ( *Hunk_Clear )( void );
@@ -232,6 +236,12 @@ typedef struct {
 	//int ( *FS_FileIsInPAK )( const char *name, int *pChecksum );
 	int ( *FS_ReadFile )( const char *name, void **buf );
 	void ( *FS_FreeFile )( void *buf );
+	// read only world map image, shared with the clip model
+	int ( *FS_ReadBSP )( const char *name, const void **buf );
+	void ( *FS_FreeBSP )( const void *buf );
+	// read only file image, large files are mapped from disk
+	int ( *FS_MapFile )( const char *name, const void **buf );
+	void ( *FS_UnmapFile )( const void *buf );
 	char ** ( *FS_ListFiles )( const char *name, const char *extension, int *numfilesfound );
 	char ** ( *FS_ListFilesEx )( const char *path, const char **extensions, int numExts, int *numfiles );
 	void ( *FS_FreeFileList )( char **filelist );
@@ -1411,14 +1411,17 @@ image_t	*R_FindImageFile( const char *name, imgFlags_t flags )
 	//
 	// load the pic from disk
 	//
+	R_PROFILE_BEGIN( "R_FindImageFile" );
+
 	localName = R_LoadImage( name, &pic, &width, &height );
 	if ( pic == NULL ) {
+		R_PROFILE_END();
 		return NULL;
 	}
 
 	// Arnout: apply lightmap colouring
 	if ( flags & IMGFLAG_LIGHTMAP ) {
-		R_ProcessLightmap( &pic, 4, width, height, &pic );
+		R_ProcessLightmap( pic, 4, width, height, pic );
 
 		// ydnar: no texture compression
 		if ( !(flags & IMGFLAG_NO_COMPRESSION) )
@@ -1450,12 +1453,16 @@ image_t	*R_FindImageFile( const char *name, imgFlags_t flags )
 #ifdef CHECKPOWEROF2
 	if ( ( /*!nonPowerOfTwoTextures ||*/ !r_allowNonPo2->integer) && (( ( width - 1 ) & width ) || ( ( height - 1 ) & height )) ) {
 		Com_Printf( S_COLOR_RED "Image not power of 2 scaled: \"%s\"\n", name );
+		R_PROFILE_END();
 		return NULL;
 	}
 #endif // CHECKPOWEROF2
 
 	image = R_CreateImage( name, localName, pic, width, height, flags );
 	//ri.Free( pic );
+
+	R_PROFILE_END();
+
 	return image;
 }
 
@@ -1670,6 +1670,12 @@ extern cvar_t  *r_cacheModels;
 
 extern cvar_t  *r_cacheGathering;
 
+// engine side com_profile, the markers are recorded by the engine
+extern cvar_t  *r_profile;
+
+#define R_PROFILE_BEGIN( name )	do { if ( r_profile->integer ) ri.Com_ProfileBegin( name ); } while ( 0 )
+#define R_PROFILE_END()			do { if ( r_profile->integer ) ri.Com_ProfileEnd(); } while ( 0 )
+
 //extern cvar_t	*r_marksOnTriangleMeshes;
 
 extern cvar_t  *r_bonesDebug;
@@ -1787,7 +1793,7 @@ qhandle_t	RE_RegisterSkin( const char *name );
 
 qboolean	RE_GetEntityToken( char *buffer, int size );
 
-float       R_ProcessLightmap( byte **pic, int in_padding, int width, int height, byte **pic_out ); // Arnout
+float       R_ProcessLightmap( const byte *pic, int in_padding, int width, int height, byte *pic_out ); // Arnout
 
 //----(SA)
 qboolean    RE_GetSkinModel( qhandle_t skinid, const char *type, char *name );
@@ -748,7 +748,9 @@ void RE_RenderScene( const refdef_t *fd ) {
 	tr.numDrawSurfCmds = 0;
 #endif
 
+	R_PROFILE_BEGIN( "R_RenderView" );
 	R_RenderView( &parms );
+	R_PROFILE_END();
 
 #ifndef USE_VULKAN
 	if ( fd->rdflags & RDF_RENDEROMNIBOT )
@@ -124,6 +124,8 @@ typedef struct {
 	int num_tags;
 
 	byte			baselineUsed[ MAX_GENTITIES ];
+
+	qboolean		prefetched;			// next map was handed to Com_PrefetchMap
 } server_t;
 
 typedef struct {
@@ -319,6 +321,35 @@ typedef struct {
 
 } serverStatic_t;
 
+// counters behind the metrics command, kept across maps
+#define METRICS_FRAME_BUCKETS	10
+
+typedef enum {
+	SVQ_STATUS,				// getstatus and the complete status
+	SVQ_INFO,
+	SVQ_CHALLENGE,
+	SVQ_CONNECT,
+	SVQ_RCON,
+	SVQ_COUNT
+} svQuery_t;
+
+typedef struct {
+	int64_t		frames;
+	int64_t		frameUsec;
+	int64_t		frameBuckets[ METRICS_FRAME_BUCKETS ];
+
+	int64_t		snapshotsBuilt;
+	int64_t		snapshotBuildUsec;
+	int64_t		snapshotsSent;
+	int64_t		snapshotEncodeUsec;
+
+	int64_t		rateLimitedAddress[ SVQ_COUNT ];	// SVC_RateLimitAddress
+	int64_t		rateLimitedGlobal[ SVQ_COUNT ];		// the shared buckets
+
+	int64_t		connects;
+	netchanStats_t	departed;	// traffic of clients whose slot was reused
+} svMetrics_t;
+
 #ifdef USE_BANS
 #define SERVER_MAXBANS	1024
 // Structure for managing bans
@@ -335,6 +366,7 @@ typedef struct
 //=============================================================================
 
 extern serverStatic_t svs;                  // persistant server info across maps
+extern svMetrics_t svm;
 extern server_t sv;                         // cleared each map
 extern vm_t            *gvm;                // game virtual machine
 
@@ -373,6 +405,8 @@ extern cvar_t  *sv_onlyVisibleClients;
 extern cvar_t  *sv_showAverageBPS;          // NERVE - SMF - net debugging
 
 extern cvar_t* sv_gameType;
+extern cvar_t  *sv_gameState;
+extern int      sv_cachedGametype;
 
 extern cvar_t  *sv_filterCommands;
 
@@ -596,6 +630,14 @@ int SV_Netchan_TransmitNextFragment( client_t *client );
 qboolean SV_Netchan_Process( client_t *client, msg_t *msg );
 void SV_Netchan_FreeQueue( client_t *client );
 
+//
+// sv_metrics.c
+//
+void SV_InitMetrics( void );
+void SV_MetricsFrame( void );
+void SV_MetricsFrameTime( int usec );
+void SV_MetricsRetireClient( client_t *cl );
+
 //
 // sv_filter.c
 //
@@ -153,6 +153,7 @@ void SV_GetChallenge( const netadr_t *from ) {
 
 	// Prevent using getchallenge as an amplifier
 	if ( SVC_RateLimitAddress( from, 10, 1000 ) ) {
+		svm.rateLimitedAddress[ SVQ_CHALLENGE ]++;
 		if ( com_developer->integer ) {
 			Com_Printf( "SV_GetChallenge: rate limit from %s exceeded, dropping request\n",
 				NET_AdrToString( from ) );
@@ -458,6 +459,7 @@ A "connect" OOB command has been received
 void SV_DirectConnect( const netadr_t *from ) {
 	static		rateLimit_t bucket;
 	char		userinfo[MAX_INFO_STRING], tld[3];
+	infoDict_t	dict;
 	int			i, n;
 	client_t	*cl, *newcl;
 	//sharedEntity_t *ent;
@@ -497,6 +499,7 @@ void SV_DirectConnect( const netadr_t *from ) {
 
 	// Prevent using connect as an amplifier
 	if ( SVC_RateLimitAddress( from, 10, 1000 ) ) {
+		svm.rateLimitedAddress[ SVQ_CONNECT ]++;
 		if ( com_developer->integer ) {
 			Com_Printf( "SV_DirectConnect: rate limit from %s exceeded, dropping request\n",
 				NET_AdrToString( from ) );
@@ -549,10 +552,18 @@ void SV_DirectConnect( const netadr_t *from ) {
 	}
 
 	Q_strncpyz( userinfo, info, sizeof( userinfo ) );
+	if ( !Info_DictParse( &dict, userinfo ) ) {
+		// avoid excessive outgoing traffic
+		if ( !SVC_RateLimit( &bucket, 10, 200 ) ) {
+			NET_OutOfBandPrint( NS_SERVER, from, "print\nUserinfo string length exceeded.  "
+				"Try removing setu cvars from your config.\n" );
+		}
+		return;
+	}
 
 	// DHM - Nerve :: Update Server allows any protocol to connect
 	// NOTE TTimo: but we might need to store the protocol around for potential non http/ftp clients
-	v = Info_ValueForKey( userinfo, "protocol" );
+	v = Info_DictValue( &dict, "protocol" );
 	if ( *v == '\0' )
 	{
 		if ( !SVC_RateLimit( &bucket, 10, 200 ) )
@@ -589,7 +600,7 @@ void SV_DirectConnect( const netadr_t *from ) {
 		compat = qfalse;
 	}
 
-	v = Info_ValueForKey( userinfo, "qport" );
+	v = Info_DictValue( &dict, "qport" );
 	if ( *v == '\0' )
 	{
 		if ( !SVC_RateLimit( &bucket, 10, 200 ) )
@@ -598,11 +609,11 @@ void SV_DirectConnect( const netadr_t *from ) {
 		}
 		return;
 	}
-	qport = atoi( Info_ValueForKey( userinfo, "qport" ) );
+	qport = atoi( v );
 
 	// if "client" is present in userinfo and it is a modern client
 	// then assume it can properly decode long strings and protocol extensions
-	if ( !compat && *Info_ValueForKey( userinfo, "client" ) != '\0' ) {
+	if ( !compat && *Info_DictValue( &dict, "client" ) != '\0' ) {
 		longstr = qtrue;
 	} else {
 		longstr = qfalse;
@@ -613,10 +624,10 @@ void SV_DirectConnect( const netadr_t *from ) {
 	}
 
 	// we don't need these keys after connection, release some space in userinfo
-	Info_RemoveKey( userinfo, "challenge" );
-	Info_RemoveKey( userinfo, "qport" );
-	Info_RemoveKey( userinfo, "protocol" );
-	Info_RemoveKey( userinfo, "client" );
+	Info_DictRemove( &dict, "challenge" );
+	Info_DictRemove( &dict, "qport" );
+	Info_DictRemove( &dict, "protocol" );
+	Info_DictRemove( &dict, "client" );
 
 	// don't let "ip" overflow userinfo string
 	if ( NET_IsLocalAddress( from ) )
@@ -624,7 +635,7 @@ void SV_DirectConnect( const netadr_t *from ) {
 	else
 		ip = NET_AdrToString( from );
 
-	if ( !Info_SetValueForKey( userinfo, "ip", ip ) ) {
+	if ( !Info_DictSet( &dict, "ip", ip ) ) {
 		// avoid excessive outgoing traffic
 		if ( !SVC_RateLimit( &bucket, 10, 200 ) ) {
 			NET_OutOfBandPrint( NS_SERVER, from, "print\nUserinfo string length exceeded.  "
@@ -635,7 +646,8 @@ void SV_DirectConnect( const netadr_t *from ) {
 
 	// run userinfo filter
 	SV_SetTLD( tld, from, Sys_IsLANAddress( from ) );
-	Info_SetValueForKey( userinfo, "tld", tld );
+	Info_DictSet( &dict, "tld", tld );
+	Info_DictWrite( &dict, userinfo, sizeof( userinfo ) );
 	v = SV_RunFilters( userinfo, from );
 	if ( *v != '\0' ) {
 		NET_OutOfBandPrint( NS_SERVER, from, "print\n[err_dialog]%s\n", v );
@@ -703,7 +715,7 @@ void SV_DirectConnect( const netadr_t *from ) {
 	// servers so we can play without having to kick people.
 
 	// check for privateClient password
-	password = Info_ValueForKey( userinfo, "password" );
+	password = Info_DictValue( &dict, "password" );
 	if ( *password && !strcmp( password, sv_privatePassword->string ) ) {
 		startIndex = 0;
 	} else {
@@ -758,7 +770,9 @@ gotnewcl:
 	// accept the new client
 	// this is the only place a client_t is ever initialized
 	// we got a newcl, so reset the reliableSequence and reliableAcknowledge
+	SV_MetricsRetireClient( newcl );
 	Com_Memset( newcl, 0, sizeof( *newcl ) );
+	svm.connects++;
 	clientNum = newcl - svs.clients;
 #if 0 // skip this until CS_PRIMED
 	//ent = SV_GentityNum( clientNum );
@@ -1885,6 +1899,7 @@ into a more C friendly form.
 =================
 */
 void SV_UserinfoChanged( client_t *cl, qboolean updateUserinfo, qboolean runFilter ) {
+	infoDict_t dict;
 	const char *val;
 	const char *ip;
 	int	i;
@@ -1897,16 +1912,28 @@ void SV_UserinfoChanged( client_t *cl, qboolean updateUserinfo, qboolean runFilt
 		if ( !updateUserinfo )
 			return;
 
+		if ( !Info_DictParse( &dict, cl->userinfo ) ) {
+			SV_DropClient( cl, "userinfo string length exceeded" );
+			return;
+		}
+
 		// name for C code
-		Q_strncpyz( cl->name, Info_ValueForKey( cl->userinfo, "name" ), sizeof( cl->name ) );
+		Q_strncpyz( cl->name, Info_DictValue( &dict, "name" ), sizeof( cl->name ) );
 
-		Q_strncpyz( cl->guid, Info_ValueForKey( cl->userinfo, "cl_guid" ), sizeof( cl->guid ) );
+		Q_strncpyz( cl->guid, Info_DictValue( &dict, "cl_guid" ), sizeof( cl->guid ) );
 
 		// TTimo
 		// maintain the IP information
 		// the banning code relies on this being consistently present
-		if ( !Info_SetValueForKey( cl->userinfo, "ip", "bot" ) )
+		if ( !Info_DictSet( &dict, "ip", "bot" ) )
 			SV_DropClient( cl, "userinfo string length exceeded" );
+		Info_DictWrite( &dict, cl->userinfo, sizeof( cl->userinfo ) );
+		return;
+	}
+
+	// parse once for all the keys below
+	if ( !Info_DictParse( &dict, cl->userinfo ) ) {
+		SV_DropClient( cl, "userinfo string length exceeded" );
 		return;
 	}
 
@@ -1917,7 +1944,7 @@ void SV_UserinfoChanged( client_t *cl, qboolean updateUserinfo, qboolean runFilt
 	if ( cl->netchan.remoteAddress.type == NA_LOOPBACK || ( cl->netchan.isLANAddress && com_dedicated->integer != 2 && sv_lanForceRate->integer ) ) {
 		cl->rate = 0; // lans should not rate limit
 	} else {
-		val = Info_ValueForKey( cl->userinfo, "rate" );
+		val = Info_DictValue( &dict, "rate" );
 		if ( val[0] )
 			cl->rate = atoi( val );
 		else
@@ -1935,7 +1962,7 @@ void SV_UserinfoChanged( client_t *cl, qboolean updateUserinfo, qboolean runFilt
 	}
 
 	// snaps command
-	val = Info_ValueForKey( cl->userinfo, "snaps" );
+	val = Info_DictValue( &dict, "snaps" );
 	if ( val[0] && !NET_IsLocalAddress( &cl->netchan.remoteAddress ) )
 		i = atoi( val );
 	else
@@ -1960,9 +1987,9 @@ void SV_UserinfoChanged( client_t *cl, qboolean updateUserinfo, qboolean runFilt
 		return;
 
 	// name for C code
-	Q_strncpyz( cl->name, Info_ValueForKey( cl->userinfo, "name" ), sizeof( cl->name ) );
+	Q_strncpyz( cl->name, Info_DictValue( &dict, "name" ), sizeof( cl->name ) );
 
-	Q_strncpyz( cl->guid, Info_ValueForKey( cl->userinfo, "cl_guid" ), sizeof( cl->guid ) );
+	Q_strncpyz( cl->guid, Info_DictValue( &dict, "cl_guid" ), sizeof( cl->guid ) );
 
 	/*val = Info_ValueForKey( cl->userinfo, "handicap" );
 	if ( val[0] ) {
@@ -1974,7 +2001,7 @@ void SV_UserinfoChanged( client_t *cl, qboolean updateUserinfo, qboolean runFilt
 
 	// TTimo
 	// download prefs of the client
-	val = Info_ValueForKey( cl->userinfo, "cl_wwwDownload" );
+	val = Info_DictValue( &dict, "cl_wwwDownload" );
 	cl->bDlOK = qfalse;
 	if ( strlen( val ) ) {
 		i = atoi( val );
@@ -1991,10 +2018,11 @@ void SV_UserinfoChanged( client_t *cl, qboolean updateUserinfo, qboolean runFilt
 	else
 		ip = NET_AdrToString( &cl->netchan.remoteAddress );
 
-	if ( !Info_SetValueForKey( cl->userinfo, "ip", ip ) )
+	if ( !Info_DictSet( &dict, "ip", ip ) )
 		SV_DropClient( cl, "userinfo string length exceeded" );
 
-	Info_SetValueForKey( cl->userinfo, "tld", cl->tld );
+	Info_DictSet( &dict, "tld", cl->tld );
+	Info_DictWrite( &dict, cl->userinfo, sizeof( cl->userinfo ) );
 
 	if ( runFilter )
 	{
@@ -2025,6 +2053,9 @@ static void SV_UpdateUserinfo_f( client_t *cl ) {
 	Q_strncpyz( cl->userinfo, info, sizeof( cl->userinfo ) );
 
 	SV_UserinfoChanged( cl, qtrue, qtrue ); // update userinfo, run filter
+	if ( cl->state == CS_ZOMBIE ) {
+		return; // dropped for a bad userinfo
+	}
 	// call prog code to allow overrides
 	VM_Call( gvm, GAME_CLIENT_USERINFO_CHANGED, cl - svs.clients );
 }
@@ -2152,11 +2183,17 @@ Also called by bot code
 */
 qboolean SV_ExecuteClientCommand( client_t *cl, const char *s, qboolean premaprestart ) {
 	const ucmd_t *ucmd;
+	cmdSpan_t cmdName;
 	qboolean bFloodProtect;
 	qboolean isBot;
 	qboolean isCallvote = qfalse;
 
-	Cmd_TokenizeString( s );
+	// only the command name is needed to route the command, the
+	// full tokenization is left for whoever ends up handling it
+	if ( !Cmd_TokenizeSpans( s, &cmdName, 1, qfalse ) ) {
+		cmdName.start = "";
+		cmdName.length = 0;
+	}
 
 	// malicious users may try using too many string commands
 	// to lag other players.  If we decide that we want to stall
@@ -2171,7 +2208,7 @@ qboolean SV_ExecuteClientCommand( client_t *cl, const char *s, qboolean premapre
 
 	// see if it is a server level command
 	for ( ucmd = ucmds; ucmd->name; ucmd++ ) {
-		if ( !strcmp( Cmd_Argv(0), ucmd->name ) ) {
+		if ( !strncmp( cmdName.start, ucmd->name, cmdName.length ) && ucmd->name[cmdName.length] == '\0' ) {
 			if ( ucmd->func == SV_UpdateUserinfo_f ) {
 #ifndef DEDICATED
 				if ( !com_cl_running->integer && bFloodProtect && sv_userinfoFloodProtect->integer ) {
@@ -2187,9 +2224,9 @@ qboolean SV_ExecuteClientCommand( client_t *cl, const char *s, qboolean premapre
 			} else if ( premaprestart && !ucmd->allowedpostmapchange ) {
 				continue;
 			}
+			Cmd_TokenizeString( s );
 			ucmd->func( cl );
-			bFloodProtect = qfalse;
-			break;
+			return qtrue;
 		}
 	}
 
@@ -2210,10 +2247,11 @@ qboolean SV_ExecuteClientCommand( client_t *cl, const char *s, qboolean premapre
 	if ( bFloodProtect && SV_FloodProtect( cl ) ) {
 #endif
 		// ignore any other text messages from this client but let them keep playing
-		Com_DPrintf( "client text ignored for %s: %s\n", cl->name, Cmd_Argv(0) );
+		Com_DPrintf( "client text ignored for %s: %.*s\n", cl->name, cmdName.length, cmdName.start );
 	} else {
 		// pass unknown strings to the game
-		if ( !ucmd->name && sv.state == SS_GAME && cl->state >= CS_PRIMED ) {
+		if ( sv.state == SS_GAME && cl->state >= CS_PRIMED ) {
+			Cmd_TokenizeString( s );
 			if ( sv_filterCommands->integer > 0 ) {
 				if ( sv_filterCommands->integer >= 2 )
 					Cmd_Args_Sanitize( "\n\r;", isCallvote );
@@ -2339,7 +2377,7 @@ static void SV_UserMove( client_t *cl, msg_t *msg, qboolean delta ) {
 
 	// save time for ping calculation
 	if ( cl->frames[ cl->messageAcknowledge & PACKET_MASK ].messageAcked == 0 ) {
-		cl->frames[ cl->messageAcknowledge & PACKET_MASK ].messageAcked = Sys_Milliseconds();
+		cl->frames[ cl->messageAcknowledge & PACKET_MASK ].messageAcked = Com_EventTime();
 	}
 
 	// if this is the first usercmd we have received
@@ -415,6 +415,16 @@ static qboolean SV_G_GetValue( char* value, int valueSize, const char* key )
 		return qtrue;
 	}
 
+	if ( !Q_stricmp( key, "trap_Cvar_Changes_ETE" ) ) {
+		Com_sprintf( value, valueSize, "%i", G_CVAR_CHANGES );
+		return qtrue;
+	}
+
+	if ( !Q_stricmp( key, "trap_FS_AsyncLog_ETE" ) ) {
+		Com_sprintf( value, valueSize, "%i", G_FS_ASYNC_LOG );
+		return qtrue;
+	}
+
 	// UTF-8 not yet supported
 	if ( !Q_stricmp( key, "cap_UTF8" ) ) {
 		Com_sprintf( value, valueSize, "%i", 0 );
@@ -466,9 +476,9 @@ static intptr_t SV_GameSystemCalls( intptr_t *args ) {
 		Com_Error( ERR_DROP, "%s", (const char *)VMA( 1 ) );
 		return 0;
 	case G_MILLISECONDS:
-		return Sys_Milliseconds();
+		return Com_EventTime();
 	case G_CVAR_REGISTER:
-		Cvar_Register( VMA(1), VMA(2), VMA(3), args[4], gvm->privateFlag ); 
+		Cvar_Register( VMA(1), VMA(2), VMA(3), args[4], gvm->privateFlag, VM_GAME );
 		return 0;
 	case G_CVAR_UPDATE:
 		Cvar_Update( VMA(1), gvm->privateFlag );
@@ -713,6 +723,10 @@ static intptr_t SV_GameSystemCalls( intptr_t *args ) {
 	case G_REMOVECOMMAND:
 		Cmd_RemoveCommandSafe( VMA(1) );
 		return 0;
+	case G_CVAR_CHANGES:
+		return Cvar_ReadChanges( VM_GAME, VMA(1), args[2] );
+	case G_FS_ASYNC_LOG:
+		return FS_VM_SetAsyncLog( args[1], H_QAGAME );
 
 	case G_TRAP_GETVALUE:
 		return SV_G_GetValue( VMA(1), args[2], VMA(3) );
@@ -549,6 +549,8 @@ void SV_SpawnServer( const char *mapname ) {
 	char		bspname[MAX_QPATH];
 	int			pakChecksum = 0; // checksum of pk3 map is in
 
+	PROFILE_BEGIN( "SV_SpawnServer" );
+
 	// ydnar: broadcast a level change to all connected clients
 	if ( svs.clients && !com_errorEntered ) {
 		SV_FinalCommand( "spawnserver", qfalse );
@@ -671,7 +673,9 @@ void SV_SpawnServer( const char *mapname ) {
 	FS_Restart( sv.checksumFeed );
 
 	Sys_SetStatus( "Loading map %s", mapname );
+	PROFILE_BEGIN( "CM_LoadMap" );
 	CM_LoadMap( bspname, qfalse, &checksum );
+	PROFILE_END();
 
 	// set serverinfo visible name
 	Cvar_Set( "mapname", mapname );
@@ -697,7 +701,9 @@ void SV_SpawnServer( const char *mapname ) {
 	Cvar_Set( "sv_serverRestarting", "1" );
 
 	// load and spawn all other entities
+	PROFILE_BEGIN( "SV_InitGameProgs" );
 	SV_InitGameProgs();
+	PROFILE_END();
 
 	// don't allow a map_restart if game is modified
 	// Arnout: there isn't any check done against this, obsolete
@@ -883,9 +889,17 @@ void SV_SpawnServer( const char *mapname ) {
 
 	Cvar_Set( "sv_serverRestarting", "0" );
 
+	// a listen server finishes once the client has loaded its media
+#ifndef DEDICATED
+	if ( !com_cl_running || !com_cl_running->integer )
+#endif
+	Com_PrefetchFinished();
+
 	Com_Printf ("-----------------------------------\n");
 
 	Sys_SetStatus( "Running map %s", mapname );
+
+	PROFILE_END();
 }
 
 
@@ -1012,7 +1026,7 @@ void SV_Init( void )
 	Cvar_Get( "g_altStopwatchMode", "0", CVAR_ARCHIVE );
 	Cvar_Get( "g_minGameClients", "8", CVAR_SERVERINFO );
 	Cvar_Get( "g_complaintlimit", "6", CVAR_ARCHIVE );
-	Cvar_Get( "gamestate", "-1", CVAR_WOLFINFO | CVAR_ROM );
+	sv_gameState = Cvar_Get( "gamestate", "-1", CVAR_WOLFINFO | CVAR_ROM );
 	Cvar_Get( "g_currentRound", "0", CVAR_WOLFINFO );
 	Cvar_Get( "g_nextTimeLimit", "0", CVAR_WOLFINFO );
 	// -NERVE - SMF
@@ -1091,6 +1105,8 @@ void SV_Init( void )
 
 	SV_InitChallenger();
 	svs.serverLoad = -1;
+
+	SV_InitMetrics();
 }
 
 
@@ -1168,8 +1184,10 @@ void SV_Shutdown( const char *finalmsg ) {
 	if ( svs.clients ) {
 		int index;
 
-		for ( index = 0; index < sv_maxclients->integer; index++ )
+		for ( index = 0; index < sv_maxclients->integer; index++ ) {
+			SV_MetricsRetireClient( &svs.clients[ index ] );
 			SV_FreeClient( &svs.clients[ index ] );
+		}
 		
 #ifdef USE_CLIENTS_ZONE
 		Z_Free( svs.clients );
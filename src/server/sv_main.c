@@ -68,6 +68,7 @@ cvar_t  *sv_needpass;
 cvar_t *sv_dl_maxRate;
 
 cvar_t* sv_gameType;
+cvar_t	*sv_gameState;
 
 // Rafael gameskill
 //cvar_t	*sv_gameskill;
@@ -540,7 +541,7 @@ static leakyBucket_t *SVC_BucketForAddress( const netadr_t *address, int burst,
 	static leakyBucket_t dummy = { 0 };
 	static int		start = 0;
 	const int		hash = SVC_HashForAddress( address );
-	const int		now = Sys_Milliseconds();
+	const int		now = Com_EventTime();
 	leakyBucket_t	*bucket;
 	int				i, n;
 
@@ -631,7 +632,7 @@ SVC_RateLimit
 ================
 */
 qboolean SVC_RateLimit( rateLimit_t *bucket, int burst, int period ) {
-	int now = Sys_Milliseconds();
+	int now = Com_EventTime();
 	int interval = now - bucket->lastTime;
 	int expired = interval / period;
 	int expiredRemainder = interval % period;
@@ -663,7 +664,7 @@ static void SVC_RateDrop( leakyBucket_t *bucket, int burst ) {
 		if ( bucket->toxic < 10000 )
 			++bucket->toxic;
 		bucket->rate.burst = burst * bucket->toxic;
-		bucket->rate.lastTime = Sys_Milliseconds();
+		bucket->rate.lastTime = Com_EventTime();
 	}
 }
 
@@ -810,6 +811,7 @@ static void SVC_Status( const netadr_t *from ) {
 
 	// Prevent using getstatus as an amplifier
 	if ( SVC_RateLimitAddress( from, 10, 1000 ) ) {
+		svm.rateLimitedAddress[ SVQ_STATUS ]++;
 		if ( com_developer->integer ) {
 			Com_Printf( "SVC_Status: rate limit from %s exceeded, dropping request\n",
 				NET_AdrToString( from ) );
@@ -820,6 +822,7 @@ static void SVC_Status( const netadr_t *from ) {
 	// Allow getstatus to be DoSed relatively easily, but prevent
 	// excess outbound bandwidth usage when being flooded inbound
 	if ( SVC_RateLimit( &outboundRateLimit, 10, 100 ) ) {
+		svm.rateLimitedGlobal[ SVQ_STATUS ]++;
 		Com_DPrintf( "SVC_Status: rate limit exceeded, dropping request\n" );
 		return;
 	}
@@ -895,6 +898,7 @@ void SVC_GameCompleteStatus( const netadr_t *from ) {
 
 	// Prevent using getstatus as an amplifier
 	if ( SVC_RateLimitAddress( from, 10, 1000 ) ) {
+		svm.rateLimitedAddress[ SVQ_STATUS ]++;
 		if ( com_developer->integer ) {
 			Com_Printf( "SVC_GameCompleteStatus: rate limit from %s exceeded, dropping request\n",
 				NET_AdrToString( from ) );
@@ -905,6 +909,7 @@ void SVC_GameCompleteStatus( const netadr_t *from ) {
 	// Allow getstatus to be DoSed relatively easily, but prevent
 	// excess outbound bandwidth usage when being flooded inbound
 	if ( SVC_RateLimit( &outboundRateLimit, 10, 100 ) ) {
+		svm.rateLimitedGlobal[ SVQ_STATUS ]++;
 		Com_DPrintf( "SVC_GameCompleteStatus: rate limit exceeded, dropping request\n" );
 		return;
 	}
@@ -973,6 +978,7 @@ static void SVC_Info( const netadr_t *from ) {
 
 	// Prevent using getinfo as an amplifier
 	if ( SVC_RateLimitAddress( from, 10, 1000 ) ) {
+		svm.rateLimitedAddress[ SVQ_INFO ]++;
 		if ( com_developer->integer ) {
 			Com_Printf( "SVC_Info: rate limit from %s exceeded, dropping request\n",
 				NET_AdrToString( from ) );
@@ -983,6 +989,7 @@ static void SVC_Info( const netadr_t *from ) {
 	// Allow getinfo to be DoSed relatively easily, but prevent
 	// excess outbound bandwidth usage when being flooded inbound
 	if ( SVC_RateLimit( &outboundRateLimit, 10, 100 ) ) {
+		svm.rateLimitedGlobal[ SVQ_INFO ]++;
 		Com_DPrintf( "SVC_Info: rate limit exceeded, dropping request\n" );
 		return;
 	}
@@ -1100,6 +1107,7 @@ static void SVC_RemoteCommand( const netadr_t *from ) {
 
 	// Prevent using rcon as an amplifier and make dictionary attacks impractical
 	if ( SVC_RateLimitAddress( from, 10, 1000 ) ) {
+		svm.rateLimitedAddress[ SVQ_RCON ]++;
 		if ( com_developer->integer ) {
 			Com_Printf( "SVC_RemoteCommand: rate limit from %s exceeded, dropping request\n",
 				NET_AdrToString( from ) );
@@ -1115,6 +1123,7 @@ static void SVC_RemoteCommand( const netadr_t *from ) {
 	} else {
 		// Make DoS via rcon impractical
 		if ( SVC_RateLimit( &bucket, 10, 1000 ) ) {
+			svm.rateLimitedGlobal[ SVQ_RCON ]++;
 			Com_DPrintf( "SVC_RemoteCommand: rate limit exceeded, dropping request\n" );
 			return;
 		}
@@ -1543,6 +1552,185 @@ static void SV_Restart( const char *reason ) {
 }
 
 
+/*
+==================
+SV_PrefetchMapCommand
+
+Follows vstr chains in a command string until a map change is found
+==================
+*/
+static void SV_PrefetchMapCommand( const char *text, int depth ) {
+	char		command[ MAX_CVAR_VALUE_STRING ];
+	char		buf[ MAX_CVAR_VALUE_STRING ];
+	const char	*token;
+	const char	*p;
+	int			len;
+
+	if ( depth > 8 ) {
+		return;
+	}
+
+	while ( *text ) {
+		// split on ';' like the command buffer does
+		p = strchr( text, ';' );
+		len = p ? p - text : strlen( text );
+		if ( len >= sizeof( command ) ) {
+			len = sizeof( command ) - 1;
+		}
+		Com_Memcpy( command, text, len );
+		command[ len ] = '\0';
+		text += p ? len + 1 : len;
+
+		p = command;
+		token = COM_ParseExt( &p, qfalse );
+		if ( !Q_stricmp( token, "vstr" ) ) {
+			token = COM_ParseExt( &p, qfalse );
+			Cvar_VariableStringBuffer( token, buf, sizeof( buf ) );
+			SV_PrefetchMapCommand( buf, depth + 1 );
+			return;
+		}
+		if ( !Q_stricmp( token, "map" ) || !Q_stricmp( token, "devmap" ) ) {
+			token = COM_ParseExt( &p, qfalse );
+			Com_PrefetchMap( token );
+			return;
+		}
+	}
+}
+
+
+/*
+==================
+SV_CampaignMap
+
+Finds map number index of a campaign in the .campaign scripts
+==================
+*/
+static qboolean SV_CampaignMap( const char *shortname, int index, char *mapname, int size ) {
+	char		name[ MAX_QPATH ];
+	char		maps[ MAX_STRING_CHARS ];
+	char		**files;
+	char		*buf;
+	const char	*p, *token, *m;
+	int			numFiles, i, len;
+	qboolean	found;
+
+	found = qfalse;
+	files = FS_ListFiles( "scripts", ".campaign", &numFiles );
+
+	for ( i = 0; i < numFiles && !found; i++ ) {
+		if ( FS_ReadFile( va( "scripts/%s", files[i] ), (void **)&buf ) <= 0 ) {
+			continue;
+		}
+
+		name[0] = maps[0] = '\0';
+		p = buf;
+		while ( !found ) {
+			token = COM_Parse( &p );
+			if ( !token[0] ) {
+				break;
+			}
+			if ( !Q_stricmp( token, "shortname" ) ) {
+				Q_strncpyz( name, COM_Parse( &p ), sizeof( name ) );
+			} else if ( !Q_stricmp( token, "maps" ) ) {
+				Q_strncpyz( maps, COM_Parse( &p ), sizeof( maps ) );
+			} else if ( token[0] == '}' ) {
+				if ( !Q_stricmp( name, shortname ) ) {
+					// maps are separated by ';' like the game splits them
+					for ( m = maps; index > 0 && m; index-- ) {
+						m = strchr( m, ';' );
+						if ( m ) {
+							m++;
+						}
+					}
+					if ( m && *m ) {
+						len = strcspn( m, ";" );
+						if ( len >= size ) {
+							len = size - 1;
+						}
+						Com_Memcpy( mapname, m, len );
+						mapname[ len ] = '\0';
+						found = qtrue;
+					}
+					break;
+				}
+				name[0] = maps[0] = '\0';
+			}
+		}
+
+		FS_FreeFile( buf );
+	}
+
+	FS_FreeFileList( files );
+
+	return found;
+}
+
+
+/*
+==================
+SV_PrefetchNextMap
+
+The game runs "vstr nextmap" when the intermission ends, or moves on to
+the next map of the campaign in campaign mode
+==================
+*/
+static void SV_PrefetchNextMap( void ) {
+	char nextmap[ MAX_CVAR_VALUE_STRING ];
+	char campaign[ MAX_CVAR_VALUE_STRING ];
+
+	sv.prefetched = qtrue;
+
+	// GT_WOLF_CAMPAIGN
+	if ( sv_cachedGametype == 4 ) {
+		Cvar_VariableStringBuffer( "g_currentCampaign", campaign, sizeof( campaign ) );
+		if ( SV_CampaignMap( campaign, Cvar_VariableIntegerValue( "g_currentCampaignMap" ) + 1, nextmap, sizeof( nextmap ) ) ) {
+			Com_PrefetchMap( nextmap );
+			return;
+		}
+		// the last map goes on to nextcampaign or back to the first one
+		Cvar_VariableStringBuffer( "nextcampaign", nextmap, sizeof( nextmap ) );
+		if ( nextmap[0] ) {
+			SV_PrefetchMapCommand( nextmap, 0 );
+		} else if ( SV_CampaignMap( campaign, 0, nextmap, sizeof( nextmap ) ) ) {
+			Com_PrefetchMap( nextmap );
+		}
+		return;
+	}
+
+	Cvar_VariableStringBuffer( "nextmap", nextmap, sizeof( nextmap ) );
+	SV_PrefetchMapCommand( nextmap, 0 );
+}
+
+
+/*
+==================
+SV_GameStateChecksum
+
+Hash of all entity and player states, journaled to verify replays
+==================
+*/
+static unsigned int SV_GameStateChecksum( void ) {
+	unsigned int	checksum;
+	int				i;
+
+	checksum = 2166136261u;
+
+	for ( i = 0; i < sv.num_entities; i++ ) {
+		const entityState_t *es = &SV_GentityNum( i )->s;
+		checksum = ( checksum ^ crc32_buffer( (const byte *)es, sizeof( *es ) ) ) * 16777619u;
+	}
+
+	for ( i = 0; i < sv_maxclients->integer; i++ ) {
+		if ( svs.clients[i].state >= CS_PRIMED ) {
+			const playerState_t *ps = SV_GameClientNum( i );
+			checksum = ( checksum ^ crc32_buffer( (const byte *)ps, sizeof( *ps ) ) ) * 16777619u;
+		}
+	}
+
+	return checksum;
+}
+
+
 /*
 ==================
 SV_Frame
@@ -1556,10 +1744,14 @@ void SV_Frame( int msec ) {
 	int		startTime;
 	int		i;
 	int		frameStartTime = 0, frameEndTime;
+	int64_t	frameStartUsec, phaseStartUsec;
+	int		gameFrames, gameUsec, snapshotsUsec, serverUsec;
 
 	if ( Cvar_CheckGroup( CVG_SERVER ) )
 		SV_TrackCvarChanges(); // update rate settings, etc.
 
+	SV_MetricsFrame();
+
 	// the menu kills the server with this cvar
 	if ( sv_killserver->integer ) {
 		SV_Shutdown( "Server was killed" );
@@ -1569,7 +1761,7 @@ void SV_Frame( int msec ) {
 
 	if ( !com_sv_running->integer )
 	{
-		if ( com_dedicated->integer )
+		if ( com_dedicated->integer && !Com_JournalReplaying() )
 		{
 			// Block indefinitely until something interesting happens
 			// on STDIN.
@@ -1586,6 +1778,7 @@ void SV_Frame( int msec ) {
 	if ( com_dedicated->integer ) {
 		frameStartTime = Sys_Milliseconds();
 	}
+	frameStartUsec = Sys_Microseconds();
 
 	// if it isn't time for the next frame, do nothing
 
@@ -1651,6 +1844,11 @@ void SV_Frame( int msec ) {
 	if ( cvar_modifiedFlags & CVAR_WOLFINFO ) {
 		SV_SetConfigstring( CS_WOLFINFO, Cvar_InfoString( CVAR_WOLFINFO, NULL ) );
 		cvar_modifiedFlags &= ~CVAR_WOLFINFO;
+
+		// gamestate is a wolfinfo cvar, start reading the next map while the scoreboard is up
+		if ( !sv.prefetched && com_sv_running->integer && sv_gameState->integer == GS_INTERMISSION ) {
+			SV_PrefetchNextMap();
+		}
 	}
 
 	if ( com_speeds->integer ) {
@@ -1660,19 +1858,27 @@ void SV_Frame( int msec ) {
 	}
 
 	// update ping based on the all received frames
+	PROFILE_BEGIN( "SV_CalcPings" );
 	SV_CalcPings();
+	PROFILE_END();
 
 	//if (com_dedicated->integer) SV_BotFrame (sv.time);
 
 	// run the game simulation in chunks
+	gameFrames = 0;
+	phaseStartUsec = Sys_Microseconds();
 	while ( sv.timeResidual >= frameMsec ) {
 		sv.timeResidual -= frameMsec;
 		svs.time += frameMsec;
 		sv.time += frameMsec;
 
 		// let everything in the world think and move
+		PROFILE_BEGIN( "GAME_RUN_FRAME" );
 		VM_Call( gvm, GAME_RUN_FRAME, sv.time );
+		PROFILE_END();
+		gameFrames++;
 	}
+	gameUsec = (int)( Sys_Microseconds() - phaseStartUsec );
 
 	if ( com_speeds->integer ) {
 		time_game = Sys_Milliseconds () - startTime;
@@ -1685,11 +1891,23 @@ void SV_Frame( int msec ) {
 	SV_IssueNewSnapshot();
 
 	// send messages back to the clients
+	PROFILE_BEGIN( "SV_SendClientMessages" );
+	phaseStartUsec = Sys_Microseconds();
 	SV_SendClientMessages();
+	snapshotsUsec = (int)( Sys_Microseconds() - phaseStartUsec );
+	PROFILE_END();
 
 	// send a heartbeat to the master if needed
 	SV_MasterHeartbeat(HEARTBEAT_FOR_MASTER);
 
+	serverUsec = (int)( Sys_Microseconds() - frameStartUsec );
+	SV_MetricsFrameTime( serverUsec );
+
+	// journaled sessions are checked frame by frame when replayed
+	if ( gameFrames && ( Com_JournalRecording() || Com_JournalReplaying() ) ) {
+		Com_JournalServerFrame( sv.time, SV_GameStateChecksum(), gameUsec, snapshotsUsec, serverUsec );
+	}
+
 	if ( com_dedicated->integer ) {
 		frameEndTime = Sys_Milliseconds();
 
@@ -1766,7 +1984,7 @@ int SV_RateMsec( const client_t *client )
 		messageSize += UDPIP_HEADER_SIZE;
 
 	rateMsec = messageSize * 1000 / ((int) (client->rate * com_timescale->value));
-	rate = Sys_Milliseconds() - client->netchan.lastSentTime;
+	rate = Com_EventTime() - client->netchan.lastSentTime;
 
 	if ( rate > rateMsec )
 		return 0;
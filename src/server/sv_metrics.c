@@ -0,0 +1,557 @@
+/*
+===========================================================================
+
+Wolfenstein: Enemy Territory GPL Source Code
+Copyright (C) 1999-2010 id Software LLC, a ZeniMax Media company.
+
+This file is part of the Wolfenstein: Enemy Territory GPL Source Code (Wolf ET Source Code).
+
+Wolf ET Source Code is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Wolf ET Source Code is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Wolf ET Source Code.  If not, see <http://www.gnu.org/licenses/>.
+
+In addition, the Wolf: ET Source Code is also subject to certain additional terms. You should have received a copy of these additional terms immediately following the terms and conditions of the GNU General Public License which accompanied the Wolf ET Source Code.  If not, please request a copy in writing from id Software at the address below.
+
+If you have questions concerning this license or the applicable additional terms, you may contact in writing id Software LLC, c/o ZeniMax Media Inc., Suite 120, Rockville, Maryland 20850 USA.
+
+===========================================================================
+*/
+
+// sv_metrics.c -- server counters in the Prometheus text format
+//
+// The counters in svm are bumped inline where things happen and cost a
+// few additions per frame and snapshot. The "metrics" command prints them,
+// so they can be read over rcon. With sv_metricsPort set a worker thread
+// also serves them over HTTP; the main thread publishes a copy once per
+// frame and the worker formats and sends it without touching the server.
+
+#include "server.h"
+
+#if defined( _MSC_VER )
+#include <intrin.h>
+#define METRICS_LOAD( p )		( (unsigned int)_InterlockedOr( (volatile long *)(p), 0 ) )
+#define METRICS_STORE( p, v )	_InterlockedExchange( (volatile long *)(p), (long)(v) )
+#else
+#define METRICS_LOAD( p )		__atomic_load_n( (p), __ATOMIC_ACQUIRE )
+#define METRICS_STORE( p, v )	__atomic_store_n( (p), (v), __ATOMIC_RELEASE )
+#endif
+
+#define METRICS_BUFFER		( 64 * 1024 )
+
+// one connection is served at a time, so a slow scraper can't hold it for long
+#define METRICS_RECV_MSEC	250
+#define METRICS_SEND_MSEC	2000
+#define METRICS_SLICE_MSEC	100		// how often a send looks at exporter.quit
+
+// upper bounds of the frame time buckets in usec, the last one is +Inf
+static const int frameBucketUsec[ METRICS_FRAME_BUCKETS - 1 ] = {
+	1000, 2000, 4000, 8000, 16000, 32000, 50000, 100000, 250000
+};
+
+static const char *queryNames[ SVQ_COUNT ] = {
+	"status", "info", "challenge", "connect", "rcon"
+};
+
+typedef struct {
+	int				state;
+	qboolean		bot;
+	int				ping;
+	netchanStats_t	traffic;
+} metricsClient_t;
+
+typedef struct {
+	svMetrics_t		counters;
+	netchanStats_t	traffic;		// every client that ever connected
+	memUsage_t		memory;
+	qboolean		running;
+	int				serverLoad;
+	int				maxClients;
+	metricsClient_t	clients[ MAX_CLIENTS ];
+} metricsSnapshot_t;
+
+typedef struct {
+	char	*data;
+	int		size;
+	int		length;
+} metricsBuffer_t;
+
+svMetrics_t svm;
+
+static struct {
+	sysThread_t		*thread;
+	sysMutex_t		*lock;
+	tcpSocket_t		listener;
+	unsigned int	quit;
+	metricsSnapshot_t published;	// under the lock
+} exporter = { NULL, NULL, INVALID_TCP_SOCKET };
+
+static cvar_t *sv_metricsPort;
+static cvar_t *sv_metricsAddress;
+
+
+/*
+==================
+SV_MetricsFrameTime
+==================
+*/
+void SV_MetricsFrameTime( int usec ) {
+	int i;
+
+	for ( i = 0; i < METRICS_FRAME_BUCKETS - 1; i++ ) {
+		if ( usec <= frameBucketUsec[i] ) {
+			break;
+		}
+	}
+
+	svm.frameBuckets[i]++;
+	svm.frameUsec += usec;
+	svm.frames++;
+}
+
+
+/*
+==================
+SV_MetricsAddTraffic
+==================
+*/
+static void SV_MetricsAddTraffic( netchanStats_t *to, const netchanStats_t *from ) {
+	to->bytesSent += from->bytesSent;
+	to->bytesReceived += from->bytesReceived;
+	to->packetsSent += from->packetsSent;
+	to->packetsReceived += from->packetsReceived;
+	to->fragmentsSent += from->fragmentsSent;
+	to->dropped += from->dropped;
+}
+
+
+/*
+==================
+SV_MetricsRetireClient
+
+Moves the traffic of a client slot into the server totals before the
+slot is cleared, so the totals never go backwards
+==================
+*/
+void SV_MetricsRetireClient( client_t *cl ) {
+	SV_MetricsAddTraffic( &svm.departed, &cl->netchan.stats );
+	Com_Memset( &cl->netchan.stats, 0, sizeof( cl->netchan.stats ) );
+}
+
+
+/*
+==================
+SV_MetricsGather
+==================
+*/
+static void SV_MetricsGather( metricsSnapshot_t *snap ) {
+	const client_t	*cl;
+	metricsClient_t	*mc;
+	int				i;
+
+	snap->counters = svm;
+	snap->traffic = svm.departed;
+	snap->running = com_sv_running->integer ? qtrue : qfalse;
+	snap->serverLoad = svs.serverLoad;
+	snap->maxClients = 0;
+
+	Com_MemoryUsage( &snap->memory );
+
+	if ( !svs.clients ) {
+		return;
+	}
+
+	snap->maxClients = MIN( sv_maxclients->integer, MAX_CLIENTS );
+
+	for ( i = 0, cl = svs.clients, mc = snap->clients; i < snap->maxClients; i++, cl++, mc++ ) {
+		mc->state = cl->state;
+		mc->bot = cl->netchan.remoteAddress.type == NA_BOT ? qtrue : qfalse;
+		mc->ping = cl->ping;
+		mc->traffic = cl->netchan.stats;
+		SV_MetricsAddTraffic( &snap->traffic, &cl->netchan.stats );
+	}
+}
+
+
+/*
+==================
+SV_MetricsPrintf
+
+Reentrant, the exporter thread formats with it too
+==================
+*/
+static void FORMAT_PRINTF(2, 3) QDECL SV_MetricsPrintf( metricsBuffer_t *buf, const char *fmt, ... ) {
+	va_list	argptr;
+	int		len;
+
+	if ( buf->length >= buf->size - 1 ) {
+		return;
+	}
+
+	va_start( argptr, fmt );
+	len = Q_vsnprintf( buf->data + buf->length, buf->size - buf->length, fmt, argptr );
+	va_end( argptr );
+
+	if ( len < 0 || buf->length + len >= buf->size ) {
+		buf->length = buf->size - 1;	// truncated
+	} else {
+		buf->length += len;
+	}
+}
+
+
+/*
+==================
+SV_MetricsHeader
+==================
+*/
+static void SV_MetricsHeader( metricsBuffer_t *buf, const char *name, const char *type, const char *help ) {
+	SV_MetricsPrintf( buf, "# HELP %s %s\n# TYPE %s %s\n", name, help, name, type );
+}
+
+
+/*
+==================
+SV_MetricsClientCounter
+==================
+*/
+static void SV_MetricsClientCounter( metricsBuffer_t *buf, const metricsSnapshot_t *snap, const char *name, const char *help, size_t offset ) {
+	const metricsClient_t *mc;
+	int i;
+
+	SV_MetricsHeader( buf, name, "counter", help );
+	for ( i = 0, mc = snap->clients; i < snap->maxClients; i++, mc++ ) {
+		if ( mc->state != CS_FREE && !mc->bot ) {
+			SV_MetricsPrintf( buf, "%s{slot=\"%i\"} %lli\n", name, i, (long long)*(const int64_t *)( (const byte *)&mc->traffic + offset ) );
+		}
+	}
+}
+
+
+/*
+==================
+SV_MetricsFormat
+==================
+*/
+static void SV_MetricsFormat( metricsBuffer_t *buf, const metricsSnapshot_t *snap ) {
+	const svMetrics_t		*c = &snap->counters;
+	const metricsClient_t	*mc;
+	int64_t					cumulative;
+	int						states[ CS_ACTIVE + 1 ];
+	int						i, bots;
+
+	buf->length = 0;
+	buf->data[0] = '\0';
+
+	SV_MetricsHeader( buf, "ete_server_running", "gauge", "1 while a map is loaded" );
+	SV_MetricsPrintf( buf, "ete_server_running %i\n", snap->running );
+
+	SV_MetricsHeader( buf, "ete_server_frame_seconds", "histogram", "Time spent in each server frame" );
+	for ( i = 0, cumulative = 0; i < METRICS_FRAME_BUCKETS; i++ ) {
+		cumulative += c->frameBuckets[i];
+		if ( i < METRICS_FRAME_BUCKETS - 1 ) {
+			SV_MetricsPrintf( buf, "ete_server_frame_seconds_bucket{le=\"%g\"} %lli\n", frameBucketUsec[i] / 1e6, (long long)cumulative );
+		} else {
+			SV_MetricsPrintf( buf, "ete_server_frame_seconds_bucket{le=\"+Inf\"} %lli\n", (long long)cumulative );
+		}
+	}
+	SV_MetricsPrintf( buf, "ete_server_frame_seconds_sum %.6f\n", c->frameUsec / 1e6 );
+	SV_MetricsPrintf( buf, "ete_server_frame_seconds_count %lli\n", (long long)c->frames );
+
+	SV_MetricsHeader( buf, "ete_server_load_percent", "gauge", "Average frame time relative to the frame interval, -1 if unknown" );
+	SV_MetricsPrintf( buf, "ete_server_load_percent %i\n", snap->serverLoad );
+
+	SV_MetricsHeader( buf, "ete_snapshot_build_seconds_total", "counter", "Time spent building client snapshots" );
+	SV_MetricsPrintf( buf, "ete_snapshot_build_seconds_total %.6f\n", c->snapshotBuildUsec / 1e6 );
+	SV_MetricsHeader( buf, "ete_snapshots_built_total", "counter", "Client snapshots built" );
+	SV_MetricsPrintf( buf, "ete_snapshots_built_total %lli\n", (long long)c->snapshotsBuilt );
+	SV_MetricsHeader( buf, "ete_snapshot_encode_seconds_total", "counter", "Time spent delta encoding and sending client snapshots" );
+	SV_MetricsPrintf( buf, "ete_snapshot_encode_seconds_total %.6f\n", c->snapshotEncodeUsec / 1e6 );
+	SV_MetricsHeader( buf, "ete_snapshots_sent_total", "counter", "Client snapshots sent" );
+	SV_MetricsPrintf( buf, "ete_snapshots_sent_total %lli\n", (long long)c->snapshotsSent );
+
+	SV_MetricsHeader( buf, "ete_net_sent_bytes_total", "counter", "Bytes sent to clients" );
+	SV_MetricsPrintf( buf, "ete_net_sent_bytes_total %lli\n", (long long)snap->traffic.bytesSent );
+	SV_MetricsHeader( buf, "ete_net_received_bytes_total", "counter", "Bytes received from clients" );
+	SV_MetricsPrintf( buf, "ete_net_received_bytes_total %lli\n", (long long)snap->traffic.bytesReceived );
+	SV_MetricsHeader( buf, "ete_net_sent_packets_total", "counter", "Packets sent to clients" );
+	SV_MetricsPrintf( buf, "ete_net_sent_packets_total %lli\n", (long long)snap->traffic.packetsSent );
+	SV_MetricsHeader( buf, "ete_net_received_packets_total", "counter", "Packets received from clients" );
+	SV_MetricsPrintf( buf, "ete_net_received_packets_total %lli\n", (long long)snap->traffic.packetsReceived );
+	SV_MetricsHeader( buf, "ete_net_fragmented_packets_total", "counter", "Packets sent as fragments of a large message" );
+	SV_MetricsPrintf( buf, "ete_net_fragmented_packets_total %lli\n", (long long)snap->traffic.fragmentsSent );
+	SV_MetricsHeader( buf, "ete_net_dropped_packets_total", "counter", "Client packets lost, from gaps in the incoming sequence" );
+	SV_MetricsPrintf( buf, "ete_net_dropped_packets_total %lli\n", (long long)snap->traffic.dropped );
+
+	SV_MetricsClientCounter( buf, snap, "ete_client_sent_bytes_total", "Bytes sent to the client in a slot since it connected", offsetof( netchanStats_t, bytesSent ) );
+	SV_MetricsClientCounter( buf, snap, "ete_client_received_bytes_total", "Bytes received from the client in a slot since it connected", offsetof( netchanStats_t, bytesReceived ) );
+	SV_MetricsClientCounter( buf, snap, "ete_client_sent_packets_total", "Packets sent to the client in a slot since it connected", offsetof( netchanStats_t, packetsSent ) );
+	SV_MetricsClientCounter( buf, snap, "ete_client_received_packets_total", "Packets received from the client in a slot since it connected", offsetof( netchanStats_t, packetsReceived ) );
+	SV_MetricsClientCounter( buf, snap, "ete_client_fragmented_packets_total", "Fragments sent to the client in a slot since it connected", offsetof( netchanStats_t, fragmentsSent ) );
+	SV_MetricsClientCounter( buf, snap, "ete_client_dropped_packets_total", "Packets from the client in a slot lost since it connected", offsetof( netchanStats_t, dropped ) );
+
+	SV_MetricsHeader( buf, "ete_client_ping_milliseconds", "gauge", "Ping of the client in a slot" );
+	for ( i = 0, mc = snap->clients; i < snap->maxClients; i++, mc++ ) {
+		if ( mc->state == CS_ACTIVE && !mc->bot ) {
+			SV_MetricsPrintf( buf, "ete_client_ping_milliseconds{slot=\"%i\"} %i\n", i, mc->ping );
+		}
+	}
+
+	SV_MetricsHeader( buf, "ete_queries_rate_limited_total", "counter", "Connectionless requests dropped by SVC_RateLimit" );
+	for ( i = 0; i < SVQ_COUNT; i++ ) {
+		SV_MetricsPrintf( buf, "ete_queries_rate_limited_total{query=\"%s\",limit=\"address\"} %lli\n", queryNames[i], (long long)c->rateLimitedAddress[i] );
+		if ( i != SVQ_CHALLENGE && i != SVQ_CONNECT ) {
+			SV_MetricsPrintf( buf, "ete_queries_rate_limited_total{query=\"%s\",limit=\"global\"} %lli\n", queryNames[i], (long long)c->rateLimitedGlobal[i] );
+		}
+	}
+
+	SV_MetricsHeader( buf, "ete_connects_total", "counter", "Clients given a slot" );
+	SV_MetricsPrintf( buf, "ete_connects_total %lli\n", (long long)c->connects );
+
+	SV_MetricsHeader( buf, "ete_memory_used_bytes", "gauge", "Engine memory in use" );
+	SV_MetricsPrintf( buf, "ete_memory_used_bytes{pool=\"hunk\"} %i\n", snap->memory.hunkUsed );
+	SV_MetricsPrintf( buf, "ete_memory_used_bytes{pool=\"zone\"} %i\n", snap->memory.zoneUsed );
+	SV_MetricsPrintf( buf, "ete_memory_used_bytes{pool=\"smallzone\"} %i\n", snap->memory.smallZoneUsed );
+	SV_MetricsPrintf( buf, "ete_memory_used_bytes{pool=\"slab\"} %i\n", snap->memory.slabUsed );
+	SV_MetricsHeader( buf, "ete_memory_size_bytes", "gauge", "Engine memory reserved" );
+	SV_MetricsPrintf( buf, "ete_memory_size_bytes{pool=\"hunk\"} %i\n", snap->memory.hunkTotal );
+	SV_MetricsPrintf( buf, "ete_memory_size_bytes{pool=\"zone\"} %i\n", snap->memory.zoneTotal );
+	SV_MetricsPrintf( buf, "ete_memory_size_bytes{pool=\"smallzone\"} %i\n", snap->memory.smallZoneTotal );
+	SV_MetricsPrintf( buf, "ete_memory_size_bytes{pool=\"slab\"} %i\n", snap->memory.slabTotal );
+
+	Com_Memset( states, 0, sizeof( states ) );
+	for ( i = 0, bots = 0, mc = snap->clients; i < snap->maxClients; i++, mc++ ) {
+		if ( mc->bot && mc->state != CS_FREE ) {
+			bots++;
+		} else if ( mc->state >= 0 && mc->state <= CS_ACTIVE ) {
+			states[ mc->state ]++;
+		}
+	}
+
+	SV_MetricsHeader( buf, "ete_clients", "gauge", "Human clients by connection state" );
+	SV_MetricsPrintf( buf, "ete_clients{state=\"zombie\"} %i\n", states[ CS_ZOMBIE ] );
+	SV_MetricsPrintf( buf, "ete_clients{state=\"connected\"} %i\n", states[ CS_CONNECTED ] );
+	SV_MetricsPrintf( buf, "ete_clients{state=\"primed\"} %i\n", states[ CS_PRIMED ] );
+	SV_MetricsPrintf( buf, "ete_clients{state=\"active\"} %i\n", states[ CS_ACTIVE ] );
+	SV_MetricsHeader( buf, "ete_bots", "gauge", "Bots in game" );
+	SV_MetricsPrintf( buf, "ete_bots %i\n", bots );
+	SV_MetricsHeader( buf, "ete_clients_max", "gauge", "Client slots" );
+	SV_MetricsPrintf( buf, "ete_clients_max %i\n", snap->maxClients );
+}
+
+
+/*
+==================
+SV_MetricsSend
+
+Gives up after METRICS_SEND_MSEC or once the exporter is stopped
+==================
+*/
+static qboolean SV_MetricsSend( tcpSocket_t s, const metricsBuffer_t *buf ) {
+	const char *p = buf->data;
+	int len = buf->length;
+	int start, ret;
+
+	start = Sys_Milliseconds();
+
+	while ( len > 0 ) {
+		if ( METRICS_LOAD( &exporter.quit ) || Sys_Milliseconds() - start >= METRICS_SEND_MSEC ) {
+			return qfalse;
+		}
+		ret = NET_TCPSend( s, p, len, METRICS_SLICE_MSEC );
+		if ( ret < 0 ) {
+			return qfalse;
+		}
+		p += ret;
+		len -= ret;
+	}
+
+	return qtrue;
+}
+
+
+/*
+==================
+SV_MetricsThread
+
+Answers every connection with the last published counters, the request
+itself isn't looked at beyond waiting for it to arrive
+==================
+*/
+static void SV_MetricsThread( void *arg ) {
+	metricsSnapshot_t	*snap;
+	metricsBuffer_t		buf, head;
+	char				request[ 1024 ];
+	char				headData[ 256 ];
+	tcpSocket_t			s;
+
+	snap = malloc( sizeof( *snap ) );
+	buf.data = malloc( METRICS_BUFFER );
+	buf.size = METRICS_BUFFER;
+	head.data = headData;
+	head.size = sizeof( headData );
+
+	while ( snap && buf.data && !METRICS_LOAD( &exporter.quit ) ) {
+		s = NET_TCPAccept( exporter.listener, 250 );
+		if ( s == INVALID_TCP_SOCKET ) {
+			continue;
+		}
+
+		NET_TCPRecv( s, request, sizeof( request ), METRICS_RECV_MSEC );
+
+		Sys_LockMutex( exporter.lock );
+		*snap = exporter.published;
+		Sys_UnlockMutex( exporter.lock );
+
+		SV_MetricsFormat( &buf, snap );
+
+		head.length = 0;
+		SV_MetricsPrintf( &head, "HTTP/1.0 200 OK\r\n"
+			"Content-Type: text/plain; version=0.0.4\r\n"
+			"Connection: close\r\n"
+			"Content-Length: %i\r\n\r\n", buf.length );
+		if ( SV_MetricsSend( s, &head ) ) {
+			SV_MetricsSend( s, &buf );
+		}
+
+		NET_TCPClose( s );
+	}
+
+	free( buf.data );
+	free( snap );
+}
+
+
+/*
+==================
+SV_MetricsStop
+==================
+*/
+static void SV_MetricsStop( void ) {
+	if ( exporter.thread ) {
+		METRICS_STORE( &exporter.quit, 1 );
+		Sys_JoinThread( exporter.thread );
+		exporter.thread = NULL;
+	}
+
+	NET_TCPClose( exporter.listener );
+	exporter.listener = INVALID_TCP_SOCKET;
+}
+
+
+/*
+==================
+SV_MetricsStart
+==================
+*/
+static void SV_MetricsStart( void ) {
+	if ( !exporter.lock && ( exporter.lock = Sys_CreateMutex() ) == NULL ) {
+		Com_Printf( S_COLOR_YELLOW "WARNING: metrics exporter not started, no mutex\n" );
+		return;
+	}
+
+	exporter.listener = NET_TCPListen( sv_metricsAddress->string, sv_metricsPort->integer );
+	if ( exporter.listener == INVALID_TCP_SOCKET ) {
+		Com_Printf( S_COLOR_YELLOW "WARNING: metrics exporter couldn't listen on %s:%i\n",
+			sv_metricsAddress->string, sv_metricsPort->integer );
+		return;
+	}
+
+	SV_MetricsGather( &exporter.published );
+
+	exporter.quit = 0;
+	exporter.thread = Sys_CreateThread( SV_MetricsThread, NULL );
+	if ( !exporter.thread ) {
+		Com_Printf( S_COLOR_YELLOW "WARNING: metrics exporter thread couldn't be created\n" );
+		SV_MetricsStop();
+		return;
+	}
+
+	Com_Printf( "Serving metrics on %s:%i\n", sv_metricsAddress->string[0] ? sv_metricsAddress->string : "*", sv_metricsPort->integer );
+}
+
+
+/*
+==================
+SV_MetricsFrame
+
+Restarts the exporter when its cvars change and hands it the counters
+==================
+*/
+void SV_MetricsFrame( void ) {
+	if ( sv_metricsPort->modified || sv_metricsAddress->modified ) {
+		sv_metricsPort->modified = qfalse;
+		sv_metricsAddress->modified = qfalse;
+		SV_MetricsStop();
+		if ( sv_metricsPort->integer ) {
+			SV_MetricsStart();
+		}
+	}
+
+	if ( exporter.thread ) {
+		Sys_LockMutex( exporter.lock );
+		SV_MetricsGather( &exporter.published );
+		Sys_UnlockMutex( exporter.lock );
+	}
+}
+
+
+/*
+==================
+SV_Metrics_f
+==================
+*/
+static void SV_Metrics_f( void ) {
+	metricsSnapshot_t	*snap;
+	metricsBuffer_t		buf;
+	const char			*line, *end;
+
+	snap = Z_Malloc( sizeof( *snap ) );
+	buf.data = Z_Malloc( METRICS_BUFFER );
+	buf.size = METRICS_BUFFER;
+
+	SV_MetricsGather( snap );
+	SV_MetricsFormat( &buf, snap );
+
+	// line by line to stay below the print and rcon packet limits
+	for ( line = buf.data; *line; line = end + 1 ) {
+		end = strchr( line, '\n' );
+		if ( !end ) {
+			Com_Printf( "%s\n", line );
+			break;
+		}
+		Com_Printf( "%.*s\n", (int)( end - line ), line );
+	}
+
+	Z_Free( buf.data );
+	Z_Free( snap );
+}
+
+
+/*
+==================
+SV_InitMetrics
+==================
+*/
+void SV_InitMetrics( void ) {
+	sv_metricsPort = Cvar_Get( "sv_metricsPort", "0", CVAR_ARCHIVE_ND );
+	Cvar_CheckRange( sv_metricsPort, "0", "65535", CV_INTEGER );
+	Cvar_SetDescription( sv_metricsPort, "TCP port serving the metrics command output over HTTP for Prometheus, 0 disables it" );
+
+	sv_metricsAddress = Cvar_Get( "sv_metricsAddress", "127.0.0.1", CVAR_ARCHIVE_ND );
+	Cvar_SetDescription( sv_metricsAddress, "Address the sv_metricsPort listener binds to, empty for all interfaces" );
+
+	// started by the first SV_MetricsFrame, after networking is up
+	sv_metricsPort->modified = sv_metricsPort->integer ? qtrue : qfalse;
+	sv_metricsAddress->modified = qfalse;
+
+	Cmd_AddCommand( "metrics", SV_Metrics_f );
+}
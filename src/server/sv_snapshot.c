@@ -893,6 +893,7 @@ Also called by SV_FinalCommand
 void SV_SendClientSnapshot( client_t *client ) {
 	byte		msg_buf[ MAX_MSGLEN_BUF ];
 	msg_t		msg;
+	int64_t		start, built;
 
 	//bani
 	if ( client->state < CS_ACTIVE ) {
@@ -905,7 +906,12 @@ void SV_SendClientSnapshot( client_t *client ) {
 	}
 
 	// build the snapshot
+	start = Sys_Microseconds();
 	SV_BuildClientSnapshot( client );
+	built = Sys_Microseconds();
+
+	svm.snapshotBuildUsec += built - start;
+	svm.snapshotsBuilt++;
 
 	// bots need to have their snapshots build, but
 	// the query them directly without needing to be sent
@@ -938,6 +944,9 @@ void SV_SendClientSnapshot( client_t *client ) {
 
 	SV_SendMessageToClient( &msg, client );
 
+	svm.snapshotEncodeUsec += Sys_Microseconds() - built;
+	svm.snapshotsSent++;
+
 	sv.bpsTotalBytes += msg.cursize;            // NERVE - SMF - net debugging
 	sv.ubpsTotalBytes += msg.uncompsize / 8;    // NERVE - SMF - net debugging
 }
@@ -954,7 +963,7 @@ void SV_SendClientMessages( void )
 	client_t	*c;
 	int numclients = 0;         // NERVE - SMF - net debugging
 
-	svs.msgTime = Sys_Milliseconds();
+	svs.msgTime = Com_EventTime();
 
 	sv.bpsTotalBytes = 0;       // NERVE - SMF - net debugging
 	sv.ubpsTotalBytes = 0;      // NERVE - SMF - net debugging
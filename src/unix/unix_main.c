@@ -277,6 +277,9 @@ void Sys_DoStartProcess(const char *cmdline);
 // single exit point (regular exit or in case of signal fault)
 void NORETURN Sys_Exit(int code)
 {
+	// queued log lines, _exit() below skips stdio
+	Com_LogFlush();
+
 	Sys_ConsoleInputShutdown();
 
 	// we may be exiting to spawn another process
@@ -34,10 +34,15 @@ If you have questions concerning this license or the applicable additional terms
 #include <dirent.h>
 #include <unistd.h>
 #include <sys/mman.h>
+#include <sys/uio.h>
+#ifdef __linux__
+#include <sys/inotify.h>
+#endif
 #include <sys/time.h>
 #include <pwd.h>
 #include <dlfcn.h>
 #include <libgen.h>
+#include <pthread.h>
 
 #include "../qcommon/q_shared.h"
 #include "../qcommon/qcommon.h"
@@ -384,6 +389,402 @@ FILE *Sys_FOpen( const char *ospath, const char *mode )
 }
 
 
+struct sysMapping_s {
+	void	*base;
+	size_t	size;
+};
+
+
+/*
+=================
+Sys_MapFile
+
+Maps length bytes at offset of an open file read only, the stream
+itself can be closed afterwards
+=================
+*/
+sysMapping_t *Sys_MapFile( FILE *f, int64_t offset, int length, const void **data )
+{
+	sysMapping_t *mapping;
+	struct stat st;
+	off_t start;
+	size_t size;
+	long pageSize;
+	void *base;
+	int fd;
+
+	*data = NULL;
+
+	if ( offset < 0 || length <= 0 )
+		return NULL;
+
+	fd = fileno( f );
+	if ( fstat( fd, &st ) != 0 || offset + length > (int64_t)st.st_size )
+		return NULL;
+
+	pageSize = sysconf( _SC_PAGESIZE );
+	if ( pageSize <= 0 )
+		pageSize = 4096;
+
+	start = (off_t)( offset - offset % pageSize );
+	size = (size_t)( offset - start ) + length;
+
+	base = mmap( NULL, size, PROT_READ, MAP_PRIVATE, fd, start );
+	if ( base == MAP_FAILED )
+		return NULL;
+
+	// the whole image is parsed right away
+	madvise( base, size, MADV_WILLNEED );
+
+	mapping = malloc( sizeof( *mapping ) );
+	if ( mapping == NULL ) {
+		munmap( base, size );
+		return NULL;
+	}
+
+	mapping->base = base;
+	mapping->size = size;
+
+	*data = (const byte *)base + ( offset - start );
+	return mapping;
+}
+
+
+/*
+=================
+Sys_UnmapFile
+=================
+*/
+void Sys_UnmapFile( sysMapping_t *mapping )
+{
+	if ( mapping ) {
+		munmap( mapping->base, mapping->size );
+		free( mapping );
+	}
+}
+
+
+#define HUGE_PAGE_SIZE	( 2 * 1024 * 1024 )
+
+#ifdef MADV_HUGEPAGE
+/*
+=================
+Sys_TransparentHugePages
+
+madvise( MADV_HUGEPAGE ) succeeds even when the kernel never
+hands out huge pages
+=================
+*/
+static qboolean Sys_TransparentHugePages( void )
+{
+	char buf[ 64 ];
+	FILE *f;
+	size_t n;
+
+	f = fopen( "/sys/kernel/mm/transparent_hugepage/enabled", "r" );
+	if ( !f )
+		return qfalse;
+
+	n = fread( buf, 1, sizeof( buf ) - 1, f );
+	fclose( f );
+	buf[ n ] = '\0';
+
+	return strstr( buf, "[never]" ) == NULL ? qtrue : qfalse;
+}
+#endif
+
+
+/*
+=================
+Sys_AllocPages
+
+With huge set, explicit huge pages are tried first, they need pages
+reserved in /proc/sys/vm/nr_hugepages. Otherwise the mapping is 2 MB
+aligned and advised for transparent huge pages.
+=================
+*/
+void *Sys_AllocPages( size_t size, qboolean huge, pageKind_t *kind, size_t *pageSize )
+{
+	byte *base, *aligned;
+	size_t mapSize;
+	long small;
+
+	small = sysconf( _SC_PAGESIZE );
+	if ( small <= 0 )
+		small = 4096;
+
+	*kind = PAGES_SMALL;
+	*pageSize = small;
+
+	if ( !huge ) {
+		base = mmap( NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+		return base != MAP_FAILED ? base : NULL;
+	}
+
+	size = PAD( size, HUGE_PAGE_SIZE );
+
+#ifdef MAP_HUGETLB
+	base = mmap( NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0 );
+	if ( base != MAP_FAILED ) {
+		*kind = PAGES_HUGE;
+		*pageSize = HUGE_PAGE_SIZE;
+		return base;
+	}
+#endif
+
+	// over-allocate and trim, so the whole range can use huge pages
+	mapSize = size + HUGE_PAGE_SIZE;
+	base = mmap( NULL, mapSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+	if ( base == MAP_FAILED )
+		return NULL;
+
+	aligned = PADP( base, HUGE_PAGE_SIZE );
+	if ( aligned != base )
+		munmap( base, aligned - base );
+	if ( aligned + size != base + mapSize )
+		munmap( aligned + size, ( base + mapSize ) - ( aligned + size ) );
+
+#ifdef MADV_HUGEPAGE
+	if ( madvise( aligned, size, MADV_HUGEPAGE ) == 0 && Sys_TransparentHugePages() ) {
+		*kind = PAGES_TRANSPARENT;
+		*pageSize = HUGE_PAGE_SIZE;
+	}
+#endif
+
+	return aligned;
+}
+
+
+/*
+=================
+Sys_HugePageBytes
+
+Transparent huge pages are handed out on a best effort basis,
+only the kernel's accounting tells how much of a range got them
+=================
+*/
+int64_t Sys_HugePageBytes( const void *base, size_t size )
+{
+#ifdef __linux__
+	const uintptr_t rangeStart = (uintptr_t)base;
+	const uintptr_t rangeEnd = rangeStart + size;
+	unsigned long start, end, kb;
+	qboolean inRange;
+	char line[ 256 ];
+	int64_t total;
+	FILE *f;
+
+	f = fopen( "/proc/self/smaps", "r" );
+	if ( !f )
+		return -1;
+
+	total = 0;
+	inRange = qfalse;
+
+	while ( fgets( line, sizeof( line ), f ) ) {
+		// a new mapping starts with its address range
+		if ( sscanf( line, "%lx-%lx ", &start, &end ) == 2 ) {
+			inRange = ( start < rangeEnd && end > rangeStart ) ? qtrue : qfalse;
+		} else if ( inRange && sscanf( line, "AnonHugePages: %lu kB", &kb ) == 1 ) {
+			total += (int64_t)kb * 1024;
+		}
+	}
+
+	fclose( f );
+
+	return total;
+#else
+	return -1;
+#endif
+}
+
+
+/*
+=================
+Sys_WriteFileV
+
+Gathered write that resumes after partial writes and interrupts
+=================
+*/
+qboolean Sys_WriteFileV( FILE *f, const sysIoVec_t *vec, int count )
+{
+	struct iovec iov[ 16 ];
+	ssize_t written;
+	int i, n, fd;
+
+	if ( count > ARRAY_LEN( iov ) )
+		return qfalse;
+
+	n = 0;
+	for ( i = 0; i < count; i++ ) {
+		if ( vec[i].length > 0 ) {
+			iov[n].iov_base = (void *)vec[i].data;
+			iov[n].iov_len = vec[i].length;
+			n++;
+		}
+	}
+
+	fd = fileno( f );
+	i = 0;
+
+	while ( i < n ) {
+		written = writev( fd, iov + i, n - i );
+		if ( written < 0 ) {
+			if ( errno == EINTR )
+				continue;
+			return qfalse;
+		}
+
+		// skip what went out
+		while ( i < n && (size_t)written >= iov[i].iov_len ) {
+			written -= iov[i].iov_len;
+			i++;
+		}
+		if ( i < n ) {
+			iov[i].iov_base = (byte *)iov[i].iov_base + written;
+			iov[i].iov_len -= written;
+		}
+	}
+
+	return qtrue;
+}
+
+
+/*
+=================
+Sys_SyncFile
+=================
+*/
+void Sys_SyncFile( FILE *f )
+{
+	fsync( fileno( f ) );
+}
+
+
+#ifdef __linux__
+#define WATCH_MAX_DEPTH	16
+#define WATCH_EVENTS	(IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF)
+
+struct sysWatch_s {
+	int		fd;
+};
+
+
+/*
+=================
+Sys_AddTreeWatches
+=================
+*/
+static qboolean Sys_AddTreeWatches( int fd, const char *path, int depth )
+{
+	char	subdir[MAX_OSPATH*2];
+	struct	dirent *d;
+	struct	stat st;
+	DIR		*fdir;
+	qboolean ok;
+
+	if ( depth > WATCH_MAX_DEPTH )
+		return qfalse;
+
+	if ( inotify_add_watch( fd, path, WATCH_EVENTS | IN_ONLYDIR ) == -1 )
+		return qfalse;
+
+	if ( ( fdir = opendir( path ) ) == NULL )
+		return qfalse;
+
+	ok = qtrue;
+	while ( ok && ( d = readdir( fdir ) ) != NULL ) {
+		if ( Q_streq( d->d_name, "." ) || Q_streq( d->d_name, ".." ) )
+			continue;
+		Com_sprintf( subdir, sizeof( subdir ), "%s/%s", path, d->d_name );
+		if ( stat( subdir, &st ) == 0 && S_ISDIR( st.st_mode ) )
+			ok = Sys_AddTreeWatches( fd, subdir, depth + 1 );
+	}
+
+	closedir( fdir );
+	return ok;
+}
+#endif
+
+
+/*
+=================
+Sys_WatchTree
+
+Starts watching a directory tree for files being created, removed or
+renamed. Returns NULL when that is not possible, the caller then can't
+tell whether anything changed
+=================
+*/
+sysWatch_t *Sys_WatchTree( const char *path )
+{
+#ifdef __linux__
+	sysWatch_t *watch;
+	int fd;
+
+	fd = inotify_init1( IN_NONBLOCK | IN_CLOEXEC );
+	if ( fd == -1 )
+		return NULL;
+
+	// also fails when running out of watches (fs.inotify.max_user_watches)
+	if ( !Sys_AddTreeWatches( fd, path, 0 ) ) {
+		close( fd );
+		return NULL;
+	}
+
+	watch = malloc( sizeof( *watch ) );
+	if ( watch == NULL ) {
+		close( fd );
+		return NULL;
+	}
+
+	watch->fd = fd;
+	return watch;
+#else
+	return NULL;
+#endif
+}
+
+
+/*
+=================
+Sys_TreeChanged
+
+Non-blocking, qtrue if anything changed since the last call
+=================
+*/
+qboolean Sys_TreeChanged( sysWatch_t *watch )
+{
+#ifdef __linux__
+	char buf[4096] __attribute__ ((aligned(__alignof__(struct inotify_event))));
+	qboolean changed = qfalse;
+
+	while ( read( watch->fd, buf, sizeof( buf ) ) > 0 )
+		changed = qtrue;
+
+	return changed;
+#else
+	return qfalse;
+#endif
+}
+
+
+/*
+=================
+Sys_UnwatchTree
+=================
+*/
+void Sys_UnwatchTree( sysWatch_t *watch )
+{
+#ifdef __linux__
+	if ( watch ) {
+		close( watch->fd );
+		free( watch );
+	}
+#endif
+}
+
+
 /*
 ==============
 Sys_ResetReadOnlyAttribute
@@ -680,3 +1081,252 @@ qboolean Sys_SetAffinityMask( const uint64_t mask )
 	}
 }
 #endif // USE_AFFINITY_MASK
+
+
+/*
+==============================================================
+
+THREADS
+
+==============================================================
+*/
+
+struct sysThread_s {
+	pthread_t		handle;
+	sysThreadFunc_t	func;
+	void			*arg;
+};
+
+
+static void *Sys_ThreadMain( void *arg )
+{
+	sysThread_t *thread = (sysThread_t *)arg;
+
+	thread->func( thread->arg );
+
+	// the thread's temp stack
+	Com_FreeThreadMemory();
+	Com_ProfileThreadExit();
+
+	return NULL;
+}
+
+
+/*
+=================
+Sys_CreateThread
+=================
+*/
+sysThread_t *Sys_CreateThread( sysThreadFunc_t func, void *arg )
+{
+	sysThread_t *thread;
+
+	thread = malloc( sizeof( *thread ) );
+	if ( !thread ) {
+		return NULL;
+	}
+
+	thread->func = func;
+	thread->arg = arg;
+
+	if ( pthread_create( &thread->handle, NULL, Sys_ThreadMain, thread ) != 0 ) {
+		free( thread );
+		return NULL;
+	}
+
+	return thread;
+}
+
+
+/*
+=================
+Sys_JoinThread
+=================
+*/
+void Sys_JoinThread( sysThread_t *thread )
+{
+	pthread_join( thread->handle, NULL );
+	free( thread );
+}
+
+
+/*
+=================
+Sys_NumCPUs
+=================
+*/
+int Sys_NumCPUs( void )
+{
+	long count;
+
+	count = sysconf( _SC_NPROCESSORS_ONLN );
+	if ( count < 1 ) {
+		return 1;
+	}
+
+	return (int)count;
+}
+
+
+/*
+==============================================================
+
+SYNCHRONIZATION
+
+==============================================================
+*/
+
+struct sysMutex_s {
+	pthread_mutex_t	mutex;
+};
+
+struct sysSemaphore_s {
+	pthread_mutex_t	mutex;
+	pthread_cond_t	cond;
+	int				count;
+};
+
+
+/*
+=================
+Sys_CreateMutex
+=================
+*/
+sysMutex_t *Sys_CreateMutex( void )
+{
+	sysMutex_t *mutex;
+
+	mutex = malloc( sizeof( *mutex ) );
+	if ( !mutex ) {
+		return NULL;
+	}
+
+	if ( pthread_mutex_init( &mutex->mutex, NULL ) != 0 ) {
+		free( mutex );
+		return NULL;
+	}
+
+	return mutex;
+}
+
+
+/*
+=================
+Sys_DestroyMutex
+=================
+*/
+void Sys_DestroyMutex( sysMutex_t *mutex )
+{
+	pthread_mutex_destroy( &mutex->mutex );
+	free( mutex );
+}
+
+
+/*
+=================
+Sys_LockMutex
+=================
+*/
+void Sys_LockMutex( sysMutex_t *mutex )
+{
+	pthread_mutex_lock( &mutex->mutex );
+}
+
+
+/*
+=================
+Sys_TryLockMutex
+=================
+*/
+qboolean Sys_TryLockMutex( sysMutex_t *mutex )
+{
+	return pthread_mutex_trylock( &mutex->mutex ) == 0 ? qtrue : qfalse;
+}
+
+
+/*
+=================
+Sys_UnlockMutex
+=================
+*/
+void Sys_UnlockMutex( sysMutex_t *mutex )
+{
+	pthread_mutex_unlock( &mutex->mutex );
+}
+
+
+/*
+=================
+Sys_CreateSemaphore
+
+Unnamed POSIX semaphores are not available everywhere,
+so this is a counter guarded by a condition variable
+=================
+*/
+sysSemaphore_t *Sys_CreateSemaphore( void )
+{
+	sysSemaphore_t *sem;
+
+	sem = malloc( sizeof( *sem ) );
+	if ( !sem ) {
+		return NULL;
+	}
+
+	sem->count = 0;
+
+	if ( pthread_mutex_init( &sem->mutex, NULL ) != 0 ) {
+		free( sem );
+		return NULL;
+	}
+
+	if ( pthread_cond_init( &sem->cond, NULL ) != 0 ) {
+		pthread_mutex_destroy( &sem->mutex );
+		free( sem );
+		return NULL;
+	}
+
+	return sem;
+}
+
+
+/*
+=================
+Sys_DestroySemaphore
+=================
+*/
+void Sys_DestroySemaphore( sysSemaphore_t *sem )
+{
+	pthread_cond_destroy( &sem->cond );
+	pthread_mutex_destroy( &sem->mutex );
+	free( sem );
+}
+
+
+/*
+=================
+Sys_PostSemaphore
+=================
+*/
+void Sys_PostSemaphore( sysSemaphore_t *sem )
+{
+	pthread_mutex_lock( &sem->mutex );
+	sem->count++;
+	pthread_cond_signal( &sem->cond );
+	pthread_mutex_unlock( &sem->mutex );
+}
+
+
+/*
+=================
+Sys_WaitSemaphore
+=================
+*/
+void Sys_WaitSemaphore( sysSemaphore_t *sem )
+{
+	pthread_mutex_lock( &sem->mutex );
+	while ( sem->count == 0 ) {
+		pthread_cond_wait( &sem->cond, &sem->mutex );
+	}
+	sem->count--;
+	pthread_mutex_unlock( &sem->mutex );
+}
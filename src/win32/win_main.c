@@ -167,6 +167,9 @@ void NORETURN FORMAT_PRINTF(1, 2) QDECL Sys_Error( const char *error, ... ) {
 	Conbuf_AppendText( text );
 	Conbuf_AppendText( "\n" );
 
+	// queued log lines
+	Com_LogFlush();
+
 	Sys_SetErrorText( text );
 	Sys_ShowConsole( 1, qtrue );
 
@@ -195,6 +198,8 @@ Sys_Quit
 */
 void NORETURN Sys_Quit( void ) {
 
+	Com_LogFlush();
+
 	timeEndPeriod( 1 );
 
 	Sys_DestroyConsole();
@@ -251,6 +256,284 @@ FILE *Sys_FOpen( const char *ospath, const char *mode )
 }
 
 
+struct sysMapping_s {
+	void	*view;
+};
+
+
+/*
+==============
+Sys_MapFile
+
+Maps length bytes at offset of an open file read only, the stream
+itself can be closed afterwards
+==============
+*/
+sysMapping_t *Sys_MapFile( FILE *f, int64_t offset, int length, const void **data )
+{
+	sysMapping_t *mapping;
+	SYSTEM_INFO info;
+	LARGE_INTEGER fileSize;
+	HANDLE file, map;
+	int64_t start;
+	void *view;
+
+	*data = NULL;
+
+	if ( offset < 0 || length <= 0 ) {
+		return NULL;
+	}
+
+	file = (HANDLE)_get_osfhandle( _fileno( f ) );
+	if ( file == INVALID_HANDLE_VALUE ) {
+		return NULL;
+	}
+
+	if ( !GetFileSizeEx( file, &fileSize ) || offset + length > fileSize.QuadPart ) {
+		return NULL;
+	}
+
+	map = CreateFileMappingA( file, NULL, PAGE_READONLY, 0, 0, NULL );
+	if ( map == NULL ) {
+		return NULL;
+	}
+
+	GetSystemInfo( &info );
+	start = offset - offset % info.dwAllocationGranularity;
+
+	view = MapViewOfFile( map, FILE_MAP_READ, (DWORD)( start >> 32 ), (DWORD)( start & 0xFFFFFFFF ),
+		(SIZE_T)( offset - start ) + length );
+
+	// the view keeps the mapping object alive
+	CloseHandle( map );
+
+	if ( view == NULL ) {
+		return NULL;
+	}
+
+	mapping = malloc( sizeof( *mapping ) );
+	if ( mapping == NULL ) {
+		UnmapViewOfFile( view );
+		return NULL;
+	}
+
+	mapping->view = view;
+
+	*data = (const byte *)view + ( offset - start );
+	return mapping;
+}
+
+
+/*
+==============
+Sys_UnmapFile
+==============
+*/
+void Sys_UnmapFile( sysMapping_t *mapping )
+{
+	if ( mapping ) {
+		UnmapViewOfFile( mapping->view );
+		free( mapping );
+	}
+}
+
+
+/*
+==============
+Sys_EnableLockMemory
+
+Large pages need SeLockMemoryPrivilege, which an administrator
+has to grant to the account first
+==============
+*/
+static qboolean Sys_EnableLockMemory( void )
+{
+	TOKEN_PRIVILEGES tp;
+	HANDLE token;
+	BOOL ok;
+
+	if ( !OpenProcessToken( GetCurrentProcess(), TOKEN_ADJUST_PRIVILEGES | TOKEN_QUERY, &token ) ) {
+		return qfalse;
+	}
+
+	tp.PrivilegeCount = 1;
+	tp.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+
+	ok = LookupPrivilegeValueA( NULL, "SeLockMemoryPrivilege", &tp.Privileges[0].Luid );
+	if ( ok ) {
+		// succeeds without enabling anything if the account lacks the privilege
+		ok = AdjustTokenPrivileges( token, FALSE, &tp, 0, NULL, NULL ) && GetLastError() == ERROR_SUCCESS;
+	}
+
+	CloseHandle( token );
+
+	return ok ? qtrue : qfalse;
+}
+
+
+/*
+==============
+Sys_AllocPages
+==============
+*/
+void *Sys_AllocPages( size_t size, qboolean huge, pageKind_t *kind, size_t *pageSize )
+{
+	typedef SIZE_T ( WINAPI *largePageMinimum_t )( void );
+	largePageMinimum_t largePageMinimum;
+	SYSTEM_INFO info;
+	SIZE_T large;
+	void *base;
+
+	GetSystemInfo( &info );
+
+	*kind = PAGES_SMALL;
+	*pageSize = info.dwPageSize;
+
+	// not available on XP, which the headers target
+	largePageMinimum = (largePageMinimum_t)GetProcAddress( GetModuleHandleA( "kernel32.dll" ), "GetLargePageMinimum" );
+
+	if ( huge && largePageMinimum ) {
+		large = largePageMinimum();
+		if ( large && Sys_EnableLockMemory() ) {
+			base = VirtualAlloc( NULL, PAD( size, large ), MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE );
+			if ( base ) {
+				*kind = PAGES_HUGE;
+				*pageSize = large;
+				return base;
+			}
+		}
+	}
+
+	return VirtualAlloc( NULL, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE );
+}
+
+
+/*
+==============
+Sys_HugePageBytes
+
+Large pages are all or nothing here, see Sys_AllocPages
+==============
+*/
+int64_t Sys_HugePageBytes( const void *base, size_t size )
+{
+	return -1;
+}
+
+
+/*
+==============
+Sys_WriteFileV
+
+There is no gathered write for regular files, the pieces go out one by one
+==============
+*/
+qboolean Sys_WriteFileV( FILE *f, const sysIoVec_t *vec, int count )
+{
+	const byte *data;
+	HANDLE file;
+	DWORD written;
+	int i, remaining;
+
+	file = (HANDLE)_get_osfhandle( _fileno( f ) );
+	if ( file == INVALID_HANDLE_VALUE ) {
+		return qfalse;
+	}
+
+	for ( i = 0; i < count; i++ ) {
+		data = (const byte *)vec[i].data;
+		remaining = vec[i].length;
+		while ( remaining > 0 ) {
+			if ( !WriteFile( file, data, remaining, &written, NULL ) || written == 0 ) {
+				return qfalse;
+			}
+			data += written;
+			remaining -= written;
+		}
+	}
+
+	return qtrue;
+}
+
+
+/*
+==============
+Sys_SyncFile
+==============
+*/
+void Sys_SyncFile( FILE *f )
+{
+	FlushFileBuffers( (HANDLE)_get_osfhandle( _fileno( f ) ) );
+}
+
+
+struct sysWatch_s {
+	HANDLE	change;
+};
+
+
+/*
+==============
+Sys_WatchTree
+
+Starts watching a directory tree for files being created, removed or
+renamed. Returns NULL when that is not possible, the caller then can't
+tell whether anything changed
+==============
+*/
+sysWatch_t *Sys_WatchTree( const char *path )
+{
+	sysWatch_t *watch;
+	HANDLE change;
+
+	change = FindFirstChangeNotificationA( path, TRUE, FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_DIR_NAME );
+	if ( change == INVALID_HANDLE_VALUE ) {
+		return NULL;
+	}
+
+	watch = malloc( sizeof( *watch ) );
+	if ( watch == NULL ) {
+		FindCloseChangeNotification( change );
+		return NULL;
+	}
+
+	watch->change = change;
+	return watch;
+}
+
+
+/*
+==============
+Sys_TreeChanged
+
+Non-blocking, qtrue if anything changed since the last call
+==============
+*/
+qboolean Sys_TreeChanged( sysWatch_t *watch )
+{
+	if ( WaitForSingleObject( watch->change, 0 ) != WAIT_OBJECT_0 ) {
+		return qfalse;
+	}
+
+	FindNextChangeNotification( watch->change );
+	return qtrue;
+}
+
+
+/*
+==============
+Sys_UnwatchTree
+==============
+*/
+void Sys_UnwatchTree( sysWatch_t *watch )
+{
+	if ( watch ) {
+		FindCloseChangeNotification( watch->change );
+		free( watch );
+	}
+}
+
+
 /*
 ==============
 Sys_ResetReadOnlyAttribute
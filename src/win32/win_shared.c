@@ -379,3 +379,230 @@ qboolean Sys_SetAffinityMask( const uint64_t mask )
 	return qfalse;
 }
 #endif // USE_AFFINITY_MASK
+
+
+/*
+==============================================================
+
+THREADS
+
+==============================================================
+*/
+
+struct sysThread_s {
+	HANDLE			handle;
+	sysThreadFunc_t	func;
+	void			*arg;
+};
+
+
+static DWORD WINAPI Sys_ThreadMain( LPVOID arg )
+{
+	sysThread_t *thread = (sysThread_t *)arg;
+
+	thread->func( thread->arg );
+
+	// the thread's temp stack
+	Com_FreeThreadMemory();
+	Com_ProfileThreadExit();
+
+	return 0;
+}
+
+
+/*
+=================
+Sys_CreateThread
+=================
+*/
+sysThread_t *Sys_CreateThread( sysThreadFunc_t func, void *arg )
+{
+	sysThread_t *thread;
+
+	thread = malloc( sizeof( *thread ) );
+	if ( !thread ) {
+		return NULL;
+	}
+
+	thread->func = func;
+	thread->arg = arg;
+
+	thread->handle = CreateThread( NULL, 0, Sys_ThreadMain, thread, 0, NULL );
+	if ( !thread->handle ) {
+		free( thread );
+		return NULL;
+	}
+
+	return thread;
+}
+
+
+/*
+=================
+Sys_JoinThread
+=================
+*/
+void Sys_JoinThread( sysThread_t *thread )
+{
+	WaitForSingleObject( thread->handle, INFINITE );
+	CloseHandle( thread->handle );
+	free( thread );
+}
+
+
+/*
+=================
+Sys_NumCPUs
+=================
+*/
+int Sys_NumCPUs( void )
+{
+	SYSTEM_INFO info;
+
+	GetSystemInfo( &info );
+	if ( info.dwNumberOfProcessors < 1 ) {
+		return 1;
+	}
+
+	return (int)info.dwNumberOfProcessors;
+}
+
+
+/*
+==============================================================
+
+SYNCHRONIZATION
+
+==============================================================
+*/
+
+struct sysMutex_s {
+	CRITICAL_SECTION	cs;
+};
+
+struct sysSemaphore_s {
+	HANDLE				handle;
+};
+
+
+/*
+=================
+Sys_CreateMutex
+=================
+*/
+sysMutex_t *Sys_CreateMutex( void )
+{
+	sysMutex_t *mutex;
+
+	mutex = malloc( sizeof( *mutex ) );
+	if ( !mutex ) {
+		return NULL;
+	}
+
+	InitializeCriticalSection( &mutex->cs );
+
+	return mutex;
+}
+
+
+/*
+=================
+Sys_DestroyMutex
+=================
+*/
+void Sys_DestroyMutex( sysMutex_t *mutex )
+{
+	DeleteCriticalSection( &mutex->cs );
+	free( mutex );
+}
+
+
+/*
+=================
+Sys_LockMutex
+=================
+*/
+void Sys_LockMutex( sysMutex_t *mutex )
+{
+	EnterCriticalSection( &mutex->cs );
+}
+
+
+/*
+=================
+Sys_TryLockMutex
+=================
+*/
+qboolean Sys_TryLockMutex( sysMutex_t *mutex )
+{
+	return TryEnterCriticalSection( &mutex->cs ) ? qtrue : qfalse;
+}
+
+
+/*
+=================
+Sys_UnlockMutex
+=================
+*/
+void Sys_UnlockMutex( sysMutex_t *mutex )
+{
+	LeaveCriticalSection( &mutex->cs );
+}
+
+
+/*
+=================
+Sys_CreateSemaphore
+=================
+*/
+sysSemaphore_t *Sys_CreateSemaphore( void )
+{
+	sysSemaphore_t *sem;
+
+	sem = malloc( sizeof( *sem ) );
+	if ( !sem ) {
+		return NULL;
+	}
+
+	sem->handle = CreateSemaphore( NULL, 0, 0x7fffffff, NULL );
+	if ( !sem->handle ) {
+		free( sem );
+		return NULL;
+	}
+
+	return sem;
+}
+
+
+/*
+=================
+Sys_DestroySemaphore
+=================
+*/
+void Sys_DestroySemaphore( sysSemaphore_t *sem )
+{
+	CloseHandle( sem->handle );
+	free( sem );
+}
+
+
+/*
+=================
+Sys_PostSemaphore
+=================
+*/
+void Sys_PostSemaphore( sysSemaphore_t *sem )
+{
+	ReleaseSemaphore( sem->handle, 1, NULL );
+}
+
+
+/*
+=================
+Sys_WaitSemaphore
+=================
+*/
+void Sys_WaitSemaphore( sysSemaphore_t *sem )
+{
+	WaitForSingleObject( sem->handle, INFINITE );
+}